@@ -5,6 +5,12 @@ enum ModelType {
 
   /// YOLOv8-Pose 姿态估计（关键点检测）
   yoloPose,
+
+  /// YOLOv8-Seg 实例分割（多边形）
+  yoloSeg,
+
+  /// YOLOv8-OBB 旋转框（4 个角点的多边形）
+  yoloObb,
 }
 
 /// 标签保存模式枚举
@@ -48,6 +54,9 @@ class AiConfig {
   /// 类别ID偏置（仅在追加模式下生效，用于合并多模型的ID）
   int classIdOffset;
 
+  /// 批量推理时是否跳过近重复图片（复用上一张推理结果，适合视频抽帧）
+  bool skipNearDuplicates;
+
   AiConfig({
     this.modelType = ModelType.yolo,
     this.modelPath = '',
@@ -58,6 +67,7 @@ class AiConfig {
     this.numKeypoints = 0,
     this.keypointConfThreshold = 0.5,
     this.classIdOffset = 0,
+    this.skipNearDuplicates = false,
   });
 
   /// 从JSON创建配置（缺失或空字段使用默认值）
@@ -74,6 +84,7 @@ class AiConfig {
       keypointConfThreshold:
           (json['keypointConfThreshold'] as num?)?.toDouble() ?? 0.5,
       classIdOffset: json['classIdOffset'] as int? ?? 0,
+      skipNearDuplicates: json['skipNearDuplicates'] as bool? ?? false,
     );
   }
 
@@ -89,6 +100,7 @@ class AiConfig {
       'numKeypoints': numKeypoints,
       'keypointConfThreshold': keypointConfThreshold,
       'classIdOffset': classIdOffset,
+      'skipNearDuplicates': skipNearDuplicates,
     };
   }
 
@@ -103,6 +115,7 @@ class AiConfig {
     int? numKeypoints,
     double? keypointConfThreshold,
     int? classIdOffset,
+    bool? skipNearDuplicates,
   }) {
     return AiConfig(
       modelType: modelType ?? this.modelType,
@@ -115,6 +128,7 @@ class AiConfig {
       keypointConfThreshold:
           keypointConfThreshold ?? this.keypointConfThreshold,
       classIdOffset: classIdOffset ?? this.classIdOffset,
+      skipNearDuplicates: skipNearDuplicates ?? this.skipNearDuplicates,
     );
   }
 
@@ -32,6 +32,11 @@ class Label {
   /// AI检测置信度（可选）
   double? confidence;
 
+  /// 点是否来自检测轮廓（分割掩码或旋转框角点），不写入标签文件。
+  ///
+  /// 类别尚无定义时据此推断为多边形类型。
+  bool pointsArePolygon;
+
   Label({
     required this.id,
     this.name = '',
@@ -42,6 +47,7 @@ class Label {
     List<LabelPoint>? points,
     List<String>? extraData,
     this.confidence,
+    this.pointsArePolygon = false,
   })  : points = points ?? [],
         extraData = extraData ?? [];
 
@@ -226,6 +232,7 @@ class Label {
     List<LabelPoint>? points,
     List<String>? extraData,
     double? confidence,
+    bool? pointsArePolygon,
   }) {
     return Label(
       id: id ?? this.id,
@@ -237,6 +244,7 @@ class Label {
       points: points ?? this.points.map((p) => p.copyWith()).toList(),
       extraData: extraData ?? List.from(this.extraData),
       confidence: confidence ?? this.confidence,
+      pointsArePolygon: pointsArePolygon ?? this.pointsArePolygon,
     );
   }
 
@@ -350,7 +350,12 @@ class _ProjectSettingsPageState extends State<ProjectSettingsPage> {
       if (summary.totalImages == 0) return;
 
       if (mounted) {
-        ToastUtils.show(context, l10n.batchInferenceComplete);
+        ToastUtils.show(
+          context,
+          summary.skippedImages > 0
+              ? l10n.batchInferenceCompleteSkipped(summary.skippedImages)
+              : l10n.batchInferenceComplete,
+        );
       }
     } catch (e, stack) {
       if (mounted) {
@@ -87,7 +87,10 @@ class AppServices {
     final detector = gpuDetector ?? OnnxGpuDetector(engine: engine);
     final batchService = batchInferenceService ??
         BatchInferenceService(
-          runner: InferenceServiceBatchRunner(service),
+          runner: InferenceServiceBatchRunner(
+            service,
+            rawCacheDirectory: defaultRawCacheDirectory,
+          ),
           imageRepository: resolvedImageRepository,
           labelRepository: resolvedLabelRepository,
         );
@@ -18,7 +18,9 @@ class AiPostProcessor {
     for (final label in labels) {
       final type = definitions.typeForClassId(
         label.id,
-        fallback: LabelType.boxWithPoint,
+        fallback: label.pointsArePolygon
+            ? LabelType.polygon
+            : LabelType.boxWithPoint,
       );
       if (type == LabelType.box) {
         label.points.clear();
@@ -30,6 +32,8 @@ class AiPostProcessor {
   /// Ensures every class id appearing in [labels] has a definition.
   ///
   /// Missing definitions are appended with auto-generated names and colors.
+  /// Classes whose points come from a mask contour or rotated box are typed
+  /// as polygons, other classes with points as box + keypoints.
   List<LabelDefinition> fillMissingDefinitions(
     List<Label> labels,
     List<LabelDefinition> definitions,
@@ -51,8 +55,11 @@ class AiPostProcessor {
     LabelType inferType(int classId) {
       final samples = labels.where((l) => l.id == classId);
       if (samples.isEmpty) return LabelType.box;
-      final hasPoints = samples.any((l) => l.points.isNotEmpty);
-      return hasPoints ? LabelType.boxWithPoint : LabelType.box;
+      final withPoints = samples.where((l) => l.points.isNotEmpty);
+      if (withPoints.isEmpty) return LabelType.box;
+      return withPoints.any((l) => l.pointsArePolygon)
+          ? LabelType.polygon
+          : LabelType.boxWithPoint;
     }
 
     for (final classId in missingIds) {
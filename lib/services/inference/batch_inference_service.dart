@@ -1,4 +1,5 @@
 import 'package:path/path.dart' as path;
+import 'package:path_provider/path_provider.dart';
 import '../../models/ai_config.dart';
 import '../../models/label.dart';
 import '../../models/label_definition.dart';
@@ -6,6 +7,8 @@ import 'ai_post_processor.dart';
 import '../app/app_error.dart';
 import '../app/error_reporter.dart';
 import '../image/image_repository.dart';
+import 'batch_manifest.dart';
+import 'batch_manifest_store.dart';
 import 'inference_service.dart';
 import '../labels/label_file_repository.dart';
 
@@ -28,11 +31,28 @@ abstract class BatchInferenceRunner {
   );
 }
 
+/// 默认的原始输出缓存目录（应用支持目录下的 raw_cache），获取失败时返回 null。
+Future<String?> defaultRawCacheDirectory() async {
+  try {
+    final directory = await getApplicationSupportDirectory();
+    return path.join(directory.path, 'raw_cache');
+  } catch (_) {
+    return null;
+  }
+}
+
 /// InferenceService 适配器。
+///
+/// 提供 [rawCacheDirectory] 时，模型加载后启用原始输出缓存，
+/// 仅调整阈值后的重复批量推理可跳过解码与模型推理。
 class InferenceServiceBatchRunner implements BatchInferenceRunner {
   final InferenceService _service;
+  final Future<String?> Function()? _rawCacheDirectory;
 
-  InferenceServiceBatchRunner(this._service);
+  InferenceServiceBatchRunner(
+    this._service, {
+    Future<String?> Function()? rawCacheDirectory,
+  }) : _rawCacheDirectory = rawCacheDirectory;
 
   @override
   void initialize() {
@@ -45,8 +65,13 @@ class InferenceServiceBatchRunner implements BatchInferenceRunner {
   }
 
   @override
-  Future<bool> loadModel(String path, {bool useGpu = false}) {
-    return _service.loadModel(path, useGpu: useGpu);
+  Future<bool> loadModel(String path, {bool useGpu = false}) async {
+    final loaded = await _service.loadModel(path, useGpu: useGpu);
+    final provider = _rawCacheDirectory;
+    if (loaded && provider != null && !_service.hasRawCache) {
+      _service.setRawCacheDirectory(await provider());
+    }
+    return loaded;
   }
 
   @override
@@ -76,6 +101,9 @@ class BatchInferenceSummary {
   /// 已处理图片数量。
   final int processedImages;
 
+  /// 因未变化而跳过的图片数量（见 [BatchManifest]）。
+  final int skippedImages;
+
   /// 失败的批次数量。
   final int failedBatches;
 
@@ -88,6 +116,7 @@ class BatchInferenceSummary {
     required this.inferredImages,
     required this.totalImages,
     required this.processedImages,
+    this.skippedImages = 0,
     this.failedBatches = 0,
     this.lastError,
   });
@@ -100,7 +129,15 @@ class BatchInferenceService {
     AiPostProcessor? postProcessor,
     ImageRepository? imageRepository,
     LabelFileRepository? labelRepository,
-  })  : _runner = runner ?? InferenceServiceBatchRunner(InferenceService()),
+    FileHasher fileHasher = nativeFileHasher,
+    BatchManifestStore manifestStore = const FileBatchManifestStore(),
+  })  : _fileHasher = fileHasher,
+        _manifestStore = manifestStore,
+        _runner = runner ??
+            InferenceServiceBatchRunner(
+              InferenceService(),
+              rawCacheDirectory: defaultRawCacheDirectory,
+            ),
         _postProcessor = postProcessor ?? const AiPostProcessor(),
         _imageRepository = imageRepository ?? FileImageRepository(),
         _labelRepository = labelRepository ?? FileLabelRepository();
@@ -109,8 +146,13 @@ class BatchInferenceService {
   final AiPostProcessor _postProcessor;
   final ImageRepository _imageRepository;
   final LabelFileRepository _labelRepository;
+  final FileHasher _fileHasher;
+  final BatchManifestStore _manifestStore;
 
   /// 执行批量推理并返回结果汇总。
+  ///
+  /// [incremental] 为 true 时按标签目录下的清单跳过已用相同模型与配置推理
+  /// 且未变化的图片，中断后重新运行只处理剩余图片。
   Future<BatchInferenceSummary> run({
     required String imageDir,
     required String labelDir,
@@ -122,6 +164,7 @@ class BatchInferenceService {
     void Function(List<LabelDefinition> updatedDefinitions)?
         onDefinitionsUpdated,
     void Function(String fileName)? onInferredImage,
+    bool incremental = true,
   }) async {
     final continueCheck = shouldContinue ?? () => true;
     final imageFiles = await _imageRepository.listImagePaths(imageDir);
@@ -140,6 +183,42 @@ class BatchInferenceService {
 
     await _labelRepository.ensureDirectory(labelDir);
 
+    final inferredImages = <String>{};
+    BatchManifest? manifest;
+    var fingerprint = 0;
+    var pendingFiles = imageFiles;
+    if (incremental) {
+      manifest = await BatchManifest.open(
+        labelDir,
+        hasher: _fileHasher,
+        store: _manifestStore,
+      );
+      fingerprint =
+          await BatchManifest.fingerprintOf(config, store: _manifestStore);
+      pendingFiles = await manifest.pending(imageFiles, fingerprint);
+    }
+    final skippedImages = totalImages - pendingFiles.length;
+    if (skippedImages > 0) {
+      final pendingSet = pendingFiles.toSet();
+      for (final imagePath in imageFiles) {
+        if (pendingSet.contains(imagePath)) continue;
+        final fileName = path.basename(imagePath);
+        inferredImages.add(fileName);
+        onInferredImage?.call(fileName);
+      }
+      onProgress?.call(skippedImages, totalImages);
+    }
+    if (pendingFiles.isEmpty) {
+      return BatchInferenceSummary(
+        modelLoaded: true,
+        definitions: definitions,
+        inferredImages: inferredImages,
+        totalImages: totalImages,
+        processedImages: 0,
+        skippedImages: skippedImages,
+      );
+    }
+
     _runner.initialize();
     final modelLoaded =
         await _runner.loadModel(config.modelPath, useGpu: useGpu);
@@ -148,9 +227,10 @@ class BatchInferenceService {
       return BatchInferenceSummary(
         modelLoaded: false,
         definitions: definitions,
-        inferredImages: {},
+        inferredImages: inferredImages,
         totalImages: totalImages,
         processedImages: 0,
+        skippedImages: skippedImages,
       );
     }
 
@@ -158,19 +238,19 @@ class BatchInferenceService {
     final batchSize = useBatchGpu ? 32 : 4;
 
     var currentDefinitions = definitions;
-    final inferredImages = <String>{};
     var processedImages = 0;
     var failedBatches = 0;
     AppError? lastError;
 
-    for (int i = 0; i < imageFiles.length; i += batchSize) {
+    for (int i = 0; i < pendingFiles.length; i += batchSize) {
       if (!continueCheck()) break;
 
-      final end = (i + batchSize < imageFiles.length)
+      final end = (i + batchSize < pendingFiles.length)
           ? i + batchSize
-          : imageFiles.length;
-      final batchPaths = imageFiles.sublist(i, end);
-      onProgress?.call(i + 1, totalImages);
+          : pendingFiles.length;
+      final batchPaths = pendingFiles.sublist(i, end);
+      final written = <String>[];
+      onProgress?.call(skippedImages + i + 1, totalImages);
 
       try {
         final batchLabels = await _runner.runBatchInference(
@@ -230,10 +310,11 @@ class BatchInferenceService {
           final fileName = path.basename(imagePath);
           inferredImages.add(fileName);
           onInferredImage?.call(fileName);
+          written.add(imagePath);
           processedImages += 1;
         }
 
-        onProgress?.call(end, totalImages);
+        onProgress?.call(skippedImages + end, totalImages);
       } catch (e, stack) {
         lastError = ErrorReporter.report(
           e,
@@ -243,7 +324,10 @@ class BatchInferenceService {
         );
         failedBatches += 1;
       }
+      // 逐批记录，中断后已写入的图片不再重做（追加模式下不会重复追加）。
+      await manifest?.record(written, fingerprint);
     }
+    await manifest?.compact();
 
     return BatchInferenceSummary(
       modelLoaded: true,
@@ -251,6 +335,7 @@ class BatchInferenceService {
       inferredImages: inferredImages,
       totalImages: totalImages,
       processedImages: processedImages,
+      skippedImages: skippedImages,
       failedBatches: failedBatches,
       lastError: lastError,
     );
@@ -0,0 +1,288 @@
+import 'dart:convert';
+
+import 'package:onnx_inference/onnx_inference.dart' as onnx;
+import 'package:path/path.dart' as path;
+
+import '../../models/ai_config.dart';
+import 'batch_manifest_store.dart';
+
+/// 批量计算文件内容哈希，无法读取的文件对应 null；不支持时返回 null。
+typedef FileHasher = List<int?>? Function(List<String> paths);
+
+/// 默认文件哈希：原生库并行映射读取，与原始输出缓存键一致。
+List<int?>? nativeFileHasher(List<String> paths) {
+  try {
+    return onnx.OnnxInference.instance.hashFiles(paths);
+  } catch (_) {
+    // 原生库不可用时仅按大小与修改时间判断。
+    return null;
+  }
+}
+
+/// 清单条目：一张已推理图片的文件状态与推理指纹。
+class BatchManifestEntry {
+  /// 文件大小（字节）。
+  final int size;
+
+  /// 修改时间（毫秒）。
+  final int modifiedMs;
+
+  /// 内容哈希（0 表示未知）。
+  final int hash;
+
+  /// 推理时的模型与配置指纹。
+  final int fingerprint;
+
+  const BatchManifestEntry({
+    required this.size,
+    required this.modifiedMs,
+    required this.hash,
+    required this.fingerprint,
+  });
+}
+
+/// 批量推理清单
+///
+/// 保存在标签目录下，逐批追加已推理图片的大小、修改时间、内容哈希与指纹。
+/// 重复运行时跳过未变化的图片；中断后已写入的批次不再重做。
+class BatchManifest {
+  BatchManifest._(
+    this.filePath,
+    this._entries,
+    this._lines,
+    this._hasher,
+    this._store,
+  );
+
+  /// 清单文件名。
+  static const fileName = '.label_load_manifest';
+
+  static const _header = '# label_load batch manifest v1';
+
+  /// 读取文件状态与校验内容哈希时每批的文件数。
+  static const _hashChunk = 256;
+
+  /// 清单文件路径。
+  final String filePath;
+
+  final Map<String, BatchManifestEntry> _entries;
+  final FileHasher _hasher;
+  final BatchManifestStore _store;
+
+  /// 文件中的条目行数（含被后续行覆盖的旧行）。
+  int _lines;
+
+  /// 写入失败后不再尝试（只读目录等）。
+  bool _writable = true;
+
+  /// 条目数量。
+  int get length => _entries.length;
+
+  /// 读取标签目录下的清单（不存在或损坏的行视为空）。
+  static Future<BatchManifest> open(
+    String labelDir, {
+    FileHasher hasher = nativeFileHasher,
+    BatchManifestStore store = const FileBatchManifestStore(),
+  }) async {
+    final filePath = path.join(labelDir, fileName);
+    final entries = <String, BatchManifestEntry>{};
+    var lines = 0;
+    try {
+      // 首次运行没有清单。
+      final content = await store.readString(filePath) ?? '';
+      for (final line in const LineSplitter().convert(content)) {
+        if (line.isEmpty || line.startsWith('#')) continue;
+        final parts = line.split('\t');
+        if (parts.length != 5) continue;
+        final size = int.tryParse(parts[1]);
+        final modifiedMs = int.tryParse(parts[2]);
+        final hash = int.tryParse(parts[3]);
+        final fingerprint = int.tryParse(parts[4]);
+        if (size == null ||
+            modifiedMs == null ||
+            hash == null ||
+            fingerprint == null) {
+          continue;
+        }
+        // 追加写入，后出现的条目覆盖先前的。
+        entries[parts[0]] = BatchManifestEntry(
+          size: size,
+          modifiedMs: modifiedMs,
+          hash: hash,
+          fingerprint: fingerprint,
+        );
+        lines++;
+      }
+    } on FormatException {
+      // 非 UTF-8 内容视为损坏，重新开始。
+      entries.clear();
+      lines = 0;
+    }
+    return BatchManifest._(filePath, entries, lines, hasher, store);
+  }
+
+  /// 计算模型与配置指纹
+  ///
+  /// 覆盖模型文件（路径、大小、修改时间）与影响标注结果的配置项，
+  /// 任一变化都会使已有条目失效。
+  static Future<int> fingerprintOf(
+    AiConfig config, {
+    BatchManifestStore store = const FileBatchManifestStore(),
+  }) async {
+    final model = await store.stat(config.modelPath);
+    return _fnv1a([
+      config.modelPath,
+      model?.size ?? -1,
+      model?.modifiedMs ?? 0,
+      config.modelType.index,
+      config.confidenceThreshold,
+      config.nmsThreshold,
+      config.numKeypoints,
+      config.keypointConfThreshold,
+      config.labelSaveMode.index,
+      config.classIdOffset,
+      // 仅开启时参与，关闭时与旧清单的指纹保持一致。
+      if (config.skipNearDuplicates) 'dedup',
+    ].join('|'));
+  }
+
+  /// 筛选需要推理的图片
+  ///
+  /// 新增、内容变化、指纹不一致或标签文件缺失的图片需要推理。大小一致但
+  /// 修改时间变化的图片按内容哈希确认，未变化时刷新条目并跳过。
+  Future<List<String>> pending(List<String> imagePaths, int fingerprint) async {
+    final labelNames = await _store.listFileNames(path.dirname(filePath));
+    final result = <String>[];
+    final known = <String>[];
+    for (final imagePath in imagePaths) {
+      final entry = _entries[path.basename(imagePath)];
+      if (entry == null ||
+          entry.fingerprint != fingerprint ||
+          !labelNames.contains(_labelName(imagePath))) {
+        result.add(imagePath);
+      } else {
+        known.add(imagePath);
+      }
+    }
+
+    // 已有条目按文件状态判断是否变化（分块并发读取）。
+    final verify = <String>[];
+    for (var start = 0; start < known.length; start += _hashChunk) {
+      final chunk = known.sublist(
+          start,
+          start + _hashChunk < known.length
+              ? start + _hashChunk
+              : known.length);
+      final stats = await Future.wait(chunk.map(_store.stat));
+      for (var j = 0; j < chunk.length; j++) {
+        final entry = _entries[path.basename(chunk[j])]!;
+        final stat = stats[j];
+        if (stat == null || stat.size != entry.size) {
+          result.add(chunk[j]);
+        } else if (stat.modifiedMs != entry.modifiedMs) {
+          if (entry.hash == 0) {
+            result.add(chunk[j]);
+          } else {
+            verify.add(chunk[j]);
+          }
+        }
+      }
+    }
+
+    // 仅修改时间变化（复制、touch）：内容一致时刷新条目。
+    final touched = <String>[];
+    for (var start = 0; start < verify.length; start += _hashChunk) {
+      final chunk = verify.sublist(
+          start,
+          start + _hashChunk < verify.length
+              ? start + _hashChunk
+              : verify.length);
+      final hashes = _hasher(chunk);
+      for (var j = 0; j < chunk.length; j++) {
+        final entry = _entries[path.basename(chunk[j])]!;
+        if (hashes != null && hashes[j] == entry.hash) {
+          touched.add(chunk[j]);
+        } else {
+          result.add(chunk[j]);
+        }
+      }
+    }
+    if (touched.isNotEmpty) {
+      await record(touched, fingerprint);
+    }
+
+    // 保持原有顺序。
+    if (known.isNotEmpty) {
+      final order = {
+        for (var i = 0; i < imagePaths.length; i++) imagePaths[i]: i
+      };
+      result.sort((a, b) => order[a]!.compareTo(order[b]!));
+    }
+    return result;
+  }
+
+  /// 记录已推理的图片（追加写入清单，写入失败时静默忽略）。
+  Future<void> record(List<String> imagePaths, int fingerprint) async {
+    if (imagePaths.isEmpty) return;
+    final hashes = _hasher(imagePaths);
+    final stats = await Future.wait(imagePaths.map(_store.stat));
+    final buffer = StringBuffer();
+    for (var i = 0; i < imagePaths.length; i++) {
+      final name = path.basename(imagePaths[i]);
+      if (name.contains('\t') || name.contains('\n')) continue;
+      final stat = stats[i];
+      if (stat == null) continue;
+      final entry = BatchManifestEntry(
+        size: stat.size,
+        modifiedMs: stat.modifiedMs,
+        hash: hashes?[i] ?? 0,
+        fingerprint: fingerprint,
+      );
+      _entries[name] = entry;
+      _writeEntry(buffer, name, entry);
+      _lines++;
+    }
+    if (buffer.isEmpty || !_writable) return;
+    final header = await _store.stat(filePath) == null ? '$_header\n' : '';
+    _writable = await _store.appendString(filePath, '$header$buffer');
+  }
+
+  /// 重写清单以去除被覆盖的旧行（先写临时文件再重命名）。
+  Future<void> compact() async {
+    if (!_writable || _lines <= _entries.length) return;
+    final buffer = StringBuffer('$_header\n');
+    _entries.forEach((name, entry) => _writeEntry(buffer, name, entry));
+    _writable = await _store.replaceString(filePath, buffer.toString());
+    if (_writable) {
+      _lines = _entries.length;
+    }
+  }
+
+  static String _labelName(String imagePath) =>
+      '${path.basenameWithoutExtension(imagePath)}.txt';
+
+  static void _writeEntry(
+      StringBuffer buffer, String name, BatchManifestEntry entry) {
+    buffer
+      ..write(name)
+      ..write('\t')
+      ..write(entry.size)
+      ..write('\t')
+      ..write(entry.modifiedMs)
+      ..write('\t')
+      ..write(entry.hash)
+      ..write('\t')
+      ..write(entry.fingerprint)
+      ..write('\n');
+  }
+
+  /// 64 位 FNV-1a（按 UTF-16 码元）。
+  static int _fnv1a(String text) {
+    var hash = 0xcbf29ce484222325;
+    for (final unit in text.codeUnits) {
+      hash ^= unit;
+      hash *= 0x100000001b3;
+    }
+    return hash;
+  }
+}
@@ -0,0 +1,101 @@
+import 'dart:convert';
+import 'dart:io';
+
+import 'package:path/path.dart' as path;
+
+/// 文件状态：清单据此判断图片与模型是否变化。
+class FileStamp {
+  /// 文件大小（字节）。
+  final int size;
+
+  /// 修改时间（毫秒）。
+  final int modifiedMs;
+
+  const FileStamp({required this.size, required this.modifiedMs});
+}
+
+/// 批量推理清单的文件访问接口，抽象文件系统读写。
+abstract class BatchManifestStore {
+  /// 读取文件状态，文件不存在或不可访问时返回 null。
+  Future<FileStamp?> stat(String filePath);
+
+  /// 列出目录下的文件名（不含子目录），目录不可读时返回空集合。
+  Future<Set<String>> listFileNames(String directoryPath);
+
+  /// 读取 UTF-8 文本，文件不存在或不可读时返回 null；
+  /// 内容不是合法 UTF-8 时抛出 [FormatException]。
+  Future<String?> readString(String filePath);
+
+  /// 追加写入文本（不存在时创建），返回是否成功。
+  Future<bool> appendString(String filePath, String content);
+
+  /// 整体替换文件内容（先写临时文件再重命名），返回是否成功。
+  Future<bool> replaceString(String filePath, String content);
+}
+
+/// 基于文件系统的清单存储。
+class FileBatchManifestStore implements BatchManifestStore {
+  const FileBatchManifestStore();
+
+  @override
+  Future<FileStamp?> stat(String filePath) async {
+    final stat = await FileStat.stat(filePath);
+    if (stat.type == FileSystemEntityType.notFound) return null;
+    return FileStamp(
+      size: stat.size,
+      modifiedMs: stat.modified.millisecondsSinceEpoch,
+    );
+  }
+
+  @override
+  Future<Set<String>> listFileNames(String directoryPath) async {
+    final names = <String>{};
+    try {
+      await for (final entity in Directory(directoryPath).list()) {
+        if (entity is File) {
+          names.add(path.basename(entity.path));
+        }
+      }
+    } on FileSystemException {
+      // 目录不可读时视为空目录。
+    }
+    return names;
+  }
+
+  @override
+  Future<String?> readString(String filePath) async {
+    final List<int> bytes;
+    try {
+      bytes = await File(filePath).readAsBytes();
+    } on FileSystemException {
+      return null;
+    }
+    return utf8.decode(bytes);
+  }
+
+  @override
+  Future<bool> appendString(String filePath, String content) async {
+    try {
+      await File(filePath).writeAsString(
+        content,
+        mode: FileMode.append,
+        flush: true,
+      );
+      return true;
+    } on FileSystemException {
+      return false;
+    }
+  }
+
+  @override
+  Future<bool> replaceString(String filePath, String content) async {
+    final tmp = File('$filePath.tmp');
+    try {
+      await tmp.writeAsString(content, flush: true);
+      await tmp.rename(filePath);
+      return true;
+    } on FileSystemException {
+      return false;
+    }
+  }
+}
@@ -1,7 +1,10 @@
+import 'dart:io';
+
 import 'package:flutter/foundation.dart';
 import 'package:onnx_inference/onnx_inference.dart' as onnx;
 import '../../models/ai_config.dart';
 import '../gpu/gpu_info.dart';
+import 'inference_stats.dart';
 
 /// 推理引擎接口
 ///
@@ -16,6 +19,12 @@ abstract class InferenceEngine {
   /// 加载模型，返回是否成功。
   bool loadModel(String path, {bool useGpu = false});
 
+  /// 在后台加载模型，成功后替换当前模型，返回是否成功。
+  ///
+  /// 加载期间当前模型继续推理，失败时保留当前模型。后端不支持时等同于
+  /// [loadModel]。
+  Future<bool> loadModelAsync(String path, {bool useGpu = false});
+
   /// 卸载当前模型。
   void unloadModel();
 
@@ -40,6 +49,48 @@ abstract class InferenceEngine {
     required int numKeypoints,
   });
 
+  /// 打开流式批量推理会话（后端不支持时返回 null）。
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  });
+
+  /// 为当前模型打开原始输出缓存（后端不支持时返回 null）。
+  ///
+  /// 缓存随模型失效，重新加载模型后需重新打开。
+  InferenceRawCache? openRawCache(String directory);
+
+  /// 设置 [detectBatch] 的近重复跳过（[maxDistance] 为 null 时关闭）。
+  ///
+  /// 开启后与上一张推理图片的感知哈希汉明距离不超过 [maxDistance] 的图片
+  /// 直接复用其结果。后端不支持时返回 false；流式会话不受影响。
+  bool setDedupDistance(int? maxDistance);
+
+  /// 申请原生图像缓冲区（后端不支持或分配失败时返回 null）。
+  ///
+  /// 写入 RGBA 数据后传给 [detect]、[detectBatch] 或
+  /// [InferenceBatchStream.push] 时不再拷贝到原生内存；用毕以
+  /// [releaseImageBuffer] 归还。
+  Uint8List? acquireImageBuffer(int size);
+
+  /// 归还 [acquireImageBuffer] 申请的缓冲区。
+  void releaseImageBuffer(Uint8List buffer);
+
+  /// 单次推理得到多组阈值下的结果（后端不支持时返回 null）。
+  ///
+  /// 结果按 `ci * nmsThresholds.length + ni` 排列，与逐组调用 [detect] 一致。
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  });
+
   /// GPU 是否可用。
   bool isGpuAvailable();
 
@@ -49,6 +100,12 @@ abstract class InferenceEngine {
   /// 获取可用推理提供者。
   String getAvailableProviders();
 
+  /// 获取当前模型的性能统计（未加载模型或不支持时返回 null）。
+  InferenceStats? getStats();
+
+  /// 清零性能统计。
+  void resetStats();
+
   /// 最近一次错误信息。
   String get lastError;
 
@@ -59,6 +116,54 @@ abstract class InferenceEngine {
   void dispose();
 }
 
+/// 流式批量推理会话
+///
+/// 逐张推入图片，结果按 tag 增量取回，峰值内存与图片总数无关。
+abstract class InferenceBatchStream {
+  /// 推入一张 RGBA 图片，返回是否成功。
+  bool push(Uint8List rgbaBytes, int width, int height, int tag);
+
+  /// 对剩余图片立即推理，返回是否成功。
+  bool flush();
+
+  /// 取出全部已完成的结果 (tag, detections)。
+  ///
+  /// 取结果出错时抛出异常，而不是当作队列为空。
+  List<(int, Iterable<dynamic>)> drain();
+
+  /// 关闭会话并释放资源。
+  void close();
+}
+
+/// 原始输出缓存
+///
+/// 按图片文件内容缓存 NMS 前的候选框，仅阈值变化的重复推理直接重做后处理，
+/// 跳过图片解码与模型推理。
+abstract class InferenceRawCache {
+  /// 计算图片文件内容的缓存键。
+  int keyOf(Uint8List fileBytes);
+
+  /// 按阈值从缓存取结果，未命中时返回 null。
+  Iterable<dynamic>? lookup(
+    int key, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  });
+
+  /// 批量推理并写入缓存（[keys] 与 [rgbaBytesList] 一一对应）。
+  List<List<dynamic>> detectBatch(
+    List<int> keys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  });
+}
+
 /// ONNX 推理后端适配器
 ///
 /// 通过抽象层隔离原生库，便于单元测试。
@@ -67,6 +172,7 @@ abstract class OnnxBackend {
   bool get hasModel;
   bool initialize();
   bool loadModel(String path, {bool useGpu = false});
+  Future<bool> loadModelAsync(String path, {bool useGpu = false});
   void unloadModel();
   Iterable<dynamic> detect(
     Uint8List rgbaBytes,
@@ -85,9 +191,47 @@ abstract class OnnxBackend {
     required onnx.ModelType modelType,
     required int numKeypoints,
   });
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  });
+  bool enableRawCache(String? directory);
+  bool setDedupDistance(int? maxDistance);
+  Uint8List? acquireImageBuffer(int size);
+  void releaseImageBuffer(Uint8List buffer);
+  int? hashBytes(Uint8List data);
+  Iterable<dynamic>? detectCached(
+    int imageKey, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  });
+  List<List<dynamic>> detectBatchKeyed(
+    List<int> imageKeys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  });
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  });
   bool isGpuAvailable();
   onnx.GpuInfo getGpuInfo();
   String getAvailableProviders();
+  onnx.OnnxStats? getStats();
+  void resetStats();
   String get lastError;
   int get lastErrorCode;
   void dispose();
@@ -104,14 +248,25 @@ class OnnxInferenceBackend implements OnnxBackend {
   @override
   bool get hasModel => _engine.hasModel;
 
+  /// 所有模型共享一组原生线程池，加载多个模型时线程总数不变。
+  static const _initOptions = onnx.OnnxInitOptions(useGlobalThreadPools: true);
+
   @override
-  bool initialize() => _engine.initialize();
+  bool initialize() {
+    // 运行时已按默认方式初始化（如先行加载过模型）时沿用现有环境。
+    return _engine.initialize(options: _initOptions) || _engine.initialize();
+  }
 
   @override
   bool loadModel(String path, {bool useGpu = false}) {
     return _engine.loadModel(path, useGpu: useGpu);
   }
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) {
+    return _engine.loadModelAsync(path, useGpu: useGpu);
+  }
+
   @override
   void unloadModel() => _engine.unloadModel();
 
@@ -155,6 +310,116 @@ class OnnxInferenceBackend implements OnnxBackend {
     );
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    final stream = _engine.openBatchStream(
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+    return stream == null ? null : _OnnxBatchStreamAdapter(stream);
+  }
+
+  @override
+  bool enableRawCache(String? directory) {
+    return _engine.supportsRawCache && _engine.enableRawCache(directory);
+  }
+
+  @override
+  bool setDedupDistance(int? maxDistance) =>
+      _engine.setDedupDistance(maxDistance);
+
+  /// 已申请缓冲区的视图对应的原生缓冲区。
+  final Expando<onnx.OnnxImageBuffer> _imageBuffers =
+      Expando('inference_image_buffer');
+
+  @override
+  Uint8List? acquireImageBuffer(int size) {
+    final buffer = _engine.acquireImageBuffer(size);
+    if (buffer == null) return null;
+    _imageBuffers[buffer.bytes] = buffer;
+    return buffer.bytes;
+  }
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {
+    final pooled = _imageBuffers[buffer];
+    if (pooled == null) return;
+    _imageBuffers[buffer] = null;
+    _engine.releaseImageBuffer(pooled);
+  }
+
+  @override
+  int? hashBytes(Uint8List data) => _engine.hashBytes(data);
+
+  @override
+  Iterable<dynamic>? detectCached(
+    int imageKey, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return _engine.detectCached(
+      imageKey,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  List<List<dynamic>> detectBatchKeyed(
+    List<int> imageKeys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return _engine.detectBatchKeyed(
+      imageKeys,
+      rgbaBytesList,
+      sizes,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    if (!_engine.supportsSweep) return null;
+    return _engine
+        .detectSweep(
+          rgbaBytes,
+          width,
+          height,
+          confThresholds: confThresholds,
+          nmsThresholds: nmsThresholds,
+          modelType: modelType,
+          numKeypoints: numKeypoints,
+        )
+        ?.results;
+  }
+
   @override
   bool isGpuAvailable() => _engine.isGpuAvailable();
 
@@ -164,6 +429,12 @@ class OnnxInferenceBackend implements OnnxBackend {
   @override
   String getAvailableProviders() => _engine.getAvailableProviders();
 
+  @override
+  onnx.OnnxStats? getStats() => _engine.getStats();
+
+  @override
+  void resetStats() => _engine.resetStats();
+
   @override
   String get lastError => _engine.lastError;
 
@@ -174,6 +445,306 @@ class OnnxInferenceBackend implements OnnxBackend {
   void dispose() => _engine.dispose();
 }
 
+/// 将 onnx_inference 包的流式会话适配为 [InferenceBatchStream]。
+class _OnnxBatchStreamAdapter implements InferenceBatchStream {
+  _OnnxBatchStreamAdapter(this._stream);
+
+  final onnx.OnnxBatchStream _stream;
+
+  @override
+  bool push(Uint8List rgbaBytes, int width, int height, int tag) {
+    return _stream.push(rgbaBytes, width, height, tag);
+  }
+
+  @override
+  bool flush() => _stream.flush();
+
+  @override
+  List<(int, Iterable<dynamic>)> drain() => _stream.drain();
+
+  @override
+  void close() => _stream.close();
+}
+
+/// 本地推理守护进程后端。
+///
+/// 模型由 label_load_daemon 持有并与其他进程共享，并发请求在守护进程内合并
+/// 为微批次。守护进程未运行、连接断开或平台不支持时转交本地后端 [fallback]，
+/// 并按最近一次加载参数在本地重新加载模型。
+class OnnxDaemonBackend implements OnnxBackend {
+  OnnxDaemonBackend({
+    required onnx.OnnxDaemonClient? Function() connect,
+    required OnnxBackend fallback,
+  })  : _connect = connect,
+        _fallback = fallback;
+
+  final onnx.OnnxDaemonClient? Function() _connect;
+  final OnnxBackend _fallback;
+  onnx.OnnxDaemonClient? _client;
+  /// 守护进程不可用后不再重连，后续请求全部走本地后端。
+  bool _daemonUnavailable = false;
+  String? _modelPath;
+  bool _modelUseGpu = false;
+
+  /// 当前守护进程连接（按需建立）。
+  onnx.OnnxDaemonClient? get _daemon {
+    if (_daemonUnavailable) return null;
+    final client = _client ??= _connect();
+    if (client == null) _daemonUnavailable = true;
+    return client;
+  }
+
+  /// 是否正经由守护进程推理。
+  bool get usesDaemon => _client != null && !_daemonUnavailable;
+
+  /// 放弃守护进程并在本地加载最近一次的模型。
+  bool _failOver() {
+    _client?.close();
+    _client = null;
+    _daemonUnavailable = true;
+    final path = _modelPath;
+    if (path == null) return false;
+    return _fallback.initialize() &&
+        _fallback.loadModel(path, useGpu: _modelUseGpu);
+  }
+
+  bool _lostDaemon(onnx.OnnxDaemonClient client) =>
+      client.lastErrorCode == onnx.OnnxDaemonClient.errorDaemonUnavailable;
+
+  @override
+  bool get hasModel => _client?.hasModel ?? _fallback.hasModel;
+
+  @override
+  bool initialize() => _daemon != null || _fallback.initialize();
+
+  @override
+  bool loadModel(String path, {bool useGpu = false}) {
+    _modelPath = path;
+    _modelUseGpu = useGpu;
+    final client = _daemon;
+    if (client == null) {
+      return _fallback.initialize() &&
+          _fallback.loadModel(path, useGpu: useGpu);
+    }
+    if (client.loadModel(path, useGpu: useGpu)) return true;
+    return _lostDaemon(client) && _failOver();
+  }
+
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async {
+    // 守护进程在自身进程内加载，只有本地后端需要后台加载。
+    if (_daemon != null) return loadModel(path, useGpu: useGpu);
+    _modelPath = path;
+    _modelUseGpu = useGpu;
+    return _fallback.initialize() &&
+        await _fallback.loadModelAsync(path, useGpu: useGpu);
+  }
+
+  @override
+  void unloadModel() {
+    // 守护进程中的模型常驻，断开连接即可；下次加载时重新连接。
+    _modelPath = null;
+    _client?.close();
+    _client = null;
+    _fallback.unloadModel();
+  }
+
+  @override
+  Iterable<dynamic> detect(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return detectBatch(
+      [rgbaBytes],
+      [(width, height)],
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    ).first;
+  }
+
+  @override
+  List<List<dynamic>> detectBatch(
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    final client = _client;
+    if (client != null && client.hasModel) {
+      final results = client.detectBatch(
+        rgbaBytesList,
+        sizes,
+        confThreshold: confThreshold,
+        nmsThreshold: nmsThreshold,
+        modelType: modelType,
+        numKeypoints: numKeypoints,
+      );
+      if (!_lostDaemon(client) || !_failOver()) return results;
+    }
+    return _fallback.detectBatch(
+      rgbaBytesList,
+      sizes,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    // 守护进程自行合批，调用方退回 detectBatch。
+    if (usesDaemon) return null;
+    return _fallback.openBatchStream(
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  bool enableRawCache(String? directory) {
+    // 守护进程中的模型不在本进程，缓存仅用于本地推理。
+    if (usesDaemon) return false;
+    return _fallback.enableRawCache(directory);
+  }
+
+  @override
+  bool setDedupDistance(int? maxDistance) {
+    if (usesDaemon) return false;
+    return _fallback.setDedupDistance(maxDistance);
+  }
+
+  @override
+  Uint8List? acquireImageBuffer(int size) {
+    // 守护进程经共享内存取图，原生缓冲区仅用于本地推理。
+    if (usesDaemon) return null;
+    return _fallback.acquireImageBuffer(size);
+  }
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) =>
+      _fallback.releaseImageBuffer(buffer);
+
+  @override
+  int? hashBytes(Uint8List data) => _fallback.hashBytes(data);
+
+  @override
+  Iterable<dynamic>? detectCached(
+    int imageKey, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    if (usesDaemon) return null;
+    return _fallback.detectCached(
+      imageKey,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  List<List<dynamic>> detectBatchKeyed(
+    List<int> imageKeys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    if (usesDaemon) {
+      return detectBatch(
+        rgbaBytesList,
+        sizes,
+        confThreshold: confThreshold,
+        nmsThreshold: nmsThreshold,
+        modelType: modelType,
+        numKeypoints: numKeypoints,
+      );
+    }
+    return _fallback.detectBatchKeyed(
+      imageKeys,
+      rgbaBytesList,
+      sizes,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    // 守护进程协议只支持单组阈值，调用方退回逐组推理。
+    if (usesDaemon) return null;
+    return _fallback.detectSweep(
+      rgbaBytes,
+      width,
+      height,
+      confThresholds: confThresholds,
+      nmsThresholds: nmsThresholds,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  bool isGpuAvailable() => _fallback.isGpuAvailable();
+
+  @override
+  onnx.GpuInfo getGpuInfo() => _fallback.getGpuInfo();
+
+  @override
+  String getAvailableProviders() => _fallback.getAvailableProviders();
+
+  @override
+  onnx.OnnxStats? getStats() => usesDaemon ? null : _fallback.getStats();
+
+  @override
+  void resetStats() => _fallback.resetStats();
+
+  @override
+  String get lastError => _client?.lastError ?? _fallback.lastError;
+
+  @override
+  int get lastErrorCode => _client?.lastErrorCode ?? _fallback.lastErrorCode;
+
+  @override
+  void dispose() {
+    _client?.close();
+    _client = null;
+    _fallback.dispose();
+  }
+}
+
 /// ONNX 推理引擎实现。
 ///
 /// 默认使用单例 [instance] 复用底层原生资源。
@@ -183,7 +754,23 @@ class OnnxInferenceEngine implements InferenceEngine {
             OnnxInferenceBackend(engine ?? onnx.OnnxInference.instance);
 
   /// 共享的推理引擎实例。
-  static final OnnxInferenceEngine instance = OnnxInferenceEngine();
+  ///
+  /// 设置环境变量 LABEL_LOAD_DAEMON_SOCKET 时经本地推理守护进程推理（空值
+  /// 表示默认套接字路径），守护进程不可用时回退到进程内推理。
+  static final OnnxInferenceEngine instance =
+      OnnxInferenceEngine(backend: _defaultBackend());
+
+  static OnnxBackend _defaultBackend() {
+    final local = OnnxInferenceBackend(onnx.OnnxInference.instance);
+    final socket = Platform.environment['LABEL_LOAD_DAEMON_SOCKET'];
+    if (socket == null) return local;
+    return OnnxDaemonBackend(
+      connect: () => onnx.OnnxDaemonClient.connect(
+        socketPath: socket.isEmpty ? null : socket,
+      ),
+      fallback: local,
+    );
+  }
 
   final OnnxBackend _backend;
 
@@ -198,6 +785,11 @@ class OnnxInferenceEngine implements InferenceEngine {
     return _backend.loadModel(path, useGpu: useGpu);
   }
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) {
+    return _backend.loadModelAsync(path, useGpu: useGpu);
+  }
+
   @override
   void unloadModel() => _backend.unloadModel();
 
@@ -241,6 +833,59 @@ class OnnxInferenceEngine implements InferenceEngine {
     );
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return _backend.openBatchStream(
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: _convertModelType(modelType),
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) {
+    if (!_backend.enableRawCache(directory)) return null;
+    return _OnnxRawCache(this);
+  }
+
+  @override
+  bool setDedupDistance(int? maxDistance) =>
+      _backend.setDedupDistance(maxDistance);
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => _backend.acquireImageBuffer(size);
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) =>
+      _backend.releaseImageBuffer(buffer);
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return _backend.detectSweep(
+      rgbaBytes,
+      width,
+      height,
+      confThresholds: confThresholds,
+      nmsThresholds: nmsThresholds,
+      modelType: _convertModelType(modelType),
+      numKeypoints: numKeypoints,
+    );
+  }
+
   @override
   bool isGpuAvailable() => _backend.isGpuAvailable();
 
@@ -260,6 +905,32 @@ class OnnxInferenceEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => _backend.getAvailableProviders();
 
+  @override
+  InferenceStats? getStats() {
+    final stats = _backend.getStats();
+    if (stats == null) return null;
+    return InferenceStats(
+      stages: {
+        for (final entry in stats.stages.entries)
+          InferenceStage.values[entry.key.index]: InferenceStageTiming(
+            lastMs: entry.value.lastMs,
+            p50Ms: entry.value.p50Ms,
+            p95Ms: entry.value.p95Ms,
+            p99Ms: entry.value.p99Ms,
+          ),
+      },
+      calls: stats.calls,
+      images: stats.images,
+      candidates: stats.candidates,
+      detections: stats.detections,
+      bytesAllocated: stats.bytesAllocated,
+      dedupSkipped: stats.dedupSkipped,
+    );
+  }
+
+  @override
+  void resetStats() => _backend.resetStats();
+
   @override
   String get lastError => _backend.lastError;
 
@@ -275,6 +946,58 @@ class OnnxInferenceEngine implements InferenceEngine {
         return onnx.ModelType.yolo;
       case ModelType.yoloPose:
         return onnx.ModelType.yoloPose;
+      case ModelType.yoloSeg:
+        return onnx.ModelType.yoloSeg;
+      case ModelType.yoloObb:
+        return onnx.ModelType.yoloObb;
     }
   }
 }
+
+/// 基于 [OnnxInferenceEngine] 后端的原始输出缓存。
+class _OnnxRawCache implements InferenceRawCache {
+  _OnnxRawCache(this._engine);
+
+  final OnnxInferenceEngine _engine;
+
+  @override
+  int keyOf(Uint8List fileBytes) => _engine._backend.hashBytes(fileBytes) ?? 0;
+
+  @override
+  Iterable<dynamic>? lookup(
+    int key, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return _engine._backend.detectCached(
+      key,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: _engine._convertModelType(modelType),
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  @override
+  List<List<dynamic>> detectBatch(
+    List<int> keys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return _engine._backend.detectBatchKeyed(
+      keys,
+      rgbaBytesList,
+      sizes,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: _engine._convertModelType(modelType),
+      numKeypoints: numKeypoints,
+    );
+  }
+}
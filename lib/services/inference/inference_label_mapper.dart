@@ -14,8 +14,15 @@ class InferenceLabelMapper {
       final className = definitions.nameForClassId(classId);
 
       List<LabelPoint>? points;
+      var fromPolygon = false;
       final rawKeypoints = det.keypoints;
-      if (rawKeypoints is Iterable && rawKeypoints.isNotEmpty) {
+      final rawPolygon = det.polygon;
+      if (rawPolygon is Iterable && rawPolygon.isNotEmpty) {
+        points = rawPolygon.map<LabelPoint>((p) {
+          return LabelPoint(x: p.x, y: p.y);
+        }).toList();
+        fromPolygon = true;
+      } else if (rawKeypoints is Iterable && rawKeypoints.isNotEmpty) {
         points = rawKeypoints.map<LabelPoint>((kp) {
           return LabelPoint(
             x: kp.x,
@@ -25,7 +32,7 @@ class InferenceLabelMapper {
         }).toList();
       }
 
-      labels.add(Label(
+      final label = Label(
         id: classId,
         name: className,
         x: det.x,
@@ -33,7 +40,11 @@ class InferenceLabelMapper {
         width: det.width,
         height: det.height,
         points: points,
-      ));
+        pointsArePolygon: fromPolygon,
+      );
+      // 旋转框的宽高是边长而非包围盒，统一以轮廓/角点重算边界框。
+      if (fromPolygon) label.updateBboxFromPoints();
+      labels.add(label);
     }
     return labels;
   }
@@ -8,6 +8,8 @@ import '../app/error_reporter.dart';
 import '../image/image_repository.dart';
 import 'inference_label_mapper.dart';
 import 'inference_engine.dart';
+import 'inference_stats.dart';
+import 'threshold_sweep.dart';
 import '../gpu/gpu_info.dart';
 
 /// AI推理服务
@@ -20,6 +22,14 @@ class InferenceService {
   ImageRepository _imageRepository;
   String? _loadedModelPath;
   bool _isLoading = false;
+  String? _rawCacheDirectory;
+  InferenceRawCache? _rawCache;
+  // 当前模型已设置的近重复跳过距离及是否生效（模型加载时为关闭）。
+  int? _dedupDistance;
+  bool _dedupActive = false;
+
+  /// 开启近重复跳过时使用的感知哈希汉明距离（64 位 dHash）。
+  static const nearDuplicateDistance = 4;
 
   InferenceService({
     ImageRepository? imageRepository,
@@ -55,6 +65,9 @@ class InferenceService {
   /// 是否正在加载模型
   bool get isLoading => _isLoading;
 
+  /// 当前模型是否启用了原始输出缓存
+  bool get hasRawCache => _rawCache != null;
+
   @visibleForTesting
   void setImageRepository(ImageRepository repository) {
     _imageRepository = repository;
@@ -65,8 +78,27 @@ class InferenceService {
     return _engine.initialize();
   }
 
+  /// 设置原始输出缓存目录（null 关闭），对当前及之后加载的模型生效。
+  ///
+  /// 启用后批量推理按图片文件内容查询缓存，仅阈值变化的重复推理
+  /// 跳过解码与模型推理。
+  void setRawCacheDirectory(String? directory) {
+    _rawCacheDirectory = directory;
+    _openRawCache();
+  }
+
+  void _openRawCache() {
+    final directory = _rawCacheDirectory;
+    _rawCache = directory != null && _loadedModelPath != null && hasModel
+        ? _engine.openRawCache(directory)
+        : null;
+  }
+
   /// 加载ONNX模型
   ///
+  /// 新模型在后台加载，期间已加载的模型继续可用；加载成功后才替换，失败时
+  /// 保留原模型。
+  ///
   /// [modelPath] 模型文件路径
   /// [useGpu] 是否使用GPU加速
   Future<bool> loadModel(String modelPath, {bool useGpu = false}) async {
@@ -81,11 +113,8 @@ class InferenceService {
         return true;
       }
 
-      // 卸载旧模型
-      unloadModel();
-
-      // 加载新模型
-      final success = _engine.loadModel(modelPath, useGpu: useGpu);
+      // 后台加载新模型，成功后替换旧模型
+      final success = await _engine.loadModelAsync(modelPath, useGpu: useGpu);
       if (!success) {
         final details = _engine.lastError;
         final code = _engine.lastErrorCode;
@@ -103,7 +132,11 @@ class InferenceService {
         }
       }
       if (success) {
+        // 新模型的缓存与近重复跳过需重新设置。
         _loadedModelPath = modelPath;
+        _dedupDistance = null;
+        _dedupActive = false;
+        _openRawCache();
       }
 
       _isLoading = false;
@@ -124,6 +157,9 @@ class InferenceService {
   void unloadModel() {
     _engine.unloadModel();
     _loadedModelPath = null;
+    _rawCache = null;
+    _dedupDistance = null;
+    _dedupActive = false;
   }
 
   /// 对图像执行推理
@@ -142,6 +178,69 @@ class InferenceService {
       throw const AppError(AppErrorCode.aiModelNotLoaded);
     }
 
+    final image = await _decodeImageFile(imagePath);
+
+    // 执行检测
+    final detections = _withRgba(
+      [image],
+      (rgba) => _engine.detect(
+        rgba.single,
+        image.width,
+        image.height,
+        confThreshold: config.confidenceThreshold,
+        nmsThreshold: config.nmsThreshold,
+        modelType: config.modelType,
+        numKeypoints: config.numKeypoints,
+      ),
+    );
+    _throwIfEngineError();
+
+    return InferenceLabelMapper.fromDetections(
+      detections,
+      labelDefinitions,
+    );
+  }
+
+  /// 对样例图片执行阈值扫描
+  ///
+  /// 只运行一次模型，返回 [confThresholds] × [nmsThresholds] 每种组合下的
+  /// 检测数量；[config] 中的阈值被忽略。后端不支持时返回 null。
+  Future<ThresholdSweep?> runThresholdSweep(
+    String imagePath,
+    AiConfig config, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+  }) async {
+    if (!hasModel) {
+      throw const AppError(AppErrorCode.aiModelNotLoaded);
+    }
+
+    final image = await _decodeImageFile(imagePath);
+    final results = _withRgba(
+      [image],
+      (rgba) => _engine.detectSweep(
+        rgba.single,
+        image.width,
+        image.height,
+        confThresholds: confThresholds,
+        nmsThresholds: nmsThresholds,
+        modelType: config.modelType,
+        numKeypoints: config.numKeypoints,
+      ),
+    );
+    if (results == null) {
+      _throwIfEngineError();
+      return null;
+    }
+
+    return ThresholdSweep(
+      confThresholds: List.unmodifiable(confThresholds),
+      nmsThresholds: List.unmodifiable(nmsThresholds),
+      counts: List.unmodifiable(results.map((r) => r.length)),
+    );
+  }
+
+  Future<img.Image> _decodeImageFile(String imagePath) async {
     // 读取图像文件
     if (!await _imageRepository.exists(imagePath)) {
       throw AppError(AppErrorCode.imageFileNotFound, details: imagePath);
@@ -157,27 +256,7 @@ class InferenceService {
     if (image == null) {
       throw const AppError(AppErrorCode.imageDecodeFailed);
     }
-
-    // 获取RGBA格式字节数据
-    final rgbaBytes = image.getBytes(order: img.ChannelOrder.rgba);
-
-    // 转换模型类型枚举
-    // 执行检测
-    final detections = _engine.detect(
-      rgbaBytes,
-      image.width,
-      image.height,
-      confThreshold: config.confidenceThreshold,
-      nmsThreshold: config.nmsThreshold,
-      modelType: config.modelType,
-      numKeypoints: config.numKeypoints,
-    );
-    _throwIfEngineError();
-
-    return InferenceLabelMapper.fromDetections(
-      detections,
-      labelDefinitions,
-    );
+    return image;
   }
 
   /// 批量执行推理
@@ -196,15 +275,33 @@ class InferenceService {
       throw const AppError(AppErrorCode.aiModelNotLoaded);
     }
 
-    final images = await Future.wait(imagePaths.map((path) async {
-      if (!await _imageRepository.exists(path)) return null;
-      final bytes = await _imageRepository.readBytes(path);
+    final dedup = _applyDedup(config);
+
+    // 分割模型的掩码依赖原型输出，不经原始输出缓存。
+    final rawCache = _rawCache;
+    if (rawCache != null && config.modelType != ModelType.yoloSeg) {
+      return _runCachedBatch(rawCache, imagePaths, config, labelDefinitions);
+    }
+
+    // 优先使用流式会话：内存占用与图片数量无关。近重复跳过只作用于
+    // 整批推理，开启时不走流式会话。
+    final stream = dedup
+        ? null
+        : _engine.openBatchStream(
+            confThreshold: config.confidenceThreshold,
+            nmsThreshold: config.nmsThreshold,
+            modelType: config.modelType,
+            numKeypoints: config.numKeypoints,
+          );
+    if (stream != null) {
       try {
-        return await compute(_decodeImage, bytes);
-      } catch (_) {
-        return null;
+        return await _runStreamedBatch(stream, imagePaths, labelDefinitions);
+      } finally {
+        stream.close();
       }
-    }));
+    }
+
+    final images = await Future.wait(imagePaths.map(_loadImage));
 
     // 过滤掉解码失败的图片
     final validImages = <img.Image>[];
@@ -221,20 +318,19 @@ class InferenceService {
       return List.filled(imagePaths.length, []);
     }
 
-    // 准备批量数据
-    final rgbaDataList = validImages
-        .map((image) => image.getBytes(order: img.ChannelOrder.rgba))
-        .toList();
     final sizes =
         validImages.map((image) => (image.width, image.height)).toList();
     // 执行批量检测
-    final batchDetections = _engine.detectBatch(
-      rgbaDataList,
-      sizes,
-      confThreshold: config.confidenceThreshold,
-      nmsThreshold: config.nmsThreshold,
-      modelType: config.modelType,
-      numKeypoints: config.numKeypoints,
+    final batchDetections = _withRgba(
+      validImages,
+      (rgba) => _engine.detectBatch(
+        rgba,
+        sizes,
+        confThreshold: config.confidenceThreshold,
+        nmsThreshold: config.nmsThreshold,
+        modelType: config.modelType,
+        numKeypoints: config.numKeypoints,
+      ),
     );
     _throwIfEngineError();
 
@@ -252,6 +348,209 @@ class InferenceService {
     return results;
   }
 
+  /// 按配置设置近重复跳过，返回是否生效。
+  ///
+  /// 仅在设置变化时下发：重新设置会丢弃跨批次的参照图片。
+  bool _applyDedup(AiConfig config) {
+    final distance = config.skipNearDuplicates ? nearDuplicateDistance : null;
+    if (distance != _dedupDistance) {
+      _dedupActive = _engine.setDedupDistance(distance) && distance != null;
+      _dedupDistance = distance;
+    }
+    return _dedupActive;
+  }
+
+  /// 流式批量推理。
+  ///
+  /// 解码与推入流水线化：同一时刻至多持有两张已解码图片，
+  /// 推入后原生层立即完成预处理，解码结果随即可被回收。
+  Future<List<List<Label>>> _runStreamedBatch(
+    InferenceBatchStream stream,
+    List<String> imagePaths,
+    List<LabelDefinition> labelDefinitions,
+  ) async {
+    final results = List<List<Label>>.filled(imagePaths.length, []);
+
+    void collect() {
+      for (final (tag, detections) in stream.drain()) {
+        results[tag] = InferenceLabelMapper.fromDetections(
+          detections,
+          labelDefinitions,
+        );
+      }
+    }
+
+    Future<img.Image?>? pending =
+        imagePaths.isEmpty ? null : _loadImage(imagePaths.first);
+    for (int i = 0; i < imagePaths.length; i++) {
+      final image = await pending;
+      // 预取下一张，与当前图片的推理重叠。
+      pending =
+          i + 1 < imagePaths.length ? _loadImage(imagePaths[i + 1]) : null;
+      if (image == null) continue;
+
+      // 推入时原生层即完成预处理，缓冲区随即归还。
+      final pushed = _withRgba(
+        [image],
+        (rgba) => stream.push(rgba.single, image.width, image.height, i),
+      );
+      if (!pushed) {
+        await pending;
+        _throwIfEngineError();
+      }
+      collect();
+    }
+
+    if (!stream.flush()) {
+      _throwIfEngineError();
+    }
+    collect();
+    return results;
+  }
+
+  /// 经原始输出缓存批量推理。
+  ///
+  /// 按文件内容哈希查询缓存，命中的图片跳过解码与推理；
+  /// 其余图片解码后以带键批量推理写入缓存。
+  Future<List<List<Label>>> _runCachedBatch(
+    InferenceRawCache cache,
+    List<String> imagePaths,
+    AiConfig config,
+    List<LabelDefinition> labelDefinitions,
+  ) async {
+    final results = List<List<Label>>.filled(imagePaths.length, []);
+    final missIndices = <int>[];
+    final missKeys = <int>[];
+    final missBytes = <Uint8List>[];
+
+    for (int i = 0; i < imagePaths.length; i++) {
+      final path = imagePaths[i];
+      if (!await _imageRepository.exists(path)) continue;
+      final bytes = await _imageRepository.readBytes(path);
+      final key = cache.keyOf(bytes);
+      final cached = cache.lookup(
+        key,
+        confThreshold: config.confidenceThreshold,
+        nmsThreshold: config.nmsThreshold,
+        modelType: config.modelType,
+        numKeypoints: config.numKeypoints,
+      );
+      if (cached != null) {
+        results[i] =
+            InferenceLabelMapper.fromDetections(cached, labelDefinitions);
+        continue;
+      }
+      missIndices.add(i);
+      missKeys.add(key);
+      missBytes.add(bytes);
+    }
+    if (missIndices.isEmpty) return results;
+
+    final images = await Future.wait(missBytes.map(_decodeBytes));
+    final validIndices = <int>[];
+    final keys = <int>[];
+    final validImages = <img.Image>[];
+    final sizes = <(int, int)>[];
+    for (int i = 0; i < images.length; i++) {
+      final image = images[i];
+      if (image == null) continue;
+      validIndices.add(missIndices[i]);
+      keys.add(missKeys[i]);
+      validImages.add(image);
+      sizes.add((image.width, image.height));
+    }
+    if (validIndices.isEmpty) return results;
+
+    final batchDetections = _withRgba(
+      validImages,
+      (rgba) => cache.detectBatch(
+        keys,
+        rgba,
+        sizes,
+        confThreshold: config.confidenceThreshold,
+        nmsThreshold: config.nmsThreshold,
+        modelType: config.modelType,
+        numKeypoints: config.numKeypoints,
+      ),
+    );
+    _throwIfEngineError();
+
+    for (int i = 0; i < batchDetections.length; i++) {
+      results[validIndices[i]] = InferenceLabelMapper.fromDetections(
+        batchDetections[i],
+        labelDefinitions,
+      );
+    }
+    return results;
+  }
+
+  /// 读取并解码图像，失败时返回 null。
+  Future<img.Image?> _loadImage(String path) async {
+    if (!await _imageRepository.exists(path)) return null;
+    return _decodeBytes(await _imageRepository.readBytes(path));
+  }
+
+  /// 在隔离线程中解码图像，失败时返回 null。
+  Future<img.Image?> _decodeBytes(Uint8List bytes) async {
+    try {
+      return await compute(_decodeImage, bytes);
+    } catch (_) {
+      return null;
+    }
+  }
+
+  /// 把解码图像转为 RGBA 后交给 [body]，返回其结果。
+  ///
+  /// 优先写入引擎的原生图像缓冲区，推理接口不再拷贝到原生内存；引擎不支持
+  /// 或分配失败时使用 getBytes 的独立拷贝。缓冲区在 [body] 返回后归还。
+  T _withRgba<T>(List<img.Image> images, T Function(List<Uint8List>) body) {
+    final acquired = <Uint8List>[];
+    try {
+      final rgba = <Uint8List>[];
+      for (final image in images) {
+        final buffer =
+            _engine.acquireImageBuffer(image.width * image.height * 4);
+        if (buffer == null) {
+          rgba.add(image.getBytes(order: img.ChannelOrder.rgba));
+          continue;
+        }
+        acquired.add(buffer);
+        _writeRgba(image, buffer);
+        rgba.add(buffer);
+      }
+      return body(rgba);
+    } finally {
+      for (final buffer in acquired) {
+        _engine.releaseImageBuffer(buffer);
+      }
+    }
+  }
+
+  /// 把图像像素按 RGBA 写入 [out]（长度为 width * height * 4）。
+  ///
+  /// 8 位 RGB/RGBA 图像直接从像素数据转换，其余格式经 getBytes 转换。
+  static void _writeRgba(img.Image image, Uint8List out) {
+    final pixels = image.width * image.height;
+    if (image.format == img.Format.uint8 && !image.hasPalette) {
+      final src = image.toUint8List();
+      if (image.numChannels == 4) {
+        out.setRange(0, pixels * 4, src);
+        return;
+      }
+      if (image.numChannels == 3) {
+        for (var i = 0, j = 0; j < pixels * 4; i += 3, j += 4) {
+          out[j] = src[i];
+          out[j + 1] = src[i + 1];
+          out[j + 2] = src[i + 2];
+          out[j + 3] = 255;
+        }
+        return;
+      }
+    }
+    out.setRange(
+        0, pixels * 4, image.getBytes(order: img.ChannelOrder.rgba));
+  }
+
   void _throwIfEngineError() {
     final code = _engine.lastErrorCode;
     if (code == 0) return;
@@ -282,6 +581,16 @@ class InferenceService {
     return _engine.getAvailableProviders();
   }
 
+  /// 获取推理性能统计（未加载模型时返回 null）
+  InferenceStats? getStats() {
+    return _engine.getStats();
+  }
+
+  /// 清零推理性能统计
+  void resetStats() {
+    _engine.resetStats();
+  }
+
   /// 释放资源
   void dispose() {
     unloadModel();
@@ -0,0 +1,89 @@
+/// 推理阶段
+///
+/// 与原生层阶段一一对应；图片解码在 Dart 侧完成，不在其中。
+enum InferenceStage {
+  /// letterbox 预处理。
+  preprocess,
+
+  /// 模型推理。
+  run,
+
+  /// 输出解析。
+  parse,
+
+  /// 非极大值抑制。
+  nms,
+
+  /// 分割掩码组装。
+  masks,
+
+  /// 结果拷贝。
+  marshal,
+
+  /// 各阶段合计。
+  total,
+}
+
+/// 单阶段耗时（毫秒）。
+class InferenceStageTiming {
+  /// 最近一次调用耗时。
+  final double lastMs;
+
+  /// 累计中位数。
+  final double p50Ms;
+
+  /// 累计 95 分位。
+  final double p95Ms;
+
+  /// 累计 99 分位。
+  final double p99Ms;
+
+  const InferenceStageTiming({
+    required this.lastMs,
+    required this.p50Ms,
+    required this.p95Ms,
+    required this.p99Ms,
+  });
+}
+
+/// 推理性能统计
+///
+/// 由推理引擎提供，用于定位自动标注的耗时瓶颈。
+class InferenceStats {
+  /// 各阶段耗时。
+  final Map<InferenceStage, InferenceStageTiming> stages;
+
+  /// 推理调用次数。
+  final int calls;
+
+  /// 处理的图片数。
+  final int images;
+
+  /// NMS 前的候选框数。
+  final int candidates;
+
+  /// 输出的检测框数。
+  final int detections;
+
+  /// 原生层累计分配的字节数。
+  final int bytesAllocated;
+
+  /// 近重复复用结果而跳过推理的图片数。
+  final int dedupSkipped;
+
+  const InferenceStats({
+    required this.stages,
+    required this.calls,
+    required this.images,
+    required this.candidates,
+    required this.detections,
+    required this.bytesAllocated,
+    this.dedupSkipped = 0,
+  });
+
+  @override
+  String toString() =>
+      'InferenceStats(calls=$calls, images=$images, candidates=$candidates, '
+      'detections=$detections, bytes=$bytesAllocated, '
+      'dedupSkipped=$dedupSkipped)';
+}
@@ -0,0 +1,42 @@
+/// 阈值扫描结果
+///
+/// 单张样例图片在一组置信度阈值 × NMS 阈值下的检测数量，用于调节阈值时
+/// 即时预览，无需逐次重新推理。
+class ThresholdSweep {
+  /// 置信度阈值（升序）。
+  final List<double> confThresholds;
+
+  /// NMS 阈值（升序）。
+  final List<double> nmsThresholds;
+
+  /// 各组合的检测数量，按 `ci * nmsThresholds.length + ni` 排列。
+  final List<int> counts;
+
+  const ThresholdSweep({
+    required this.confThresholds,
+    required this.nmsThresholds,
+    required this.counts,
+  });
+
+  /// 第 [confIndex] 个置信度阈值与第 [nmsIndex] 个 NMS 阈值下的检测数量。
+  int countAt(int confIndex, int nmsIndex) =>
+      counts[confIndex * nmsThresholds.length + nmsIndex];
+
+  /// 取最接近 ([confidence], [nms]) 的网格点的检测数量。
+  int countNear(double confidence, double nms) {
+    return countAt(
+      _nearestIndex(confThresholds, confidence),
+      _nearestIndex(nmsThresholds, nms),
+    );
+  }
+
+  static int _nearestIndex(List<double> values, double target) {
+    var best = 0;
+    for (var i = 1; i < values.length; i++) {
+      if ((values[i] - target).abs() < (values[best] - target).abs()) {
+        best = i;
+      }
+    }
+    return best;
+  }
+}
@@ -3,6 +3,9 @@ import 'package:flutter_gen/gen_l10n/app_localizations.dart';
 import 'package:provider/provider.dart';
 import '../../models/ai_config.dart';
 import '../../services/app/app_services.dart';
+import '../../services/files/file_extensions.dart';
+import '../../services/inference/inference_stats.dart';
+import '../../services/inference/threshold_sweep.dart';
 
 /// AI推理设置组件
 ///
@@ -31,6 +34,21 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
   /// 类别偏移输入框控制器（用于映射外部模型类别）。
   late TextEditingController _classIdOffsetController;
 
+  /// 最近一次读取的推理性能统计（展开统计面板时刷新）。
+  InferenceStats? _stats;
+
+  /// 样例图片的阈值扫描结果（拖动滑块时据此即时显示检测数量）。
+  ThresholdSweep? _sweep;
+
+  /// 阈值预览的样例图片路径。
+  String? _samplePath;
+
+  /// 阈值预览是否正在推理。
+  bool _sweepRunning = false;
+
+  /// 阈值预览失败（模型未就绪、图片无法解码或后端不支持）。
+  bool _sweepFailed = false;
+
   @override
   void initState() {
     super.initState();
@@ -59,6 +77,13 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
         _classIdOffsetController.text = widget.config.classIdOffset.toString();
       }
     }
+    // 模型变化后旧的扫描结果失效。
+    if (oldWidget.config.modelPath != widget.config.modelPath ||
+        oldWidget.config.modelType != widget.config.modelType ||
+        oldWidget.config.numKeypoints != widget.config.numKeypoints) {
+      _sweep = null;
+      _sweepFailed = false;
+    }
   }
 
   @override
@@ -87,9 +112,13 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
         _buildModelPathField(l10n, theme),
         _buildConfidenceSlider(l10n, theme),
         _buildNmsSlider(l10n, theme),
+        _buildThresholdPreview(l10n, theme),
         _buildAutoInferToggle(l10n),
+        _buildSkipNearDuplicatesToggle(l10n),
         const Divider(),
         _buildLabelSaveModeSelector(l10n),
+        const Divider(),
+        _buildStatsPanel(l10n, theme),
       ],
     );
   }
@@ -141,6 +170,18 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
                     style: const TextStyle(fontSize: 12)),
                 icon: const Icon(Icons.accessibility_new, size: 16),
               ),
+              ButtonSegment(
+                value: ModelType.yoloSeg,
+                label: Text(l10n.modelTypeYoloSeg,
+                    style: const TextStyle(fontSize: 12)),
+                icon: const Icon(Icons.pentagon_outlined, size: 16),
+              ),
+              ButtonSegment(
+                value: ModelType.yoloObb,
+                label: Text(l10n.modelTypeYoloObb,
+                    style: const TextStyle(fontSize: 12)),
+                icon: const Icon(Icons.rotate_90_degrees_ccw, size: 16),
+              ),
             ],
             selected: {widget.config.modelType},
             onSelectionChanged: (selected) {
@@ -359,6 +400,102 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
     );
   }
 
+  /// 构建阈值预览
+  ///
+  /// 对样例图片只推理一次，得到滑块网格上每组阈值的检测数量。
+  Widget _buildThresholdPreview(AppLocalizations l10n, ThemeData theme) {
+    final sweep = _sweep;
+    final String text;
+    if (_sweepRunning) {
+      text = l10n.thresholdPreviewRunning;
+    } else if (_sweepFailed) {
+      text = l10n.thresholdPreviewFailed;
+    } else if (sweep == null) {
+      text = l10n.thresholdPreviewDesc;
+    } else {
+      text = l10n.thresholdPreviewCount(
+        _samplePath!.split('/').last,
+        sweep.countNear(
+            widget.config.confidenceThreshold, widget.config.nmsThreshold),
+      );
+    }
+    return Padding(
+      padding: const EdgeInsets.only(bottom: 8),
+      child: Row(
+        children: [
+          Expanded(
+            child: Text(
+              text,
+              style: TextStyle(
+                fontSize: 12,
+                color: sweep == null ? theme.hintColor : null,
+              ),
+            ),
+          ),
+          TextButton.icon(
+            onPressed: _sweepRunning ? null : _pickSampleImage,
+            icon: const Icon(Icons.image_search, size: 18),
+            label: Text(l10n.thresholdPreviewPick),
+          ),
+        ],
+      ),
+    );
+  }
+
+  /// 选择样例图片并执行阈值扫描
+  Future<void> _pickSampleImage() async {
+    final l10n = AppLocalizations.of(context)!;
+    final services = context.read<AppServices>();
+    final path = await services.filePickerService.pickFile(
+      dialogTitle: l10n.thresholdPreviewPick,
+      allowedExtensions: [
+        for (final ext in supportedImageExtensions) ext.substring(1),
+      ],
+    );
+    if (path == null || !mounted) return;
+
+    setState(() {
+      _samplePath = path;
+      _sweep = null;
+      _sweepFailed = false;
+      _sweepRunning = true;
+    });
+
+    final config = widget.config;
+    final service = services.inferenceService;
+    ThresholdSweep? sweep;
+    try {
+      // 已加载同一模型时 loadModel 直接返回。
+      final ready = config.modelPath.isEmpty
+          ? service.hasModel
+          : await service.loadModel(config.modelPath);
+      if (ready) {
+        sweep = await service.runThresholdSweep(
+          path,
+          config,
+          confThresholds: _sliderSteps(0.05, 0.95, 18),
+          nmsThresholds: _sliderSteps(0.1, 0.9, 16),
+        );
+      }
+    } catch (_) {
+      sweep = null;
+    }
+    if (!mounted) return;
+    setState(() {
+      _sweep = sweep;
+      _sweepFailed = sweep == null;
+      _sweepRunning = false;
+    });
+  }
+
+  /// 与滑块刻度一致的阈值网格。
+  static List<double> _sliderSteps(double min, double max, int divisions) {
+    return [
+      for (var i = 0; i <= divisions; i++)
+        min + (max - min) * i / divisions,
+    ];
+  }
+
   /// 构建自动推理开关
   Widget _buildAutoInferToggle(AppLocalizations l10n) {
     return SwitchListTile(
@@ -373,6 +510,20 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
     );
   }
 
+  /// 构建近重复跳过开关
+  Widget _buildSkipNearDuplicatesToggle(AppLocalizations l10n) {
+    return SwitchListTile(
+      title: Text(l10n.skipNearDuplicates),
+      subtitle: Text(l10n.skipNearDuplicatesDesc,
+          style: const TextStyle(fontSize: 12)),
+      value: widget.config.skipNearDuplicates,
+      onChanged: (value) {
+        widget.onChanged(widget.config.copyWith(skipNearDuplicates: value));
+      },
+      contentPadding: EdgeInsets.zero,
+    );
+  }
+
   /// 构建标签保存模式选择器
   Widget _buildLabelSaveModeSelector(AppLocalizations l10n) {
     return Column(
@@ -461,4 +612,98 @@ class _AiSettingsWidgetState extends State<AiSettingsWidget> {
       ],
     );
   }
+
+  /// 读取推理性能统计
+  void _refreshStats() {
+    final service = context.read<AppServices>().inferenceService;
+    setState(() => _stats = service.getStats());
+  }
+
+  /// 清零推理性能统计
+  void _resetStats() {
+    context.read<AppServices>().inferenceService.resetStats();
+    _refreshStats();
+  }
+
+  /// 构建性能统计面板
+  ///
+  /// 折叠时不读取统计，展开后按需刷新。
+  Widget _buildStatsPanel(AppLocalizations l10n, ThemeData theme) {
+    final stats = _stats;
+    return ExpansionTile(
+      title: Text(l10n.inferenceStats,
+          style: const TextStyle(fontWeight: FontWeight.w500)),
+      subtitle: Text(l10n.inferenceStatsDesc,
+          style: TextStyle(fontSize: 12, color: theme.hintColor)),
+      tilePadding: EdgeInsets.zero,
+      childrenPadding: const EdgeInsets.only(bottom: 8),
+      expandedCrossAxisAlignment: CrossAxisAlignment.start,
+      onExpansionChanged: (expanded) {
+        if (expanded) _refreshStats();
+      },
+      children: [
+        if (stats == null || stats.calls == 0)
+          Text(l10n.inferenceStatsEmpty,
+              style: TextStyle(fontSize: 12, color: theme.hintColor))
+        else ...[
+          Text(
+            l10n.inferenceStatsCounters(
+                stats.calls, stats.images, stats.candidates, stats.detections),
+            style: const TextStyle(fontSize: 12),
+          ),
+          if (stats.dedupSkipped > 0)
+            Text(
+              l10n.inferenceStatsDedupSkipped(stats.dedupSkipped),
+              style: const TextStyle(fontSize: 12),
+            ),
+          const SizedBox(height: 8),
+          _buildStatsTable(l10n, stats),
+        ],
+        Row(
+          mainAxisAlignment: MainAxisAlignment.end,
+          children: [
+            TextButton.icon(
+              onPressed: _refreshStats,
+              icon: const Icon(Icons.refresh, size: 18),
+              label: Text(l10n.inferenceStatsRefresh),
+            ),
+            TextButton.icon(
+              onPressed: _resetStats,
+              icon: const Icon(Icons.restart_alt, size: 18),
+              label: Text(l10n.inferenceStatsReset),
+            ),
+          ],
+        ),
+      ],
+    );
+  }
+
+  /// 构建各阶段耗时表（last / p50 / p95 / p99）
+  Widget _buildStatsTable(AppLocalizations l10n, InferenceStats stats) {
+    const cellStyle = TextStyle(fontSize: 12);
+    const headerStyle = TextStyle(fontSize: 12, fontWeight: FontWeight.w500);
+    Widget cell(String text, {TextStyle style = cellStyle}) => Padding(
+          padding: const EdgeInsets.symmetric(vertical: 2),
+          child: Text(text, style: style),
+        );
+
+    return Table(
+      columnWidths: const {0: FlexColumnWidth(1.5)},
+      children: [
+        TableRow(children: [
+          cell(l10n.inferenceStatsStage, style: headerStyle),
+          for (final header in const ['last', 'p50', 'p95', 'p99'])
+            cell(header, style: headerStyle),
+        ]),
+        for (final entry in stats.stages.entries)
+          TableRow(children: [
+            cell(entry.key.name),
+            cell(entry.value.lastMs.toStringAsFixed(2)),
+            cell(entry.value.p50Ms.toStringAsFixed(2)),
+            cell(entry.value.p95Ms.toStringAsFixed(2)),
+            cell(entry.value.p99Ms.toStringAsFixed(2)),
+          ]),
+      ],
+    );
+  }
 }
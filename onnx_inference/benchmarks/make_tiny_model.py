@@ -0,0 +1,182 @@
+#!/usr/bin/env python3
+"""生成用于基准与 CI 的微型 YOLOv8 形状模型。
+
+输入 images [batch, 3, 640, 640]，输出 output0 [batch, 84, 8400]，与
+YOLOv8 检测模型一致（4 个框坐标 + 80 类得分，8400 = 80² + 40² + 20²）。
+三路平均池化（步长 8/16/32）各接 1x1 卷积后拼接，Sigmoid 后按通道缩放：
+坐标落在 0-640 像素，类别得分偏低，只有少量候选框超过默认阈值。
+
+权重由固定公式生成，输出文件逐字节可复现。仅依赖 Python 标准库
+（手写 protobuf 编码），CI 无需安装 onnx 包。
+
+用法: python3 make_tiny_model.py [输出路径]
+"""
+
+import math
+import struct
+import sys
+
+INPUT_SIZE = 640
+NUM_CHANNELS = 84
+STRIDES = (8, 16, 32)
+OPSET = 13
+
+
+# ---------------------------------------------------------------------------
+# protobuf 编码
+# ---------------------------------------------------------------------------
+
+
+def _varint(value):
+    out = bytearray()
+    value &= (1 << 64) - 1
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def _key(field, wire_type):
+    return _varint((field << 3) | wire_type)
+
+
+def _int(field, value):
+    return _key(field, 0) + _varint(value)
+
+
+def _bytes(field, data):
+    if isinstance(data, str):
+        data = data.encode("utf-8")
+    return _key(field, 2) + _varint(len(data)) + data
+
+
+# ---------------------------------------------------------------------------
+# ONNX 消息
+# ---------------------------------------------------------------------------
+
+FLOAT = 1
+INT64 = 7
+ATTR_INT = 2
+ATTR_INTS = 7
+
+
+def tensor(name, dims, data_type, raw):
+    msg = b"".join(_int(1, d) for d in dims)
+    return msg + _int(2, data_type) + _bytes(8, name) + _bytes(9, raw)
+
+
+def float_tensor(name, dims, values):
+    return tensor(name, dims, FLOAT, struct.pack("<%df" % len(values), *values))
+
+
+def int64_tensor(name, dims, values):
+    return tensor(name, dims, INT64, struct.pack("<%dq" % len(values), *values))
+
+
+def attr_int(name, value):
+    return _bytes(1, name) + _int(20, ATTR_INT) + _int(3, value)
+
+
+def attr_ints(name, values):
+    msg = _bytes(1, name) + _int(20, ATTR_INTS)
+    return msg + b"".join(_int(8, v) for v in values)
+
+
+def node(op_type, inputs, outputs, name, attrs=()):
+    msg = b"".join(_bytes(1, i) for i in inputs)
+    msg += b"".join(_bytes(2, o) for o in outputs)
+    msg += _bytes(3, name) + _bytes(4, op_type)
+    return msg + b"".join(_bytes(5, a) for a in attrs)
+
+
+def value_info(name, dims):
+    shape = b""
+    for dim in dims:
+        if isinstance(dim, str):
+            shape += _bytes(1, _bytes(2, dim))
+        else:
+            shape += _bytes(1, _int(1, dim))
+    tensor_type = _int(1, FLOAT) + _bytes(2, shape)
+    return _bytes(1, name) + _bytes(2, _bytes(1, tensor_type))
+
+
+# ---------------------------------------------------------------------------
+# 模型
+# ---------------------------------------------------------------------------
+
+
+def conv_params(branch):
+    """1x1 卷积权重 [84, 3, 1, 1] 与偏置 [84]（确定性公式）。"""
+    weights = []
+    bias = []
+    for c in range(NUM_CHANNELS):
+        for k in range(3):
+            weights.append(4.0 * math.sin(1.7 * c + 2.3 * k + 0.9 * branch))
+        # 坐标通道居中，类别通道偏负，使大部分得分落在阈值以下。
+        bias.append(0.0 if c < 4 else -5.5 + 0.1 * ((c * 7 + branch) % 11))
+    return weights, bias
+
+
+def build_model():
+    nodes = []
+    initializers = []
+    concat_inputs = []
+    for branch, stride in enumerate(STRIDES):
+        pooled = "pool%d" % stride
+        conv = "conv%d" % stride
+        flat = "flat%d" % stride
+        weights, bias = conv_params(branch)
+        initializers.append(
+            float_tensor("w%d" % stride, [NUM_CHANNELS, 3, 1, 1], weights))
+        initializers.append(float_tensor("b%d" % stride, [NUM_CHANNELS], bias))
+        nodes.append(node("AveragePool", ["images"], [pooled], pooled, [
+            attr_ints("kernel_shape", [stride, stride]),
+            attr_ints("strides", [stride, stride]),
+        ]))
+        nodes.append(node("Conv", [pooled, "w%d" % stride, "b%d" % stride],
+                          [conv], conv))
+        nodes.append(node("Reshape", [conv, "flat_shape"], [flat], flat))
+        concat_inputs.append(flat)
+
+    initializers.append(int64_tensor("flat_shape", [3], [0, NUM_CHANNELS, -1]))
+    # 中心点覆盖整幅输入，宽高不超过输入的 1/4。
+    scale = [float(INPUT_SIZE)] * 2 + [INPUT_SIZE / 4.0] * 2
+    scale += [1.0] * (NUM_CHANNELS - 4)
+    initializers.append(float_tensor("channel_scale", [1, NUM_CHANNELS, 1],
+                                     scale))
+    nodes.append(node("Concat", concat_inputs, ["concat"], "concat",
+                      [attr_int("axis", 2)]))
+    nodes.append(node("Sigmoid", ["concat"], ["sigmoid"], "sigmoid"))
+    nodes.append(node("Mul", ["sigmoid", "channel_scale"], ["output0"],
+                      "scale"))
+
+    num_boxes = sum((INPUT_SIZE // s) ** 2 for s in STRIDES)
+    graph = b"".join(_bytes(1, n) for n in nodes)
+    graph += _bytes(2, "tiny_yolov8")
+    graph += b"".join(_bytes(5, t) for t in initializers)
+    graph += _bytes(11, value_info("images",
+                                   ["batch", 3, INPUT_SIZE, INPUT_SIZE]))
+    graph += _bytes(12, value_info("output0",
+                                   ["batch", NUM_CHANNELS, num_boxes]))
+
+    opset = _bytes(1, "") + _int(2, OPSET)
+    model = _int(1, 7)  # ir_version
+    model += _bytes(2, "label_load")  # producer_name
+    model += _bytes(7, graph)
+    model += _bytes(8, opset)
+    return model
+
+
+def main():
+    path = sys.argv[1] if len(sys.argv) > 1 else "tiny_yolov8.onnx"
+    with open(path, "wb") as f:
+        f.write(build_model())
+    print(path)
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,508 @@
+/**
+ * ONNX 推理端到端吞吐基准
+ *
+ * 通过公开 C API 走完整的 onnx_detect_batch 路径（预处理、推理、解析、NMS、
+ * 结果拷贝），报告吞吐、调用延迟分位数、各阶段耗时与峰值 RSS。
+ * 不依赖 Flutter；默认使用随仓库提供的微型模型与合成图片，可直接用于 CI。
+ *
+ * 用法: onnx_bench [选项]
+ *   --model PATH        模型路径（默认 benchmarks/tiny_yolov8.onnx）
+ *   --images DIR        图片目录（二进制 PPM，P6）；缺省时使用合成图片
+ *   --synthetic N       合成图片数量（默认 16）
+ *   --batch LIST        批量大小列表，逗号分隔（默认 1,4,8）
+ *   --workers N         并发线程数，每个线程持有独立模型句柄（默认 1）
+ *   --shared-threads N  所有句柄共享 N 个 ORT 算子内线程（0 为物理核数）；
+ *                       缺省时每个句柄各自创建线程
+ *   --iterations N      每种配置的计时调用次数（默认 20）
+ *   --warmup N          预热调用次数（默认 3）
+ *   --gpu               请求 GPU 执行提供程序
+ *   --out PATH          JSON 输出路径（默认标准输出；人类可读报告写到标准错误）
+ */
+#include "onnx_inference.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+#ifndef ONNX_BENCH_DEFAULT_MODEL
+#define ONNX_BENCH_DEFAULT_MODEL "tiny_yolov8.onnx"
+#endif
+
+namespace {
+
+struct BenchOptions {
+  std::string model_path = ONNX_BENCH_DEFAULT_MODEL;
+  std::string image_dir;
+  int synthetic = 16;
+  std::vector<int> batch_sizes = {1, 4, 8};
+  int workers = 1;
+  int shared_threads = -1; // -1 表示不使用全局线程池
+  int iterations = 20;
+  int warmup = 3;
+  bool use_gpu = false;
+  std::string out_path;
+};
+
+struct Image {
+  std::string name;
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+struct RunResult {
+  int batch_size = 0;
+  int workers = 0;
+  int64_t calls = 0;
+  int64_t images = 0;
+  int64_t detections = 0;
+  double wall_ms = 0;
+  double images_per_sec = 0;
+  double p50_ms = 0;
+  double p99_ms = 0;
+  double max_ms = 0;
+  OnnxStats stats{};
+};
+
+const char *const kStageNames[ONNX_STAGE_COUNT] = {
+    "preprocess", "run", "parse", "nms", "masks", "marshal", "total"};
+
+// 峰值常驻内存（字节）。
+int64_t peak_rss_bytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters;
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                           sizeof(counters))) {
+    return (int64_t)counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+#ifdef __APPLE__
+  return (int64_t)usage.ru_maxrss; // macOS 以字节为单位
+#else
+  return (int64_t)usage.ru_maxrss * 1024; // Linux 以 KiB 为单位
+#endif
+#endif
+}
+
+// 读取 PPM 头部的下一个整数（跳过空白与注释）。
+bool read_ppm_int(FILE *file, int *value) {
+  int ch = fgetc(file);
+  while (ch != EOF) {
+    if (ch == '#') {
+      while (ch != EOF && ch != '\n') {
+        ch = fgetc(file);
+      }
+    } else if (ch == ' ' || ch == '\t' || ch == '\r' || ch == '\n') {
+      ch = fgetc(file);
+    } else {
+      break;
+    }
+  }
+  if (ch < '0' || ch > '9') {
+    return false;
+  }
+  *value = 0;
+  while (ch >= '0' && ch <= '9') {
+    *value = *value * 10 + (ch - '0');
+    ch = fgetc(file);
+  }
+  return true;
+}
+
+// 加载二进制 PPM（P6，8 位）为 RGBA。
+bool load_ppm(const std::string &path, Image *image) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  char magic[2] = {0, 0};
+  int maxval = 0;
+  bool ok = fread(magic, 1, 2, file) == 2 && magic[0] == 'P' &&
+            magic[1] == '6' && read_ppm_int(file, &image->width) &&
+            read_ppm_int(file, &image->height) &&
+            read_ppm_int(file, &maxval) && maxval == 255 &&
+            image->width > 0 && image->height > 0;
+  if (ok) {
+    size_t pixels = (size_t)image->width * image->height;
+    std::vector<uint8_t> rgb(pixels * 3);
+    ok = fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    image->rgba.resize(pixels * 4);
+    for (size_t i = 0; ok && i < pixels; i++) {
+      image->rgba[i * 4 + 0] = rgb[i * 3 + 0];
+      image->rgba[i * 4 + 1] = rgb[i * 3 + 1];
+      image->rgba[i * 4 + 2] = rgb[i * 3 + 2];
+      image->rgba[i * 4 + 3] = 255;
+    }
+  }
+  fclose(file);
+  return ok;
+}
+
+std::vector<Image> load_image_dir(const std::string &dir) {
+  std::vector<Image> images;
+  std::error_code error;
+  std::vector<std::filesystem::path> paths;
+  for (const auto &entry : std::filesystem::directory_iterator(dir, error)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".ppm") {
+      paths.push_back(entry.path());
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  for (const auto &path : paths) {
+    Image image;
+    image.name = path.filename().string();
+    if (load_ppm(path.string(), &image)) {
+      images.push_back(std::move(image));
+    } else {
+      fprintf(stderr, "跳过无法解析的图片: %s\n", path.string().c_str());
+    }
+  }
+  return images;
+}
+
+// 合成图片：常见相机分辨率轮换，渐变加伪随机噪声。
+std::vector<Image> make_synthetic_images(int count) {
+  static const int kSizes[][2] = {{640, 480}, {1280, 720}, {1920, 1080}};
+  std::vector<Image> images(count);
+  uint32_t state = 12345;
+  for (int i = 0; i < count; i++) {
+    Image &image = images[i];
+    image.width = kSizes[i % 3][0];
+    image.height = kSizes[i % 3][1];
+    image.name = "synthetic_" + std::to_string(i);
+    image.rgba.resize((size_t)image.width * image.height * 4);
+    for (int y = 0; y < image.height; y++) {
+      for (int x = 0; x < image.width; x++) {
+        state = state * 1664525u + 1013904223u;
+        uint8_t noise = (uint8_t)(state >> 27);
+        uint8_t *px = &image.rgba[((size_t)y * image.width + x) * 4];
+        px[0] = (uint8_t)((x * 255 / image.width + noise + i * 17) & 0xFF);
+        px[1] = (uint8_t)((y * 255 / image.height + noise) & 0xFF);
+        px[2] = (uint8_t)(((x + y) & 0xFF) ^ noise);
+        px[3] = 255;
+      }
+    }
+  }
+  return images;
+}
+
+double percentile(std::vector<double> values, double q) {
+  if (values.empty()) {
+    return 0;
+  }
+  std::sort(values.begin(), values.end());
+  size_t index = (size_t)std::min<double>(values.size() - 1,
+                                          q * (double)values.size());
+  return values[index];
+}
+
+// 单个工作线程：独立句柄，循环取图组成批次并计时。
+struct Worker {
+  ModelHandle handle = nullptr;
+  std::vector<double> latencies_ms;
+  int64_t images = 0;
+  int64_t detections = 0;
+  std::string error;
+};
+
+bool run_calls(Worker *worker, const std::vector<Image> &images,
+               int batch_size, int calls, int offset, bool record) {
+  std::vector<const uint8_t *> data(batch_size);
+  std::vector<int> widths(batch_size);
+  std::vector<int> heights(batch_size);
+  for (int call = 0; call < calls; call++) {
+    for (int i = 0; i < batch_size; i++) {
+      const Image &image =
+          images[(size_t)(offset + call * batch_size + i) % images.size()];
+      data[i] = image.rgba.data();
+      widths[i] = image.width;
+      heights[i] = image.height;
+    }
+    auto start = std::chrono::steady_clock::now();
+    BatchDetectionResult *result = onnx_detect_batch(
+        worker->handle, data.data(), batch_size, widths.data(), heights.data(),
+        0.25f, 0.45f, MODEL_TYPE_YOLO, 0);
+    double ms = std::chrono::duration<double, std::milli>(
+                    std::chrono::steady_clock::now() - start)
+                    .count();
+    if (!result) {
+      worker->error = onnx_get_last_error();
+      return false;
+    }
+    if (record) {
+      worker->latencies_ms.push_back(ms);
+      worker->images += batch_size;
+      for (int i = 0; i < result->num_images; i++) {
+        worker->detections += result->results[i].count;
+      }
+    }
+    onnx_free_batch_result(result);
+  }
+  return true;
+}
+
+bool run_config(const BenchOptions &options, const std::vector<Image> &images,
+                int batch_size, RunResult *out) {
+  std::vector<Worker> workers(options.workers);
+  for (Worker &worker : workers) {
+    worker.handle = onnx_load_model(options.model_path.c_str(),
+                                    options.use_gpu);
+    if (!worker.handle) {
+      fprintf(stderr, "加载模型失败: %s\n", onnx_get_last_error());
+      for (Worker &loaded : workers) {
+        onnx_unload_model(loaded.handle);
+      }
+      return false;
+    }
+  }
+
+  // 预热后清零统计，只计入稳态调用。
+  for (size_t w = 0; w < workers.size(); w++) {
+    if (!run_calls(&workers[w], images, batch_size, options.warmup,
+                   (int)w * batch_size, false)) {
+      fprintf(stderr, "推理失败: %s\n", workers[w].error.c_str());
+      for (Worker &worker : workers) {
+        onnx_unload_model(worker.handle);
+      }
+      return false;
+    }
+    onnx_reset_stats(workers[w].handle);
+  }
+
+  std::atomic<bool> ok{true};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (size_t w = 0; w < workers.size(); w++) {
+    threads.emplace_back([&, w] {
+      if (!run_calls(&workers[w], images, batch_size, options.iterations,
+                     (int)w * batch_size, true)) {
+        ok = false;
+      }
+    });
+  }
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  double wall_ms = std::chrono::duration<double, std::milli>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  std::vector<double> latencies;
+  out->batch_size = batch_size;
+  out->workers = options.workers;
+  out->wall_ms = wall_ms;
+  for (Worker &worker : workers) {
+    if (!worker.error.empty()) {
+      fprintf(stderr, "推理失败: %s\n", worker.error.c_str());
+    }
+    latencies.insert(latencies.end(), worker.latencies_ms.begin(),
+                     worker.latencies_ms.end());
+    out->images += worker.images;
+    out->detections += worker.detections;
+  }
+  out->calls = (int64_t)latencies.size();
+  out->images_per_sec = wall_ms > 0 ? out->images * 1000.0 / wall_ms : 0;
+  out->p50_ms = percentile(latencies, 0.50);
+  out->p99_ms = percentile(latencies, 0.99);
+  out->max_ms = percentile(latencies, 1.0);
+  // 各阶段耗时取自首个句柄（各线程负载相同）。
+  onnx_get_stats(workers[0].handle, &out->stats);
+
+  for (Worker &worker : workers) {
+    onnx_unload_model(worker.handle);
+  }
+  return ok;
+}
+
+void print_report(const BenchOptions &options, const std::vector<Image> &images,
+                  const std::vector<RunResult> &results) {
+  fprintf(stderr, "模型: %s\n", options.model_path.c_str());
+  fprintf(stderr, "图片: %zu 张 (%s), 线程: %d, 计时调用: %d\n", images.size(),
+          options.image_dir.empty() ? "合成" : options.image_dir.c_str(),
+          options.workers, options.iterations);
+  fprintf(stderr, "%6s %10s %10s %10s %9s %9s %9s %9s\n", "batch", "img/s",
+          "p50 ms", "p99 ms", "prep", "run", "parse", "nms");
+  for (const RunResult &r : results) {
+    fprintf(stderr, "%6d %10.1f %10.2f %10.2f %9.2f %9.2f %9.2f %9.2f\n",
+            r.batch_size, r.images_per_sec, r.p50_ms, r.p99_ms,
+            r.stats.p50_ms[ONNX_STAGE_PREPROCESS], r.stats.p50_ms[ONNX_STAGE_RUN],
+            r.stats.p50_ms[ONNX_STAGE_PARSE], r.stats.p50_ms[ONNX_STAGE_NMS]);
+  }
+  fprintf(stderr, "峰值 RSS: %.1f MiB\n", peak_rss_bytes() / 1048576.0);
+}
+
+bool write_json(const BenchOptions &options, const std::vector<Image> &images,
+                const std::vector<RunResult> &results) {
+  FILE *file = options.out_path.empty() ? stdout
+                                        : fopen(options.out_path.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "无法写入 %s\n", options.out_path.c_str());
+    return false;
+  }
+  fprintf(file, "{\n  \"suite\": \"onnx_bench\",\n  \"schema\": 1,\n");
+  fprintf(file, "  \"onnxruntime\": \"%s\",\n", onnx_get_version());
+  fprintf(file, "  \"providers\": \"%s\",\n", onnx_get_available_providers());
+  fprintf(file, "  \"use_gpu\": %s,\n", options.use_gpu ? "true" : "false");
+  fprintf(file, "  \"images\": %zu,\n  \"synthetic\": %s,\n", images.size(),
+          options.image_dir.empty() ? "true" : "false");
+  fprintf(file, "  \"workers\": %d,\n  \"iterations\": %d,\n", options.workers,
+          options.iterations);
+  fprintf(file, "  \"shared_threads\": %d,\n", options.shared_threads);
+  fprintf(file, "  \"peak_rss_bytes\": %lld,\n",
+          (long long)peak_rss_bytes());
+  fprintf(file, "  \"results\": [");
+  for (size_t i = 0; i < results.size(); i++) {
+    const RunResult &r = results[i];
+    fprintf(file,
+            "%s\n    {\"batch_size\": %d, \"calls\": %lld, \"images\": %lld, "
+            "\"detections\": %lld, \"wall_ms\": %.3f, "
+            "\"images_per_sec\": %.3f, \"latency_p50_ms\": %.3f, "
+            "\"latency_p99_ms\": %.3f, \"latency_max_ms\": %.3f,\n"
+            "     \"stages_p50_ms\": {",
+            i == 0 ? "" : ",", r.batch_size, (long long)r.calls,
+            (long long)r.images, (long long)r.detections, r.wall_ms,
+            r.images_per_sec, r.p50_ms, r.p99_ms, r.max_ms);
+    for (int stage = 0; stage < ONNX_STAGE_COUNT; stage++) {
+      fprintf(file, "%s\"%s\": %.4f", stage == 0 ? "" : ", ",
+              kStageNames[stage], r.stats.p50_ms[stage]);
+    }
+    fprintf(file, "}}");
+  }
+  fprintf(file, "\n  ]\n}\n");
+  if (file != stdout) {
+    fclose(file);
+  }
+  return true;
+}
+
+bool parse_int_list(const char *text, std::vector<int> *out) {
+  out->clear();
+  std::string token;
+  for (const char *p = text;; p++) {
+    if (*p == ',' || *p == '\0') {
+      int value = atoi(token.c_str());
+      if (value <= 0) {
+        return false;
+      }
+      out->push_back(value);
+      token.clear();
+      if (*p == '\0') {
+        break;
+      }
+    } else {
+      token += *p;
+    }
+  }
+  return !out->empty();
+}
+
+bool parse_args(int argc, char **argv, BenchOptions *options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    bool ok = true;
+    if (arg == "--model" && has_value) {
+      options->model_path = argv[++i];
+    } else if (arg == "--images" && has_value) {
+      options->image_dir = argv[++i];
+    } else if (arg == "--synthetic" && has_value) {
+      options->synthetic = atoi(argv[++i]);
+      ok = options->synthetic > 0;
+    } else if (arg == "--batch" && has_value) {
+      ok = parse_int_list(argv[++i], &options->batch_sizes);
+    } else if (arg == "--workers" && has_value) {
+      options->workers = atoi(argv[++i]);
+      ok = options->workers > 0;
+    } else if (arg == "--shared-threads" && has_value) {
+      options->shared_threads = atoi(argv[++i]);
+      ok = options->shared_threads >= 0;
+    } else if (arg == "--iterations" && has_value) {
+      options->iterations = atoi(argv[++i]);
+      ok = options->iterations > 0;
+    } else if (arg == "--warmup" && has_value) {
+      options->warmup = atoi(argv[++i]);
+      ok = options->warmup >= 0;
+    } else if (arg == "--gpu") {
+      options->use_gpu = true;
+    } else if (arg == "--out" && has_value) {
+      options->out_path = argv[++i];
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      fprintf(stderr,
+              "用法: %s [--model PATH] [--images DIR | --synthetic N] "
+              "[--batch 1,4,8] [--workers N] [--shared-threads N] "
+              "[--iterations N] [--warmup N] [--gpu] [--out PATH]\n",
+              argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  if (!parse_args(argc, argv, &options)) {
+    return 2;
+  }
+  OnnxInitOptions init_options;
+  onnx_default_init_options(&init_options);
+  if (options.shared_threads >= 0) {
+    init_options.use_global_thread_pools = true;
+    init_options.intra_op_threads = options.shared_threads;
+  }
+  if (!onnx_init_with_options(&init_options)) {
+    fprintf(stderr, "初始化失败: %s\n", onnx_get_last_error());
+    return 1;
+  }
+
+  std::vector<Image> images = options.image_dir.empty()
+                                  ? make_synthetic_images(options.synthetic)
+                                  : load_image_dir(options.image_dir);
+  if (images.empty()) {
+    fprintf(stderr, "没有可用的图片\n");
+    onnx_cleanup();
+    return 1;
+  }
+
+  std::vector<RunResult> results;
+  bool ok = true;
+  for (int batch_size : options.batch_sizes) {
+    RunResult result;
+    if (!run_config(options, images, batch_size, &result)) {
+      ok = false;
+      break;
+    }
+    results.push_back(result);
+  }
+
+  if (ok) {
+    print_report(options, images, results);
+    ok = write_json(options, images, results);
+  }
+  onnx_cleanup();
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,439 @@
+/**
+ * ONNX 推理插件热点路径基准测试
+ *
+ * 不依赖模型与 GPU，在合成数据上测量预处理、输出解析、NMS/IoU 与结果
+ * 拷贝/释放的耗时，结果以 JSON 输出，便于跨版本对比。
+ *
+ * 用法: onnx_inference_bench [--filter 子串] [--min-time-ms N] [--out 文件]
+ */
+#include "onnx_inference_utils.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+// 模型输入尺寸与 YOLOv8 候选框数（640x640 下 80² + 40² + 20²）。
+constexpr int kInputSize = 640;
+constexpr int kNumBoxes = 8400;
+constexpr int kNumClasses = 80;
+constexpr int kNumKeypoints = 17;
+constexpr float kConfThreshold = 0.25f;
+constexpr float kNmsThreshold = 0.45f;
+
+// 防止被测结果被优化掉。
+volatile uint64_t g_sink = 0;
+
+struct BenchOptions {
+  std::string filter;
+  double min_time_ms = 200.0;
+  std::string out_path;
+};
+
+struct BenchResult {
+  std::string name;
+  int64_t iterations = 0;
+  int64_t items = 0; // 每次迭代处理的元素数（像素、候选框、框对等）
+  double min_ns = 0;
+  double median_ns = 0;
+  double p95_ns = 0;
+  double mean_ns = 0;
+};
+
+// 运行一个用例：setup 不计时，body 计时；至少运行 min_time_ms 且不少于 10 次。
+bool run_case(const BenchOptions &options, std::vector<BenchResult> *results,
+              const std::string &name, int64_t items,
+              const std::function<void()> &setup,
+              const std::function<void()> &body) {
+  if (!options.filter.empty() &&
+      name.find(options.filter) == std::string::npos) {
+    return false;
+  }
+  using Clock = std::chrono::steady_clock;
+
+  // 预热：填充缓存并让暂存区增长到稳态。
+  for (int i = 0; i < 3; i++) {
+    setup();
+    body();
+  }
+
+  std::vector<double> samples;
+  double elapsed_ms = 0;
+  while (elapsed_ms < options.min_time_ms || samples.size() < 10) {
+    setup();
+    auto start = Clock::now();
+    body();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start)
+                    .count();
+    samples.push_back(ns);
+    elapsed_ms += ns / 1e6;
+  }
+
+  std::sort(samples.begin(), samples.end());
+  double sum = 0;
+  for (double ns : samples) {
+    sum += ns;
+  }
+  BenchResult result;
+  result.name = name;
+  result.iterations = (int64_t)samples.size();
+  result.items = items;
+  result.min_ns = samples.front();
+  result.median_ns = samples[samples.size() / 2];
+  result.p95_ns = samples[std::min(samples.size() - 1,
+                                   (size_t)(samples.size() * 0.95))];
+  result.mean_ns = sum / (double)samples.size();
+  results->push_back(result);
+
+  fprintf(stderr, "%-40s %10.1f us (p95 %10.1f us, n=%lld)\n", name.c_str(),
+          result.median_ns / 1e3, result.p95_ns / 1e3,
+          (long long)result.iterations);
+  return true;
+}
+
+// 每组用例使用独立的固定种子，合成数据不随版本与 --filter 变化。
+std::mt19937 seeded_rng(const char *group) {
+  std::seed_seq seed(group, group + strlen(group));
+  return std::mt19937(seed);
+}
+
+// 合成 RGBA 图像（渐变加噪声，避免全零数据走捷径）。
+std::vector<uint8_t> make_image(int width, int height, std::mt19937 *rng) {
+  std::vector<uint8_t> image((size_t)width * height * 4);
+  std::uniform_int_distribution<int> noise(0, 31);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t *px = &image[((size_t)y * width + x) * 4];
+      px[0] = (uint8_t)((x * 255 / width + noise(*rng)) & 0xFF);
+      px[1] = (uint8_t)((y * 255 / height + noise(*rng)) & 0xFF);
+      px[2] = (uint8_t)(((x + y) & 0xFF) ^ noise(*rng));
+      px[3] = 255;
+    }
+  }
+  return image;
+}
+
+// 合成 YOLOv8 输出 [num_features, kNumBoxes]（特征优先）。
+//
+// 多数候选框得分很低；num_objects 个目标各自在附近激活一簇候选框，
+// 与真实模型输出中 NMS 前的候选分布相近。
+std::vector<float> make_yolo_output(int model_type, int num_objects,
+                                    std::mt19937 *rng) {
+  int extra = model_type == MODEL_TYPE_YOLO_POSE ? kNumKeypoints * 3 : 0;
+  int num_classes = model_type == MODEL_TYPE_YOLO_POSE ? 1 : kNumClasses;
+  int num_features = 4 + num_classes + extra;
+  std::vector<float> out((size_t)num_features * kNumBoxes);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  auto at = [&](int feature, int box) -> float & {
+    return out[(size_t)feature * kNumBoxes + box];
+  };
+
+  for (int box = 0; box < kNumBoxes; box++) {
+    at(0, box) = unit(*rng) * kInputSize;
+    at(1, box) = unit(*rng) * kInputSize;
+    at(2, box) = 8.0f + unit(*rng) * 120.0f;
+    at(3, box) = 8.0f + unit(*rng) * 120.0f;
+    for (int c = 0; c < num_classes; c++) {
+      at(4 + c, box) = unit(*rng) * 0.05f;
+    }
+    for (int k = 0; k < extra; k++) {
+      at(4 + num_classes + k, box) = unit(*rng) * kInputSize;
+    }
+  }
+
+  std::uniform_int_distribution<int> pick_box(0, kNumBoxes - 1);
+  std::uniform_int_distribution<int> pick_class(0, num_classes - 1);
+  std::uniform_int_distribution<int> cluster(10, 30);
+  for (int obj = 0; obj < num_objects; obj++) {
+    float cx = 40.0f + unit(*rng) * (kInputSize - 80);
+    float cy = 40.0f + unit(*rng) * (kInputSize - 80);
+    float w = 20.0f + unit(*rng) * 200.0f;
+    float h = 20.0f + unit(*rng) * 200.0f;
+    int cls = pick_class(*rng);
+    int anchors = cluster(*rng);
+    for (int a = 0; a < anchors; a++) {
+      int box = pick_box(*rng);
+      at(0, box) = cx + (unit(*rng) - 0.5f) * w * 0.2f;
+      at(1, box) = cy + (unit(*rng) - 0.5f) * h * 0.2f;
+      at(2, box) = w * (0.9f + unit(*rng) * 0.2f);
+      at(3, box) = h * (0.9f + unit(*rng) * 0.2f);
+      at(4 + cls, box) = 0.3f + unit(*rng) * 0.65f;
+    }
+  }
+  return out;
+}
+
+// 生成带关键点的检测结果（用于结果拷贝/释放路径）。
+std::vector<Detection> make_pose_detections(int count,
+                                            std::vector<float> *keypoints,
+                                            std::mt19937 *rng) {
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  keypoints->assign((size_t)count * kNumKeypoints * 3, 0.0f);
+  for (float &v : *keypoints) {
+    v = unit(*rng);
+  }
+  std::vector<Detection> detections(count);
+  for (int i = 0; i < count; i++) {
+    Detection &det = detections[i];
+    det = Detection{};
+    det.class_id = 0;
+    det.confidence = 0.3f + unit(*rng) * 0.7f;
+    det.x = unit(*rng);
+    det.y = unit(*rng);
+    det.width = 0.05f + unit(*rng) * 0.3f;
+    det.height = 0.05f + unit(*rng) * 0.3f;
+    det.keypoints = keypoints->data() + (size_t)i * kNumKeypoints * 3;
+    det.num_keypoints = kNumKeypoints;
+  }
+  return detections;
+}
+
+void bench_preprocess(const BenchOptions &options,
+                      std::vector<BenchResult> *results) {
+  static const int kSources[][2] = {
+      {640, 480}, {1280, 720}, {1920, 1080}, {4032, 3024}};
+  std::vector<float> buffer((size_t)3 * kInputSize * kInputSize);
+  for (const auto &source : kSources) {
+    int w = source[0];
+    int h = source[1];
+    std::string name = "preprocess/" + std::to_string(w) + "x" +
+                       std::to_string(h);
+    if (!options.filter.empty() &&
+        name.find(options.filter) == std::string::npos) {
+      continue;
+    }
+    std::mt19937 rng = seeded_rng(name.c_str());
+    std::vector<uint8_t> image = make_image(w, h, &rng);
+    run_case(
+        options, results, name, (int64_t)w * h, [] {},
+        [&] {
+          float sx, sy;
+          int pl, pt;
+          preprocess_image_to_buffer(image.data(), w, h, kInputSize,
+                                     kInputSize, buffer.data(), &sx, &sy, &pl,
+                                     &pt);
+          g_sink += (uint64_t)buffer[buffer.size() / 2];
+        });
+  }
+}
+
+void bench_parse(const BenchOptions &options,
+                 std::vector<BenchResult> *results) {
+  std::mt19937 rng = seeded_rng("parse");
+  struct Case {
+    const char *name;
+    int model_type;
+    int num_objects;
+  };
+  static const Case kCases[] = {
+      {"parse/detect_80cls_8400", MODEL_TYPE_YOLO, 60},
+      {"parse/pose_17kpt_8400", MODEL_TYPE_YOLO_POSE, 20},
+  };
+  DetectionScratch scratch;
+  for (const Case &c : kCases) {
+    int num_features = c.model_type == MODEL_TYPE_YOLO_POSE
+                           ? 5 + kNumKeypoints * 3
+                           : 4 + kNumClasses;
+    std::vector<float> output = make_yolo_output(c.model_type, c.num_objects,
+                                                 &rng);
+    run_case(
+        options, results, c.name, kNumBoxes, [] {},
+        [&] {
+          parse_yolov8_output(output.data(), num_features, kNumBoxes,
+                              c.model_type, kNumKeypoints, kConfThreshold,
+                              1.0f, 1.0f, 0, 0, kInputSize, kInputSize,
+                              &scratch);
+          g_sink += scratch.candidates.size();
+        });
+  }
+}
+
+void bench_nms(const BenchOptions &options,
+               std::vector<BenchResult> *results) {
+  std::mt19937 rng = seeded_rng("nms");
+  // 以解析结果作为 NMS 输入，保持真实的簇状重叠分布。
+  struct Case {
+    const char *name;
+    int num_objects;
+    float conf;
+  };
+  static const Case kCases[] = {
+      {"nms/inplace_60obj", 60, kConfThreshold},
+      {"nms/inplace_300obj_low_conf", 300, 0.01f},
+  };
+  DetectionScratch scratch;
+  std::vector<Detection> working;
+  for (const Case &c : kCases) {
+    std::vector<float> output = make_yolo_output(MODEL_TYPE_YOLO,
+                                                 c.num_objects, &rng);
+    parse_yolov8_output(output.data(), 4 + kNumClasses, kNumBoxes,
+                        MODEL_TYPE_YOLO, 0, c.conf, 1.0f, 1.0f, 0, 0,
+                        kInputSize, kInputSize, &scratch);
+    std::vector<Detection> input = scratch.candidates;
+    run_case(
+        options, results, c.name, (int64_t)input.size(),
+        [&] { working.assign(input.begin(), input.end()); },
+        [&] {
+          g_sink += onnx_nms_inplace(working.data(), working.size(),
+                                     kNmsThreshold);
+        });
+    if (c.conf == kConfThreshold) {
+      run_case(
+          options, results, "nms/vector_60obj", (int64_t)input.size(),
+          [] {},
+          [&] { g_sink += onnx_nms(input, kNmsThreshold).size(); });
+    }
+  }
+
+  // IoU：固定 4096 对框，衡量单次计算的吞吐。
+  constexpr int kPairs = 4096;
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::vector<Detection> boxes(kPairs * 2);
+  for (Detection &det : boxes) {
+    det = Detection{};
+    det.x = unit(rng);
+    det.y = unit(rng);
+    det.width = 0.05f + unit(rng) * 0.3f;
+    det.height = 0.05f + unit(rng) * 0.3f;
+  }
+  run_case(options, results, "iou/pairs", kPairs, [] {}, [&] {
+    float sum = 0;
+    for (int i = 0; i < kPairs; i++) {
+      sum += onnx_iou(boxes[2 * i], boxes[2 * i + 1]);
+    }
+    g_sink += (uint64_t)sum;
+  });
+}
+
+void bench_results(const BenchOptions &options,
+                   std::vector<BenchResult> *results) {
+  std::mt19937 rng = seeded_rng("results");
+  constexpr int kCount = 100;
+  std::vector<float> keypoints;
+  std::vector<Detection> detections =
+      make_pose_detections(kCount, &keypoints, &rng);
+
+  // 逐次堆分配的拷贝 + 释放（onnx_detect / onnx_free_result 路径）。
+  run_case(options, results, "result/copy_release_pose_100", kCount, [] {},
+           [&] {
+             DetectionResult result{};
+             if (onnx_copy_detections(detections.data(), kCount, &result)) {
+               g_sink += (uint64_t)result.count;
+             }
+             onnx_release_detections(&result);
+           });
+
+  // 写入调用方复用缓冲区（onnx_detect_into 路径）。
+  std::vector<Detection> out_detections(kCount);
+  std::vector<uint8_t> arena((size_t)kCount * kNumKeypoints * 3 *
+                                 sizeof(float) +
+                             4096);
+  run_case(options, results, "result/pack_pose_100", kCount, [] {}, [&] {
+    OnnxResultBuffer out{};
+    out.detections = out_detections.data();
+    out.capacity = kCount;
+    out.arena = arena.data();
+    out.arena_capacity = (int64_t)arena.size();
+    g_sink += (uint64_t)onnx_pack_result(detections.data(), kCount, &out);
+    g_sink += (uint64_t)out.count;
+  });
+}
+
+std::string compiler_name() {
+#if defined(__clang__)
+  return std::string("clang ") + __clang_version__;
+#elif defined(__GNUC__)
+  return std::string("gcc ") + __VERSION__;
+#elif defined(_MSC_VER)
+  return "msvc " + std::to_string(_MSC_VER);
+#else
+  return "unknown";
+#endif
+}
+
+std::string json_escape(const std::string &text) {
+  std::string out;
+  for (char ch : text) {
+    if (ch == '"' || ch == '\\') {
+      out += '\\';
+    }
+    out += ch;
+  }
+  return out;
+}
+
+bool write_json(const BenchOptions &options,
+                const std::vector<BenchResult> &results) {
+  FILE *file = options.out_path.empty() ? stdout
+                                        : fopen(options.out_path.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "无法写入 %s\n", options.out_path.c_str());
+    return false;
+  }
+  fprintf(file, "{\n  \"suite\": \"onnx_inference_bench\",\n");
+  fprintf(file, "  \"schema\": 1,\n");
+  fprintf(file, "  \"compiler\": \"%s\",\n",
+          json_escape(compiler_name()).c_str());
+  fprintf(file, "  \"min_time_ms\": %.1f,\n", options.min_time_ms);
+  fprintf(file, "  \"results\": [");
+  for (size_t i = 0; i < results.size(); i++) {
+    const BenchResult &r = results[i];
+    fprintf(file,
+            "%s\n    {\"name\": \"%s\", \"iterations\": %lld, "
+            "\"items\": %lld, \"min_ns\": %.0f, \"median_ns\": %.0f, "
+            "\"p95_ns\": %.0f, \"mean_ns\": %.0f}",
+            i == 0 ? "" : ",", json_escape(r.name).c_str(),
+            (long long)r.iterations, (long long)r.items, r.min_ns,
+            r.median_ns, r.p95_ns, r.mean_ns);
+  }
+  fprintf(file, "\n  ]\n}\n");
+  if (file != stdout) {
+    fclose(file);
+  }
+  return true;
+}
+
+bool parse_args(int argc, char **argv, BenchOptions *options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    if (arg == "--filter" && has_value) {
+      options->filter = argv[++i];
+    } else if (arg == "--min-time-ms" && has_value) {
+      options->min_time_ms = atof(argv[++i]);
+    } else if (arg == "--out" && has_value) {
+      options->out_path = argv[++i];
+    } else {
+      fprintf(stderr,
+              "用法: %s [--filter 子串] [--min-time-ms N] [--out 文件]\n",
+              argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  BenchOptions options;
+  if (!parse_args(argc, argv, &options)) {
+    return 2;
+  }
+
+  std::vector<BenchResult> results;
+  bench_preprocess(options, &results);
+  bench_parse(options, &results);
+  bench_nms(options, &results);
+  bench_results(options, &results);
+
+  return write_json(options, results) ? 0 : 1;
+}
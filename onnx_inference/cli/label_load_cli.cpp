@@ -0,0 +1,1167 @@
+/**
+ * LabelLoad 无界面批量自动标注
+ *
+ * 在无法启动 Flutter 的服务器上对图片目录批量推理，按应用相同的格式与
+ * 追加/覆盖语义写出 YOLO 标签文件。多线程解码 → 批量推理 → 写出三级流水线，
+ * 队列有界，内存占用与图片数量无关。
+ *
+ * 用法: label_load_cli [选项]
+ *   --project KEY       按 id 或名称读取应用中的项目配置
+ *   --projects PATH     projects.json 路径（默认应用文档目录下的
+ *                       LabelLoad/projects.json）
+ *   --model PATH        模型路径（覆盖项目配置，下同）
+ *   --images DIR        图片目录
+ *   --labels DIR        标签目录
+ *   --type T            模型类型: yolo | pose | seg | obb
+ *   --conf X            置信度阈值
+ *   --nms X             NMS IoU 阈值
+ *   --keypoints N       姿态模型关键点数量
+ *   --mode M            append | overwrite
+ *   --offset N          类别 ID 偏置（仅追加模式生效）
+ *   --batch N           批量大小（默认 CPU 4，GPU 32，同应用）
+ *   --decoders N        解码线程数（默认 CPU 核数的一半）
+ *   --threads N         ORT 共享算子内线程数（0 为物理核数；缺省为每会话 4）
+ *   --gpu               请求 GPU 执行提供程序
+ *   --resume            跳过上次运行已写出的图片
+ *   --shard I/N         分片模式：只处理第 I 个分片（共 N 个，I 从 0 开始）
+ *   --lease             分片模式：动态认领任意未完成的分块
+ *   --chunk N           分块大小（默认 64，同一任务的各 worker 必须一致）
+ *   --lease-timeout S   租约无心跳多少秒后可被接管（默认 120）
+ *   --worker ID         worker 标识（默认主机名-进程号）
+ *   --merge             核对各 worker 的完成记录是否覆盖全部图片
+ *   --video PATH        视频模式：对视频文件或目录中的视频抽帧，帧图片写入
+ *                       --images 目录，同时写出标签
+ *   --fps X             按时间均匀抽帧，每秒 X 帧
+ *   --stride N          每 N 帧取一帧（默认 1，--fps 优先）
+ *   --frame-format F    帧图片格式: jpg | bmp（默认 jpg，无 stb_image_write
+ *                       时为 bmp）
+ *   --dedup N           近重复跳过：与上一张推理的图片感知哈希距离不超过 N
+ *                       （0-64）时复用其检测结果，不运行模型
+ *   --cascade PATH      级联模式：--model 为快速模型，先推理全部图片，检测落在
+ *                       不确定区间或无检测的图片改由 PATH 的重模型推理
+ *   --uncertain LO,HI   级联的不确定置信度区间 [LO, HI)（默认 0.1,0.5）
+ *   --escalate-min N    不确定检测达到 N 个时升级（默认 1）
+ *   --no-escalate-empty 快速模型无检测时不升级
+ *   --track K           跟踪模式：按顺序逐帧处理，每 K 帧（或轨迹置信度下降
+ *                       时）运行一次模型，其余帧由多目标跟踪外推
+ *
+ * 已完成的图片记录在标签目录下的 .label_load_cli_done 中，每写出一个标签
+ * 文件追加一行；不带 --resume 时该记录在开始时清空。
+ *
+ * 分片模式下多台机器可对同一共享目录并发运行，通过 .label_load_shards 中的
+ * 租约文件认领互不重叠的分块（见 label_load_cli_utils.h），中断后重新运行
+ * 即续跑；全部完成后用 --merge 核对覆盖并生成 .label_load_cli_done。
+ *
+ * 视频模式下单个线程解码视频（FFmpeg 内部多线程）并抽帧转为 RGBA，解码线程
+ * 池改为编码并写出帧图片，帧直接进入批量推理，不经过中间文件重新解码。
+ *
+ * 跟踪模式下推理线程按帧序号重排后逐帧处理，每个视频（普通模式下为整个
+ * 图片目录，按文件名顺序）是一个序列，续跑跳过的帧之后重新开始跟踪。
+ */
+#include "label_load_cli_utils.h"
+#include "label_load_video.h"
+#include "onnx_inference.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+using namespace label_load_cli;
+
+namespace {
+
+const char *const kJournalName = ".label_load_cli_done";
+
+struct CliOptions {
+  std::string project;
+  std::string projects_path;
+  ProjectSettings settings;
+  // 命令行覆盖项（空/负值表示沿用项目配置）
+  std::string model_path;
+  std::string image_dir;
+  std::string label_dir;
+  int model_type = -1;
+  double conf_threshold = -1;
+  double nms_threshold = -1;
+  int num_keypoints = -1;
+  int save_mode = -1;
+  bool has_offset = false;
+  int class_id_offset = 0;
+  int batch_size = 0;
+  int decoders = 0;
+  int threads = -1;
+  bool use_gpu = false;
+  bool resume = false;
+  // 分片
+  int shard_index = 0;
+  int shard_count = 0;
+  bool lease = false;
+  int chunk_size = 64;
+  double lease_timeout = 120;
+  std::string worker;
+  bool merge = false;
+  // 视频
+  std::string video;
+  double fps = 0;
+  int stride = 1;
+  std::string frame_format;
+  // 近重复跳过的汉明距离（负数表示关闭）
+  int dedup = -1;
+  // 跟踪模式的关键帧间隔（0 表示关闭）
+  int track = 0;
+  // 级联（重模型路径为空表示关闭；区间为负表示沿用默认）
+  std::string cascade_model;
+  double uncertain_low = -1;
+  double uncertain_high = -1;
+  int escalate_min = 0;
+  bool escalate_empty = true;
+
+  bool sharded() const { return shard_count > 0 || lease; }
+};
+
+/// 有界阻塞队列；close 后 pop 取完剩余元素即返回 false。
+template <typename T> class BoundedQueue {
+public:
+  explicit BoundedQueue(size_t capacity) : capacity_(capacity) {}
+
+  void push(T item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_full_.wait(lock, [this] { return items_.size() < capacity_; });
+    items_.push_back(std::move(item));
+    not_empty_.notify_one();
+  }
+
+  bool pop(T *item) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !items_.empty() || closed_; });
+    if (items_.empty()) {
+      return false;
+    }
+    *item = std::move(items_.front());
+    items_.pop_front();
+    not_full_.notify_one();
+    return true;
+  }
+
+  void close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    not_empty_.notify_all();
+  }
+
+private:
+  size_t capacity_;
+  std::deque<T> items_;
+  bool closed_ = false;
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+};
+
+struct DecodedImage {
+  size_t index = 0;
+  bool ok = false;
+  bool new_sequence = false; // 跟踪序列的首帧（跟踪器在此重置）
+  std::string path; // 图片路径；视频模式为写出的帧路径
+  RgbaImage image;
+};
+
+struct WriteJob {
+  size_t index = 0;
+  std::string path;
+  bool ok = true; // 解码或推理失败的图片同样经过写出线程，以便分块计数
+  std::vector<YoloLabel> labels;
+};
+
+double now_seconds() {
+  return std::chrono::duration<double>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+/// 待处理图片来源
+///
+/// 普通模式按顺序分发；分片模式在取完当前分块后认领下一块，暂无可认领的
+/// 分块时等待其他 worker 完成或租约过期。
+class ImageSource {
+public:
+  ImageSource(const std::vector<std::string> &images, ShardWorker *shard,
+              int chunk_size, double poll_seconds)
+      : images_(images), shard_(shard), chunk_size_(chunk_size),
+        poll_seconds_(poll_seconds) {
+    if (!shard_) {
+      for (size_t i = 0; i < images_.size(); i++) {
+        queue_.push_back(i);
+      }
+    }
+  }
+
+  bool next(size_t *index) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pos_ == queue_.size()) {
+      if (!shard_) {
+        return false;
+      }
+      int chunk = shard_->claim_next(now_seconds());
+      if (chunk < 0) {
+        if (shard_->exhausted()) {
+          return false;
+        }
+        lock.unlock();
+        std::this_thread::sleep_for(std::chrono::duration<double>(poll_seconds_));
+        lock.lock();
+        continue;
+      }
+      size_t begin = (size_t)chunk * chunk_size_;
+      size_t end = std::min(images_.size(), begin + chunk_size_);
+      std::vector<std::string> names;
+      for (size_t i = begin; i < end; i++) {
+        names.push_back(fs::path(images_[i]).filename().string());
+      }
+      queue_.clear();
+      pos_ = 0;
+      for (int offset : shard_->start_chunk(chunk, names)) {
+        queue_.push_back(begin + offset);
+      }
+    }
+    *index = queue_[pos_++];
+    return true;
+  }
+
+  int chunk_of(size_t index) const { return (int)(index / chunk_size_); }
+
+private:
+  const std::vector<std::string> &images_;
+  ShardWorker *shard_;
+  size_t chunk_size_;
+  double poll_seconds_;
+  std::mutex mutex_;
+  std::vector<size_t> queue_;
+  size_t pos_ = 0;
+};
+
+struct Counters {
+  std::atomic<int64_t> written{0};
+  std::atomic<int64_t> decode_failed{0};
+  std::atomic<int64_t> infer_failed{0};
+  std::atomic<int64_t> write_failed{0};
+  std::atomic<int64_t> lease_lost{0};
+  std::atomic<int64_t> frames{0}; // 视频模式抽取的帧数
+  std::atomic<int64_t> frame_failed{0};
+  std::atomic<int64_t> decode_ns{0}; // 各解码线程累计
+  std::atomic<int64_t> infer_ns{0};
+  std::atomic<int64_t> write_ns{0};
+};
+
+int64_t elapsed_ns(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+bool parse_model_type(const std::string &name, int *out) {
+  static const char *const kNames[] = {"yolo", "pose", "seg", "obb"};
+  for (int i = 0; i < 4; i++) {
+    if (name == kNames[i]) {
+      *out = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+void print_usage(const char *program) {
+  fprintf(stderr,
+          "用法: %s [--project KEY] [--projects PATH] [--model PATH] "
+          "[--images DIR] [--labels DIR] [--type yolo|pose|seg|obb] "
+          "[--conf X] [--nms X] [--keypoints N] [--mode append|overwrite] "
+          "[--offset N] [--batch N] [--decoders N] [--threads N] [--gpu] "
+          "[--resume] [--shard I/N | --lease] [--chunk N] "
+          "[--lease-timeout S] [--worker ID] [--merge] [--video PATH] "
+          "[--fps X] [--stride N] [--frame-format jpg|bmp] [--dedup N] "
+          "[--cascade PATH] [--uncertain LO,HI] [--escalate-min N] "
+          "[--no-escalate-empty] [--track K]\n",
+          program);
+}
+
+bool parse_args(int argc, char **argv, CliOptions *options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    bool ok = true;
+    if (arg == "--project" && has_value) {
+      options->project = argv[++i];
+    } else if (arg == "--projects" && has_value) {
+      options->projects_path = argv[++i];
+    } else if (arg == "--model" && has_value) {
+      options->model_path = argv[++i];
+    } else if (arg == "--images" && has_value) {
+      options->image_dir = argv[++i];
+    } else if (arg == "--labels" && has_value) {
+      options->label_dir = argv[++i];
+    } else if (arg == "--type" && has_value) {
+      ok = parse_model_type(argv[++i], &options->model_type);
+    } else if (arg == "--conf" && has_value) {
+      options->conf_threshold = atof(argv[++i]);
+      ok = options->conf_threshold >= 0 && options->conf_threshold <= 1;
+    } else if (arg == "--nms" && has_value) {
+      options->nms_threshold = atof(argv[++i]);
+      ok = options->nms_threshold >= 0 && options->nms_threshold <= 1;
+    } else if (arg == "--keypoints" && has_value) {
+      options->num_keypoints = atoi(argv[++i]);
+      ok = options->num_keypoints >= 0;
+    } else if (arg == "--mode" && has_value) {
+      std::string mode = argv[++i];
+      options->save_mode = mode == "append"      ? kSaveAppend
+                           : mode == "overwrite" ? kSaveOverwrite
+                                                 : -1;
+      ok = options->save_mode >= 0;
+    } else if (arg == "--offset" && has_value) {
+      options->has_offset = true;
+      options->class_id_offset = atoi(argv[++i]);
+    } else if (arg == "--batch" && has_value) {
+      options->batch_size = atoi(argv[++i]);
+      ok = options->batch_size > 0;
+    } else if (arg == "--decoders" && has_value) {
+      options->decoders = atoi(argv[++i]);
+      ok = options->decoders > 0;
+    } else if (arg == "--threads" && has_value) {
+      options->threads = atoi(argv[++i]);
+      ok = options->threads >= 0;
+    } else if (arg == "--gpu") {
+      options->use_gpu = true;
+    } else if (arg == "--resume") {
+      options->resume = true;
+    } else if (arg == "--shard" && has_value) {
+      ok = parse_shard_spec(argv[++i], &options->shard_index,
+                            &options->shard_count);
+    } else if (arg == "--lease") {
+      options->lease = true;
+    } else if (arg == "--chunk" && has_value) {
+      options->chunk_size = atoi(argv[++i]);
+      ok = options->chunk_size > 0;
+    } else if (arg == "--lease-timeout" && has_value) {
+      options->lease_timeout = atof(argv[++i]);
+      ok = options->lease_timeout > 0;
+    } else if (arg == "--worker" && has_value) {
+      options->worker = argv[++i];
+      ok = !options->worker.empty();
+    } else if (arg == "--merge") {
+      options->merge = true;
+    } else if (arg == "--video" && has_value) {
+      options->video = argv[++i];
+    } else if (arg == "--fps" && has_value) {
+      options->fps = atof(argv[++i]);
+      ok = options->fps > 0;
+    } else if (arg == "--stride" && has_value) {
+      options->stride = atoi(argv[++i]);
+      ok = options->stride > 0;
+    } else if (arg == "--frame-format" && has_value) {
+      options->frame_format = argv[++i];
+      const auto &formats = frame_formats();
+      ok = std::find(formats.begin(), formats.end(), options->frame_format) !=
+           formats.end();
+    } else if (arg == "--dedup" && has_value) {
+      options->dedup = atoi(argv[++i]);
+      ok = options->dedup >= 0 && options->dedup <= 64;
+    } else if (arg == "--cascade" && has_value) {
+      options->cascade_model = argv[++i];
+    } else if (arg == "--uncertain" && has_value) {
+      ok = sscanf(argv[++i], "%lf,%lf", &options->uncertain_low,
+                  &options->uncertain_high) == 2 &&
+           options->uncertain_low >= 0 &&
+           options->uncertain_low <= options->uncertain_high &&
+           options->uncertain_high <= 1;
+    } else if (arg == "--escalate-min" && has_value) {
+      options->escalate_min = atoi(argv[++i]);
+      ok = options->escalate_min > 0;
+    } else if (arg == "--no-escalate-empty") {
+      options->escalate_empty = false;
+    } else if (arg == "--track" && has_value) {
+      options->track = atoi(argv[++i]);
+      ok = options->track > 0;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  if (options->shard_count > 0 && options->lease) {
+    fprintf(stderr, "--shard 与 --lease 不能同时使用\n");
+    return false;
+  }
+  if (!options->video.empty() && (options->sharded() || options->merge)) {
+    fprintf(stderr, "--video 不能与分片选项同时使用\n");
+    return false;
+  }
+  if (options->cascade_model.empty() &&
+      (options->uncertain_low >= 0 || options->escalate_min > 0 ||
+       !options->escalate_empty)) {
+    fprintf(stderr, "级联选项需要同时指定 --cascade\n");
+    return false;
+  }
+  if (options->track > 0 && options->sharded()) {
+    fprintf(stderr, "--track 不能与分片选项同时使用\n");
+    return false;
+  }
+  if (options->frame_format.empty()) {
+    options->frame_format = frame_formats().front();
+  }
+  return true;
+}
+
+// 合并项目配置与命令行覆盖项。
+bool resolve_settings(CliOptions *options) {
+  ProjectSettings &settings = options->settings;
+  if (!options->project.empty()) {
+    std::string path = options->projects_path.empty()
+                           ? default_projects_path()
+                           : options->projects_path;
+    std::string error;
+    if (!load_project(path, options->project, &settings, &error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return false;
+    }
+  }
+  if (!options->model_path.empty()) {
+    settings.model_path = options->model_path;
+  }
+  if (!options->image_dir.empty()) {
+    settings.image_dir = options->image_dir;
+  }
+  if (!options->label_dir.empty()) {
+    settings.label_dir = options->label_dir;
+  }
+  if (options->model_type >= 0) {
+    settings.model_type = options->model_type;
+  }
+  if (options->conf_threshold >= 0) {
+    settings.conf_threshold = options->conf_threshold;
+  }
+  if (options->nms_threshold >= 0) {
+    settings.nms_threshold = options->nms_threshold;
+  }
+  if (options->num_keypoints >= 0) {
+    settings.num_keypoints = options->num_keypoints;
+  }
+  if (options->save_mode >= 0) {
+    settings.save_mode = options->save_mode;
+  }
+  if (options->has_offset) {
+    settings.class_id_offset = options->class_id_offset;
+  }
+
+  // 核对覆盖不需要模型。
+  const char *missing = settings.model_path.empty() && !options->merge
+                            ? "--model"
+                        : settings.image_dir.empty() ? "--images"
+                        : settings.label_dir.empty() ? "--labels"
+                                                     : nullptr;
+  if (missing) {
+    fprintf(stderr, "缺少 %s（或通过 --project 读取项目配置）\n", missing);
+    return false;
+  }
+  return true;
+}
+
+// 推理所用的模型：加载了重模型时按级联规则升级不确定的图片。
+struct Models {
+  ModelHandle fast = nullptr;
+  ModelHandle heavy = nullptr;
+  OnnxCascadeOptions cascade{};
+};
+
+BatchDetectionResult *detect_batch(const Models &models,
+                                   const ProjectSettings &settings,
+                                   const uint8_t **pixels, int count,
+                                   int *widths, int *heights) {
+  if (models.heavy) {
+    return onnx_detect_batch_cascade(
+        models.fast, models.heavy, pixels, count, widths, heights,
+        (float)settings.conf_threshold, (float)settings.nms_threshold,
+        settings.model_type, settings.num_keypoints, &models.cascade);
+  }
+  return onnx_detect_batch(models.fast, pixels, count, widths, heights,
+                           (float)settings.conf_threshold,
+                           (float)settings.nms_threshold, settings.model_type,
+                           settings.num_keypoints);
+}
+
+// 批量推理并把结果转为标签；失败返回 false（整批计为失败）。
+bool infer_batch(const Models &models, const ProjectSettings &settings,
+                 std::vector<DecodedImage> &batch,
+                 BoundedQueue<WriteJob> *write_queue) {
+  std::vector<const uint8_t *> pixels;
+  std::vector<int> widths, heights;
+  for (const auto &item : batch) {
+    pixels.push_back(item.image.rgba.data());
+    widths.push_back(item.image.width);
+    heights.push_back(item.image.height);
+  }
+  BatchDetectionResult *result =
+      detect_batch(models, settings, pixels.data(), (int)batch.size(),
+                   widths.data(), heights.data());
+  if (!result) {
+    return false;
+  }
+  for (int i = 0; i < result->num_images && i < (int)batch.size(); i++) {
+    WriteJob job;
+    job.index = batch[i].index;
+    job.path = std::move(batch[i].path);
+    const DetectionResult &dets = result->results[i];
+    job.labels.reserve(dets.count);
+    for (int k = 0; k < dets.count; k++) {
+      job.labels.push_back(label_from_detection(dets.detections[k]));
+    }
+    write_queue->push(std::move(job));
+  }
+  onnx_free_batch_result(result);
+  return true;
+}
+
+// 跟踪模式下处理一帧：需要时运行检测器并更新轨迹，标签取自跟踪器输出。
+// 失败返回 false（该帧不写标签）。
+bool track_frame(const Models &models, TrackerHandle tracker,
+                 const ProjectSettings &settings, DecodedImage &item,
+                 BoundedQueue<WriteJob> *write_queue) {
+  WriteJob job;
+  job.index = item.index;
+  job.path = std::move(item.path);
+  bool ok = true;
+  if (onnx_tracker_advance(tracker) == 1) {
+    const uint8_t *pixels = item.image.rgba.data();
+    BatchDetectionResult *result =
+        detect_batch(models, settings, &pixels, 1, &item.image.width,
+                     &item.image.height);
+    ok = result && result->num_images == 1 &&
+         onnx_tracker_update(tracker, result->results[0].detections,
+                             result->results[0].count) == ONNX_OK;
+    onnx_free_batch_result(result);
+  }
+  DetectionResult *dets = ok ? onnx_tracker_current(tracker) : nullptr;
+  if (!dets) {
+    job.ok = false;
+  } else {
+    job.labels.reserve(dets->count);
+    for (int k = 0; k < dets->count; k++) {
+      job.labels.push_back(label_from_detection(dets->detections[k]));
+    }
+    onnx_free_result(dets);
+  }
+  bool written = job.ok;
+  write_queue->push(std::move(job));
+  return written;
+}
+
+// 核对分片覆盖；完整时写出 .label_load_cli_done，之后可用 --resume 续跑。
+int run_merge(const ProjectSettings &settings,
+              const std::vector<std::string> &images) {
+  std::string dir = shard_dir(settings.label_dir);
+  ShardPlan plan;
+  if (!read_shard_plan(dir, &plan)) {
+    fprintf(stderr, "没有分片计划: %s\n", dir.c_str());
+    return 1;
+  }
+  ShardPlan current = make_shard_plan(images, plan.chunk_size);
+  if (current.image_count != plan.image_count ||
+      current.list_hash != plan.list_hash) {
+    fprintf(stderr, "图片目录与分片计划不一致（计划 %lld 张，当前 %lld 张）\n",
+            (long long)plan.image_count, (long long)current.image_count);
+    return 1;
+  }
+  for (const auto &progress : read_shard_progress(dir)) {
+    fprintf(stderr, "worker %s: 完成 %d 个分块，写出 %lld 张\n",
+            progress.worker.c_str(), progress.chunks_done,
+            (long long)progress.images_written);
+  }
+  ShardCoverage coverage = verify_shard_coverage(dir, images, plan);
+  fprintf(stderr, "分块 %d/%d 完成，已写出 %zu 张，缺少 %zu 张\n",
+          coverage.chunks_done, coverage.chunks_total, coverage.written.size(),
+          coverage.missing.size());
+  for (size_t i = 0; i < coverage.missing.size() && i < 20; i++) {
+    fprintf(stderr, "  缺少 %s\n", coverage.missing[i].c_str());
+  }
+  if (!coverage.missing.empty()) {
+    return 1;
+  }
+  std::string journal;
+  for (const auto &name : coverage.written) {
+    journal += name + "\n";
+  }
+  std::string journal_path =
+      (fs::path(settings.label_dir) / kJournalName).string();
+  if (!write_file_atomic(journal_path, journal)) {
+    fprintf(stderr, "无法写入续跑记录: %s\n", journal_path.c_str());
+    return 1;
+  }
+  return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  CliOptions options;
+  if (!parse_args(argc, argv, &options)) {
+    return 2;
+  }
+  if (!resolve_settings(&options)) {
+    return 2;
+  }
+  ProjectSettings &settings = options.settings;
+
+  std::error_code fs_error;
+  bool video_mode = !options.video.empty();
+  std::vector<std::string> images;
+  std::vector<std::string> videos;
+  if (video_mode) {
+    if (!VideoReader::available()) {
+      fprintf(stderr, "当前构建不支持视频解码（配置时需要 FFmpeg 开发库）\n");
+      return 2;
+    }
+    videos = list_videos(options.video);
+    if (videos.empty()) {
+      fprintf(stderr, "没有视频: %s\n", options.video.c_str());
+      return 2;
+    }
+    fs::create_directories(settings.image_dir, fs_error);
+  } else {
+    int unsupported = 0;
+    images = list_images(settings.image_dir, &unsupported);
+    if (unsupported > 0) {
+      fprintf(stderr, "跳过 %d 张当前构建无法解码的图片（支持:", unsupported);
+      for (const auto &ext : decodable_extensions()) {
+        fprintf(stderr, " %s", ext.c_str());
+      }
+      fprintf(stderr, "）\n");
+    }
+  }
+
+  fs::create_directories(settings.label_dir, fs_error);
+  if (options.merge) {
+    return run_merge(settings, images);
+  }
+
+  // 分片模式由分块完成记录续跑；多个进程不能共用同一续跑记录。
+  std::unique_ptr<ShardWorker> shard;
+  std::vector<std::string> pending;
+  size_t resumed = 0;
+  FILE *journal = nullptr;
+  std::set<std::string> done;
+  if (options.sharded()) {
+    std::string dir = shard_dir(settings.label_dir);
+    ShardPlan plan = make_shard_plan(images, options.chunk_size);
+    std::string error;
+    if (!open_shard_plan(dir, plan, &error)) {
+      fprintf(stderr, "%s\n", error.c_str());
+      return 1;
+    }
+    std::string worker =
+        options.worker.empty() ? default_worker_id() : options.worker;
+    shard = std::make_unique<ShardWorker>(
+        dir, worker, plan.chunk_count(), options.shard_index,
+        options.shard_count, options.lease_timeout);
+    if (shard->exhausted()) {
+      fprintf(stderr, "负责的分块均已完成（共 %d 块）\n", plan.chunk_count());
+      return 0;
+    }
+    pending = images;
+    fprintf(stderr, "worker %s，分块大小 %d，共 %d 块\n", worker.c_str(),
+            plan.chunk_size, plan.chunk_count());
+  } else {
+    std::string journal_path =
+        (fs::path(settings.label_dir) / kJournalName).string();
+    if (options.resume) {
+      done = read_journal(journal_path);
+    }
+    for (const auto &path : images) {
+      if (!done.count(fs::path(path).filename().string())) {
+        pending.push_back(path);
+      }
+    }
+    resumed = images.size() - pending.size();
+    journal = fopen(journal_path.c_str(), options.resume ? "a" : "w");
+    if (!journal) {
+      fprintf(stderr, "无法写入续跑记录: %s\n", journal_path.c_str());
+      return 1;
+    }
+    if (pending.empty() && !video_mode) {
+      fprintf(stderr, "没有待处理的图片（共 %zu 张，已完成 %zu 张）\n",
+              images.size(), resumed);
+      fclose(journal);
+      return 0;
+    }
+  }
+
+  OnnxInitOptions init_options;
+  onnx_default_init_options(&init_options);
+  if (options.threads >= 0) {
+    init_options.use_global_thread_pools = true;
+    init_options.intra_op_threads = options.threads;
+  }
+  if (!onnx_init_with_options(&init_options)) {
+    fprintf(stderr, "初始化失败: %s\n", onnx_get_last_error());
+    if (journal) {
+      fclose(journal);
+    }
+    return 1;
+  }
+  ModelHandle model =
+      onnx_load_model(settings.model_path.c_str(), options.use_gpu);
+  if (!model) {
+    fprintf(stderr, "模型加载失败: %s\n", onnx_get_last_error());
+    onnx_cleanup();
+    if (journal) {
+      fclose(journal);
+    }
+    return 1;
+  }
+  if (options.dedup >= 0 && onnx_set_dedup(model, options.dedup) != ONNX_OK) {
+    fprintf(stderr, "近重复跳过设置失败: %s\n", onnx_get_last_error());
+  }
+  Models models;
+  models.fast = model;
+  onnx_default_cascade_options(&models.cascade);
+  if (!options.cascade_model.empty()) {
+    models.heavy =
+        onnx_load_model(options.cascade_model.c_str(), options.use_gpu);
+    if (!models.heavy) {
+      fprintf(stderr, "重模型加载失败: %s\n", onnx_get_last_error());
+      onnx_unload_model(model);
+      onnx_cleanup();
+      if (journal) {
+        fclose(journal);
+      }
+      return 1;
+    }
+    if (options.dedup >= 0) {
+      onnx_set_dedup(models.heavy, options.dedup);
+    }
+    if (options.uncertain_low >= 0) {
+      models.cascade.uncertain_low = (float)options.uncertain_low;
+      models.cascade.uncertain_high = (float)options.uncertain_high;
+    }
+    if (options.escalate_min > 0) {
+      models.cascade.min_uncertain = options.escalate_min;
+    }
+    models.cascade.escalate_empty = options.escalate_empty;
+  }
+  TrackerHandle tracker = nullptr;
+  if (options.track > 0) {
+    OnnxTrackerOptions tracker_options;
+    onnx_tracker_default_options(&tracker_options);
+    tracker_options.keyframe_interval = options.track;
+    tracker = onnx_tracker_create(&tracker_options);
+    if (!tracker) {
+      fprintf(stderr, "跟踪器创建失败，改为逐帧推理: %s\n",
+              onnx_get_last_error());
+    }
+  }
+
+  int batch_size = options.batch_size;
+  if (batch_size <= 0) {
+    batch_size = options.use_gpu && onnx_is_gpu_available() ? 32 : 4;
+  }
+  models.cascade.heavy_batch_size = batch_size;
+  int decoders = options.decoders;
+  if (decoders <= 0) {
+    decoders = std::max(1, (int)std::thread::hardware_concurrency() / 2);
+  }
+
+  if (video_mode) {
+    char sampling[64];
+    if (options.fps > 0) {
+      snprintf(sampling, sizeof(sampling), "每秒 %g 帧", options.fps);
+    } else {
+      snprintf(sampling, sizeof(sampling), "每 %d 帧取一帧", options.stride);
+    }
+    fprintf(stderr, "视频 %zu 个，%s，帧格式 %s，批量 %d，编码线程 %d，%s\n",
+            videos.size(), sampling, options.frame_format.c_str(), batch_size,
+            decoders,
+            settings.save_mode == kSaveAppend ? "追加" : "覆盖");
+  } else if (shard) {
+    fprintf(stderr, "批量 %d，解码线程 %d，%s\n", batch_size, decoders,
+            settings.save_mode == kSaveAppend ? "追加" : "覆盖");
+  } else {
+    fprintf(stderr,
+            "待处理 %zu 张（跳过已完成 %zu 张），批量 %d，解码线程 %d，%s\n",
+            pending.size(), resumed, batch_size, decoders,
+            settings.save_mode == kSaveAppend ? "追加" : "覆盖");
+  }
+
+  Counters counters;
+  BoundedQueue<DecodedImage> decode_queue((size_t)batch_size * 2);
+  BoundedQueue<WriteJob> write_queue((size_t)batch_size * 2);
+  auto start = std::chrono::steady_clock::now();
+
+  // 分片心跳：定期续租并写出进度，被接管的分块不再写出。
+  double poll_seconds = std::min(options.lease_timeout / 4, 5.0);
+  std::mutex heartbeat_mutex;
+  std::condition_variable heartbeat_cv;
+  bool stopping = false;
+  std::thread heartbeat;
+  if (shard) {
+    heartbeat = std::thread([&] {
+      std::unique_lock<std::mutex> lock(heartbeat_mutex);
+      while (!heartbeat_cv.wait_for(
+          lock, std::chrono::duration<double>(poll_seconds),
+          [&] { return stopping; })) {
+        for (int chunk : shard->heartbeat()) {
+          fprintf(stderr, "分块 %d 的租约已被其他 worker 接管\n", chunk);
+        }
+      }
+    });
+  }
+
+  // 视频：单线程顺序解码并抽帧，跳过的帧不做颜色转换。
+  BoundedQueue<DecodedImage> frame_queue((size_t)batch_size * 2);
+  std::thread video_thread;
+  if (video_mode) {
+    video_thread = std::thread([&] {
+      FrameSampler sampler(options.stride, options.fps);
+      size_t next_index = 0;
+      for (const auto &video : videos) {
+        auto begin = std::chrono::steady_clock::now();
+        std::string error;
+        std::unique_ptr<VideoReader> reader = VideoReader::open(video, &error);
+        if (!reader) {
+          fprintf(stderr, "%s: %s\n", video.c_str(), error.c_str());
+          counters.decode_failed++;
+          continue;
+        }
+        sampler.reset();
+        bool sequence_start = true;
+        int64_t frame_index = 0;
+        double seconds = 0;
+        while (reader->next(&frame_index, &seconds, &error)) {
+          if (!sampler.accept(seconds)) {
+            continue;
+          }
+          std::string name =
+              frame_file_name(video, frame_index, options.frame_format);
+          if (done.count(name)) {
+            resumed++;
+            sequence_start = true;
+            continue;
+          }
+          DecodedImage item;
+          item.index = next_index++;
+          item.new_sequence = sequence_start;
+          sequence_start = false;
+          item.path = (fs::path(settings.image_dir) / name).string();
+          item.ok = reader->convert(&item.image, &error);
+          counters.decode_ns += elapsed_ns(begin);
+          frame_queue.push(std::move(item));
+          begin = std::chrono::steady_clock::now();
+        }
+        if (!error.empty()) {
+          fprintf(stderr, "%s: %s\n", video.c_str(), error.c_str());
+          counters.decode_failed++;
+        }
+        counters.decode_ns += elapsed_ns(begin);
+      }
+      frame_queue.close();
+    });
+  }
+
+  // 解码：各线程从来源取图，完成后由最后一个线程关闭队列。视频模式下改为
+  // 编码并写出帧图片，写出后再进入推理，标签不会先于图片出现。
+  ImageSource source(pending, shard.get(), options.chunk_size, poll_seconds);
+  std::atomic<int> live_decoders{decoders};
+  std::vector<std::thread> decode_threads;
+  for (int t = 0; t < decoders; t++) {
+    decode_threads.emplace_back([&] {
+      DecodedImage item;
+      std::string encoded;
+      while (video_mode && frame_queue.pop(&item)) {
+        auto begin = std::chrono::steady_clock::now();
+        counters.frames++;
+        if (item.ok) {
+          item.ok = encode_frame(item.image, options.frame_format, &encoded) &&
+                    write_file_atomic(item.path, encoded);
+          if (!item.ok) {
+            fprintf(stderr, "帧写出失败: %s\n", item.path.c_str());
+            counters.frame_failed++;
+          }
+        } else {
+          counters.decode_failed++;
+        }
+        counters.write_ns += elapsed_ns(begin);
+        // 失败的帧同样进入推理线程，跟踪模式按连续的帧序号重排。
+        decode_queue.push(std::move(item));
+      }
+      size_t index;
+      while (!video_mode && source.next(&index)) {
+        auto begin = std::chrono::steady_clock::now();
+        DecodedImage item;
+        item.index = index;
+        item.path = pending[index];
+        std::string error;
+        item.ok = decode_image(pending[index], &item.image, &error);
+        if (!item.ok) {
+          fprintf(stderr, "解码失败 %s: %s\n", pending[index].c_str(),
+                  error.c_str());
+        }
+        counters.decode_ns += elapsed_ns(begin);
+        decode_queue.push(std::move(item));
+      }
+      if (live_decoders.fetch_sub(1) == 1) {
+        decode_queue.close();
+      }
+    });
+  }
+
+  // 写出：单线程，标签类型补全与应用一致地按处理顺序累积。
+  std::vector<int> new_classes;
+  std::thread writer([&] {
+    WriteJob job;
+    auto last_report = std::chrono::steady_clock::now();
+    while (write_queue.pop(&job)) {
+      auto begin = std::chrono::steady_clock::now();
+      const fs::path image_path(job.path);
+      int chunk = source.chunk_of(job.index);
+      if (!job.ok) {
+        if (shard) {
+          shard->finish_image(chunk, image_path.filename().string(), false);
+        }
+        continue;
+      }
+      if (shard && !shard->holds(chunk)) {
+        counters.lease_lost++;
+        continue;
+      }
+      std::string label_path =
+          (fs::path(settings.label_dir) / image_path.stem()).string() + ".txt";
+      std::string existing;
+      bool has_existing = read_file(label_path, &existing);
+      size_t known = settings.label_types.size();
+      std::string content = merge_label_file(
+          has_existing ? &existing : nullptr, std::move(job.labels), &settings);
+      for (size_t i = known; i < settings.label_types.size(); i++) {
+        new_classes.push_back(settings.label_types[i].first);
+      }
+      bool written = write_file_atomic(label_path, content);
+      if (written) {
+        if (journal) {
+          fprintf(journal, "%s\n", image_path.filename().string().c_str());
+          fflush(journal);
+        }
+        counters.written++;
+      } else {
+        fprintf(stderr, "写入失败: %s\n", label_path.c_str());
+        counters.write_failed++;
+      }
+      if (shard) {
+        shard->finish_image(chunk, image_path.filename().string(), written);
+      }
+      counters.write_ns += elapsed_ns(begin);
+
+      if (elapsed_ns(last_report) >= 2000000000LL) {
+        last_report = std::chrono::steady_clock::now();
+        double seconds = elapsed_ns(start) / 1e9;
+        if (video_mode) {
+          fprintf(stderr, "进度 %lld 帧，%.1f 帧/秒\n",
+                  (long long)counters.written.load(),
+                  counters.written.load() / seconds);
+        } else if (shard) {
+          fprintf(stderr, "进度 %lld 张（完成 %d 个分块），%.1f 张/秒\n",
+                  (long long)counters.written.load(), shard->chunks_done(),
+                  counters.written.load() / seconds);
+        } else {
+          fprintf(stderr, "进度 %lld/%zu，%.1f 张/秒\n",
+                  (long long)counters.written.load(), pending.size(),
+                  counters.written.load() / seconds);
+        }
+      }
+    }
+  });
+
+  // 推理：当前线程攒批，解码失败的图片不写标签，以便 --resume 重试。
+  // 跟踪模式按帧序号重排后逐帧处理，序列首帧重置跟踪器。
+  std::vector<DecodedImage> batch;
+  std::map<size_t, DecodedImage> reorder;
+  size_t next_frame = 0;
+  DecodedImage item;
+  bool more = true;
+  while (more) {
+    more = decode_queue.pop(&item);
+    if (tracker) {
+      if (more) {
+        size_t index = item.index;
+        reorder.emplace(index, std::move(item));
+      }
+      for (auto it = reorder.begin();
+           it != reorder.end() && it->first == next_frame;
+           it = reorder.erase(it), next_frame++) {
+        DecodedImage &frame = it->second;
+        if (frame.new_sequence) {
+          onnx_tracker_reset(tracker);
+        }
+        if (!frame.ok) {
+          if (!video_mode) {
+            counters.decode_failed++;
+          }
+          WriteJob failed;
+          failed.index = frame.index;
+          failed.path = std::move(frame.path);
+          failed.ok = false;
+          write_queue.push(std::move(failed));
+          continue;
+        }
+        auto begin = std::chrono::steady_clock::now();
+        if (!track_frame(models, tracker, settings, frame, &write_queue)) {
+          fprintf(stderr, "推理失败: %s\n", onnx_get_last_error());
+          counters.infer_failed++;
+        }
+        counters.infer_ns += elapsed_ns(begin);
+      }
+      continue;
+    }
+    if (more) {
+      if (!item.ok) {
+        if (!video_mode) {
+          counters.decode_failed++;
+        }
+        WriteJob failed;
+        failed.index = item.index;
+        failed.path = std::move(item.path);
+        failed.ok = false;
+        write_queue.push(std::move(failed));
+        continue;
+      }
+      batch.push_back(std::move(item));
+      if ((int)batch.size() < batch_size) {
+        continue;
+      }
+    }
+    if (batch.empty()) {
+      continue;
+    }
+    auto begin = std::chrono::steady_clock::now();
+    if (!infer_batch(models, settings, batch, &write_queue)) {
+      fprintf(stderr, "批量推理失败: %s\n", onnx_get_last_error());
+      counters.infer_failed += (int64_t)batch.size();
+      for (const auto &failed_item : batch) {
+        WriteJob failed;
+        failed.index = failed_item.index;
+        failed.path = failed_item.path;
+        failed.ok = false;
+        write_queue.push(std::move(failed));
+      }
+    }
+    counters.infer_ns += elapsed_ns(begin);
+    batch.clear();
+  }
+  write_queue.close();
+
+  if (video_thread.joinable()) {
+    video_thread.join();
+  }
+  for (auto &thread : decode_threads) {
+    thread.join();
+  }
+  writer.join();
+  if (shard) {
+    {
+      std::lock_guard<std::mutex> lock(heartbeat_mutex);
+      stopping = true;
+    }
+    heartbeat_cv.notify_all();
+    heartbeat.join();
+    shard->heartbeat();
+  }
+  if (journal) {
+    fclose(journal);
+  }
+  OnnxStats stats{};
+  if (onnx_get_stats(model, &stats) != ONNX_OK) {
+    stats = OnnxStats{};
+  }
+  OnnxTrackerStats track_stats{};
+  if (tracker) {
+    onnx_tracker_get_stats(tracker, &track_stats);
+    onnx_tracker_destroy(tracker);
+  }
+  onnx_unload_model(model);
+  onnx_unload_model(models.heavy);
+  onnx_cleanup();
+
+  double seconds = elapsed_ns(start) / 1e9;
+  int64_t written = counters.written.load();
+  fprintf(stderr,
+          "完成: 写出 %lld 张，解码失败 %lld，推理失败 %lld，写入失败 %lld\n",
+          (long long)written, (long long)counters.decode_failed.load(),
+          (long long)counters.infer_failed.load(),
+          (long long)counters.write_failed.load());
+  fprintf(stderr,
+          "耗时 %.2f 秒，%.1f 张/秒（解码 %.2f 秒·线程，推理 %.2f 秒，"
+          "写出 %.2f 秒）\n",
+          seconds, seconds > 0 ? written / seconds : 0.0,
+          counters.decode_ns.load() / 1e9, counters.infer_ns.load() / 1e9,
+          counters.write_ns.load() / 1e9);
+  if (video_mode) {
+    fprintf(stderr, "抽取 %lld 帧（跳过已完成 %zu 帧），帧写出失败 %lld\n",
+            (long long)counters.frames.load(), resumed,
+            (long long)counters.frame_failed.load());
+  }
+  if (options.dedup >= 0) {
+    fprintf(stderr, "近重复跳过 %lld 张（复用上一张推理结果）\n",
+            (long long)stats.dedup_skipped);
+  }
+  if (models.heavy) {
+    fprintf(stderr, "级联: 升级 %lld/%lld 张到重模型（%.1f%%）\n",
+            (long long)stats.cascade_escalated,
+            (long long)stats.cascade_images,
+            stats.cascade_images > 0
+                ? 100.0 * stats.cascade_escalated / stats.cascade_images
+                : 0.0);
+  }
+  if (tracker) {
+    fprintf(stderr,
+            "跟踪: 模型运行 %lld/%lld 帧（%.1f%%，其中提前运行 %lld 次），"
+            "共 %lld 条轨迹\n",
+            (long long)track_stats.detector_calls,
+            (long long)track_stats.frames,
+            track_stats.frames > 0
+                ? 100.0 * track_stats.detector_calls / track_stats.frames
+                : 0.0,
+            (long long)track_stats.forced_calls,
+            (long long)track_stats.tracks_created);
+  }
+  if (shard) {
+    fprintf(stderr, "本 worker 完成 %d 个分块", shard->chunks_done());
+    if (counters.lease_lost > 0) {
+      fprintf(stderr, "，%lld 张因租约被接管未写出",
+              (long long)counters.lease_lost.load());
+    }
+    fprintf(stderr, "\n");
+  }
+  if (!new_classes.empty()) {
+    std::sort(new_classes.begin(), new_classes.end());
+    fprintf(stderr, "项目中未定义的类别 ID:");
+    for (int class_id : new_classes) {
+      fprintf(stderr, " %d", class_id);
+    }
+    fprintf(stderr, "（请在应用中补充标签定义）\n");
+  }
+
+  bool ok = counters.decode_failed == 0 && counters.infer_failed == 0 &&
+            counters.write_failed == 0 && counters.lease_lost == 0 &&
+            counters.frame_failed == 0;
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,1586 @@
+/**
+ * 无界面自动标注工具的可测试逻辑实现
+ */
+#include "label_load_cli_utils.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_NO_STDIO_WRITE
+#include <stb_image.h>
+#endif
+
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE_WRITE
+#define STB_IMAGE_WRITE_IMPLEMENTATION
+#define STBI_WRITE_NO_STDIO
+#include <stb_image_write.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace label_load_cli {
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+const JsonValue *JsonValue::get(const char *key) const {
+  if (type != kObject) {
+    return nullptr;
+  }
+  for (const auto &field : fields) {
+    if (field.first == key) {
+      return &field.second;
+    }
+  }
+  return nullptr;
+}
+
+namespace {
+
+class JsonParser {
+public:
+  explicit JsonParser(const std::string &text) : text_(text) {}
+
+  bool parse(JsonValue *out, std::string *error) {
+    bool ok = parse_value(out, 0);
+    skip_space();
+    if (ok && pos_ != text_.size()) {
+      ok = fail("多余的内容");
+    }
+    if (!ok && error) {
+      *error = error_ + "（偏移 " + std::to_string(pos_) + "）";
+    }
+    return ok;
+  }
+
+private:
+  static constexpr int kMaxDepth = 64;
+
+  bool fail(const char *message) {
+    if (error_.empty()) {
+      error_ = message;
+    }
+    return false;
+  }
+
+  void skip_space() {
+    while (pos_ < text_.size() &&
+           (text_[pos_] == ' ' || text_[pos_] == '\t' || text_[pos_] == '\n' ||
+            text_[pos_] == '\r')) {
+      pos_++;
+    }
+  }
+
+  bool consume(const char *literal) {
+    size_t len = strlen(literal);
+    if (text_.compare(pos_, len, literal) != 0) {
+      return false;
+    }
+    pos_ += len;
+    return true;
+  }
+
+  bool parse_value(JsonValue *out, int depth) {
+    if (depth > kMaxDepth) {
+      return fail("嵌套过深");
+    }
+    skip_space();
+    if (pos_ >= text_.size()) {
+      return fail("意外的结尾");
+    }
+    char ch = text_[pos_];
+    if (ch == '{') {
+      return parse_object(out, depth);
+    }
+    if (ch == '[') {
+      return parse_array(out, depth);
+    }
+    if (ch == '"') {
+      out->type = JsonValue::kString;
+      return parse_string(&out->string);
+    }
+    if (consume("true")) {
+      out->type = JsonValue::kBool;
+      out->boolean = true;
+      return true;
+    }
+    if (consume("false")) {
+      out->type = JsonValue::kBool;
+      out->boolean = false;
+      return true;
+    }
+    if (consume("null")) {
+      out->type = JsonValue::kNull;
+      return true;
+    }
+    return parse_number(out);
+  }
+
+  bool parse_object(JsonValue *out, int depth) {
+    out->type = JsonValue::kObject;
+    pos_++; // '{'
+    skip_space();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+      pos_++;
+      return true;
+    }
+    while (true) {
+      skip_space();
+      std::string key;
+      if (pos_ >= text_.size() || text_[pos_] != '"' || !parse_string(&key)) {
+        return fail("缺少字段名");
+      }
+      skip_space();
+      if (pos_ >= text_.size() || text_[pos_] != ':') {
+        return fail("缺少 ':'");
+      }
+      pos_++;
+      out->fields.emplace_back(std::move(key), JsonValue());
+      if (!parse_value(&out->fields.back().second, depth + 1)) {
+        return false;
+      }
+      skip_space();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        pos_++;
+        continue;
+      }
+      if (pos_ < text_.size() && text_[pos_] == '}') {
+        pos_++;
+        return true;
+      }
+      return fail("缺少 ',' 或 '}'");
+    }
+  }
+
+  bool parse_array(JsonValue *out, int depth) {
+    out->type = JsonValue::kArray;
+    pos_++; // '['
+    skip_space();
+    if (pos_ < text_.size() && text_[pos_] == ']') {
+      pos_++;
+      return true;
+    }
+    while (true) {
+      out->items.emplace_back();
+      if (!parse_value(&out->items.back(), depth + 1)) {
+        return false;
+      }
+      skip_space();
+      if (pos_ < text_.size() && text_[pos_] == ',') {
+        pos_++;
+        continue;
+      }
+      if (pos_ < text_.size() && text_[pos_] == ']') {
+        pos_++;
+        return true;
+      }
+      return fail("缺少 ',' 或 ']'");
+    }
+  }
+
+  bool parse_hex4(uint32_t *out) {
+    if (pos_ + 4 > text_.size()) {
+      return false;
+    }
+    *out = 0;
+    for (int i = 0; i < 4; i++) {
+      char ch = text_[pos_++];
+      *out <<= 4;
+      if (ch >= '0' && ch <= '9') {
+        *out |= (uint32_t)(ch - '0');
+      } else if (ch >= 'a' && ch <= 'f') {
+        *out |= (uint32_t)(ch - 'a' + 10);
+      } else if (ch >= 'A' && ch <= 'F') {
+        *out |= (uint32_t)(ch - 'A' + 10);
+      } else {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static void append_utf8(std::string *out, uint32_t cp) {
+    if (cp < 0x80) {
+      out->push_back((char)cp);
+    } else if (cp < 0x800) {
+      out->push_back((char)(0xC0 | (cp >> 6)));
+      out->push_back((char)(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+      out->push_back((char)(0xE0 | (cp >> 12)));
+      out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+      out->push_back((char)(0x80 | (cp & 0x3F)));
+    } else {
+      out->push_back((char)(0xF0 | (cp >> 18)));
+      out->push_back((char)(0x80 | ((cp >> 12) & 0x3F)));
+      out->push_back((char)(0x80 | ((cp >> 6) & 0x3F)));
+      out->push_back((char)(0x80 | (cp & 0x3F)));
+    }
+  }
+
+  bool parse_string(std::string *out) {
+    pos_++; // '"'
+    while (pos_ < text_.size()) {
+      char ch = text_[pos_++];
+      if (ch == '"') {
+        return true;
+      }
+      if (ch != '\\') {
+        out->push_back(ch);
+        continue;
+      }
+      if (pos_ >= text_.size()) {
+        break;
+      }
+      char esc = text_[pos_++];
+      switch (esc) {
+      case '"':
+      case '\\':
+      case '/':
+        out->push_back(esc);
+        break;
+      case 'b':
+        out->push_back('\b');
+        break;
+      case 'f':
+        out->push_back('\f');
+        break;
+      case 'n':
+        out->push_back('\n');
+        break;
+      case 'r':
+        out->push_back('\r');
+        break;
+      case 't':
+        out->push_back('\t');
+        break;
+      case 'u': {
+        uint32_t cp = 0;
+        if (!parse_hex4(&cp)) {
+          return fail("无效的 \\u 转义");
+        }
+        // UTF-16 代理对
+        if (cp >= 0xD800 && cp < 0xDC00 && consume("\\u")) {
+          uint32_t low = 0;
+          if (!parse_hex4(&low) || low < 0xDC00 || low >= 0xE000) {
+            return fail("无效的代理对");
+          }
+          cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+        }
+        append_utf8(out, cp);
+        break;
+      }
+      default:
+        return fail("无效的转义字符");
+      }
+    }
+    return fail("字符串未结束");
+  }
+
+  bool parse_number(JsonValue *out) {
+    const char *begin = text_.c_str() + pos_;
+    char *end = nullptr;
+    out->number = strtod(begin, &end);
+    if (end == begin || !(*begin == '-' || (*begin >= '0' && *begin <= '9'))) {
+      return fail("无效的值");
+    }
+    out->type = JsonValue::kNumber;
+    pos_ += (size_t)(end - begin);
+    return true;
+  }
+
+  const std::string &text_;
+  size_t pos_ = 0;
+  std::string error_;
+};
+
+std::string json_string(const JsonValue &obj, const char *key) {
+  const JsonValue *value = obj.get(key);
+  return value && value->type == JsonValue::kString ? value->string : "";
+}
+
+// 数值字段，缺失或类型不符时返回 fallback（同 `as num? ?? fallback`）。
+double json_number(const JsonValue &obj, const char *key, double fallback) {
+  const JsonValue *value = obj.get(key);
+  return value && value->type == JsonValue::kNumber ? value->number : fallback;
+}
+
+int json_int(const JsonValue &obj, const char *key, int fallback) {
+  return (int)json_number(obj, key, fallback);
+}
+
+} // namespace
+
+bool parse_json(const std::string &text, JsonValue *out, std::string *error) {
+  *out = JsonValue();
+  return JsonParser(text).parse(out, error);
+}
+
+// ============================================================================
+// 项目配置
+// ============================================================================
+
+namespace {
+
+std::string env_or_empty(const char *name) {
+  const char *value = getenv(name);
+  return value ? value : "";
+}
+
+#ifndef _WIN32
+// path_provider 在 Linux 上经 xdg-user-dir 取文档目录，这里直接读取其配置。
+std::string xdg_documents_dir(const std::string &home) {
+  std::string config_home = env_or_empty("XDG_CONFIG_HOME");
+  if (config_home.empty()) {
+    config_home = home + "/.config";
+  }
+  std::ifstream file(config_home + "/user-dirs.dirs");
+  std::string line;
+  const std::string key = "XDG_DOCUMENTS_DIR=\"";
+  while (std::getline(file, line)) {
+    if (line.compare(0, key.size(), key) != 0) {
+      continue;
+    }
+    std::string value = line.substr(key.size());
+    size_t quote = value.find('"');
+    if (quote != std::string::npos) {
+      value.resize(quote);
+    }
+    if (value.compare(0, 5, "$HOME") == 0) {
+      value = home + value.substr(5);
+    }
+    return value;
+  }
+  return home + "/Documents";
+}
+#endif
+
+} // namespace
+
+std::string default_projects_path() {
+#ifdef _WIN32
+  std::string documents = env_or_empty("USERPROFILE") + "\\Documents";
+#else
+  std::string documents = env_or_empty("XDG_DOCUMENTS_DIR");
+  if (documents.empty()) {
+    documents = xdg_documents_dir(env_or_empty("HOME"));
+  }
+#endif
+  return (fs::path(documents) / "LabelLoad" / "projects.json").string();
+}
+
+bool load_project(const std::string &projects_path, const std::string &key,
+                  ProjectSettings *out, std::string *error) {
+  std::string text;
+  if (!read_file(projects_path, &text)) {
+    *error = "无法读取项目列表: " + projects_path;
+    return false;
+  }
+  JsonValue root;
+  std::string parse_error;
+  if (!parse_json(text, &root, &parse_error)) {
+    *error = "项目列表格式错误: " + parse_error;
+    return false;
+  }
+  if (root.type != JsonValue::kArray) {
+    *error = "项目列表格式错误: 顶层应为数组";
+    return false;
+  }
+
+  const JsonValue *project = nullptr;
+  for (const auto &item : root.items) {
+    if (json_string(item, "id") == key || json_string(item, "name") == key) {
+      project = &item;
+      break;
+    }
+  }
+  if (!project) {
+    *error = "未找到项目: " + key;
+    return false;
+  }
+
+  ProjectSettings settings;
+  settings.name = json_string(*project, "name");
+  settings.image_dir = json_string(*project, "imagePath");
+  settings.label_dir = json_string(*project, "labelPath");
+
+  // 旧格式的标签定义没有 classId，按数组下标回退。
+  if (const JsonValue *defs = project->get("labelDefinitions")) {
+    for (size_t i = 0; i < defs->items.size(); i++) {
+      const JsonValue &def = defs->items[i];
+      int type = json_int(def, "type", kLabelBox);
+      if (type < kLabelBox || type > kLabelPolygon) {
+        type = kLabelBox;
+      }
+      settings.label_types.emplace_back(json_int(def, "classId", (int)i), type);
+    }
+  }
+
+  if (const JsonValue *ai = project->get("aiConfig")) {
+    settings.model_type = json_int(*ai, "modelType", MODEL_TYPE_YOLO);
+    settings.model_path = json_string(*ai, "modelPath");
+    settings.conf_threshold =
+        json_number(*ai, "confidenceThreshold", settings.conf_threshold);
+    settings.nms_threshold =
+        json_number(*ai, "nmsThreshold", settings.nms_threshold);
+    settings.save_mode = json_int(*ai, "labelSaveMode", kSaveAppend);
+    settings.num_keypoints = json_int(*ai, "numKeypoints", 0);
+    settings.class_id_offset = json_int(*ai, "classIdOffset", 0);
+  }
+
+  *out = std::move(settings);
+  return true;
+}
+
+int label_type_for_class(const ProjectSettings &settings, int class_id,
+                         int fallback) {
+  for (const auto &entry : settings.label_types) {
+    if (entry.first == class_id) {
+      return entry.second;
+    }
+  }
+  return fallback;
+}
+
+// ============================================================================
+// YOLO 标签
+// ============================================================================
+
+namespace {
+
+bool is_space(char ch) { return isspace((unsigned char)ch) != 0; }
+
+std::vector<std::string> split_fields(const std::string &line) {
+  std::vector<std::string> parts;
+  size_t i = 0;
+  while (i < line.size()) {
+    while (i < line.size() && is_space(line[i])) {
+      i++;
+    }
+    size_t start = i;
+    while (i < line.size() && !is_space(line[i])) {
+      i++;
+    }
+    if (i > start) {
+      parts.push_back(line.substr(start, i - start));
+    }
+  }
+  return parts;
+}
+
+// 十进制整数（同 int.tryParse 的常见输入）。
+bool parse_int(const std::string &text, int *out) {
+  if (text.empty()) {
+    return false;
+  }
+  errno = 0;
+  char *end = nullptr;
+  long long value = strtoll(text.c_str(), &end, 10);
+  if (*end != '\0' || errno == ERANGE || value < INT32_MIN ||
+      value > INT32_MAX) {
+    return false;
+  }
+  *out = (int)value;
+  return true;
+}
+
+// 浮点数（同 double.parse：接受 NaN/Infinity，不接受十六进制与 inf/nan）。
+bool parse_double(const std::string &text, double *out) {
+  if (text == "NaN") {
+    *out = NAN;
+    return true;
+  }
+  if (text == "Infinity" || text == "+Infinity" || text == "-Infinity") {
+    *out = text[0] == '-' ? -INFINITY : INFINITY;
+    return true;
+  }
+  for (char ch : text) {
+    if (!(isdigit((unsigned char)ch) || ch == '.' || ch == '-' || ch == '+' ||
+          ch == 'e' || ch == 'E')) {
+      return false;
+    }
+  }
+  char *end = nullptr;
+  *out = strtod(text.c_str(), &end);
+  return !text.empty() && *end == '\0';
+}
+
+// 同 double.toStringAsFixed(6)。
+void append_fixed(std::string *out, double value) {
+  if (std::isnan(value)) {
+    *out += "NaN";
+  } else if (std::isinf(value)) {
+    *out += value < 0 ? "-Infinity" : "Infinity";
+  } else {
+    char buf[64];
+    snprintf(buf, sizeof(buf), "%.6f", value);
+    *out += buf;
+  }
+}
+
+void update_bbox_from_points(YoloLabel *label) {
+  if (label->points.empty()) {
+    return;
+  }
+  double min_x = label->points[0].x, max_x = min_x;
+  double min_y = label->points[0].y, max_y = min_y;
+  for (const auto &p : label->points) {
+    min_x = std::min(min_x, p.x);
+    max_x = std::max(max_x, p.x);
+    min_y = std::min(min_y, p.y);
+    max_y = std::max(max_y, p.y);
+  }
+  label->x = (min_x + max_x) / 2;
+  label->y = (min_y + max_y) / 2;
+  label->width = std::fabs(max_x - min_x);
+  label->height = std::fabs(max_y - min_y);
+}
+
+int visibility_from_score(float score) {
+  if (score > 0.5f) {
+    return 2;
+  }
+  return score > 0.2f ? 1 : 0;
+}
+
+} // namespace
+
+YoloLabel label_from_detection(const Detection &det) {
+  YoloLabel label;
+  label.class_id = det.class_id;
+  label.x = det.x;
+  label.y = det.y;
+  label.width = det.width;
+  label.height = det.height;
+  if (det.polygon && det.num_polygon_points > 0) {
+    for (int i = 0; i < det.num_polygon_points; i++) {
+      label.points.push_back({det.polygon[i * 2], det.polygon[i * 2 + 1], 2});
+    }
+    label.polygon = true;
+    // 旋转框的宽高是边长而非包围盒，统一以轮廓/角点重算边界框。
+    update_bbox_from_points(&label);
+  } else if (det.keypoints && det.num_keypoints > 0) {
+    for (int i = 0; i < det.num_keypoints; i++) {
+      const float *kp = det.keypoints + i * 3;
+      label.points.push_back({kp[0], kp[1], visibility_from_score(kp[2])});
+    }
+  }
+  return label;
+}
+
+bool parse_yolo_line(const std::string &line, int type, YoloLabel *out) {
+  std::vector<std::string> parts = split_fields(line);
+  YoloLabel label;
+  if (parts.empty() || !parse_int(parts[0], &label.class_id)) {
+    return false;
+  }
+
+  size_t i = 1;
+  if (type == kLabelPolygon) {
+    // class_id x1 y1 x2 y2 x3 y3 ...，至少 3 个点
+    if (parts.size() < 7) {
+      return false;
+    }
+    while (i + 1 < parts.size()) {
+      LabelPoint p;
+      if (!parse_double(parts[i], &p.x) || !parse_double(parts[i + 1], &p.y)) {
+        break;
+      }
+      label.points.push_back(p);
+      i += 2;
+    }
+    update_bbox_from_points(&label);
+  } else {
+    // class_id cx cy w h [x y v]...
+    if (parts.size() < 5 || !parse_double(parts[1], &label.x) ||
+        !parse_double(parts[2], &label.y) ||
+        !parse_double(parts[3], &label.width) ||
+        !parse_double(parts[4], &label.height)) {
+      return false;
+    }
+    i = 5;
+    if (type == kLabelBoxWithPoint) {
+      while (i + 2 < parts.size()) {
+        LabelPoint p;
+        double v = 0;
+        if (!parse_double(parts[i], &p.x) ||
+            !parse_double(parts[i + 1], &p.y) ||
+            !parse_double(parts[i + 2], &v) || !std::isfinite(v)) {
+          break;
+        }
+        p.visibility = (int)std::min(2.0, std::max(0.0, std::round(v)));
+        label.points.push_back(p);
+        i += 3;
+      }
+    }
+  }
+  label.extra.assign(parts.begin() + (ptrdiff_t)i, parts.end());
+  *out = std::move(label);
+  return true;
+}
+
+std::string format_yolo_line(const YoloLabel &label, bool is_polygon) {
+  std::string line = std::to_string(label.class_id);
+  if (is_polygon && !label.points.empty()) {
+    for (const auto &p : label.points) {
+      line += ' ';
+      append_fixed(&line, p.x);
+      line += ' ';
+      append_fixed(&line, p.y);
+    }
+  } else {
+    for (double v : {label.x, label.y, label.width, label.height}) {
+      line += ' ';
+      append_fixed(&line, v);
+    }
+    for (const auto &p : label.points) {
+      line += ' ';
+      append_fixed(&line, p.x);
+      line += ' ';
+      append_fixed(&line, p.y);
+      line += ' ' + std::to_string(p.visibility);
+    }
+  }
+  for (const auto &field : label.extra) {
+    line += ' ' + field;
+  }
+  return line;
+}
+
+std::vector<int> fill_missing_label_types(const std::vector<YoloLabel> &labels,
+                                          ProjectSettings *settings) {
+  std::vector<int> added;
+  for (const auto &label : labels) {
+    if (label_type_for_class(*settings, label.class_id, -1) < 0 &&
+        std::find(added.begin(), added.end(), label.class_id) == added.end()) {
+      added.push_back(label.class_id);
+    }
+  }
+  for (int class_id : added) {
+    int type = kLabelBox;
+    for (const auto &label : labels) {
+      if (label.class_id != class_id || label.points.empty()) {
+        continue;
+      }
+      // 分割轮廓与旋转框角点按多边形保存，而不是关键点。
+      if (label.polygon) {
+        type = kLabelPolygon;
+        break;
+      }
+      type = kLabelBoxWithPoint;
+    }
+    settings->label_types.emplace_back(class_id, type);
+  }
+  std::sort(settings->label_types.begin(), settings->label_types.end());
+  std::sort(added.begin(), added.end());
+  return added;
+}
+
+std::string merge_label_file(const std::string *existing,
+                             std::vector<YoloLabel> labels,
+                             ProjectSettings *settings) {
+  bool append = settings->save_mode == kSaveAppend;
+  for (auto &label : labels) {
+    if (append) {
+      label.class_id += settings->class_id_offset;
+    }
+    // 纯边界框类别不保留关键点与额外字段。
+    int fallback = label.polygon ? kLabelPolygon : kLabelBoxWithPoint;
+    if (label_type_for_class(*settings, label.class_id, fallback) ==
+        kLabelBox) {
+      label.points.clear();
+      label.extra.clear();
+    }
+  }
+  fill_missing_label_types(labels, settings);
+
+  // 已有文件：可解析的行按标签重新格式化，其余行原样保留在末尾。
+  std::vector<YoloLabel> kept;
+  std::vector<std::string> corrupted;
+  if (existing) {
+    std::istringstream stream(*existing);
+    std::string line;
+    while (std::getline(stream, line)) {
+      std::vector<std::string> parts = split_fields(line);
+      if (parts.empty()) {
+        continue;
+      }
+      int class_id = 0;
+      YoloLabel label;
+      if (!parse_int(parts[0], &class_id) ||
+          !parse_yolo_line(line,
+                           label_type_for_class(*settings, class_id,
+                                                kLabelBoxWithPoint),
+                           &label)) {
+        corrupted.push_back(line);
+        continue;
+      }
+      kept.push_back(std::move(label));
+    }
+  }
+  if (append && !kept.empty()) {
+    labels.insert(labels.begin(), std::make_move_iterator(kept.begin()),
+                  std::make_move_iterator(kept.end()));
+  }
+
+  std::string content;
+  for (const auto &label : labels) {
+    if (!content.empty()) {
+      content += '\n';
+    }
+    bool is_polygon = label_type_for_class(*settings, label.class_id,
+                                           kLabelBox) == kLabelPolygon;
+    content += format_yolo_line(label, is_polygon);
+  }
+  for (const auto &line : corrupted) {
+    if (!content.empty()) {
+      content += '\n';
+    }
+    content += line;
+  }
+  return content;
+}
+
+// ============================================================================
+// 图片与文件
+// ============================================================================
+
+namespace {
+
+// 应用内 supportedImageExtensions。
+const char *const kAppImageExtensions[] = {".jpg", ".jpeg", ".png", ".bmp",
+                                           ".webp"};
+
+std::string lower_extension(const fs::path &path) {
+  std::string ext = path.extension().string();
+  std::transform(ext.begin(), ext.end(), ext.begin(),
+                 [](unsigned char ch) { return (char)tolower(ch); });
+  return ext;
+}
+
+// 读取 PNM 头部的下一个整数（跳过空白与注释）。
+bool read_pnm_int(const std::string &data, size_t *pos, int *value) {
+  while (*pos < data.size()) {
+    char ch = data[*pos];
+    if (ch == '#') {
+      while (*pos < data.size() && data[*pos] != '\n') {
+        (*pos)++;
+      }
+    } else if (is_space(ch)) {
+      (*pos)++;
+    } else {
+      break;
+    }
+  }
+  if (*pos >= data.size() || !isdigit((unsigned char)data[*pos])) {
+    return false;
+  }
+  int64_t v = 0;
+  while (*pos < data.size() && isdigit((unsigned char)data[*pos])) {
+    v = v * 10 + (data[(*pos)++] - '0');
+    if (v > INT32_MAX) {
+      return false;
+    }
+  }
+  *value = (int)v;
+  return true;
+}
+
+// 二进制 PPM（P6）/ PGM（P5），8 位。
+bool decode_pnm(const std::string &data, RgbaImage *out) {
+  if (data.size() < 2 || data[0] != 'P' || (data[1] != '5' && data[1] != '6')) {
+    return false;
+  }
+  int channels = data[1] == '6' ? 3 : 1;
+  size_t pos = 2;
+  int width = 0, height = 0, maxval = 0;
+  if (!read_pnm_int(data, &pos, &width) || !read_pnm_int(data, &pos, &height) ||
+      !read_pnm_int(data, &pos, &maxval) || maxval != 255 || width <= 0 ||
+      height <= 0 || pos >= data.size()) {
+    return false;
+  }
+  pos++; // 头部后的单个空白
+  size_t pixels = (size_t)width * height;
+  if (data.size() - pos < pixels * channels) {
+    return false;
+  }
+  const uint8_t *src = (const uint8_t *)data.data() + pos;
+  out->width = width;
+  out->height = height;
+  out->rgba.resize(pixels * 4);
+  for (size_t i = 0; i < pixels; i++) {
+    const uint8_t *px = src + i * channels;
+    out->rgba[i * 4 + 0] = px[0];
+    out->rgba[i * 4 + 1] = px[channels == 3 ? 1 : 0];
+    out->rgba[i * 4 + 2] = px[channels == 3 ? 2 : 0];
+    out->rgba[i * 4 + 3] = 255;
+  }
+  return true;
+}
+
+} // namespace
+
+const std::vector<std::string> &decodable_extensions() {
+  static const std::vector<std::string> extensions = {
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE
+      ".jpg", ".jpeg", ".png", ".bmp",
+#endif
+      ".ppm", ".pgm"};
+  return extensions;
+}
+
+std::vector<std::string> list_images(const std::string &dir, int *skipped) {
+  const auto &decodable = decodable_extensions();
+  std::vector<std::string> paths;
+  int unsupported = 0;
+  std::error_code error;
+  for (const auto &entry : fs::directory_iterator(dir, error)) {
+    if (!entry.is_regular_file(error)) {
+      continue;
+    }
+    std::string ext = lower_extension(entry.path());
+    if (std::find(decodable.begin(), decodable.end(), ext) != decodable.end()) {
+      paths.push_back(entry.path().string());
+    } else if (std::find(std::begin(kAppImageExtensions),
+                         std::end(kAppImageExtensions),
+                         ext) != std::end(kAppImageExtensions)) {
+      unsupported++;
+    }
+  }
+  std::sort(paths.begin(), paths.end());
+  if (skipped) {
+    *skipped = unsupported;
+  }
+  return paths;
+}
+
+bool decode_image(const std::string &path, RgbaImage *out, std::string *error) {
+  std::string data;
+  if (!read_file(path, &data)) {
+    *error = "无法读取文件";
+    return false;
+  }
+  if (decode_pnm(data, out)) {
+    return true;
+  }
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE
+  int width = 0, height = 0, channels = 0;
+  stbi_uc *pixels =
+      stbi_load_from_memory((const stbi_uc *)data.data(), (int)data.size(),
+                            &width, &height, &channels, 4);
+  if (pixels) {
+    out->width = width;
+    out->height = height;
+    out->rgba.assign(pixels, pixels + (size_t)width * height * 4);
+    stbi_image_free(pixels);
+    return true;
+  }
+  *error = stbi_failure_reason();
+#else
+  *error = "无法解码（当前构建仅支持 PPM/PGM）";
+#endif
+  return false;
+}
+
+bool write_file_atomic(const std::string &path, const std::string &content) {
+  static std::atomic<uint64_t> counter{0};
+  fs::path target(path);
+  std::error_code error;
+  if (target.has_parent_path()) {
+    fs::create_directories(target.parent_path(), error);
+  }
+  fs::path tmp = target.parent_path() /
+                 ("." + target.filename().string() + ".tmp" +
+                  std::to_string(counter.fetch_add(1)));
+  {
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    file.write(content.data(), (std::streamsize)content.size());
+    if (!file.good()) {
+      file.close();
+      fs::remove(tmp, error);
+      return false;
+    }
+  }
+  fs::rename(tmp, target, error);
+  if (error) {
+    // 部分平台不允许覆盖，删除后重试。
+    fs::remove(target, error);
+    fs::rename(tmp, target, error);
+  }
+  if (error) {
+    fs::remove(tmp, error);
+    return false;
+  }
+  return true;
+}
+
+bool read_file(const std::string &path, std::string *out) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::ostringstream buffer;
+  buffer << file.rdbuf();
+  *out = buffer.str();
+  return true;
+}
+
+std::set<std::string> read_journal(const std::string &path) {
+  std::set<std::string> done;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      done.insert(line);
+    }
+  }
+  return done;
+}
+
+// ============================================================================
+// 视频抽帧
+// ============================================================================
+
+const std::vector<std::string> &video_extensions() {
+  static const std::vector<std::string> extensions = {".mp4", ".mkv", ".avi",
+                                                      ".webm", ".mov"};
+  return extensions;
+}
+
+std::vector<std::string> list_videos(const std::string &path) {
+  std::vector<std::string> videos;
+  std::error_code error;
+  if (!fs::is_directory(path, error)) {
+    videos.push_back(path);
+    return videos;
+  }
+  const auto &extensions = video_extensions();
+  for (const auto &entry : fs::directory_iterator(path, error)) {
+    if (entry.is_regular_file(error) &&
+        std::find(extensions.begin(), extensions.end(),
+                  lower_extension(entry.path())) != extensions.end()) {
+      videos.push_back(entry.path().string());
+    }
+  }
+  std::sort(videos.begin(), videos.end());
+  return videos;
+}
+
+FrameSampler::FrameSampler(int stride, double fps)
+    : stride_(std::max(1, stride)), interval_(fps > 0 ? 1.0 / fps : 0) {}
+
+bool FrameSampler::accept(double seconds) {
+  if (interval_ <= 0) {
+    return count_++ % stride_ == 0;
+  }
+  // 容忍时间戳取整误差；跳跃后从当前帧重新计时。
+  if (seconds + 1e-6 < next_) {
+    return false;
+  }
+  next_ += interval_;
+  if (next_ <= seconds) {
+    next_ = seconds + interval_;
+  }
+  return true;
+}
+
+void FrameSampler::reset() {
+  count_ = 0;
+  next_ = 0;
+}
+
+std::string frame_file_name(const std::string &video_path, int64_t frame,
+                            const std::string &format) {
+  char number[32];
+  snprintf(number, sizeof(number), "%06lld", (long long)frame);
+  return fs::path(video_path).stem().string() + "_" + number + "." + format;
+}
+
+const std::vector<std::string> &frame_formats() {
+  static const std::vector<std::string> formats = {
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE_WRITE
+      "jpg",
+#endif
+      "bmp"};
+  return formats;
+}
+
+namespace {
+
+void put_le(std::string *out, uint32_t value, int bytes) {
+  for (int i = 0; i < bytes; i++) {
+    out->push_back((char)((value >> (8 * i)) & 0xFF));
+  }
+}
+
+std::string encode_bmp(const RgbaImage &image) {
+  // 自下而上存储的 BGR 行，每行补齐到 4 字节。
+  uint32_t row = ((uint32_t)image.width * 3 + 3) & ~3u;
+  uint32_t pixels = row * (uint32_t)image.height;
+  std::string out;
+  out.reserve(54 + pixels);
+  out += "BM";
+  put_le(&out, 54 + pixels, 4);
+  put_le(&out, 0, 4);
+  put_le(&out, 54, 4);
+  put_le(&out, 40, 4);
+  put_le(&out, (uint32_t)image.width, 4);
+  put_le(&out, (uint32_t)image.height, 4);
+  put_le(&out, 1, 2);
+  put_le(&out, 24, 2);
+  put_le(&out, 0, 4);
+  put_le(&out, pixels, 4);
+  put_le(&out, 2835, 4); // 72 DPI
+  put_le(&out, 2835, 4);
+  put_le(&out, 0, 4);
+  put_le(&out, 0, 4);
+  for (int y = image.height - 1; y >= 0; y--) {
+    const uint8_t *src = image.rgba.data() + (size_t)y * image.width * 4;
+    size_t start = out.size();
+    for (int x = 0; x < image.width; x++) {
+      out.push_back((char)src[x * 4 + 2]);
+      out.push_back((char)src[x * 4 + 1]);
+      out.push_back((char)src[x * 4 + 0]);
+    }
+    out.append(row - (out.size() - start), '\0');
+  }
+  return out;
+}
+
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE_WRITE
+void append_to_string(void *context, void *data, int size) {
+  static_cast<std::string *>(context)->append((const char *)data, size);
+}
+#endif
+
+} // namespace
+
+bool encode_frame(const RgbaImage &image, const std::string &format,
+                  std::string *out) {
+  if (image.width <= 0 || image.height <= 0 ||
+      image.rgba.size() < (size_t)image.width * image.height * 4) {
+    return false;
+  }
+  out->clear();
+  if (format == "bmp") {
+    *out = encode_bmp(image);
+    return true;
+  }
+#ifdef LABEL_LOAD_CLI_HAVE_STB_IMAGE_WRITE
+  if (format == "jpg") {
+    return stbi_write_jpg_to_func(append_to_string, out, image.width,
+                                  image.height, 4, image.rgba.data(),
+                                  95) != 0;
+  }
+#endif
+  return false;
+}
+
+// ============================================================================
+// 分片任务
+// ============================================================================
+
+namespace {
+
+const char *const kPlanHeader = "label_load shard plan v1";
+
+std::string chunk_file(const std::string &dir, int chunk, const char *kind,
+                       int generation) {
+  std::string name = "chunk_" + std::to_string(chunk) + "." + kind;
+  if (generation >= 0) {
+    name += "." + std::to_string(generation);
+  }
+  return (fs::path(dir) / name).string();
+}
+
+// 独占创建并写入文件，已存在返回 false（NFSv3 起 O_EXCL 为服务端原子操作）。
+bool create_exclusive(const std::string &path, const std::string &content) {
+  FILE *file = fopen(path.c_str(), "wx");
+  if (!file) {
+    return false;
+  }
+  fwrite(content.data(), 1, content.size(), file);
+  fclose(file);
+  return true;
+}
+
+// 当前最高代租约，没有租约返回 -1。
+int current_generation(const std::string &dir, int chunk) {
+  std::error_code error;
+  int generation = 0;
+  while (fs::exists(chunk_file(dir, chunk, "lease", generation), error)) {
+    generation++;
+  }
+  return generation - 1;
+}
+
+int64_t modified_stamp(const std::string &path) {
+  std::error_code error;
+  auto time = fs::last_write_time(path, error);
+  return error ? -1 : (int64_t)time.time_since_epoch().count();
+}
+
+std::vector<std::string> read_lines(const std::string &path) {
+  std::vector<std::string> lines;
+  std::ifstream file(path);
+  std::string line;
+  while (std::getline(file, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (!line.empty()) {
+      lines.push_back(line);
+    }
+  }
+  return lines;
+}
+
+std::string file_name_of(const std::string &path) {
+  return fs::path(path).filename().string();
+}
+
+std::string format_plan(const ShardPlan &plan) {
+  return std::string(kPlanHeader) + "\nchunk_size " +
+         std::to_string(plan.chunk_size) + "\nimages " +
+         std::to_string(plan.image_count) + "\nlist_hash " +
+         std::to_string(plan.list_hash) + "\n";
+}
+
+// 进度文件名中只保留安全字符。
+std::string sanitize_worker_id(const std::string &worker) {
+  std::string out = worker;
+  for (char &ch : out) {
+    if (!isalnum((unsigned char)ch) && ch != '-' && ch != '_' && ch != '.') {
+      ch = '_';
+    }
+  }
+  return out;
+}
+
+} // namespace
+
+std::string shard_dir(const std::string &label_dir) {
+  return (fs::path(label_dir) / ".label_load_shards").string();
+}
+
+bool parse_shard_spec(const std::string &text, int *index, int *count) {
+  size_t slash = text.find('/');
+  if (slash == std::string::npos) {
+    return false;
+  }
+  int i = 0, n = 0;
+  if (!parse_int(text.substr(0, slash), &i) ||
+      !parse_int(text.substr(slash + 1), &n) || n <= 0 || i < 0 || i >= n) {
+    return false;
+  }
+  *index = i;
+  *count = n;
+  return true;
+}
+
+std::string default_worker_id() {
+  char host[256] = {0};
+#ifdef _WIN32
+  const char *name = getenv("COMPUTERNAME");
+  snprintf(host, sizeof(host), "%s", name ? name : "host");
+  int pid = _getpid();
+#else
+  if (gethostname(host, sizeof(host) - 1) != 0) {
+    snprintf(host, sizeof(host), "host");
+  }
+  int pid = (int)getpid();
+#endif
+  return std::string(host) + "-" + std::to_string(pid);
+}
+
+int ShardPlan::chunk_count() const {
+  return chunk_size > 0 ? (int)((image_count + chunk_size - 1) / chunk_size)
+                        : 0;
+}
+
+ShardPlan make_shard_plan(const std::vector<std::string> &images,
+                          int chunk_size) {
+  ShardPlan plan;
+  plan.chunk_size = chunk_size;
+  plan.image_count = (int64_t)images.size();
+  uint64_t hash = 0xcbf29ce484222325ULL;
+  for (const auto &path : images) {
+    for (unsigned char ch : file_name_of(path) + "\n") {
+      hash ^= ch;
+      hash *= 0x100000001b3ULL;
+    }
+  }
+  plan.list_hash = hash;
+  return plan;
+}
+
+bool read_shard_plan(const std::string &dir, ShardPlan *out) {
+  std::vector<std::string> lines =
+      read_lines((fs::path(dir) / "plan").string());
+  if (lines.size() < 4 || lines[0] != kPlanHeader) {
+    return false;
+  }
+  ShardPlan plan;
+  unsigned long long hash = 0;
+  long long images = 0;
+  if (sscanf(lines[1].c_str(), "chunk_size %d", &plan.chunk_size) != 1 ||
+      sscanf(lines[2].c_str(), "images %lld", &images) != 1 ||
+      sscanf(lines[3].c_str(), "list_hash %llu", &hash) != 1 ||
+      plan.chunk_size <= 0 || images < 0) {
+    return false;
+  }
+  plan.image_count = images;
+  plan.list_hash = hash;
+  *out = plan;
+  return true;
+}
+
+bool open_shard_plan(const std::string &dir, const ShardPlan &plan,
+                     std::string *error) {
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  fs::path target = fs::path(dir) / "plan";
+  // 先写临时文件再硬链接到 plan：硬链接在目标存在时失败，其他 worker
+  // 不会读到写了一半的计划。
+  fs::path tmp = fs::path(dir) / ("plan.tmp." + sanitize_worker_id(
+                                                   default_worker_id()));
+  if (!write_file_atomic(tmp.string(), format_plan(plan))) {
+    *error = "无法写入分片目录: " + dir;
+    return false;
+  }
+  fs::create_hard_link(tmp, target, ec);
+  std::error_code ignored;
+  fs::remove(tmp, ignored);
+
+  ShardPlan existing;
+  if (!read_shard_plan(dir, &existing)) {
+    *error = "分片计划损坏: " + target.string();
+    return false;
+  }
+  if (existing.chunk_size != plan.chunk_size ||
+      existing.image_count != plan.image_count ||
+      existing.list_hash != plan.list_hash) {
+    *error = "分片计划与当前图片列表或 --chunk 不一致（分块 " +
+             std::to_string(existing.chunk_size) + "，图片 " +
+             std::to_string(existing.image_count) +
+             "）；重新开始请删除 " + dir;
+    return false;
+  }
+  return true;
+}
+
+ShardCoverage verify_shard_coverage(const std::string &dir,
+                                    const std::vector<std::string> &images,
+                                    const ShardPlan &plan) {
+  ShardCoverage coverage;
+  coverage.chunks_total = plan.chunk_count();
+  for (int chunk = 0; chunk < coverage.chunks_total; chunk++) {
+    size_t begin = (size_t)chunk * plan.chunk_size;
+    size_t end = std::min(images.size(), begin + plan.chunk_size);
+    std::vector<std::string> lines;
+    std::error_code error;
+    std::string done_path = chunk_file(dir, chunk, "done", -1);
+    bool done = fs::exists(done_path, error);
+    if (done) {
+      coverage.chunks_done++;
+      lines = read_lines(done_path);
+    }
+    std::set<std::string> written(lines.begin(), lines.end());
+    for (size_t i = begin; i < end; i++) {
+      std::string name = file_name_of(images[i]);
+      if (written.count(name)) {
+        coverage.written.push_back(name);
+      } else {
+        coverage.missing.push_back(name);
+      }
+    }
+  }
+  return coverage;
+}
+
+std::vector<ShardProgress> read_shard_progress(const std::string &dir) {
+  std::vector<ShardProgress> result;
+  std::error_code error;
+  for (const auto &entry : fs::directory_iterator(dir, error)) {
+    if (entry.path().extension() != ".progress") {
+      continue;
+    }
+    std::vector<std::string> lines = read_lines(entry.path().string());
+    if (lines.empty()) {
+      continue;
+    }
+    ShardProgress progress;
+    long long images = 0, updated = 0;
+    char worker[256] = {0};
+    if (sscanf(lines[0].c_str(), "%255[^\t]\t%d\t%lld\t%lld", worker,
+               &progress.chunks_done, &images, &updated) != 4) {
+      continue;
+    }
+    progress.worker = worker;
+    progress.images_written = images;
+    progress.updated = updated;
+    result.push_back(progress);
+  }
+  std::sort(result.begin(), result.end(),
+            [](const ShardProgress &a, const ShardProgress &b) {
+              return a.worker < b.worker;
+            });
+  return result;
+}
+
+ShardWorker::ShardWorker(std::string dir, std::string worker_id,
+                         int chunk_count, int shard_index, int shard_count,
+                         double lease_timeout)
+    : dir_(std::move(dir)), worker_id_(std::move(worker_id)),
+      chunk_count_(chunk_count), shard_index_(shard_index),
+      shard_count_(shard_count), lease_timeout_(lease_timeout) {
+  std::error_code error;
+  fs::create_directories(dir_, error);
+  if (shard_count_ == 0) {
+    // 各 worker 从不同位置开始认领，减少对同一分块的争用。
+    next_ = chunk_count_ > 0
+                ? (int)(std::hash<std::string>()(worker_id_) % chunk_count_)
+                : 0;
+  }
+}
+
+ShardWorker::~ShardWorker() {
+  for (auto &entry : held_) {
+    if (entry.second.log) {
+      fclose(entry.second.log);
+    }
+  }
+}
+
+bool ShardWorker::eligible(int chunk) const {
+  return shard_count_ == 0 || chunk % shard_count_ == shard_index_;
+}
+
+bool ShardWorker::is_done(int chunk) {
+  if (done_.count(chunk)) {
+    return true;
+  }
+  std::error_code error;
+  if (fs::exists(chunk_file(dir_, chunk, "done", -1), error)) {
+    done_.insert(chunk);
+    return true;
+  }
+  return false;
+}
+
+bool ShardWorker::try_claim(int chunk, int generation) {
+  if (!create_exclusive(chunk_file(dir_, chunk, "lease", generation),
+                        worker_id_ + "\n")) {
+    return false;
+  }
+  // 认领与上一代持有者完成之间存在竞争：已完成则放弃租约。
+  std::error_code error;
+  if (is_done(chunk)) {
+    fs::remove(chunk_file(dir_, chunk, "lease", generation), error);
+    return false;
+  }
+  Held held;
+  held.generation = generation;
+  held_[chunk] = std::move(held);
+  observed_.erase(chunk);
+  return true;
+}
+
+int ShardWorker::claim_next(double now) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int step = 0; step < chunk_count_; step++) {
+    int chunk = (next_ + step) % chunk_count_;
+    if (!eligible(chunk) || held_.count(chunk) || is_done(chunk)) {
+      continue;
+    }
+    int generation = current_generation(dir_, chunk);
+    bool claimed = false;
+    if (generation < 0) {
+      claimed = try_claim(chunk, 0);
+    } else {
+      std::string lease = chunk_file(dir_, chunk, "lease", generation);
+      std::vector<std::string> owner = read_lines(lease);
+      int64_t stamp = modified_stamp(lease);
+      Observed &seen = observed_[chunk];
+      if (!owner.empty() && owner[0] == worker_id_) {
+        // 同一标识的 worker 重启后直接接管。
+        claimed = try_claim(chunk, generation + 1);
+      } else if (seen.generation != generation || seen.stamp != stamp) {
+        seen.generation = generation;
+        seen.stamp = stamp;
+        seen.since = now;
+      } else if (now - seen.since >= lease_timeout_) {
+        claimed = try_claim(chunk, generation + 1);
+      }
+    }
+    if (claimed) {
+      next_ = (chunk + 1) % chunk_count_;
+      return chunk;
+    }
+  }
+  return -1;
+}
+
+bool ShardWorker::exhausted() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  for (int chunk = 0; chunk < chunk_count_; chunk++) {
+    if (eligible(chunk) && !held_.count(chunk) && !is_done(chunk)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+std::vector<int> ShardWorker::start_chunk(
+    int chunk, const std::vector<std::string> &names) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int> todo;
+  auto it = held_.find(chunk);
+  if (it == held_.end()) {
+    return todo;
+  }
+  Held &held = it->second;
+  // 先前各代持有者写出的图片不再重做（追加模式不会重复追加）。
+  std::set<std::string> written;
+  for (int generation = 0; generation < held.generation; generation++) {
+    for (auto &name : read_lines(chunk_file(dir_, chunk, "log", generation))) {
+      written.insert(std::move(name));
+    }
+  }
+  for (int i = 0; i < (int)names.size(); i++) {
+    if (written.count(names[i])) {
+      held.names.push_back(names[i]);
+    } else {
+      todo.push_back(i);
+    }
+  }
+  held.remaining = (int)todo.size();
+  if (todo.empty()) {
+    complete(chunk, &held);
+    held_.erase(chunk);
+    return todo;
+  }
+  held.log = fopen(chunk_file(dir_, chunk, "log", held.generation).c_str(),
+                   "a");
+  return todo;
+}
+
+void ShardWorker::finish_image(int chunk, const std::string &name,
+                               bool written) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = held_.find(chunk);
+  if (it == held_.end()) {
+    return;
+  }
+  Held &held = it->second;
+  if (written) {
+    held.names.push_back(name);
+    images_written_++;
+    if (held.log) {
+      fprintf(held.log, "%s\n", name.c_str());
+      fflush(held.log);
+    }
+  }
+  if (--held.remaining <= 0) {
+    complete(chunk, &held);
+    held_.erase(it);
+  }
+}
+
+void ShardWorker::complete(int chunk, Held *held) {
+  std::string content;
+  for (const auto &name : held->names) {
+    content += name + "\n";
+  }
+  if (write_file_atomic(chunk_file(dir_, chunk, "done", -1), content)) {
+    done_.insert(chunk);
+    chunks_done_++;
+  }
+  release(held);
+  // done 已写出，各代租约与进度日志不再需要。
+  std::error_code error;
+  for (int generation = 0; generation < held->generation; generation++) {
+    fs::remove(chunk_file(dir_, chunk, "lease", generation), error);
+    fs::remove(chunk_file(dir_, chunk, "log", generation), error);
+  }
+  fs::remove(chunk_file(dir_, chunk, "lease", held->generation), error);
+  fs::remove(chunk_file(dir_, chunk, "log", held->generation), error);
+}
+
+void ShardWorker::release(Held *held) {
+  if (held->log) {
+    fclose(held->log);
+    held->log = nullptr;
+  }
+}
+
+bool ShardWorker::holds(int chunk) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return held_.count(chunk) != 0;
+}
+
+std::vector<int> ShardWorker::heartbeat() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<int> lost;
+  for (auto it = held_.begin(); it != held_.end();) {
+    int chunk = it->first;
+    Held &held = it->second;
+    std::string lease = chunk_file(dir_, chunk, "lease", held.generation);
+    std::error_code error;
+    bool taken = fs::exists(
+        chunk_file(dir_, chunk, "lease", held.generation + 1), error);
+    if (!taken) {
+      fs::last_write_time(lease, fs::file_time_type::clock::now(), error);
+      taken = (bool)error;
+    }
+    if (taken) {
+      lost.push_back(chunk);
+      release(&held);
+      it = held_.erase(it);
+    } else {
+      ++it;
+    }
+  }
+  std::string content = worker_id_ + "\t" + std::to_string(chunks_done_) +
+                        "\t" + std::to_string(images_written_) + "\t" +
+                        std::to_string((int64_t)time(nullptr)) + "\n";
+  write_file_atomic(
+      (fs::path(dir_) /
+       ("worker_" + sanitize_worker_id(worker_id_) + ".progress"))
+          .string(),
+      content);
+  return lost;
+}
+
+int ShardWorker::chunks_done() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return chunks_done_;
+}
+
+int64_t ShardWorker::images_written() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return images_written_;
+}
+
+} // namespace label_load_cli
@@ -0,0 +1,347 @@
+/**
+ * 无界面自动标注工具的可测试逻辑
+ *
+ * 项目配置读取（projects.json）、YOLO 标签文件的解析与合并、图片解码、
+ * 续跑记录与多进程分片协调。标签文件的读写语义与应用内
+ * BatchInferenceService + FileService.writeLabels 保持一致，同一目录可交替
+ * 使用 GUI 与命令行标注。
+ */
+#ifndef LABEL_LOAD_CLI_UTILS_H
+#define LABEL_LOAD_CLI_UTILS_H
+
+#include "onnx_inference.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace label_load_cli {
+
+// ============================================================================
+// JSON
+// ============================================================================
+
+/// 最小 JSON 值（仅用于读取 projects.json）。
+struct JsonValue {
+  enum Type { kNull, kBool, kNumber, kString, kArray, kObject };
+  Type type = kNull;
+  bool boolean = false;
+  double number = 0;
+  std::string string;
+  std::vector<JsonValue> items;
+  std::vector<std::pair<std::string, JsonValue>> fields;
+
+  /// 查找对象字段，不存在或非对象返回 nullptr。
+  const JsonValue *get(const char *key) const;
+};
+
+/// 解析 JSON 文本，失败时 error 给出出错位置。
+bool parse_json(const std::string &text, JsonValue *out, std::string *error);
+
+// ============================================================================
+// 项目配置
+// ============================================================================
+
+/// 与应用 LabelType 的序号一致。
+enum LabelType { kLabelBox = 0, kLabelBoxWithPoint = 1, kLabelPolygon = 2 };
+
+/// 与应用 LabelSaveMode 的序号一致。
+enum LabelSaveMode { kSaveAppend = 0, kSaveOverwrite = 1 };
+
+/// 标注任务配置，字段与默认值对应 ProjectConfig 与 AiConfig。
+struct ProjectSettings {
+  std::string name;
+  std::string image_dir;
+  std::string label_dir;
+  std::string model_path;
+  int model_type = MODEL_TYPE_YOLO;
+  double conf_threshold = 0.25;
+  double nms_threshold = 0.45;
+  int num_keypoints = 0;
+  int save_mode = kSaveAppend;
+  int class_id_offset = 0; // 仅追加模式生效
+  std::vector<std::pair<int, int>> label_types; // (class_id, LabelType)
+};
+
+/// 应用默认的 projects.json 路径（文档目录/LabelLoad/projects.json）。
+std::string default_projects_path();
+
+/// 从 projects.json 读取 id 或名称为 key 的项目。
+bool load_project(const std::string &projects_path, const std::string &key,
+                  ProjectSettings *out, std::string *error);
+
+/// 按类别 ID 查找标签类型，未定义返回 fallback。
+int label_type_for_class(const ProjectSettings &settings, int class_id,
+                         int fallback);
+
+// ============================================================================
+// YOLO 标签
+// ============================================================================
+
+struct LabelPoint {
+  double x = 0;
+  double y = 0;
+  int visibility = 2;
+};
+
+/// 对应应用 Label 的文件级字段（坐标均为归一化值）。
+struct YoloLabel {
+  int class_id = 0;
+  double x = 0;
+  double y = 0;
+  double width = 0;
+  double height = 0;
+  std::vector<LabelPoint> points;
+  std::vector<std::string> extra; // 未解析的尾部字段，原样保留
+  bool polygon = false; // 点来自检测轮廓（不写入文件，同 Label.pointsArePolygon）
+};
+
+/// 检测结果转标签（同 InferenceLabelMapper.fromDetections）。
+YoloLabel label_from_detection(const Detection &det);
+
+/// 按类型解析一行（同 Label.fromYoloLine），失败返回 false。
+bool parse_yolo_line(const std::string &line, int type, YoloLabel *out);
+
+/// 格式化为一行（同 Label.toYoloLine）。
+std::string format_yolo_line(const YoloLabel &label, bool is_polygon);
+
+/// 为未定义的类别补充类型（同 AiPostProcessor.fillMissingDefinitions）。
+/// 点来自检测轮廓的类别记为多边形，其余带点的类别记为边界框 + 关键点，
+/// 否则为纯边界框。
+/// @return 新增的类别 ID
+std::vector<int> fill_missing_label_types(const std::vector<YoloLabel> &labels,
+                                          ProjectSettings *settings);
+
+/// 由已有文件内容与新标签生成写入内容。
+///
+/// 依次执行类别偏移（仅追加模式）、按类型清理、补充未定义类别、读取已有
+/// 标签；追加模式下已有标签在前，覆盖模式仅保留无法解析的行。
+/// @param existing 已有文件内容，文件不存在时为 nullptr
+/// @param settings 未定义的类别会被补充到 label_types
+std::string merge_label_file(const std::string *existing,
+                             std::vector<YoloLabel> labels,
+                             ProjectSettings *settings);
+
+// ============================================================================
+// 图片与文件
+// ============================================================================
+
+/// 解码后的 RGBA 图片。
+struct RgbaImage {
+  int width = 0;
+  int height = 0;
+  std::vector<uint8_t> rgba;
+};
+
+/// 当前构建可解码的扩展名（小写，含点）。
+const std::vector<std::string> &decodable_extensions();
+
+/// 列出目录下可解码的图片（不递归），按路径排序。
+/// @param skipped 输出：扩展名受应用支持但当前构建无法解码的文件数
+std::vector<std::string> list_images(const std::string &dir, int *skipped);
+
+/// 解码图片为 RGBA。
+bool decode_image(const std::string &path, RgbaImage *out, std::string *error);
+
+/// 原子写入文本文件（临时文件 + 重命名）。
+bool write_file_atomic(const std::string &path, const std::string &content);
+
+/// 读取整个文件，不存在返回 false。
+bool read_file(const std::string &path, std::string *out);
+
+/// 读取续跑记录（每行一个已完成的图片文件名）。
+std::set<std::string> read_journal(const std::string &path);
+
+// ============================================================================
+// 视频抽帧
+// ============================================================================
+
+/// 应用支持的视频扩展名（同 supportedVideoExtensions）。
+const std::vector<std::string> &video_extensions();
+
+/// 列出视频：path 为文件时返回自身，为目录时列出其中的视频（不递归），
+/// 按路径排序。
+std::vector<std::string> list_videos(const std::string &path);
+
+/// 抽帧策略：fps > 0 时按时间戳均匀采样，否则每 stride 帧取一帧。
+class FrameSampler {
+public:
+  FrameSampler(int stride, double fps);
+
+  /// 按解码顺序判断帧是否保留。
+  /// @param seconds 帧的显示时间（秒）
+  bool accept(double seconds);
+
+  /// 开始下一个视频。
+  void reset();
+
+private:
+  int stride_;
+  double interval_;
+  int64_t count_ = 0;
+  double next_ = 0;
+};
+
+/// 抽出帧的文件名：<视频名>_<帧序号，至少 6 位>.<format>。
+std::string frame_file_name(const std::string &video_path, int64_t frame,
+                            const std::string &format);
+
+/// 当前构建可写出的帧格式，首个为默认（jpg 需要 stb_image_write）。
+const std::vector<std::string> &frame_formats();
+
+/// 按格式编码帧图片；bmp 为 24 位无压缩，不依赖第三方库。
+bool encode_frame(const RgbaImage &image, const std::string &format,
+                  std::string *out);
+
+// ============================================================================
+// 分片任务
+// ============================================================================
+//
+// 多台机器挂载同一数据集目录时，各 worker 通过标签目录下的
+// .label_load_shards 协调：排序后的图片列表按固定大小切成分块，worker
+// 以独占创建租约文件的方式认领分块，逐张记录进度，完成后写出 done 文件。
+// 所有协调都基于文件系统的原子操作（独占创建、硬链接、重命名），NFS 可用。
+//
+//   plan                    分片计划（分块大小、图片数、列表哈希）
+//   chunk_<c>.lease.<g>     第 g 代租约，内容为持有者标识；心跳刷新修改时间
+//   chunk_<c>.log.<g>       第 g 代持有者已写出的图片文件名
+//   chunk_<c>.done          分块完成记录（已写出的图片文件名）
+//   worker_<id>.progress    各 worker 的进度
+
+/// 标签目录下的分片目录。
+std::string shard_dir(const std::string &label_dir);
+
+/// 解析 "i/N"（0 <= i < N）。
+bool parse_shard_spec(const std::string &text, int *index, int *count);
+
+/// 默认 worker 标识（主机名-进程号）。
+std::string default_worker_id();
+
+/// 分片计划，参与同一任务的 worker 必须一致。
+struct ShardPlan {
+  int chunk_size = 64;
+  int64_t image_count = 0;
+  uint64_t list_hash = 0; // 图片文件名列表的 FNV-1a
+
+  int chunk_count() const;
+};
+
+/// 由排序后的图片列表生成计划。
+ShardPlan make_shard_plan(const std::vector<std::string> &images,
+                          int chunk_size);
+
+/// 首个 worker 原子创建计划文件，其余 worker 读取并校验一致。
+bool open_shard_plan(const std::string &dir, const ShardPlan &plan,
+                     std::string *error);
+
+/// 读取计划文件，不存在或损坏返回 false。
+bool read_shard_plan(const std::string &dir, ShardPlan *out);
+
+/// 覆盖检查结果。
+struct ShardCoverage {
+  int chunks_total = 0;
+  int chunks_done = 0;
+  std::vector<std::string> written; // 已写出标签的图片文件名
+  std::vector<std::string> missing; // 未写出标签的图片文件名
+};
+
+/// 核对各分块的完成记录是否覆盖全部图片。
+ShardCoverage verify_shard_coverage(const std::string &dir,
+                                    const std::vector<std::string> &images,
+                                    const ShardPlan &plan);
+
+/// 单个 worker 最近一次心跳写出的进度。
+struct ShardProgress {
+  std::string worker;
+  int chunks_done = 0;
+  int64_t images_written = 0;
+  int64_t updated = 0; // Unix 时间（秒）
+};
+
+/// 读取全部 worker 的进度，按标识排序。
+std::vector<ShardProgress> read_shard_progress(const std::string &dir);
+
+/// 分片 worker（线程安全）
+///
+/// 租约是否过期由本地单调时钟观察：租约的代数与修改时间在 lease_timeout
+/// 秒内没有变化即视为持有者失联，可创建下一代租约接管，不依赖各机器时钟
+/// 一致。被接管的旧持有者在下次心跳时发现更高代租约并放弃该分块。以相同
+/// 标识重启的 worker 直接接管自己遗留的租约。
+class ShardWorker {
+public:
+  /// @param shard_count 0 表示认领任意分块，否则只处理
+  ///        chunk % shard_count == shard_index 的分块
+  ShardWorker(std::string dir, std::string worker_id, int chunk_count,
+              int shard_index, int shard_count, double lease_timeout);
+  ~ShardWorker();
+
+  ShardWorker(const ShardWorker &) = delete;
+  ShardWorker &operator=(const ShardWorker &) = delete;
+
+  /// 认领下一个分块，暂无可认领的分块返回 -1。
+  /// @param now 本地单调时钟（秒），用于判断租约过期
+  int claim_next(double now);
+
+  /// 负责的分块是否都已完成或由本 worker 持有（无需再等待其他 worker）。
+  bool exhausted();
+
+  /// 开始处理已认领的分块，跳过先前持有者已写出的图片。
+  /// @param names 分块内图片文件名（按计划顺序）
+  /// @return 仍需处理的图片在 names 中的位置；为空时分块已直接完成
+  std::vector<int> start_chunk(int chunk, const std::vector<std::string> &names);
+
+  /// 一张图片处理结束；分块内全部结束后写出 done 文件并释放租约。
+  void finish_image(int chunk, const std::string &name, bool written);
+
+  /// 本 worker 是否仍持有分块的租约。
+  bool holds(int chunk);
+
+  /// 刷新持有的租约并写出进度。
+  /// @return 本次发现已被其他 worker 接管的分块
+  std::vector<int> heartbeat();
+
+  int chunks_done();
+  int64_t images_written();
+
+private:
+  struct Held {
+    int generation = 0;
+    FILE *log = nullptr;
+    int remaining = 0;
+    std::vector<std::string> names; // 已写出（含先前持有者）
+  };
+  struct Observed {
+    int generation = -1;
+    int64_t stamp = 0;
+    double since = 0;
+  };
+
+  bool eligible(int chunk) const;
+  bool is_done(int chunk);
+  bool try_claim(int chunk, int generation);
+  void complete(int chunk, Held *held);
+  void release(Held *held);
+
+  std::string dir_;
+  std::string worker_id_;
+  int chunk_count_;
+  int shard_index_;
+  int shard_count_;
+  double lease_timeout_;
+  std::mutex mutex_;
+  std::map<int, Held> held_;
+  std::map<int, Observed> observed_;
+  std::set<int> done_;
+  int next_ = 0;
+  int chunks_done_ = 0;
+  int64_t images_written_ = 0;
+};
+
+} // namespace label_load_cli
+
+#endif // LABEL_LOAD_CLI_UTILS_H
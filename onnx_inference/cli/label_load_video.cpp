@@ -0,0 +1,209 @@
+/**
+ * 视频解码实现
+ */
+#include "label_load_video.h"
+
+#ifdef LABEL_LOAD_CLI_HAVE_LIBAV
+extern "C" {
+#include <libavcodec/avcodec.h>
+#include <libavformat/avformat.h>
+#include <libavutil/error.h>
+#include <libswscale/swscale.h>
+}
+#endif
+
+namespace label_load_cli {
+
+#ifdef LABEL_LOAD_CLI_HAVE_LIBAV
+
+namespace {
+
+std::string av_error_text(int code) {
+  char buffer[AV_ERROR_MAX_STRING_SIZE] = {0};
+  av_strerror(code, buffer, sizeof(buffer));
+  return buffer;
+}
+
+} // namespace
+
+struct VideoReader::State {
+  AVFormatContext *format = nullptr;
+  AVCodecContext *codec = nullptr;
+  SwsContext *sws = nullptr;
+  AVPacket *packet = nullptr;
+  AVFrame *frame = nullptr;
+  int stream = -1;
+  double time_base = 0;
+  double frame_rate = 0;
+  int64_t start_pts = 0;
+  int64_t decoded = 0;
+  bool flushing = false;
+
+  ~State() {
+    sws_freeContext(sws);
+    av_frame_free(&frame);
+    av_packet_free(&packet);
+    avcodec_free_context(&codec);
+    avformat_close_input(&format);
+  }
+};
+
+VideoReader::VideoReader() : state_(new State()) {}
+
+VideoReader::~VideoReader() = default;
+
+bool VideoReader::available() { return true; }
+
+std::unique_ptr<VideoReader> VideoReader::open(const std::string &path,
+                                               std::string *error) {
+  std::unique_ptr<VideoReader> reader(new VideoReader());
+  State &s = *reader->state_;
+  int ret = avformat_open_input(&s.format, path.c_str(), nullptr, nullptr);
+  if (ret < 0) {
+    *error = "无法打开视频: " + av_error_text(ret);
+    return nullptr;
+  }
+  ret = avformat_find_stream_info(s.format, nullptr);
+  if (ret < 0) {
+    *error = "无法读取流信息: " + av_error_text(ret);
+    return nullptr;
+  }
+  s.stream =
+      av_find_best_stream(s.format, AVMEDIA_TYPE_VIDEO, -1, -1, nullptr, 0);
+  if (s.stream < 0) {
+    *error = "没有视频流";
+    return nullptr;
+  }
+  AVStream *stream = s.format->streams[s.stream];
+  const AVCodec *decoder = avcodec_find_decoder(stream->codecpar->codec_id);
+  if (!decoder) {
+    *error = "不支持的视频编码";
+    return nullptr;
+  }
+  s.codec = avcodec_alloc_context3(decoder);
+  if (!s.codec ||
+      avcodec_parameters_to_context(s.codec, stream->codecpar) < 0) {
+    *error = "无法创建解码器";
+    return nullptr;
+  }
+  s.codec->thread_count = 0; // 由解码器按核数选择线程数
+  ret = avcodec_open2(s.codec, decoder, nullptr);
+  if (ret < 0) {
+    *error = "无法打开解码器: " + av_error_text(ret);
+    return nullptr;
+  }
+  s.time_base = av_q2d(stream->time_base);
+  if (stream->avg_frame_rate.den != 0) {
+    s.frame_rate = av_q2d(stream->avg_frame_rate);
+  }
+  s.start_pts = stream->start_time != AV_NOPTS_VALUE ? stream->start_time : 0;
+  s.packet = av_packet_alloc();
+  s.frame = av_frame_alloc();
+  if (!s.packet || !s.frame) {
+    *error = "内存不足";
+    return nullptr;
+  }
+  return reader;
+}
+
+bool VideoReader::next(int64_t *index, double *seconds, std::string *error) {
+  State &s = *state_;
+  error->clear();
+  av_frame_unref(s.frame);
+  while (true) {
+    int ret = avcodec_receive_frame(s.codec, s.frame);
+    if (ret == 0) {
+      int64_t pts = s.frame->best_effort_timestamp;
+      if (pts != AV_NOPTS_VALUE) {
+        *seconds = (double)(pts - s.start_pts) * s.time_base;
+      } else {
+        *seconds = s.frame_rate > 0 ? s.decoded / s.frame_rate : 0;
+      }
+      *index = s.decoded++;
+      return true;
+    }
+    if (ret == AVERROR_EOF) {
+      return false;
+    }
+    if (ret != AVERROR(EAGAIN) || s.flushing) {
+      *error = "解码失败: " + av_error_text(ret);
+      return false;
+    }
+    // 解码器需要更多数据：读取下一个本流的包，读完后进入冲刷。
+    ret = av_read_frame(s.format, s.packet);
+    if (ret < 0) {
+      avcodec_send_packet(s.codec, nullptr);
+      s.flushing = true;
+      continue;
+    }
+    if (s.packet->stream_index == s.stream) {
+      ret = avcodec_send_packet(s.codec, s.packet);
+      if (ret < 0 && ret != AVERROR_INVALIDDATA) {
+        av_packet_unref(s.packet);
+        *error = "解码失败: " + av_error_text(ret);
+        return false;
+      }
+    }
+    av_packet_unref(s.packet);
+  }
+}
+
+bool VideoReader::convert(RgbaImage *out, std::string *error) {
+  State &s = *state_;
+  int width = s.frame->width;
+  int height = s.frame->height;
+  if (width <= 0 || height <= 0) {
+    *error = "无效的帧尺寸";
+    return false;
+  }
+  s.sws = sws_getCachedContext(s.sws, width, height,
+                               (AVPixelFormat)s.frame->format, width, height,
+                               AV_PIX_FMT_RGBA, SWS_BILINEAR, nullptr, nullptr,
+                               nullptr);
+  if (!s.sws) {
+    *error = "不支持的像素格式";
+    return false;
+  }
+  out->width = width;
+  out->height = height;
+  out->rgba.resize((size_t)width * height * 4);
+  uint8_t *dst[4] = {out->rgba.data(), nullptr, nullptr, nullptr};
+  int dst_stride[4] = {width * 4, 0, 0, 0};
+  sws_scale(s.sws, (const uint8_t *const *)s.frame->data, s.frame->linesize,
+            0, height, dst, dst_stride);
+  return true;
+}
+
+#else // LABEL_LOAD_CLI_HAVE_LIBAV
+
+struct VideoReader::State {};
+
+VideoReader::VideoReader() : state_(new State()) {}
+
+VideoReader::~VideoReader() = default;
+
+bool VideoReader::available() { return false; }
+
+std::unique_ptr<VideoReader> VideoReader::open(const std::string &path,
+                                               std::string *error) {
+  (void)path;
+  *error = "当前构建不支持视频解码（需要 libavformat/libavcodec/libswscale）";
+  return nullptr;
+}
+
+bool VideoReader::next(int64_t *index, double *seconds, std::string *error) {
+  (void)index;
+  (void)seconds;
+  *error = "当前构建不支持视频解码";
+  return false;
+}
+
+bool VideoReader::convert(RgbaImage *out, std::string *error) {
+  (void)out;
+  *error = "当前构建不支持视频解码";
+  return false;
+}
+
+#endif // LABEL_LOAD_CLI_HAVE_LIBAV
+
+} // namespace label_load_cli
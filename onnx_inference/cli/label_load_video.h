@@ -0,0 +1,51 @@
+/**
+ * 视频解码（libavformat / libavcodec / libswscale）
+ *
+ * 按显示顺序逐帧解码，先返回帧序号与时间戳供抽帧判断，保留的帧再转换为
+ * RGBA，跳过的帧不做颜色转换。构建时未找到 FFmpeg 开发库则 open 总是失败。
+ */
+#ifndef LABEL_LOAD_VIDEO_H
+#define LABEL_LOAD_VIDEO_H
+
+#include "label_load_cli_utils.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace label_load_cli {
+
+class VideoReader {
+public:
+  ~VideoReader();
+
+  VideoReader(const VideoReader &) = delete;
+  VideoReader &operator=(const VideoReader &) = delete;
+
+  /// 当前构建是否支持视频解码。
+  static bool available();
+
+  /// 打开视频的第一个视频流，失败返回 nullptr。
+  static std::unique_ptr<VideoReader> open(const std::string &path,
+                                           std::string *error);
+
+  /// 解码下一帧。
+  /// @param index 输出：帧序号（从 0 开始）
+  /// @param seconds 输出：显示时间（秒，相对流起点）
+  /// @return 结束或出错返回 false，出错时 error 非空
+  bool next(int64_t *index, double *seconds, std::string *error);
+
+  /// 将最近一次 next 得到的帧转换为 RGBA。
+  bool convert(RgbaImage *out, std::string *error);
+
+private:
+  struct State;
+
+  VideoReader();
+
+  std::unique_ptr<State> state_;
+};
+
+} // namespace label_load_cli
+
+#endif // LABEL_LOAD_VIDEO_H
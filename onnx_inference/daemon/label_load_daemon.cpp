@@ -0,0 +1,164 @@
+/**
+ * LabelLoad 本地推理守护进程
+ *
+ * 常驻持有已加载的模型，多个应用实例或命令行工具经 Unix 域套接字共享同一
+ * 组会话；参数相同的并发请求合并为微批次，提高小批量请求的总吞吐。
+ *
+ * 用法: label_load_daemon [选项]
+ *   --socket PATH       套接字路径（默认 $XDG_RUNTIME_DIR/label_load.sock，
+ *                       否则 /tmp/label_load-<uid>.sock）
+ *   --max-batch N       每个微批次的最大图片数（默认 8）
+ *   --max-delay-us N    最早的请求最多等待的微秒数（默认 2000，0 为不等待）
+ *   --threads N         ORT 共享算子内线程数（0 为物理核数；缺省为每会话 4）
+ *   --socket-mode MODE  套接字文件权限（八进制，默认 600，仅当前用户）
+ *
+ * 收到 SIGINT / SIGTERM 时处理完已排队的请求后退出。
+ */
+#include "onnx_daemon_server.h"
+#include "onnx_inference.h"
+
+#include <csignal>
+#include <pthread.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace onnx_daemon;
+
+namespace {
+
+struct DaemonOptions {
+  DaemonServerOptions server;
+  int threads = -1;
+};
+
+void print_usage(const char *program) {
+  fprintf(stderr,
+          "用法: %s [--socket PATH] [--max-batch N] [--max-delay-us N] "
+          "[--threads N] [--socket-mode MODE]\n",
+          program);
+}
+
+bool parse_args(int argc, char **argv, DaemonOptions *options) {
+  options->server.socket_path = default_socket_path();
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    bool has_value = i + 1 < argc;
+    bool ok = true;
+    if (arg == "--socket" && has_value) {
+      options->server.socket_path = argv[++i];
+    } else if (arg == "--max-batch" && has_value) {
+      options->server.max_batch = atoi(argv[++i]);
+      ok = options->server.max_batch > 0;
+    } else if (arg == "--max-delay-us" && has_value) {
+      options->server.max_delay_us = atoll(argv[++i]);
+      ok = options->server.max_delay_us >= 0;
+    } else if (arg == "--threads" && has_value) {
+      options->threads = atoi(argv[++i]);
+      ok = options->threads >= 0;
+    } else if (arg == "--socket-mode" && has_value) {
+      options->server.socket_mode = (unsigned)strtoul(argv[++i], nullptr, 8);
+      ok = options->server.socket_mode <= 0777;
+    } else {
+      ok = false;
+    }
+    if (!ok) {
+      print_usage(argv[0]);
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  DaemonOptions options;
+  if (!parse_args(argc, argv, &options)) {
+    return 2;
+  }
+
+  // 在创建任何线程（含 ORT 线程池）前屏蔽信号，由主线程同步等待。
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  signal(SIGPIPE, SIG_IGN);
+
+  OnnxInitOptions init_options;
+  onnx_default_init_options(&init_options);
+  if (options.threads >= 0) {
+    init_options.use_global_thread_pools = true;
+    init_options.intra_op_threads = options.threads;
+  }
+  if (!onnx_init_with_options(&init_options)) {
+    fprintf(stderr, "初始化失败: %s\n", onnx_get_last_error());
+    return 1;
+  }
+
+  // 模型 ID 即句柄下标；模型在守护进程生命周期内常驻。
+  std::vector<ModelHandle> models;
+  DaemonBackend backend;
+  backend.load_model = [&models](const std::string &path, bool use_gpu,
+                                 int32_t *model_id, std::string *error) {
+    ModelHandle handle = onnx_load_model(path.c_str(), use_gpu);
+    if (!handle) {
+      *error = onnx_get_last_error();
+      return onnx_get_last_error_code();
+    }
+    fprintf(stderr, "已加载模型 #%zu: %s%s\n", models.size(), path.c_str(),
+            use_gpu ? "（GPU）" : "");
+    *model_id = (int32_t)models.size();
+    models.push_back(handle);
+    return (int)ONNX_OK;
+  };
+  backend.detect_batch = [&models](const DetectParams &params, int num_images,
+                                   const uint8_t **images, const int *widths,
+                                   const int *heights,
+                                   std::vector<std::string> *results,
+                                   std::string *error) {
+    BatchDetectionResult *batch = onnx_detect_batch(
+        models[(size_t)params.model_id], images, num_images,
+        const_cast<int *>(widths), const_cast<int *>(heights),
+        params.conf_threshold, params.nms_threshold, params.model_type,
+        params.num_keypoints);
+    if (!batch) {
+      *error = onnx_get_last_error();
+      return onnx_get_last_error_code();
+    }
+    results->assign((size_t)num_images, std::string());
+    for (int i = 0; i < num_images && i < batch->num_images; i++) {
+      encode_detections(batch->results[i].detections, batch->results[i].count,
+                        &(*results)[(size_t)i]);
+    }
+    onnx_free_batch_result(batch);
+    return (int)ONNX_OK;
+  };
+
+  DaemonServer server(options.server, backend);
+  std::string error;
+  if (!server.start(&error)) {
+    fprintf(stderr, "启动失败: %s\n", error.c_str());
+    onnx_cleanup();
+    return 1;
+  }
+  fprintf(stderr, "监听 %s（微批次 %d 张，最长等待 %lld us）\n",
+          options.server.socket_path.c_str(), options.server.max_batch,
+          (long long)options.server.max_delay_us);
+
+  int received = 0;
+  sigwait(&signals, &received);
+  server.stop();
+
+  DaemonStats stats = server.stats();
+  fprintf(stderr, "已退出: %lld 个请求，%lld 张图片，%lld 个批次\n",
+          (long long)stats.requests, (long long)stats.images,
+          (long long)stats.batches);
+  for (ModelHandle handle : models) {
+    onnx_unload_model(handle);
+  }
+  onnx_cleanup();
+  return 0;
+}
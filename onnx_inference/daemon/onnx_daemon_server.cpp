@@ -0,0 +1,403 @@
+/**
+ * 本地推理守护进程服务端实现
+ */
+#include "onnx_daemon_server.h"
+
+#ifdef ONNX_DAEMON_SUPPORTED
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace onnx_daemon {
+
+using Clock = std::chrono::steady_clock;
+
+struct DaemonServer::Connection {
+  int fd = -1;
+  std::thread thread;
+  std::atomic<bool> finished{false};
+};
+
+/// 排队中的推理请求；图片指针指向连接映射的共享内存，连接线程在请求
+/// 完成前阻塞，因此映射在此期间保持有效。
+struct DaemonServer::PendingRequest {
+  DetectParams params;
+  std::vector<const uint8_t *> images;
+  std::vector<int> widths;
+  std::vector<int> heights;
+  Clock::time_point enqueued;
+
+  std::mutex mutex;
+  std::condition_variable cv;
+  bool done = false;
+  int status = ONNX_OK;
+  std::string reply; // 成功时为编码结果，失败时为错误信息
+};
+
+namespace {
+
+struct Mapping {
+  const uint8_t *data = nullptr;
+  size_t size = 0;
+  std::string error; // 最近一次附加被拒绝的原因
+
+  void reset() {
+    if (data) {
+      munmap((void *)data, size);
+    }
+    data = nullptr;
+    size = 0;
+    error.clear();
+  }
+};
+
+bool reply_error(int fd, int status, const std::string &message) {
+  return send_message(fd, kReply, status, message.data(), message.size());
+}
+
+} // namespace
+
+DaemonServer::DaemonServer(DaemonServerOptions options, DaemonBackend backend)
+    : options_(std::move(options)), backend_(std::move(backend)) {
+  options_.max_batch = std::max(1, options_.max_batch);
+  options_.max_delay_us = std::max<int64_t>(0, options_.max_delay_us);
+}
+
+DaemonServer::~DaemonServer() { stop(); }
+
+bool DaemonServer::start(std::string *error) {
+  if (running_) {
+    return true;
+  }
+  listen_fd_ = listen_socket(options_.socket_path, options_.socket_mode, error);
+  if (listen_fd_ < 0) {
+    return false;
+  }
+  running_ = true;
+  dispatch_stop_ = false;
+  dispatch_thread_ = std::thread(&DaemonServer::dispatch_loop, this);
+  accept_thread_ = std::thread(&DaemonServer::accept_loop, this);
+  return true;
+}
+
+void DaemonServer::stop() {
+  if (!running_.exchange(false)) {
+    return;
+  }
+  accept_thread_.join();
+  close(listen_fd_);
+  listen_fd_ = -1;
+  unlink(options_.socket_path.c_str());
+
+  // 关闭读端使连接线程退出；等待中的请求仍由调度线程完成。
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto &connection : connections_) {
+      shutdown(connection->fd, SHUT_RDWR);
+    }
+  }
+  reap_connections(true);
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex_);
+    dispatch_stop_ = true;
+  }
+  queue_cv_.notify_all();
+  dispatch_thread_.join();
+}
+
+DaemonStats DaemonServer::stats() const {
+  DaemonStats stats;
+  stats.requests = requests_;
+  stats.images = images_;
+  stats.batches = batches_;
+  return stats;
+}
+
+void DaemonServer::reap_connections(bool all) {
+  std::list<std::unique_ptr<Connection>> finished;
+  {
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    for (auto it = connections_.begin(); it != connections_.end();) {
+      if (all || (*it)->finished) {
+        finished.push_back(std::move(*it));
+        it = connections_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+  }
+  for (auto &connection : finished) {
+    connection->thread.join();
+    close(connection->fd);
+  }
+}
+
+void DaemonServer::accept_loop() {
+  while (running_) {
+    pollfd pfd{listen_fd_, POLLIN, 0};
+    int ready = poll(&pfd, 1, 100);
+    reap_connections(false);
+    if (ready <= 0 || !running_) {
+      continue;
+    }
+    int fd = accept(listen_fd_, nullptr, nullptr);
+    if (fd < 0) {
+      continue;
+    }
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#endif
+    auto connection = std::make_unique<Connection>();
+    connection->fd = fd;
+    Connection *raw = connection.get();
+    std::lock_guard<std::mutex> lock(connections_mutex_);
+    connections_.push_back(std::move(connection));
+    raw->thread = std::thread(&DaemonServer::serve, this, raw);
+  }
+}
+
+int DaemonServer::load_model(const std::string &payload, int32_t *model_id,
+                             std::string *error) {
+  if (payload.size() < 2) {
+    *error = "缺少模型路径";
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  bool use_gpu = payload[0] != 0;
+  std::string path = payload.substr(1);
+  std::string key = std::string(use_gpu ? "gpu:" : "cpu:") + path;
+
+  std::lock_guard<std::mutex> lock(models_mutex_);
+  auto it = models_.find(key);
+  if (it != models_.end()) {
+    *model_id = it->second;
+    return ONNX_OK;
+  }
+  int status = backend_.load_model(path, use_gpu, model_id, error);
+  if (status == ONNX_OK) {
+    models_[key] = *model_id;
+    model_ids_.insert(*model_id);
+  }
+  return status;
+}
+
+void DaemonServer::serve(Connection *connection) {
+  int fd = connection->fd;
+  Mapping mapping;
+  MessageHeader header;
+  std::string payload;
+  int received_fd = -1;
+  while (recv_message(fd, &header, &payload, &received_fd)) {
+    if (header.type == kAttachMemory) {
+      // 无应答；校验或映射失败时后续 DETECT 报错。
+      mapping.reset();
+      uint64_t size = 0;
+      if (received_fd >= 0 && payload.size() == sizeof(size)) {
+        memcpy(&size, payload.data(), sizeof(size));
+        void *data = check_shared_memory(received_fd, size, &mapping.error)
+                         ? mmap(nullptr, (size_t)size, PROT_READ, MAP_SHARED,
+                                received_fd, 0)
+                         : MAP_FAILED;
+        if (data != MAP_FAILED) {
+          mapping.data = (const uint8_t *)data;
+          mapping.size = (size_t)size;
+        }
+      }
+      if (received_fd >= 0) {
+        close(received_fd);
+      }
+      continue;
+    }
+    if (received_fd >= 0) {
+      close(received_fd);
+    }
+
+    if (header.type == kLoadModel) {
+      int32_t model_id = -1;
+      std::string error;
+      int status = load_model(payload, &model_id, &error);
+      bool sent = status == ONNX_OK
+                      ? send_message(fd, kReply, ONNX_OK, &model_id,
+                                     sizeof(model_id))
+                      : reply_error(fd, status, error);
+      if (!sent) {
+        break;
+      }
+      continue;
+    }
+
+    if (header.type != kDetect) {
+      if (!reply_error(fd, ONNX_ERROR_INVALID_ARGUMENT, "未知的消息类型")) {
+        break;
+      }
+      continue;
+    }
+
+    // 校验请求：图片必须完整落在已映射的共享内存内。
+    DetectRequest request;
+    std::string error;
+    if (payload.size() < sizeof(request)) {
+      error = "请求格式错误";
+    } else {
+      memcpy(&request, payload.data(), sizeof(request));
+      if (request.num_images <= 0 || request.num_images > kMaxImages ||
+          payload.size() != sizeof(request) + (size_t)request.num_images *
+                                                  sizeof(ImageRef)) {
+        error = "请求格式错误";
+      } else if (!mapping.data) {
+        error = mapping.error.empty() ? "未附加共享内存"
+                                      : "共享内存被拒绝: " + mapping.error;
+      } else {
+        std::lock_guard<std::mutex> lock(models_mutex_);
+        if (!model_ids_.count(request.model_id)) {
+          error = "未知的模型 ID: " + std::to_string(request.model_id);
+        }
+      }
+    }
+    auto pending = std::make_shared<PendingRequest>();
+    if (error.empty()) {
+      pending->params.model_id = request.model_id;
+      pending->params.conf_threshold = request.conf_threshold;
+      pending->params.nms_threshold = request.nms_threshold;
+      pending->params.model_type = request.model_type;
+      pending->params.num_keypoints = request.num_keypoints;
+      const char *refs = payload.data() + sizeof(request);
+      for (int i = 0; i < request.num_images && error.empty(); i++) {
+        ImageRef ref;
+        memcpy(&ref, refs + (size_t)i * sizeof(ref), sizeof(ref));
+        uint64_t bytes = ref.width > 0 && ref.height > 0 &&
+                                 ref.width <= 65536 && ref.height <= 65536
+                             ? (uint64_t)ref.width * (uint64_t)ref.height * 4
+                             : 0;
+        if (bytes == 0 || ref.offset > mapping.size ||
+            bytes > mapping.size - ref.offset) {
+          error = "第 " + std::to_string(i) + " 张图片越界";
+          break;
+        }
+        pending->images.push_back(mapping.data + ref.offset);
+        pending->widths.push_back(ref.width);
+        pending->heights.push_back(ref.height);
+      }
+    }
+    if (!error.empty()) {
+      if (!reply_error(fd, ONNX_ERROR_INVALID_ARGUMENT, error)) {
+        break;
+      }
+      continue;
+    }
+
+    pending->enqueued = Clock::now();
+    {
+      std::lock_guard<std::mutex> lock(queue_mutex_);
+      queue_.push_back(pending);
+    }
+    queue_cv_.notify_all();
+    {
+      std::unique_lock<std::mutex> lock(pending->mutex);
+      pending->cv.wait(lock, [&] { return pending->done; });
+    }
+    if (!send_message(fd, kReply, pending->status, pending->reply.data(),
+                      pending->reply.size())) {
+      break;
+    }
+  }
+  if (received_fd >= 0) {
+    close(received_fd);
+  }
+  mapping.reset();
+  connection->finished = true;
+}
+
+void DaemonServer::dispatch_loop() {
+  const auto max_delay = std::chrono::microseconds(options_.max_delay_us);
+  std::unique_lock<std::mutex> lock(queue_mutex_);
+  while (true) {
+    queue_cv_.wait(lock, [this] { return !queue_.empty() || dispatch_stop_; });
+    if (queue_.empty()) {
+      return;
+    }
+    // 以最早的请求为准，合并参数相同的请求。
+    const DetectParams params = queue_.front()->params;
+    const Clock::time_point deadline = queue_.front()->enqueued + max_delay;
+    int queued_images = 0;
+    for (const auto &request : queue_) {
+      if (request->params == params) {
+        queued_images += (int)request->images.size();
+      }
+    }
+    if (queued_images < options_.max_batch && !dispatch_stop_ &&
+        Clock::now() < deadline) {
+      queue_cv_.wait_until(lock, deadline);
+      continue;
+    }
+
+    std::vector<std::shared_ptr<PendingRequest>> batch;
+    int batch_images = 0;
+    for (auto it = queue_.begin(); it != queue_.end();) {
+      if ((*it)->params == params &&
+          (batch.empty() ||
+           batch_images + (int)(*it)->images.size() <= options_.max_batch)) {
+        batch_images += (int)(*it)->images.size();
+        batch.push_back(*it);
+        it = queue_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    lock.unlock();
+    run_batch(std::move(batch));
+    lock.lock();
+  }
+}
+
+void DaemonServer::run_batch(
+    std::vector<std::shared_ptr<PendingRequest>> batch) {
+  std::vector<const uint8_t *> images;
+  std::vector<int> widths;
+  std::vector<int> heights;
+  for (const auto &request : batch) {
+    images.insert(images.end(), request->images.begin(), request->images.end());
+    widths.insert(widths.end(), request->widths.begin(), request->widths.end());
+    heights.insert(heights.end(), request->heights.begin(),
+                   request->heights.end());
+  }
+
+  std::vector<std::string> results;
+  std::string error;
+  int status = backend_.detect_batch(batch.front()->params, (int)images.size(),
+                                     images.data(), widths.data(),
+                                     heights.data(), &results, &error);
+  if (status == ONNX_OK && results.size() != images.size()) {
+    status = ONNX_ERROR_RUNTIME_FAILURE;
+    error = "后端返回的结果数量不符";
+  }
+  batches_++;
+  images_ += (int64_t)images.size();
+
+  size_t next = 0;
+  for (const auto &request : batch) {
+    std::lock_guard<std::mutex> lock(request->mutex);
+    request->status = status;
+    if (status == ONNX_OK) {
+      for (size_t i = 0; i < request->images.size(); i++) {
+        request->reply += results[next++];
+      }
+    } else {
+      request->reply = error;
+    }
+    request->done = true;
+    requests_++;
+    request->cv.notify_one();
+  }
+}
+
+} // namespace onnx_daemon
+
+#endif // ONNX_DAEMON_SUPPORTED
@@ -0,0 +1,132 @@
+/**
+ * 本地推理守护进程服务端
+ *
+ * 接受多个客户端经 Unix 域套接字发来的推理请求，把参数相同的并发请求合并
+ * 为一个微批次交给后端执行：凑满 max_batch 张图片，或最早的请求已等待
+ * max_delay_us 时立即下发。后端与 ONNX Runtime 解耦，测试可替换为替身。
+ */
+#ifndef ONNX_DAEMON_SERVER_H
+#define ONNX_DAEMON_SERVER_H
+
+#include "onnx_daemon_protocol.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace onnx_daemon {
+
+/// 可合并为同一批次的推理参数。
+struct DetectParams {
+  int32_t model_id = -1;
+  float conf_threshold = 0;
+  float nms_threshold = 0;
+  int32_t model_type = 0;
+  int32_t num_keypoints = 0;
+
+  bool operator==(const DetectParams &other) const {
+    return model_id == other.model_id &&
+           conf_threshold == other.conf_threshold &&
+           nms_threshold == other.nms_threshold &&
+           model_type == other.model_type &&
+           num_keypoints == other.num_keypoints;
+  }
+};
+
+/// 推理后端；各回调不会被并发调用。
+struct DaemonBackend {
+  /// 加载模型，成功时写入 model_id。返回 OnnxErrorCode。
+  std::function<int(const std::string &path, bool use_gpu, int32_t *model_id,
+                    std::string *error)>
+      load_model;
+  /// 批量推理，成功时 results 按图片顺序写入 encode_detections 的编码。
+  /// 返回 OnnxErrorCode。
+  std::function<int(const DetectParams &params, int num_images,
+                    const uint8_t **images, const int *widths,
+                    const int *heights, std::vector<std::string> *results,
+                    std::string *error)>
+      detect_batch;
+};
+
+struct DaemonServerOptions {
+  std::string socket_path;
+  int max_batch = 8;
+  int64_t max_delay_us = 2000;
+  unsigned socket_mode = 0600;
+};
+
+struct DaemonStats {
+  int64_t requests = 0; // 完成的 DETECT 请求数
+  int64_t images = 0;   // 推理的图片数
+  int64_t batches = 0;  // 下发给后端的批次数
+};
+
+#ifdef ONNX_DAEMON_SUPPORTED
+
+class DaemonServer {
+public:
+  DaemonServer(DaemonServerOptions options, DaemonBackend backend);
+  ~DaemonServer();
+
+  DaemonServer(const DaemonServer &) = delete;
+  DaemonServer &operator=(const DaemonServer &) = delete;
+
+  /// 开始监听，失败时 error 给出原因。
+  bool start(std::string *error);
+  /// 断开所有客户端，处理完已排队的请求后返回；删除套接字文件。
+  void stop();
+
+  DaemonStats stats() const;
+
+private:
+  struct Connection;
+  struct PendingRequest;
+
+  void accept_loop();
+  void serve(Connection *connection);
+  void dispatch_loop();
+  void run_batch(std::vector<std::shared_ptr<PendingRequest>> batch);
+  int load_model(const std::string &payload, int32_t *model_id,
+                 std::string *error);
+  void reap_connections(bool all);
+
+  DaemonServerOptions options_;
+  DaemonBackend backend_;
+  int listen_fd_ = -1;
+  std::atomic<bool> running_{false};
+  std::thread accept_thread_;
+  std::thread dispatch_thread_;
+
+  std::mutex connections_mutex_;
+  std::list<std::unique_ptr<Connection>> connections_;
+
+  // 模型缓存：同一 (路径, GPU) 只加载一次，守护进程生命周期内常驻。
+  std::mutex models_mutex_;
+  std::map<std::string, int32_t> models_;
+  std::set<int32_t> model_ids_;
+
+  std::mutex queue_mutex_;
+  std::condition_variable queue_cv_;
+  std::deque<std::shared_ptr<PendingRequest>> queue_;
+  bool dispatch_stop_ = false;
+
+  std::atomic<int64_t> requests_{0};
+  std::atomic<int64_t> images_{0};
+  std::atomic<int64_t> batches_{0};
+};
+
+#endif // ONNX_DAEMON_SUPPORTED
+
+} // namespace onnx_daemon
+
+#endif // ONNX_DAEMON_SERVER_H
@@ -20,6 +20,12 @@ enum ModelType {
 
   /// YOLOv8-Pose 关键点检测。
   yoloPose,
+
+  /// YOLOv8-Seg 实例分割（输出轮廓多边形）。
+  yoloSeg,
+
+  /// YOLOv8-OBB 旋转框检测（输出角度与 4 个角点）。
+  yoloObb,
 }
 
 // ============================================================================
@@ -49,6 +55,21 @@ class Keypoint {
       'v=${visibility.toStringAsFixed(2)})';
 }
 
+/// 多边形顶点（归一化坐标）。
+class PolygonPoint {
+  /// 归一化 x 坐标 (0-1)。
+  final double x;
+
+  /// 归一化 y 坐标 (0-1)。
+  final double y;
+
+  const PolygonPoint({required this.x, required this.y});
+
+  @override
+  String toString() =>
+      'PolygonPoint(x=${x.toStringAsFixed(3)}, y=${y.toStringAsFixed(3)})';
+}
+
 /// 检测结果（归一化坐标）。
 class Detection {
   /// 类别 ID。
@@ -72,6 +93,12 @@ class Detection {
   /// 关键点列表（姿态模型可选）。
   final List<Keypoint>? keypoints;
 
+  /// 实例轮廓多边形（分割模型可选；OBB 模型为 4 个角点）。
+  final List<PolygonPoint>? polygon;
+
+  /// 旋转角（弧度，顺时针；仅 OBB 模型非 0）。
+  final double angle;
+
   /// 掩码数据（分割模型预留）。
   final List<double>? mask;
 
@@ -89,6 +116,8 @@ class Detection {
     required this.width,
     required this.height,
     this.keypoints,
+    this.polygon,
+    this.angle = 0,
     this.mask,
     this.maskWidth,
     this.maskHeight,
@@ -99,7 +128,8 @@ class Detection {
       'Detection(class=$classId, conf=${confidence.toStringAsFixed(2)}, '
       'x=${x.toStringAsFixed(3)}, y=${y.toStringAsFixed(3)}, '
       'w=${width.toStringAsFixed(3)}, h=${height.toStringAsFixed(3)}'
-      '${keypoints != null ? ", kpts=${keypoints!.length}" : ""})';
+      '${keypoints != null ? ", kpts=${keypoints!.length}" : ""}'
+      '${polygon != null ? ", polygon=${polygon!.length}" : ""})';
 }
 
 /// GPU 信息。
@@ -142,6 +172,239 @@ class GpuInfo {
       'device=$deviceName, cudaDevices=$cudaDeviceCount)';
 }
 
+/// 推理阶段（与原生 OnnxStage 顺序一致）。
+enum OnnxStage {
+  /// letterbox 预处理。
+  preprocess,
+
+  /// ONNX Runtime 推理。
+  run,
+
+  /// 输出解析（候选框展开）。
+  parse,
+
+  /// 非极大值抑制。
+  nms,
+
+  /// 分割掩码组装。
+  masks,
+
+  /// 结果拷贝/打包。
+  marshal,
+
+  /// 以上各阶段之和。
+  total,
+}
+
+/// 单个阶段的耗时（毫秒）。
+class OnnxStageTiming {
+  /// 最近一次调用的耗时。
+  final double lastMs;
+
+  /// 累计分位数（取自对数直方图，相对误差约 19%）。
+  final double p50Ms;
+  final double p95Ms;
+  final double p99Ms;
+
+  const OnnxStageTiming({
+    required this.lastMs,
+    required this.p50Ms,
+    required this.p95Ms,
+    required this.p99Ms,
+  });
+}
+
+/// 模型句柄的性能统计。
+///
+/// 一次调用指一次 detect/detectBatch 或一个流式微批次；图片解码在 Dart 侧，
+/// 不计入原生统计。
+class OnnxStats {
+  /// 各阶段耗时。
+  final Map<OnnxStage, OnnxStageTiming> stages;
+
+  /// 调用次数。
+  final int calls;
+
+  /// 图片数。
+  final int images;
+
+  /// NMS 前候选框数。
+  final int candidates;
+
+  /// 输出检测框数。
+  final int detections;
+
+  /// 句柄缓冲区增长与返回结果的堆分配字节数。
+  final int bytesAllocated;
+
+  /// 近重复复用结果而跳过推理的图片数（见 [OnnxInference.setDedupDistance]）。
+  final int dedupSkipped;
+
+  /// 经两级级联推理的图片数（见 [OnnxInference.detectBatchCascade]）。
+  final int cascadeImages;
+
+  /// 其中升级到重模型的图片数。
+  final int cascadeEscalated;
+
+  const OnnxStats({
+    required this.stages,
+    required this.calls,
+    required this.images,
+    required this.candidates,
+    required this.detections,
+    required this.bytesAllocated,
+    this.dedupSkipped = 0,
+    this.cascadeImages = 0,
+    this.cascadeEscalated = 0,
+  });
+
+  @override
+  String toString() =>
+      'OnnxStats(calls=$calls, images=$images, candidates=$candidates, '
+      'detections=$detections, bytes=$bytesAllocated, '
+      'dedupSkipped=$dedupSkipped, '
+      'cascade=$cascadeEscalated/$cascadeImages, '
+      'total=${stages[OnnxStage.total]?.p50Ms.toStringAsFixed(2)}ms p50)';
+}
+
+/// 两级级联升级规则（默认值与原生 onnx_default_cascade_options 一致）。
+class OnnxCascadeOptions {
+  /// 不确定区间下限，快速模型以此为置信度阈值运行。
+  final double uncertainLow;
+
+  /// 不确定区间上限（不含）。
+  final double uncertainHigh;
+
+  /// 不确定检测数达到该值时升级到重模型。
+  final int minUncertain;
+
+  /// 快速模型无任何检测时升级。
+  final bool escalateEmpty;
+
+  /// 升级图片每批送入重模型的数量，0 为一批全部。
+  final int heavyBatchSize;
+
+  const OnnxCascadeOptions({
+    this.uncertainLow = 0.1,
+    this.uncertainHigh = 0.5,
+    this.minUncertain = 1,
+    this.escalateEmpty = true,
+    this.heavyBatchSize = 0,
+  });
+}
+
+/// 运行时初始化选项（默认值与 [OnnxInference.initialize] 不带选项时一致）。
+class OnnxInitOptions {
+  /// 所有模型共享一组 ORT 线程池，总线程数不随加载的模型数增长。
+  final bool useGlobalThreadPools;
+
+  /// 共享线程空闲时自旋等待（降低延迟，但占用 CPU）。
+  final bool allowSpinning;
+
+  /// 共享算子内线程数（含调用线程），0 为物理核数。
+  final int intraOpThreads;
+
+  /// 共享算子间线程数，0 为 ORT 默认。
+  final int interOpThreads;
+
+  /// 算子内线程的 CPU 亲和性，如 `'1,2;3,4;5,6'`（共 intraOpThreads - 1 组，
+  /// 逻辑处理器从 1 起编号）；null 为不绑定。
+  final String? intraOpAffinity;
+
+  const OnnxInitOptions({
+    this.useGlobalThreadPools = false,
+    this.allowSpinning = true,
+    this.intraOpThreads = 0,
+    this.interOpThreads = 0,
+    this.intraOpAffinity,
+  });
+}
+
+/// ORT 内存池扩展策略。
+enum OnnxArenaExtendStrategy {
+  /// 按 2 的幂扩展（ORT 默认）。
+  nextPowerOfTwo,
+
+  /// 按请求大小扩展，占用贴近实际。
+  sameAsRequested,
+}
+
+/// 模型加载选项（默认值与 [OnnxInference.loadModel] 不带选项时一致）。
+class OnnxLoadOptions {
+  /// CPU 内存池；关闭后张量内存用完即归还系统。
+  final bool enableCpuArena;
+
+  /// 按首次运行的形状预规划内存（批量大小多变时可关闭）。
+  final bool enableMemPattern;
+
+  /// 内存池扩展策略（CPU 侧为进程级共享配置，首个设置者生效）。
+  final OnnxArenaExtendStrategy arenaExtendStrategy;
+
+  /// 内存池首块大小，0 为 ORT 默认。
+  final int arenaInitialChunkBytes;
+
+  const OnnxLoadOptions({
+    this.enableCpuArena = true,
+    this.enableMemPattern = true,
+    this.arenaExtendStrategy = OnnxArenaExtendStrategy.nextPowerOfTwo,
+    this.arenaInitialChunkBytes = 0,
+  });
+}
+
+/// 模型句柄的内存占用（字节，null 表示当前运行时不支持查询）。
+class OnnxMemoryUsage {
+  /// ORT CPU 内存池向系统申请的字节数。
+  final int? arenaReservedBytes;
+
+  /// 其中在用的字节数。
+  final int? arenaInUseBytes;
+
+  /// 句柄输入张量与后处理暂存区容量。
+  final int pluginReservedBytes;
+
+  /// 进程常驻内存。
+  final int? processRssBytes;
+
+  /// 最近一次 [OnnxInference.trimMemory] 归还的内存池字节数。
+  final int? arenaTrimmedBytes;
+
+  const OnnxMemoryUsage({
+    required this.arenaReservedBytes,
+    required this.arenaInUseBytes,
+    required this.pluginReservedBytes,
+    required this.processRssBytes,
+    required this.arenaTrimmedBytes,
+  });
+
+  @override
+  String toString() =>
+      'OnnxMemoryUsage(arenaReserved=$arenaReservedBytes, '
+      'arenaInUse=$arenaInUseBytes, plugin=$pluginReservedBytes, '
+      'rss=$processRssBytes, trimmed=$arenaTrimmedBytes)';
+}
+
+/// 多阈值扫描结果（见 [OnnxInference.detectSweep]）。
+class OnnxSweepResult {
+  /// 置信度阈值。
+  final List<double> confThresholds;
+
+  /// NMS 阈值。
+  final List<double> nmsThresholds;
+
+  /// 各阈值组合的检测结果，按 `confIndex * nmsThresholds.length + nmsIndex` 排列。
+  final List<List<Detection>> results;
+
+  const OnnxSweepResult({
+    required this.confThresholds,
+    required this.nmsThresholds,
+    required this.results,
+  });
+
+  /// 第 [confIndex] 个置信度阈值与第 [nmsIndex] 个 NMS 阈值的检测结果。
+  List<Detection> at(int confIndex, int nmsIndex) =>
+      results[confIndex * nmsThresholds.length + nmsIndex];
+}
+
 // ============================================================================
 // Native 结构定义
 // ============================================================================
@@ -171,6 +434,16 @@ base class NativeDetection extends Struct {
 
   @Int32()
   external int numKeypoints;
+
+  /// 多边形顶点数组（x, y）指针。
+  external Pointer<Float> polygon;
+
+  @Int32()
+  external int numPolygonPoints;
+
+  /// 旋转角（弧度）。
+  @Float()
+  external double angle;
 }
 
 /// 原生检测结果数组结构体。
@@ -192,6 +465,32 @@ base class NativeBatchDetectionResult extends Struct {
   external int numImages;
 }
 
+/// 原生可复用结果缓冲区结构体（调用方持有）。
+base class NativeOnnxResultBuffer extends Struct {
+  external Pointer<NativeDetection> detections;
+
+  @Int32()
+  external int capacity;
+
+  @Int32()
+  external int count;
+
+  /// 变长数据区（关键点等）。
+  external Pointer<Uint8> arena;
+
+  @Int64()
+  external int arenaCapacity;
+
+  @Int64()
+  external int arenaUsed;
+
+  @Int32()
+  external int requiredCapacity;
+
+  @Int64()
+  external int requiredArena;
+}
+
 /// 原生 GPU 信息结构体。
 base class NativeGpuInfo extends Struct {
   @Bool()
@@ -213,6 +512,116 @@ base class NativeGpuInfo extends Struct {
   external int cudaDeviceCount;
 }
 
+/// 原生性能统计结构体。
+base class NativeOnnxStats extends Struct {
+  @Array(7)
+  external Array<Double> lastMs;
+
+  @Array(7)
+  external Array<Double> p50Ms;
+
+  @Array(7)
+  external Array<Double> p95Ms;
+
+  @Array(7)
+  external Array<Double> p99Ms;
+
+  @Int64()
+  external int calls;
+
+  @Int64()
+  external int images;
+
+  @Int64()
+  external int candidates;
+
+  @Int64()
+  external int detections;
+
+  @Int64()
+  external int bytesAllocated;
+
+  @Int64()
+  external int dedupSkipped;
+
+  @Int64()
+  external int cascadeImages;
+
+  @Int64()
+  external int cascadeEscalated;
+}
+
+/// 原生级联升级规则结构体。
+base class NativeOnnxCascadeOptions extends Struct {
+  @Float()
+  external double uncertainLow;
+
+  @Float()
+  external double uncertainHigh;
+
+  @Int32()
+  external int minUncertain;
+
+  @Bool()
+  external bool escalateEmpty;
+
+  @Int32()
+  external int heavyBatchSize;
+}
+
+/// 原生运行时初始化选项结构体。
+base class NativeOnnxInitOptions extends Struct {
+  @Bool()
+  external bool useGlobalThreadPools;
+
+  @Bool()
+  external bool allowSpinning;
+
+  @Int32()
+  external int intraOpThreads;
+
+  @Int32()
+  external int interOpThreads;
+
+  external Pointer<Utf8> intraOpAffinity;
+}
+
+/// 原生模型加载选项结构体。
+base class NativeOnnxLoadOptions extends Struct {
+  @Bool()
+  external bool useGpu;
+
+  @Bool()
+  external bool enableCpuArena;
+
+  @Bool()
+  external bool enableMemPattern;
+
+  @Int32()
+  external int arenaExtendStrategy;
+
+  @Int64()
+  external int arenaInitialChunkBytes;
+}
+
+/// 原生内存占用结构体。
+base class NativeOnnxMemoryUsage extends Struct {
+  @Int64()
+  external int arenaReservedBytes;
+
+  @Int64()
+  external int arenaInUseBytes;
+
+  @Int64()
+  external int pluginReservedBytes;
+
+  @Int64()
+  external int processRssBytes;
+
+  @Int64()
+  external int arenaTrimmedBytes;
+}
+
 // ============================================================================
 // Native 函数签名
 // ============================================================================
@@ -220,6 +629,11 @@ base class NativeGpuInfo extends Struct {
 typedef OnnxInitNative = Bool Function();
 typedef OnnxInitDart = bool Function();
 
+typedef OnnxInitWithOptionsNative = Bool Function(
+    Pointer<NativeOnnxInitOptions> options);
+typedef OnnxInitWithOptionsDart = bool Function(
+    Pointer<NativeOnnxInitOptions> options);
+
 typedef OnnxCleanupNative = Void Function();
 typedef OnnxCleanupDart = void Function();
 
@@ -276,56 +690,341 @@ typedef OnnxDetectBatchDart = Pointer<NativeBatchDetectionResult> Function(
   int numKeypoints,
 );
 
-typedef OnnxFreeResultNative = Void Function(Pointer<NativeDetectionResult> result);
-typedef OnnxFreeResultDart = void Function(Pointer<NativeDetectionResult> result);
+typedef OnnxDetectIntoNative = Int32 Function(
+  Pointer<Void> handle,
+  Pointer<Uint8> imageData,
+  Int32 imageWidth,
+  Int32 imageHeight,
+  Float confThreshold,
+  Float nmsThreshold,
+  Int32 modelType,
+  Int32 numKeypoints,
+  Pointer<NativeOnnxResultBuffer> out,
+);
+typedef OnnxDetectIntoDart = int Function(
+  Pointer<Void> handle,
+  Pointer<Uint8> imageData,
+  int imageWidth,
+  int imageHeight,
+  double confThreshold,
+  double nmsThreshold,
+  int modelType,
+  int numKeypoints,
+  Pointer<NativeOnnxResultBuffer> out,
+);
 
-typedef OnnxFreeBatchResultNative = Void Function(Pointer<NativeBatchDetectionResult> result);
-typedef OnnxFreeBatchResultDart = void Function(Pointer<NativeBatchDetectionResult> result);
+typedef OnnxCopyLastResultNative = Int32 Function(
+    Pointer<Void> handle, Pointer<NativeOnnxResultBuffer> out);
+typedef OnnxCopyLastResultDart = int Function(
+    Pointer<Void> handle, Pointer<NativeOnnxResultBuffer> out);
 
-typedef OnnxGetVersionNative = Pointer<Utf8> Function();
-typedef OnnxGetVersionDart = Pointer<Utf8> Function();
+typedef OnnxStreamCreateNative = Pointer<Void> Function(
+  Pointer<Void> handle,
+  Float confThreshold,
+  Float nmsThreshold,
+  Int32 modelType,
+  Int32 numKeypoints,
+  Int64 memoryBudgetBytes,
+);
+typedef OnnxStreamCreateDart = Pointer<Void> Function(
+  Pointer<Void> handle,
+  double confThreshold,
+  double nmsThreshold,
+  int modelType,
+  int numKeypoints,
+  int memoryBudgetBytes,
+);
 
-typedef OnnxIsGpuAvailableNative = Bool Function();
-typedef OnnxIsGpuAvailableDart = bool Function();
+typedef OnnxStreamPushNative = Int32 Function(Pointer<Void> stream,
+    Pointer<Uint8> imageData, Int32 imageWidth, Int32 imageHeight, Int64 tag);
+typedef OnnxStreamPushDart = int Function(Pointer<Void> stream,
+    Pointer<Uint8> imageData, int imageWidth, int imageHeight, int tag);
 
-typedef OnnxGetGpuInfoNative = NativeGpuInfo Function();
-typedef OnnxGetGpuInfoDart = NativeGpuInfo Function();
+typedef OnnxStreamIntNative = Int32 Function(Pointer<Void> stream);
+typedef OnnxStreamIntDart = int Function(Pointer<Void> stream);
 
-typedef OnnxGetAvailableProvidersNative = Pointer<Utf8> Function();
-typedef OnnxGetAvailableProvidersDart = Pointer<Utf8> Function();
-typedef OnnxGetLastErrorNative = Pointer<Utf8> Function();
-typedef OnnxGetLastErrorDart = Pointer<Utf8> Function();
-typedef OnnxGetLastErrorCodeNative = Int32 Function();
-typedef OnnxGetLastErrorCodeDart = int Function();
+typedef OnnxStreamNextNative = Int32 Function(Pointer<Void> stream,
+    Pointer<Int64> tag, Pointer<NativeOnnxResultBuffer> out);
+typedef OnnxStreamNextDart = int Function(Pointer<Void> stream,
+    Pointer<Int64> tag, Pointer<NativeOnnxResultBuffer> out);
 
-typedef OnnxLookup = T Function<S extends Function, T extends Function>(
-  String symbolName,
+typedef OnnxStreamDestroyNative = Void Function(Pointer<Void> stream);
+typedef OnnxStreamDestroyDart = void Function(Pointer<Void> stream);
+
+typedef OnnxAcquireImageBufferNative = Pointer<Uint8> Function(Int64 size);
+typedef OnnxAcquireImageBufferDart = Pointer<Uint8> Function(int size);
+
+typedef OnnxReleaseImageBufferNative = Void Function(Pointer<Uint8> buffer);
+typedef OnnxReleaseImageBufferDart = void Function(Pointer<Uint8> buffer);
+
+typedef OnnxTrimImageBuffersNative = Int64 Function();
+typedef OnnxTrimImageBuffersDart = int Function();
+
+typedef OnnxGetStatsNative = Int32 Function(
+    Pointer<Void> handle, Pointer<NativeOnnxStats> out);
+typedef OnnxGetStatsDart = int Function(
+    Pointer<Void> handle, Pointer<NativeOnnxStats> out);
+
+typedef OnnxResetStatsNative = Void Function(Pointer<Void> handle);
+typedef OnnxResetStatsDart = void Function(Pointer<Void> handle);
+
+typedef OnnxStartProfilingNative = Int32 Function(
+    Pointer<Void> handle, Pointer<Utf8> tracePath);
+typedef OnnxStartProfilingDart = int Function(
+    Pointer<Void> handle, Pointer<Utf8> tracePath);
+
+typedef OnnxStopProfilingNative = Int32 Function(Pointer<Void> handle);
+typedef OnnxStopProfilingDart = int Function(Pointer<Void> handle);
+
+typedef OnnxLoadModelWithOptionsNative = Pointer<Void> Function(
+    Pointer<Utf8> modelPath, Pointer<NativeOnnxLoadOptions> options);
+typedef OnnxLoadModelWithOptionsDart = Pointer<Void> Function(
+    Pointer<Utf8> modelPath, Pointer<NativeOnnxLoadOptions> options);
+
+typedef OnnxGetMemoryUsageNative = Int32 Function(
+    Pointer<Void> handle, Pointer<NativeOnnxMemoryUsage> out);
+typedef OnnxGetMemoryUsageDart = int Function(
+    Pointer<Void> handle, Pointer<NativeOnnxMemoryUsage> out);
+
+typedef OnnxTrimMemoryNative = Int32 Function(Pointer<Void> handle);
+typedef OnnxTrimMemoryDart = int Function(Pointer<Void> handle);
+
+typedef OnnxHashBytesNative = Uint64 Function(Pointer<Uint8> data, Int64 size);
+typedef OnnxHashBytesDart = int Function(Pointer<Uint8> data, int size);
+
+typedef OnnxHashFilesNative = Int32 Function(Pointer<Pointer<Utf8>> paths,
+    Int32 count, Pointer<Uint64> hashes, Pointer<Uint8> ok);
+typedef OnnxHashFilesDart = int Function(Pointer<Pointer<Utf8>> paths,
+    int count, Pointer<Uint64> hashes, Pointer<Uint8> ok);
+
+typedef OnnxSetDedupNative = Int32 Function(
+    Pointer<Void> handle, Int32 maxDistance);
+typedef OnnxSetDedupDart = int Function(Pointer<Void> handle, int maxDistance);
+
+typedef OnnxLoadModelAsyncNative = Pointer<Void> Function(
+    Pointer<Utf8> modelPath, Pointer<NativeOnnxLoadOptions> options);
+typedef OnnxLoadModelAsyncDart = Pointer<Void> Function(
+    Pointer<Utf8> modelPath, Pointer<NativeOnnxLoadOptions> options);
+
+typedef OnnxLoadModelDoneNative = Int32 Function(Pointer<Void> load);
+typedef OnnxLoadModelDoneDart = int Function(Pointer<Void> load);
+
+typedef OnnxLoadModelFinishNative = Pointer<Void> Function(Pointer<Void> load);
+typedef OnnxLoadModelFinishDart = Pointer<Void> Function(Pointer<Void> load);
+
+typedef OnnxLoadModelCancelNative = Void Function(Pointer<Void> load);
+typedef OnnxLoadModelCancelDart = void Function(Pointer<Void> load);
+
+typedef OnnxSetRuntimeSearchPathsNative = Bool Function(Pointer<Utf8> paths);
+typedef OnnxSetRuntimeSearchPathsDart = bool Function(Pointer<Utf8> paths);
+
+typedef OnnxGetRuntimePathNative = Pointer<Utf8> Function();
+typedef OnnxGetRuntimePathDart = Pointer<Utf8> Function();
+
+typedef OnnxDetectBatchCascadeNative = Pointer<NativeBatchDetectionResult>
+    Function(
+  Pointer<Void> fast,
+  Pointer<Void> heavy,
+  Pointer<Pointer<Uint8>> imageDataList,
+  Int32 numImages,
+  Pointer<Int32> imageWidths,
+  Pointer<Int32> imageHeights,
+  Float confThreshold,
+  Float nmsThreshold,
+  Int32 modelType,
+  Int32 numKeypoints,
+  Pointer<NativeOnnxCascadeOptions> options,
+);
+typedef OnnxDetectBatchCascadeDart = Pointer<NativeBatchDetectionResult>
+    Function(
+  Pointer<Void> fast,
+  Pointer<Void> heavy,
+  Pointer<Pointer<Uint8>> imageDataList,
+  int numImages,
+  Pointer<Int32> imageWidths,
+  Pointer<Int32> imageHeights,
+  double confThreshold,
+  double nmsThreshold,
+  int modelType,
+  int numKeypoints,
+  Pointer<NativeOnnxCascadeOptions> options,
 );
 
-/// FFI 绑定集合，用于隔离动态库加载与逻辑调用。
-class OnnxBindings {
-  const OnnxBindings({
-    required this.init,
-    required this.cleanup,
-    required this.loadModel,
-    required this.unloadModel,
-    required this.getInputSize,
-    required this.detect,
-    required this.detectBatch,
-    required this.freeResult,
-    required this.freeBatchResult,
-    required this.getVersion,
-    required this.isGpuAvailable,
-    required this.getGpuInfo,
-    required this.getAvailableProviders,
-    required this.getLastError,
-    required this.getLastErrorCode,
-  });
+typedef OnnxEnableRawCacheNative = Int32 Function(
+    Pointer<Void> handle, Pointer<Utf8> cacheDir);
+typedef OnnxEnableRawCacheDart = int Function(
+    Pointer<Void> handle, Pointer<Utf8> cacheDir);
 
-  /// 从动态库解析全部函数指针。
-  factory OnnxBindings.fromLibrary(DynamicLibrary lib) {
-    return OnnxBindings(
-      init: lib.lookupFunction<OnnxInitNative, OnnxInitDart>('onnx_init'),
+typedef OnnxDetectCachedNative = Pointer<NativeDetectionResult> Function(
+  Pointer<Void> handle,
+  Uint64 imageKey,
+  Float confThreshold,
+  Float nmsThreshold,
+  Int32 modelType,
+  Int32 numKeypoints,
+);
+typedef OnnxDetectCachedDart = Pointer<NativeDetectionResult> Function(
+  Pointer<Void> handle,
+  int imageKey,
+  double confThreshold,
+  double nmsThreshold,
+  int modelType,
+  int numKeypoints,
+);
+
+typedef OnnxDetectBatchKeyedNative = Pointer<NativeBatchDetectionResult>
+    Function(
+  Pointer<Void> handle,
+  Pointer<Pointer<Uint8>> imageDataList,
+  Pointer<Uint64> imageKeys,
+  Int32 numImages,
+  Pointer<Int32> imageWidths,
+  Pointer<Int32> imageHeights,
+  Float confThreshold,
+  Float nmsThreshold,
+  Int32 modelType,
+  Int32 numKeypoints,
+);
+typedef OnnxDetectBatchKeyedDart = Pointer<NativeBatchDetectionResult>
+    Function(
+  Pointer<Void> handle,
+  Pointer<Pointer<Uint8>> imageDataList,
+  Pointer<Uint64> imageKeys,
+  int numImages,
+  Pointer<Int32> imageWidths,
+  Pointer<Int32> imageHeights,
+  double confThreshold,
+  double nmsThreshold,
+  int modelType,
+  int numKeypoints,
+);
+
+typedef OnnxDetectSweepNative = Pointer<NativeBatchDetectionResult> Function(
+  Pointer<Void> handle,
+  Pointer<Uint8> imageData,
+  Int32 width,
+  Int32 height,
+  Pointer<Float> confThresholds,
+  Int32 numConf,
+  Pointer<Float> nmsThresholds,
+  Int32 numNms,
+  Int32 modelType,
+  Int32 numKeypoints,
+);
+typedef OnnxDetectSweepDart = Pointer<NativeBatchDetectionResult> Function(
+  Pointer<Void> handle,
+  Pointer<Uint8> imageData,
+  int width,
+  int height,
+  Pointer<Float> confThresholds,
+  int numConf,
+  Pointer<Float> nmsThresholds,
+  int numNms,
+  int modelType,
+  int numKeypoints,
+);
+
+typedef OnnxClientConnectNative = Pointer<Void> Function(
+    Pointer<Utf8> socketPath);
+typedef OnnxClientConnectDart = Pointer<Void> Function(
+    Pointer<Utf8> socketPath);
+
+typedef OnnxClientLoadModelNative = Int32 Function(
+    Pointer<Void> client, Pointer<Utf8> modelPath, Bool useGpu);
+typedef OnnxClientLoadModelDart = int Function(
+    Pointer<Void> client, Pointer<Utf8> modelPath, bool useGpu);
+
+typedef OnnxClientDisconnectNative = Void Function(Pointer<Void> client);
+typedef OnnxClientDisconnectDart = void Function(Pointer<Void> client);
+
+typedef OnnxFreeResultNative = Void Function(Pointer<NativeDetectionResult> result);
+typedef OnnxFreeResultDart = void Function(Pointer<NativeDetectionResult> result);
+
+typedef OnnxFreeBatchResultNative = Void Function(Pointer<NativeBatchDetectionResult> result);
+typedef OnnxFreeBatchResultDart = void Function(Pointer<NativeBatchDetectionResult> result);
+
+typedef OnnxGetVersionNative = Pointer<Utf8> Function();
+typedef OnnxGetVersionDart = Pointer<Utf8> Function();
+
+typedef OnnxIsGpuAvailableNative = Bool Function();
+typedef OnnxIsGpuAvailableDart = bool Function();
+
+typedef OnnxGetGpuInfoNative = NativeGpuInfo Function();
+typedef OnnxGetGpuInfoDart = NativeGpuInfo Function();
+
+typedef OnnxGetAvailableProvidersNative = Pointer<Utf8> Function();
+typedef OnnxGetAvailableProvidersDart = Pointer<Utf8> Function();
+typedef OnnxGetLastErrorNative = Pointer<Utf8> Function();
+typedef OnnxGetLastErrorDart = Pointer<Utf8> Function();
+typedef OnnxGetLastErrorCodeNative = Int32 Function();
+typedef OnnxGetLastErrorCodeDart = int Function();
+
+typedef OnnxLookup = T Function<S extends Function, T extends Function>(
+  String symbolName,
+);
+
+/// FFI 绑定集合，用于隔离动态库加载与逻辑调用。
+class OnnxBindings {
+  const OnnxBindings({
+    required this.init,
+    required this.cleanup,
+    required this.loadModel,
+    required this.unloadModel,
+    required this.getInputSize,
+    required this.detect,
+    required this.detectBatch,
+    required this.freeResult,
+    required this.freeBatchResult,
+    required this.getVersion,
+    required this.isGpuAvailable,
+    required this.getGpuInfo,
+    required this.getAvailableProviders,
+    required this.getLastError,
+    required this.getLastErrorCode,
+    this.detectInto,
+    this.copyLastResult,
+    this.streamCreate,
+    this.streamPush,
+    this.streamFlush,
+    this.streamBatchSize,
+    this.streamNext,
+    this.streamDestroy,
+    this.acquireImageBuffer,
+    this.releaseImageBuffer,
+    this.trimImageBuffers,
+    this.getStats,
+    this.resetStats,
+    this.startProfiling,
+    this.stopProfiling,
+    this.loadModelWithOptions,
+    this.getMemoryUsage,
+    this.trimMemory,
+    this.initWithOptions,
+    this.clientDefaultSocketPath,
+    this.clientConnect,
+    this.clientLoadModel,
+    this.clientDetectBatch,
+    this.clientDisconnect,
+    this.hashBytes,
+    this.enableRawCache,
+    this.detectCached,
+    this.detectBatchKeyed,
+    this.detectSweep,
+    this.hashFiles,
+    this.setDedup,
+    this.detectBatchCascade,
+    this.loadModelAsync,
+    this.loadModelDone,
+    this.loadModelFinish,
+    this.loadModelCancel,
+    this.setRuntimeSearchPaths,
+    this.getRuntimePath,
+  });
+
+  /// 从动态库解析全部函数指针。
+  factory OnnxBindings.fromLibrary(DynamicLibrary lib) {
+    return OnnxBindings(
+      init: lib.lookupFunction<OnnxInitNative, OnnxInitDart>('onnx_init'),
       cleanup:
           lib.lookupFunction<OnnxCleanupNative, OnnxCleanupDart>('onnx_cleanup'),
       loadModel:
@@ -374,6 +1073,165 @@ class OnnxBindings {
       ),
       getLastErrorCode: lib.lookupFunction<OnnxGetLastErrorCodeNative,
           OnnxGetLastErrorCodeDart>('onnx_get_last_error_code'),
+      detectInto: lib.providesSymbol('onnx_detect_into')
+          ? lib.lookupFunction<OnnxDetectIntoNative, OnnxDetectIntoDart>(
+              'onnx_detect_into',
+            )
+          : null,
+      copyLastResult: lib.providesSymbol('onnx_copy_last_result')
+          ? lib.lookupFunction<OnnxCopyLastResultNative,
+              OnnxCopyLastResultDart>('onnx_copy_last_result')
+          : null,
+      streamCreate: lib.providesSymbol('onnx_stream_create')
+          ? lib.lookupFunction<OnnxStreamCreateNative, OnnxStreamCreateDart>(
+              'onnx_stream_create',
+            )
+          : null,
+      streamPush: lib.providesSymbol('onnx_stream_push')
+          ? lib.lookupFunction<OnnxStreamPushNative, OnnxStreamPushDart>(
+              'onnx_stream_push',
+            )
+          : null,
+      streamFlush: lib.providesSymbol('onnx_stream_flush')
+          ? lib.lookupFunction<OnnxStreamIntNative, OnnxStreamIntDart>(
+              'onnx_stream_flush',
+            )
+          : null,
+      streamBatchSize: lib.providesSymbol('onnx_stream_batch_size')
+          ? lib.lookupFunction<OnnxStreamIntNative, OnnxStreamIntDart>(
+              'onnx_stream_batch_size',
+            )
+          : null,
+      streamNext: lib.providesSymbol('onnx_stream_next')
+          ? lib.lookupFunction<OnnxStreamNextNative, OnnxStreamNextDart>(
+              'onnx_stream_next',
+            )
+          : null,
+      streamDestroy: lib.providesSymbol('onnx_stream_destroy')
+          ? lib.lookupFunction<OnnxStreamDestroyNative,
+              OnnxStreamDestroyDart>('onnx_stream_destroy')
+          : null,
+      acquireImageBuffer: lib.providesSymbol('onnx_acquire_image_buffer')
+          ? lib.lookupFunction<OnnxAcquireImageBufferNative,
+              OnnxAcquireImageBufferDart>('onnx_acquire_image_buffer')
+          : null,
+      releaseImageBuffer: lib.providesSymbol('onnx_release_image_buffer')
+          ? lib.lookupFunction<OnnxReleaseImageBufferNative,
+              OnnxReleaseImageBufferDart>('onnx_release_image_buffer')
+          : null,
+      trimImageBuffers: lib.providesSymbol('onnx_trim_image_buffers')
+          ? lib.lookupFunction<OnnxTrimImageBuffersNative,
+              OnnxTrimImageBuffersDart>('onnx_trim_image_buffers')
+          : null,
+      getStats: lib.providesSymbol('onnx_get_stats')
+          ? lib.lookupFunction<OnnxGetStatsNative, OnnxGetStatsDart>(
+              'onnx_get_stats')
+          : null,
+      resetStats: lib.providesSymbol('onnx_reset_stats')
+          ? lib.lookupFunction<OnnxResetStatsNative, OnnxResetStatsDart>(
+              'onnx_reset_stats')
+          : null,
+      startProfiling: lib.providesSymbol('onnx_start_profiling')
+          ? lib.lookupFunction<OnnxStartProfilingNative,
+              OnnxStartProfilingDart>('onnx_start_profiling')
+          : null,
+      stopProfiling: lib.providesSymbol('onnx_stop_profiling')
+          ? lib.lookupFunction<OnnxStopProfilingNative, OnnxStopProfilingDart>(
+              'onnx_stop_profiling')
+          : null,
+      loadModelWithOptions: lib.providesSymbol('onnx_load_model_with_options')
+          ? lib.lookupFunction<OnnxLoadModelWithOptionsNative,
+              OnnxLoadModelWithOptionsDart>('onnx_load_model_with_options')
+          : null,
+      getMemoryUsage: lib.providesSymbol('onnx_get_memory_usage')
+          ? lib.lookupFunction<OnnxGetMemoryUsageNative,
+              OnnxGetMemoryUsageDart>('onnx_get_memory_usage')
+          : null,
+      trimMemory: lib.providesSymbol('onnx_trim_memory')
+          ? lib.lookupFunction<OnnxTrimMemoryNative, OnnxTrimMemoryDart>(
+              'onnx_trim_memory')
+          : null,
+      initWithOptions: lib.providesSymbol('onnx_init_with_options')
+          ? lib.lookupFunction<OnnxInitWithOptionsNative,
+              OnnxInitWithOptionsDart>('onnx_init_with_options')
+          : null,
+      clientDefaultSocketPath:
+          lib.providesSymbol('onnx_client_default_socket_path')
+              ? lib.lookupFunction<OnnxGetVersionNative, OnnxGetVersionDart>(
+                  'onnx_client_default_socket_path')
+              : null,
+      clientConnect: lib.providesSymbol('onnx_client_connect')
+          ? lib.lookupFunction<OnnxClientConnectNative, OnnxClientConnectDart>(
+              'onnx_client_connect')
+          : null,
+      clientLoadModel: lib.providesSymbol('onnx_client_load_model')
+          ? lib.lookupFunction<OnnxClientLoadModelNative,
+              OnnxClientLoadModelDart>('onnx_client_load_model')
+          : null,
+      clientDetectBatch: lib.providesSymbol('onnx_client_detect_batch')
+          ? lib.lookupFunction<OnnxDetectBatchNative, OnnxDetectBatchDart>(
+              'onnx_client_detect_batch')
+          : null,
+      clientDisconnect: lib.providesSymbol('onnx_client_disconnect')
+          ? lib.lookupFunction<OnnxClientDisconnectNative,
+              OnnxClientDisconnectDart>('onnx_client_disconnect')
+          : null,
+      hashBytes: lib.providesSymbol('onnx_hash_bytes')
+          ? lib.lookupFunction<OnnxHashBytesNative, OnnxHashBytesDart>(
+              'onnx_hash_bytes')
+          : null,
+      enableRawCache: lib.providesSymbol('onnx_enable_raw_cache')
+          ? lib.lookupFunction<OnnxEnableRawCacheNative,
+              OnnxEnableRawCacheDart>('onnx_enable_raw_cache')
+          : null,
+      detectCached: lib.providesSymbol('onnx_detect_cached')
+          ? lib.lookupFunction<OnnxDetectCachedNative, OnnxDetectCachedDart>(
+              'onnx_detect_cached')
+          : null,
+      detectBatchKeyed: lib.providesSymbol('onnx_detect_batch_keyed')
+          ? lib.lookupFunction<OnnxDetectBatchKeyedNative,
+              OnnxDetectBatchKeyedDart>('onnx_detect_batch_keyed')
+          : null,
+      detectSweep: lib.providesSymbol('onnx_detect_sweep')
+          ? lib.lookupFunction<OnnxDetectSweepNative, OnnxDetectSweepDart>(
+              'onnx_detect_sweep')
+          : null,
+      hashFiles: lib.providesSymbol('onnx_hash_files')
+          ? lib.lookupFunction<OnnxHashFilesNative, OnnxHashFilesDart>(
+              'onnx_hash_files')
+          : null,
+      setDedup: lib.providesSymbol('onnx_set_dedup')
+          ? lib.lookupFunction<OnnxSetDedupNative, OnnxSetDedupDart>(
+              'onnx_set_dedup')
+          : null,
+      detectBatchCascade: lib.providesSymbol('onnx_detect_batch_cascade')
+          ? lib.lookupFunction<OnnxDetectBatchCascadeNative,
+              OnnxDetectBatchCascadeDart>('onnx_detect_batch_cascade')
+          : null,
+      loadModelAsync: lib.providesSymbol('onnx_load_model_async')
+          ? lib.lookupFunction<OnnxLoadModelAsyncNative,
+              OnnxLoadModelAsyncDart>('onnx_load_model_async')
+          : null,
+      loadModelDone: lib.providesSymbol('onnx_load_model_done')
+          ? lib.lookupFunction<OnnxLoadModelDoneNative, OnnxLoadModelDoneDart>(
+              'onnx_load_model_done')
+          : null,
+      loadModelFinish: lib.providesSymbol('onnx_load_model_finish')
+          ? lib.lookupFunction<OnnxLoadModelFinishNative,
+              OnnxLoadModelFinishDart>('onnx_load_model_finish')
+          : null,
+      loadModelCancel: lib.providesSymbol('onnx_load_model_cancel')
+          ? lib.lookupFunction<OnnxLoadModelCancelNative,
+              OnnxLoadModelCancelDart>('onnx_load_model_cancel')
+          : null,
+      setRuntimeSearchPaths: lib.providesSymbol('onnx_set_runtime_search_paths')
+          ? lib.lookupFunction<OnnxSetRuntimeSearchPathsNative,
+              OnnxSetRuntimeSearchPathsDart>('onnx_set_runtime_search_paths')
+          : null,
+      getRuntimePath: lib.providesSymbol('onnx_get_runtime_path')
+          ? lib.lookupFunction<OnnxGetRuntimePathNative,
+              OnnxGetRuntimePathDart>('onnx_get_runtime_path')
+          : null,
     );
   }
 
@@ -416,9 +1274,206 @@ class OnnxBindings {
       ),
       getLastErrorCode: lookup<OnnxGetLastErrorCodeNative,
           OnnxGetLastErrorCodeDart>('onnx_get_last_error_code'),
+      detectInto: _tryLookup(
+        () => lookup<OnnxDetectIntoNative, OnnxDetectIntoDart>(
+          'onnx_detect_into',
+        ),
+      ),
+      copyLastResult: _tryLookup(
+        () => lookup<OnnxCopyLastResultNative, OnnxCopyLastResultDart>(
+          'onnx_copy_last_result',
+        ),
+      ),
+      streamCreate: _tryLookup(
+        () => lookup<OnnxStreamCreateNative, OnnxStreamCreateDart>(
+          'onnx_stream_create',
+        ),
+      ),
+      streamPush: _tryLookup(
+        () => lookup<OnnxStreamPushNative, OnnxStreamPushDart>(
+          'onnx_stream_push',
+        ),
+      ),
+      streamFlush: _tryLookup(
+        () => lookup<OnnxStreamIntNative, OnnxStreamIntDart>(
+          'onnx_stream_flush',
+        ),
+      ),
+      streamBatchSize: _tryLookup(
+        () => lookup<OnnxStreamIntNative, OnnxStreamIntDart>(
+          'onnx_stream_batch_size',
+        ),
+      ),
+      streamNext: _tryLookup(
+        () => lookup<OnnxStreamNextNative, OnnxStreamNextDart>(
+          'onnx_stream_next',
+        ),
+      ),
+      streamDestroy: _tryLookup(
+        () => lookup<OnnxStreamDestroyNative, OnnxStreamDestroyDart>(
+          'onnx_stream_destroy',
+        ),
+      ),
+      acquireImageBuffer: _tryLookup(
+        () => lookup<OnnxAcquireImageBufferNative, OnnxAcquireImageBufferDart>(
+          'onnx_acquire_image_buffer',
+        ),
+      ),
+      releaseImageBuffer: _tryLookup(
+        () => lookup<OnnxReleaseImageBufferNative, OnnxReleaseImageBufferDart>(
+          'onnx_release_image_buffer',
+        ),
+      ),
+      trimImageBuffers: _tryLookup(
+        () => lookup<OnnxTrimImageBuffersNative, OnnxTrimImageBuffersDart>(
+          'onnx_trim_image_buffers',
+        ),
+      ),
+      getStats: _tryLookup(
+        () => lookup<OnnxGetStatsNative, OnnxGetStatsDart>('onnx_get_stats'),
+      ),
+      resetStats: _tryLookup(
+        () => lookup<OnnxResetStatsNative, OnnxResetStatsDart>(
+          'onnx_reset_stats',
+        ),
+      ),
+      startProfiling: _tryLookup(
+        () => lookup<OnnxStartProfilingNative, OnnxStartProfilingDart>(
+          'onnx_start_profiling',
+        ),
+      ),
+      stopProfiling: _tryLookup(
+        () => lookup<OnnxStopProfilingNative, OnnxStopProfilingDart>(
+          'onnx_stop_profiling',
+        ),
+      ),
+      loadModelWithOptions: _tryLookup(
+        () => lookup<OnnxLoadModelWithOptionsNative,
+            OnnxLoadModelWithOptionsDart>('onnx_load_model_with_options'),
+      ),
+      getMemoryUsage: _tryLookup(
+        () => lookup<OnnxGetMemoryUsageNative, OnnxGetMemoryUsageDart>(
+          'onnx_get_memory_usage',
+        ),
+      ),
+      trimMemory: _tryLookup(
+        () => lookup<OnnxTrimMemoryNative, OnnxTrimMemoryDart>(
+          'onnx_trim_memory',
+        ),
+      ),
+      initWithOptions: _tryLookup(
+        () => lookup<OnnxInitWithOptionsNative, OnnxInitWithOptionsDart>(
+          'onnx_init_with_options',
+        ),
+      ),
+      clientDefaultSocketPath: _tryLookup(
+        () => lookup<OnnxGetVersionNative, OnnxGetVersionDart>(
+          'onnx_client_default_socket_path',
+        ),
+      ),
+      clientConnect: _tryLookup(
+        () => lookup<OnnxClientConnectNative, OnnxClientConnectDart>(
+          'onnx_client_connect',
+        ),
+      ),
+      clientLoadModel: _tryLookup(
+        () => lookup<OnnxClientLoadModelNative, OnnxClientLoadModelDart>(
+          'onnx_client_load_model',
+        ),
+      ),
+      clientDetectBatch: _tryLookup(
+        () => lookup<OnnxDetectBatchNative, OnnxDetectBatchDart>(
+          'onnx_client_detect_batch',
+        ),
+      ),
+      clientDisconnect: _tryLookup(
+        () => lookup<OnnxClientDisconnectNative, OnnxClientDisconnectDart>(
+          'onnx_client_disconnect',
+        ),
+      ),
+      hashBytes: _tryLookup(
+        () => lookup<OnnxHashBytesNative, OnnxHashBytesDart>(
+          'onnx_hash_bytes',
+        ),
+      ),
+      enableRawCache: _tryLookup(
+        () => lookup<OnnxEnableRawCacheNative, OnnxEnableRawCacheDart>(
+          'onnx_enable_raw_cache',
+        ),
+      ),
+      detectCached: _tryLookup(
+        () => lookup<OnnxDetectCachedNative, OnnxDetectCachedDart>(
+          'onnx_detect_cached',
+        ),
+      ),
+      detectBatchKeyed: _tryLookup(
+        () => lookup<OnnxDetectBatchKeyedNative, OnnxDetectBatchKeyedDart>(
+          'onnx_detect_batch_keyed',
+        ),
+      ),
+      detectSweep: _tryLookup(
+        () => lookup<OnnxDetectSweepNative, OnnxDetectSweepDart>(
+          'onnx_detect_sweep',
+        ),
+      ),
+      hashFiles: _tryLookup(
+        () => lookup<OnnxHashFilesNative, OnnxHashFilesDart>(
+          'onnx_hash_files',
+        ),
+      ),
+      setDedup: _tryLookup(
+        () => lookup<OnnxSetDedupNative, OnnxSetDedupDart>(
+          'onnx_set_dedup',
+        ),
+      ),
+      detectBatchCascade: _tryLookup(
+        () => lookup<OnnxDetectBatchCascadeNative, OnnxDetectBatchCascadeDart>(
+          'onnx_detect_batch_cascade',
+        ),
+      ),
+      loadModelAsync: _tryLookup(
+        () => lookup<OnnxLoadModelAsyncNative, OnnxLoadModelAsyncDart>(
+          'onnx_load_model_async',
+        ),
+      ),
+      loadModelDone: _tryLookup(
+        () => lookup<OnnxLoadModelDoneNative, OnnxLoadModelDoneDart>(
+          'onnx_load_model_done',
+        ),
+      ),
+      loadModelFinish: _tryLookup(
+        () => lookup<OnnxLoadModelFinishNative, OnnxLoadModelFinishDart>(
+          'onnx_load_model_finish',
+        ),
+      ),
+      loadModelCancel: _tryLookup(
+        () => lookup<OnnxLoadModelCancelNative, OnnxLoadModelCancelDart>(
+          'onnx_load_model_cancel',
+        ),
+      ),
+      setRuntimeSearchPaths: _tryLookup(
+        () => lookup<OnnxSetRuntimeSearchPathsNative,
+            OnnxSetRuntimeSearchPathsDart>(
+          'onnx_set_runtime_search_paths',
+        ),
+      ),
+      getRuntimePath: _tryLookup(
+        () => lookup<OnnxGetRuntimePathNative, OnnxGetRuntimePathDart>(
+          'onnx_get_runtime_path',
+        ),
+      ),
     );
   }
 
+  /// 解析可选符号（旧版原生库缺失时返回 null）。
+  static T? _tryLookup<T>(T Function() resolve) {
+    try {
+      return resolve();
+    } catch (_) {
+      return null;
+    }
+  }
+
   final OnnxInitDart init;
   final OnnxCleanupDart cleanup;
   final OnnxLoadModelDart loadModel;
@@ -434,6 +1489,235 @@ class OnnxBindings {
   final OnnxGetAvailableProvidersDart getAvailableProviders;
   final OnnxGetLastErrorDart getLastError;
   final OnnxGetLastErrorCodeDart getLastErrorCode;
+
+  /// 写入调用方缓冲区的推理（可选，缺失时回退到 [detect]）。
+  final OnnxDetectIntoDart? detectInto;
+
+  /// 取回最近一次结果（可选，与 [detectInto] 配套）。
+  final OnnxCopyLastResultDart? copyLastResult;
+
+  /// 流式批量推理（可选，全部存在时 [OnnxInference.openBatchStream] 可用）。
+  final OnnxStreamCreateDart? streamCreate;
+  final OnnxStreamPushDart? streamPush;
+  final OnnxStreamIntDart? streamFlush;
+  final OnnxStreamIntDart? streamBatchSize;
+  final OnnxStreamNextDart? streamNext;
+  final OnnxStreamDestroyDart? streamDestroy;
+
+  /// 图像暂存池（可选，缺失时退回 calloc 临时拷贝）。
+  final OnnxAcquireImageBufferDart? acquireImageBuffer;
+  final OnnxReleaseImageBufferDart? releaseImageBuffer;
+  final OnnxTrimImageBuffersDart? trimImageBuffers;
+
+  /// 性能统计（可选，缺失时 [OnnxInference.getStats] 返回 null）。
+  final OnnxGetStatsDart? getStats;
+  final OnnxResetStatsDart? resetStats;
+
+  /// 性能分析（可选，缺失时 [OnnxInference.startProfiling] 返回 false）。
+  final OnnxStartProfilingDart? startProfiling;
+  final OnnxStopProfilingDart? stopProfiling;
+
+  /// 加载选项与内存回收（可选，缺失时忽略选项，[OnnxInference.trimMemory]
+  /// 返回 false）。
+  final OnnxLoadModelWithOptionsDart? loadModelWithOptions;
+  final OnnxGetMemoryUsageDart? getMemoryUsage;
+  final OnnxTrimMemoryDart? trimMemory;
+
+  /// 带选项初始化（可选，缺失时忽略选项）。
+  final OnnxInitWithOptionsDart? initWithOptions;
+
+  /// 本地推理守护进程客户端（可选，全部存在时 [OnnxDaemonClient] 可用）。
+  final OnnxGetVersionDart? clientDefaultSocketPath;
+  final OnnxClientConnectDart? clientConnect;
+  final OnnxClientLoadModelDart? clientLoadModel;
+  final OnnxDetectBatchDart? clientDetectBatch;
+  final OnnxClientDisconnectDart? clientDisconnect;
+
+  /// 原始输出缓存（可选，全部存在时 [OnnxInference.enableRawCache] 可用）。
+  final OnnxHashBytesDart? hashBytes;
+  final OnnxEnableRawCacheDart? enableRawCache;
+  final OnnxDetectCachedDart? detectCached;
+  final OnnxDetectBatchKeyedDart? detectBatchKeyed;
+
+  /// 多阈值扫描（可选，旧版原生库缺失）。
+  final OnnxDetectSweepDart? detectSweep;
+
+  /// 并行文件哈希（可选，旧版原生库缺失）。
+  final OnnxHashFilesDart? hashFiles;
+
+  /// 近重复跳过（可选，旧版原生库缺失）。
+  final OnnxSetDedupDart? setDedup;
+
+  /// 两级级联（可选，旧版原生库缺失）。
+  final OnnxDetectBatchCascadeDart? detectBatchCascade;
+
+  /// 后台加载（可选，全部存在时 [OnnxInference.loadModelAsync] 不阻塞）。
+  final OnnxLoadModelAsyncDart? loadModelAsync;
+  final OnnxLoadModelDoneDart? loadModelDone;
+  final OnnxLoadModelFinishDart? loadModelFinish;
+  final OnnxLoadModelCancelDart? loadModelCancel;
+
+  /// 运行时库搜索路径与实际加载路径（可选，旧版原生库缺失）。
+  final OnnxSetRuntimeSearchPathsDart? setRuntimeSearchPaths;
+  final OnnxGetRuntimePathDart? getRuntimePath;
+
+  /// 是否支持后台加载。
+  bool get supportsAsyncLoad =>
+      loadModelAsync != null &&
+      loadModelDone != null &&
+      loadModelFinish != null &&
+      loadModelCancel != null;
+
+  /// 是否支持图像暂存池。
+  bool get supportsImageBufferPool =>
+      acquireImageBuffer != null && releaseImageBuffer != null;
+
+  /// 是否支持流式批量推理。
+  bool get supportsBatchStream =>
+      streamCreate != null &&
+      streamPush != null &&
+      streamFlush != null &&
+      streamBatchSize != null &&
+      streamNext != null &&
+      streamDestroy != null;
+
+  /// 是否支持原始输出缓存。
+  bool get supportsRawCache =>
+      hashBytes != null &&
+      enableRawCache != null &&
+      detectCached != null &&
+      detectBatchKeyed != null;
+
+  /// 是否支持本地推理守护进程客户端。
+  bool get supportsDaemonClient =>
+      clientConnect != null &&
+      clientLoadModel != null &&
+      clientDetectBatch != null &&
+      clientDisconnect != null;
+}
+
+// ============================================================================
+// 图像暂存池
+// ============================================================================
+
+/// 原生暂存池中的图像缓冲区。
+///
+/// 直接把 RGBA 数据写入 [bytes]，再将 [bytes] 传给 [OnnxInference.detect]、
+/// [OnnxInference.detectBatch] 或 [OnnxBatchStream.push] 时不会再次拷贝。
+/// 使用完毕后调用 [OnnxInference.releaseImageBuffer] 归还。
+class OnnxImageBuffer {
+  OnnxImageBuffer._(this.pointer, this.bytes);
+
+  /// 原生缓冲区指针。
+  final Pointer<Uint8> pointer;
+
+  /// 原生内存上的可写视图（长度为申请的字节数）。
+  final Uint8List bytes;
+}
+
+// ============================================================================
+// 流式批量推理
+// ============================================================================
+
+/// 流式批量推理会话。
+///
+/// 逐张推入图片，原生层立即完成 letterbox 并按内存预算攒成微批次推理，
+/// 结果按推入顺序增量取回。峰值内存与提交的图片总数无关。
+class OnnxBatchStream {
+  OnnxBatchStream._(this._owner, this._bindings, this._handle);
+
+  final OnnxInference _owner;
+  final OnnxBindings _bindings;
+  Pointer<Void>? _handle;
+
+  /// 复用的 RGBA 暂存区（原生层推入时即完成预处理，可立即复用）。
+  Pointer<Uint8>? _staging;
+  int _stagingSize = 0;
+
+  /// 微批次大小（由原生层根据内存预算推导）。
+  int get batchSize {
+    final handle = _handle;
+    return handle == null ? 0 : _bindings.streamBatchSize!(handle);
+  }
+
+  /// 推入一张 RGBA 图片，返回是否成功。
+  ///
+  /// [tag] 随结果返回，用于还原图片顺序。
+  bool push(Uint8List imageData, int width, int height, int tag) {
+    final handle = _handle;
+    if (handle == null) return false;
+    final pooled = _owner._pooledViews[imageData];
+    if (pooled != null) {
+      return _bindings.streamPush!(handle, pooled, width, height, tag) == 0;
+    }
+    if (_stagingSize < imageData.length) {
+      if (_staging != null) calloc.free(_staging!);
+      _staging = calloc<Uint8>(imageData.length);
+      _stagingSize = imageData.length;
+    }
+    _staging!.asTypedList(imageData.length).setAll(0, imageData);
+    return _bindings.streamPush!(handle, _staging!, width, height, tag) == 0;
+  }
+
+  /// 对未满的微批次立即推理，返回是否成功。
+  bool flush() {
+    final handle = _handle;
+    if (handle == null) return false;
+    return _bindings.streamFlush!(handle) == 0;
+  }
+
+  /// 取出全部已完成的结果 (tag, detections)。
+  ///
+  /// 队列为空时结束；其他错误（如扩容后仍无法写入结果）抛出 [StateError]，
+  /// 避免结果被静默丢弃。
+  List<(int, List<Detection>)> drain() {
+    final handle = _handle;
+    if (handle == null) return const [];
+
+    final results = <(int, List<Detection>)>[];
+    final tagPtr = calloc<Int64>();
+    try {
+      while (true) {
+        var buffer = _owner._ensureResultBuffer(64, 4096);
+        var code = _bindings.streamNext!(handle, tagPtr, buffer);
+        if (code == OnnxInference._errorBufferTooSmall) {
+          buffer = _owner._ensureResultBuffer(
+            buffer.ref.requiredCapacity,
+            buffer.ref.requiredArena,
+          );
+          code = _bindings.streamNext!(handle, tagPtr, buffer);
+        }
+        if (code == OnnxInference._errorNoResult) break;
+        if (code != 0) {
+          throw StateError('取出流式结果失败 ($code): ${_owner.lastError}');
+        }
+        results.add((
+          tagPtr.value,
+          OnnxInference._readDetections(
+            buffer.ref.detections,
+            buffer.ref.count,
+          ),
+        ));
+      }
+    } finally {
+      calloc.free(tagPtr);
+    }
+    return results;
+  }
+
+  /// 关闭会话并释放原生资源（未取出的结果将被丢弃）。
+  void close() {
+    final handle = _handle;
+    if (handle != null) {
+      _bindings.streamDestroy!(handle);
+      _handle = null;
+    }
+    if (_staging != null) {
+      calloc.free(_staging!);
+      _staging = null;
+      _stagingSize = 0;
+    }
+  }
 }
 
 // ============================================================================
@@ -454,6 +1738,21 @@ class OnnxInference {
   bool _initialized = false;
   /// 当前模型句柄（由原生层返回）。
   Pointer<Void>? _modelHandle;
+  /// 级联重模型句柄（见 [loadCascadeModel]）。
+  Pointer<Void>? _cascadeHandle;
+  /// 后台加载中的模型（见 [loadModelAsync]）。
+  Pointer<Void>? _pendingLoad;
+  /// 跨调用复用的原生结果缓冲区（按需扩容，dispose 时释放）。
+  Pointer<NativeOnnxResultBuffer>? _resultBuffer;
+
+  /// 暂存池缓冲区视图到原生指针的映射（识别可零拷贝传入的数据）。
+  final Expando<Pointer<Uint8>> _pooledViews = Expando('onnx_image_buffer');
+
+  /// 原生错误码：结果缓冲区容量不足。
+  static const int _errorBufferTooSmall = 7;
+
+  /// 原生错误码：没有可取的结果。
+  static const int _errorNoResult = 8;
 
   OnnxInference._(this._bindings);
 
@@ -491,26 +1790,184 @@ class OnnxInference {
   }
 
   /// 初始化 ONNX Runtime。
-  bool initialize() {
-    if (_initialized) return true;
-    _initialized = _bindings.init();
-    return _initialized;
+  ///
+  /// [options] 需在加载模型前传入；已初始化且线程池模式不一致时返回 false。
+  /// 原生库不支持时忽略选项。
+  bool initialize({OnnxInitOptions? options}) {
+    final initWithOptions = _bindings.initWithOptions;
+    if (options == null || initWithOptions == null) {
+      if (_initialized) return true;
+      _initialized = _bindings.init();
+      return _initialized;
+    }
+
+    final nativeOptions = calloc<NativeOnnxInitOptions>();
+    final affinity = options.intraOpAffinity;
+    final affinityPtr = affinity == null ? nullptr : affinity.toNativeUtf8();
+    try {
+      nativeOptions.ref
+        ..useGlobalThreadPools = options.useGlobalThreadPools
+        ..allowSpinning = options.allowSpinning
+        ..intraOpThreads = options.intraOpThreads
+        ..interOpThreads = options.interOpThreads
+        ..intraOpAffinity = affinityPtr;
+      final ok = initWithOptions(nativeOptions);
+      _initialized = _initialized || ok;
+      return ok;
+    } finally {
+      if (affinityPtr != nullptr) {
+        calloc.free(affinityPtr);
+      }
+      calloc.free(nativeOptions);
+    }
+  }
+
+  /// 设置 ONNX Runtime 库的搜索路径（目录或库文件），需在首次初始化前调用。
+  ///
+  /// 空列表恢复默认搜索顺序。运行时库已加载、链接时绑定或原生库不支持时
+  /// 返回 false。
+  bool setRuntimeSearchPaths(List<String> paths) {
+    final setPaths = _bindings.setRuntimeSearchPaths;
+    if (setPaths == null) return false;
+    final pathsPtr = paths.join(Platform.isWindows ? ';' : ':').toNativeUtf8();
+    try {
+      return setPaths(pathsPtr);
+    } finally {
+      calloc.free(pathsPtr);
+    }
+  }
+
+  /// 实际加载的 ONNX Runtime 库路径（未加载、链接时绑定或原生库不支持时为 null）。
+  String? get runtimePath {
+    final getPath = _bindings.getRuntimePath;
+    if (getPath == null) return null;
+    final path = getPath().toDartString();
+    return path.isEmpty ? null : path;
   }
 
   /// 当前模型句柄是否有效。
   bool get _hasValidModel =>
       _modelHandle != null && _modelHandle!.address != 0;
 
-  /// 将 RGBA 数据拷贝到原生堆内存（调用方负责释放）。
-  Pointer<Uint8> _copyImageToNative(Uint8List imageData) {
-    final ptr = calloc<Uint8>(imageData.length);
+  /// 将 RGBA 数据暂存到原生内存。
+  ///
+  /// 暂存池缓冲区的视图直接返回其指针，不拷贝（owned 为 false）；
+  /// 其余数据拷贝到池缓冲区（不支持暂存池时使用 calloc），
+  /// owned 为 true，需经 [_releaseStaged] 释放。
+  (Pointer<Uint8>, bool) _stageImage(Uint8List imageData) {
+    final pooled = _pooledViews[imageData];
+    if (pooled != null) {
+      return (pooled, false);
+    }
+    final Pointer<Uint8> ptr;
+    if (_bindings.supportsImageBufferPool) {
+      ptr = _bindings.acquireImageBuffer!(imageData.length);
+      if (ptr.address == 0) {
+        throw StateError('图像缓冲区分配失败: ${imageData.length} 字节');
+      }
+    } else {
+      ptr = calloc<Uint8>(imageData.length);
+    }
     ptr.asTypedList(imageData.length).setAll(0, imageData);
-    return ptr;
+    return (ptr, true);
+  }
+
+  /// 释放 [_stageImage] 拷贝出的原生内存。
+  void _releaseStaged(Pointer<Uint8> ptr) {
+    if (_bindings.supportsImageBufferPool) {
+      _bindings.releaseImageBuffer!(ptr);
+    } else {
+      calloc.free(ptr);
+    }
+  }
+
+  /// 确保结果缓冲区至少具备指定容量，返回缓冲区指针。
+  Pointer<NativeOnnxResultBuffer> _ensureResultBuffer(
+    int capacity,
+    int arenaBytes,
+  ) {
+    var buffer = _resultBuffer;
+    if (buffer == null) {
+      buffer = calloc<NativeOnnxResultBuffer>();
+      _resultBuffer = buffer;
+    }
+    final ref = buffer.ref;
+    if (ref.capacity < capacity) {
+      if (ref.detections.address != 0) calloc.free(ref.detections);
+      ref.detections = calloc<NativeDetection>(capacity);
+      ref.capacity = capacity;
+    }
+    if (ref.arenaCapacity < arenaBytes) {
+      if (ref.arena.address != 0) calloc.free(ref.arena);
+      ref.arena = calloc<Uint8>(arenaBytes);
+      ref.arenaCapacity = arenaBytes;
+    }
+    return buffer;
+  }
+
+  /// 释放结果缓冲区。
+  void _freeResultBuffer() {
+    final buffer = _resultBuffer;
+    if (buffer == null) return;
+    if (buffer.ref.detections.address != 0) {
+      calloc.free(buffer.ref.detections);
+    }
+    if (buffer.ref.arena.address != 0) calloc.free(buffer.ref.arena);
+    calloc.free(buffer);
+    _resultBuffer = null;
+  }
+
+  /// 将原生检测数组转换为 Dart 对象。
+  static List<Detection> _readDetections(
+    Pointer<NativeDetection> ptr,
+    int count,
+  ) {
+    final detections = <Detection>[];
+    for (int i = 0; i < count; i++) {
+      final det = ptr[i];
+
+      // 解析关键点。
+      List<Keypoint>? keypoints;
+      if (det.numKeypoints > 0 && det.keypoints.address != 0) {
+        keypoints = [];
+        for (int k = 0; k < det.numKeypoints; k++) {
+          keypoints.add(Keypoint(
+            x: det.keypoints[k * 3 + 0],
+            y: det.keypoints[k * 3 + 1],
+            visibility: det.keypoints[k * 3 + 2],
+          ));
+        }
+      }
+
+      // 解析多边形。
+      List<PolygonPoint>? polygon;
+      if (det.numPolygonPoints > 0 && det.polygon.address != 0) {
+        polygon = [
+          for (int k = 0; k < det.numPolygonPoints; k++)
+            PolygonPoint(x: det.polygon[k * 2], y: det.polygon[k * 2 + 1]),
+        ];
+      }
+
+      detections.add(Detection(
+        classId: det.classId,
+        confidence: det.confidence,
+        x: det.x,
+        y: det.y,
+        width: det.width,
+        height: det.height,
+        keypoints: keypoints,
+        polygon: polygon,
+        angle: det.angle,
+      ));
+    }
+    return detections;
   }
 
   /// 清理 ONNX Runtime。
   void dispose() {
+    unloadCascadeModel();
     unloadModel();
+    _freeResultBuffer();
     if (_initialized) {
       _bindings.cleanup();
       _initialized = false;
@@ -521,16 +1978,37 @@ class OnnxInference {
   ///
   /// [modelPath] - .onnx 模型文件路径。
   /// [useGpu] - 是否尝试使用 GPU 加速。
-  bool loadModel(String modelPath, {bool useGpu = false}) {
+  /// [options] - 内存池等加载选项（原生库不支持时忽略）。
+  bool loadModel(
+    String modelPath, {
+    bool useGpu = false,
+    OnnxLoadOptions? options,
+  }) {
     if (!_initialized && !initialize()) {
       return false;
     }
 
     unloadModel();
 
+    final loadWithOptions = _bindings.loadModelWithOptions;
     final pathPtr = modelPath.toNativeUtf8();
     try {
-      _modelHandle = _bindings.loadModel(pathPtr, useGpu);
+      if (options != null && loadWithOptions != null) {
+        final nativeOptions = calloc<NativeOnnxLoadOptions>();
+        try {
+          nativeOptions.ref
+            ..useGpu = useGpu
+            ..enableCpuArena = options.enableCpuArena
+            ..enableMemPattern = options.enableMemPattern
+            ..arenaExtendStrategy = options.arenaExtendStrategy.index
+            ..arenaInitialChunkBytes = options.arenaInitialChunkBytes;
+          _modelHandle = loadWithOptions(pathPtr, nativeOptions);
+        } finally {
+          calloc.free(nativeOptions);
+        }
+      } else {
+        _modelHandle = _bindings.loadModel(pathPtr, useGpu);
+      }
     } finally {
       calloc.free(pathPtr);
     }
@@ -538,15 +2016,118 @@ class OnnxInference {
     return _modelHandle != null && _modelHandle!.address != 0;
   }
 
+  /// 是否正在后台加载模型。
+  bool get isLoadingAsync => _pendingLoad != null;
+
+  /// 在原生后台线程加载并预热模型，完成后替换当前模型。
+  ///
+  /// 加载期间当前模型继续推理，调用方不阻塞；加载成功后一次性替换句柄并
+  /// 卸载旧模型，旧模型上未关闭的流式会话照常完成后才释放。失败时保留
+  /// 当前模型。再次调用、[loadModel] 或 [unloadModel] 会放弃未完成的加载，
+  /// 被放弃的调用返回 false。原生库不支持时退回同步 [loadModel]。
+  Future<bool> loadModelAsync(
+    String modelPath, {
+    bool useGpu = false,
+    OnnxLoadOptions options = const OnnxLoadOptions(),
+    Duration pollInterval = const Duration(milliseconds: 10),
+  }) async {
+    if (!_bindings.supportsAsyncLoad) {
+      return loadModel(modelPath, useGpu: useGpu, options: options);
+    }
+    if (!_initialized && !initialize()) {
+      return false;
+    }
+    _cancelPendingLoad();
+
+    final pathPtr = modelPath.toNativeUtf8();
+    final nativeOptions = calloc<NativeOnnxLoadOptions>();
+    final Pointer<Void> load;
+    try {
+      nativeOptions.ref
+        ..useGpu = useGpu
+        ..enableCpuArena = options.enableCpuArena
+        ..enableMemPattern = options.enableMemPattern
+        ..arenaExtendStrategy = options.arenaExtendStrategy.index
+        ..arenaInitialChunkBytes = options.arenaInitialChunkBytes;
+      load = _bindings.loadModelAsync!(pathPtr, nativeOptions);
+    } finally {
+      calloc.free(nativeOptions);
+      calloc.free(pathPtr);
+    }
+    if (load.address == 0) {
+      return false;
+    }
+
+    _pendingLoad = load;
+    while (_bindings.loadModelDone!(load) == 0) {
+      await Future<void>.delayed(pollInterval);
+      // 已被后续调用放弃（原生侧负责释放）。
+      if (_pendingLoad != load) {
+        return false;
+      }
+    }
+    _pendingLoad = null;
+    final handle = _bindings.loadModelFinish!(load);
+    if (handle.address == 0) {
+      return false;
+    }
+    final previous = _modelHandle;
+    _modelHandle = handle;
+    if (previous != null && previous.address != 0) {
+      _bindings.unloadModel(previous);
+    }
+    return true;
+  }
+
+  /// 放弃未完成的后台加载（不等待，模型由原生后台线程卸载）。
+  void _cancelPendingLoad() {
+    final load = _pendingLoad;
+    _pendingLoad = null;
+    if (load != null) {
+      _bindings.loadModelCancel!(load);
+    }
+  }
+
   /// 卸载当前模型。
   void unloadModel() {
+    _cancelPendingLoad();
     if (_hasValidModel) {
       _bindings.unloadModel(_modelHandle!);
       _modelHandle = null;
     }
   }
 
-  /// 获取模型期望的输入尺寸。
+  /// 原生库是否支持两级级联。
+  bool get supportsCascade => _bindings.detectBatchCascade != null;
+
+  /// 加载级联重模型（如 yolov8x），与 [loadModel] 加载的快速模型配合
+  /// [detectBatchCascade] 使用；替换已加载的重模型。
+  ///
+  /// 原生库不支持或加载失败时返回 false。
+  bool loadCascadeModel(String modelPath, {bool useGpu = false}) {
+    if (!supportsCascade || (!_initialized && !initialize())) {
+      return false;
+    }
+    unloadCascadeModel();
+    final pathPtr = modelPath.toNativeUtf8();
+    try {
+      _cascadeHandle = _bindings.loadModel(pathPtr, useGpu);
+    } finally {
+      calloc.free(pathPtr);
+    }
+    return _cascadeHandle!.address != 0;
+  }
+
+  /// 卸载级联重模型。
+  void unloadCascadeModel() {
+    final handle = _cascadeHandle;
+    _cascadeHandle = null;
+    if (handle != null && handle.address != 0) {
+      _bindings.unloadModel(handle);
+    }
+  }
+
+  /// 获取模型期望的输入尺寸。
   ///
   /// 未加载模型时返回 null。
   (int width, int height)? getInputSize() {
@@ -587,11 +2168,39 @@ class OnnxInference {
       return [];
     }
 
-    Pointer<Uint8>? imagePtr;
+    final (imagePtr, ownsImage) = _stageImage(imageData);
     Pointer<NativeDetectionResult> resultPtr = Pointer.fromAddress(0);
 
     try {
-      imagePtr = _copyImageToNative(imageData);
+
+      // 优先写入复用缓冲区，避免每次调用的原生结果分配。
+      final detectInto = _bindings.detectInto;
+      final copyLastResult = _bindings.copyLastResult;
+      if (detectInto != null && copyLastResult != null) {
+        var buffer = _ensureResultBuffer(64, 4096);
+        var code = detectInto(
+          _modelHandle!,
+          imagePtr,
+          width,
+          height,
+          confThreshold,
+          nmsThreshold,
+          modelType.index,
+          numKeypoints,
+          buffer,
+        );
+        if (code == _errorBufferTooSmall) {
+          buffer = _ensureResultBuffer(
+            buffer.ref.requiredCapacity,
+            buffer.ref.requiredArena,
+          );
+          code = copyLastResult(_modelHandle!, buffer);
+        }
+        if (code != 0) {
+          return [];
+        }
+        return _readDetections(buffer.ref.detections, buffer.ref.count);
+      }
 
       resultPtr = _bindings.detect(
         _modelHandle!,
@@ -609,39 +2218,10 @@ class OnnxInference {
       }
 
       final result = resultPtr.ref;
-      final detections = <Detection>[];
-
-      for (int i = 0; i < result.count; i++) {
-        final det = result.detections[i];
-
-        // 解析关键点。
-        List<Keypoint>? keypoints;
-        if (det.numKeypoints > 0 && det.keypoints.address != 0) {
-          keypoints = [];
-          for (int k = 0; k < det.numKeypoints; k++) {
-            keypoints.add(Keypoint(
-              x: det.keypoints[k * 3 + 0],
-              y: det.keypoints[k * 3 + 1],
-              visibility: det.keypoints[k * 3 + 2],
-            ));
-          }
-        }
-
-        detections.add(Detection(
-          classId: det.classId,
-          confidence: det.confidence,
-          x: det.x,
-          y: det.y,
-          width: det.width,
-          height: det.height,
-          keypoints: keypoints,
-        ));
-      }
-
-      return detections;
+      return _readDetections(result.detections, result.count);
     } finally {
-      if (imagePtr != null) {
-        calloc.free(imagePtr);
+      if (ownsImage) {
+        _releaseStaged(imagePtr);
       }
       if (resultPtr.address != 0) {
         _bindings.freeResult(resultPtr);
@@ -664,12 +2244,66 @@ class OnnxInference {
     double nmsThreshold = 0.45,
     ModelType modelType = ModelType.yolo,
     int numKeypoints = 17,
+  }) {
+    return _detectBatch(
+      imageList,
+      sizes,
+      null,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  /// 两级级联批量推理。
+  ///
+  /// 快速模型（[loadModel]）先推理全部图片，不确定检测数达到
+  /// [OnnxCascadeOptions.minUncertain] 或无检测的图片再由重模型
+  /// （[loadCascadeModel]）推理并替换结果。两个模型须输出相同的类别。
+  /// 未加载重模型或原生库不支持时等同于 [detectBatch]。
+  List<List<Detection>> detectBatchCascade(
+    List<Uint8List> imageList,
+    List<(int, int)> sizes, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+    OnnxCascadeOptions options = const OnnxCascadeOptions(),
+  }) {
+    final heavy = _cascadeHandle;
+    return _detectBatch(
+      imageList,
+      sizes,
+      null,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+      cascade: supportsCascade && heavy != null && heavy.address != 0
+          ? options
+          : null,
+    );
+  }
+
+  /// 批量推理实现；[imageKeys] 非空时经带缓存键的接口写入原始输出缓存，
+  /// [cascade] 非空时经两级级联接口推理。
+  List<List<Detection>> _detectBatch(
+    List<Uint8List> imageList,
+    List<(int, int)> sizes,
+    List<int>? imageKeys, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+    OnnxCascadeOptions? cascade,
   }) {
     if (!_hasValidModel || imageList.isEmpty) {
       return List.filled(imageList.length, []);
     }
     
-    if (imageList.length != sizes.length) {
+    if (imageList.length != sizes.length ||
+        (imageKeys != null && imageKeys.length != imageList.length)) {
       throw ArgumentError('图像列表和尺寸列表长度必须一致');
     }
 
@@ -678,32 +2312,73 @@ class OnnxInference {
     final imageListPtr = calloc<Pointer<Uint8>>(numImages);
     final widthListPtr = calloc<Int32>(numImages);
     final heightListPtr = calloc<Int32>(numImages);
+    final Pointer<Uint64> keysPtr =
+        imageKeys == null ? nullptr : calloc<Uint64>(numImages);
+    final Pointer<NativeOnnxCascadeOptions> cascadePtr =
+        cascade == null ? nullptr : calloc<NativeOnnxCascadeOptions>();
     final imagePtrs = <Pointer<Uint8>>[];
     Pointer<NativeBatchDetectionResult> resultPtr = Pointer.fromAddress(0);
 
     try {
       // 填充图像数据和尺寸。
       for (int i = 0; i < numImages; i++) {
-        final imageData = imageList[i];
-        final imagePtr = _copyImageToNative(imageData);
-        imagePtrs.add(imagePtr);
+        final (imagePtr, ownsImage) = _stageImage(imageList[i]);
+        if (ownsImage) {
+          imagePtrs.add(imagePtr);
+        }
         imageListPtr[i] = imagePtr;
         
         widthListPtr[i] = sizes[i].$1;
         heightListPtr[i] = sizes[i].$2;
+        if (imageKeys != null) keysPtr[i] = imageKeys[i];
       }
 
-      resultPtr = _bindings.detectBatch(
-        _modelHandle!,
-        imageListPtr,
-        numImages,
-        widthListPtr,
-        heightListPtr,
-        confThreshold,
-        nmsThreshold,
-        modelType.index,
-        numKeypoints,
-      );
+      if (cascade != null) {
+        cascadePtr.ref
+          ..uncertainLow = cascade.uncertainLow
+          ..uncertainHigh = cascade.uncertainHigh
+          ..minUncertain = cascade.minUncertain
+          ..escalateEmpty = cascade.escalateEmpty
+          ..heavyBatchSize = cascade.heavyBatchSize;
+        resultPtr = _bindings.detectBatchCascade!(
+          _modelHandle!,
+          _cascadeHandle!,
+          imageListPtr,
+          numImages,
+          widthListPtr,
+          heightListPtr,
+          confThreshold,
+          nmsThreshold,
+          modelType.index,
+          numKeypoints,
+          cascadePtr,
+        );
+      } else if (imageKeys != null) {
+        resultPtr = _bindings.detectBatchKeyed!(
+          _modelHandle!,
+          imageListPtr,
+          keysPtr,
+          numImages,
+          widthListPtr,
+          heightListPtr,
+          confThreshold,
+          nmsThreshold,
+          modelType.index,
+          numKeypoints,
+        );
+      } else {
+        resultPtr = _bindings.detectBatch(
+          _modelHandle!,
+          imageListPtr,
+          numImages,
+          widthListPtr,
+          heightListPtr,
+          confThreshold,
+          nmsThreshold,
+          modelType.index,
+          numKeypoints,
+        );
+      }
       
       if (resultPtr.address == 0) {
         return List.filled(numImages, []);
@@ -714,34 +2389,7 @@ class OnnxInference {
       
       for (int i = 0; i < batchResult.numImages; i++) {
         final result = batchResult.results[i]; // 指针算术自动处理。
-        final detections = <Detection>[];
-
-        for (int k = 0; k < result.count; k++) {
-          final det = result.detections[k];
-
-          // 解析关键点。
-          List<Keypoint>? keypoints;
-          if (det.numKeypoints > 0 && det.keypoints.address != 0) {
-            keypoints = [];
-            for (int m = 0; m < det.numKeypoints; m++) {
-              keypoints.add(Keypoint(
-                x: det.keypoints[m * 3 + 0],
-                y: det.keypoints[m * 3 + 1],
-                visibility: det.keypoints[m * 3 + 2],
-              ));
-            }
-          }
-
-          detections.add(Detection(
-            classId: det.classId,
-            confidence: det.confidence,
-            x: det.x,
-            y: det.y,
-            width: det.width,
-            height: det.height,
-            keypoints: keypoints,
-          ));
-        }
+        final detections = _readDetections(result.detections, result.count);
         allDetections.add(detections);
       }
       
@@ -753,14 +2401,395 @@ class OnnxInference {
       }
       // 释放临时内存。
       for (final ptr in imagePtrs) {
-        calloc.free(ptr);
+        _releaseStaged(ptr);
       }
+      // 按本批次的使用高水位收缩暂存池，避免一次大批次长期占用内存。
+      _bindings.trimImageBuffers?.call();
       calloc.free(imageListPtr);
       calloc.free(widthListPtr);
       calloc.free(heightListPtr);
+      if (keysPtr != nullptr) calloc.free(keysPtr);
+      if (cascadePtr != nullptr) calloc.free(cascadePtr);
+    }
+  }
+
+  /// 原生库是否支持原始输出缓存。
+  bool get supportsRawCache => _bindings.supportsRawCache;
+
+  /// 计算内容哈希，作为 [detectCached] / [detectBatchKeyed] 的缓存键。
+  ///
+  /// 通常对编码后的图片文件字节计算，命中缓存时无需解码。
+  /// 原生库不支持时返回 null。
+  int? hashBytes(Uint8List data) {
+    final hashBytes = _bindings.hashBytes;
+    if (hashBytes == null) {
+      return null;
+    }
+    final ptr = calloc<Uint8>(data.isEmpty ? 1 : data.length);
+    try {
+      ptr.asTypedList(data.length).setAll(0, data);
+      return hashBytes(ptr, data.length);
+    } finally {
+      calloc.free(ptr);
+    }
+  }
+
+  /// 并行计算多个文件的内容哈希。
+  ///
+  /// 结果与对整个文件内容调用 [hashBytes] 一致，可直接用作缓存键；
+  /// 无法读取的文件对应 null。无需加载模型。原生库不支持时返回 null。
+  List<int?>? hashFiles(List<String> paths) {
+    final hashFiles = _bindings.hashFiles;
+    if (hashFiles == null) {
+      return null;
+    }
+    if (paths.isEmpty) {
+      return const [];
+    }
+    final pathPtrs = calloc<Pointer<Utf8>>(paths.length);
+    final hashesPtr = calloc<Uint64>(paths.length);
+    final okPtr = calloc<Uint8>(paths.length);
+    try {
+      for (int i = 0; i < paths.length; i++) {
+        pathPtrs[i] = paths[i].toNativeUtf8();
+      }
+      if (hashFiles(pathPtrs, paths.length, hashesPtr, okPtr) < 0) {
+        return null;
+      }
+      return [
+        for (int i = 0; i < paths.length; i++)
+          okPtr[i] != 0 ? hashesPtr[i] : null,
+      ];
+    } finally {
+      for (int i = 0; i < paths.length; i++) {
+        if (pathPtrs[i].address != 0) {
+          calloc.free(pathPtrs[i]);
+        }
+      }
+      calloc.free(pathPtrs);
+      calloc.free(hashesPtr);
+      calloc.free(okPtr);
+    }
+  }
+
+  /// 为当前模型启用原始输出缓存（[directory] 为 null 时关闭）。
+  ///
+  /// 缓存 NMS 前的候选框，仅阈值变化的重复推理可经 [detectCached]
+  /// 直接重做后处理。分割模型不缓存。未加载模型或原生库不支持时返回 false。
+  bool enableRawCache(String? directory) {
+    if (!_hasValidModel || !_bindings.supportsRawCache) {
+      return false;
+    }
+    final dirPtr = directory == null || directory.isEmpty
+        ? nullptr
+        : directory.toNativeUtf8();
+    try {
+      return _bindings.enableRawCache!(_modelHandle!, dirPtr) == 0;
+    } finally {
+      if (dirPtr != nullptr) calloc.free(dirPtr);
+    }
+  }
+
+  /// 设置当前模型批量推理的近重复跳过（[maxDistance] 为 null 时关闭）。
+  ///
+  /// 开启后与上一张实际推理的图片尺寸相同、感知哈希汉明距离不超过
+  /// [maxDistance]（0-64）的图片直接复用其检测结果，跳过数计入
+  /// [OnnxStats.dedupSkipped]。未加载模型或原生库不支持时返回 false。
+  bool setDedupDistance(int? maxDistance) {
+    final setDedup = _bindings.setDedup;
+    if (!_hasValidModel || setDedup == null) {
+      return false;
+    }
+    return setDedup(_modelHandle!, maxDistance ?? -1) == 0;
+  }
+
+  /// 从原始输出缓存取结果（不运行模型），未命中时返回 null。
+  List<Detection>? detectCached(
+    int imageKey, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    if (!_hasValidModel || !_bindings.supportsRawCache) {
+      return null;
+    }
+    final resultPtr = _bindings.detectCached!(
+      _modelHandle!,
+      imageKey,
+      confThreshold,
+      nmsThreshold,
+      modelType.index,
+      numKeypoints,
+    );
+    if (resultPtr.address == 0) {
+      return null;
+    }
+    try {
+      return _readDetections(resultPtr.ref.detections, resultPtr.ref.count);
+    } finally {
+      _bindings.freeResult(resultPtr);
+    }
+  }
+
+  /// 批量推理并写入原始输出缓存（[imageKeys] 与 [imageList] 一一对应）。
+  ///
+  /// 原生库不支持时等同 [detectBatch]。
+  List<List<Detection>> detectBatchKeyed(
+    List<int> imageKeys,
+    List<Uint8List> imageList,
+    List<(int, int)> sizes, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    return _detectBatch(
+      imageList,
+      sizes,
+      _bindings.supportsRawCache ? imageKeys : null,
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    );
+  }
+
+  /// 原生库是否支持多阈值扫描。
+  bool get supportsSweep => _bindings.detectSweep != null;
+
+  /// 单次推理的多阈值扫描。
+  ///
+  /// 只运行一次模型，返回 [confThresholds] × [nmsThresholds] 每种组合的
+  /// 检测结果，与以对应阈值调用 [detect] 一致。[nmsThresholds] 至多 32 个。
+  /// 未加载模型、原生库不支持或推理失败时返回 null。
+  OnnxSweepResult? detectSweep(
+    Uint8List imageData,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    final detectSweep = _bindings.detectSweep;
+    if (!_hasValidModel ||
+        detectSweep == null ||
+        confThresholds.isEmpty ||
+        nmsThresholds.isEmpty) {
+      return null;
+    }
+
+    final (imagePtr, ownsImage) = _stageImage(imageData);
+    final confPtr = calloc<Float>(confThresholds.length);
+    final nmsPtr = calloc<Float>(nmsThresholds.length);
+    Pointer<NativeBatchDetectionResult> resultPtr = Pointer.fromAddress(0);
+    try {
+      confPtr.asTypedList(confThresholds.length).setAll(0, confThresholds);
+      nmsPtr.asTypedList(nmsThresholds.length).setAll(0, nmsThresholds);
+      resultPtr = detectSweep(
+        _modelHandle!,
+        imagePtr,
+        width,
+        height,
+        confPtr,
+        confThresholds.length,
+        nmsPtr,
+        nmsThresholds.length,
+        modelType.index,
+        numKeypoints,
+      );
+      if (resultPtr.address == 0) {
+        return null;
+      }
+      final batchResult = resultPtr.ref;
+      return OnnxSweepResult(
+        confThresholds: List.unmodifiable(confThresholds),
+        nmsThresholds: List.unmodifiable(nmsThresholds),
+        results: [
+          for (int i = 0; i < batchResult.numImages; i++)
+            _readDetections(
+              batchResult.results[i].detections,
+              batchResult.results[i].count,
+            ),
+        ],
+      );
+    } finally {
+      if (resultPtr.address != 0) {
+        _bindings.freeBatchResult(resultPtr);
+      }
+      if (ownsImage) {
+        _releaseStaged(imagePtr);
+      }
+      calloc.free(confPtr);
+      calloc.free(nmsPtr);
+    }
+  }
+
+  /// 从原生暂存池申请图像缓冲区。
+  ///
+  /// 返回的 [OnnxImageBuffer.bytes] 可直接写入 RGBA 数据并零拷贝传入推理接口。
+  /// 原生库不支持暂存池或分配失败时返回 null。
+  OnnxImageBuffer? acquireImageBuffer(int size) {
+    if (size <= 0 || !_bindings.supportsImageBufferPool) {
+      return null;
+    }
+    final ptr = _bindings.acquireImageBuffer!(size);
+    if (ptr.address == 0) {
+      return null;
+    }
+    final bytes = ptr.asTypedList(size);
+    _pooledViews[bytes] = ptr;
+    return OnnxImageBuffer._(ptr, bytes);
+  }
+
+  /// 归还图像缓冲区（归还后不可再访问 [OnnxImageBuffer.bytes]）。
+  void releaseImageBuffer(OnnxImageBuffer buffer) {
+    _pooledViews[buffer.bytes] = null;
+    _bindings.releaseImageBuffer?.call(buffer.pointer);
+  }
+
+  /// 回收暂存池中超出近期使用高水位的缓存，返回释放的字节数。
+  int trimImageBuffers() => _bindings.trimImageBuffers?.call() ?? 0;
+
+  /// 获取当前模型的性能统计。
+  ///
+  /// 未加载模型或原生库不支持时返回 null。
+  OnnxStats? getStats() {
+    final getStats = _bindings.getStats;
+    if (!_hasValidModel || getStats == null) {
+      return null;
+    }
+    final nativeStats = calloc<NativeOnnxStats>();
+    try {
+      if (getStats(_modelHandle!, nativeStats) != 0) {
+        return null;
+      }
+      final ref = nativeStats.ref;
+      return OnnxStats(
+        stages: {
+          for (final stage in OnnxStage.values)
+            stage: OnnxStageTiming(
+              lastMs: ref.lastMs[stage.index],
+              p50Ms: ref.p50Ms[stage.index],
+              p95Ms: ref.p95Ms[stage.index],
+              p99Ms: ref.p99Ms[stage.index],
+            ),
+        },
+        calls: ref.calls,
+        images: ref.images,
+        candidates: ref.candidates,
+        detections: ref.detections,
+        bytesAllocated: ref.bytesAllocated,
+        dedupSkipped: ref.dedupSkipped,
+        cascadeImages: ref.cascadeImages,
+        cascadeEscalated: ref.cascadeEscalated,
+      );
+    } finally {
+      calloc.free(nativeStats);
+    }
+  }
+
+  /// 清零当前模型的性能统计。
+  void resetStats() {
+    if (!_hasValidModel) return;
+    _bindings.resetStats?.call(_modelHandle!);
+  }
+
+  /// 开启性能分析，[stopProfiling] 时将 ORT 算子与插件各阶段合并写入
+  /// [tracePath]（Chrome trace JSON，可用 Perfetto 打开）。
+  ///
+  /// 未加载模型、原生库不支持或开启失败时返回 false。
+  bool startProfiling(String tracePath) {
+    final startProfiling = _bindings.startProfiling;
+    if (!_hasValidModel || startProfiling == null) {
+      return false;
+    }
+    final pathPtr = tracePath.toNativeUtf8();
+    try {
+      return startProfiling(_modelHandle!, pathPtr) == 0;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  /// 结束性能分析并写出 trace 文件，成功返回 true。
+  bool stopProfiling() {
+    final stopProfiling = _bindings.stopProfiling;
+    if (!_hasValidModel || stopProfiling == null) {
+      return false;
+    }
+    return stopProfiling(_modelHandle!) == 0;
+  }
+
+  /// 获取当前模型的内存占用。
+  ///
+  /// 未加载模型或原生库不支持时返回 null。
+  OnnxMemoryUsage? getMemoryUsage() {
+    final getMemoryUsage = _bindings.getMemoryUsage;
+    if (!_hasValidModel || getMemoryUsage == null) {
+      return null;
+    }
+    final nativeUsage = calloc<NativeOnnxMemoryUsage>();
+    try {
+      if (getMemoryUsage(_modelHandle!, nativeUsage) != 0) {
+        return null;
+      }
+      final ref = nativeUsage.ref;
+      int? known(int bytes) => bytes < 0 ? null : bytes;
+      return OnnxMemoryUsage(
+        arenaReservedBytes: known(ref.arenaReservedBytes),
+        arenaInUseBytes: known(ref.arenaInUseBytes),
+        pluginReservedBytes: ref.pluginReservedBytes,
+        processRssBytes: known(ref.processRssBytes),
+        arenaTrimmedBytes: known(ref.arenaTrimmedBytes),
+      );
+    } finally {
+      calloc.free(nativeUsage);
     }
   }
 
+  /// 回收当前模型的空闲内存（适合在批量任务结束后调用）。
+  ///
+  /// 句柄缓冲区立即释放，ORT 内存池以一次空白推理立即收缩，
+  /// 归还量见 [OnnxMemoryUsage.arenaTrimmedBytes]。
+  /// 未加载模型或原生库不支持时返回 false。
+  bool trimMemory() {
+    final trimMemory = _bindings.trimMemory;
+    if (!_hasValidModel || trimMemory == null) {
+      return false;
+    }
+    return trimMemory(_modelHandle!) == 0;
+  }
+
+  /// 打开流式批量推理会话。
+  ///
+  /// [memoryBudgetBytes] 为原生微批次的内存预算，<= 0 使用默认值。
+  /// 未加载模型或原生库不支持时返回 null。调用方需在卸载模型前 [OnnxBatchStream.close]。
+  OnnxBatchStream? openBatchStream({
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+    int memoryBudgetBytes = 0,
+  }) {
+    if (!_hasValidModel || !_bindings.supportsBatchStream) {
+      return null;
+    }
+    final handle = _bindings.streamCreate!(
+      _modelHandle!,
+      confThreshold,
+      nmsThreshold,
+      modelType.index,
+      numKeypoints,
+      memoryBudgetBytes,
+    );
+    if (handle.address == 0) {
+      return null;
+    }
+    return OnnxBatchStream._(this, _bindings, handle);
+  }
+
   /// 获取插件版本。
   String get version {
     final ptr = _bindings.getVersion();
@@ -839,3 +2868,174 @@ class OnnxInference {
     }
   }
 }
+
+// ============================================================================
+// 本地推理守护进程客户端
+// ============================================================================
+
+/// 本地推理守护进程（label_load_daemon）客户端。
+///
+/// 模型由守护进程持有，多个应用实例与命令行工具共享；并发请求在守护进程内
+/// 合并为微批次。图片经共享内存传递。仅 Linux / macOS 可用。
+class OnnxDaemonClient {
+  OnnxDaemonClient._(this._bindings, this._handle);
+
+  /// 原生错误码：守护进程不可用（未运行或连接已断开）。
+  static const int errorDaemonUnavailable = 9;
+
+  final OnnxBindings _bindings;
+  Pointer<Void>? _handle;
+  bool _hasModel = false;
+
+  /// 连接守护进程，[socketPath] 为空时使用默认路径。
+  ///
+  /// 原生库不支持或守护进程未运行时返回 null。
+  static OnnxDaemonClient? connect({
+    String? socketPath,
+    OnnxBindings? bindings,
+  }) {
+    final resolved = bindings ?? OnnxInference.instance._bindings;
+    if (!resolved.supportsDaemonClient) return null;
+    final pathPtr = socketPath == null ? nullptr : socketPath.toNativeUtf8();
+    try {
+      final handle = resolved.clientConnect!(pathPtr);
+      if (handle.address == 0) return null;
+      return OnnxDaemonClient._(resolved, handle);
+    } finally {
+      if (pathPtr != nullptr) calloc.free(pathPtr);
+    }
+  }
+
+  /// 默认套接字路径（原生库不支持时为 null）。
+  static String? defaultSocketPath({OnnxBindings? bindings}) {
+    final resolved = bindings ?? OnnxInference.instance._bindings;
+    final path = resolved.clientDefaultSocketPath?.call().toDartString();
+    return path == null || path.isEmpty ? null : path;
+  }
+
+  /// 是否仍处于连接状态。
+  bool get isConnected => _handle != null;
+
+  /// 是否已加载模型。
+  bool get hasModel => _hasModel;
+
+  /// 请求守护进程加载模型（同一路径由所有客户端共享）。
+  bool loadModel(String modelPath, {bool useGpu = false}) {
+    final handle = _handle;
+    if (handle == null) return false;
+    final pathPtr = modelPath.toNativeUtf8();
+    try {
+      _hasModel = _bindings.clientLoadModel!(handle, pathPtr, useGpu) == 0;
+      return _hasModel;
+    } finally {
+      calloc.free(pathPtr);
+    }
+  }
+
+  /// 经守护进程运行批量推理，参数与 [OnnxInference.detectBatch] 相同。
+  ///
+  /// 失败时返回空结果，原因见 [lastErrorCode]。
+  List<List<Detection>> detectBatch(
+    List<Uint8List> imageList,
+    List<(int, int)> sizes, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    final handle = _handle;
+    if (handle == null || !_hasModel || imageList.isEmpty) {
+      return List.filled(imageList.length, []);
+    }
+    if (imageList.length != sizes.length) {
+      throw ArgumentError('图像列表和尺寸列表长度必须一致');
+    }
+
+    // 原生层再拷贝进共享内存，此处只需临时暂存。
+    final numImages = imageList.length;
+    final imageListPtr = calloc<Pointer<Uint8>>(numImages);
+    final widthListPtr = calloc<Int32>(numImages);
+    final heightListPtr = calloc<Int32>(numImages);
+    final imagePtrs = <Pointer<Uint8>>[];
+    Pointer<NativeBatchDetectionResult> resultPtr = Pointer.fromAddress(0);
+    try {
+      for (int i = 0; i < numImages; i++) {
+        final ptr = calloc<Uint8>(imageList[i].length);
+        ptr.asTypedList(imageList[i].length).setAll(0, imageList[i]);
+        imagePtrs.add(ptr);
+        imageListPtr[i] = ptr;
+        widthListPtr[i] = sizes[i].$1;
+        heightListPtr[i] = sizes[i].$2;
+      }
+
+      resultPtr = _bindings.clientDetectBatch!(
+        handle,
+        imageListPtr,
+        numImages,
+        widthListPtr,
+        heightListPtr,
+        confThreshold,
+        nmsThreshold,
+        modelType.index,
+        numKeypoints,
+      );
+      if (resultPtr.address == 0) {
+        return List.filled(numImages, []);
+      }
+
+      final batchResult = resultPtr.ref;
+      return [
+        for (int i = 0; i < batchResult.numImages; i++)
+          OnnxInference._readDetections(
+            batchResult.results[i].detections,
+            batchResult.results[i].count,
+          ),
+      ];
+    } finally {
+      if (resultPtr.address != 0) {
+        _bindings.freeBatchResult(resultPtr);
+      }
+      for (final ptr in imagePtrs) {
+        calloc.free(ptr);
+      }
+      calloc.free(imageListPtr);
+      calloc.free(widthListPtr);
+      calloc.free(heightListPtr);
+    }
+  }
+
+  /// 单张推理。
+  List<Detection> detect(
+    Uint8List imageData,
+    int width,
+    int height, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    ModelType modelType = ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    return detectBatch(
+      [imageData],
+      [(width, height)],
+      confThreshold: confThreshold,
+      nmsThreshold: nmsThreshold,
+      modelType: modelType,
+      numKeypoints: numKeypoints,
+    ).first;
+  }
+
+  /// 最近一次错误信息。
+  String get lastError => _bindings.getLastError().toDartString();
+
+  /// 最近一次错误码。
+  int get lastErrorCode => _bindings.getLastErrorCode();
+
+  /// 断开连接（守护进程中的模型不受影响）。
+  void close() {
+    final handle = _handle;
+    if (handle == null) return;
+    _bindings.clientDisconnect!(handle);
+    _handle = null;
+    _hasModel = false;
+  }
+}
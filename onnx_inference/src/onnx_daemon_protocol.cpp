@@ -0,0 +1,420 @@
+/**
+ * 本地推理守护进程协议实现
+ */
+#include "onnx_daemon_protocol.h"
+
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef ONNX_DAEMON_SUPPORTED
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+#endif
+
+// memfd 封印（Linux 3.17+、glibc 2.27+）。
+#if defined(ONNX_DAEMON_SUPPORTED) && defined(__linux__) &&                  \
+    defined(MFD_ALLOW_SEALING) && defined(F_ADD_SEALS)
+#define ONNX_DAEMON_SEALED_MEMORY 1
+#endif
+
+namespace onnx_daemon {
+
+std::string default_socket_path() {
+#ifdef ONNX_DAEMON_SUPPORTED
+  const char *runtime_dir = getenv("XDG_RUNTIME_DIR");
+  if (runtime_dir && runtime_dir[0]) {
+    return std::string(runtime_dir) + "/label_load.sock";
+  }
+  return "/tmp/label_load-" + std::to_string((unsigned long)getuid()) +
+         ".sock";
+#else
+  return "";
+#endif
+}
+
+// ============================================================================
+// 结果编码
+// ============================================================================
+
+void encode_detections(const Detection *detections, int count,
+                       std::string *out) {
+  int32_t n = count;
+  out->append((const char *)&n, sizeof(n));
+  for (int i = 0; i < count; i++) {
+    const Detection &det = detections[i];
+    DetectionRecord record;
+    record.class_id = det.class_id;
+    record.confidence = det.confidence;
+    record.x = det.x;
+    record.y = det.y;
+    record.width = det.width;
+    record.height = det.height;
+    record.angle = det.angle;
+    record.num_keypoints = det.keypoints ? det.num_keypoints : 0;
+    record.num_polygon_points = det.polygon ? det.num_polygon_points : 0;
+    out->append((const char *)&record, sizeof(record));
+    out->append((const char *)det.keypoints,
+                (size_t)record.num_keypoints * 3 * sizeof(float));
+    out->append((const char *)det.polygon,
+                (size_t)record.num_polygon_points * 2 * sizeof(float));
+  }
+}
+
+namespace {
+
+bool read_bytes(const std::string &data, size_t *pos, void *dst, size_t n) {
+  if (data.size() - *pos < n) {
+    return false;
+  }
+  memcpy(dst, data.data() + *pos, n);
+  *pos += n;
+  return true;
+}
+
+// 读取 count 个 float 到新分配的缓冲区（count 为 0 时返回 nullptr）。
+bool read_floats(const std::string &data, size_t *pos, int count,
+                 float **out) {
+  *out = nullptr;
+  if (count == 0) {
+    return true;
+  }
+  size_t bytes = (size_t)count * sizeof(float);
+  if (data.size() - *pos < bytes) {
+    return false;
+  }
+  *out = (float *)malloc(bytes);
+  return *out && read_bytes(data, pos, *out, bytes);
+}
+
+} // namespace
+
+bool decode_detections(const std::string &data, size_t *pos,
+                       DetectionResult *out) {
+  out->detections = nullptr;
+  out->count = 0;
+  out->capacity = 0;
+  int32_t count = 0;
+  if (*pos > data.size() || !read_bytes(data, pos, &count, sizeof(count)) ||
+      count < 0 || (size_t)count > data.size() / sizeof(DetectionRecord)) {
+    return false;
+  }
+  if (count == 0) {
+    return true;
+  }
+  out->detections = (Detection *)calloc((size_t)count, sizeof(Detection));
+  if (!out->detections) {
+    return false;
+  }
+  out->capacity = count;
+  for (int i = 0; i < count; i++) {
+    DetectionRecord record;
+    if (!read_bytes(data, pos, &record, sizeof(record)) ||
+        record.num_keypoints < 0 || record.num_polygon_points < 0 ||
+        record.num_keypoints > (1 << 20) ||
+        record.num_polygon_points > (1 << 20)) {
+      return false;
+    }
+    Detection &det = out->detections[i];
+    det.class_id = record.class_id;
+    det.confidence = record.confidence;
+    det.x = record.x;
+    det.y = record.y;
+    det.width = record.width;
+    det.height = record.height;
+    det.angle = record.angle;
+    // 先计入 count，失败时已分配的缓冲区可由调用方统一释放。
+    out->count = i + 1;
+    if (!read_floats(data, pos, record.num_keypoints * 3, &det.keypoints) ||
+        !read_floats(data, pos, record.num_polygon_points * 2,
+                     &det.polygon)) {
+      return false;
+    }
+    det.num_keypoints = det.keypoints ? record.num_keypoints : 0;
+    det.num_polygon_points = det.polygon ? record.num_polygon_points : 0;
+  }
+  return true;
+}
+
+#ifdef ONNX_DAEMON_SUPPORTED
+
+// ============================================================================
+// 套接字
+// ============================================================================
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+constexpr int kSendFlags = MSG_NOSIGNAL;
+#else
+constexpr int kSendFlags = 0; // macOS 以 SO_NOSIGPIPE 代替
+#endif
+
+void disable_sigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+  int on = 1;
+  setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+  (void)fd;
+#endif
+}
+
+bool fill_address(const std::string &path, sockaddr_un *addr) {
+  memset(addr, 0, sizeof(*addr));
+  addr->sun_family = AF_UNIX;
+  if (path.empty() || path.size() >= sizeof(addr->sun_path)) {
+    return false;
+  }
+  memcpy(addr->sun_path, path.c_str(), path.size() + 1);
+  return true;
+}
+
+bool send_all(int fd, const char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = send(fd, data, size, kSendFlags);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+bool recv_all(int fd, char *data, size_t size) {
+  while (size > 0) {
+    ssize_t n = recv(fd, data, size, 0);
+    if (n < 0 && errno == EINTR) {
+      continue;
+    }
+    if (n <= 0) {
+      return false;
+    }
+    data += n;
+    size -= (size_t)n;
+  }
+  return true;
+}
+
+} // namespace
+
+bool send_message(int socket_fd, uint32_t type, int32_t status,
+                  const void *payload, size_t size, int pass_fd) {
+  if (size > kMaxPayload) {
+    return false;
+  }
+  MessageHeader header{kMagic, type, status, (uint32_t)size};
+  if (pass_fd >= 0) {
+    // 描述符随头部一起发送（需至少 1 字节常规数据）。
+    iovec iov{&header, sizeof(header)};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+    memset(control, 0, sizeof(control));
+    msghdr msg{};
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control;
+    msg.msg_controllen = sizeof(control);
+    cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+    memcpy(CMSG_DATA(cmsg), &pass_fd, sizeof(int));
+    ssize_t n;
+    do {
+      n = sendmsg(socket_fd, &msg, kSendFlags);
+    } while (n < 0 && errno == EINTR);
+    if (n <= 0) {
+      return false;
+    }
+    if ((size_t)n < sizeof(header) &&
+        !send_all(socket_fd, (const char *)&header + n,
+                  sizeof(header) - (size_t)n)) {
+      return false;
+    }
+  } else if (!send_all(socket_fd, (const char *)&header, sizeof(header))) {
+    return false;
+  }
+  return size == 0 || send_all(socket_fd, (const char *)payload, size);
+}
+
+bool recv_message(int socket_fd, MessageHeader *header, std::string *payload,
+                  int *received_fd) {
+  if (received_fd) {
+    *received_fd = -1;
+  }
+  iovec iov{header, sizeof(*header)};
+  alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int))];
+  msghdr msg{};
+  msg.msg_iov = &iov;
+  msg.msg_iovlen = 1;
+  msg.msg_control = control;
+  msg.msg_controllen = sizeof(control);
+  ssize_t n;
+  do {
+    n = recvmsg(socket_fd, &msg, 0);
+  } while (n < 0 && errno == EINTR);
+  if (n <= 0) {
+    return false;
+  }
+  for (cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg;
+       cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+    if (cmsg->cmsg_level == SOL_SOCKET && cmsg->cmsg_type == SCM_RIGHTS) {
+      int fd = -1;
+      memcpy(&fd, CMSG_DATA(cmsg), sizeof(int));
+      if (received_fd) {
+        *received_fd = fd;
+      } else {
+        close(fd);
+      }
+    }
+  }
+  if ((size_t)n < sizeof(*header) &&
+      !recv_all(socket_fd, (char *)header + n, sizeof(*header) - (size_t)n)) {
+    return false;
+  }
+  if (header->magic != kMagic || header->size > kMaxPayload) {
+    return false;
+  }
+  payload->resize(header->size);
+  return header->size == 0 ||
+         recv_all(socket_fd, &(*payload)[0], header->size);
+}
+
+int connect_socket(const std::string &path) {
+  sockaddr_un addr;
+  if (!fill_address(path, &addr)) {
+    return -1;
+  }
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    return -1;
+  }
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  if (connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+    close(fd);
+    return -1;
+  }
+  disable_sigpipe(fd);
+  return fd;
+}
+
+int listen_socket(const std::string &path, unsigned mode, std::string *error) {
+  sockaddr_un addr;
+  if (!fill_address(path, &addr)) {
+    *error = "套接字路径为空或过长: " + path;
+    return -1;
+  }
+  // 残留的套接字文件：仍可连接说明已有守护进程在运行。
+  int probe = connect_socket(path);
+  if (probe >= 0) {
+    close(probe);
+    *error = "已有守护进程在监听: " + path;
+    return -1;
+  }
+  unlink(path.c_str());
+
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0) {
+    *error = strerror(errno);
+    return -1;
+  }
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  if (bind(fd, (sockaddr *)&addr, sizeof(addr)) != 0 ||
+      chmod(path.c_str(), (mode_t)mode) != 0 || listen(fd, 64) != 0) {
+    *error = path + ": " + strerror(errno);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+// ============================================================================
+// 共享内存
+// ============================================================================
+
+#ifdef ONNX_DAEMON_SEALED_MEMORY
+static const int kSizeSeals = F_SEAL_SHRINK | F_SEAL_GROW;
+#endif
+
+bool create_shared_memory(size_t size, SharedMemory *out) {
+#ifdef ONNX_DAEMON_SEALED_MEMORY
+  int fd = memfd_create("label_load", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+  if (fd < 0) {
+    return false;
+  }
+  // 封印大小：守护进程据此确认映射期间文件不会被缩小。
+  if (ftruncate(fd, (off_t)size) != 0 ||
+      fcntl(fd, F_ADD_SEALS, kSizeSeals | F_SEAL_SEAL) != 0) {
+    close(fd);
+    return false;
+  }
+#else
+  static std::atomic<unsigned> counter{0};
+  std::string name = "/label_load_" + std::to_string((long)getpid()) + "_" +
+                     std::to_string(counter.fetch_add(1));
+  int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+  if (fd < 0) {
+    return false;
+  }
+  // 立即移除名称：只能经描述符共享，进程退出后自动回收。
+  shm_unlink(name.c_str());
+  fcntl(fd, F_SETFD, FD_CLOEXEC);
+  if (ftruncate(fd, (off_t)size) != 0) {
+    close(fd);
+    return false;
+  }
+#endif
+  void *data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (data == MAP_FAILED) {
+    close(fd);
+    return false;
+  }
+  out->fd = fd;
+  out->data = (uint8_t *)data;
+  out->size = size;
+  return true;
+}
+
+void release_shared_memory(SharedMemory *memory) {
+  if (memory->data) {
+    munmap(memory->data, memory->size);
+  }
+  if (memory->fd >= 0) {
+    close(memory->fd);
+  }
+  *memory = SharedMemory();
+}
+
+bool check_shared_memory(int fd, uint64_t size, std::string *error) {
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    *error = std::string("fstat: ") + strerror(errno);
+    return false;
+  }
+  if (size == 0 || st.st_size < 0 || (uint64_t)st.st_size < size) {
+    *error = "共享内存大小不符: 声明 " + std::to_string(size) + "，实际 " +
+             std::to_string((long long)st.st_size);
+    return false;
+  }
+#ifdef ONNX_DAEMON_SEALED_MEMORY
+  int seals = fcntl(fd, F_GET_SEALS);
+  if (seals < 0 || (seals & kSizeSeals) != kSizeSeals) {
+    *error = "共享内存未封印大小";
+    return false;
+  }
+#endif
+  // 其余平台（macOS）的 POSIX 共享内存设定大小后不能再 ftruncate。
+  return true;
+}
+
+#endif // ONNX_DAEMON_SUPPORTED
+
+} // namespace onnx_daemon
@@ -0,0 +1,132 @@
+/**
+ * 本地推理守护进程协议
+ *
+ * 客户端（插件库内的 onnx_client_* 接口）与 label_load_daemon 之间经 Unix
+ * 域套接字通信。消息为定长头部 + 负载，按本机字节序编码（仅限本机）。
+ * 图片像素不经套接字传输：客户端创建共享内存并以 SCM_RIGHTS 传递描述符，
+ * 推理请求只携带各图片在共享内存中的偏移与尺寸。
+ *
+ * 会话流程：
+ *   ATTACH_MEMORY（附带描述符，共享内存扩容时重发）
+ *   LOAD_MODEL  -> REPLY(model_id)
+ *   DETECT      -> REPLY(按图片顺序编码的检测结果)
+ */
+#ifndef ONNX_DAEMON_PROTOCOL_H
+#define ONNX_DAEMON_PROTOCOL_H
+
+#include "onnx_inference.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Windows 无 Unix 域套接字描述符传递，Android 无 shm_open。
+#if !defined(_WIN32) && !defined(__ANDROID__)
+#define ONNX_DAEMON_SUPPORTED 1
+#endif
+
+namespace onnx_daemon {
+
+constexpr uint32_t kMagic = 0x31444C4C; // "LLD1"
+constexpr uint32_t kMaxPayload = 64u << 20;
+constexpr int kMaxImages = 256;
+/// 共享内存中每张图片的起始偏移按此对齐。
+constexpr size_t kImageAlignment = 64;
+
+enum MessageType : uint32_t {
+  kAttachMemory = 1, // 负载: uint64 大小；附带共享内存描述符
+  kLoadModel = 2,    // 负载: uint8 use_gpu + 模型路径（UTF-8，不含结尾 0）
+  kDetect = 3,       // 负载: DetectRequest + ImageRef[num_images]
+  kReply = 100,      // status 为 OnnxErrorCode；失败时负载为错误信息
+};
+
+struct MessageHeader {
+  uint32_t magic;
+  uint32_t type;
+  int32_t status;
+  uint32_t size; // 负载字节数
+};
+
+struct DetectRequest {
+  int32_t model_id;
+  float conf_threshold;
+  float nms_threshold;
+  int32_t model_type;
+  int32_t num_keypoints;
+  int32_t num_images;
+};
+
+struct ImageRef {
+  int32_t width;
+  int32_t height;
+  uint64_t offset; // 相对共享内存起始的字节偏移，RGBA 连续存放
+};
+
+/// 编码后的检测框，其后紧跟 num_keypoints * 3 与 num_polygon_points * 2 个
+/// float。每张图片的结果以 int32 检测数开头。
+struct DetectionRecord {
+  int32_t class_id;
+  float confidence;
+  float x;
+  float y;
+  float width;
+  float height;
+  float angle;
+  int32_t num_keypoints;
+  int32_t num_polygon_points;
+};
+
+/// 默认套接字路径：$XDG_RUNTIME_DIR/label_load.sock，
+/// 否则 /tmp/label_load-<uid>.sock。
+std::string default_socket_path();
+
+/// 追加一张图片的编码结果。
+void encode_detections(const Detection *detections, int count,
+                       std::string *out);
+
+/// 从 pos 处解码一张图片的结果，成功后 pos 前移。
+///
+/// 检测数组与关键点、多边形单独堆分配，布局与 onnx_copy_detections 一致，
+/// 可用 onnx_release_detections / onnx_free_batch_result 释放。
+bool decode_detections(const std::string &data, size_t *pos,
+                       DetectionResult *out);
+
+#ifdef ONNX_DAEMON_SUPPORTED
+
+/// 发送一条消息；pass_fd >= 0 时随消息传递该描述符。
+bool send_message(int socket_fd, uint32_t type, int32_t status,
+                  const void *payload, size_t size, int pass_fd = -1);
+
+/// 接收一条消息；received_fd 非空时接收随附的描述符（无则为 -1）。
+bool recv_message(int socket_fd, MessageHeader *header, std::string *payload,
+                  int *received_fd = nullptr);
+
+/// 连接守护进程，失败返回 -1。
+int connect_socket(const std::string &path);
+
+/// 在 path 上监听（清理无人监听的残留套接字文件），失败返回 -1。
+int listen_socket(const std::string &path, unsigned mode, std::string *error);
+
+/// 匿名共享内存（仅能通过描述符共享）。
+///
+/// Linux 上为 memfd，并加 F_SEAL_SHRINK / F_SEAL_GROW 封印，大小此后不可
+/// 更改；其余平台为创建后立即 unlink 的 POSIX 共享内存。
+struct SharedMemory {
+  int fd = -1;
+  uint8_t *data = nullptr;
+  size_t size = 0;
+};
+
+bool create_shared_memory(size_t size, SharedMemory *out);
+void release_shared_memory(SharedMemory *memory);
+
+/// 映射客户端传来的描述符前校验：当前至少 size 字节（fstat），Linux 上还
+/// 要求已封印大小。客户端夸大大小或事后缩小文件会使守护进程读取时
+/// 触发 SIGBUS，连带断开其他客户端。
+bool check_shared_memory(int fd, uint64_t size, std::string *error);
+
+#endif // ONNX_DAEMON_SUPPORTED
+
+} // namespace onnx_daemon
+
+#endif // ONNX_DAEMON_PROTOCOL_H
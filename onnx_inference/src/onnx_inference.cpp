@@ -6,24 +6,48 @@
  * 支持的模型:
  * - YOLOv8 Detection (yolov8n.onnx, yolov8s.onnx 等)
  * - YOLOv8-Pose (yolov8n-pose.onnx 等)
+ * - YOLOv8-Seg (yolov8n-seg.onnx 等)
+ * - YOLOv8-OBB (yolov8n-obb.onnx 等)
  */
 
 #include "onnx_inference.h"
+#include "onnx_daemon_protocol.h"
 #include "onnx_inference_utils.h"
+#include "onnx_raw_cache.h"
+#include "onnx_runtime_loader.h"
+#include "onnx_tracker.h"
+#ifdef ONNX_INFERENCE_TESTING
+#include "onnx_inference_testing.h"
+#endif
 
 #include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cmath>
 #include <cstdarg>
 #include <cstdio>
 #include <cstdlib>
+#include <condition_variable>
 #include <cstring>
+#include <deque>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
 #ifndef ONNX_RUNTIME_NOT_FOUND
 #include <onnxruntime_c_api.h>
 #endif
 #include <vector>
 
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <unistd.h>
+#endif
+
 // ============================================================================
 // 全局变量
 // ============================================================================
@@ -33,7 +57,20 @@ static const OrtApi *g_ort = nullptr;
 static OrtEnv *g_env = nullptr;
 static bool g_initialized = false;
 static std::mutex g_init_mutex;
+// 进程级共享 CPU 内存池是否已注册（随环境释放失效）。
+static bool g_env_arena_registered = false;
+// 环境是否带全局线程池（会话据此放弃自建线程）。
+static bool g_global_thread_pools = false;
+// 进行中的后台加载线程（受 g_init_mutex 保护），onnx_cleanup 等待其归零。
+static InflightCounter g_pending_loads;
+#ifdef ONNX_RUNTIME_DYNAMIC
+// 动态加载的运行时库（进程内不卸载）与调用方设置的搜索路径。
+static OnnxRuntimeLibrary g_ort_library;
+static std::string g_ort_search_paths;
 #endif
+#endif
+// 图像暂存池（与 ONNX Runtime 无关，两种构建共用）。
+static ImageBufferPool g_image_pool;
 // 线程局部错误缓存（FFI 调用方可读取）。
 static thread_local char g_last_error[512] = {0};
 static thread_local int g_last_error_code = ONNX_OK;
@@ -43,17 +80,75 @@ static thread_local int g_last_error_code = ONNX_OK;
 // ============================================================================
 
 #ifndef ONNX_RUNTIME_NOT_FOUND
+// 单张图片的 letterbox 参数，供后处理还原坐标。
+struct LetterboxParams {
+  float scale_x;
+  float scale_y;
+  int pad_left;
+  int pad_top;
+};
+
 struct OnnxModel {
-  OrtSession *session;
-  OrtAllocator *allocator;
-  OrtMemoryInfo *memory_info;
+  OrtSession *session = nullptr;
+  OrtAllocator *allocator = nullptr;
+  OrtMemoryInfo *memory_info = nullptr;
   // 模型输入尺寸（由模型元数据推断，回退到默认值）。
-  int input_width;
-  int input_height;
+  int input_width = 0;
+  int input_height = 0;
   // 输入/输出名称（由 ONNX Runtime 分配，需释放）。
-  char *input_name;
-  char *output_name;
-  size_t num_outputs;
+  char *input_name = nullptr;
+  char *output_name = nullptr;
+  size_t num_outputs = 0;
+  // 首个输出的静态形状 [batch, features, boxes]（动态维度为 0）。
+  int output_features = 0;
+  int output_boxes = 0;
+  // 分割模型的原型输出名称与形状 [batch, 32, h, w]（非分割模型为空）。
+  char *mask_output_name = nullptr;
+  int proto_height = 0;
+  int proto_width = 0;
+  // 端到端输出 [batch, max_det, row]（NMS-free 或图内已含 NMS），
+  // 逐行直接解码，跳过候选展开与 NMS。
+  bool end_to_end = false;
+  // 跨调用复用的输入张量、letterbox 参数与后处理暂存区（只增不减）。
+  std::vector<float> input_buffer;
+  std::vector<LetterboxParams> letterbox;
+  DetectionScratch scratch;
+  // 暂存区前 last_result_count 个候选框为最近一张图片的 NMS 结果。
+  int last_result_count = 0;
+  // 各阶段耗时与计数器。
+  ModelStats stats;
+  // 加载参数（开启性能分析时据此重建会话）。
+  std::string model_path;
+  OnnxLoadOptions options = {};
+  // 最近一次 onnx_trim_memory 归还的内存池字节数（-1 表示无法测量）。
+  int64_t arena_trimmed_bytes = 0;
+  // 性能分析输出路径（为空表示未在分析）、ORT 分析起点与插件片段。
+  std::string trace_path;
+  int64_t profile_start_ns = 0;
+  std::vector<TraceSpan> trace_spans;
+  // 原始输出缓存目录（为空表示未启用）、模型文件哈希与条目编码缓冲区。
+  std::string raw_cache_dir;
+  uint64_t model_hash = 0;
+  std::string raw_cache_entry;
+  // 多阈值扫描中各 NMS 阈值保留者在并集中的下标与单个组合的结果暂存。
+  std::vector<std::vector<uint32_t>> sweep_kept;
+  std::vector<Detection> sweep_selection;
+  // 近重复跳过阈值（负数表示关闭）、最近一张实际推理的图片及其结果，
+  // 以及产生该结果的推理参数（参数变化时不跨调用复用）。
+  int dedup_distance = -1;
+  DedupReference dedup_reference;
+  DetectionResult dedup_result = {};
+  float dedup_conf = 0;
+  float dedup_nms = 0;
+  int dedup_model_type = -1;
+  int dedup_keypoints = -1;
+  // 引用计数：调用方持有 1，每个未销毁的流式会话各持有 1。
+  std::atomic<int> refs{1};
+#ifdef ONNX_INFERENCE_TESTING
+  // 测试模型代替 Run 的合成输出 [1, features, boxes]（调用方持有）。
+  const float *testing_output = nullptr;
+  int64_t testing_dims[3] = {0};
+#endif
 };
 #endif
 
@@ -107,6 +202,14 @@ struct OrtValueDeleter {
   }
 };
 
+struct OrtRunOptionsDeleter {
+  void operator()(OrtRunOptions *ptr) const {
+    if (ptr && g_ort) {
+      g_ort->ReleaseRunOptions(ptr);
+    }
+  }
+};
+
 struct OrtTensorInfoDeleter {
   void operator()(OrtTensorTypeAndShapeInfo *ptr) const {
     if (ptr && g_ort) {
@@ -118,6 +221,7 @@ struct OrtTensorInfoDeleter {
 using OrtSessionOptionsPtr =
     std::unique_ptr<OrtSessionOptions, OrtSessionOptionsDeleter>;
 using OrtValuePtr = std::unique_ptr<OrtValue, OrtValueDeleter>;
+using OrtRunOptionsPtr = std::unique_ptr<OrtRunOptions, OrtRunOptionsDeleter>;
 using OrtTensorInfoPtr =
     std::unique_ptr<OrtTensorTypeAndShapeInfo, OrtTensorInfoDeleter>;
 #endif
@@ -146,8 +250,28 @@ FFI_PLUGIN_EXPORT bool onnx_init(void) {
   return false;
 }
 
+FFI_PLUGIN_EXPORT bool onnx_init_with_options(const OnnxInitOptions *options) {
+  (void)options;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return false;
+}
+
 FFI_PLUGIN_EXPORT void onnx_cleanup(void) {
   clear_last_error();
+  onnx_pool_clear(&g_image_pool);
+}
+
+FFI_PLUGIN_EXPORT bool onnx_set_runtime_search_paths(const char *paths) {
+  (void)paths;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return false;
+}
+
+FFI_PLUGIN_EXPORT const char *onnx_get_runtime_path(void) {
+  clear_last_error();
+  return "";
 }
 
 FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
@@ -159,11 +283,46 @@ FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
   return nullptr;
 }
 
+FFI_PLUGIN_EXPORT ModelHandle
+onnx_load_model_with_options(const char *model_path,
+                             const OnnxLoadOptions *options) {
+  (void)model_path;
+  (void)options;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
 FFI_PLUGIN_EXPORT void onnx_unload_model(ModelHandle handle) {
   (void)handle;
   clear_last_error();
 }
 
+FFI_PLUGIN_EXPORT ModelLoadHandle
+onnx_load_model_async(const char *model_path, const OnnxLoadOptions *options) {
+  (void)model_path;
+  (void)options;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT int onnx_load_model_done(ModelLoadHandle load) {
+  (void)load;
+  return -1;
+}
+
+FFI_PLUGIN_EXPORT ModelHandle onnx_load_model_finish(ModelLoadHandle load) {
+  (void)load;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT void onnx_load_model_cancel(ModelLoadHandle load) {
+  (void)load;
+}
+
 FFI_PLUGIN_EXPORT bool onnx_get_input_size(ModelHandle handle, int *width,
                                            int *height) {
   (void)handle;
@@ -213,14 +372,249 @@ onnx_detect(ModelHandle handle, const uint8_t *image_data, int image_width,
   return nullptr;
 }
 
-FFI_PLUGIN_EXPORT void onnx_free_batch_result(BatchDetectionResult *result) {
-  (void)result;
+FFI_PLUGIN_EXPORT int onnx_detect_into(ModelHandle handle,
+                                       const uint8_t *image_data,
+                                       int image_width, int image_height,
+                                       float conf_threshold,
+                                       float nms_threshold, int model_type,
+                                       int num_keypoints,
+                                       OnnxResultBuffer *out) {
+  (void)handle;
+  (void)image_data;
+  (void)image_width;
+  (void)image_height;
+  (void)conf_threshold;
+  (void)nms_threshold;
+  (void)model_type;
+  (void)num_keypoints;
   clear_last_error();
+  if (out) {
+    out->count = 0;
+    out->arena_used = 0;
+  }
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
 }
 
-FFI_PLUGIN_EXPORT void onnx_free_result(DetectionResult *result) {
-  (void)result;
+FFI_PLUGIN_EXPORT int onnx_copy_last_result(ModelHandle handle,
+                                            OnnxResultBuffer *out) {
+  (void)handle;
+  clear_last_error();
+  if (out) {
+    out->count = 0;
+    out->arena_used = 0;
+  }
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT BatchStreamHandle
+onnx_stream_create(ModelHandle handle, float conf_threshold,
+                   float nms_threshold, int model_type, int num_keypoints,
+                   int64_t memory_budget_bytes) {
+  (void)handle;
+  (void)conf_threshold;
+  (void)nms_threshold;
+  (void)model_type;
+  (void)num_keypoints;
+  (void)memory_budget_bytes;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_push(BatchStreamHandle stream,
+                                       const uint8_t *image_data,
+                                       int image_width, int image_height,
+                                       int64_t tag) {
+  (void)stream;
+  (void)image_data;
+  (void)image_width;
+  (void)image_height;
+  (void)tag;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_flush(BatchStreamHandle stream) {
+  (void)stream;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_pending(BatchStreamHandle stream) {
+  (void)stream;
+  return 0;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_batch_size(BatchStreamHandle stream) {
+  (void)stream;
+  return 0;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_next(BatchStreamHandle stream, int64_t *tag,
+                                       OnnxResultBuffer *out) {
+  (void)stream;
+  (void)tag;
+  (void)out;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT void onnx_stream_destroy(BatchStreamHandle stream) {
+  (void)stream;
+  clear_last_error();
+}
+
+FFI_PLUGIN_EXPORT int onnx_set_dedup(ModelHandle handle, int max_distance) {
+  (void)handle;
+  (void)max_distance;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *onnx_detect_batch_cascade(
+    ModelHandle fast, ModelHandle heavy, const uint8_t **image_data_list,
+    int num_images, int *image_widths, int *image_heights,
+    float conf_threshold, float nms_threshold, int model_type,
+    int num_keypoints, const OnnxCascadeOptions *options) {
+  (void)fast;
+  (void)heavy;
+  (void)image_data_list;
+  (void)num_images;
+  (void)image_widths;
+  (void)image_heights;
+  (void)conf_threshold;
+  (void)nms_threshold;
+  (void)model_type;
+  (void)num_keypoints;
+  (void)options;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT int onnx_enable_raw_cache(ModelHandle handle,
+                                            const char *cache_dir) {
+  (void)handle;
+  (void)cache_dir;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT DetectionResult *
+onnx_detect_cached(ModelHandle handle, uint64_t image_key,
+                   float conf_threshold, float nms_threshold, int model_type,
+                   int num_keypoints) {
+  (void)handle;
+  (void)image_key;
+  (void)conf_threshold;
+  (void)nms_threshold;
+  (void)model_type;
+  (void)num_keypoints;
   clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_batch_keyed(ModelHandle handle, const uint8_t **image_data_list,
+                        const uint64_t *image_keys, int num_images,
+                        int *image_widths, int *image_heights,
+                        float conf_threshold, float nms_threshold,
+                        int model_type, int num_keypoints) {
+  (void)handle;
+  (void)image_data_list;
+  (void)image_keys;
+  (void)num_images;
+  (void)image_widths;
+  (void)image_heights;
+  (void)conf_threshold;
+  (void)nms_threshold;
+  (void)model_type;
+  (void)num_keypoints;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_sweep(ModelHandle handle, const uint8_t *image_data,
+                  int image_width, int image_height,
+                  const float *conf_thresholds, int num_conf,
+                  const float *nms_thresholds, int num_nms, int model_type,
+                  int num_keypoints) {
+  (void)handle;
+  (void)image_data;
+  (void)image_width;
+  (void)image_height;
+  (void)conf_thresholds;
+  (void)num_conf;
+  (void)nms_thresholds;
+  (void)num_nms;
+  (void)model_type;
+  (void)num_keypoints;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return nullptr;
+}
+
+FFI_PLUGIN_EXPORT int onnx_get_stats(ModelHandle handle, OnnxStats *out) {
+  (void)handle;
+  clear_last_error();
+  if (out) {
+    *out = OnnxStats();
+  }
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT void onnx_reset_stats(ModelHandle handle) {
+  (void)handle;
+  clear_last_error();
+}
+
+FFI_PLUGIN_EXPORT int onnx_start_profiling(ModelHandle handle,
+                                           const char *trace_path) {
+  (void)handle;
+  (void)trace_path;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stop_profiling(ModelHandle handle) {
+  (void)handle;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT int onnx_get_memory_usage(ModelHandle handle,
+                                            OnnxMemoryUsage *out) {
+  (void)handle;
+  clear_last_error();
+  if (out) {
+    out->arena_reserved_bytes = -1;
+    out->arena_in_use_bytes = -1;
+    out->plugin_reserved_bytes = 0;
+    out->process_rss_bytes = onnx_process_rss_bytes();
+    out->arena_trimmed_bytes = -1;
+  }
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
+}
+
+FFI_PLUGIN_EXPORT int onnx_trim_memory(ModelHandle handle) {
+  (void)handle;
+  clear_last_error();
+  set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "ONNX Runtime 未找到");
+  return ONNX_ERROR_RUNTIME_NOT_FOUND;
 }
 
 FFI_PLUGIN_EXPORT const char *onnx_get_version(void) {
@@ -259,22 +653,136 @@ FFI_PLUGIN_EXPORT int onnx_get_last_error_code(void) {
 #else
 
 FFI_PLUGIN_EXPORT bool onnx_init(void) {
-  // 初始化全局环境（线程安全）。
-  std::lock_guard<std::mutex> lock(g_init_mutex);
-  if (g_initialized)
+  return onnx_init_with_options(nullptr);
+}
+
+#ifdef ONNX_RUNTIME_DYNAMIC
+#ifndef ONNX_RUNTIME_LIB_DIR
+#define ONNX_RUNTIME_LIB_DIR ""
+#endif
+
+// 运行时是否提供编译时头文件的 API 版本；旧版运行时返回 false 并写入原因。
+static bool accept_ort_api_base(void *symbol, std::string *reason) {
+  auto get_api_base = reinterpret_cast<decltype(&OrtGetApiBase)>(symbol);
+  const OrtApiBase *api_base = get_api_base();
+  if (api_base && api_base->GetApi(ORT_API_VERSION)) {
     return true;
+  }
+  *reason = std::string("运行时 ") +
+            (api_base ? api_base->GetVersionString() : "?") +
+            " 不支持 API 版本 " + std::to_string(ORT_API_VERSION);
+  return false;
+}
+
+// 按搜索路径打开运行时库并解析 OrtGetApiBase（调用方持有 g_init_mutex）。
+// 失败时不缓存结果（不兼容的库会被关闭并尝试下一个候选），
+// 修正搜索路径后可再次初始化。
+static const OrtApiBase *load_ort_api_base() {
+  if (!g_ort_library.handle) {
+    const char *env_paths = getenv(kOnnxRuntimePathEnv);
+    std::vector<std::string> candidates = onnx_runtime_candidates(
+        g_ort_search_paths, env_paths ? env_paths : "",
+        onnx_runtime_module_dir(), ONNX_RUNTIME_LIB_DIR);
+    std::string error;
+    if (!onnx_runtime_open(candidates, "OrtGetApiBase", &g_ort_library, &error,
+                           accept_ort_api_base)) {
+      fprintf(stderr, "加载 ONNX Runtime 失败: %s\n", error.c_str());
+      set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "加载 ONNX Runtime 失败: %s",
+                     error.c_str());
+      return nullptr;
+    }
+  }
+  auto get_api_base =
+      reinterpret_cast<decltype(&OrtGetApiBase)>(g_ort_library.symbol);
+  return get_api_base();
+}
+#else
+static const OrtApiBase *load_ort_api_base() { return OrtGetApiBase(); }
+#endif
+
+// 按选项创建全局线程池配置；失败返回 nullptr 并设置线程局部错误。
+static OrtThreadingOptions *
+create_threading_options(const OnnxInitOptions &options) {
+  OrtThreadingOptions *threading = nullptr;
+  if (!handle_status(g_ort->CreateThreadingOptions(&threading),
+                     "CreateThreadingOptions")) {
+    return nullptr;
+  }
+  bool ok = handle_status(g_ort->SetGlobalIntraOpNumThreads(
+                              threading, options.intra_op_threads),
+                          "SetGlobalIntraOpNumThreads") &&
+            handle_status(g_ort->SetGlobalInterOpNumThreads(
+                              threading, options.inter_op_threads),
+                          "SetGlobalInterOpNumThreads") &&
+            handle_status(g_ort->SetGlobalSpinControl(
+                              threading, options.allow_spinning ? 1 : 0),
+                          "SetGlobalSpinControl");
+  if (ok && options.intra_op_affinity && options.intra_op_affinity[0]) {
+    ok = handle_status(g_ort->SetGlobalIntraOpThreadAffinity(
+                           threading, options.intra_op_affinity),
+                       "SetGlobalIntraOpThreadAffinity");
+  }
+  if (!ok) {
+    g_ort->ReleaseThreadingOptions(threading);
+    return nullptr;
+  }
+  return threading;
+}
 
+FFI_PLUGIN_EXPORT bool onnx_init_with_options(const OnnxInitOptions *options) {
+  // 初始化全局环境（线程安全）。
+  std::lock_guard<std::mutex> lock(g_init_mutex);
   clear_last_error();
 
-  g_ort = OrtGetApiBase()->GetApi(ORT_API_VERSION);
+  OnnxInitOptions init_options;
+  onnx_default_init_options(&init_options);
+  if (options) {
+    init_options = *options;
+  }
+  // 不带选项（onnx_init）时沿用已有环境。
+  if (g_initialized) {
+    if (options &&
+        init_options.use_global_thread_pools != g_global_thread_pools) {
+      set_last_error(ONNX_ERROR_INVALID_ARGUMENT,
+                     "运行时已初始化，线程池模式需在加载模型前设置");
+      return false;
+    }
+    return true;
+  }
+  if (init_options.intra_op_threads < 0 || init_options.inter_op_threads < 0) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的线程数: %d/%d",
+                   init_options.intra_op_threads,
+                   init_options.inter_op_threads);
+    return false;
+  }
+
+  const OrtApiBase *api_base = load_ort_api_base();
+  if (!api_base) {
+    return false;
+  }
+  // 动态加载时已按候选校验过版本；静态链接的运行时仍可能不匹配。
+  g_ort = api_base->GetApi(ORT_API_VERSION);
   if (!g_ort) {
     fprintf(stderr, "获取 ONNX Runtime API 失败\n");
-    set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND, "获取 ONNX Runtime API 失败");
+    set_last_error(ONNX_ERROR_RUNTIME_NOT_FOUND,
+                   "获取 ONNX Runtime API 失败: 运行时 %s 不支持 API 版本 %d",
+                   api_base->GetVersionString(), ORT_API_VERSION);
     return false;
   }
 
-  OrtStatus *status =
-      g_ort->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "OnnxInference", &g_env);
+  OrtStatus *status = nullptr;
+  if (init_options.use_global_thread_pools) {
+    OrtThreadingOptions *threading = create_threading_options(init_options);
+    if (!threading) {
+      return false;
+    }
+    status = g_ort->CreateEnvWithGlobalThreadPools(
+        ORT_LOGGING_LEVEL_WARNING, "OnnxInference", threading, &g_env);
+    g_ort->ReleaseThreadingOptions(threading);
+  } else {
+    status =
+        g_ort->CreateEnv(ORT_LOGGING_LEVEL_WARNING, "OnnxInference", &g_env);
+  }
   if (status != nullptr) {
     const char *msg = g_ort->GetErrorMessage(status);
     fprintf(stderr, "创建 ONNX 环境失败: %s\n", msg);
@@ -283,60 +791,216 @@ FFI_PLUGIN_EXPORT bool onnx_init(void) {
     return false;
   }
 
+  g_global_thread_pools = init_options.use_global_thread_pools;
   g_initialized = true;
   return true;
 }
 
 FFI_PLUGIN_EXPORT void onnx_cleanup(void) {
-  std::lock_guard<std::mutex> lock(g_init_mutex);
+  std::unique_lock<std::mutex> lock(g_init_mutex);
+  // 后台加载线程可能仍在用环境创建会话或预热（含已放弃的加载）。
+  onnx_inflight_wait(&g_pending_loads, lock);
   if (g_env) {
     g_ort->ReleaseEnv(g_env);
     g_env = nullptr;
   }
+  g_env_arena_registered = false;
+  g_global_thread_pools = false;
   g_initialized = false;
+  onnx_pool_clear(&g_image_pool);
+}
+
+FFI_PLUGIN_EXPORT bool onnx_set_runtime_search_paths(const char *paths) {
+  std::lock_guard<std::mutex> lock(g_init_mutex);
+  clear_last_error();
+#ifdef ONNX_RUNTIME_DYNAMIC
+  if (g_ort_library.handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "ONNX Runtime 已加载: %s",
+                   g_ort_library.path.c_str());
+    return false;
+  }
+  g_ort_search_paths = paths ? paths : "";
+  return true;
+#else
+  (void)paths;
+  set_last_error(ONNX_ERROR_INVALID_ARGUMENT,
+                 "ONNX Runtime 在链接时绑定，不支持搜索路径");
+  return false;
+#endif
+}
+
+FFI_PLUGIN_EXPORT const char *onnx_get_runtime_path(void) {
+  std::lock_guard<std::mutex> lock(g_init_mutex);
+  clear_last_error();
+#ifdef ONNX_RUNTIME_DYNAMIC
+  // 库打开后路径不再变化，可直接返回内部缓冲区。
+  return g_ort_library.path.c_str();
+#else
+  return "";
+#endif
 }
 
 // ============================================================================
 // 模型加载
 // ============================================================================
 
-FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
-                                              bool use_gpu) {
-  // 加载模型并创建会话，失败时返回空句柄并设置线程局部错误。
-  clear_last_error();
-  if (!g_initialized && !onnx_init()) {
-    return nullptr;
-  }
-  if (!model_path || model_path[0] == '\0') {
-    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "model_path 为空");
-    return nullptr;
+// 读取指定输出的静态形状，返回维度数（失败返回 0，动态维度为 -1）。
+static size_t get_output_dims(OrtSession *session, size_t index,
+                              int64_t *dims, size_t max_dims) {
+  OrtTypeInfo *type_info = nullptr;
+  if (!handle_status(
+          g_ort->SessionGetOutputTypeInfo(session, index, &type_info),
+          "SessionGetOutputTypeInfo")) {
+    return 0;
   }
+  size_t dim_count = 0;
+  const OrtTensorTypeAndShapeInfo *tensor_info = nullptr;
+  if (handle_status(g_ort->CastTypeInfoToTensorInfo(type_info, &tensor_info),
+                    "CastTypeInfoToTensorInfo") &&
+      tensor_info &&
+      handle_status(g_ort->GetDimensionsCount(tensor_info, &dim_count),
+                    "GetDimensionsCount")) {
+    if (dim_count > max_dims) {
+      dim_count = max_dims;
+    }
+    if (!handle_status(g_ort->GetDimensions(tensor_info, dims, dim_count),
+                       "GetDimensions")) {
+      dim_count = 0;
+    }
+  }
+  g_ort->ReleaseTypeInfo(type_info);
+  return dim_count;
+}
 
-  OnnxModel *model = new OnnxModel();
-  memset(model, 0, sizeof(OnnxModel));
+// YOLOv8 在 stride 8/16/32 三个尺度上的候选框总数。
+static int64_t yolo_anchor_count(int width, int height) {
+  int64_t count = 0;
+  for (int stride = 8; stride <= 32; stride *= 2) {
+    count += (int64_t)((width + stride - 1) / stride) *
+             ((height + stride - 1) / stride);
+  }
+  return count;
+}
+
+// 模型元数据是否声明端到端输出（Ultralytics 导出的 end2end / nms 键）。
+static bool metadata_declares_end_to_end(OnnxModel *model) {
+  OrtModelMetadata *metadata = nullptr;
+  if (!handle_status(g_ort->SessionGetModelMetadata(model->session, &metadata),
+                     "SessionGetModelMetadata")) {
+    clear_last_error();
+    return false;
+  }
+  bool declared = false;
+  const char *keys[] = {"end2end", "nms"};
+  for (const char *key : keys) {
+    char *value = nullptr;
+    if (handle_status(g_ort->ModelMetadataLookupCustomMetadataMap(
+                          metadata, model->allocator, key, &value),
+                      "ModelMetadataLookupCustomMetadataMap") &&
+        value) {
+      declared = declared || strcmp(value, "True") == 0 ||
+                 strcmp(value, "true") == 0 || strcmp(value, "1") == 0;
+      model->allocator->Free(model->allocator, value);
+    }
+  }
+  clear_last_error();
+  g_ort->ReleaseModelMetadata(metadata);
+  return declared;
+}
+
+// 是否设置了需要共享分配器承载的 CPU 内存池参数。
+static bool arena_customized(const OnnxLoadOptions &options) {
+  return options.arena_extend_strategy != ONNX_ARENA_EXTEND_NEXT_POWER_OF_TWO ||
+         options.arena_initial_chunk_bytes > 0;
+}
+
+// 按选项注册进程级共享 CPU 内存池；已注册时沿用首次的配置。
+static bool register_env_arena(const OnnxLoadOptions &options) {
+  std::lock_guard<std::mutex> lock(g_init_mutex);
+  if (g_env_arena_registered) {
+    return true;
+  }
+
+  const char *keys[] = {"arena_extend_strategy", "initial_chunk_size_bytes"};
+  size_t values[] = {(size_t)options.arena_extend_strategy,
+                     (size_t)options.arena_initial_chunk_bytes};
+  size_t num_keys = options.arena_initial_chunk_bytes > 0 ? 2 : 1;
+  OrtArenaCfg *arena_cfg = nullptr;
+  if (!handle_status(g_ort->CreateArenaCfgV2(keys, values, num_keys,
+                                             &arena_cfg),
+                     "CreateArenaCfgV2")) {
+    return false;
+  }
 
+  OrtMemoryInfo *memory_info = nullptr;
+  bool ok = handle_status(g_ort->CreateCpuMemoryInfo(OrtArenaAllocator,
+                                                     OrtMemTypeDefault,
+                                                     &memory_info),
+                          "CreateCpuMemoryInfo") &&
+            handle_status(g_ort->CreateAndRegisterAllocator(g_env, memory_info,
+                                                            arena_cfg),
+                          "CreateAndRegisterAllocator");
+  if (memory_info) {
+    g_ort->ReleaseMemoryInfo(memory_info);
+  }
+  g_ort->ReleaseArenaCfg(arena_cfg);
+  g_env_arena_registered = ok;
+  return ok;
+}
+
+// 创建推理会话；profile_prefix 非空时开启 ORT 性能分析。
+// 失败返回 nullptr 并设置线程局部错误。
+static OrtSession *create_session(const char *model_path,
+                                  const OnnxLoadOptions &options,
+                                  const char *profile_prefix) {
   // 创建会话选项
   OrtSessionOptions *session_options_raw = nullptr;
   if (!handle_status(g_ort->CreateSessionOptions(&session_options_raw),
                      "CreateSessionOptions")) {
-    delete model;
     return nullptr;
   }
   OrtSessionOptionsPtr session_options(session_options_raw);
 
-  // 设置优化选项
-  handle_status(g_ort->SetIntraOpNumThreads(session_options.get(), 4),
-                "SetIntraOpNumThreads");
+  // 设置优化选项：共享全局线程池时不再自建线程。
+  if (g_global_thread_pools) {
+    handle_status(g_ort->DisablePerSessionThreads(session_options.get()),
+                  "DisablePerSessionThreads");
+  } else {
+    handle_status(g_ort->SetIntraOpNumThreads(session_options.get(), 4),
+                  "SetIntraOpNumThreads");
+  }
 
   handle_status(g_ort->SetSessionGraphOptimizationLevel(session_options.get(),
                                                         ORT_ENABLE_ALL),
                 "SetSessionGraphOptimizationLevel");
 
+  // 内存池与内存模式
+  if (!options.enable_cpu_arena) {
+    handle_status(g_ort->DisableCpuMemArena(session_options.get()),
+                  "DisableCpuMemArena");
+  } else if (arena_customized(options)) {
+    // 会话改用共享内存池；失败时保留会话自带的默认内存池。
+    if (!register_env_arena(options) ||
+        !handle_status(g_ort->AddSessionConfigEntry(
+                           session_options.get(), "session.use_env_allocators",
+                           "1"),
+                       "AddSessionConfigEntry")) {
+      fprintf(stderr, "自定义内存池不可用，使用默认内存池: %s\n",
+              g_last_error);
+      clear_last_error();
+    }
+  }
+  if (!options.enable_mem_pattern) {
+    handle_status(g_ort->DisableMemPattern(session_options.get()),
+                  "DisableMemPattern");
+  }
+
   // 如果请求且可用，添加 CUDA 提供程序
-  if (use_gpu) {
+  if (options.use_gpu) {
     OrtCUDAProviderOptions cuda_options;
     memset(&cuda_options, 0, sizeof(cuda_options));
     cuda_options.device_id = 0;
+    cuda_options.arena_extend_strategy = options.arena_extend_strategy;
 
     if (!handle_status(g_ort->SessionOptionsAppendExecutionProvider_CUDA(
                            session_options.get(), &cuda_options),
@@ -345,22 +1009,81 @@ FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
     }
   }
 
+  if (profile_prefix &&
+      !handle_status(g_ort->EnableProfiling(session_options.get(),
+                                            profile_prefix),
+                     "EnableProfiling")) {
+    return nullptr;
+  }
+
   // 创建会话
-  OrtStatus *status =
-      g_ort->CreateSession(g_env, model_path, session_options.get(),
-                           &model->session);
+  OrtSession *session = nullptr;
+  OrtStatus *status = g_ort->CreateSession(g_env, model_path,
+                                           session_options.get(), &session);
 
   if (status != nullptr) {
     const char *msg = g_ort->GetErrorMessage(status);
     fprintf(stderr, "加载模型失败: %s\n", msg);
     set_last_error(ONNX_ERROR_RUNTIME_FAILURE, "加载模型失败: %s", msg);
     g_ort->ReleaseStatus(status);
-    delete model;
     return nullptr;
   }
+  return session;
+}
+
+FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
+                                              bool use_gpu) {
+  OnnxLoadOptions options;
+  onnx_default_load_options(&options);
+  options.use_gpu = use_gpu;
+  return onnx_load_model_with_options(model_path, &options);
+}
+
+FFI_PLUGIN_EXPORT ModelHandle
+onnx_load_model_with_options(const char *model_path,
+                             const OnnxLoadOptions *options) {
+  // 加载模型并创建会话，失败时返回空句柄并设置线程局部错误。
+  clear_last_error();
+  if (!g_initialized && !onnx_init()) {
+    return nullptr;
+  }
+  if (!model_path || model_path[0] == '\0') {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "model_path 为空");
+    return nullptr;
+  }
+
+  OnnxLoadOptions load_options;
+  onnx_default_load_options(&load_options);
+  if (options) {
+    load_options = *options;
+  }
+  if (load_options.arena_extend_strategy !=
+          ONNX_ARENA_EXTEND_NEXT_POWER_OF_TWO &&
+      load_options.arena_extend_strategy !=
+          ONNX_ARENA_EXTEND_SAME_AS_REQUESTED) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的内存池扩展策略: %d",
+                   load_options.arena_extend_strategy);
+    return nullptr;
+  }
+  if (load_options.arena_initial_chunk_bytes < 0) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的内存池首块大小: %lld",
+                   (long long)load_options.arena_initial_chunk_bytes);
+    return nullptr;
+  }
+
+  OrtSession *session = create_session(model_path, load_options, nullptr);
+  if (!session) {
+    return nullptr;
+  }
+
+  OnnxModel *model = new OnnxModel();
+  model->session = session;
+  model->model_path = model_path;
+  model->options = load_options;
 
   // 获取分配器
-  status = g_ort->GetAllocatorWithDefaultOptions(&model->allocator);
+  OrtStatus *status =
+      g_ort->GetAllocatorWithDefaultOptions(&model->allocator);
   if (!handle_status(status, "GetAllocatorWithDefaultOptions")) {
     g_ort->ReleaseSession(model->session);
     delete model;
@@ -437,18 +1160,57 @@ FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
                                             &model->output_name),
                 "SessionGetOutputName");
 
-  fprintf(stderr, "[信息] 模型已加载: 输入=%dx%d, 输出数=%zu\n",
-          model->input_width, model->input_height, model->num_outputs);
+  // 记录首个输出的静态形状（用于流式批量的内存预算）
+  int64_t output_dims[8] = {0};
+  size_t output_dim_count =
+      get_output_dims(model->session, 0, output_dims, 8);
+  if (output_dim_count >= 3) {
+    model->output_features = output_dims[1] > 0 ? (int)output_dims[1] : 0;
+    model->output_boxes = output_dims[2] > 0 ? (int)output_dims[2] : 0;
+  }
+
+  // 端到端输出：元数据声明，或静态形状为 [batch, max_det, row] 且末维
+  // 不等于 YOLOv8 候选框数（排除小输入尺寸下特征数多于候选数的情况）。
+  model->end_to_end =
+      metadata_declares_end_to_end(model) ||
+      (output_dim_count == 3 && model->output_features > 0 &&
+       model->output_boxes > 0 &&
+       model->output_features > model->output_boxes &&
+       model->output_boxes !=
+           yolo_anchor_count(model->input_width, model->input_height));
+
+  // 第二个 4 维输出且通道数匹配时视为分割原型（YOLOv8-seg）。
+  if (model->num_outputs >= 2) {
+    int64_t proto_dims[8] = {0};
+    size_t proto_dim_count =
+        get_output_dims(model->session, 1, proto_dims, 8);
+    if (proto_dim_count == 4 && proto_dims[1] == kSegMaskCoeffs &&
+        handle_status(g_ort->SessionGetOutputName(model->session, 1,
+                                                  model->allocator,
+                                                  &model->mask_output_name),
+                      "SessionGetOutputName")) {
+      model->proto_height = proto_dims[2] > 0 ? (int)proto_dims[2] : 0;
+      model->proto_width = proto_dims[3] > 0 ? (int)proto_dims[3] : 0;
+    }
+  }
+
+  fprintf(stderr, "[信息] 模型已加载: 输入=%dx%d, 输出数=%zu%s\n",
+          model->input_width, model->input_height, model->num_outputs,
+          model->end_to_end ? ", 端到端输出" : "");
 
   return model;
 }
 
-FFI_PLUGIN_EXPORT void onnx_unload_model(ModelHandle handle) {
-  // 释放会话与关联的输入/输出名称。
-  if (!handle)
+// 释放一个引用，最后一个引用释放会话与关联的输入/输出名称。
+static void release_model(OnnxModel *model) {
+  if (model->refs.fetch_sub(1) > 1) {
     return;
+  }
 
-  OnnxModel *model = (OnnxModel *)handle;
+  // 仍在分析中时先写出 trace，避免会话析构时留下未合并的 ORT 文件。
+  if (!model->trace_path.empty()) {
+    onnx_stop_profiling(model);
+  }
 
   if (model->input_name) {
     model->allocator->Free(model->allocator, model->input_name);
@@ -456,16 +1218,206 @@ FFI_PLUGIN_EXPORT void onnx_unload_model(ModelHandle handle) {
   if (model->output_name) {
     model->allocator->Free(model->allocator, model->output_name);
   }
+  if (model->mask_output_name) {
+    model->allocator->Free(model->allocator, model->mask_output_name);
+  }
   if (model->memory_info) {
     g_ort->ReleaseMemoryInfo(model->memory_info);
   }
   if (model->session) {
     g_ort->ReleaseSession(model->session);
   }
+  onnx_release_detections(&model->dedup_result);
 
   delete model;
 }
 
+FFI_PLUGIN_EXPORT void onnx_unload_model(ModelHandle handle) {
+  if (!handle)
+    return;
+  release_model((OnnxModel *)handle);
+}
+
+#ifdef ONNX_INFERENCE_TESTING
+FFI_PLUGIN_EXPORT ModelHandle onnx_testing_create_model(int input_width,
+                                                        int input_height,
+                                                        const float *output,
+                                                        int num_features,
+                                                        int num_boxes) {
+  clear_last_error();
+  if (input_width <= 0 || input_height <= 0 || !output || num_features <= 0 ||
+      num_boxes <= 0) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "testing_create_model: 参数无效");
+    return nullptr;
+  }
+  OnnxModel *model = new (std::nothrow) OnnxModel();
+  if (!model) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 OnnxModel 失败");
+    return nullptr;
+  }
+  model->input_width = input_width;
+  model->input_height = input_height;
+  model->output_features = num_features;
+  model->output_boxes = num_boxes;
+  model->testing_output = output;
+  model->testing_dims[0] = 1;
+  model->testing_dims[1] = num_features;
+  model->testing_dims[2] = num_boxes;
+  return model;
+}
+#endif
+
+// ============================================================================
+// 后台加载
+// ============================================================================
+
+struct OnnxModelLoad {
+  std::string model_path;
+  OnnxLoadOptions options = {};
+  std::mutex mutex;
+  std::condition_variable finished;
+  bool done = false;
+  bool cancelled = false;
+  // 调用方与后台线程各持有 1，归零时释放。
+  int refs = 2;
+  // 后台线程的结果与错误（done 之后只读）。
+  OnnxModel *model = nullptr;
+  int error_code = ONNX_OK;
+  std::string error;
+};
+
+// 以一张灰色图片（letterbox 填充色）运行一次推理，使 ORT 完成首次运行的
+// 内存分配与算子初始化；失败不影响加载结果。
+static void warm_up_model(OnnxModel *model) {
+  std::vector<uint8_t> image(
+      (size_t)model->input_width * model->input_height * 4, 114);
+  DetectionResult *result =
+      onnx_detect(model, image.data(), model->input_width,
+                  model->input_height, 1.0f, 0.45f, MODEL_TYPE_YOLO, 0);
+  if (result) {
+    onnx_free_result(result);
+  } else {
+    fprintf(stderr, "[警告] 模型预热失败: %s\n", g_last_error);
+  }
+  onnx_reset_stats(model);
+  clear_last_error();
+}
+
+static void run_model_load(OnnxModelLoad *load) {
+  OnnxModel *model = (OnnxModel *)onnx_load_model_with_options(
+      load->model_path.c_str(), &load->options);
+  if (model) {
+    warm_up_model(model);
+  }
+  std::unique_lock<std::mutex> lock(load->mutex);
+  load->model = model;
+  if (!model) {
+    load->error_code =
+        g_last_error_code != ONNX_OK ? g_last_error_code : ONNX_ERROR_UNKNOWN;
+    load->error = g_last_error;
+  }
+  load->done = true;
+  load->finished.notify_all();
+  bool cancelled = load->cancelled;
+  bool last = --load->refs == 0;
+  lock.unlock();
+  // 已放弃的加载由后台线程自行卸载模型。
+  if (cancelled && model) {
+    release_model(model);
+  }
+  if (last) {
+    delete load;
+  }
+  std::lock_guard<std::mutex> init_lock(g_init_mutex);
+  onnx_inflight_end(&g_pending_loads);
+}
+
+FFI_PLUGIN_EXPORT ModelLoadHandle
+onnx_load_model_async(const char *model_path, const OnnxLoadOptions *options) {
+  clear_last_error();
+  if (!model_path || model_path[0] == '\0') {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "model_path 为空");
+    return nullptr;
+  }
+  // 在调用线程初始化运行时，后台线程只创建会话。
+  if (!g_initialized && !onnx_init()) {
+    return nullptr;
+  }
+  OnnxModelLoad *load = new (std::nothrow) OnnxModelLoad();
+  if (!load) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配加载句柄失败");
+    return nullptr;
+  }
+  load->model_path = model_path;
+  onnx_default_load_options(&load->options);
+  if (options) {
+    load->options = *options;
+  }
+  {
+    std::lock_guard<std::mutex> lock(g_init_mutex);
+    onnx_inflight_begin(&g_pending_loads);
+  }
+  try {
+    std::thread(run_model_load, load).detach();
+  } catch (const std::system_error &e) {
+    {
+      std::lock_guard<std::mutex> lock(g_init_mutex);
+      onnx_inflight_end(&g_pending_loads);
+    }
+    delete load;
+    set_last_error(ONNX_ERROR_RUNTIME_FAILURE, "启动加载线程失败: %s",
+                   e.what());
+    return nullptr;
+  }
+  return load;
+}
+
+FFI_PLUGIN_EXPORT int onnx_load_model_done(ModelLoadHandle load) {
+  if (!load)
+    return -1;
+  OnnxModelLoad *pending = (OnnxModelLoad *)load;
+  std::lock_guard<std::mutex> lock(pending->mutex);
+  return pending->done ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT ModelHandle onnx_load_model_finish(ModelLoadHandle load) {
+  clear_last_error();
+  if (!load) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "load 为空");
+    return nullptr;
+  }
+  OnnxModelLoad *pending = (OnnxModelLoad *)load;
+  std::unique_lock<std::mutex> lock(pending->mutex);
+  pending->finished.wait(lock, [pending] { return pending->done; });
+  OnnxModel *model = pending->model;
+  if (!model) {
+    set_last_error(pending->error_code, "%s", pending->error.c_str());
+  }
+  bool last = --pending->refs == 0;
+  lock.unlock();
+  if (last) {
+    delete pending;
+  }
+  return model;
+}
+
+FFI_PLUGIN_EXPORT void onnx_load_model_cancel(ModelLoadHandle load) {
+  if (!load)
+    return;
+  OnnxModelLoad *pending = (OnnxModelLoad *)load;
+  std::unique_lock<std::mutex> lock(pending->mutex);
+  pending->cancelled = true;
+  OnnxModel *model = pending->done ? pending->model : nullptr;
+  bool last = --pending->refs == 0;
+  lock.unlock();
+  if (model) {
+    release_model(model);
+  }
+  if (last) {
+    delete pending;
+  }
+}
+
 FFI_PLUGIN_EXPORT bool onnx_get_input_size(ModelHandle handle, int *width,
                                            int *height) {
   clear_last_error();
@@ -483,452 +1435,1604 @@ FFI_PLUGIN_EXPORT bool onnx_get_input_size(ModelHandle handle, int *width,
 }
 
 // ============================================================================
-// 图像预处理 (letterbox)
+// 推理
 // ============================================================================
 
-/// 预处理图像，执行 letterbox 缩放并写入指定缓冲区
-/// @param image_data 输入 RGBA 图像数据
-/// @param image_width 原始图像宽度
-/// @param image_height 原始图像高度
-/// @param target_width 目标宽度
-/// @param target_height 目标高度
-/// @param buffer 目标缓冲区 (大小必须为 3 * target_width * target_height)
-/// @param scale_x 输出：x 方向缩放比例
-/// @param scale_y 输出：y 方向缩放比例
-/// @param pad_left 输出：左侧填充像素数
-/// @param pad_top 输出：顶部填充像素数
-static void preprocess_image_to_buffer(const uint8_t *image_data,
-                                       int image_width, int image_height,
-                                       int target_width, int target_height,
-                                       float *buffer, float *scale_x,
-                                       float *scale_y, int *pad_left,
-                                       int *pad_top) {
-  if (!image_data || !buffer || target_width <= 0 || target_height <= 0 ||
-      image_width <= 1 || image_height <= 1) {
-    if (scale_x)
-      *scale_x = 0.0f;
-    if (scale_y)
-      *scale_y = 0.0f;
-    if (pad_left)
-      *pad_left = 0;
-    if (pad_top)
-      *pad_top = 0;
-    return;
-  }
-  // 计算 letterbox 缩放比例（保持宽高比）
-  float ratio = std::min((float)target_width / image_width,
-                         (float)target_height / image_height);
-
-  int new_width = (int)(image_width * ratio);
-  int new_height = (int)(image_height * ratio);
-
-  *pad_left = (target_width - new_width) / 2;
-  *pad_top = (target_height - new_height) / 2;
-  *scale_x = ratio;
-  *scale_y = ratio;
-
-  // 填充灰色 (114/255) - YOLO 标准填充值
-  const float pad_value = 114.0f / 255.0f;
-  int total_pixels = target_width * target_height;
-  for (int i = 0; i < 3 * total_pixels; i++) {
-    buffer[i] = pad_value;
-  }
-
-  // 使用双线性插值复制和缩放图像（RGBA -> CHW RGB）。
-  for (int y = 0; y < new_height; y++) {
-    float src_y_f = y / ratio;
-    int src_y = (int)src_y_f;
-    float y_lerp = src_y_f - src_y;
-    if (src_y >= image_height - 1) {
-      src_y = image_height - 2;
-      y_lerp = 1.0f;
-    }
-
-    for (int x = 0; x < new_width; x++) {
-      float src_x_f = x / ratio;
-      int src_x = (int)src_x_f;
-      float x_lerp = src_x_f - src_x;
-      if (src_x >= image_width - 1) {
-        src_x = image_width - 2;
-        x_lerp = 1.0f;
-      }
-
-      int dst_x = x + *pad_left;
-      int dst_y = y + *pad_top;
-      int c_stride = target_width * target_height;
-      int dst_idx = dst_y * target_width + dst_x;
+// 轮廓简化容差（原型像素，YOLOv8 原型为输入的 1/4）。
+static const float kMaskPolygonEpsilon = 0.75f;
 
-      // 对每个通道进行双线性插值
-      for (int c = 0; c < 3; c++) {
-        int idx00 = (src_y * image_width + src_x) * 4 + c;
-        int idx01 = (src_y * image_width + src_x + 1) * 4 + c;
-        int idx10 = ((src_y + 1) * image_width + src_x) * 4 + c;
-        int idx11 = ((src_y + 1) * image_width + src_x + 1) * 4 + c;
+// 模型句柄持有的可复用缓冲区容量（字节）。
+static size_t model_buffer_bytes(const OnnxModel *model) {
+  return model->input_buffer.capacity() * sizeof(float) +
+         model->letterbox.capacity() * sizeof(LetterboxParams) +
+         onnx_scratch_bytes(model->scratch) +
+         model->raw_cache_entry.capacity() +
+         model->sweep_selection.capacity() * sizeof(Detection);
+}
 
-        float v00 = image_data[idx00] / 255.0f;
-        float v01 = image_data[idx01] / 255.0f;
-        float v10 = image_data[idx10] / 255.0f;
-        float v11 = image_data[idx11] / 255.0f;
+// 原始输出缓存条目路径。
+static std::string raw_cache_entry_path(const OnnxModel *model,
+                                        uint64_t image_key) {
+  return onnx_raw_cache_path(model->raw_cache_dir, model->model_hash,
+                             model->input_width, model->input_height,
+                             image_key);
+}
 
-        float v0 = v00 * (1 - x_lerp) + v01 * x_lerp;
-        float v1 = v10 * (1 - x_lerp) + v11 * x_lerp;
-        float v = v0 * (1 - y_lerp) + v1 * y_lerp;
+// 对暂存区候选框执行 NMS（原地压缩，保留者位于前部），返回保留数量。
+// 端到端输出已是最终结果，直接保留全部。
+static size_t suppress_candidates(OnnxModel *model, int model_type,
+                                  float nms_threshold) {
+  DetectionScratch &scratch = model->scratch;
+  if (model->end_to_end) {
+    return scratch.candidates.size();
+  }
+  StageTimer timer(&model->stats, ONNX_STAGE_NMS);
+  return model_type == MODEL_TYPE_YOLO_OBB
+             ? onnx_nms_rotated_inplace(scratch.candidates.data(),
+                                        scratch.candidates.size(),
+                                        nms_threshold)
+             : onnx_nms_inplace(scratch.candidates.data(),
+                                scratch.candidates.size(), nms_threshold);
+}
 
-        buffer[c * c_stride + dst_idx] = v;
+// 多阈值扫描：各 NMS 阈值保留者的并集压缩到暂存区前部，返回并集大小；
+// sweep_kept[j] 为阈值 j 的保留者在并集中的下标。端到端输出各阈值均保留全部。
+static size_t sweep_candidates(OnnxModel *model, int model_type,
+                               const float *nms_thresholds, int num_nms) {
+  DetectionScratch &scratch = model->scratch;
+  std::vector<std::vector<uint32_t>> &kept = model->sweep_kept;
+  size_t count = scratch.candidates.size();
+  if (model->end_to_end) {
+    kept.resize(num_nms);
+    for (auto &list : kept) {
+      list.resize(count);
+      for (size_t i = 0; i < count; i++) {
+        list[i] = (uint32_t)i;
       }
     }
+    return count;
   }
+  StageTimer timer(&model->stats, ONNX_STAGE_NMS);
+  return onnx_nms_sweep(scratch.candidates.data(), count, nms_thresholds,
+                        num_nms, model_type == MODEL_TYPE_YOLO_OBB, &kept);
 }
 
-// ============================================================================
-// YOLOv8 输出解析
-// ============================================================================
-
-// YOLOv8 输出格式: [1, num_features, num_boxes]
-// 检测: num_features = 4 + num_classes
-// 姿态: num_features = 4 + num_classes + num_keypoints * 3
-// 分割: num_features = 4 + num_classes + 32（掩码系数）
-
-/// 解析 YOLOv8 模型输出
-static std::vector<Detection>
-parse_yolov8_output(float *output_data, int num_features, int num_boxes,
-                    int model_type, int num_keypoints, float conf_threshold,
-                    float scale_x, float scale_y, int pad_left, int pad_top,
-                    int image_width, int image_height) {
+// 一次调用的统计范围：结束时归档阶段耗时并累计缓冲区增长；
+// 性能分析期间同时记录整次调用的追踪片段（name 须为静态字符串）。
+struct StatsScope {
+  StatsScope(OnnxModel *model, const char *name)
+      : model(model), name(name), buffer_bytes(model_buffer_bytes(model)),
+        trace_start_ns(model->stats.trace ? onnx_trace_now_ns() : 0) {}
+  ~StatsScope() {
+    size_t now = model_buffer_bytes(model);
+    if (now > buffer_bytes) {
+      model->stats.bytes_allocated += (int64_t)(now - buffer_bytes);
+    }
+    if (model->stats.trace) {
+      onnx_trace_record(model->stats.trace, name, trace_start_ns,
+                        onnx_trace_now_ns() - trace_start_ns);
+    }
+    onnx_stats_commit(&model->stats);
+  }
+  StatsScope(const StatsScope &) = delete;
+  StatsScope &operator=(const StatsScope &) = delete;
 
-  std::vector<Detection> detections;
+  OnnxModel *model;
+  const char *name;
+  size_t buffer_bytes;
+  int64_t trace_start_ns;
+};
 
-  // 根据模型类型计算类别数
-  int num_classes;
-  int extra_features = 0;
+/// 单次推理调用的附加参数：随调用传入，不写在跨调用存在的 OnnxModel 上。
+struct DetectCallOptions {
+  // 各图片的原始输出缓存键（onnx_detect_batch_keyed，其余调用为空）。
+  const uint64_t *cache_keys = nullptr;
+  // 多阈值扫描的 NMS 阈值（onnx_detect_sweep，其余调用为空）。
+  const float *sweep_nms = nullptr;
+  int sweep_num_nms = 0;
+};
 
-  if (model_type == MODEL_TYPE_YOLO_POSE && num_keypoints > 0) {
-    extra_features = num_keypoints * 3;
-    num_classes = num_features - 4 - extra_features;
-  } else {
-    num_classes = num_features - 4;
+/// 推理的后处理部分：按输出张量逐张图片解析、NMS 并回调。
+///
+/// output_data 为 [num_images, output_dims[1], output_dims[2]]；
+/// protos 为分割原型（不可用时 data 为空），proto_stride 为单张图片的跨度。
+template <typename OnImage>
+static bool postprocess_outputs(OnnxModel *model, const float *output_data,
+                                const int64_t *output_dims, size_t dim_count,
+                                const MaskPrototypes &protos,
+                                size_t proto_stride,
+                                const LetterboxParams *letterbox,
+                                int num_images, const int *image_widths,
+                                const int *image_heights, float conf_threshold,
+                                float nms_threshold, int model_type,
+                                int num_keypoints, const char *context,
+                                const DetectCallOptions &call,
+                                OnImage &&on_image) {
+  model->last_result_count = 0;
+  if (dim_count < 3 || output_dims[1] <= 0 || output_dims[2] <= 0) {
+    // 无法识别的输出形状：每张图片返回空结果。
+    for (int i = 0; i < num_images; i++) {
+      if (!on_image(i, (const Detection *)nullptr, 0)) {
+        return false;
+      }
+    }
+    return true;
   }
 
-  if (num_classes < 1) {
-    fprintf(stderr, "[警告] 无效的类别数=%d，设置为 1\n", num_classes);
-    num_classes = 1;
-  }
+  // YOLOv8 输出格式: [batch, num_features, num_boxes]；
+  // 端到端输出格式: [batch, num_rows, row_size]。
+  size_t stride_per_image = (size_t)output_dims[1] * output_dims[2];
+  DetectionScratch &scratch = model->scratch;
+  ModelStats &stats = model->stats;
+  stats.images += num_images;
 
-  for (int i = 0; i < num_boxes; i++) {
-    // YOLOv8 转置格式: output[feature][box]
-    float cx = output_data[0 * num_boxes + i];
-    float cy = output_data[1 * num_boxes + i];
-    float w = output_data[2 * num_boxes + i];
-    float h = output_data[3 * num_boxes + i];
+  // 写入原始输出缓存时以较低的下限解析，缓存后再按本次阈值过滤。
+  bool store_raw = call.cache_keys && !model->raw_cache_dir.empty() &&
+                   onnx_raw_cache_supports(model_type);
+  float parse_threshold =
+      store_raw ? std::min(conf_threshold, kRawCacheMinConfidence)
+                : conf_threshold;
 
-    // 找到最佳类别
-    int best_class = 0;
-    float best_score = 0;
-    for (int c = 0; c < num_classes; c++) {
-      float score = output_data[(4 + c) * num_boxes + i];
-      if (score > best_score) {
-        best_score = score;
-        best_class = c;
+  for (int i = 0; i < num_images; i++) {
+    const LetterboxParams &lb = letterbox[i];
+    const float *image_output = output_data + i * stride_per_image;
+    try {
+      StageTimer timer(&stats, ONNX_STAGE_PARSE);
+      if (model->end_to_end) {
+        parse_end2end_output(image_output, (int)output_dims[2],
+                             (int)output_dims[1], model_type, num_keypoints,
+                             parse_threshold, lb.scale_x, lb.scale_y,
+                             lb.pad_left, lb.pad_top, image_widths[i],
+                             image_heights[i], &scratch);
+      } else {
+        parse_yolov8_output(image_output, (int)output_dims[1],
+                            (int)output_dims[2], model_type, num_keypoints,
+                            parse_threshold, lb.scale_x, lb.scale_y,
+                            lb.pad_left, lb.pad_top, image_widths[i],
+                            image_heights[i], &scratch);
       }
+    } catch (const std::bad_alloc &) {
+      set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "%s: 分配候选框失败",
+                     context);
+      return false;
     }
 
-    if (best_score < conf_threshold)
-      continue;
-
-    // 转换为原始图像坐标（归一化 0-1）。
-    float x_norm = (cx - pad_left) / scale_x / image_width;
-    float y_norm = (cy - pad_top) / scale_y / image_height;
-    float w_norm = w / scale_x / image_width;
-    float h_norm = h / scale_y / image_height;
-
-    Detection det;
-    det.class_id = best_class;
-    det.confidence = best_score;
-    det.x = x_norm;
-    det.y = y_norm;
-    det.width = w_norm;
-    det.height = h_norm;
-    det.keypoints = nullptr;
-    det.num_keypoints = 0;
-
-    // 提取姿态模型的关键点（归一化坐标）。
-    if (model_type == MODEL_TYPE_YOLO_POSE && num_keypoints > 0) {
-      det.num_keypoints = num_keypoints;
-      det.keypoints = (float *)malloc(num_keypoints * 3 * sizeof(float));
-      if (!det.keypoints) {
-        set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配关键点内存失败");
-        det.num_keypoints = 0;
+    if (store_raw) {
+      StageTimer timer(&stats, ONNX_STAGE_PARSE);
+      try {
+        onnx_raw_cache_encode(scratch.candidates.data(),
+                              scratch.candidates.size(), model_type,
+                              num_keypoints, parse_threshold,
+                              &model->raw_cache_entry);
+        // 写入失败（如磁盘已满）只影响后续命中，不视为推理错误。
+        onnx_raw_cache_store(raw_cache_entry_path(model, call.cache_keys[i]),
+                             model->raw_cache_entry);
+      } catch (const std::bad_alloc &) {
       }
+      scratch.candidates.resize(onnx_filter_candidates(
+          scratch.candidates.data(), scratch.candidates.size(),
+          conf_threshold));
+    }
 
-      int kpt_start = 4 + num_classes;
-      for (int k = 0; k < num_keypoints && det.keypoints; k++) {
-        float kp_x = output_data[(kpt_start + k * 3 + 0) * num_boxes + i];
-        float kp_y = output_data[(kpt_start + k * 3 + 1) * num_boxes + i];
-        float kp_v = output_data[(kpt_start + k * 3 + 2) * num_boxes + i];
-
-        // 转换关键点为归一化坐标
-        det.keypoints[k * 3 + 0] = (kp_x - pad_left) / scale_x / image_width;
-        det.keypoints[k * 3 + 1] = (kp_y - pad_top) / scale_y / image_height;
-        det.keypoints[k * 3 + 2] = kp_v;
+    stats.candidates += (int64_t)scratch.candidates.size();
+
+    // 应用 NMS（原地压缩，保留者位于暂存区前部）；
+    // 多阈值扫描时保留者为各阈值的并集。
+    size_t kept;
+    if (call.sweep_nms) {
+      try {
+        kept = sweep_candidates(model, model_type, call.sweep_nms,
+                                call.sweep_num_nms);
+      } catch (const std::bad_alloc &) {
+        set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "%s: 分配扫描结果失败",
+                       context);
+        return false;
+      }
+    } else {
+      kept = suppress_candidates(model, model_type, nms_threshold);
+    }
+    model->last_result_count = (int)kept;
+    stats.detections += (int64_t)kept;
+
+    // 仅对 NMS 保留者组装掩码。
+    if (model_type == MODEL_TYPE_YOLO_SEG) {
+      MaskPrototypes image_protos = protos;
+      if (image_protos.data) {
+        image_protos.data += i * proto_stride;
+      }
+      try {
+        StageTimer timer(&stats, ONNX_STAGE_MASKS);
+        assemble_yolov8_masks(scratch.candidates.data(), (int)kept,
+                              image_protos, lb.scale_x, lb.scale_y,
+                              lb.pad_left, lb.pad_top, image_widths[i],
+                              image_heights[i], kMaskPolygonEpsilon,
+                              &scratch);
+      } catch (const std::bad_alloc &) {
+        set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "%s: 分配掩码失败",
+                       context);
+        return false;
       }
     }
 
-    detections.push_back(det);
+    StageTimer timer(&stats, ONNX_STAGE_MARSHAL);
+    if (!on_image(i, (const Detection *)scratch.candidates.data(), (int)kept)) {
+      return false;
+    }
   }
 
-  return detections;
+  return true;
 }
 
-// ============================================================================
-// 推理
-// ============================================================================
-
-FFI_PLUGIN_EXPORT BatchDetectionResult *
-onnx_detect_batch(ModelHandle handle, const uint8_t **image_data_list,
-                  int num_images, int *image_widths, int *image_heights,
-                  float conf_threshold, float nms_threshold, int model_type,
-                  int num_keypoints) {
-  // 批量推理：分配输入缓冲区并在返回前释放。
-  clear_last_error();
-  if (!handle || !image_data_list || num_images <= 0)
-    return nullptr;
-  if (!image_widths || !image_heights) {
-    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "尺寸数组为空");
-    return nullptr;
+/// 对已完成 letterbox 的输入执行 Run、解析与 NMS，逐张图片回调保留的检测框。
+///
+/// input_data 为 [num_images, 3, h, w] 的连续缓冲区，letterbox 为对应参数。
+/// 回调参数 (index, detections, count) 中的检测框及关键点指向模型暂存区，
+/// 仅在回调期间有效；回调返回 false 时中止并返回 false。
+template <typename OnImage>
+static bool infer_preprocessed(OnnxModel *model, float *input_data,
+                               const LetterboxParams *letterbox,
+                               int num_images, const int *image_widths,
+                               const int *image_heights, float conf_threshold,
+                               float nms_threshold, int model_type,
+                               int num_keypoints, const char *context,
+                               const DetectCallOptions &call,
+                               OnImage &&on_image) {
+#ifdef ONNX_INFERENCE_TESTING
+  // 测试模型：以合成输出代替 Run（仅单张图片），其余路径与真实推理一致。
+  if (model->testing_output) {
+    if (num_images != 1) {
+      set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "%s: 测试模型仅支持单张图片",
+                     context);
+      return false;
+    }
+    return postprocess_outputs(model, model->testing_output,
+                               model->testing_dims, 3, MaskPrototypes(), 0,
+                               letterbox, num_images, image_widths,
+                               image_heights, conf_threshold, nms_threshold,
+                               model_type, num_keypoints, context, call,
+                               std::forward<OnImage>(on_image));
   }
-
-  OnnxModel *model = (OnnxModel *)handle;
+#endif
   int w = model->input_width;
   int h = model->input_height;
-  size_t image_size = 3 * w * h;
-  size_t batch_buffer_size = num_images * image_size * sizeof(float);
-
-  // 分配批量输入缓冲区
-  float *input_data = (float *)malloc(batch_buffer_size);
-  if (!input_data) {
-    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配输入缓冲区失败");
-    return nullptr;
-  }
-
-  // 存储每张图片的缩放参数，供后处理使用
-  std::vector<float> scales_x(num_images);
-  std::vector<float> scales_y(num_images);
-  std::vector<int> pads_left(num_images);
-  std::vector<int> pads_top(num_images);
-
-  // 预处理每张图片
-  // TODO: 可并行化
-  for (int i = 0; i < num_images; i++) {
-    if (!image_data_list[i]) {
-      free(input_data);
-      set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "image_data_list[%d] 为空",
-                     i);
-      return nullptr;
-    }
-    if (!validate_image_dimensions(image_widths[i], image_heights[i],
-                                   "detect_batch")) {
-      free(input_data);
-      return nullptr;
-    }
-
-    float *img_buffer = input_data + i * image_size;
-    preprocess_image_to_buffer(image_data_list[i], image_widths[i],
-                               image_heights[i], w, h, img_buffer, &scales_x[i],
-                               &scales_y[i], &pads_left[i], &pads_top[i]);
-  }
+  size_t batch_elements = (size_t)num_images * 3 * w * h;
 
   // 创建输入张量 [batch, 3, height, width]
   int64_t input_shape[] = {num_images, 3, h, w};
   OrtValue *input_tensor_raw = nullptr;
   OrtStatus *status = g_ort->CreateTensorWithDataAsOrtValue(
-      model->memory_info, input_data, batch_buffer_size, input_shape, 4,
-      ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &input_tensor_raw);
-
+      model->memory_info, input_data, batch_elements * sizeof(float),
+      input_shape, 4, ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT, &input_tensor_raw);
   if (!handle_status(status, "CreateTensorWithDataAsOrtValue")) {
-    free(input_data);
-    return nullptr;
+    return false;
   }
   OrtValuePtr input_tensor(input_tensor_raw);
 
-  // 运行推理
+  // 运行推理（分割模型同时取原型输出）
+  bool want_masks =
+      model_type == MODEL_TYPE_YOLO_SEG && model->mask_output_name;
   const char *input_names[] = {model->input_name};
-  const char *output_names[] = {model->output_name};
-  OrtValue *output_tensor_raw = nullptr;
+  const char *output_names[] = {model->output_name, model->mask_output_name};
+  OrtValue *output_tensors_raw[2] = {nullptr, nullptr};
 
   const OrtValue *input_tensor_ptr = input_tensor.get();
-  status = g_ort->Run(model->session, nullptr, input_names,
-                      &input_tensor_ptr, 1, output_names, 1,
-                      &output_tensor_raw);
-
-  free(input_data);
-
+  {
+    StageTimer timer(&model->stats, ONNX_STAGE_RUN);
+    status = g_ort->Run(model->session, nullptr, input_names,
+                        &input_tensor_ptr, 1, output_names,
+                        want_masks ? 2 : 1, output_tensors_raw);
+  }
   if (!handle_status(status, "Run")) {
-    return nullptr;
+    return false;
+  }
+  OrtValuePtr output_tensor(output_tensors_raw[0]);
+  OrtValuePtr proto_tensor(output_tensors_raw[1]);
+
+  // 原型形状以运行时为准（支持动态输入尺寸）。
+  MaskPrototypes protos;
+  size_t proto_stride = 0;
+  if (want_masks && proto_tensor) {
+    OrtTensorTypeAndShapeInfo *proto_info_raw = nullptr;
+    int64_t proto_dims[4] = {0};
+    size_t proto_dim_count = 0;
+    float *proto_data = nullptr;
+    if (handle_status(g_ort->GetTensorTypeAndShape(proto_tensor.get(),
+                                                   &proto_info_raw),
+                      "GetTensorTypeAndShape")) {
+      OrtTensorInfoPtr proto_info(proto_info_raw);
+      if (handle_status(g_ort->GetDimensionsCount(proto_info.get(),
+                                                  &proto_dim_count),
+                        "GetDimensionsCount") &&
+          proto_dim_count == 4 &&
+          handle_status(g_ort->GetDimensions(proto_info.get(), proto_dims, 4),
+                        "GetDimensions") &&
+          proto_dims[1] == kSegMaskCoeffs &&
+          handle_status(g_ort->GetTensorMutableData(proto_tensor.get(),
+                                                    (void **)&proto_data),
+                        "GetTensorMutableData")) {
+        protos.data = proto_data;
+        protos.height = (int)proto_dims[2];
+        protos.width = (int)proto_dims[3];
+        protos.input_width = w;
+        protos.input_height = h;
+        proto_stride = (size_t)kSegMaskCoeffs * protos.width * protos.height;
+      }
+    }
+    // 原型不可用时退化为无多边形的检测结果，不视为错误。
+    clear_last_error();
   }
-  OrtValuePtr output_tensor(output_tensor_raw);
 
   // 获取输出数据（由 OrtValue 生命周期管理）。
   float *output_data;
   status =
       g_ort->GetTensorMutableData(output_tensor.get(), (void **)&output_data);
   if (!handle_status(status, "GetTensorMutableData")) {
-    return nullptr;
+    return false;
   }
 
   // 获取输出形状
   OrtTensorTypeAndShapeInfo *output_info_raw = nullptr;
   status = g_ort->GetTensorTypeAndShape(output_tensor.get(), &output_info_raw);
   if (!handle_status(status, "GetTensorTypeAndShape")) {
-    return nullptr;
+    return false;
   }
   OrtTensorInfoPtr output_info(output_info_raw);
 
   size_t dim_count;
   status = g_ort->GetDimensionsCount(output_info.get(), &dim_count);
   if (!handle_status(status, "GetDimensionsCount")) {
-    return nullptr;
+    return false;
   }
 
-  std::vector<int64_t> output_dims(dim_count);
-  handle_status(g_ort->GetDimensions(output_info.get(), output_dims.data(),
+  int64_t output_dims[8] = {0};
+  if (dim_count > 8) {
+    dim_count = 8;
+  }
+  handle_status(g_ort->GetDimensions(output_info.get(), output_dims,
                                      dim_count),
                 "GetDimensions");
 
-  // 解析结果并生成返回结构体（调用方需释放）。
-  BatchDetectionResult *batch_result =
-      (BatchDetectionResult *)malloc(sizeof(BatchDetectionResult));
-  if (!batch_result) {
-    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 BatchDetectionResult 失败");
-    return nullptr;
-  }
-  batch_result->num_images = num_images;
-  batch_result->results =
-      (DetectionResult *)malloc(num_images * sizeof(DetectionResult));
-  if (!batch_result->results) {
-    free(batch_result);
-    set_last_error(ONNX_ERROR_ALLOCATION_FAILED,
-                   "分配 DetectionResult 数组失败");
-    return nullptr;
-  }
-  memset(batch_result->results, 0, num_images * sizeof(DetectionResult));
-
-  if (dim_count >= 3 && output_dims[1] > 0 && output_dims[2] > 0) {
-    // YOLOv8 输出格式: [batch, num_features, num_boxes]
-    int num_features = (int)output_dims[1];
-    int num_boxes = (int)output_dims[2];
-    size_t stride_per_image = num_features * num_boxes;
+  return postprocess_outputs(model, output_data, output_dims, dim_count,
+                             protos, proto_stride, letterbox, num_images,
+                             image_widths, image_heights, conf_threshold,
+                             nms_threshold, model_type, num_keypoints, context,
+                             call, std::forward<OnImage>(on_image));
+}
 
-    for (int i = 0; i < num_images; i++) {
-      float *current_output = output_data + i * stride_per_image;
-
-      std::vector<Detection> detections = parse_yolov8_output(
-          current_output, num_features, num_boxes, model_type, num_keypoints,
-          conf_threshold, scales_x[i], scales_y[i], pads_left[i], pads_top[i],
-          image_widths[i], image_heights[i]);
-
-      // 应用 NMS
-      detections = onnx_nms(detections, nms_threshold);
-
-      // 保存结果
-      batch_result->results[i].count = (int)detections.size();
-      batch_result->results[i].capacity = batch_result->results[i].count;
-      if (batch_result->results[i].count > 0) {
-        batch_result->results[i].detections = (Detection *)malloc(
-            batch_result->results[i].count * sizeof(Detection));
-        if (!batch_result->results[i].detections) {
-          set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 Detection 失败");
-          batch_result->results[i].count = 0;
-          batch_result->results[i].capacity = 0;
-          continue;
-        }
-        for (int k = 0; k < batch_result->results[i].count; k++) {
-          batch_result->results[i].detections[k] = detections[k];
-        }
-      } else {
-        batch_result->results[i].detections = nullptr;
+// 校验批量输入的像素指针与尺寸。
+static bool validate_images(const uint8_t *const *image_data_list,
+                            int num_images, const int *image_widths,
+                            const int *image_heights, const char *context) {
+  for (int i = 0; i < num_images; i++) {
+    if (!image_data_list[i]) {
+      set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "%s: image_data_list[%d] 为空",
+                     context, i);
+      return false;
+    }
+    if (!validate_image_dimensions(image_widths[i], image_heights[i],
+                                   context)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// 批量推理核心：校验、预处理到模型复用缓冲区后调用 infer_preprocessed。
+///
+/// 输入张量与 letterbox 参数复用模型暂存区，稳态下不产生堆分配。
+template <typename OnImage>
+static bool run_detection(OnnxModel *model, const uint8_t *const *image_data_list,
+                          int num_images, const int *image_widths,
+                          const int *image_heights, float conf_threshold,
+                          float nms_threshold, int model_type,
+                          int num_keypoints, const char *context,
+                          const DetectCallOptions &call,
+                          OnImage &&on_image) {
+  if (!validate_images(image_data_list, num_images, image_widths,
+                       image_heights, context)) {
+    return false;
+  }
+
+  StatsScope stats_scope(model, context);
+  int w = model->input_width;
+  int h = model->input_height;
+  size_t image_size = (size_t)3 * w * h;
+  size_t batch_elements = (size_t)num_images * image_size;
+
+  // 输入缓冲区只增不减，批量大小稳定后不再分配。
+  try {
+    if (model->input_buffer.size() < batch_elements) {
+      model->input_buffer.resize(batch_elements);
+    }
+    if (model->letterbox.size() < (size_t)num_images) {
+      model->letterbox.resize(num_images);
+    }
+  } catch (const std::bad_alloc &) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "%s: 分配输入缓冲区失败",
+                   context);
+    return false;
+  }
+  float *input_data = model->input_buffer.data();
+
+  // 预处理每张图片
+  // TODO: 可并行化
+  {
+    StageTimer timer(&model->stats, ONNX_STAGE_PREPROCESS);
+    for (int i = 0; i < num_images; i++) {
+      LetterboxParams &lb = model->letterbox[i];
+      preprocess_image_to_buffer(image_data_list[i], image_widths[i],
+                                 image_heights[i], w, h,
+                                 input_data + i * image_size, &lb.scale_x,
+                                 &lb.scale_y, &lb.pad_left, &lb.pad_top);
+    }
+  }
+
+  return infer_preprocessed(model, input_data, model->letterbox.data(),
+                            num_images, image_widths, image_heights,
+                            conf_threshold, nms_threshold, model_type,
+                            num_keypoints, context, call,
+                            std::forward<OnImage>(on_image));
+}
+
+// 分配含 count 个空结果的 BatchDetectionResult，失败时设置错误并返回 NULL。
+static BatchDetectionResult *alloc_batch_result(int count) {
+  BatchDetectionResult *batch_result =
+      (BatchDetectionResult *)malloc(sizeof(BatchDetectionResult));
+  if (!batch_result) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 BatchDetectionResult 失败");
+    return nullptr;
+  }
+  batch_result->num_images = count;
+  batch_result->results =
+      (DetectionResult *)calloc(count, sizeof(DetectionResult));
+  if (!batch_result->results) {
+    free(batch_result);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED,
+                   "分配 DetectionResult 数组失败");
+    return nullptr;
+  }
+  return batch_result;
+}
+
+// 一次近重复批量调用的规划（调用内有效，不跨调用保留）。
+struct DedupPlan {
+  std::vector<uint64_t> hashes;
+  std::vector<int> source; // 结果来源，含义见 onnx_plan_dedup
+  // 需要推理的图片在原批次中的下标及其压缩后的子批次。
+  std::vector<int> index;
+  std::vector<const uint8_t *> images;
+  std::vector<int> widths;
+  std::vector<int> heights;
+  std::vector<uint64_t> keys;
+};
+
+// 近重复跳过的批量推理：只对需要推理的图片运行模型，其余图片复制参照结果。
+static BatchDetectionResult *
+detect_batch_dedup(OnnxModel *model, const uint8_t **image_data_list,
+                   const uint64_t *image_keys, int num_images,
+                   int *image_widths, int *image_heights, float conf_threshold,
+                   float nms_threshold, int model_type, int num_keypoints,
+                   const char *context) {
+  if (!validate_images(image_data_list, num_images, image_widths,
+                       image_heights, context)) {
+    return nullptr;
+  }
+  if (model->dedup_conf != conf_threshold ||
+      model->dedup_nms != nms_threshold ||
+      model->dedup_model_type != model_type ||
+      model->dedup_keypoints != num_keypoints) {
+    model->dedup_reference = DedupReference();
+  }
+
+  BatchDetectionResult *batch_result = alloc_batch_result(num_images);
+  if (!batch_result) {
+    return nullptr;
+  }
+
+  // 按顺序规划后把需要推理的图片压缩成一个子批次。
+  DedupPlan plan;
+  try {
+    plan.hashes.resize(num_images);
+    plan.source.resize(num_images);
+  } catch (const std::bad_alloc &) {
+    onnx_free_batch_result(batch_result);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配近重复暂存区失败");
+    return nullptr;
+  }
+  for (int i = 0; i < num_images; i++) {
+    plan.hashes[i] =
+        onnx_dhash_rgba(image_data_list[i], image_widths[i], image_heights[i]);
+  }
+  DedupReference reference = model->dedup_reference;
+  int skipped = onnx_plan_dedup(plan.hashes.data(), image_widths,
+                                image_heights, num_images,
+                                model->dedup_distance, &reference,
+                                plan.source.data());
+  try {
+    for (int i = 0; i < num_images; i++) {
+      if (plan.source[i] != -1)
+        continue;
+      plan.index.push_back(i);
+      plan.images.push_back(image_data_list[i]);
+      plan.widths.push_back(image_widths[i]);
+      plan.heights.push_back(image_heights[i]);
+      if (image_keys) {
+        plan.keys.push_back(image_keys[i]);
       }
     }
+  } catch (const std::bad_alloc &) {
+    onnx_free_batch_result(batch_result);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配近重复暂存区失败");
+    return nullptr;
+  }
+
+  int inferred = (int)plan.index.size();
+  bool ok = true;
+  if (inferred > 0) {
+    DetectCallOptions call;
+    call.cache_keys = image_keys ? plan.keys.data() : nullptr;
+    ok = run_detection(
+        model, plan.images.data(), inferred, plan.widths.data(),
+        plan.heights.data(), conf_threshold, nms_threshold, model_type,
+        num_keypoints, context, call,
+        [&](int k, const Detection *detections, int count) {
+          int i = plan.index[k];
+          if (!onnx_copy_detections(detections, count,
+                                    &batch_result->results[i])) {
+            set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 Detection 失败");
+            return false;
+          }
+          model->stats.bytes_allocated +=
+              onnx_result_bytes(detections, count);
+          return true;
+        });
+  }
+  if (!ok) {
+    onnx_free_batch_result(batch_result);
+    return nullptr;
+  }
+
+  for (int i = 0; i < num_images; i++) {
+    int source = plan.source[i];
+    if (source == -1)
+      continue;
+    const DetectionResult &from = source >= 0 ? batch_result->results[source]
+                                              : model->dedup_result;
+    if (!onnx_copy_detections(from.detections, from.count,
+                              &batch_result->results[i])) {
+      onnx_free_batch_result(batch_result);
+      set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 Detection 失败");
+      return nullptr;
+    }
+    model->stats.bytes_allocated +=
+        onnx_result_bytes(from.detections, from.count);
   }
 
+  // 本批有推理时，最后一张推理的图片成为下一次调用的参照。
+  if (inferred > 0) {
+    const DetectionResult &last = batch_result->results[plan.index.back()];
+    onnx_release_detections(&model->dedup_result);
+    if (!onnx_copy_detections(last.detections, last.count,
+                              &model->dedup_result)) {
+      reference = DedupReference();
+    }
+  }
+  model->dedup_reference = reference;
+  model->dedup_conf = conf_threshold;
+  model->dedup_nms = nms_threshold;
+  model->dedup_model_type = model_type;
+  model->dedup_keypoints = num_keypoints;
+  model->stats.dedup_skipped += skipped;
   return batch_result;
 }
 
+// 批量推理：结果深拷贝到堆分配的返回结构体（调用方需释放）。
+// image_keys 非空时同时写入原始输出缓存。
+static BatchDetectionResult *
+detect_batch_with_keys(ModelHandle handle, const uint8_t **image_data_list,
+                       const uint64_t *image_keys, int num_images,
+                       int *image_widths, int *image_heights,
+                       float conf_threshold, float nms_threshold,
+                       int model_type, int num_keypoints,
+                       const char *context) {
+  clear_last_error();
+  if (!handle || !image_data_list || num_images <= 0)
+    return nullptr;
+  if (!image_widths || !image_heights) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "尺寸数组为空");
+    return nullptr;
+  }
+
+  OnnxModel *model = (OnnxModel *)handle;
+  if (model->dedup_distance >= 0) {
+    return detect_batch_dedup(model, image_data_list, image_keys, num_images,
+                              image_widths, image_heights, conf_threshold,
+                              nms_threshold, model_type, num_keypoints,
+                              context);
+  }
+  BatchDetectionResult *batch_result = alloc_batch_result(num_images);
+  if (!batch_result) {
+    return nullptr;
+  }
+
+  DetectCallOptions call;
+  call.cache_keys = image_keys;
+  bool ok = run_detection(
+      model, image_data_list, num_images, image_widths, image_heights,
+      conf_threshold, nms_threshold, model_type, num_keypoints, context, call,
+      [&](int i, const Detection *detections, int count) {
+        if (!onnx_copy_detections(detections, count,
+                                  &batch_result->results[i])) {
+          set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 Detection 失败");
+          return false;
+        }
+        model->stats.bytes_allocated += onnx_result_bytes(detections, count);
+        return true;
+      });
+
+  if (!ok) {
+    onnx_free_batch_result(batch_result);
+    return nullptr;
+  }
+  return batch_result;
+}
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_batch(ModelHandle handle, const uint8_t **image_data_list,
+                  int num_images, int *image_widths, int *image_heights,
+                  float conf_threshold, float nms_threshold, int model_type,
+                  int num_keypoints) {
+  return detect_batch_with_keys(handle, image_data_list, nullptr, num_images,
+                                image_widths, image_heights, conf_threshold,
+                                nms_threshold, model_type, num_keypoints,
+                                "detect_batch");
+}
+
 FFI_PLUGIN_EXPORT DetectionResult *
 onnx_detect(ModelHandle handle, const uint8_t *image_data, int image_width,
             int image_height, float conf_threshold, float nms_threshold,
             int model_type, int num_keypoints) {
-  // 单张推理：包装批量接口并转移检测结果指针所有权。
+  // 单张推理：直接写入单个结果结构体，不经过批量外壳。
+  clear_last_error();
+  if (!image_data) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "image_data 为空");
+    return nullptr;
+  }
+  if (!validate_image_dimensions(image_width, image_height, "detect")) {
+    return nullptr;
+  }
+  if (!handle)
+    return nullptr;
+
+  const uint8_t *image_list[] = {image_data};
+  int widths[] = {image_width};
+  int heights[] = {image_height};
+
+  DetectionResult *result =
+      (DetectionResult *)calloc(1, sizeof(DetectionResult));
+  if (!result) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 DetectionResult 失败");
+    return nullptr;
+  }
+
+  OnnxModel *model = (OnnxModel *)handle;
+  bool ok = run_detection(
+      model, image_list, 1, widths, heights, conf_threshold, nms_threshold,
+      model_type, num_keypoints, "detect", DetectCallOptions(),
+      [&](int, const Detection *detections, int count) {
+        if (!onnx_copy_detections(detections, count, result)) {
+          set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 Detection 失败");
+          return false;
+        }
+        model->stats.bytes_allocated += onnx_result_bytes(detections, count);
+        return true;
+      });
+
+  if (!ok) {
+    onnx_free_result(result);
+    return nullptr;
+  }
+  return result;
+}
+
+FFI_PLUGIN_EXPORT int onnx_detect_into(ModelHandle handle,
+                                       const uint8_t *image_data,
+                                       int image_width, int image_height,
+                                       float conf_threshold,
+                                       float nms_threshold, int model_type,
+                                       int num_keypoints,
+                                       OnnxResultBuffer *out) {
+  // 单张推理：结果写入调用方缓冲区，不分配返回结构体。
   clear_last_error();
+  if (!handle || !out) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 或 out 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  out->count = 0;
+  out->arena_used = 0;
   if (!image_data) {
     set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "image_data 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+
+  const uint8_t *image_list[] = {image_data};
+  int widths[] = {image_width};
+  int heights[] = {image_height};
+
+  int code = ONNX_OK;
+  bool ok = run_detection(
+      (OnnxModel *)handle, image_list, 1, widths, heights, conf_threshold,
+      nms_threshold, model_type, num_keypoints, "detect_into",
+      DetectCallOptions(), [&](int, const Detection *detections, int count) {
+        code = onnx_pack_result(detections, count, out);
+        return true;
+      });
+
+  if (!ok) {
+    return g_last_error_code != ONNX_OK ? g_last_error_code
+                                        : ONNX_ERROR_UNKNOWN;
+  }
+  if (code == ONNX_ERROR_BUFFER_TOO_SMALL) {
+    set_last_error(code, "结果缓冲区不足: 需要 %d 个检测, %lld 字节数据区",
+                   out->required_capacity, (long long)out->required_arena);
+  }
+  return code;
+}
+
+FFI_PLUGIN_EXPORT int onnx_copy_last_result(ModelHandle handle,
+                                            OnnxResultBuffer *out) {
+  // 从暂存区取回最近一次结果（用于扩容后重取，避免重新推理）。
+  clear_last_error();
+  if (!handle || !out) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 或 out 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  int code = onnx_pack_result(model->scratch.candidates.data(),
+                              model->last_result_count, out);
+  if (code == ONNX_ERROR_BUFFER_TOO_SMALL) {
+    set_last_error(code, "结果缓冲区不足: 需要 %d 个检测, %lld 字节数据区",
+                   out->required_capacity, (long long)out->required_arena);
+  }
+  return code;
+}
+
+// ============================================================================
+// 原始输出缓存
+// ============================================================================
+
+FFI_PLUGIN_EXPORT int onnx_enable_raw_cache(ModelHandle handle,
+                                            const char *cache_dir) {
+  clear_last_error();
+  if (!handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  if (!cache_dir || !cache_dir[0]) {
+    model->raw_cache_dir.clear();
+    return ONNX_OK;
+  }
+  // 以模型文件内容而非路径为键：同名模型重新导出后旧条目自然失效。
+  uint64_t model_hash = 0;
+  if (!onnx_hash_mapped_file(model->model_path, &model_hash)) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无法读取模型文件: %s",
+                   model->model_path.c_str());
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  model->model_hash = model_hash;
+  model->raw_cache_dir = cache_dir;
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT DetectionResult *
+onnx_detect_cached(ModelHandle handle, uint64_t image_key,
+                   float conf_threshold, float nms_threshold, int model_type,
+                   int num_keypoints) {
+  // 命中时只做过滤与 NMS：不运行模型，也不需要图片像素。
+  clear_last_error();
+  if (!handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 为空");
+    return nullptr;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  if (model->raw_cache_dir.empty() || !onnx_raw_cache_supports(model_type)) {
+    set_last_error(ONNX_ERROR_NO_RESULT, "未启用原始输出缓存");
+    return nullptr;
+  }
+
+  DetectionScratch &scratch = model->scratch;
+  model->last_result_count = 0;
+  auto load_start = std::chrono::steady_clock::now();
+  bool hit = false;
+  try {
+    hit = onnx_raw_cache_load(raw_cache_entry_path(model, image_key),
+                              model_type, num_keypoints, conf_threshold,
+                              &scratch);
+  } catch (const std::bad_alloc &) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "detect_cached: 分配候选框失败");
+    return nullptr;
+  }
+  if (!hit) {
+    set_last_error(ONNX_ERROR_NO_RESULT, "原始输出缓存未命中");
+    return nullptr;
+  }
+
+  // 未命中不计入统计；命中时读取耗时计入解析阶段。
+  StatsScope stats_scope(model, "detect_cached");
+  ModelStats &stats = model->stats;
+  stats.current_ms[ONNX_STAGE_PARSE] +=
+      std::chrono::duration<double, std::milli>(
+          std::chrono::steady_clock::now() - load_start)
+          .count();
+  stats.images += 1;
+  stats.candidates += (int64_t)scratch.candidates.size();
+  size_t kept = suppress_candidates(model, model_type, nms_threshold);
+  model->last_result_count = (int)kept;
+  stats.detections += (int64_t)kept;
+
+  StageTimer timer(&stats, ONNX_STAGE_MARSHAL);
+  DetectionResult *result =
+      (DetectionResult *)calloc(1, sizeof(DetectionResult));
+  if (!result || !onnx_copy_detections(scratch.candidates.data(), (int)kept,
+                                       result)) {
+    free(result);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配 DetectionResult 失败");
     return nullptr;
   }
-  if (!validate_image_dimensions(image_width, image_height, "detect")) {
-    return nullptr;
+  stats.bytes_allocated += onnx_result_bytes(scratch.candidates.data(),
+                                             (int)kept);
+  return result;
+}
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_batch_keyed(ModelHandle handle, const uint8_t **image_data_list,
+                        const uint64_t *image_keys, int num_images,
+                        int *image_widths, int *image_heights,
+                        float conf_threshold, float nms_threshold,
+                        int model_type, int num_keypoints) {
+  return detect_batch_with_keys(handle, image_data_list, image_keys,
+                                num_images, image_widths, image_heights,
+                                conf_threshold, nms_threshold, model_type,
+                                num_keypoints, "detect_batch_keyed");
+}
+
+// ============================================================================
+// 近重复跳过
+// ============================================================================
+
+FFI_PLUGIN_EXPORT int onnx_set_dedup(ModelHandle handle, int max_distance) {
+  clear_last_error();
+  if (!handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  if (max_distance > 64) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的汉明距离: %d",
+                   max_distance);
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  // 重新设置时丢弃参照，下一张图片总是实际推理。
+  OnnxModel *model = (OnnxModel *)handle;
+  model->dedup_distance = max_distance < 0 ? -1 : max_distance;
+  model->dedup_reference = DedupReference();
+  onnx_release_detections(&model->dedup_result);
+  return ONNX_OK;
+}
+
+// ============================================================================
+// 两级级联
+// ============================================================================
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *onnx_detect_batch_cascade(
+    ModelHandle fast, ModelHandle heavy, const uint8_t **image_data_list,
+    int num_images, int *image_widths, int *image_heights,
+    float conf_threshold, float nms_threshold, int model_type,
+    int num_keypoints, const OnnxCascadeOptions *options) {
+  clear_last_error();
+  OnnxCascadeOptions rules;
+  onnx_default_cascade_options(&rules);
+  if (options) {
+    rules = *options;
+  }
+  if (!fast || !heavy || !onnx_cascade_options_valid(rules)) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的级联参数");
+    return nullptr;
+  }
+
+  // 快速模型以不确定区间下限运行，才能看到区间内低于最终阈值的检测。
+  float fast_conf = std::min(conf_threshold, rules.uncertain_low);
+  BatchDetectionResult *result = detect_batch_with_keys(
+      fast, image_data_list, nullptr, num_images, image_widths, image_heights,
+      fast_conf, nms_threshold, model_type, num_keypoints, "cascade_fast");
+  if (!result) {
+    return nullptr;
+  }
+
+  std::vector<int> escalated;
+  std::vector<const uint8_t *> images;
+  std::vector<int> widths, heights;
+  try {
+    for (int i = 0; i < num_images; i++) {
+      const DetectionResult &fast_result = result->results[i];
+      if (!onnx_cascade_should_escalate(fast_result.detections,
+                                        fast_result.count, rules)) {
+        onnx_filter_result(&result->results[i], conf_threshold);
+        continue;
+      }
+      escalated.push_back(i);
+      images.push_back(image_data_list[i]);
+      widths.push_back(image_widths[i]);
+      heights.push_back(image_heights[i]);
+    }
+  } catch (const std::bad_alloc &) {
+    onnx_free_batch_result(result);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配级联暂存区失败");
+    return nullptr;
+  }
+
+  // 升级的图片单独分批送入重模型，结果替换快速模型的结果。
+  int total = (int)escalated.size();
+  int step = rules.heavy_batch_size > 0 ? rules.heavy_batch_size : total;
+  for (int start = 0; start < total; start += step) {
+    int count = std::min(step, total - start);
+    BatchDetectionResult *heavy_result = detect_batch_with_keys(
+        heavy, images.data() + start, nullptr, count, widths.data() + start,
+        heights.data() + start, conf_threshold, nms_threshold, model_type,
+        num_keypoints, "cascade_heavy");
+    if (!heavy_result) {
+      onnx_free_batch_result(result);
+      return nullptr;
+    }
+    for (int k = 0; k < count; k++) {
+      DetectionResult &slot = result->results[escalated[start + k]];
+      onnx_release_detections(&slot);
+      slot = heavy_result->results[k];
+      heavy_result->results[k] = DetectionResult();
+    }
+    onnx_free_batch_result(heavy_result);
+  }
+
+  OnnxModel *model = (OnnxModel *)fast;
+  model->stats.cascade_images += num_images;
+  model->stats.cascade_escalated += total;
+  return result;
+}
+
+// ============================================================================
+// 多阈值扫描
+// ============================================================================
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_sweep(ModelHandle handle, const uint8_t *image_data,
+                  int image_width, int image_height,
+                  const float *conf_thresholds, int num_conf,
+                  const float *nms_thresholds, int num_nms, int model_type,
+                  int num_keypoints) {
+  clear_last_error();
+  if (!handle || !image_data)
+    return nullptr;
+  if (!conf_thresholds || num_conf <= 0 || !nms_thresholds || num_nms <= 0 ||
+      num_nms > kMaxSweepNmsThresholds ||
+      (int64_t)num_conf * num_nms > INT32_MAX) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT,
+                   "detect_sweep: 阈值数组无效（NMS 阈值 1-%d 个）",
+                   kMaxSweepNmsThresholds);
+    return nullptr;
+  }
+
+  OnnxModel *model = (OnnxModel *)handle;
+  BatchDetectionResult *batch_result = alloc_batch_result(num_conf * num_nms);
+  if (!batch_result) {
+    return nullptr;
+  }
+
+  // 以最低置信度阈值解析一次，各组合从并集中按阈值挑选。
+  float min_conf = *std::min_element(conf_thresholds,
+                                     conf_thresholds + num_conf);
+  const uint8_t *image_list[] = {image_data};
+  DetectCallOptions call;
+  call.sweep_nms = nms_thresholds;
+  call.sweep_num_nms = num_nms;
+  bool ok = run_detection(
+      model, image_list, 1, &image_width, &image_height, min_conf,
+      nms_thresholds[0], model_type, num_keypoints, "detect_sweep", call,
+      [&](int, const Detection *detections, int count) {
+        std::vector<Detection> &selection = model->sweep_selection;
+        for (int ci = 0; ci < num_conf; ci++) {
+          for (int ni = 0; ni < num_nms; ni++) {
+            selection.clear();
+            try {
+              for (uint32_t index : model->sweep_kept[ni]) {
+                if (count > 0 &&
+                    detections[index].confidence >= conf_thresholds[ci]) {
+                  selection.push_back(detections[index]);
+                }
+              }
+            } catch (const std::bad_alloc &) {
+              set_last_error(ONNX_ERROR_ALLOCATION_FAILED,
+                             "detect_sweep: 分配扫描结果失败");
+              return false;
+            }
+            int n = (int)selection.size();
+            if (!onnx_copy_detections(
+                    selection.data(), n,
+                    &batch_result->results[ci * num_nms + ni])) {
+              set_last_error(ONNX_ERROR_ALLOCATION_FAILED,
+                             "分配 Detection 失败");
+              return false;
+            }
+            model->stats.bytes_allocated +=
+                onnx_result_bytes(selection.data(), n);
+          }
+        }
+        return true;
+      });
+
+  if (!ok) {
+    onnx_free_batch_result(batch_result);
+    return nullptr;
+  }
+  return batch_result;
+}
+
+// ============================================================================
+// 流式批量推理
+// ============================================================================
+
+// 默认内存预算与微批次上限。
+static const int64_t kDefaultStreamBudget = 256LL * 1024 * 1024;
+static const int kMaxStreamBatch = 64;
+// 中间激活按输入张量的倍数估算（YOLOv8 量级的经验值）。
+static const int64_t kActivationFactor = 4;
+
+// 流式批量中单张图片的待取结果（检测框的关键点指针指向 keypoints）。
+struct StreamResult {
+  int64_t tag = 0;
+  std::vector<Detection> detections;
+  std::vector<float> keypoints;
+  std::vector<float> polygons;
+};
+
+struct OnnxBatchStream {
+  OnnxModel *model = nullptr;
+  float conf_threshold = 0.25f;
+  float nms_threshold = 0.45f;
+  int model_type = MODEL_TYPE_YOLO;
+  int num_keypoints = 0;
+  int batch_size = 1;
+  // 当前微批次的 letterbox 输入与元数据（容量为 batch_size 张图片）。
+  std::vector<float> input_buffer;
+  std::vector<LetterboxParams> letterbox;
+  std::vector<int> widths;
+  std::vector<int> heights;
+  std::vector<int64_t> tags;
+  int staged = 0;
+  // 待取结果队列与可复用的结果槽（保留 vector 容量）。
+  std::deque<StreamResult> results;
+  std::vector<StreamResult> free_slots;
+};
+
+// 根据内存预算推导微批次大小。
+static int stream_batch_size(const OnnxModel *model, int64_t budget) {
+  int64_t input_bytes =
+      3LL * model->input_width * model->input_height * (int64_t)sizeof(float);
+  int64_t output_bytes =
+      model->output_features > 0 && model->output_boxes > 0
+          ? (int64_t)model->output_features * model->output_boxes *
+                (int64_t)sizeof(float)
+          : input_bytes;
+  int64_t proto_bytes = (int64_t)kSegMaskCoeffs * model->proto_width *
+                        model->proto_height * (int64_t)sizeof(float);
+  int64_t per_image =
+      input_bytes * (1 + kActivationFactor) + output_bytes + proto_bytes;
+  int64_t size = per_image > 0 ? budget / per_image : 1;
+  return (int)std::max<int64_t>(1, std::min<int64_t>(size, kMaxStreamBatch));
+}
+
+// 复制检测结果到结果槽（关键点与多边形深拷贝到槽内连续缓冲区）。
+static void store_stream_result(OnnxBatchStream *stream, int64_t tag,
+                                const Detection *detections, int count) {
+  StreamResult slot;
+  if (!stream->free_slots.empty()) {
+    slot = std::move(stream->free_slots.back());
+    stream->free_slots.pop_back();
+  }
+  slot.tag = tag;
+  slot.detections.assign(detections, detections + count);
+
+  size_t total_kpts = 0;
+  size_t total_polygon = 0;
+  for (int i = 0; i < count; i++) {
+    if (detections[i].keypoints && detections[i].num_keypoints > 0) {
+      total_kpts += (size_t)detections[i].num_keypoints * 3;
+    }
+    if (detections[i].polygon && detections[i].num_polygon_points > 0) {
+      total_polygon += (size_t)detections[i].num_polygon_points * 2;
+    }
+  }
+  slot.keypoints.resize(total_kpts);
+  slot.polygons.resize(total_polygon);
+  size_t offset = 0;
+  size_t polygon_offset = 0;
+  for (Detection &det : slot.detections) {
+    if (det.keypoints && det.num_keypoints > 0) {
+      size_t n = (size_t)det.num_keypoints * 3;
+      memcpy(slot.keypoints.data() + offset, det.keypoints, n * sizeof(float));
+      det.keypoints = slot.keypoints.data() + offset;
+      offset += n;
+    } else {
+      det.keypoints = nullptr;
+      det.num_keypoints = 0;
+    }
+    if (det.polygon && det.num_polygon_points > 0) {
+      size_t n = (size_t)det.num_polygon_points * 2;
+      memcpy(slot.polygons.data() + polygon_offset, det.polygon,
+             n * sizeof(float));
+      det.polygon = slot.polygons.data() + polygon_offset;
+      polygon_offset += n;
+    } else {
+      det.polygon = nullptr;
+      det.num_polygon_points = 0;
+    }
+  }
+  stream->results.push_back(std::move(slot));
+}
+
+// 对已暂存的微批次执行推理，结果进入待取队列。
+static int run_stream_batch(OnnxBatchStream *stream) {
+  if (stream->staged == 0)
+    return ONNX_OK;
+  int staged = stream->staged;
+  stream->staged = 0;
+
+  StatsScope stats_scope(stream->model, "stream_batch");
+  bool ok = false;
+  try {
+    ok = infer_preprocessed(
+        stream->model, stream->input_buffer.data(), stream->letterbox.data(),
+        staged, stream->widths.data(), stream->heights.data(),
+        stream->conf_threshold, stream->nms_threshold, stream->model_type,
+        stream->num_keypoints, "stream", DetectCallOptions(),
+        [&](int i, const Detection *detections, int count) {
+          store_stream_result(stream, stream->tags[i], detections, count);
+          return true;
+        });
+  } catch (const std::bad_alloc &) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "stream: 分配结果失败");
+    return ONNX_ERROR_ALLOCATION_FAILED;
+  }
+  if (!ok) {
+    // 调用方据线程局部错误判断失败，微批次已丢弃，不能只返回错误码。
+    if (g_last_error_code == ONNX_OK) {
+      set_last_error(ONNX_ERROR_UNKNOWN, "stream: 微批次推理失败");
+    }
+    return g_last_error_code;
+  }
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT BatchStreamHandle
+onnx_stream_create(ModelHandle handle, float conf_threshold,
+                   float nms_threshold, int model_type, int num_keypoints,
+                   int64_t memory_budget_bytes) {
+  clear_last_error();
+  if (!handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 为空");
+    return nullptr;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  int64_t budget =
+      memory_budget_bytes > 0 ? memory_budget_bytes : kDefaultStreamBudget;
+
+  OnnxBatchStream *stream = new (std::nothrow) OnnxBatchStream();
+  if (!stream) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配流式会话失败");
+    return nullptr;
+  }
+  stream->model = model;
+  stream->conf_threshold = conf_threshold;
+  stream->nms_threshold = nms_threshold;
+  stream->model_type = model_type;
+  stream->num_keypoints = num_keypoints;
+  stream->batch_size = stream_batch_size(model, budget);
+
+  // 微批次输入一次性分配，之后推入不再增长。
+  size_t batch = (size_t)stream->batch_size;
+  try {
+    stream->input_buffer.resize(batch * 3 * model->input_width *
+                                model->input_height);
+    stream->letterbox.resize(batch);
+    stream->widths.resize(batch);
+    stream->heights.resize(batch);
+    stream->tags.resize(batch);
+  } catch (const std::bad_alloc &) {
+    delete stream;
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "分配流式输入缓冲区失败");
+    return nullptr;
+  }
+  // 会话持有模型引用，模型先于会话卸载时延后释放。
+  model->refs.fetch_add(1);
+  return stream;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_push(BatchStreamHandle stream_handle,
+                                       const uint8_t *image_data,
+                                       int image_width, int image_height,
+                                       int64_t tag) {
+  clear_last_error();
+  if (!stream_handle || !image_data) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "stream 或 image_data 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  if (!validate_image_dimensions(image_width, image_height, "stream_push")) {
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxBatchStream *stream = (OnnxBatchStream *)stream_handle;
+  OnnxModel *model = stream->model;
+
+  int slot = stream->staged;
+  size_t image_size = (size_t)3 * model->input_width * model->input_height;
+  LetterboxParams &lb = stream->letterbox[slot];
+  {
+    // 预处理耗时计入该微批次的统计。
+    StageTimer timer(&model->stats, ONNX_STAGE_PREPROCESS);
+    preprocess_image_to_buffer(image_data, image_width, image_height,
+                               model->input_width, model->input_height,
+                               stream->input_buffer.data() + slot * image_size,
+                               &lb.scale_x, &lb.scale_y, &lb.pad_left,
+                               &lb.pad_top);
+  }
+  stream->widths[slot] = image_width;
+  stream->heights[slot] = image_height;
+  stream->tags[slot] = tag;
+  stream->staged++;
+
+  if (stream->staged >= stream->batch_size) {
+    return run_stream_batch(stream);
+  }
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_flush(BatchStreamHandle stream_handle) {
+  clear_last_error();
+  if (!stream_handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "stream 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  return run_stream_batch((OnnxBatchStream *)stream_handle);
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_pending(BatchStreamHandle stream_handle) {
+  if (!stream_handle)
+    return 0;
+  return (int)((OnnxBatchStream *)stream_handle)->results.size();
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_batch_size(BatchStreamHandle stream_handle) {
+  if (!stream_handle)
+    return 0;
+  return ((OnnxBatchStream *)stream_handle)->batch_size;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stream_next(BatchStreamHandle stream_handle,
+                                       int64_t *tag, OnnxResultBuffer *out) {
+  clear_last_error();
+  if (!stream_handle || !out) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "stream 或 out 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxBatchStream *stream = (OnnxBatchStream *)stream_handle;
+  if (stream->results.empty()) {
+    out->count = 0;
+    out->arena_used = 0;
+    return ONNX_ERROR_NO_RESULT;
+  }
+
+  StreamResult &front = stream->results.front();
+  int code = onnx_pack_result(front.detections.data(),
+                              (int)front.detections.size(), out);
+  if (code != ONNX_OK) {
+    set_last_error(code, "结果缓冲区不足: 需要 %d 个检测, %lld 字节数据区",
+                   out->required_capacity, (long long)out->required_arena);
+    return code;
+  }
+  if (tag) {
+    *tag = front.tag;
+  }
+  stream->free_slots.push_back(std::move(front));
+  stream->results.pop_front();
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT void onnx_stream_destroy(BatchStreamHandle stream_handle) {
+  if (!stream_handle)
+    return;
+  OnnxBatchStream *stream = (OnnxBatchStream *)stream_handle;
+  OnnxModel *model = stream->model;
+  delete stream;
+  release_model(model);
+}
+
+FFI_PLUGIN_EXPORT int onnx_get_stats(ModelHandle handle, OnnxStats *out) {
+  clear_last_error();
+  if (!handle || !out) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 或 out 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  onnx_stats_snapshot(((OnnxModel *)handle)->stats, out);
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT void onnx_reset_stats(ModelHandle handle) {
+  clear_last_error();
+  if (!handle)
+    return;
+  ModelStats &stats = ((OnnxModel *)handle)->stats;
+  std::vector<TraceSpan> *trace = stats.trace;
+  stats = ModelStats();
+  stats.trace = trace;
+}
+
+// ============================================================================
+// 性能分析
+// ============================================================================
+
+static int64_t current_process_id() {
+#ifdef _WIN32
+  return (int64_t)_getpid();
+#else
+  return (int64_t)getpid();
+#endif
+}
+
+// 读取整个文本文件，失败返回 false。
+static bool read_text_file(const char *path, std::string *out) {
+  FILE *file = fopen(path, "rb");
+  if (!file)
+    return false;
+  char chunk[64 * 1024];
+  size_t n = 0;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    out->append(chunk, n);
+  }
+  bool ok = ferror(file) == 0;
+  fclose(file);
+  return ok;
+}
+
+FFI_PLUGIN_EXPORT int onnx_start_profiling(ModelHandle handle,
+                                           const char *trace_path) {
+  clear_last_error();
+  if (!handle || !trace_path || trace_path[0] == '\0') {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "句柄或 trace_path 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  if (!model->trace_path.empty()) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "性能分析已在进行中");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+
+  // ORT 只能在创建会话时开启分析，因此以相同参数重建会话。ORT 会在前缀后
+  // 追加时间戳，原始文件在结束时合并后删除。
+  std::string prefix = std::string(trace_path) + ".ort";
+  OrtSession *session =
+      create_session(model->model_path.c_str(), model->options, prefix.c_str());
+  if (!session) {
+    return g_last_error_code;
+  }
+  uint64_t start_ns = 0;
+  if (!handle_status(g_ort->SessionGetProfilingStartTimeNs(session, &start_ns),
+                     "SessionGetProfilingStartTimeNs")) {
+    g_ort->ReleaseSession(session);
+    return g_last_error_code;
+  }
+
+  g_ort->ReleaseSession(model->session);
+  model->session = session;
+  model->trace_path = trace_path;
+  model->profile_start_ns = (int64_t)start_ns;
+  model->trace_spans.clear();
+  model->stats.trace = &model->trace_spans;
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT int onnx_stop_profiling(ModelHandle handle) {
+  clear_last_error();
+  if (!handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  if (model->trace_path.empty()) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "性能分析未开启");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  model->stats.trace = nullptr;
+
+  // 结束 ORT 分析（写出其 JSON 文件），读入后删除原始文件。
+  std::string ort_json;
+  char *ort_file = nullptr;
+  if (handle_status(g_ort->SessionEndProfiling(model->session,
+                                               model->allocator, &ort_file),
+                    "SessionEndProfiling") &&
+      ort_file) {
+    if (read_text_file(ort_file, &ort_json)) {
+      remove(ort_file);
+    }
+    model->allocator->Free(model->allocator, ort_file);
+  }
+
+  std::string merged =
+      onnx_merge_trace(ort_json, model->trace_spans, model->profile_start_ns,
+                       current_process_id());
+  std::string trace_path;
+  trace_path.swap(model->trace_path);
+  std::vector<TraceSpan>().swap(model->trace_spans);
+
+  FILE *file = fopen(trace_path.c_str(), "wb");
+  bool written = file && fwrite(merged.data(), 1, merged.size(), file) ==
+                             merged.size();
+  if (file && fclose(file) != 0) {
+    written = false;
+  }
+  if (!written) {
+    set_last_error(ONNX_ERROR_RUNTIME_FAILURE, "写入性能分析文件失败: %s",
+                   trace_path.c_str());
+    return ONNX_ERROR_RUNTIME_FAILURE;
+  }
+  return ONNX_OK;
+}
+
+// ============================================================================
+// 内存
+// ============================================================================
+
+// 读取会话 CPU 内存池的申请量与在用量；运行时不支持时保持 -1。
+static void read_arena_usage(OnnxModel *model, OnnxMemoryUsage *out) {
+#if ORT_API_VERSION >= 23
+  OrtAllocator *allocator = nullptr;
+  if (!handle_status(g_ort->CreateAllocator(model->session, model->memory_info,
+                                            &allocator),
+                     "CreateAllocator")) {
+    clear_last_error();
+    return;
+  }
+  OrtKeyValuePairs *stats = nullptr;
+  if (handle_status(g_ort->AllocatorGetStats(allocator, &stats),
+                    "AllocatorGetStats") &&
+      stats) {
+    const char *const *keys = nullptr;
+    const char *const *values = nullptr;
+    size_t count = 0;
+    g_ort->GetKeyValuePairs(stats, &keys, &values, &count);
+    for (size_t i = 0; i < count; i++) {
+      if (strcmp(keys[i], "TotalAllocated") == 0) {
+        out->arena_reserved_bytes = strtoll(values[i], nullptr, 10);
+      } else if (strcmp(keys[i], "InUse") == 0) {
+        out->arena_in_use_bytes = strtoll(values[i], nullptr, 10);
+      }
+    }
+    g_ort->ReleaseKeyValuePairs(stats);
+  }
+  clear_last_error();
+  g_ort->ReleaseAllocator(allocator);
+#else
+  (void)model;
+  (void)out;
+#endif
+}
+
+// 以一张灰色输入运行一次会话并开启内存池收缩，Run 结束时 ORT 把空闲块
+// 归还系统。输入在此临时分配，不重新增长句柄缓冲区，也不计入统计。
+static bool shrink_model_arena(OnnxModel *model) {
+  OrtRunOptions *run_options_raw = nullptr;
+  if (!handle_status(g_ort->CreateRunOptions(&run_options_raw),
+                     "CreateRunOptions")) {
+    return false;
+  }
+  OrtRunOptionsPtr run_options(run_options_raw);
+  if (!handle_status(g_ort->AddRunConfigEntry(
+                         run_options.get(),
+                         "memory.enable_memory_arena_shrinkage",
+                         model->options.use_gpu ? "cpu:0;gpu:0" : "cpu:0"),
+                     "AddRunConfigEntry")) {
+    return false;
   }
-  // 简单的包装器，调用批量接口
-  const uint8_t *image_list[] = {image_data};
-  int widths[] = {image_width};
-  int heights[] = {image_height};
 
-  BatchDetectionResult *batch_res =
-      onnx_detect_batch(handle, image_list, 1, widths, heights, conf_threshold,
-                        nms_threshold, model_type, num_keypoints);
+  int w = model->input_width;
+  int h = model->input_height;
+  std::vector<float> input((size_t)3 * w * h, 114.0f / 255.0f);
+  int64_t input_shape[] = {1, 3, h, w};
+  OrtValue *input_tensor_raw = nullptr;
+  if (!handle_status(g_ort->CreateTensorWithDataAsOrtValue(
+                         model->memory_info, input.data(),
+                         input.size() * sizeof(float), input_shape, 4,
+                         ONNX_TENSOR_ELEMENT_DATA_TYPE_FLOAT,
+                         &input_tensor_raw),
+                     "CreateTensorWithDataAsOrtValue")) {
+    return false;
+  }
+  OrtValuePtr input_tensor(input_tensor_raw);
 
-  if (!batch_res)
-    return nullptr;
+  const char *input_names[] = {model->input_name};
+  const char *output_names[] = {model->output_name};
+  const OrtValue *input_tensor_ptr = input_tensor.get();
+  OrtValue *output_tensor_raw = nullptr;
+  if (!handle_status(g_ort->Run(model->session, run_options.get(),
+                                input_names, &input_tensor_ptr, 1,
+                                output_names, 1, &output_tensor_raw),
+                     "Run")) {
+    return false;
+  }
+  OrtValuePtr output_tensor(output_tensor_raw);
+  return true;
+}
 
-  // 提取单个结果并释放外壳
-  DetectionResult *single_res =
-      (DetectionResult *)malloc(sizeof(DetectionResult));
-  if (batch_res->results && batch_res->num_images > 0) {
-    *single_res = batch_res->results[0]; // 浅拷贝结构体（指针所有权转移）
-    // 清除原指针防止双重释放
-    batch_res->results[0].detections = nullptr;
-    batch_res->results[0].count = 0;
+FFI_PLUGIN_EXPORT int onnx_get_memory_usage(ModelHandle handle,
+                                            OnnxMemoryUsage *out) {
+  clear_last_error();
+  if (!handle || !out) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 或 out 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  OnnxModel *model = (OnnxModel *)handle;
+  out->arena_reserved_bytes = -1;
+  out->arena_in_use_bytes = -1;
+  out->plugin_reserved_bytes = (int64_t)model_buffer_bytes(model);
+  out->process_rss_bytes = onnx_process_rss_bytes();
+  out->arena_trimmed_bytes = model->arena_trimmed_bytes;
+  if (model->options.enable_cpu_arena) {
+    read_arena_usage(model, out);
   } else {
-    memset(single_res, 0, sizeof(DetectionResult));
+    // 未启用内存池：张量内存直接归还系统，不存在空闲保留。
+    out->arena_reserved_bytes = 0;
+    out->arena_in_use_bytes = 0;
   }
-
-  onnx_free_batch_result(batch_res);
-  return single_res;
+  return ONNX_OK;
 }
 
-FFI_PLUGIN_EXPORT void onnx_free_batch_result(BatchDetectionResult *result) {
-  // 释放批量结果以及内部检测与关键点缓冲区。
-  if (!result)
-    return;
-  if (result->results) {
-    for (int i = 0; i < result->num_images; i++) {
-      if (result->results[i].detections) {
-        for (int k = 0; k < result->results[i].count; k++) {
-          if (result->results[i].detections[k].keypoints) {
-            free(result->results[i].detections[k].keypoints);
-          }
-        }
-        free(result->results[i].detections);
-      }
-    }
-    free(result->results);
+FFI_PLUGIN_EXPORT int onnx_trim_memory(ModelHandle handle) {
+  clear_last_error();
+  if (!handle) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "handle 为空");
+    return ONNX_ERROR_INVALID_ARGUMENT;
   }
-  free(result);
-}
+  OnnxModel *model = (OnnxModel *)handle;
 
-// onnx_free_result 改为只释放单个结果结构体
-FFI_PLUGIN_EXPORT void onnx_free_result(DetectionResult *result) {
-  // 释放单张结果以及内部关键点缓冲区。
-  if (!result)
-    return;
-  if (result->detections) {
-    // 释放每个检测结果的关键点
-    for (int i = 0; i < result->count; i++) {
-      if (result->detections[i].keypoints) {
-        free(result->detections[i].keypoints);
-      }
-    }
-    free(result->detections);
+  // 句柄缓冲区立即释放，下次推理按需重新增长。
+  std::vector<float>().swap(model->input_buffer);
+  std::vector<LetterboxParams>().swap(model->letterbox);
+  model->scratch = DetectionScratch();
+  std::string().swap(model->raw_cache_entry);
+  std::vector<std::vector<uint32_t>>().swap(model->sweep_kept);
+  std::vector<Detection>().swap(model->sweep_selection);
+  model->last_result_count = 0;
+
+  // ORT 内存池只在 Run 结束时收缩，因此立即以空白输入运行一次。
+  model->arena_trimmed_bytes = 0;
+  if (!model->options.enable_cpu_arena && !model->options.use_gpu) {
+    return ONNX_OK;
   }
-  free(result);
+  OnnxMemoryUsage before = {-1, -1, 0, 0, -1};
+  if (model->options.enable_cpu_arena) {
+    read_arena_usage(model, &before);
+  }
+  if (!shrink_model_arena(model)) {
+    model->arena_trimmed_bytes = -1;
+    return g_last_error_code;
+  }
+  OnnxMemoryUsage after = {-1, -1, 0, 0, -1};
+  if (model->options.enable_cpu_arena) {
+    read_arena_usage(model, &after);
+  }
+  model->arena_trimmed_bytes =
+      before.arena_reserved_bytes >= 0 && after.arena_reserved_bytes >= 0
+          ? std::max<int64_t>(0, before.arena_reserved_bytes -
+                                     after.arena_reserved_bytes)
+          : -1;
+  return ONNX_OK;
 }
 
 FFI_PLUGIN_EXPORT const char *onnx_get_version(void) {
@@ -1105,3 +3209,494 @@ FFI_PLUGIN_EXPORT int onnx_get_last_error_code(void) {
   return g_last_error_code;
 }
 #endif
+
+// ============================================================================
+// 初始化与加载选项
+// ============================================================================
+
+FFI_PLUGIN_EXPORT void onnx_default_init_options(OnnxInitOptions *options) {
+  if (!options) {
+    return;
+  }
+  memset(options, 0, sizeof(*options));
+  options->use_global_thread_pools = false;
+  options->allow_spinning = true;
+  options->intra_op_threads = 0;
+  options->inter_op_threads = 0;
+  options->intra_op_affinity = nullptr;
+}
+
+FFI_PLUGIN_EXPORT void onnx_default_load_options(OnnxLoadOptions *options) {
+  if (!options) {
+    return;
+  }
+  memset(options, 0, sizeof(*options));
+  options->use_gpu = false;
+  options->enable_cpu_arena = true;
+  options->enable_mem_pattern = true;
+  options->arena_extend_strategy = ONNX_ARENA_EXTEND_NEXT_POWER_OF_TWO;
+  options->arena_initial_chunk_bytes = 0;
+}
+
+FFI_PLUGIN_EXPORT void
+onnx_default_cascade_options(OnnxCascadeOptions *options) {
+  if (!options) {
+    return;
+  }
+  memset(options, 0, sizeof(*options));
+  options->uncertain_low = 0.1f;
+  options->uncertain_high = 0.5f;
+  options->min_uncertain = 1;
+  options->escalate_empty = true;
+  options->heavy_batch_size = 0;
+}
+
+// ============================================================================
+// 结果释放
+// ============================================================================
+
+// 守护进程客户端在无 ORT 的构建中同样返回堆分配结果，释放逻辑两种构建共用。
+FFI_PLUGIN_EXPORT void onnx_free_batch_result(BatchDetectionResult *result) {
+  // 释放批量结果以及内部检测与关键点缓冲区。
+  if (!result)
+    return;
+  if (result->results) {
+    for (int i = 0; i < result->num_images; i++) {
+      onnx_release_detections(&result->results[i]);
+    }
+    free(result->results);
+  }
+  free(result);
+}
+
+// onnx_free_result 改为只释放单个结果结构体
+FFI_PLUGIN_EXPORT void onnx_free_result(DetectionResult *result) {
+  // 释放单张结果以及内部关键点缓冲区。
+  if (!result)
+    return;
+  onnx_release_detections(result);
+  free(result);
+}
+
+// ============================================================================
+// 图像暂存池
+// ============================================================================
+
+FFI_PLUGIN_EXPORT uint8_t *onnx_acquire_image_buffer(int64_t size) {
+  clear_last_error();
+  if (size <= 0) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的缓冲区大小: %lld",
+                   (long long)size);
+    return nullptr;
+  }
+  uint8_t *buffer = onnx_pool_acquire(&g_image_pool, size);
+  if (!buffer) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "图像缓冲区分配失败");
+  }
+  return buffer;
+}
+
+FFI_PLUGIN_EXPORT void onnx_release_image_buffer(uint8_t *buffer) {
+  onnx_pool_release(&g_image_pool, buffer);
+}
+
+FFI_PLUGIN_EXPORT int64_t onnx_trim_image_buffers(void) {
+  return onnx_pool_trim(&g_image_pool);
+}
+
+FFI_PLUGIN_EXPORT int64_t onnx_image_pool_cached_bytes(void) {
+  std::lock_guard<std::mutex> lock(g_image_pool.mutex);
+  return g_image_pool.cached_bytes;
+}
+
+// ============================================================================
+// 内容哈希
+// ============================================================================
+
+FFI_PLUGIN_EXPORT uint64_t onnx_hash_bytes(const uint8_t *data, int64_t size) {
+  if (!data || size <= 0) {
+    return onnx_hash64(nullptr, 0);
+  }
+  return onnx_hash64(data, (size_t)size);
+}
+
+FFI_PLUGIN_EXPORT uint64_t onnx_image_dhash(const uint8_t *rgba, int width,
+                                            int height) {
+  return onnx_dhash_rgba(rgba, width, height);
+}
+
+FFI_PLUGIN_EXPORT int onnx_hash_files(const char *const *paths, int count,
+                                      uint64_t *hashes, uint8_t *ok) {
+  clear_last_error();
+  if (count < 0 || (count > 0 && (!paths || !hashes || !ok))) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的文件列表");
+    return -1;
+  }
+  std::atomic<int> next{0};
+  std::atomic<int> succeeded{0};
+  auto worker = [&]() {
+    for (int i = next.fetch_add(1); i < count; i = next.fetch_add(1)) {
+      uint64_t hash = 0;
+      bool read = paths[i] && onnx_hash_mapped_file(paths[i], &hash);
+      hashes[i] = read ? hash : 0;
+      ok[i] = read ? 1 : 0;
+      if (read) {
+        succeeded.fetch_add(1, std::memory_order_relaxed);
+      }
+    }
+  };
+  // 哈希受限于读盘带宽，线程数不超过 8。
+  int threads = (int)std::min<unsigned>(
+      std::max(1u, std::thread::hardware_concurrency()), 8u);
+  threads = std::min(threads, count);
+  std::vector<std::thread> pool;
+  try {
+    for (int t = 1; t < threads; t++) {
+      pool.emplace_back(worker);
+    }
+  } catch (const std::system_error &) {
+    // 无法创建更多线程时由已有线程完成。
+  }
+  worker();
+  for (auto &thread : pool) {
+    thread.join();
+  }
+  return succeeded.load();
+}
+
+// ============================================================================
+// 多目标跟踪
+// ============================================================================
+
+FFI_PLUGIN_EXPORT void onnx_tracker_default_options(OnnxTrackerOptions *options) {
+  if (!options)
+    return;
+  options->keyframe_interval = 5;
+  options->min_confidence = 0.5f;
+  options->match_iou = 0.3f;
+  options->max_lost = 2;
+}
+
+FFI_PLUGIN_EXPORT TrackerHandle
+onnx_tracker_create(const OnnxTrackerOptions *options) {
+  clear_last_error();
+  OnnxTrackerOptions resolved;
+  onnx_tracker_default_options(&resolved);
+  if (options) {
+    resolved = *options;
+  }
+  if (resolved.keyframe_interval < 1 || !(resolved.min_confidence >= 0) ||
+      resolved.min_confidence > 1 || !(resolved.match_iou > 0) ||
+      resolved.match_iou > 1 || resolved.max_lost < 0) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的跟踪器选项");
+    return nullptr;
+  }
+  OnnxTracker *tracker = new (std::nothrow) OnnxTracker(resolved);
+  if (!tracker) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "跟踪器分配失败");
+  }
+  return tracker;
+}
+
+FFI_PLUGIN_EXPORT void onnx_tracker_destroy(TrackerHandle tracker) {
+  delete static_cast<OnnxTracker *>(tracker);
+}
+
+FFI_PLUGIN_EXPORT void onnx_tracker_reset(TrackerHandle tracker) {
+  if (tracker) {
+    static_cast<OnnxTracker *>(tracker)->reset();
+  }
+}
+
+FFI_PLUGIN_EXPORT int onnx_tracker_advance(TrackerHandle tracker) {
+  clear_last_error();
+  if (!tracker) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "tracker 为空");
+    return -1;
+  }
+  return static_cast<OnnxTracker *>(tracker)->advance() ? 1 : 0;
+}
+
+FFI_PLUGIN_EXPORT int onnx_tracker_update(TrackerHandle tracker,
+                                          const Detection *detections,
+                                          int count) {
+  clear_last_error();
+  if (!tracker || count < 0 || (count > 0 && !detections)) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的跟踪参数");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  try {
+    static_cast<OnnxTracker *>(tracker)->update(detections, count);
+  } catch (const std::bad_alloc &) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "跟踪器内存不足");
+    return ONNX_ERROR_ALLOCATION_FAILED;
+  }
+  return ONNX_OK;
+}
+
+FFI_PLUGIN_EXPORT DetectionResult *onnx_tracker_current(TrackerHandle tracker) {
+  clear_last_error();
+  if (!tracker) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "tracker 为空");
+    return nullptr;
+  }
+  DetectionResult *result = nullptr;
+  try {
+    const std::vector<Detection> &dets =
+        static_cast<OnnxTracker *>(tracker)->current();
+    result = (DetectionResult *)calloc(1, sizeof(DetectionResult));
+    if (result && !onnx_copy_detections(dets.data(), (int)dets.size(), result)) {
+      free(result);
+      result = nullptr;
+    }
+  } catch (const std::bad_alloc &) {
+    result = nullptr;
+  }
+  if (!result) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "跟踪结果分配失败");
+  }
+  return result;
+}
+
+FFI_PLUGIN_EXPORT int onnx_tracker_get_stats(TrackerHandle tracker,
+                                             OnnxTrackerStats *out) {
+  clear_last_error();
+  if (!tracker || !out) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的跟踪参数");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  *out = static_cast<OnnxTracker *>(tracker)->stats();
+  return ONNX_OK;
+}
+
+// ============================================================================
+// 本地推理守护进程客户端
+// ============================================================================
+
+#ifdef ONNX_DAEMON_SUPPORTED
+namespace {
+
+struct DaemonClient {
+  int fd = -1;
+  int32_t model_id = -1;
+  onnx_daemon::SharedMemory memory;
+};
+
+// 发送请求并等待应答；传输失败时标记 DAEMON_UNAVAILABLE。
+bool daemon_round_trip(DaemonClient *client, uint32_t type,
+                       const std::string &payload, std::string *reply,
+                       int *status) {
+  onnx_daemon::MessageHeader header;
+  if (!onnx_daemon::send_message(client->fd, type, ONNX_OK, payload.data(),
+                                 payload.size()) ||
+      !onnx_daemon::recv_message(client->fd, &header, reply) ||
+      header.type != onnx_daemon::kReply) {
+    set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "与守护进程的连接已断开");
+    return false;
+  }
+  *status = header.status;
+  if (*status != ONNX_OK) {
+    set_last_error(*status, "守护进程: %s", reply->c_str());
+  }
+  return true;
+}
+
+// 共享内存不足时扩容（至少翻倍）并重新发送描述符。
+bool daemon_reserve(DaemonClient *client, size_t needed) {
+  if (client->memory.size >= needed) {
+    return true;
+  }
+  size_t size = std::max(needed, client->memory.size * 2);
+  onnx_daemon::SharedMemory memory;
+  if (!onnx_daemon::create_shared_memory(size, &memory)) {
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "共享内存分配失败: %zu 字节",
+                   size);
+    return false;
+  }
+  uint64_t size64 = size;
+  if (!onnx_daemon::send_message(client->fd, onnx_daemon::kAttachMemory,
+                                 ONNX_OK, &size64, sizeof(size64),
+                                 memory.fd)) {
+    onnx_daemon::release_shared_memory(&memory);
+    set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "与守护进程的连接已断开");
+    return false;
+  }
+  onnx_daemon::release_shared_memory(&client->memory);
+  client->memory = memory;
+  return true;
+}
+
+} // namespace
+#endif
+
+FFI_PLUGIN_EXPORT const char *onnx_client_default_socket_path(void) {
+  static const std::string path = onnx_daemon::default_socket_path();
+  return path.c_str();
+}
+
+FFI_PLUGIN_EXPORT OnnxClientHandle
+onnx_client_connect(const char *socket_path) {
+  clear_last_error();
+#ifdef ONNX_DAEMON_SUPPORTED
+  std::string path =
+      socket_path ? socket_path : onnx_daemon::default_socket_path();
+  int fd = onnx_daemon::connect_socket(path);
+  if (fd < 0) {
+    set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "无法连接守护进程: %s",
+                   path.c_str());
+    return nullptr;
+  }
+  DaemonClient *client = new (std::nothrow) DaemonClient();
+  if (!client) {
+    close(fd);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "客户端分配失败");
+    return nullptr;
+  }
+  client->fd = fd;
+  return client;
+#else
+  (void)socket_path;
+  set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "当前平台不支持推理守护进程");
+  return nullptr;
+#endif
+}
+
+FFI_PLUGIN_EXPORT int onnx_client_load_model(OnnxClientHandle handle,
+                                             const char *model_path,
+                                             bool use_gpu) {
+  clear_last_error();
+#ifdef ONNX_DAEMON_SUPPORTED
+  DaemonClient *client = static_cast<DaemonClient *>(handle);
+  if (!client || !model_path || !model_path[0]) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的客户端或模型路径");
+    return ONNX_ERROR_INVALID_ARGUMENT;
+  }
+  std::string payload(1, use_gpu ? 1 : 0);
+  payload += model_path;
+  std::string reply;
+  int status = ONNX_OK;
+  if (!daemon_round_trip(client, onnx_daemon::kLoadModel, payload, &reply,
+                         &status)) {
+    return ONNX_ERROR_DAEMON_UNAVAILABLE;
+  }
+  if (status != ONNX_OK) {
+    return status;
+  }
+  if (reply.size() != sizeof(int32_t)) {
+    set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "守护进程应答格式错误");
+    return ONNX_ERROR_DAEMON_UNAVAILABLE;
+  }
+  memcpy(&client->model_id, reply.data(), sizeof(int32_t));
+  return ONNX_OK;
+#else
+  (void)handle;
+  (void)model_path;
+  (void)use_gpu;
+  set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "当前平台不支持推理守护进程");
+  return ONNX_ERROR_DAEMON_UNAVAILABLE;
+#endif
+}
+
+FFI_PLUGIN_EXPORT BatchDetectionResult *onnx_client_detect_batch(
+    OnnxClientHandle handle, const uint8_t **image_data_list, int num_images,
+    int *image_widths, int *image_heights, float conf_threshold,
+    float nms_threshold, int model_type, int num_keypoints) {
+  clear_last_error();
+#ifdef ONNX_DAEMON_SUPPORTED
+  DaemonClient *client = static_cast<DaemonClient *>(handle);
+  if (!client || !image_data_list || !image_widths || !image_heights ||
+      num_images <= 0 || num_images > onnx_daemon::kMaxImages) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "无效的批量推理参数");
+    return nullptr;
+  }
+  if (client->model_id < 0) {
+    set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "尚未加载模型");
+    return nullptr;
+  }
+
+  // 按对齐边界依次排布图片。
+  std::vector<onnx_daemon::ImageRef> refs((size_t)num_images);
+  size_t needed = 0;
+  for (int i = 0; i < num_images; i++) {
+    if (!image_data_list[i] || image_widths[i] <= 0 || image_heights[i] <= 0) {
+      set_last_error(ONNX_ERROR_INVALID_ARGUMENT, "第 %d 张图片无效", i);
+      return nullptr;
+    }
+    refs[i].width = image_widths[i];
+    refs[i].height = image_heights[i];
+    refs[i].offset = needed;
+    size_t bytes = (size_t)image_widths[i] * (size_t)image_heights[i] * 4;
+    needed += (bytes + onnx_daemon::kImageAlignment - 1) /
+              onnx_daemon::kImageAlignment * onnx_daemon::kImageAlignment;
+  }
+  if (!daemon_reserve(client, needed)) {
+    return nullptr;
+  }
+  for (int i = 0; i < num_images; i++) {
+    memcpy(client->memory.data + refs[i].offset, image_data_list[i],
+           (size_t)refs[i].width * (size_t)refs[i].height * 4);
+  }
+
+  onnx_daemon::DetectRequest request{client->model_id, conf_threshold,
+                                     nms_threshold,    model_type,
+                                     num_keypoints,    num_images};
+  std::string payload((const char *)&request, sizeof(request));
+  payload.append((const char *)refs.data(),
+                 refs.size() * sizeof(onnx_daemon::ImageRef));
+  std::string reply;
+  int status = ONNX_OK;
+  if (!daemon_round_trip(client, onnx_daemon::kDetect, payload, &reply,
+                         &status) ||
+      status != ONNX_OK) {
+    return nullptr;
+  }
+
+  BatchDetectionResult *result =
+      (BatchDetectionResult *)calloc(1, sizeof(BatchDetectionResult));
+  if (result) {
+    result->results =
+        (DetectionResult *)calloc((size_t)num_images, sizeof(DetectionResult));
+  }
+  if (!result || !result->results) {
+    free(result);
+    set_last_error(ONNX_ERROR_ALLOCATION_FAILED, "批量结果分配失败");
+    return nullptr;
+  }
+  result->num_images = num_images;
+  size_t pos = 0;
+  for (int i = 0; i < num_images; i++) {
+    if (!onnx_daemon::decode_detections(reply, &pos, &result->results[i])) {
+      onnx_free_batch_result(result);
+      set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "守护进程应答格式错误");
+      return nullptr;
+    }
+  }
+  return result;
+#else
+  (void)handle;
+  (void)image_data_list;
+  (void)num_images;
+  (void)image_widths;
+  (void)image_heights;
+  (void)conf_threshold;
+  (void)nms_threshold;
+  (void)model_type;
+  (void)num_keypoints;
+  set_last_error(ONNX_ERROR_DAEMON_UNAVAILABLE, "当前平台不支持推理守护进程");
+  return nullptr;
+#endif
+}
+
+FFI_PLUGIN_EXPORT void onnx_client_disconnect(OnnxClientHandle handle) {
+#ifdef ONNX_DAEMON_SUPPORTED
+  DaemonClient *client = static_cast<DaemonClient *>(handle);
+  if (!client) {
+    return;
+  }
+  close(client->fd);
+  onnx_daemon::release_shared_memory(&client->memory);
+  delete client;
+#else
+  (void)handle;
+#endif
+}
@@ -32,21 +32,29 @@ typedef enum {
   ONNX_ERROR_INVALID_ARGUMENT = 3,
   ONNX_ERROR_ALLOCATION_FAILED = 4,
   ONNX_ERROR_RUNTIME_FAILURE = 5,
-  ONNX_ERROR_RUNTIME_NOT_FOUND = 6
+  ONNX_ERROR_RUNTIME_NOT_FOUND = 6,
+  ONNX_ERROR_BUFFER_TOO_SMALL = 7,
+  ONNX_ERROR_NO_RESULT = 8,
+  ONNX_ERROR_DAEMON_UNAVAILABLE = 9
 } OnnxErrorCode;
 
 /// 检测结果结构体
 ///
 /// 坐标为归一化中心点 (x, y) 与宽高 (width, height)。
+/// OBB 模型的 width/height 为旋转框边长（分别按图像宽高归一化），angle 为
+/// 原图像素空间下的旋转角，polygon 给出 4 个角点。
 typedef struct {
-  int class_id;      // 类别 ID
-  float confidence;  // 置信度
-  float x;           // 中心 x 坐标（归一化 0-1）
-  float y;           // 中心 y 坐标（归一化 0-1）
-  float width;       // 宽度（归一化 0-1）
-  float height;      // 高度（归一化 0-1）
-  float *keypoints;  // 关键点数组 (x, y, visibility) * num_keypoints
-  int num_keypoints; // 关键点数量（非姿态模型为 0）
+  int class_id;           // 类别 ID
+  float confidence;       // 置信度
+  float x;                // 中心 x 坐标（归一化 0-1）
+  float y;                // 中心 y 坐标（归一化 0-1）
+  float width;            // 宽度（归一化 0-1）
+  float height;           // 高度（归一化 0-1）
+  float *keypoints;       // 关键点数组 (x, y, visibility) * num_keypoints
+  int num_keypoints;      // 关键点数量（非姿态模型为 0）
+  float *polygon;         // 实例轮廓多边形 (x, y) * num_polygon_points
+  int num_polygon_points; // 多边形顶点数（非分割/OBB 模型为 0）
+  float angle;            // 旋转角（弧度，顺时针；非 OBB 模型为 0）
 } Detection;
 
 /// 检测结果数组
@@ -56,10 +64,29 @@ typedef struct {
   int capacity;
 } DetectionResult;
 
+/// 调用方持有的可复用结果缓冲区
+///
+/// detections 与 arena 由调用方分配并在多次调用间复用；关键点、多边形等变长数据写入
+/// arena，检测框中的指针引用 arena 内部，无需单独释放。
+/// 容量不足时推理接口返回 ONNX_ERROR_BUFFER_TOO_SMALL，并在 required_* 中
+/// 给出所需容量。
+typedef struct {
+  Detection *detections;   // 检测数组（调用方分配，长度为 capacity）
+  int capacity;            // 检测数组容量
+  int count;               // 输出：写入的检测数量
+  uint8_t *arena;          // 变长数据区（调用方分配，arena_capacity 字节）
+  int64_t arena_capacity;  // 变长数据区容量（字节）
+  int64_t arena_used;      // 输出：已使用字节数
+  int required_capacity;   // 输出：所需检测数组容量
+  int64_t required_arena;  // 输出：所需变长数据区字节数
+} OnnxResultBuffer;
+
 /// 模型类型枚举
 typedef enum {
-  MODEL_TYPE_YOLO = 0,     // 标准 YOLO 检测
-  MODEL_TYPE_YOLO_POSE = 1 // YOLO-Pose（关键点检测）
+  MODEL_TYPE_YOLO = 0,      // 标准 YOLO 检测
+  MODEL_TYPE_YOLO_POSE = 1, // YOLO-Pose（关键点检测）
+  MODEL_TYPE_YOLO_SEG = 2,  // YOLO-Seg（实例分割，输出轮廓多边形）
+  MODEL_TYPE_YOLO_OBB = 3   // YOLO-OBB（旋转框，输出角度与角点）
 } ModelType;
 
 /// 模型句柄（不透明指针）
@@ -73,9 +100,50 @@ typedef void *ModelHandle;
 /// 初始化 ONNX Runtime
 FFI_PLUGIN_EXPORT bool onnx_init(void);
 
-/// 清理 ONNX Runtime
+/// 运行时初始化选项
+/// 先用 onnx_default_init_options 填充默认值，再按需修改。
+typedef struct {
+  // 所有模型共享一组 ORT 线程池，总线程数不随加载的模型数增长；
+  // 关闭时每个会话各自创建 4 个算子内线程。
+  bool use_global_thread_pools;
+  bool allow_spinning;  // 共享线程空闲时自旋等待（降低延迟，但占用 CPU）
+  int intra_op_threads; // 共享算子内线程数（含调用线程），0 为物理核数
+  int inter_op_threads; // 共享算子间线程数，0 为 ORT 默认
+  // 算子内线程的 CPU 亲和性，按线程以 ';' 分隔、逻辑处理器从 1 起编号，
+  // 如 "1,2;3,4;5,6"（共 intra_op_threads - 1 组）；NULL 或空串为不绑定。
+  const char *intra_op_affinity;
+} OnnxInitOptions;
+
+/// 填充默认初始化选项（与 onnx_init 行为一致）
+FFI_PLUGIN_EXPORT void onnx_default_init_options(OnnxInitOptions *options);
+
+/// 按选项初始化 ONNX Runtime
+///
+/// 需在加载模型之前调用（onnx_load_model 会以默认选项隐式初始化）。
+/// 已初始化时，线程池模式一致则直接返回成功，否则返回失败，
+/// 需先卸载全部模型并 onnx_cleanup。
+/// @param options 为 NULL 时使用默认选项（已初始化时沿用现有环境）
+FFI_PLUGIN_EXPORT bool onnx_init_with_options(const OnnxInitOptions *options);
+
+/// 清理 ONNX Runtime（同时释放图像暂存池中的缓存缓冲区）
+///
+/// 先等待进行中的后台加载线程（含已放弃的加载）结束，再释放运行时环境。
 FFI_PLUGIN_EXPORT void onnx_cleanup(void);
 
+/// 设置 ONNX Runtime 库的搜索路径（动态加载构建）
+///
+/// 插件在首次初始化时打开运行时库，依次搜索：本函数设置的路径、环境变量
+/// ONNX_INFERENCE_ORT_PATH、插件库所在目录、构建时找到的库目录、系统加载器。
+/// 每项可以是目录或库文件，多项以 ';'（Windows）或 ':' 分隔，
+/// 可借此在 CPU 与 GPU 版运行时包之间选择。onnx_cleanup 不卸载已打开的库。
+/// @param paths 为 NULL 或空串时恢复默认搜索顺序
+/// @return 运行时库已加载或链接时绑定返回 false（INVALID_ARGUMENT），
+///         无运行时构建返回 false（RUNTIME_NOT_FOUND）
+FFI_PLUGIN_EXPORT bool onnx_set_runtime_search_paths(const char *paths);
+
+/// 实际加载的 ONNX Runtime 库路径（未加载或链接时绑定返回空串）
+FFI_PLUGIN_EXPORT const char *onnx_get_runtime_path(void);
+
 // ============================================================================
 // 模型操作
 // ============================================================================
@@ -87,10 +155,69 @@ FFI_PLUGIN_EXPORT void onnx_cleanup(void);
 FFI_PLUGIN_EXPORT ModelHandle onnx_load_model(const char *model_path,
                                               bool use_gpu);
 
+/// ORT 内存池扩展策略
+typedef enum {
+  ONNX_ARENA_EXTEND_NEXT_POWER_OF_TWO = 0, // 按 2 的幂扩展（ORT 默认）
+  ONNX_ARENA_EXTEND_SAME_AS_REQUESTED = 1  // 按请求大小扩展，占用贴近实际
+} OnnxArenaExtendStrategy;
+
+/// 模型加载选项
+/// 先用 onnx_default_load_options 填充默认值，再按需修改。
+typedef struct {
+  bool use_gpu;
+  bool enable_cpu_arena;   // CPU 内存池；关闭后张量内存用完即归还系统
+  bool enable_mem_pattern; // 按首次运行的形状预规划内存（批量大小多变时可关闭）
+  int arena_extend_strategy;         // OnnxArenaExtendStrategy
+  int64_t arena_initial_chunk_bytes; // 内存池首块大小，0 为 ORT 默认
+} OnnxLoadOptions;
+
+/// 填充默认加载选项（与 onnx_load_model 行为一致）
+FFI_PLUGIN_EXPORT void onnx_default_load_options(OnnxLoadOptions *options);
+
+/// 按选项加载 ONNX 模型
+///
+/// CPU 内存池的扩展策略与首块大小通过进程级共享分配器生效：首个设置了
+/// 非默认值的模型注册分配器，之后设置非默认值的模型共用同一配置。
+/// GPU 内存池的扩展策略按模型生效。
+/// @param options 为 NULL 时使用默认选项
+/// @return 成功返回模型句柄，失败返回 NULL
+FFI_PLUGIN_EXPORT ModelHandle
+onnx_load_model_with_options(const char *model_path,
+                             const OnnxLoadOptions *options);
+
 /// 卸载模型
-/// 允许传入 NULL（无操作）。
+/// 允许传入 NULL（无操作）。仍有未销毁的流式会话时延后释放：句柄对调用方
+/// 立即失效，最后一个会话销毁时释放会话与缓冲区。
 FFI_PLUGIN_EXPORT void onnx_unload_model(ModelHandle handle);
 
+/// 后台加载句柄（不透明指针）
+typedef void *ModelLoadHandle;
+
+/// 在后台线程加载模型
+/// 按 onnx_load_model_with_options 创建会话后以一张灰色图片预热一次推理
+/// （预热不计入统计），调用线程不阻塞。用于热切换：旧句柄在加载期间继续
+/// 推理，完成后调用方以新句柄替换旧句柄再卸载旧句柄，旧句柄上未关闭的
+/// 流式会话照常完成。
+/// @param options 为 NULL 时使用默认选项
+/// @return 加载句柄，须以 onnx_load_model_finish 或 onnx_load_model_cancel
+///         释放；参数无效或无法启动线程时返回 NULL
+FFI_PLUGIN_EXPORT ModelLoadHandle
+onnx_load_model_async(const char *model_path, const OnnxLoadOptions *options);
+
+/// 查询后台加载是否已结束（成功或失败），不阻塞
+/// @return 1 已结束，0 仍在加载，load 为 NULL 时返回 -1
+FFI_PLUGIN_EXPORT int onnx_load_model_done(ModelLoadHandle load);
+
+/// 等待后台加载结束，取出模型句柄并释放 load
+/// @return 成功返回模型句柄；失败返回 NULL，后台线程的错误信息与错误码
+///         转存到调用线程
+FFI_PLUGIN_EXPORT ModelHandle onnx_load_model_finish(ModelLoadHandle load);
+
+/// 放弃后台加载并释放 load（允许 NULL），不阻塞
+/// 已结束时立即卸载模型；仍在加载时由后台线程结束后自行卸载，
+/// onnx_cleanup 会等待这些线程。
+FFI_PLUGIN_EXPORT void onnx_load_model_cancel(ModelLoadHandle load);
+
 /// 获取模型输入尺寸
 /// @param handle 模型句柄
 /// @param width 输出参数：宽度
@@ -118,6 +245,25 @@ onnx_detect(ModelHandle handle, const uint8_t *image_data, int image_width,
             int image_height, float conf_threshold, float nms_threshold,
             int model_type, int num_keypoints);
 
+/// 运行推理并写入调用方提供的缓冲区（稳态下无堆分配）
+/// 参数含义同 onnx_detect。
+/// @param out 调用方持有的结果缓冲区
+/// @return ONNX_OK；容量不足时返回 ONNX_ERROR_BUFFER_TOO_SMALL，
+///         扩容后可通过 onnx_copy_last_result 取回结果而无需重新推理
+FFI_PLUGIN_EXPORT int onnx_detect_into(ModelHandle handle,
+                                       const uint8_t *image_data,
+                                       int image_width, int image_height,
+                                       float conf_threshold,
+                                       float nms_threshold, int model_type,
+                                       int num_keypoints,
+                                       OnnxResultBuffer *out);
+
+/// 将句柄上最近一次推理（最后一张图片）的结果复制到缓冲区
+/// 结果在同一句柄的下一次推理前有效。
+/// @return ONNX_OK 或 ONNX_ERROR_BUFFER_TOO_SMALL
+FFI_PLUGIN_EXPORT int onnx_copy_last_result(ModelHandle handle,
+                                            OnnxResultBuffer *out);
+
 /// 释放检测结果
 /// 释放 DetectionResult 及其内部关键点缓冲区。
 FFI_PLUGIN_EXPORT void onnx_free_result(DetectionResult *result);
@@ -183,6 +329,390 @@ onnx_detect_batch(ModelHandle handle, const uint8_t **image_data_list,
 /// 释放 BatchDetectionResult 及其内部检测缓冲区。
 FFI_PLUGIN_EXPORT void onnx_free_batch_result(BatchDetectionResult *result);
 
+// ============================================================================
+// 流式批量推理
+// ============================================================================
+
+/// 流式批量会话句柄（不透明指针）
+/// 与所属 ModelHandle 共用线程约束；模型卸载后会话仍可使用至销毁。
+typedef void *BatchStreamHandle;
+
+/// 创建流式批量会话
+/// 微批次大小由内存预算推导：每张图片按输入张量、输出张量与激活估算计费。
+/// @param handle 模型句柄
+/// @param conf_threshold 置信度阈值 (0.0-1.0)
+/// @param nms_threshold NMS IoU 阈值 (0.0-1.0)
+/// @param model_type 模型类型
+/// @param num_keypoints 姿态模型关键点数量
+/// @param memory_budget_bytes 内存预算（字节），<= 0 使用默认值 256 MiB
+/// @return 会话句柄，失败返回 NULL
+FFI_PLUGIN_EXPORT BatchStreamHandle
+onnx_stream_create(ModelHandle handle, float conf_threshold,
+                   float nms_threshold, int model_type, int num_keypoints,
+                   int64_t memory_budget_bytes);
+
+/// 推入一张图片
+/// 图片在调用内立即完成 letterbox，返回后 image_data 即可释放或复用；
+/// 攒满一个微批次时同步执行推理，结果进入待取队列。
+/// @param tag 调用方标识（如图片索引），随结果返回
+/// @return ONNX_OK 或错误码
+FFI_PLUGIN_EXPORT int onnx_stream_push(BatchStreamHandle stream,
+                                       const uint8_t *image_data,
+                                       int image_width, int image_height,
+                                       int64_t tag);
+
+/// 对未满的微批次立即执行推理
+FFI_PLUGIN_EXPORT int onnx_stream_flush(BatchStreamHandle stream);
+
+/// 获取待取结果数量
+FFI_PLUGIN_EXPORT int onnx_stream_pending(BatchStreamHandle stream);
+
+/// 获取微批次大小（由内存预算推导）
+FFI_PLUGIN_EXPORT int onnx_stream_batch_size(BatchStreamHandle stream);
+
+/// 按推入顺序取出下一条结果并写入调用方缓冲区
+/// @param tag 输出：结果对应的调用方标识
+/// @return ONNX_OK；队列为空返回 ONNX_ERROR_NO_RESULT；
+///         容量不足返回 ONNX_ERROR_BUFFER_TOO_SMALL（结果保留在队首）
+FFI_PLUGIN_EXPORT int onnx_stream_next(BatchStreamHandle stream, int64_t *tag,
+                                       OnnxResultBuffer *out);
+
+/// 销毁流式批量会话（未推理的图片与未取结果将被丢弃）
+/// 允许传入 NULL（无操作）。
+FFI_PLUGIN_EXPORT void onnx_stream_destroy(BatchStreamHandle stream);
+
+// ============================================================================
+// 原始输出缓存
+// ============================================================================
+
+/// 计算 64 位内容哈希（XXH64），用作图片的缓存键
+/// 通常对编码后的图片文件字节计算，命中缓存时无需解码。
+FFI_PLUGIN_EXPORT uint64_t onnx_hash_bytes(const uint8_t *data, int64_t size);
+
+/// 并行计算多个文件的内容哈希
+/// 结果与对整个文件内容调用 onnx_hash_bytes 一致；文件以内存映射读取，
+/// 按文件分配到多个线程。与 ONNX Runtime 无关，存根构建下同样可用。
+/// @param paths 文件路径（UTF-8）
+/// @param hashes 输出：各文件的哈希（失败项为 0）
+/// @param ok 输出：各文件是否读取成功（1/0）
+/// @return 成功的文件数；参数无效时返回 -1
+FFI_PLUGIN_EXPORT int onnx_hash_files(const char *const *paths, int count,
+                                      uint64_t *hashes, uint8_t *ok);
+
+/// 为模型启用原始输出缓存
+/// 缓存 NMS 前的候选框，键为模型文件哈希 + 模型输入尺寸 + 图片缓存键；
+/// 仅阈值变化的重复推理可经 onnx_detect_cached 直接重做后处理。
+/// 分割模型不缓存（掩码依赖原型输出）。
+/// @param cache_dir 缓存目录（不存在时自动创建），NULL 或空串表示关闭
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_enable_raw_cache(ModelHandle handle,
+                                            const char *cache_dir);
+
+/// 从原始输出缓存取结果：按阈值过滤后执行 NMS，不运行模型
+/// 参数与 onnx_detect 相同，图片以缓存键代替。
+/// @return 堆分配的 DetectionResult，需使用 onnx_free_result 释放；
+///         未命中（或未启用缓存）返回 NULL（ONNX_ERROR_NO_RESULT）
+FFI_PLUGIN_EXPORT DetectionResult *
+onnx_detect_cached(ModelHandle handle, uint64_t image_key,
+                   float conf_threshold, float nms_threshold, int model_type,
+                   int num_keypoints);
+
+/// 批量推理并写入原始输出缓存
+/// 参数与 onnx_detect_batch 相同，image_keys[i] 为第 i 张图片的缓存键。
+/// 未启用缓存时等同 onnx_detect_batch。
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_batch_keyed(ModelHandle handle, const uint8_t **image_data_list,
+                        const uint64_t *image_keys, int num_images,
+                        int *image_widths, int *image_heights,
+                        float conf_threshold, float nms_threshold,
+                        int model_type, int num_keypoints);
+
+// ============================================================================
+// 多阈值扫描
+// ============================================================================
+
+/// 单次推理的多阈值扫描
+/// 只运行一次模型，返回 conf_thresholds × nms_thresholds 每种组合的结果，
+/// 与以对应阈值调用 onnx_detect 一致（置信度相同的候选框顺序可能不同）。
+/// 候选框按最低置信度阈值解析并只排序一次，各 NMS 阈值同时抑制，每对框的
+/// IoU 至多计算一次；各置信度阈值的结果为对应保留序列的前缀。
+/// @param conf_thresholds 置信度阈值数组（num_conf 个，至少 1 个）
+/// @param nms_thresholds NMS 阈值数组（num_nms 个，1 到 32 个）
+/// @return 堆分配的 BatchDetectionResult（num_images 为组合数），
+///         第 ci * num_nms + ni 项对应 conf_thresholds[ci] 与 nms_thresholds[ni]，
+///         需使用 onnx_free_batch_result 释放；失败返回 NULL
+FFI_PLUGIN_EXPORT BatchDetectionResult *
+onnx_detect_sweep(ModelHandle handle, const uint8_t *image_data,
+                  int image_width, int image_height,
+                  const float *conf_thresholds, int num_conf,
+                  const float *nms_thresholds, int num_nms, int model_type,
+                  int num_keypoints);
+
+// ============================================================================
+// 近重复跳过
+// ============================================================================
+
+/// 计算 RGBA 图片的 64 位差值感知哈希（dHash）
+/// 缩小为 9x8 灰度图后比较左右相邻格的亮度，每格至多采样 4 行。
+/// 与 ONNX Runtime 无关，存根构建下同样可用。
+/// @return 哈希值；参数无效时返回 0
+FFI_PLUGIN_EXPORT uint64_t onnx_image_dhash(const uint8_t *rgba, int width,
+                                            int height);
+
+/// 设置批量推理的近重复跳过
+/// 开启后 onnx_detect_batch / onnx_detect_batch_keyed 为每张图片计算 dHash，
+/// 与最近一张实际推理的图片（可来自上一次调用）尺寸相同且汉明距离不超过
+/// max_distance 时直接复用其检测结果，不运行模型；跳过的图片数计入
+/// OnnxStats.dedup_skipped。阈值、模型类型或关键点数变化时不跨调用复用。
+/// 流式会话不参与近重复跳过。
+/// @param max_distance 0-64，负数关闭（默认关闭）
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_set_dedup(ModelHandle handle, int max_distance);
+
+// ============================================================================
+// 两级级联
+// ============================================================================
+
+/// 级联升级规则
+typedef struct {
+  float uncertain_low;  // 不确定区间下限（快速模型以此为置信度阈值运行）
+  float uncertain_high; // 不确定区间上限（不含）
+  int min_uncertain;    // 不确定检测数达到该值时升级
+  bool escalate_empty;  // 快速模型无任何检测时升级
+  int heavy_batch_size; // 升级图片每批送入重模型的数量，0 为一批全部
+} OnnxCascadeOptions;
+
+/// 填充默认级联规则（不确定区间 [0.1, 0.5)，1 个不确定检测或无检测即升级）
+FFI_PLUGIN_EXPORT void
+onnx_default_cascade_options(OnnxCascadeOptions *options);
+
+/// 两级级联批量推理
+/// 快速模型以 min(conf_threshold, uncertain_low) 对全部图片推理，不确定检测
+/// 数达到 min_uncertain 或（escalate_empty 时）无检测的图片升级：按
+/// heavy_batch_size 分批由重模型以 conf_threshold 重新推理并替换结果；其余
+/// 图片保留快速模型中置信度不低于 conf_threshold 的检测。两个模型须输出相同
+/// 的类别，模型类型与关键点数共用。图片数与升级数计入快速模型的
+/// OnnxStats.cascade_images / cascade_escalated。
+/// @param fast 快速模型句柄（如 yolov8n）
+/// @param heavy 重模型句柄（如 yolov8x）
+/// @param options 升级规则，NULL 表示默认
+/// @return 堆分配的 BatchDetectionResult，需使用 onnx_free_batch_result 释放；
+///         任一模型推理失败时返回 NULL
+FFI_PLUGIN_EXPORT BatchDetectionResult *onnx_detect_batch_cascade(
+    ModelHandle fast, ModelHandle heavy, const uint8_t **image_data_list,
+    int num_images, int *image_widths, int *image_heights,
+    float conf_threshold, float nms_threshold, int model_type,
+    int num_keypoints, const OnnxCascadeOptions *options);
+
+// ============================================================================
+// 多目标跟踪
+// ============================================================================
+
+/// 跟踪器句柄
+typedef void *TrackerHandle;
+
+/// 跟踪器选项
+typedef struct {
+  int keyframe_interval; // 每隔多少帧运行一次检测器（1 为每帧）
+  float min_confidence;  // 活动轨迹外推置信度低于该值时提前运行检测器
+  float match_iou;       // 轨迹与检测关联所需的最小 IoU
+  int max_lost;          // 轨迹连续未匹配多少个关键帧后删除
+} OnnxTrackerOptions;
+
+/// 跟踪统计（reset 不清零）
+typedef struct {
+  int64_t frames;         // advance 调用次数
+  int64_t detector_calls; // 需要运行检测器的帧数
+  int64_t forced_calls;   // 其中因新轨迹确认或置信度下降而提前运行的帧数
+  int64_t tracks_created; // 累计创建的轨迹数
+  int active_tracks;      // 当前输出的轨迹数
+} OnnxTrackerStats;
+
+/// 填充默认跟踪器选项（每 5 帧检测一次，置信度下限 0.5，IoU 0.3，
+/// 丢失 2 个关键帧后删除）
+FFI_PLUGIN_EXPORT void onnx_tracker_default_options(OnnxTrackerOptions *options);
+
+/// 创建跟踪器
+/// 用于视频等连续帧：每帧先调用 onnx_tracker_advance，返回 1 时运行检测器并
+/// 以结果调用 onnx_tracker_update，随后 onnx_tracker_current 取本帧结果；
+/// 返回 0 时直接取外推结果。与 ONNX Runtime 无关，存根构建下同样可用。
+/// 句柄非线程安全。
+/// @param options 选项，NULL 表示默认
+/// @return 跟踪器句柄，选项无效时返回 NULL
+FFI_PLUGIN_EXPORT TrackerHandle
+onnx_tracker_create(const OnnxTrackerOptions *options);
+
+/// 销毁跟踪器（允许传入 NULL）
+FFI_PLUGIN_EXPORT void onnx_tracker_destroy(TrackerHandle tracker);
+
+/// 开始新序列：清空轨迹，下一帧必须运行检测器
+FFI_PLUGIN_EXPORT void onnx_tracker_reset(TrackerHandle tracker);
+
+/// 进入下一帧并外推轨迹
+/// @return 1 表示本帧需要运行检测器，0 表示可直接外推；参数无效时返回 -1
+FFI_PLUGIN_EXPORT int onnx_tracker_advance(TrackerHandle tracker);
+
+/// 以本帧检测结果更新轨迹（同类别按 IoU 贪心关联，未匹配的检测新建轨迹）
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_tracker_update(TrackerHandle tracker,
+                                          const Detection *detections,
+                                          int count);
+
+/// 获取本帧结果：运行过检测器的帧为检测结果，其余帧为外推框
+/// （关键点与多边形随框平移缩放，置信度乘以轨迹置信度）
+/// @return 堆分配的 DetectionResult，需使用 onnx_free_result 释放；
+///         失败返回 NULL
+FFI_PLUGIN_EXPORT DetectionResult *onnx_tracker_current(TrackerHandle tracker);
+
+/// 获取跟踪统计；检测器调用比例为 detector_calls / frames
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_tracker_get_stats(TrackerHandle tracker,
+                                             OnnxTrackerStats *out);
+
+// ============================================================================
+// 图像暂存池
+// ============================================================================
+
+/// 从暂存池获取至少 size 字节的图像缓冲区（16 字节对齐）
+/// 调用方可直接写入 RGBA 数据并传给 onnx_detect* 系列函数，无需额外拷贝。
+/// 缓冲区按 2 的幂尺寸等级复用（64 KiB 起）。
+/// @return 缓冲区指针，失败返回 NULL
+FFI_PLUGIN_EXPORT uint8_t *onnx_acquire_image_buffer(int64_t size);
+
+/// 归还图像缓冲区到暂存池（允许传入 NULL）
+FFI_PLUGIN_EXPORT void onnx_release_image_buffer(uint8_t *buffer);
+
+/// 回收超出在用高水位的缓存缓冲区并重置高水位
+/// @return 释放的字节数
+FFI_PLUGIN_EXPORT int64_t onnx_trim_image_buffers(void);
+
+/// 获取暂存池当前缓存（未在用）的字节数
+FFI_PLUGIN_EXPORT int64_t onnx_image_pool_cached_bytes(void);
+
+// ============================================================================
+// 性能统计
+// ============================================================================
+
+/// 推理阶段
+typedef enum {
+  ONNX_STAGE_PREPROCESS = 0, // letterbox 预处理
+  ONNX_STAGE_RUN = 1,        // ONNX Runtime 推理
+  ONNX_STAGE_PARSE = 2,      // 输出解析（候选框展开）
+  ONNX_STAGE_NMS = 3,        // 非极大值抑制
+  ONNX_STAGE_MASKS = 4,      // 分割掩码组装
+  ONNX_STAGE_MARSHAL = 5,    // 结果拷贝/打包
+  ONNX_STAGE_TOTAL = 6,      // 以上各阶段之和
+  ONNX_STAGE_COUNT = 7
+} OnnxStage;
+
+/// 模型句柄的性能统计
+///
+/// 耗时单位为毫秒（单调时钟）。一次调用指一次 onnx_detect* 或一个流式微批次；
+/// 分位数取自累计的对数直方图（相对误差约 19%），未执行的阶段不计入。
+typedef struct {
+  double last_ms[ONNX_STAGE_COUNT]; // 最近一次调用各阶段耗时
+  double p50_ms[ONNX_STAGE_COUNT];
+  double p95_ms[ONNX_STAGE_COUNT];
+  double p99_ms[ONNX_STAGE_COUNT];
+  int64_t calls;           // 调用次数
+  int64_t images;          // 图片数
+  int64_t candidates;      // NMS 前候选框数
+  int64_t detections;      // 输出检测框数
+  int64_t bytes_allocated; // 句柄缓冲区增长与返回结果的堆分配字节数
+  int64_t dedup_skipped;   // 近重复复用结果而跳过推理的图片数
+  int64_t cascade_images;    // 以该句柄为快速模型的级联推理图片数
+  int64_t cascade_escalated; // 其中升级到重模型的图片数
+} OnnxStats;
+
+/// 获取模型句柄的性能统计
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_get_stats(ModelHandle handle, OnnxStats *out);
+
+/// 清零模型句柄的性能统计（允许传入 NULL）
+FFI_PLUGIN_EXPORT void onnx_reset_stats(ModelHandle handle);
+
+// ============================================================================
+// 性能分析
+// ============================================================================
+
+/// 开启性能分析
+///
+/// 以 ONNX Runtime 性能分析选项重建会话；此后的推理同时记录 ORT 算子耗时
+/// 与插件自身各阶段（预处理、解析、NMS 等）的片段。
+/// @param trace_path 输出的 Chrome trace JSON 路径（onnx_stop_profiling 时写入）
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_start_profiling(ModelHandle handle,
+                                           const char *trace_path);
+
+/// 结束性能分析，将 ORT 与插件片段合并写入 trace_path
+///
+/// 卸载仍在分析中的模型时会自动调用。
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_stop_profiling(ModelHandle handle);
+
+// ============================================================================
+// 内存
+// ============================================================================
+
+/// 内存占用（字节，-1 表示当前运行时不支持查询）
+typedef struct {
+  int64_t arena_reserved_bytes;  // ORT CPU 内存池向系统申请的字节数
+  int64_t arena_in_use_bytes;    // 其中在用的字节数
+  int64_t plugin_reserved_bytes; // 句柄输入张量与后处理暂存区容量
+  int64_t process_rss_bytes;     // 进程常驻内存
+  int64_t arena_trimmed_bytes;   // 最近一次 onnx_trim_memory 归还的内存池字节数
+} OnnxMemoryUsage;
+
+/// 获取模型句柄的内存占用
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_get_memory_usage(ModelHandle handle,
+                                            OnnxMemoryUsage *out);
+
+/// 回收空闲内存（适合在批量任务结束后调用）
+///
+/// 立即释放句柄的输入张量与后处理暂存区。ORT 内存池只能在推理结束时收缩，
+/// 因此以一张空白输入运行一次会话，结束时把空闲块归还系统；归还量见
+/// onnx_get_memory_usage 的 arena_trimmed_bytes。关闭内存池的模型无需收缩。
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_trim_memory(ModelHandle handle);
+
+// ============================================================================
+// 本地推理守护进程客户端
+// ============================================================================
+
+/// 守护进程连接句柄（不透明指针），不可跨线程并发使用
+///
+/// 守护进程（label_load_daemon）持有已加载的模型，并将多个客户端的并发请求
+/// 合并为微批次。图片经共享内存传递。仅 Linux / macOS 支持，其余平台连接
+/// 始终失败（ONNX_ERROR_DAEMON_UNAVAILABLE）。
+typedef void *OnnxClientHandle;
+
+/// 默认套接字路径（静态缓冲区，调用方无需释放；不支持的平台返回空串）
+FFI_PLUGIN_EXPORT const char *onnx_client_default_socket_path(void);
+
+/// 连接守护进程
+/// @param socket_path 套接字路径，NULL 表示默认路径
+/// @return 连接句柄，失败返回 NULL（ONNX_ERROR_DAEMON_UNAVAILABLE）
+FFI_PLUGIN_EXPORT OnnxClientHandle
+onnx_client_connect(const char *socket_path);
+
+/// 请求守护进程加载模型（同一路径只加载一次），后续推理使用该模型
+/// @return 错误码（ONNX_OK 表示成功）
+FFI_PLUGIN_EXPORT int onnx_client_load_model(OnnxClientHandle client,
+                                             const char *model_path,
+                                             bool use_gpu);
+
+/// 经守护进程运行批量推理，参数与 onnx_detect_batch 相同
+/// @return 堆分配的 BatchDetectionResult，需使用 onnx_free_batch_result 释放；
+///         连接断开时返回 NULL（ONNX_ERROR_DAEMON_UNAVAILABLE）
+FFI_PLUGIN_EXPORT BatchDetectionResult *onnx_client_detect_batch(
+    OnnxClientHandle client, const uint8_t **image_data_list, int num_images,
+    int *image_widths, int *image_heights, float conf_threshold,
+    float nms_threshold, int model_type, int num_keypoints);
+
+/// 断开连接并释放句柄
+FFI_PLUGIN_EXPORT void onnx_client_disconnect(OnnxClientHandle client);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,30 @@
+/**
+ * ONNX 推理插件测试专用入口（仅 ONNX_INFERENCE_TESTING 构建提供）
+ *
+ * 以合成输出张量代替 ONNX Runtime 的 Run，使门禁测试无需模型即可经
+ * onnx_detect / onnx_detect_into 走插件自身的预处理、解析、NMS 与结果写出。
+ */
+#ifndef ONNX_INFERENCE_TESTING_H
+#define ONNX_INFERENCE_TESTING_H
+
+#include "onnx_inference.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/// 创建不含会话的测试模型
+/// 每次推理的输出均为 output（[num_features, num_boxes]，仅支持单张图片），
+/// output 由调用方持有并在模型卸载前保持有效。以 onnx_unload_model 释放。
+/// @return 模型句柄；参数无效或分配失败时返回 NULL
+FFI_PLUGIN_EXPORT ModelHandle onnx_testing_create_model(int input_width,
+                                                        int input_height,
+                                                        const float *output,
+                                                        int num_features,
+                                                        int num_boxes);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ONNX_INFERENCE_TESTING_H
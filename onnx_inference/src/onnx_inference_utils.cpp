@@ -4,6 +4,23 @@
 #include "onnx_inference_utils.h"
 
 #include <algorithm>
+#include <bitset>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#elif defined(__APPLE__)
+#include <mach/mach.h>
+#else
+#include <unistd.h>
+#endif
 
 // IoU 计算基于中心点与宽高坐标。
 float onnx_iou(const Detection &a, const Detection &b) {
@@ -35,30 +52,1497 @@ float onnx_iou(const Detection &a, const Detection &b) {
 
 std::vector<Detection> onnx_nms(std::vector<Detection> detections,
                                 float threshold) {
+  size_t kept = onnx_nms_inplace(detections.data(), detections.size(),
+                                 threshold);
+  detections.resize(kept);
+  return detections;
+}
+
+namespace {
+
+// 凸多边形的有向面积（顶点按 x, y 交错存放）。
+float polygon_signed_area(const float *points, int count) {
+  float area = 0;
+  for (int i = 0, j = count - 1; i < count; j = i++) {
+    area += points[j * 2] * points[i * 2 + 1] -
+            points[i * 2] * points[j * 2 + 1];
+  }
+  return area * 0.5f;
+}
+
+// 用有向边 (a -> b) 的内侧半平面裁剪凸多边形（Sutherland-Hodgman）。
+int clip_polygon(const float *in, int count, const float *a, const float *b,
+                 float orientation, float *out) {
+  auto side = [&](const float *p) {
+    return orientation *
+           ((b[0] - a[0]) * (p[1] - a[1]) - (b[1] - a[1]) * (p[0] - a[0]));
+  };
+  int n = 0;
+  for (int i = 0; i < count; i++) {
+    const float *cur = in + i * 2;
+    const float *next = in + ((i + 1) % count) * 2;
+    float s_cur = side(cur);
+    float s_next = side(next);
+    if (s_cur >= 0) {
+      out[n * 2] = cur[0];
+      out[n * 2 + 1] = cur[1];
+      n++;
+    }
+    if ((s_cur >= 0) != (s_next >= 0)) {
+      float t = s_cur / (s_cur - s_next);
+      out[n * 2] = cur[0] + t * (next[0] - cur[0]);
+      out[n * 2 + 1] = cur[1] + t * (next[1] - cur[1]);
+      n++;
+    }
+  }
+  return n;
+}
+
+// 两个四边形的精确交集面积。
+float quad_intersection_area(const float *a, const float *b) {
+  // 凸四边形互裁最多产生 8 个顶点，每条边至多再多 1 个。
+  float buf_a[2 * 12];
+  float buf_b[2 * 12];
+  memcpy(buf_a, a, 8 * sizeof(float));
+  int n = 4;
+  float orientation = polygon_signed_area(b, 4) >= 0 ? 1.0f : -1.0f;
+  float *in = buf_a;
+  float *out = buf_b;
+  for (int e = 0; e < 4 && n > 0; e++) {
+    n = clip_polygon(in, n, b + e * 2, b + ((e + 1) % 4) * 2, orientation,
+                     out);
+    std::swap(in, out);
+  }
+  return n >= 3 ? std::fabs(polygon_signed_area(in, n)) : 0.0f;
+}
+
+// 角点的轴对齐包围盒与面积，用于旋转 NMS 的预筛。
+struct QuadBounds {
+  float x1, y1, x2, y2, area;
+};
+
+QuadBounds quad_bounds(const float *quad) {
+  QuadBounds bounds{quad[0], quad[1], quad[0], quad[1], 0};
+  for (int i = 1; i < 4; i++) {
+    bounds.x1 = std::min(bounds.x1, quad[i * 2]);
+    bounds.y1 = std::min(bounds.y1, quad[i * 2 + 1]);
+    bounds.x2 = std::max(bounds.x2, quad[i * 2]);
+    bounds.y2 = std::max(bounds.y2, quad[i * 2 + 1]);
+  }
+  bounds.area = std::fabs(polygon_signed_area(quad, 4));
+  return bounds;
+}
+
+bool has_quad(const Detection &det) {
+  return det.polygon && det.num_polygon_points == 4;
+}
+
+// 旋转 IoU 是否超过阈值；包围盒交集给出 IoU 上界，多数候选无需精确求交。
+bool rotated_overlaps(const Detection &a, const QuadBounds &ba,
+                      const Detection &b, const QuadBounds &bb,
+                      float threshold) {
+  if (!has_quad(a) || !has_quad(b))
+    return onnx_iou(a, b) > threshold;
+
+  float inter_w = std::min(ba.x2, bb.x2) - std::max(ba.x1, bb.x1);
+  float inter_h = std::min(ba.y2, bb.y2) - std::max(ba.y1, bb.y1);
+  if (inter_w <= 0 || inter_h <= 0)
+    return false;
+
+  // 交集不超过包围盒交集与较小框面积，IoU 随交集单调递增。
+  float inter_max =
+      std::min(inter_w * inter_h, std::min(ba.area, bb.area));
+  float union_min = ba.area + bb.area - inter_max;
+  if (union_min <= 0 || inter_max / union_min <= threshold)
+    return false;
+
+  float inter = quad_intersection_area(a.polygon, b.polygon);
+  float union_area = ba.area + bb.area - inter;
+  return union_area > 0 && inter / union_area > threshold;
+}
+
+// 旋转 IoU 及其包围盒上界（与 rotated_overlaps 的计算一致）；
+// 上界不超过 floor 时跳过精确求交，IoU 记为 0。
+float rotated_iou_bounded(const Detection &a, const QuadBounds &ba,
+                          const Detection &b, const QuadBounds &bb,
+                          float floor, float *upper) {
+  if (!has_quad(a) || !has_quad(b)) {
+    *upper = onnx_iou(a, b);
+    return *upper;
+  }
+
+  *upper = 0;
+  float inter_w = std::min(ba.x2, bb.x2) - std::max(ba.x1, bb.x1);
+  float inter_h = std::min(ba.y2, bb.y2) - std::max(ba.y1, bb.y1);
+  if (inter_w <= 0 || inter_h <= 0)
+    return 0;
+  float inter_max =
+      std::min(inter_w * inter_h, std::min(ba.area, bb.area));
+  float union_min = ba.area + bb.area - inter_max;
+  if (union_min <= 0)
+    return 0;
+  *upper = inter_max / union_min;
+  if (*upper <= floor)
+    return 0;
+
+  float inter = quad_intersection_area(a.polygon, b.polygon);
+  float union_area = ba.area + bb.area - inter;
+  return union_area > 0 ? inter / union_area : 0;
+}
+
+// 贪心 NMS 主体；on_keep 在候选被保留并压缩到 kept 位置时回调。
+template <typename Overlaps, typename OnKeep>
+size_t nms_inplace_with(Detection *detections, size_t count,
+                        Overlaps overlaps, OnKeep on_keep) {
+  if (!detections || count == 0)
+    return 0;
+
   // 按置信度降序排序（确保稳定的筛选优先级）。
-  std::sort(detections.begin(), detections.end(),
+  std::sort(detections, detections + count,
+            [](const Detection &a, const Detection &b) {
+              return a.confidence > b.confidence;
+            });
+
+  // 贪心抑制：候选框仅与已保留的同类别框比较，保留者压缩到前部。
+  size_t kept = 0;
+  for (size_t i = 0; i < count; i++) {
+    bool suppressed = false;
+    for (size_t k = 0; k < kept; k++) {
+      if (detections[k].class_id == detections[i].class_id &&
+          overlaps(k, detections[i])) {
+        suppressed = true;
+        break;
+      }
+    }
+    if (!suppressed) {
+      on_keep(kept, detections[i]);
+      detections[kept++] = detections[i];
+    }
+  }
+
+  return kept;
+}
+
+} // namespace
+
+size_t onnx_nms_inplace(Detection *detections, size_t count,
+                        float threshold) {
+  return nms_inplace_with(
+      detections, count,
+      [&](size_t k, const Detection &det) {
+        return onnx_iou(detections[k], det) > threshold;
+      },
+      [](size_t, const Detection &) {});
+}
+
+size_t onnx_nms_rotated_inplace(Detection *detections, size_t count,
+                                float threshold) {
+  // 保留者的包围盒只计算一次；缓存随线程复用，稳态下不分配内存。
+  thread_local std::vector<QuadBounds> kept_bounds;
+  if (kept_bounds.size() < count) {
+    kept_bounds.resize(count);
+  }
+  QuadBounds current{};
+  const Detection *current_det = nullptr;
+  auto bounds_of = [&](const Detection &det) -> const QuadBounds & {
+    if (current_det != &det) {
+      current = has_quad(det) ? quad_bounds(det.polygon) : QuadBounds{};
+      current_det = &det;
+    }
+    return current;
+  };
+  return nms_inplace_with(
+      detections, count,
+      [&](size_t k, const Detection &det) {
+        return rotated_overlaps(detections[k], kept_bounds[k], det,
+                                bounds_of(det), threshold);
+      },
+      [&](size_t k, const Detection &det) { kept_bounds[k] = bounds_of(det); });
+}
+
+size_t onnx_nms_sweep(Detection *detections, size_t count,
+                      const float *thresholds, int num_thresholds,
+                      bool rotated, std::vector<std::vector<uint32_t>> *kept) {
+  if (num_thresholds < 0)
+    num_thresholds = 0;
+  kept->resize(num_thresholds);
+  for (auto &list : *kept) {
+    list.clear();
+  }
+  if (!detections || count == 0 || num_thresholds == 0 ||
+      num_thresholds > kMaxSweepNmsThresholds)
+    return 0;
+
+  // 与 nms_inplace_with 相同的排序。
+  std::sort(detections, detections + count,
             [](const Detection &a, const Detection &b) {
               return a.confidence > b.confidence;
             });
 
-  std::vector<bool> suppressed(detections.size(), false);
-  std::vector<Detection> result;
+  // 各阈值保留者的并集（排序后下标升序），及其保留于哪些阈值的位掩码。
+  thread_local std::vector<uint32_t> keepers;
+  thread_local std::vector<uint32_t> keeper_masks;
+  thread_local std::vector<QuadBounds> keeper_bounds;
+  keepers.clear();
+  keeper_masks.clear();
+  keeper_bounds.clear();
+  const uint32_t all = num_thresholds == 32
+                           ? ~0u
+                           : (1u << num_thresholds) - 1;
 
-  for (size_t i = 0; i < detections.size(); i++) {
-    if (suppressed[i])
+  for (size_t i = 0; i < count; i++) {
+    const Detection &det = detections[i];
+    QuadBounds bounds{};
+    if (rotated && has_quad(det)) {
+      bounds = quad_bounds(det.polygon);
+    }
+    uint32_t suppressed = 0;
+    for (size_t u = 0; u < keepers.size() && suppressed != all; u++) {
+      // 仅对仍保留该候选、且保留了此框的阈值比较。
+      uint32_t live = keeper_masks[u] & ~suppressed;
+      const Detection &keeper = detections[keepers[u]];
+      if (!live || keeper.class_id != det.class_id)
+        continue;
+      float iou;
+      float upper;
+      if (rotated) {
+        float floor = 1.0f;
+        for (int j = 0; j < num_thresholds; j++) {
+          if (live & (1u << j))
+            floor = std::min(floor, thresholds[j]);
+        }
+        iou = rotated_iou_bounded(keeper, keeper_bounds[u], det, bounds,
+                                  floor, &upper);
+      } else {
+        iou = onnx_iou(keeper, det);
+        upper = iou;
+      }
+      for (int j = 0; j < num_thresholds; j++) {
+        if ((live & (1u << j)) && upper > thresholds[j] &&
+            iou > thresholds[j])
+          suppressed |= 1u << j;
+      }
+    }
+    uint32_t keep = all & ~suppressed;
+    if (!keep)
       continue;
+    uint32_t position = (uint32_t)keepers.size();
+    for (int j = 0; j < num_thresholds; j++) {
+      if (keep & (1u << j))
+        (*kept)[j].push_back(position);
+    }
+    keepers.push_back((uint32_t)i);
+    keeper_masks.push_back(keep);
+    keeper_bounds.push_back(bounds);
+  }
+
+  // 并集下标升序且不小于其位置，可原地前移。
+  for (size_t u = 0; u < keepers.size(); u++) {
+    detections[u] = detections[keepers[u]];
+  }
+  return keepers.size();
+}
+
+float onnx_rotated_iou(const Detection &a, const Detection &b) {
+  if (!has_quad(a) || !has_quad(b))
+    return onnx_iou(a, b);
+  QuadBounds ba = quad_bounds(a.polygon);
+  QuadBounds bb = quad_bounds(b.polygon);
+  if (std::min(ba.x2, bb.x2) <= std::max(ba.x1, bb.x1) ||
+      std::min(ba.y2, bb.y2) <= std::max(ba.y1, bb.y1))
+    return 0;
+  float inter = quad_intersection_area(a.polygon, b.polygon);
+  float union_area = ba.area + bb.area - inter;
+  return union_area > 0 ? inter / union_area : 0;
+}
+
+void preprocess_image_to_buffer(const uint8_t *image_data, int image_width,
+                                int image_height, int target_width,
+                                int target_height, float *buffer,
+                                float *scale_x, float *scale_y, int *pad_left,
+                                int *pad_top) {
+  if (!image_data || !buffer || target_width <= 0 || target_height <= 0 ||
+      image_width <= 1 || image_height <= 1) {
+    if (scale_x)
+      *scale_x = 0.0f;
+    if (scale_y)
+      *scale_y = 0.0f;
+    if (pad_left)
+      *pad_left = 0;
+    if (pad_top)
+      *pad_top = 0;
+    return;
+  }
+  // 计算 letterbox 缩放比例（保持宽高比）
+  float ratio = std::min((float)target_width / image_width,
+                         (float)target_height / image_height);
+
+  int new_width = (int)(image_width * ratio);
+  int new_height = (int)(image_height * ratio);
+
+  *pad_left = (target_width - new_width) / 2;
+  *pad_top = (target_height - new_height) / 2;
+  *scale_x = ratio;
+  *scale_y = ratio;
+
+  // 填充灰色 (114/255) - YOLO 标准填充值
+  const float pad_value = 114.0f / 255.0f;
+  int total_pixels = target_width * target_height;
+  for (int i = 0; i < 3 * total_pixels; i++) {
+    buffer[i] = pad_value;
+  }
+
+  // 使用双线性插值复制和缩放图像（RGBA -> CHW RGB）。
+  for (int y = 0; y < new_height; y++) {
+    float src_y_f = y / ratio;
+    int src_y = (int)src_y_f;
+    float y_lerp = src_y_f - src_y;
+    if (src_y >= image_height - 1) {
+      src_y = image_height - 2;
+      y_lerp = 1.0f;
+    }
+
+    for (int x = 0; x < new_width; x++) {
+      float src_x_f = x / ratio;
+      int src_x = (int)src_x_f;
+      float x_lerp = src_x_f - src_x;
+      if (src_x >= image_width - 1) {
+        src_x = image_width - 2;
+        x_lerp = 1.0f;
+      }
+
+      int dst_x = x + *pad_left;
+      int dst_y = y + *pad_top;
+      int c_stride = target_width * target_height;
+      int dst_idx = dst_y * target_width + dst_x;
+
+      // 对每个通道进行双线性插值
+      for (int c = 0; c < 3; c++) {
+        int idx00 = (src_y * image_width + src_x) * 4 + c;
+        int idx01 = (src_y * image_width + src_x + 1) * 4 + c;
+        int idx10 = ((src_y + 1) * image_width + src_x) * 4 + c;
+        int idx11 = ((src_y + 1) * image_width + src_x + 1) * 4 + c;
+
+        float v00 = image_data[idx00] / 255.0f;
+        float v01 = image_data[idx01] / 255.0f;
+        float v10 = image_data[idx10] / 255.0f;
+        float v11 = image_data[idx11] / 255.0f;
+
+        float v0 = v00 * (1 - x_lerp) + v01 * x_lerp;
+        float v1 = v10 * (1 - x_lerp) + v11 * x_lerp;
+        float v = v0 * (1 - y_lerp) + v1 * y_lerp;
+
+        buffer[c * c_stride + dst_idx] = v;
+      }
+    }
+  }
+}
 
-    result.push_back(detections[i]);
+namespace {
 
-    // 抑制同类别中 IoU 大于阈值的检测框
-    for (size_t j = i + 1; j < detections.size(); j++) {
-      if (!suppressed[j] && detections[i].class_id == detections[j].class_id) {
-        if (onnx_iou(detections[i], detections[j]) > threshold) {
-          suppressed[j] = true;
+// 候选框解码上下文：letterbox 坐标映射与附加特征（关键点/掩码系数/角度）布局。
+struct CandidateDecoder {
+  float scale_x, scale_y;
+  int pad_left, pad_top;
+  int image_width, image_height;
+  int num_keypoints = 0;  // > 0 时读取关键点
+  bool has_masks = false; // 读取掩码系数
+  int extra_start = 0;    // 关键点/掩码系数的起始特征
+  int angle_index = -1;   // 角度特征（>= 0 时为旋转框）
+  DetectionScratch *scratch = nullptr;
+
+  // 按候选框上限预留附加特征缓冲，保证写入期间指针稳定。
+  void reserve(int max_candidates) const {
+    size_t n = (size_t)max_candidates;
+    if (num_keypoints > 0 &&
+        scratch->keypoints.size() < (size_t)num_keypoints * 3 * n) {
+      scratch->keypoints.resize((size_t)num_keypoints * 3 * n);
+    }
+    if (has_masks && scratch->mask_coeffs.size() < (size_t)kSegMaskCoeffs * n) {
+      scratch->mask_coeffs.resize((size_t)kSegMaskCoeffs * n);
+    }
+    if (angle_index >= 0 && scratch->polygons.size() < 8 * n) {
+      scratch->polygons.resize(8 * n);
+    }
+  }
+
+  // 追加一个候选框；feature(k) 读取该框的第 k 个特征，坐标为输入像素空间。
+  template <typename Feature>
+  void emit(const Feature &feature, int class_id, float score, float cx,
+            float cy, float w, float h) const {
+    size_t index = scratch->candidates.size();
+
+    // 转换为原始图像坐标（归一化 0-1）。
+    Detection det;
+    det.class_id = class_id;
+    det.confidence = score;
+    det.x = (cx - pad_left) / scale_x / image_width;
+    det.y = (cy - pad_top) / scale_y / image_height;
+    det.width = w / scale_x / image_width;
+    det.height = h / scale_y / image_height;
+    det.keypoints = nullptr;
+    det.num_keypoints = 0;
+    det.polygon = nullptr;
+    det.num_polygon_points = 0;
+    det.angle = 0;
+
+    // 提取姿态模型的关键点（归一化坐标）。
+    if (num_keypoints > 0) {
+      float *kpts =
+          scratch->keypoints.data() + (size_t)num_keypoints * 3 * index;
+      for (int k = 0; k < num_keypoints; k++) {
+        float kp_x = feature(extra_start + k * 3 + 0);
+        float kp_y = feature(extra_start + k * 3 + 1);
+        float kp_v = feature(extra_start + k * 3 + 2);
+
+        kpts[k * 3 + 0] = (kp_x - pad_left) / scale_x / image_width;
+        kpts[k * 3 + 1] = (kp_y - pad_top) / scale_y / image_height;
+        kpts[k * 3 + 2] = kp_v;
+      }
+      det.keypoints = kpts;
+      det.num_keypoints = num_keypoints;
+    }
+
+    // 暂存分割模型的掩码系数（组装掩码后替换为多边形）。
+    if (has_masks) {
+      float *coeffs =
+          scratch->mask_coeffs.data() + (size_t)kSegMaskCoeffs * index;
+      for (int k = 0; k < kSegMaskCoeffs; k++) {
+        coeffs[k] = feature(extra_start + k);
+      }
+      det.polygon = coeffs;
+    }
+
+    // 旋转框：角点在输入像素空间展开后再映射回原图（归一化）。
+    if (angle_index >= 0) {
+      float angle = feature(angle_index);
+      float c = std::cos(angle);
+      float s = std::sin(angle);
+      float ux = w * 0.5f * c, uy = w * 0.5f * s;
+      float vx = -h * 0.5f * s, vy = h * 0.5f * c;
+      const float signs[4][2] = {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+      float *corners = scratch->polygons.data() + 8 * index;
+      for (int k = 0; k < 4; k++) {
+        float px = cx + signs[k][0] * ux + signs[k][1] * vx;
+        float py = cy + signs[k][0] * uy + signs[k][1] * vy;
+        corners[k * 2] = (px - pad_left) / scale_x / image_width;
+        corners[k * 2 + 1] = (py - pad_top) / scale_y / image_height;
+      }
+      det.angle = angle;
+      det.polygon = corners;
+      det.num_polygon_points = 4;
+    }
+
+    scratch->candidates.push_back(det);
+  }
+};
+
+} // namespace
+
+// YOLOv8 输出格式: [1, num_features, num_boxes]
+// 检测: num_features = 4 + num_classes
+// 姿态: num_features = 4 + num_classes + num_keypoints * 3
+// 分割: num_features = 4 + num_classes + 32（掩码系数）
+// 旋转框: num_features = 4 + num_classes + 1（角度，弧度）
+void parse_yolov8_output(const float *output_data, int num_features,
+                         int num_boxes, int model_type, int num_keypoints,
+                         float conf_threshold, float scale_x, float scale_y,
+                         int pad_left, int pad_top, int image_width,
+                         int image_height, DetectionScratch *scratch) {
+  scratch->candidates.clear();
+  if (!output_data || num_boxes <= 0 || scale_x <= 0 || scale_y <= 0)
+    return;
+
+  // 根据模型类型计算类别数
+  int num_classes;
+  bool has_keypoints = model_type == MODEL_TYPE_YOLO_POSE && num_keypoints > 0;
+  bool has_masks = model_type == MODEL_TYPE_YOLO_SEG &&
+                   num_features > 4 + kSegMaskCoeffs;
+  bool has_angle = model_type == MODEL_TYPE_YOLO_OBB && num_features > 5;
+
+  if (has_keypoints) {
+    num_classes = num_features - 4 - num_keypoints * 3;
+  } else if (has_masks) {
+    num_classes = num_features - 4 - kSegMaskCoeffs;
+  } else if (has_angle) {
+    num_classes = num_features - 4 - 1;
+  } else {
+    num_classes = num_features - 4;
+  }
+
+  if (num_classes < 1) {
+    fprintf(stderr, "[警告] 无效的类别数=%d，设置为 1\n", num_classes);
+    num_classes = 1;
+  }
+
+  CandidateDecoder decoder{scale_x, scale_y, pad_left, pad_top,
+                           image_width, image_height};
+  decoder.num_keypoints = has_keypoints ? num_keypoints : 0;
+  decoder.has_masks = has_masks;
+  decoder.extra_start = 4 + num_classes;
+  decoder.angle_index = has_angle ? num_features - 1 : -1;
+  decoder.scratch = scratch;
+  decoder.reserve(num_boxes);
+
+  for (int i = 0; i < num_boxes; i++) {
+    // 找到最佳类别
+    int best_class = 0;
+    float best_score = 0;
+    for (int c = 0; c < num_classes; c++) {
+      float score = output_data[(4 + c) * num_boxes + i];
+      if (score > best_score) {
+        best_score = score;
+        best_class = c;
+      }
+    }
+
+    if (best_score < conf_threshold)
+      continue;
+
+    // YOLOv8 转置格式: output[feature][box]
+    auto feature = [&](int f) {
+      return output_data[(size_t)f * num_boxes + i];
+    };
+    decoder.emit(feature, best_class, best_score, feature(0), feature(1),
+                 feature(2), feature(3));
+  }
+}
+
+// 端到端输出格式: [1, num_rows, row_size]，每行一个最终检测框
+// 检测: x1, y1, x2, y2, score, class
+// 姿态/分割: 检测 6 项后接关键点 (x, y, v) 或 32 个掩码系数
+// 旋转框: cx, cy, w, h, score, class, angle
+void parse_end2end_output(const float *output_data, int row_size,
+                          int num_rows, int model_type, int num_keypoints,
+                          float conf_threshold, float scale_x, float scale_y,
+                          int pad_left, int pad_top, int image_width,
+                          int image_height, DetectionScratch *scratch) {
+  scratch->candidates.clear();
+  if (!output_data || num_rows <= 0 || row_size < 6 || scale_x <= 0 ||
+      scale_y <= 0)
+    return;
+
+  bool is_obb = model_type == MODEL_TYPE_YOLO_OBB && row_size >= 7;
+  CandidateDecoder decoder{scale_x, scale_y, pad_left, pad_top,
+                           image_width, image_height};
+  decoder.extra_start = 6;
+  decoder.num_keypoints = model_type == MODEL_TYPE_YOLO_POSE &&
+                                  num_keypoints > 0 &&
+                                  row_size >= 6 + num_keypoints * 3
+                              ? num_keypoints
+                              : 0;
+  decoder.has_masks =
+      model_type == MODEL_TYPE_YOLO_SEG && row_size >= 6 + kSegMaskCoeffs;
+  decoder.angle_index = is_obb ? 6 : -1;
+  decoder.scratch = scratch;
+  decoder.reserve(num_rows);
+
+  for (int i = 0; i < num_rows; i++) {
+    const float *row = output_data + (size_t)i * row_size;
+    // 末尾的填充行得分为 0，由阈值过滤。
+    float score = row[4];
+    if (!(score >= conf_threshold) || row[5] < 0)
+      continue;
+
+    auto feature = [row](int f) { return row[f]; };
+    int class_id = (int)(row[5] + 0.5f);
+    if (is_obb) {
+      decoder.emit(feature, class_id, score, row[0], row[1], row[2], row[3]);
+    } else {
+      decoder.emit(feature, class_id, score, (row[0] + row[2]) * 0.5f,
+                   (row[1] + row[3]) * 0.5f, row[2] - row[0],
+                   row[3] - row[1]);
+    }
+  }
+}
+
+// ============================================================================
+// 分割掩码
+// ============================================================================
+
+void onnx_mask_logits(const float *coeffs, const float *protos, int num_protos,
+                      int proto_width, int proto_height, int x0, int y0, int x1,
+                      int y1, float *out) {
+  // 每次累加 8 个连续像素：定长内层循环可被展开并以 SIMD 寄存器承载
+  // （-O2 下同样生效），累加器留在寄存器中，每个输出只写一次。
+  constexpr int kBlock = 8;
+  int crop_width = x1 - x0;
+  size_t plane = (size_t)proto_width * proto_height;
+  for (int y = y0; y < y1; y++) {
+    float *row = out + (size_t)(y - y0) * crop_width;
+    const float *base = protos + (size_t)y * proto_width + x0;
+    int x = 0;
+    for (; x + kBlock <= crop_width; x += kBlock) {
+      float acc[kBlock] = {0};
+      for (int k = 0; k < num_protos; k++) {
+        const float *src = base + k * plane + x;
+        const float c = coeffs[k];
+        for (int j = 0; j < kBlock; j++) {
+          acc[j] += c * src[j];
         }
       }
+      for (int j = 0; j < kBlock; j++) {
+        row[x + j] = acc[j];
+      }
+    }
+    for (; x < crop_width; x++) {
+      float acc = 0.0f;
+      for (int k = 0; k < num_protos; k++) {
+        acc += coeffs[k] * base[k * plane + x];
+      }
+      row[x] = acc;
     }
   }
+}
+
+namespace {
+
+// 8 邻域方向（图像坐标，y 向下），按顺时针排列，从正西开始。
+const int kDirX[8] = {-1, -1, 0, 1, 1, 1, 0, -1};
+const int kDirY[8] = {0, -1, -1, -1, 0, 1, 1, 1};
+
+} // namespace
+
+size_t onnx_trace_mask_contour(const uint8_t *mask, int width, int height,
+                               MaskScratch *scratch) {
+  scratch->contour.clear();
+  if (!mask || width <= 0 || height <= 0)
+    return 0;
 
-  return result;
+  // 8 连通域标记，选出面积最大的连通域。
+  size_t area = (size_t)width * height;
+  std::vector<int> &labels = scratch->labels;
+  std::vector<int> &stack = scratch->stack;
+  labels.assign(area, 0);
+  int best_label = 0;
+  size_t best_size = 0;
+  int best_start = -1;
+  int next_label = 0;
+  for (int start = 0; start < (int)area; start++) {
+    if (!mask[start] || labels[start])
+      continue;
+    int label = ++next_label;
+    size_t size = 0;
+    labels[start] = label;
+    stack.clear();
+    stack.push_back(start);
+    while (!stack.empty()) {
+      int idx = stack.back();
+      stack.pop_back();
+      size++;
+      int cx = idx % width;
+      int cy = idx / width;
+      for (int d = 0; d < 8; d++) {
+        int nx = cx + kDirX[d];
+        int ny = cy + kDirY[d];
+        if (nx < 0 || ny < 0 || nx >= width || ny >= height)
+          continue;
+        int n = ny * width + nx;
+        if (mask[n] && !labels[n]) {
+          labels[n] = label;
+          stack.push_back(n);
+        }
+      }
+    }
+    if (size > best_size) {
+      best_size = size;
+      best_label = label;
+      best_start = start;
+    }
+  }
+  if (best_start < 0)
+    return 0;
+
+  auto inside = [&](int x, int y) {
+    return x >= 0 && y >= 0 && x < width && y < height &&
+           labels[y * width + x] == best_label;
+  };
+
+  // 径向扫描追踪外轮廓：起点为光栅序首个像素，其西侧必为背景。
+  std::vector<float> &contour = scratch->contour;
+  int sx = best_start % width;
+  int sy = best_start / width;
+  contour.push_back((float)sx);
+  contour.push_back((float)sy);
+
+  int px = sx, py = sy;
+  int back = 0; // 从当前像素指向上一轮廓像素（或背景）的方向
+  int second_x = -1, second_y = -1;
+  size_t max_steps = area * 4 + 8;
+  for (size_t step = 0; step < max_steps; step++) {
+    int found = -1;
+    for (int k = 1; k <= 8; k++) {
+      int d = (back + k) % 8;
+      if (inside(px + kDirX[d], py + kDirY[d])) {
+        found = d;
+        break;
+      }
+    }
+    if (found < 0)
+      break; // 孤立像素
+
+    int nx = px + kDirX[found];
+    int ny = py + kDirY[found];
+    if (px == sx && py == sy && step > 0 && nx == second_x &&
+        ny == second_y) {
+      // 回到起点且下一步与第一步相同：轮廓闭合，去掉重复的起点。
+      contour.resize(contour.size() - 2);
+      break;
+    }
+    if (step == 0) {
+      second_x = nx;
+      second_y = ny;
+    }
+    contour.push_back((float)nx);
+    contour.push_back((float)ny);
+    back = (found + 4) % 8;
+    px = nx;
+    py = ny;
+  }
+  return contour.size() / 2;
+}
+
+namespace {
+
+// 点到线段的距离平方。
+float segment_distance_sq(const float *p, const float *a, const float *b) {
+  float dx = b[0] - a[0];
+  float dy = b[1] - a[1];
+  float len_sq = dx * dx + dy * dy;
+  float t = 0.0f;
+  if (len_sq > 0.0f) {
+    t = ((p[0] - a[0]) * dx + (p[1] - a[1]) * dy) / len_sq;
+    t = std::max(0.0f, std::min(1.0f, t));
+  }
+  float ex = a[0] + t * dx - p[0];
+  float ey = a[1] + t * dy - p[1];
+  return ex * ex + ey * ey;
+}
+
+} // namespace
+
+size_t onnx_simplify_polygon(const float *points, size_t count, float epsilon,
+                             float *out, MaskScratch *scratch) {
+  if (count <= 3) {
+    if (out != points && count > 0)
+      memmove(out, points, count * 2 * sizeof(float));
+    return count;
+  }
+
+  // 以首点与距其最远的点切分闭合多边形，两条链分别做 Douglas-Peucker。
+  size_t far_index = 0;
+  float far_dist = -1.0f;
+  for (size_t i = 1; i < count; i++) {
+    float dx = points[i * 2] - points[0];
+    float dy = points[i * 2 + 1] - points[1];
+    float d = dx * dx + dy * dy;
+    if (d > far_dist) {
+      far_dist = d;
+      far_index = i;
+    }
+  }
+
+  std::vector<uint8_t> &keep = scratch->keep;
+  std::vector<int> &ranges = scratch->ranges;
+  keep.assign(count, 0);
+  keep[0] = 1;
+  keep[far_index] = 1;
+  ranges.clear();
+  // 区间 [first, last]，last == count 表示回到首点。
+  ranges.push_back(0);
+  ranges.push_back((int)far_index);
+  ranges.push_back((int)far_index);
+  ranges.push_back((int)count);
+
+  float eps_sq = epsilon * epsilon;
+  while (!ranges.empty()) {
+    int last = ranges.back();
+    ranges.pop_back();
+    int first = ranges.back();
+    ranges.pop_back();
+    const float *a = points + (size_t)first * 2;
+    const float *b = points + (size_t)(last % count) * 2;
+    float max_dist = 0.0f;
+    int max_index = -1;
+    for (int i = first + 1; i < last; i++) {
+      float d = segment_distance_sq(points + (size_t)i * 2, a, b);
+      if (d > max_dist) {
+        max_dist = d;
+        max_index = i;
+      }
+    }
+    if (max_index >= 0 && max_dist > eps_sq) {
+      keep[max_index] = 1;
+      ranges.push_back(first);
+      ranges.push_back(max_index);
+      ranges.push_back(max_index);
+      ranges.push_back(last);
+    }
+  }
+
+  size_t kept = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (keep[i]) {
+      out[kept * 2] = points[i * 2];
+      out[kept * 2 + 1] = points[i * 2 + 1];
+      kept++;
+    }
+  }
+  return kept;
+}
+
+void assemble_yolov8_masks(Detection *detections, int count,
+                           const MaskPrototypes &protos, float scale_x,
+                           float scale_y, int pad_left, int pad_top,
+                           int image_width, int image_height, float epsilon,
+                           DetectionScratch *scratch) {
+  scratch->polygons.clear();
+  MaskScratch &ms = scratch->mask;
+  ms.offsets.assign(count, 0);
+
+  bool usable = protos.data && protos.width > 0 && protos.height > 0 &&
+                protos.input_width > 0 && protos.input_height > 0 &&
+                scale_x > 0 && scale_y > 0 && image_width > 0 &&
+                image_height > 0;
+  // 输入像素 -> 原型像素的比例。
+  float to_proto_x = usable ? (float)protos.width / protos.input_width : 0;
+  float to_proto_y = usable ? (float)protos.height / protos.input_height : 0;
+
+  for (int i = 0; i < count; i++) {
+    Detection &det = detections[i];
+    const float *coeffs = det.num_polygon_points == 0 ? det.polygon : nullptr;
+    det.polygon = nullptr;
+    det.num_polygon_points = 0;
+    if (!usable || !coeffs)
+      continue;
+
+    // 检测框映射到原型分辨率并裁剪，只在框内计算掩码。
+    float cx = det.x * image_width * scale_x + pad_left;
+    float cy = det.y * image_height * scale_y + pad_top;
+    float bw = det.width * image_width * scale_x;
+    float bh = det.height * image_height * scale_y;
+    int x0 = std::max(0, (int)std::floor((cx - bw / 2) * to_proto_x));
+    int y0 = std::max(0, (int)std::floor((cy - bh / 2) * to_proto_y));
+    int x1 = std::min(protos.width, (int)std::ceil((cx + bw / 2) * to_proto_x));
+    int y1 =
+        std::min(protos.height, (int)std::ceil((cy + bh / 2) * to_proto_y));
+    if (x1 <= x0 || y1 <= y0)
+      continue;
+
+    int crop_w = x1 - x0;
+    int crop_h = y1 - y0;
+    size_t crop_area = (size_t)crop_w * crop_h;
+    if (ms.logits.size() < crop_area)
+      ms.logits.resize(crop_area);
+    onnx_mask_logits(coeffs, protos.data, kSegMaskCoeffs, protos.width,
+                     protos.height, x0, y0, x1, y1, ms.logits.data());
+
+    // logit > 0 等价于 sigmoid > 0.5，无需计算 sigmoid。
+    if (ms.binary.size() < crop_area)
+      ms.binary.resize(crop_area);
+    uint8_t *binary = ms.binary.data();
+    for (size_t p = 0; p < crop_area; p++) {
+      binary[p] = ms.logits[p] > 0.0f ? 1 : 0;
+    }
+
+    size_t n = onnx_trace_mask_contour(binary, crop_w, crop_h, &ms);
+    n = onnx_simplify_polygon(ms.contour.data(), n, epsilon, ms.contour.data(),
+                              &ms);
+    if (n < 3)
+      continue;
+
+    // 像素中心 -> 输入坐标 -> 原图归一化坐标。
+    size_t offset = scratch->polygons.size();
+    for (size_t k = 0; k < n; k++) {
+      float ix = (x0 + ms.contour[k * 2] + 0.5f) / to_proto_x;
+      float iy = (y0 + ms.contour[k * 2 + 1] + 0.5f) / to_proto_y;
+      float nx = (ix - pad_left) / scale_x / image_width;
+      float ny = (iy - pad_top) / scale_y / image_height;
+      scratch->polygons.push_back(std::max(0.0f, std::min(1.0f, nx)));
+      scratch->polygons.push_back(std::max(0.0f, std::min(1.0f, ny)));
+    }
+    ms.offsets[i] = offset;
+    det.num_polygon_points = (int)n;
+  }
+
+  // polygons 增长完成后再回填指针，避免扩容导致悬垂。
+  for (int i = 0; i < count; i++) {
+    if (detections[i].num_polygon_points > 0) {
+      detections[i].polygon = scratch->polygons.data() + ms.offsets[i];
+    }
+  }
+}
+
+bool onnx_copy_detections(const Detection *detections, int count,
+                          DetectionResult *out) {
+  out->detections = nullptr;
+  out->count = 0;
+  out->capacity = 0;
+  if (count <= 0)
+    return true;
+
+  out->detections = (Detection *)malloc(count * sizeof(Detection));
+  if (!out->detections)
+    return false;
+  out->capacity = count;
+
+  for (int i = 0; i < count; i++) {
+    Detection det = detections[i];
+    float *kpts = nullptr;
+    float *polygon = nullptr;
+    if (det.keypoints && det.num_keypoints > 0) {
+      size_t bytes = (size_t)det.num_keypoints * 3 * sizeof(float);
+      kpts = (float *)malloc(bytes);
+      if (!kpts) {
+        onnx_release_detections(out);
+        return false;
+      }
+      memcpy(kpts, det.keypoints, bytes);
+    } else {
+      det.num_keypoints = 0;
+    }
+    if (det.polygon && det.num_polygon_points > 0) {
+      size_t bytes = (size_t)det.num_polygon_points * 2 * sizeof(float);
+      polygon = (float *)malloc(bytes);
+      if (!polygon) {
+        free(kpts);
+        onnx_release_detections(out);
+        return false;
+      }
+      memcpy(polygon, det.polygon, bytes);
+    } else {
+      det.num_polygon_points = 0;
+    }
+    det.keypoints = kpts;
+    det.polygon = polygon;
+    out->detections[i] = det;
+    out->count = i + 1;
+  }
+  return true;
+}
+
+void onnx_release_detections(DetectionResult *result) {
+  if (!result)
+    return;
+  if (result->detections) {
+    for (int i = 0; i < result->count; i++) {
+      free(result->detections[i].keypoints);
+      free(result->detections[i].polygon);
+    }
+    free(result->detections);
+  }
+  result->detections = nullptr;
+  result->count = 0;
+  result->capacity = 0;
+}
+
+int onnx_pack_result(const Detection *detections, int count,
+                     OnnxResultBuffer *out) {
+  // 先计算所需容量，确保溢出时不留下部分写入的结果。
+  int64_t arena_needed = 0;
+  for (int i = 0; i < count; i++) {
+    if (detections[i].keypoints && detections[i].num_keypoints > 0) {
+      arena_needed +=
+          (int64_t)detections[i].num_keypoints * 3 * (int64_t)sizeof(float);
+    }
+    if (detections[i].polygon && detections[i].num_polygon_points > 0) {
+      arena_needed += (int64_t)detections[i].num_polygon_points * 2 *
+                      (int64_t)sizeof(float);
+    }
+  }
+
+  out->count = 0;
+  out->arena_used = 0;
+  out->required_capacity = count;
+  out->required_arena = arena_needed;
+  if (count > out->capacity || arena_needed > out->arena_capacity ||
+      (count > 0 && !out->detections) ||
+      (arena_needed > 0 && !out->arena)) {
+    return ONNX_ERROR_BUFFER_TOO_SMALL;
+  }
+
+  for (int i = 0; i < count; i++) {
+    Detection det = detections[i];
+    if (det.keypoints && det.num_keypoints > 0) {
+      size_t bytes = (size_t)det.num_keypoints * 3 * sizeof(float);
+      float *kpts = (float *)(out->arena + out->arena_used);
+      memcpy(kpts, det.keypoints, bytes);
+      det.keypoints = kpts;
+      out->arena_used += (int64_t)bytes;
+    } else {
+      det.keypoints = nullptr;
+      det.num_keypoints = 0;
+    }
+    if (det.polygon && det.num_polygon_points > 0) {
+      size_t bytes = (size_t)det.num_polygon_points * 2 * sizeof(float);
+      float *polygon = (float *)(out->arena + out->arena_used);
+      memcpy(polygon, det.polygon, bytes);
+      det.polygon = polygon;
+      out->arena_used += (int64_t)bytes;
+    } else {
+      det.polygon = nullptr;
+      det.num_polygon_points = 0;
+    }
+    out->detections[i] = det;
+  }
+  out->count = count;
+  return ONNX_OK;
+}
+
+// ============================================================================
+// 图像暂存池
+// ============================================================================
+
+namespace {
+
+// 缓冲区前缀头：记录尺寸等级与容量，使归还无需额外查找结构。
+struct PoolHeader {
+  int32_t size_class; // -1 表示未入池的大缓冲区
+  int32_t reserved;
+  int64_t capacity;
+};
+static_assert(sizeof(PoolHeader) == 16, "PoolHeader 必须保持 16 字节对齐");
+
+int pool_size_class(int64_t size) {
+  for (int c = 0; c < kImagePoolNumClasses; c++) {
+    if (size <= (int64_t(1) << (kImagePoolMinShift + c)))
+      return c;
+  }
+  return -1;
+}
+
+PoolHeader *pool_header(uint8_t *buffer) {
+  return reinterpret_cast<PoolHeader *>(buffer - sizeof(PoolHeader));
+}
+
+} // namespace
+
+uint8_t *onnx_pool_acquire(ImageBufferPool *pool, int64_t size) {
+  if (!pool || size <= 0)
+    return nullptr;
+
+  int size_class = pool_size_class(size);
+  int64_t capacity =
+      size_class >= 0 ? int64_t(1) << (kImagePoolMinShift + size_class) : size;
+
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    if (size_class >= 0 && !pool->free_lists[size_class].empty()) {
+      uint8_t *buffer = pool->free_lists[size_class].back();
+      pool->free_lists[size_class].pop_back();
+      pool->cached_bytes -= capacity;
+      pool->in_use_bytes += capacity;
+      pool->high_water = std::max(pool->high_water, pool->in_use_bytes);
+      return buffer;
+    }
+  }
+
+  // 缓存未命中：在锁外分配，避免阻塞其他线程。
+  void *raw = malloc(sizeof(PoolHeader) + (size_t)capacity);
+  if (!raw)
+    return nullptr;
+  PoolHeader *header = static_cast<PoolHeader *>(raw);
+  header->size_class = size_class;
+  header->reserved = 0;
+  header->capacity = capacity;
+
+  std::lock_guard<std::mutex> lock(pool->mutex);
+  pool->in_use_bytes += capacity;
+  pool->high_water = std::max(pool->high_water, pool->in_use_bytes);
+  return static_cast<uint8_t *>(raw) + sizeof(PoolHeader);
+}
+
+void onnx_pool_release(ImageBufferPool *pool, uint8_t *buffer) {
+  if (!pool || !buffer)
+    return;
+
+  PoolHeader *header = pool_header(buffer);
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    pool->in_use_bytes -= header->capacity;
+    if (header->size_class >= 0) {
+      pool->free_lists[header->size_class].push_back(buffer);
+      pool->cached_bytes += header->capacity;
+      return;
+    }
+  }
+  free(header);
+}
+
+int64_t onnx_pool_trim(ImageBufferPool *pool) {
+  if (!pool)
+    return 0;
+
+  std::vector<uint8_t *> victims;
+  int64_t freed = 0;
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    // 保留的缓存加在用字节不超过高水位；优先回收大缓冲区。
+    int64_t keep = std::max<int64_t>(0, pool->high_water - pool->in_use_bytes);
+    for (int c = kImagePoolNumClasses - 1; c >= 0; c--) {
+      int64_t capacity = int64_t(1) << (kImagePoolMinShift + c);
+      auto &list = pool->free_lists[c];
+      while (!list.empty() && pool->cached_bytes > keep) {
+        victims.push_back(list.back());
+        list.pop_back();
+        pool->cached_bytes -= capacity;
+        freed += capacity;
+      }
+    }
+    pool->high_water = pool->in_use_bytes;
+  }
+
+  for (uint8_t *buffer : victims) {
+    free(pool_header(buffer));
+  }
+  return freed;
+}
+
+int64_t onnx_pool_clear(ImageBufferPool *pool) {
+  if (!pool)
+    return 0;
+
+  std::vector<uint8_t *> victims;
+  int64_t freed = 0;
+  {
+    std::lock_guard<std::mutex> lock(pool->mutex);
+    for (auto &list : pool->free_lists) {
+      for (uint8_t *buffer : list) {
+        freed += pool_header(buffer)->capacity;
+        victims.push_back(buffer);
+      }
+      list.clear();
+    }
+    pool->cached_bytes = 0;
+  }
+
+  for (uint8_t *buffer : victims) {
+    free(pool_header(buffer));
+  }
+  return freed;
+}
+
+void onnx_inflight_begin(InflightCounter *counter) { counter->count++; }
+
+void onnx_inflight_end(InflightCounter *counter) {
+  if (--counter->count == 0) {
+    counter->idle.notify_all();
+  }
+}
+
+void onnx_inflight_wait(InflightCounter *counter,
+                        std::unique_lock<std::mutex> &lock) {
+  counter->idle.wait(lock, [counter] { return counter->count == 0; });
+}
+
+// ============================================================================
+// 性能统计
+// ============================================================================
+
+namespace {
+
+constexpr double kStatsBucketsPerOctave = 4.0;
+
+} // namespace
+
+void onnx_histogram_record(StageHistogram *histogram, double ms) {
+  double us = ms * 1000.0;
+  int bucket = 0;
+  if (us > 1.0) {
+    bucket = (int)(std::log2(us) * kStatsBucketsPerOctave);
+    bucket = std::min(bucket, kStatsBuckets - 1);
+  }
+  histogram->counts[bucket]++;
+  histogram->samples++;
+}
+
+double onnx_histogram_percentile(const StageHistogram &histogram, double q) {
+  if (histogram.samples <= 0)
+    return 0;
+  int64_t rank = (int64_t)std::ceil(q * (double)histogram.samples);
+  rank = std::max<int64_t>(1, std::min(rank, histogram.samples));
+  int64_t seen = 0;
+  int bucket = 0;
+  for (; bucket < kStatsBuckets - 1; bucket++) {
+    seen += histogram.counts[bucket];
+    if (seen >= rank)
+      break;
+  }
+  return std::exp2((bucket + 1) / kStatsBucketsPerOctave) / 1000.0;
+}
+
+void onnx_stats_commit(ModelStats *stats) {
+  double total = 0;
+  for (int stage = 0; stage < ONNX_STAGE_TOTAL; stage++) {
+    total += stats->current_ms[stage];
+  }
+  stats->current_ms[ONNX_STAGE_TOTAL] = total;
+  for (int stage = 0; stage < ONNX_STAGE_COUNT; stage++) {
+    double ms = stats->current_ms[stage];
+    stats->last_ms[stage] = ms;
+    if (ms > 0) {
+      onnx_histogram_record(&stats->histograms[stage], ms);
+    }
+    stats->current_ms[stage] = 0;
+  }
+  stats->calls++;
+}
+
+void onnx_stats_snapshot(const ModelStats &stats, OnnxStats *out) {
+  for (int stage = 0; stage < ONNX_STAGE_COUNT; stage++) {
+    const StageHistogram &histogram = stats.histograms[stage];
+    out->last_ms[stage] = stats.last_ms[stage];
+    out->p50_ms[stage] = onnx_histogram_percentile(histogram, 0.50);
+    out->p95_ms[stage] = onnx_histogram_percentile(histogram, 0.95);
+    out->p99_ms[stage] = onnx_histogram_percentile(histogram, 0.99);
+  }
+  out->calls = stats.calls;
+  out->images = stats.images;
+  out->candidates = stats.candidates;
+  out->detections = stats.detections;
+  out->bytes_allocated = stats.bytes_allocated;
+  out->dedup_skipped = stats.dedup_skipped;
+  out->cascade_images = stats.cascade_images;
+  out->cascade_escalated = stats.cascade_escalated;
+}
+
+// ============================================================================
+// 性能分析追踪
+// ============================================================================
+
+void onnx_trace_record(std::vector<TraceSpan> *trace, const char *name,
+                       int64_t start_ns, int64_t dur_ns) {
+  if (trace->size() >= kMaxTraceSpans)
+    return;
+  trace->push_back({name, start_ns, dur_ns});
+}
+
+const char *onnx_stage_name(int stage) {
+  static const char *const kNames[ONNX_STAGE_COUNT] = {
+      "preprocess", "run", "parse", "nms", "masks", "marshal", "total"};
+  return stage >= 0 && stage < ONNX_STAGE_COUNT ? kNames[stage] : "unknown";
+}
+
+std::string onnx_merge_trace(const std::string &ort_json,
+                             const std::vector<TraceSpan> &spans,
+                             int64_t start_ns, int64_t pid) {
+  // 保留 ORT 数组内的事件，去掉首尾方括号后追加自有事件。
+  std::string body;
+  size_t open = ort_json.find('[');
+  size_t close = ort_json.rfind(']');
+  if (open != std::string::npos && close != std::string::npos &&
+      close > open) {
+    body = ort_json.substr(open + 1, close - open - 1);
+    size_t first = body.find_first_not_of(" \t\r\n");
+    size_t last = body.find_last_not_of(" \t\r\n,");
+    body = first == std::string::npos ? std::string()
+                                      : body.substr(first, last - first + 1);
+  }
+
+  std::string out = "[\n";
+  out += body;
+  char line[256];
+  // 自有事件归入独立线程轨道（tid 0），在 Perfetto 中与 ORT 内核并列显示。
+  snprintf(line, sizeof(line),
+           "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":%lld,"
+           "\"tid\":0,\"args\":{\"name\":\"onnx_inference\"}}",
+           body.empty() ? "" : ",\n", (long long)pid);
+  out += line;
+  for (const TraceSpan &span : spans) {
+    long long ts = std::max<int64_t>(0, span.start_ns - start_ns) / 1000;
+    long long dur = std::max<int64_t>(0, span.dur_ns) / 1000;
+    snprintf(line, sizeof(line),
+             ",\n{\"cat\":\"plugin\",\"pid\":%lld,\"tid\":0,"
+             "\"dur\":%lld,\"ts\":%lld,\"ph\":\"X\",\"name\":\"%s\","
+             "\"args\":{}}",
+             (long long)pid, dur, ts, span.name);
+    out += line;
+  }
+  out += "\n]\n";
+  return out;
+}
+
+size_t onnx_scratch_bytes(const DetectionScratch &scratch) {
+  const MaskScratch &mask = scratch.mask;
+  return scratch.candidates.capacity() * sizeof(Detection) +
+         (scratch.keypoints.capacity() + scratch.mask_coeffs.capacity() +
+          scratch.polygons.capacity() + mask.logits.capacity() +
+          mask.contour.capacity()) *
+             sizeof(float) +
+         mask.binary.capacity() + mask.keep.capacity() +
+         (mask.labels.capacity() + mask.stack.capacity() +
+          mask.ranges.capacity()) *
+             sizeof(int) +
+         mask.offsets.capacity() * sizeof(size_t);
+}
+
+int64_t onnx_result_bytes(const Detection *detections, int count) {
+  int64_t bytes = (int64_t)count * (int64_t)sizeof(Detection);
+  for (int i = 0; i < count; i++) {
+    if (detections[i].keypoints && detections[i].num_keypoints > 0) {
+      bytes +=
+          (int64_t)detections[i].num_keypoints * 3 * (int64_t)sizeof(float);
+    }
+    if (detections[i].polygon && detections[i].num_polygon_points > 0) {
+      bytes += (int64_t)detections[i].num_polygon_points * 2 *
+               (int64_t)sizeof(float);
+    }
+  }
+  return bytes;
+}
+
+int64_t onnx_process_rss_bytes() {
+#if defined(_WIN32)
+  PROCESS_MEMORY_COUNTERS counters;
+  if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                            sizeof(counters))) {
+    return -1;
+  }
+  return (int64_t)counters.WorkingSetSize;
+#elif defined(__APPLE__)
+  mach_task_basic_info_data_t info;
+  mach_msg_type_number_t count = MACH_TASK_BASIC_INFO_COUNT;
+  if (task_info(mach_task_self(), MACH_TASK_BASIC_INFO, (task_info_t)&info,
+                &count) != KERN_SUCCESS) {
+    return -1;
+  }
+  return (int64_t)info.resident_size;
+#else
+  // /proc/self/statm 第二列为常驻页数。
+  FILE *file = fopen("/proc/self/statm", "r");
+  if (!file) {
+    return -1;
+  }
+  long long size_pages = 0;
+  long long resident_pages = 0;
+  int read = fscanf(file, "%lld %lld", &size_pages, &resident_pages);
+  fclose(file);
+  long page_size = sysconf(_SC_PAGESIZE);
+  if (read != 2 || page_size <= 0) {
+    return -1;
+  }
+  return (int64_t)resident_pages * page_size;
+#endif
+}
+
+// ============================================================================
+// 近重复跳过
+// ============================================================================
+
+// 一行内连续像素的亮度和（BT.601 定点系数，和为 256），循环可自动向量化。
+static uint64_t row_luma_sum(const uint8_t *pixels, int count) {
+  uint32_t sum = 0;
+  for (int i = 0; i < count; i++) {
+    sum += pixels[i * 4] * 77u + pixels[i * 4 + 1] * 150u +
+           pixels[i * 4 + 2] * 29u;
+  }
+  return sum;
+}
+
+uint64_t onnx_dhash_rgba(const uint8_t *rgba, int width, int height) {
+  if (!rgba || width <= 0 || height <= 0) {
+    return 0;
+  }
+  // 每格取格内全部列、至多 4 行的亮度均值；小图的格至少包含一个像素。
+  const int kCols = 9;
+  const int kRows = 8;
+  const int kSampleRows = 4;
+  int x0[kCols], x1[kCols];
+  for (int c = 0; c < kCols; c++) {
+    x0[c] = std::min((int)((int64_t)c * width / kCols), width - 1);
+    x1[c] = std::max(x0[c] + 1, (int)((int64_t)(c + 1) * width / kCols));
+  }
+  double means[kRows][kCols];
+  for (int r = 0; r < kRows; r++) {
+    int y0 = std::min((int)((int64_t)r * height / kRows), height - 1);
+    int y1 = std::max(y0 + 1, (int)((int64_t)(r + 1) * height / kRows));
+    int rows = std::min(kSampleRows, y1 - y0);
+    uint64_t sums[kCols] = {0};
+    for (int k = 0; k < rows; k++) {
+      int y = y0 + (int)((int64_t)k * (y1 - y0) / rows);
+      // 单个像素的加权亮度不超过 65280，每段 65536 个像素时 32 位累加不溢出。
+      const uint8_t *row = rgba + (size_t)y * width * 4;
+      for (int c = 0; c < kCols; c++) {
+        for (int x = x0[c]; x < x1[c]; x += 1 << 16) {
+          int n = std::min(x1[c] - x, 1 << 16);
+          sums[c] += row_luma_sum(row + (size_t)x * 4, n);
+        }
+      }
+    }
+    for (int c = 0; c < kCols; c++) {
+      means[r][c] = (double)sums[c] / ((double)rows * (x1[c] - x0[c]));
+    }
+  }
+  uint64_t hash = 0;
+  for (int r = 0; r < kRows; r++) {
+    for (int c = 0; c < kCols - 1; c++) {
+      hash = (hash << 1) | (means[r][c] > means[r][c + 1] ? 1u : 0u);
+    }
+  }
+  return hash;
+}
+
+int onnx_hamming64(uint64_t a, uint64_t b) {
+  return (int)std::bitset<64>(a ^ b).count();
+}
+
+int onnx_plan_dedup(const uint64_t *hashes, const int *widths,
+                    const int *heights, int count, int max_distance,
+                    DedupReference *reference, int *source) {
+  int skipped = 0;
+  int last = -2; // 当前参照在本批中的位置，-2 表示 reference
+  for (int i = 0; i < count; i++) {
+    if (max_distance >= 0 && reference->valid &&
+        reference->width == widths[i] && reference->height == heights[i] &&
+        onnx_hamming64(reference->hash, hashes[i]) <= max_distance) {
+      source[i] = last;
+      skipped++;
+      continue;
+    }
+    source[i] = -1;
+    last = i;
+    reference->valid = true;
+    reference->hash = hashes[i];
+    reference->width = widths[i];
+    reference->height = heights[i];
+  }
+  return skipped;
+}
+
+bool onnx_cascade_options_valid(const OnnxCascadeOptions &options) {
+  return options.uncertain_low >= 0 &&
+         options.uncertain_low <= options.uncertain_high &&
+         options.uncertain_high <= 1 && options.min_uncertain >= 1 &&
+         options.heavy_batch_size >= 0;
+}
+
+bool onnx_cascade_should_escalate(const Detection *detections, int count,
+                                  const OnnxCascadeOptions &options) {
+  if (count <= 0) {
+    return options.escalate_empty;
+  }
+  int uncertain = 0;
+  for (int i = 0; i < count; i++) {
+    float confidence = detections[i].confidence;
+    if (confidence >= options.uncertain_low &&
+        confidence < options.uncertain_high &&
+        ++uncertain >= options.min_uncertain) {
+      return true;
+    }
+  }
+  return false;
+}
+
+void onnx_filter_result(DetectionResult *result, float conf_threshold) {
+  int kept = 0;
+  for (int i = 0; i < result->count; i++) {
+    Detection &det = result->detections[i];
+    if (det.confidence < conf_threshold) {
+      free(det.keypoints);
+      free(det.polygon);
+      continue;
+    }
+    result->detections[kept++] = det;
+  }
+  result->count = kept;
 }
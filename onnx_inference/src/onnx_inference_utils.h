@@ -8,13 +8,62 @@
 
 #include "onnx_inference.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <mutex>
+#include <string>
 #include <vector>
 
+/// YOLOv8-seg 每个候选框的掩码系数数量（与原型通道数一致）。
+constexpr int kSegMaskCoeffs = 32;
+
+/// 掩码组装暂存区（原型分辨率下的裁剪区域）。
+struct MaskScratch {
+  std::vector<float> logits;
+  std::vector<uint8_t> binary;
+  std::vector<int> labels;
+  std::vector<int> stack;
+  std::vector<float> contour;
+  std::vector<uint8_t> keep;
+  std::vector<int> ranges;
+  std::vector<size_t> offsets;
+};
+
+/// 后处理暂存区。
+///
+/// 候选框的关键点指针指向 keypoints 缓冲区，多边形指针指向 polygons。
+/// 分割模型在解析后、组装掩码前，polygon 暂存指向 mask_coeffs 的系数指针
+/// （num_polygon_points 为 0）。暂存区跨调用复用，容量只增不减，
+/// 稳态下解析、NMS 与掩码组装不产生堆分配。
+struct DetectionScratch {
+  std::vector<Detection> candidates;
+  std::vector<float> keypoints;
+  std::vector<float> mask_coeffs;
+  std::vector<float> polygons;
+  MaskScratch mask;
+};
+
+/// 分割原型输出及其与模型输入的对应关系。
+struct MaskPrototypes {
+  const float *data = nullptr; // [kSegMaskCoeffs, height, width]
+  int width = 0;
+  int height = 0;
+  int input_width = 0;         // 模型输入尺寸（原型为其等比缩小）
+  int input_height = 0;
+};
+
 /// 计算两个检测框的 IoU（使用中心点与宽高）。
 ///
 /// Detection 中的坐标为归一化中心点 (x, y) 与宽高 (w, h)。
 float onnx_iou(const Detection &a, const Detection &b);
 
+/// 计算两个旋转框的 IoU。
+///
+/// 使用 polygon 中的 4 个角点做凸多边形求交；任一检测缺少角点时退回
+/// onnx_iou。归一化坐标下的各向异性缩放不改变面积比，IoU 与像素空间一致。
+float onnx_rotated_iou(const Detection &a, const Detection &b);
+
 /// 执行按类别的非极大值抑制（NMS）。
 ///
 /// 同类别框之间 IoU 大于阈值会被抑制。
@@ -22,4 +71,314 @@ float onnx_iou(const Detection &a, const Detection &b);
 std::vector<Detection> onnx_nms(std::vector<Detection> detections,
                                 float threshold);
 
+/// 原地执行按类别的 NMS。
+///
+/// 保留的检测框按置信度降序压缩到数组前部，返回保留数量。
+/// 不分配内存。
+size_t onnx_nms_inplace(Detection *detections, size_t count, float threshold);
+
+/// 原地执行按类别的旋转框 NMS。
+///
+/// 先用角点的轴对齐包围盒估计 IoU 上界，仅在上界超过阈值时做精确多边形求交。
+/// 行为与 onnx_nms_inplace 一致（降序压缩到前部，返回保留数量）。
+size_t onnx_nms_rotated_inplace(Detection *detections, size_t count,
+                                float threshold);
+
+/// 多阈值扫描支持的 NMS 阈值数上限。
+constexpr int kMaxSweepNmsThresholds = 32;
+
+/// 一次排序、多个 NMS 阈值的按类别贪心抑制。
+///
+/// 对每个阈值的结果与 onnx_nms_inplace / onnx_nms_rotated_inplace 一致。
+/// 各阈值同时推进：候选框只与任一阈值的保留者比较，每对框的 IoU 至多计算
+/// 一次，代价接近单次 NMS。各阈值保留者的并集按置信度降序压缩到数组前部，
+/// 返回并集大小；kept[j] 为阈值 j 的保留者在并集中的下标（降序）。
+/// 贪心保留只依赖更高置信度的保留者，因此置信度阈值 c 的结果即 kept[j]
+/// 中 confidence >= c 的前缀。num_thresholds 须在 1 到 kMaxSweepNmsThresholds 之间。
+size_t onnx_nms_sweep(Detection *detections, size_t count,
+                      const float *thresholds, int num_thresholds,
+                      bool rotated, std::vector<std::vector<uint32_t>> *kept);
+
+/// 预处理图像，执行 letterbox 缩放并写入指定缓冲区。
+///
+/// @param buffer 目标缓冲区（大小必须为 3 * target_width * target_height）
+/// @param scale_x 输出：x 方向缩放比例
+/// @param scale_y 输出：y 方向缩放比例
+/// @param pad_left 输出：左侧填充像素数
+/// @param pad_top 输出：顶部填充像素数
+void preprocess_image_to_buffer(const uint8_t *image_data, int image_width,
+                                int image_height, int target_width,
+                                int target_height, float *buffer,
+                                float *scale_x, float *scale_y, int *pad_left,
+                                int *pad_top);
+
+/// 解析 YOLOv8 模型输出，将超过置信度阈值的候选框写入暂存区。
+///
+/// 输出布局为 [num_features, num_boxes]，坐标转换为原图归一化坐标。
+/// 调用会清空 scratch 中已有的候选框。分割模型的掩码系数暂存于
+/// scratch->mask_coeffs，需在 NMS 后调用 assemble_yolov8_masks。
+/// OBB 模型的最后一个特征为角度，4 个角点写入 scratch->polygons。
+void parse_yolov8_output(const float *output_data, int num_features,
+                         int num_boxes, int model_type, int num_keypoints,
+                         float conf_threshold, float scale_x, float scale_y,
+                         int pad_left, int pad_top, int image_width,
+                         int image_height, DetectionScratch *scratch);
+
+/// 解析端到端（NMS-free / 图内已含 NMS）模型输出。
+///
+/// 输出布局为 [num_rows, row_size]，每行即最终检测框，无需候选展开与 NMS。
+/// 结果写入 scratch->candidates，附加特征的存放方式与 parse_yolov8_output
+/// 一致（分割模型仍需调用 assemble_yolov8_masks）。
+void parse_end2end_output(const float *output_data, int row_size,
+                          int num_rows, int model_type, int num_keypoints,
+                          float conf_threshold, float scale_x, float scale_y,
+                          int pad_left, int pad_top, int image_width,
+                          int image_height, DetectionScratch *scratch);
+
+/// 计算裁剪区域 [x0, x1) x [y0, y1) 内的掩码 logits。
+///
+/// out[y][x] = Σ_k coeffs[k] * protos[k][y0 + y][x0 + x]，按 8 像素分块
+/// 在寄存器中累加以便编译器向量化。out 大小为 (x1 - x0) * (y1 - y0)。
+void onnx_mask_logits(const float *coeffs, const float *protos, int num_protos,
+                      int proto_width, int proto_height, int x0, int y0, int x1,
+                      int y1, float *out);
+
+/// 追踪二值掩码中最大 8 连通域的外轮廓。
+///
+/// mask 非零为前景；轮廓点为像素坐标 (x, y) 交错写入 scratch->contour。
+/// 返回轮廓点数（无前景返回 0）。
+size_t onnx_trace_mask_contour(const uint8_t *mask, int width, int height,
+                               MaskScratch *scratch);
+
+/// 对闭合多边形执行 Douglas-Peucker 简化。
+///
+/// points 为 (x, y) 交错的 count 个顶点；保留的顶点按原顺序写入 out
+/// （可与 points 相同），返回保留数量。
+size_t onnx_simplify_polygon(const float *points, size_t count, float epsilon,
+                             float *out, MaskScratch *scratch);
+
+/// 为 NMS 后保留的分割检测组装掩码并提取轮廓多边形。
+///
+/// 仅对检测框在原型分辨率下的裁剪区域计算系数×原型并以 logit > 0
+/// （sigmoid > 0.5）阈值化，提取最大连通域外轮廓，经简化后写回 polygon
+/// （原图归一化坐标，指向 scratch->polygons）。protos.data 为空时清除
+/// 暂存的系数指针。
+void assemble_yolov8_masks(Detection *detections, int count,
+                           const MaskPrototypes &protos, float scale_x,
+                           float scale_y, int pad_left, int pad_top,
+                           int image_width, int image_height, float epsilon,
+                           DetectionScratch *scratch);
+
+/// 将检测结果深拷贝到堆分配的 DetectionResult（关键点与多边形单独分配）。
+///
+/// 失败时返回 false，out 保持为空结果。
+bool onnx_copy_detections(const Detection *detections, int count,
+                          DetectionResult *out);
+
+/// 释放 DetectionResult 内部的检测、关键点与多边形缓冲区（不释放结构体本身）。
+void onnx_release_detections(DetectionResult *result);
+
+/// 将检测结果写入调用方提供的缓冲区。
+///
+/// 关键点与多边形写入 arena 并由检测框指针引用。容量不足时不写入任何检测，
+/// 设置 required_capacity / required_arena 并返回
+/// ONNX_ERROR_BUFFER_TOO_SMALL。
+int onnx_pack_result(const Detection *detections, int count,
+                     OnnxResultBuffer *out);
+
+/// 图像暂存池尺寸等级：64 KiB 起按 2 的幂递增，最大 1 GiB。
+constexpr int kImagePoolMinShift = 16;
+constexpr int kImagePoolNumClasses = 15;
+
+/// 图像暂存池。
+///
+/// 归还的缓冲区按尺寸等级缓存复用；超过最大等级的请求直接分配且不缓存。
+/// 记录自上次收缩以来的在用字节高水位，供 onnx_pool_trim 回收多余缓存。
+/// 所有操作线程安全。
+struct ImageBufferPool {
+  std::mutex mutex;
+  std::vector<uint8_t *> free_lists[kImagePoolNumClasses];
+  int64_t cached_bytes = 0;
+  int64_t in_use_bytes = 0;
+  int64_t high_water = 0;
+};
+
+/// 获取至少 size 字节的缓冲区（16 字节对齐），失败返回 nullptr。
+uint8_t *onnx_pool_acquire(ImageBufferPool *pool, int64_t size);
+
+/// 归还缓冲区（允许 nullptr）。
+void onnx_pool_release(ImageBufferPool *pool, uint8_t *buffer);
+
+/// 将缓存收缩到高水位以内并重置高水位，返回释放的字节数。
+int64_t onnx_pool_trim(ImageBufferPool *pool);
+
+/// 释放全部缓存缓冲区（在用缓冲区不受影响），返回释放的字节数。
+int64_t onnx_pool_clear(ImageBufferPool *pool);
+
+/// 进行中的后台任务计数，由调用方的互斥量保护。
+///
+/// 后台加载线程在整个生命周期内计数；onnx_cleanup 释放运行时环境前等待
+/// 归零，避免线程仍在创建会话或预热时环境被释放。
+struct InflightCounter {
+  int count = 0;
+  std::condition_variable idle;
+};
+
+/// 计数加一（调用方持有互斥量）。
+void onnx_inflight_begin(InflightCounter *counter);
+
+/// 计数减一，归零时唤醒等待方（调用方持有互斥量）。
+void onnx_inflight_end(InflightCounter *counter);
+
+/// 等待计数归零；lock 为保护计数的互斥量，等待期间释放。
+void onnx_inflight_wait(InflightCounter *counter,
+                        std::unique_lock<std::mutex> &lock);
+
+/// 耗时直方图档数：1 µs 起每档 ×2^(1/4)，覆盖约 16 秒。
+constexpr int kStatsBuckets = 96;
+
+/// 单阶段耗时的累计对数直方图。
+struct StageHistogram {
+  uint32_t counts[kStatsBuckets] = {};
+  int64_t samples = 0;
+};
+
+/// 自有阶段的追踪片段（Chrome trace 的 "X" 事件）。
+///
+/// 时间取自 high_resolution_clock 的纳秒数，与 ONNX Runtime 性能分析器同源。
+struct TraceSpan {
+  const char *name;
+  int64_t start_ns;
+  int64_t dur_ns;
+};
+
+/// 单次性能分析最多记录的片段数（超出后丢弃，与 ORT 的事件上限同量级）。
+constexpr size_t kMaxTraceSpans = 1 << 20;
+
+/// 当前追踪时钟（纳秒）。
+inline int64_t onnx_trace_now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::high_resolution_clock::now().time_since_epoch())
+      .count();
+}
+
+/// 记录一个追踪片段（达到上限后忽略）。
+void onnx_trace_record(std::vector<TraceSpan> *trace, const char *name,
+                       int64_t start_ns, int64_t dur_ns);
+
+/// 阶段名称（用于追踪事件）。
+const char *onnx_stage_name(int stage);
+
+/// 将自有片段合并进 ONNX Runtime 输出的 Chrome trace JSON 数组。
+///
+/// start_ns 为 ORT 性能分析的起点，片段时间换算为相对起点的微秒；
+/// ort_json 不是 JSON 数组（如为空）时仅输出自有片段。
+std::string onnx_merge_trace(const std::string &ort_json,
+                             const std::vector<TraceSpan> &spans,
+                             int64_t start_ns, int64_t pid);
+
+/// 模型句柄的性能统计。
+///
+/// current_ms 累计本次调用各阶段耗时，onnx_stats_commit 时归档到 last_ms 与
+/// 直方图。trace 非空时（性能分析期间）同时记录各阶段片段。
+/// 与模型句柄相同，不保证线程安全。
+struct ModelStats {
+  double current_ms[ONNX_STAGE_COUNT] = {};
+  double last_ms[ONNX_STAGE_COUNT] = {};
+  StageHistogram histograms[ONNX_STAGE_COUNT];
+  int64_t calls = 0;
+  int64_t images = 0;
+  int64_t candidates = 0;
+  int64_t detections = 0;
+  int64_t bytes_allocated = 0;
+  int64_t dedup_skipped = 0;
+  int64_t cascade_images = 0;
+  int64_t cascade_escalated = 0;
+  std::vector<TraceSpan> *trace = nullptr;
+};
+
+/// 作用域计时：析构时将耗时累加到 stats->current_ms[stage]，
+/// 性能分析期间同时记录追踪片段。
+struct StageTimer {
+  StageTimer(ModelStats *stats, int stage)
+      : stats(stats), stage(stage), start(std::chrono::steady_clock::now()),
+        trace_start_ns(stats->trace ? onnx_trace_now_ns() : 0) {}
+  ~StageTimer() {
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    stats->current_ms[stage] +=
+        std::chrono::duration<double, std::milli>(elapsed).count();
+    if (stats->trace) {
+      onnx_trace_record(
+          stats->trace, onnx_stage_name(stage), trace_start_ns,
+          std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+              .count());
+    }
+  }
+  StageTimer(const StageTimer &) = delete;
+  StageTimer &operator=(const StageTimer &) = delete;
+
+  ModelStats *stats;
+  int stage;
+  std::chrono::steady_clock::time_point start;
+  int64_t trace_start_ns;
+};
+
+/// 记录一次耗时（毫秒）。
+void onnx_histogram_record(StageHistogram *histogram, double ms);
+
+/// 估算分位数 q（0-1），返回所在档的上界（毫秒）；无样本时返回 0。
+double onnx_histogram_percentile(const StageHistogram &histogram, double q);
+
+/// 结束一次调用：计算 TOTAL，归档 current_ms 并计数。
+void onnx_stats_commit(ModelStats *stats);
+
+/// 导出统计快照。
+void onnx_stats_snapshot(const ModelStats &stats, OnnxStats *out);
+
+/// 后处理暂存区当前占用的堆容量（字节）。
+size_t onnx_scratch_bytes(const DetectionScratch &scratch);
+
+/// 深拷贝检测结果所需的堆字节数（检测数组与关键点/多边形）。
+int64_t onnx_result_bytes(const Detection *detections, int count);
+
+/// 进程当前常驻内存（字节），无法获取时返回 -1。
+int64_t onnx_process_rss_bytes();
+
+/// 9x8 灰度缩略图的差值哈希（见 onnx_image_dhash）。
+uint64_t onnx_dhash_rgba(const uint8_t *rgba, int width, int height);
+
+/// 64 位汉明距离。
+int onnx_hamming64(uint64_t a, uint64_t b);
+
+/// 近重复判定的参照图片（最近一张实际推理的图片）。
+struct DedupReference {
+  bool valid = false;
+  uint64_t hash = 0;
+  int width = 0;
+  int height = 0;
+};
+
+/// 近重复判定，按顺序与参照比较，未跳过的图片成为新的参照。
+///
+/// source[i] 为 -1 表示需要推理，-2 表示复用 reference 的结果，j >= 0 表示
+/// 复用本批第 j 张（j < i 且需要推理）的结果。reference 更新为最后一张需要
+/// 推理的图片。
+/// @return 跳过的图片数
+int onnx_plan_dedup(const uint64_t *hashes, const int *widths,
+                    const int *heights, int count, int max_distance,
+                    DedupReference *reference, int *source);
+
+/// 级联规则是否有效（0 <= low <= high <= 1，min_uncertain >= 1，
+/// heavy_batch_size >= 0）。
+bool onnx_cascade_options_valid(const OnnxCascadeOptions &options);
+
+/// 级联升级判定：置信度位于 [uncertain_low, uncertain_high) 的检测数达到
+/// min_uncertain，或无检测且 escalate_empty 时返回 true。
+bool onnx_cascade_should_escalate(const Detection *detections, int count,
+                                  const OnnxCascadeOptions &options);
+
+/// 原地删除置信度低于 conf_threshold 的检测（释放其关键点与多边形），
+/// 其余检测保持顺序。
+void onnx_filter_result(DetectionResult *result, float conf_threshold);
+
 #endif // ONNX_INFERENCE_UTILS_H
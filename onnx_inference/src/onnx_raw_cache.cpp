@@ -0,0 +1,416 @@
+/**
+ * 原始输出缓存实现
+ */
+#include "onnx_raw_cache.h"
+
+#include <atomic>
+#include <cinttypes>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#ifdef _WIN32
+#include <process.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+
+// ============================================================================
+// 内容哈希
+// ============================================================================
+
+namespace {
+
+constexpr uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+constexpr uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+constexpr uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+constexpr uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+constexpr uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+inline uint64_t rotl64(uint64_t x, int r) { return (x << r) | (x >> (64 - r)); }
+
+inline uint64_t read64(const uint8_t *p) {
+  uint64_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t read32(const uint8_t *p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t hash_round(uint64_t acc, uint64_t input) {
+  acc += input * kPrime2;
+  acc = rotl64(acc, 31);
+  return acc * kPrime1;
+}
+
+inline uint64_t merge_round(uint64_t acc, uint64_t value) {
+  acc ^= hash_round(0, value);
+  return acc * kPrime1 + kPrime4;
+}
+
+} // namespace
+
+uint64_t onnx_hash64(const void *data, size_t size, uint64_t seed) {
+  const uint8_t *p = (const uint8_t *)data;
+  const uint8_t *end = p + size;
+  uint64_t h;
+
+  if (size >= 32) {
+    uint64_t v1 = seed + kPrime1 + kPrime2;
+    uint64_t v2 = seed + kPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime1;
+    const uint8_t *limit = end - 32;
+    do {
+      v1 = hash_round(v1, read64(p));
+      v2 = hash_round(v2, read64(p + 8));
+      v3 = hash_round(v3, read64(p + 16));
+      v4 = hash_round(v4, read64(p + 24));
+      p += 32;
+    } while (p <= limit);
+    h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+    h = merge_round(h, v1);
+    h = merge_round(h, v2);
+    h = merge_round(h, v3);
+    h = merge_round(h, v4);
+  } else {
+    h = seed + kPrime5;
+  }
+
+  h += (uint64_t)size;
+  while (p + 8 <= end) {
+    h ^= hash_round(0, read64(p));
+    h = rotl64(h, 27) * kPrime1 + kPrime4;
+    p += 8;
+  }
+  if (p + 4 <= end) {
+    h ^= (uint64_t)read32(p) * kPrime1;
+    h = rotl64(h, 23) * kPrime2 + kPrime3;
+    p += 4;
+  }
+  while (p < end) {
+    h ^= (uint64_t)(*p) * kPrime5;
+    h = rotl64(h, 11) * kPrime1;
+    p++;
+  }
+
+  h ^= h >> 33;
+  h *= kPrime2;
+  h ^= h >> 29;
+  h *= kPrime3;
+  h ^= h >> 32;
+  return h;
+}
+
+bool onnx_hash_mapped_file(const std::string &path, uint64_t *out) {
+#ifdef _WIN32
+  std::ifstream file(fs::u8path(path), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  if (file.bad()) {
+    return false;
+  }
+  *out = onnx_hash64(data.data(), data.size());
+  return true;
+#else
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+  if (size == 0) {
+    close(fd);
+    *out = onnx_hash64(nullptr, 0);
+    return true;
+  }
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  // 顺序读取一遍，提示内核提前预读。
+  madvise(data, size, MADV_SEQUENTIAL);
+  *out = onnx_hash64(data, size);
+  munmap(data, size);
+  return true;
+#endif
+}
+
+// ============================================================================
+// 条目编码
+// ============================================================================
+
+namespace {
+
+constexpr uint32_t kRawCacheMagic = 0x31435252; // "RRC1"
+constexpr uint32_t kRawCacheVersion = 1;
+// 单个候选框附加数据的合理上限（防御损坏的条目）。
+constexpr int32_t kMaxRecordPoints = 1 << 12;
+
+struct RawCacheHeader {
+  uint32_t magic;
+  uint32_t version;
+  int32_t model_type;
+  int32_t num_keypoints;
+  float min_confidence;
+  int32_t count;
+};
+
+// 候选框记录，其后紧跟 num_keypoints * 3 与 num_polygon_points * 2 个 float。
+struct RawCandidateRecord {
+  int32_t class_id;
+  float confidence;
+  float x;
+  float y;
+  float width;
+  float height;
+  float angle;
+  int32_t num_keypoints;
+  int32_t num_polygon_points;
+};
+
+} // namespace
+
+bool onnx_raw_cache_supports(int model_type) {
+  return model_type == MODEL_TYPE_YOLO || model_type == MODEL_TYPE_YOLO_POSE ||
+         model_type == MODEL_TYPE_YOLO_OBB;
+}
+
+std::string onnx_raw_cache_path(const std::string &dir, uint64_t model_hash,
+                                int input_width, int input_height,
+                                uint64_t image_key) {
+  char model_dir[64];
+  char file_name[32];
+  snprintf(model_dir, sizeof(model_dir), "%016" PRIx64 "_%dx%d", model_hash,
+           input_width, input_height);
+  snprintf(file_name, sizeof(file_name), "%016" PRIx64 ".raw", image_key);
+  return (fs::u8path(dir) / model_dir / file_name).u8string();
+}
+
+void onnx_raw_cache_encode(const Detection *candidates, size_t count,
+                           int model_type, int num_keypoints,
+                           float min_confidence, std::string *out) {
+  RawCacheHeader header{kRawCacheMagic, kRawCacheVersion, model_type,
+                        num_keypoints, min_confidence, (int32_t)count};
+  out->clear();
+  out->append((const char *)&header, sizeof(header));
+  for (size_t i = 0; i < count; i++) {
+    const Detection &det = candidates[i];
+    RawCandidateRecord record;
+    record.class_id = det.class_id;
+    record.confidence = det.confidence;
+    record.x = det.x;
+    record.y = det.y;
+    record.width = det.width;
+    record.height = det.height;
+    record.angle = det.angle;
+    record.num_keypoints = det.keypoints ? det.num_keypoints : 0;
+    record.num_polygon_points = det.polygon ? det.num_polygon_points : 0;
+    out->append((const char *)&record, sizeof(record));
+    out->append((const char *)det.keypoints,
+                (size_t)record.num_keypoints * 3 * sizeof(float));
+    out->append((const char *)det.polygon,
+                (size_t)record.num_polygon_points * 2 * sizeof(float));
+  }
+}
+
+bool onnx_raw_cache_decode(const uint8_t *data, size_t size, int model_type,
+                           int num_keypoints, float conf_threshold,
+                           DetectionScratch *scratch) {
+  scratch->candidates.clear();
+  RawCacheHeader header;
+  if (!data || size < sizeof(header)) {
+    return false;
+  }
+  memcpy(&header, data, sizeof(header));
+  if (header.magic != kRawCacheMagic || header.version != kRawCacheVersion ||
+      header.model_type != model_type ||
+      (model_type == MODEL_TYPE_YOLO_POSE &&
+       header.num_keypoints != num_keypoints) ||
+      !(conf_threshold >= header.min_confidence) || header.count < 0 ||
+      (size_t)header.count > size / sizeof(RawCandidateRecord)) {
+    return false;
+  }
+
+  // 第一遍：校验边界并统计保留者所需的关键点与角点空间。
+  size_t kept = 0;
+  size_t keypoint_floats = 0;
+  size_t polygon_floats = 0;
+  size_t pos = sizeof(header);
+  for (int32_t i = 0; i < header.count; i++) {
+    RawCandidateRecord record;
+    if (size - pos < sizeof(record)) {
+      return false;
+    }
+    memcpy(&record, data + pos, sizeof(record));
+    pos += sizeof(record);
+    if (record.num_keypoints < 0 || record.num_keypoints > kMaxRecordPoints ||
+        record.num_polygon_points < 0 ||
+        record.num_polygon_points > kMaxRecordPoints) {
+      return false;
+    }
+    size_t extra = ((size_t)record.num_keypoints * 3 +
+                    (size_t)record.num_polygon_points * 2) *
+                   sizeof(float);
+    if (size - pos < extra) {
+      return false;
+    }
+    pos += extra;
+    if (record.confidence >= conf_threshold) {
+      kept++;
+      keypoint_floats += (size_t)record.num_keypoints * 3;
+      polygon_floats += (size_t)record.num_polygon_points * 2;
+    }
+  }
+
+  // 第二遍：缓冲区一次扩容到位后再写入指针。
+  scratch->candidates.reserve(kept);
+  if (scratch->keypoints.size() < keypoint_floats) {
+    scratch->keypoints.resize(keypoint_floats);
+  }
+  if (scratch->polygons.size() < polygon_floats) {
+    scratch->polygons.resize(polygon_floats);
+  }
+  float *keypoints = scratch->keypoints.data();
+  float *polygons = scratch->polygons.data();
+  pos = sizeof(header);
+  for (int32_t i = 0; i < header.count; i++) {
+    RawCandidateRecord record;
+    memcpy(&record, data + pos, sizeof(record));
+    pos += sizeof(record);
+    size_t kp_bytes = (size_t)record.num_keypoints * 3 * sizeof(float);
+    size_t poly_bytes = (size_t)record.num_polygon_points * 2 * sizeof(float);
+    if (record.confidence >= conf_threshold) {
+      Detection det{};
+      det.class_id = record.class_id;
+      det.confidence = record.confidence;
+      det.x = record.x;
+      det.y = record.y;
+      det.width = record.width;
+      det.height = record.height;
+      det.angle = record.angle;
+      if (record.num_keypoints > 0) {
+        memcpy(keypoints, data + pos, kp_bytes);
+        det.keypoints = keypoints;
+        det.num_keypoints = record.num_keypoints;
+        keypoints += record.num_keypoints * 3;
+      }
+      if (record.num_polygon_points > 0) {
+        memcpy(polygons, data + pos + kp_bytes, poly_bytes);
+        det.polygon = polygons;
+        det.num_polygon_points = record.num_polygon_points;
+        polygons += record.num_polygon_points * 2;
+      }
+      scratch->candidates.push_back(det);
+    }
+    pos += kp_bytes + poly_bytes;
+  }
+  return true;
+}
+
+// ============================================================================
+// 条目读写
+// ============================================================================
+
+bool onnx_raw_cache_store(const std::string &path, const std::string &data) {
+  static std::atomic<uint64_t> counter{0};
+  fs::path target = fs::u8path(path);
+  std::error_code error;
+  fs::create_directories(target.parent_path(), error);
+#ifdef _WIN32
+  long long pid = (long long)_getpid();
+#else
+  long long pid = (long long)getpid();
+#endif
+  // 临时文件名含进程号，多进程共享缓存目录时互不覆盖。
+  fs::path tmp = target.parent_path() /
+                 ("." + target.filename().string() + "." +
+                  std::to_string(pid) + "." +
+                  std::to_string(counter.fetch_add(1)) + ".tmp");
+  {
+    std::ofstream file(tmp, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), (std::streamsize)data.size());
+    if (!file.good()) {
+      file.close();
+      fs::remove(tmp, error);
+      return false;
+    }
+  }
+  fs::rename(tmp, target, error);
+  if (error) {
+    // 部分平台不允许覆盖，删除后重试。
+    fs::remove(target, error);
+    fs::rename(tmp, target, error);
+  }
+  if (error) {
+    fs::remove(tmp, error);
+    return false;
+  }
+  return true;
+}
+
+bool onnx_raw_cache_load(const std::string &path, int model_type,
+                         int num_keypoints, float conf_threshold,
+                         DetectionScratch *scratch) {
+  scratch->candidates.clear();
+#ifdef _WIN32
+  std::ifstream file(fs::u8path(path), std::ios::binary);
+  if (!file) {
+    return false;
+  }
+  std::string data((std::istreambuf_iterator<char>(file)),
+                   std::istreambuf_iterator<char>());
+  return onnx_raw_cache_decode((const uint8_t *)data.data(), data.size(),
+                               model_type, num_keypoints, conf_threshold,
+                               scratch);
+#else
+  int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) {
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+    close(fd);
+    return false;
+  }
+  size_t size = (size_t)st.st_size;
+  void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (data == MAP_FAILED) {
+    return false;
+  }
+  bool ok = onnx_raw_cache_decode((const uint8_t *)data, size, model_type,
+                                  num_keypoints, conf_threshold, scratch);
+  munmap(data, size);
+  return ok;
+#endif
+}
+
+size_t onnx_filter_candidates(Detection *candidates, size_t count,
+                              float conf_threshold) {
+  size_t kept = 0;
+  for (size_t i = 0; i < count; i++) {
+    if (candidates[i].confidence >= conf_threshold) {
+      candidates[kept++] = candidates[i];
+    }
+  }
+  return kept;
+}
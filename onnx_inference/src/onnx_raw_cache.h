@@ -0,0 +1,67 @@
+/**
+ * 原始输出缓存
+ *
+ * 按「模型文件哈希 + 模型输入尺寸 + 图片内容哈希」缓存 NMS 前的候选框：
+ * 以较低的置信度下限解析，按解析顺序压缩存储（关键点与旋转框角点内联）。
+ * 仅阈值变化的重复推理直接映射缓存条目，按新置信度过滤后重做 NMS，
+ * 跳过图片解码、预处理与 Run。按解析顺序过滤与以新阈值重新解析的结果一致。
+ *
+ * 目录布局：<dir>/<模型哈希>_<宽>x<高>/<图片哈希>.raw，条目原子写入，
+ * 多进程共享同一目录是安全的。分割模型的掩码依赖原型输出，不做缓存。
+ */
+#ifndef ONNX_RAW_CACHE_H
+#define ONNX_RAW_CACHE_H
+
+#include "onnx_inference_utils.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// 写入缓存时的置信度下限（本次阈值更低时取本次阈值）。
+///
+/// 查询阈值低于条目下限时视为未命中，需重新推理。
+constexpr float kRawCacheMinConfidence = 0.05f;
+
+/// 64 位内容哈希（XXH64）。
+uint64_t onnx_hash64(const void *data, size_t size, uint64_t seed = 0);
+
+/// 映射（Windows 上为读取）整个文件并计算内容哈希，失败返回 false。
+///
+/// 与对文件字节调用 onnx_hash64 的结果一致，用作模型与图片缓存键。
+bool onnx_hash_mapped_file(const std::string &path, uint64_t *out);
+
+/// 模型类型是否支持原始输出缓存（分割模型除外）。
+bool onnx_raw_cache_supports(int model_type);
+
+/// 缓存条目路径。
+std::string onnx_raw_cache_path(const std::string &dir, uint64_t model_hash,
+                                int input_width, int input_height,
+                                uint64_t image_key);
+
+/// 编码候选框（按传入顺序）。
+void onnx_raw_cache_encode(const Detection *candidates, size_t count,
+                           int model_type, int num_keypoints,
+                           float min_confidence, std::string *out);
+
+/// 解码缓存条目，置信度不低于 conf_threshold 的候选框按原顺序写入暂存区。
+///
+/// 关键点与角点指向 scratch->keypoints / scratch->polygons。格式损坏、
+/// 模型类型或关键点数不一致、conf_threshold 低于条目下限时返回 false。
+bool onnx_raw_cache_decode(const uint8_t *data, size_t size, int model_type,
+                           int num_keypoints, float conf_threshold,
+                           DetectionScratch *scratch);
+
+/// 原子写入缓存条目（先写临时文件再重命名，自动创建目录）。
+bool onnx_raw_cache_store(const std::string &path, const std::string &data);
+
+/// 映射（Windows 上为读取）并解码缓存条目；不存在或不匹配返回 false。
+bool onnx_raw_cache_load(const std::string &path, int model_type,
+                         int num_keypoints, float conf_threshold,
+                         DetectionScratch *scratch);
+
+/// 原地保留置信度不低于阈值的候选框（保持原顺序），返回保留数量。
+size_t onnx_filter_candidates(Detection *candidates, size_t count,
+                              float conf_threshold);
+
+#endif // ONNX_RAW_CACHE_H
@@ -0,0 +1,189 @@
+/**
+ * ONNX Runtime 动态加载实现
+ */
+#include "onnx_runtime_loader.h"
+
+#include <algorithm>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+// 平台库名（依次尝试）。
+#if defined(_WIN32)
+static const char *const kLibraryNames[] = {"onnxruntime.dll"};
+#elif defined(__APPLE__)
+static const char *const kLibraryNames[] = {"libonnxruntime.dylib"};
+#else
+static const char *const kLibraryNames[] = {"libonnxruntime.so",
+                                            "libonnxruntime.so.1"};
+#endif
+
+char onnx_runtime_path_separator() {
+#ifdef _WIN32
+  return ';';
+#else
+  return ':';
+#endif
+}
+
+static std::string join_path(const std::string &dir, const char *name) {
+#ifdef _WIN32
+  // LoadLibraryEx 的 LOAD_WITH_ALTERED_SEARCH_PATH 要求反斜杠。
+  const char separator = '\\';
+#else
+  const char separator = '/';
+#endif
+  if (dir.back() == '/' || dir.back() == '\\') {
+    return dir + name;
+  }
+  return dir + separator + name;
+}
+
+static void add_candidate(std::vector<std::string> *out,
+                          const std::string &candidate) {
+  if (std::find(out->begin(), out->end(), candidate) == out->end()) {
+    out->push_back(candidate);
+  }
+}
+
+// 展开一组以分隔符分隔的搜索项；as_file 时项本身也作为候选。
+static void add_entries(std::vector<std::string> *out, const std::string &paths,
+                        bool as_file) {
+  size_t start = 0;
+  while (start <= paths.size()) {
+    size_t end = paths.find(onnx_runtime_path_separator(), start);
+    if (end == std::string::npos) {
+      end = paths.size();
+    }
+    std::string entry = paths.substr(start, end - start);
+    if (!entry.empty()) {
+      for (const char *name : kLibraryNames) {
+        add_candidate(out, join_path(entry, name));
+      }
+      if (as_file) {
+        add_candidate(out, entry);
+      }
+    }
+    start = end + 1;
+  }
+}
+
+std::vector<std::string>
+onnx_runtime_candidates(const std::string &paths, const std::string &env_paths,
+                        const std::string &plugin_dir,
+                        const std::string &build_dir) {
+  std::vector<std::string> candidates;
+  add_entries(&candidates, paths, true);
+  add_entries(&candidates, env_paths, true);
+  // 目录本身可能含分隔符（如 Windows 盘符），不再拆分。
+  for (const std::string *dir : {&plugin_dir, &build_dir}) {
+    if (!dir->empty()) {
+      for (const char *name : kLibraryNames) {
+        add_candidate(&candidates, join_path(*dir, name));
+      }
+    }
+  }
+  for (const char *name : kLibraryNames) {
+    add_candidate(&candidates, name);
+  }
+  return candidates;
+}
+
+std::string onnx_runtime_module_dir() {
+  std::string path;
+#ifdef _WIN32
+  HMODULE module = nullptr;
+  if (GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS |
+                             GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                         reinterpret_cast<LPCSTR>(&onnx_runtime_module_dir),
+                         &module)) {
+    char buffer[MAX_PATH];
+    DWORD length = GetModuleFileNameA(module, buffer, MAX_PATH);
+    if (length > 0 && length < MAX_PATH) {
+      path.assign(buffer, length);
+    }
+  }
+#else
+  Dl_info info;
+  if (dladdr(reinterpret_cast<void *>(&onnx_runtime_module_dir), &info) &&
+      info.dli_fname) {
+    path = info.dli_fname;
+  }
+#endif
+  size_t slash = path.find_last_of("/\\");
+  if (slash == std::string::npos) {
+    return std::string();
+  }
+  return path.substr(0, slash);
+}
+
+bool onnx_runtime_open(const std::vector<std::string> &candidates,
+                       const char *symbol, OnnxRuntimeLibrary *out,
+                       std::string *error, const OnnxRuntimeAccept &accept) {
+  std::string last_error = "无候选路径";
+  // 能打开但不兼容的库比找不到库更能说明问题。
+  std::string rejected;
+  for (const std::string &candidate : candidates) {
+#ifdef _WIN32
+    // 带目录时按库所在目录解析其依赖（如 onnxruntime_providers_shared.dll）。
+    bool has_dir = candidate.find_first_of("/\\") != std::string::npos;
+    HMODULE handle = LoadLibraryExA(
+        candidate.c_str(), nullptr, has_dir ? LOAD_WITH_ALTERED_SEARCH_PATH : 0);
+    if (!handle) {
+      last_error = candidate + ": LoadLibrary 失败 (" +
+                   std::to_string(GetLastError()) + ")";
+      continue;
+    }
+    void *entry = reinterpret_cast<void *>(GetProcAddress(handle, symbol));
+    if (!entry) {
+      last_error = candidate + ": 未导出 " + symbol;
+      FreeLibrary(handle);
+      continue;
+    }
+    std::string reason;
+    if (accept && !accept(entry, &reason)) {
+      if (rejected.empty()) {
+        rejected = candidate + ": " + reason;
+      }
+      FreeLibrary(handle);
+      continue;
+    }
+#else
+    void *handle = dlopen(candidate.c_str(), RTLD_NOW | RTLD_LOCAL);
+    if (!handle) {
+      const char *reason = dlerror();
+      last_error = reason ? std::string(reason) : candidate + ": dlopen 失败";
+      continue;
+    }
+    void *entry = dlsym(handle, symbol);
+    if (!entry) {
+      last_error = candidate + ": 未导出 " + symbol;
+      dlclose(handle);
+      continue;
+    }
+    std::string reason;
+    if (accept && !accept(entry, &reason)) {
+      if (rejected.empty()) {
+        rejected = candidate + ": " + reason;
+      }
+      dlclose(handle);
+      continue;
+    }
+#endif
+    out->handle = reinterpret_cast<void *>(handle);
+    out->symbol = entry;
+    out->path = candidate;
+    return true;
+  }
+  if (error) {
+    *error = "已尝试 " + std::to_string(candidates.size()) + " 个候选，" +
+             (rejected.empty() ? last_error : rejected);
+  }
+  return false;
+}
@@ -0,0 +1,55 @@
+/**
+ * ONNX Runtime 动态加载
+ *
+ * 插件只在编译时依赖 ONNX Runtime 头文件：首次 onnx_init 时按搜索路径
+ * dlopen（Windows 上为 LoadLibrary）运行时库并解析 OrtGetApiBase，
+ * 找不到时在运行时报告 RUNTIME_NOT_FOUND。同一插件可搭配 CPU 或 GPU
+ * 版运行时包，应用启动时也不必等待动态链接器加载 ORT 及其依赖。
+ *
+ * 搜索顺序：onnx_set_runtime_search_paths 设置的路径、环境变量
+ * ONNX_INFERENCE_ORT_PATH、插件库所在目录、构建时找到的 ORT 库目录，
+ * 最后交给系统加载器按库名查找。每项可以是目录或库文件路径，
+ * 多项以平台路径分隔符（Windows 为 ';'，其余为 ':'）分隔。
+ */
+#ifndef ONNX_RUNTIME_LOADER_H
+#define ONNX_RUNTIME_LOADER_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+/// 环境变量名：运行时库搜索路径。
+constexpr const char *kOnnxRuntimePathEnv = "ONNX_INFERENCE_ORT_PATH";
+
+/// 已打开的运行时库（进程内不卸载，ORT 线程池可能仍在运行）。
+struct OnnxRuntimeLibrary {
+  void *handle = nullptr; // dlopen / LoadLibrary 句柄
+  void *symbol = nullptr; // 解析出的入口函数
+  std::string path;       // 实际打开的候选
+};
+
+/// 平台搜索路径分隔符。
+char onnx_runtime_path_separator();
+
+/// 按搜索顺序展开候选：每项先尝试「项/库名」，再尝试项本身，
+/// 最后为裸库名；空项与重复项跳过。
+std::vector<std::string>
+onnx_runtime_candidates(const std::string &paths, const std::string &env_paths,
+                        const std::string &plugin_dir,
+                        const std::string &build_dir);
+
+/// 插件库自身所在目录（无法获取时为空）。
+std::string onnx_runtime_module_dir();
+
+/// 校验已解析的入口（如 API 版本）；拒绝时写入原因。
+using OnnxRuntimeAccept = std::function<bool(void *symbol, std::string *reason)>;
+
+/// 依次打开候选并解析 symbol，返回首个成功且通过 accept（可为空）的库；
+/// 未导出 symbol 或被拒绝的库会被关闭，out 保持不变。
+/// 全部失败时 error 记录尝试数与失败原因（优先报告被拒绝的候选）。
+bool onnx_runtime_open(const std::vector<std::string> &candidates,
+                       const char *symbol, OnnxRuntimeLibrary *out,
+                       std::string *error,
+                       const OnnxRuntimeAccept &accept = nullptr);
+
+#endif // ONNX_RUNTIME_LOADER_H
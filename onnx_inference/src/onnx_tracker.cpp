@@ -0,0 +1,285 @@
+/**
+ * 多目标跟踪实现
+ */
+#include "onnx_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 过程噪声与观测噪声相对框尺寸的标准差（与 ByteTrack 一致）。
+constexpr float kStdPosition = 1.0f / 20.0f;
+constexpr float kStdVelocity = 1.0f / 160.0f;
+// 新轨迹的速度先验：检测器不是逐帧运行，取较宽的先验使第二次观测即可
+// 估计出速度（ByteTrack 逐帧更新，取 10 倍 kStdVelocity）。
+constexpr float kStdInitVelocity = 1.0f / 2.0f;
+constexpr float kMinSize = 1e-4f;
+
+// 坐标轴对应的框尺寸：x 与宽按宽度缩放，y 与高按高度缩放。
+float axis_scale(int axis, float width, float height) {
+  return std::max(axis % 2 == 0 ? width : height, kMinSize);
+}
+
+// 将观测框内的点平移缩放到新框，stride 为每点的浮点数（前两个为 x、y）。
+void project_points(const std::vector<float> &src, int stride,
+                    const Detection &from, const Detection &to, float *dst) {
+  float sx = from.width > 0 ? to.width / from.width : 1.0f;
+  float sy = from.height > 0 ? to.height / from.height : 1.0f;
+  for (size_t i = 0; i + stride <= src.size(); i += stride) {
+    dst[i] = to.x + (src[i] - from.x) * sx;
+    dst[i + 1] = to.y + (src[i + 1] - from.y) * sy;
+    for (int k = 2; k < stride; k++) {
+      dst[i + k] = src[i + k];
+    }
+  }
+}
+
+} // namespace
+
+OnnxTracker::OnnxTracker(const OnnxTrackerOptions &options)
+    : options_(options) {}
+
+void OnnxTracker::reset() {
+  tracks_.clear();
+  detected_ = false;
+  since_detect_ = 0;
+}
+
+void OnnxTracker::init_track(Track *track, const Detection &det) {
+  const float z[4] = {det.x, det.y, det.width, det.height};
+  for (int i = 0; i < 4; i++) {
+    float scale = axis_scale(i, det.width, det.height);
+    Axis &axis = track->axes[i];
+    axis.pos = z[i];
+    axis.vel = 0;
+    axis.p00 = 4 * (kStdPosition * scale) * (kStdPosition * scale);
+    axis.p01 = 0;
+    axis.p11 = (kStdInitVelocity * scale) * (kStdInitVelocity * scale);
+  }
+  observe(track, det);
+}
+
+void OnnxTracker::observe(Track *track, const Detection &det) {
+  track->det = det;
+  track->keypoints.assign(det.keypoints,
+                          det.keypoints ? det.keypoints + det.num_keypoints * 3
+                                        : det.keypoints);
+  track->polygon.assign(det.polygon,
+                        det.polygon ? det.polygon + det.num_polygon_points * 2
+                                    : det.polygon);
+  track->det.keypoints = nullptr;
+  track->det.polygon = nullptr;
+  track->det.num_keypoints = (int)track->keypoints.size() / 3;
+  track->det.num_polygon_points = (int)track->polygon.size() / 2;
+  track->hits++;
+  track->since_update = 0;
+  track->lost = 0;
+}
+
+void OnnxTracker::predict(Track *track) const {
+  float width = track->axes[2].pos;
+  float height = track->axes[3].pos;
+  for (int i = 0; i < 4; i++) {
+    float scale = axis_scale(i, width, height);
+    float qp = (kStdPosition * scale) * (kStdPosition * scale);
+    float qv = (kStdVelocity * scale) * (kStdVelocity * scale);
+    Axis &axis = track->axes[i];
+    axis.pos += axis.vel;
+    axis.p00 += 2 * axis.p01 + axis.p11 + qp;
+    axis.p01 += axis.p11;
+    axis.p11 += qv;
+  }
+  track->axes[2].pos = std::max(track->axes[2].pos, kMinSize);
+  track->axes[3].pos = std::max(track->axes[3].pos, kMinSize);
+  track->since_update++;
+}
+
+void OnnxTracker::correct(Track *track, const Detection &det) {
+  const float z[4] = {det.x, det.y, det.width, det.height};
+  for (int i = 0; i < 4; i++) {
+    float scale = axis_scale(i, det.width, det.height);
+    float r = (kStdPosition * scale) * (kStdPosition * scale);
+    Axis &axis = track->axes[i];
+    float innovation = z[i] - axis.pos;
+    float s = axis.p00 + r;
+    float k0 = axis.p00 / s;
+    float k1 = axis.p01 / s;
+    axis.pos += k0 * innovation;
+    axis.vel += k1 * innovation;
+    axis.p11 -= k1 * axis.p01;
+    axis.p00 *= 1 - k0;
+    axis.p01 *= 1 - k0;
+  }
+  observe(track, det);
+}
+
+float OnnxTracker::confidence(const Track &track) const {
+  float width = std::max(track.det.width, kMinSize);
+  float height = std::max(track.det.height, kMinSize);
+  float dx = track.axes[0].pos - track.det.x;
+  float dy = track.axes[1].pos - track.det.y;
+  float d2 = (dx * dx + track.axes[0].p00) / (width * width) +
+             (dy * dy + track.axes[1].p00) / (height * height);
+  return std::exp(-std::sqrt(d2));
+}
+
+Detection OnnxTracker::predicted_box(const Track &track,
+                                     std::vector<float> *quad) const {
+  Detection box = track.det;
+  box.x = track.axes[0].pos;
+  box.y = track.axes[1].pos;
+  box.width = track.axes[2].pos;
+  box.height = track.axes[3].pos;
+  box.keypoints = nullptr;
+  box.num_keypoints = 0;
+  box.polygon = nullptr;
+  box.num_polygon_points = 0;
+  // 旋转框以外推后的角点参与旋转 IoU。
+  if (quad && track.polygon.size() == 8) {
+    quad->resize(8);
+    project_points(track.polygon, 2, track.det, box, quad->data());
+    box.polygon = quad->data();
+    box.num_polygon_points = 4;
+  }
+  return box;
+}
+
+bool OnnxTracker::advance() {
+  stats_.frames++;
+  for (auto &track : tracks_) {
+    predict(&track);
+  }
+  since_detect_++;
+  bool need = !detected_ || since_detect_ >= options_.keyframe_interval;
+  if (!need) {
+    // 新轨迹尚无速度估计，下一帧再检测一次以确认运动。
+    for (const auto &track : tracks_) {
+      if (track.lost == 0 &&
+          (track.hits < 2 || confidence(track) < options_.min_confidence)) {
+        need = true;
+        stats_.forced_calls++;
+        break;
+      }
+    }
+  }
+  if (need) {
+    stats_.detector_calls++;
+  }
+  return need;
+}
+
+void OnnxTracker::update(const Detection *detections, int count) {
+  detected_ = true;
+  since_detect_ = 0;
+
+  // 同类别且 IoU 不低于阈值的候选对按 IoU 从高到低贪心匹配。
+  struct Pair {
+    float iou;
+    int track;
+    int det;
+  };
+  std::vector<Pair> pairs;
+  std::vector<float> quad;
+  for (int t = 0; t < (int)tracks_.size(); t++) {
+    Detection box = predicted_box(tracks_[t], &quad);
+    for (int d = 0; d < count; d++) {
+      if (detections[d].class_id != box.class_id) {
+        continue;
+      }
+      float iou = onnx_rotated_iou(box, detections[d]);
+      if (iou >= options_.match_iou) {
+        pairs.push_back({iou, t, d});
+      }
+    }
+  }
+  std::sort(pairs.begin(), pairs.end(), [](const Pair &a, const Pair &b) {
+    if (a.iou != b.iou) {
+      return a.iou > b.iou;
+    }
+    return a.track != b.track ? a.track < b.track : a.det < b.det;
+  });
+  std::vector<char> track_matched(tracks_.size(), 0);
+  std::vector<char> det_matched(count > 0 ? count : 0, 0);
+  for (const Pair &pair : pairs) {
+    if (track_matched[pair.track] || det_matched[pair.det]) {
+      continue;
+    }
+    track_matched[pair.track] = 1;
+    det_matched[pair.det] = 1;
+    correct(&tracks_[pair.track], detections[pair.det]);
+  }
+
+  // 未匹配的轨迹保留 max_lost 个关键帧以便重新关联，期间不输出。
+  size_t kept = 0;
+  for (size_t t = 0; t < tracks_.size(); t++) {
+    if (!track_matched[t] && ++tracks_[t].lost > options_.max_lost) {
+      continue;
+    }
+    if (kept != t) {
+      tracks_[kept] = std::move(tracks_[t]);
+    }
+    kept++;
+  }
+  tracks_.resize(kept);
+
+  for (int d = 0; d < count; d++) {
+    if (det_matched[d]) {
+      continue;
+    }
+    tracks_.emplace_back();
+    init_track(&tracks_.back(), detections[d]);
+    stats_.tracks_created++;
+  }
+}
+
+const std::vector<Detection> &OnnxTracker::current() {
+  output_.clear();
+  size_t floats = 0;
+  for (const auto &track : tracks_) {
+    if (track.lost == 0) {
+      floats += track.keypoints.size() + track.polygon.size();
+    }
+  }
+  arena_.resize(floats);
+  float *cursor = arena_.data();
+  for (const auto &track : tracks_) {
+    if (track.lost != 0) {
+      continue;
+    }
+    Detection box = track.det;
+    if (track.since_update > 0) {
+      box = predicted_box(track, nullptr);
+      // 外推中心离开画面的轨迹不输出，等待下一关键帧确认。
+      if (box.x < 0 || box.x > 1 || box.y < 0 || box.y > 1) {
+        continue;
+      }
+      box.confidence *= confidence(track);
+    }
+    if (!track.keypoints.empty()) {
+      project_points(track.keypoints, 3, track.det, box, cursor);
+      box.keypoints = cursor;
+      box.num_keypoints = (int)track.keypoints.size() / 3;
+      cursor += track.keypoints.size();
+    }
+    if (!track.polygon.empty()) {
+      project_points(track.polygon, 2, track.det, box, cursor);
+      box.polygon = cursor;
+      box.num_polygon_points = (int)track.polygon.size() / 2;
+      cursor += track.polygon.size();
+    }
+    output_.push_back(box);
+  }
+  return output_;
+}
+
+OnnxTrackerStats OnnxTracker::stats() const {
+  OnnxTrackerStats stats = stats_;
+  stats.active_tracks = 0;
+  for (const auto &track : tracks_) {
+    if (track.lost == 0) {
+      stats.active_tracks++;
+    }
+  }
+  return stats;
+}
@@ -0,0 +1,75 @@
+/**
+ * 多目标跟踪（SORT/ByteTrack 风格）
+ *
+ * 连续帧只在关键帧运行检测器，其余帧由跟踪器外推检测框：
+ * 每条轨迹的中心 x/y 与宽高各用一个匀速卡尔曼滤波器，过程噪声与观测噪声按
+ * 框尺寸缩放（位置 1/20、速度 1/160）。关联按类别相同、IoU 从高到低贪心
+ * 匹配，IoU 复用 onnx_rotated_iou（非旋转框回退到轴对齐 IoU）。
+ *
+ * 轨迹置信度为 exp(-d)，d 为外推中心相对上次观测的位移与位置标准差按框
+ * 尺寸归一化后的长度；任一活动轨迹置信度低于下限，或新轨迹尚无速度估计
+ * （下一帧再观测一次）时提前运行检测器。
+ * 外推帧的关键点与多边形按中心位移与宽高比例从上次观测平移缩放，旋转角不变。
+ */
+#ifndef ONNX_TRACKER_H
+#define ONNX_TRACKER_H
+
+#include "onnx_inference_utils.h"
+
+#include <cstdint>
+#include <vector>
+
+class OnnxTracker {
+public:
+  explicit OnnxTracker(const OnnxTrackerOptions &options);
+
+  /// 清空轨迹与帧计数（统计保留），下一帧必须运行检测器。
+  void reset();
+
+  /// 进入下一帧：外推全部轨迹，返回本帧是否需要运行检测器。
+  bool advance();
+
+  /// 以本帧检测结果更新轨迹（拷贝关键点与多边形）。
+  void update(const Detection *detections, int count);
+
+  /// 本帧输出：上次关键帧匹配到的轨迹，本帧已更新的输出观测值，其余输出
+  /// 外推框。指针指向内部缓冲区，下次调用任一成员前有效。
+  const std::vector<Detection> &current();
+
+  OnnxTrackerStats stats() const;
+
+private:
+  // 单个坐标的匀速卡尔曼滤波器（位置、速度及 2x2 协方差）。
+  struct Axis {
+    float pos = 0, vel = 0;
+    float p00 = 0, p01 = 0, p11 = 0;
+  };
+
+  struct Track {
+    Axis axes[4]; // 中心 x、中心 y、宽、高
+    Detection det; // 最近一次观测（指针无效，见 keypoints / polygon）
+    std::vector<float> keypoints;
+    std::vector<float> polygon;
+    int hits = 0;         // 累计观测次数
+    int since_update = 0; // 距最近一次观测的帧数
+    int lost = 0;         // 连续未匹配的关键帧数
+  };
+
+  void init_track(Track *track, const Detection &det);
+  // 记录观测（拷贝关键点与多边形），清零未更新帧数与丢失计数。
+  void observe(Track *track, const Detection &det);
+  void predict(Track *track) const;
+  void correct(Track *track, const Detection &det);
+  float confidence(const Track &track) const;
+  Detection predicted_box(const Track &track, std::vector<float> *quad) const;
+
+  OnnxTrackerOptions options_;
+  std::vector<Track> tracks_;
+  bool detected_ = false; // 本序列是否已运行过检测器
+  int since_detect_ = 0;
+  OnnxTrackerStats stats_{};
+  std::vector<Detection> output_;
+  std::vector<float> arena_;
+};
+
+#endif // ONNX_TRACKER_H
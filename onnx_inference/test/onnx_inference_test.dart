@@ -1,4 +1,5 @@
 import 'dart:ffi';
+import 'dart:io';
 import 'dart:typed_data';
 
 import 'package:ffi/ffi.dart';
@@ -166,7 +167,17 @@ class _FakeNativeApi {
       ..width = 0.2
       ..height = 0.1
       ..numKeypoints = 0
-      ..keypoints = Pointer<Float>.fromAddress(0);
+      ..keypoints = Pointer<Float>.fromAddress(0)
+      ..numPolygonPoints = 3
+      ..angle = 0.5;
+    final polygonPtr = calloc<Float>(6);
+    polygonPtr[0] = 0.5;
+    polygonPtr[1] = 0.6;
+    polygonPtr[2] = 0.7;
+    polygonPtr[3] = 0.6;
+    polygonPtr[4] = 0.6;
+    polygonPtr[5] = 0.75;
+    detPtr[1].polygon = polygonPtr;
 
     resultPtr.ref
       ..detections = detPtr
@@ -224,6 +235,9 @@ class _FakeNativeApi {
       if (det.keypoints.address != 0) {
         calloc.free(det.keypoints);
       }
+      if (det.polygon.address != 0) {
+        calloc.free(det.polygon);
+      }
     }
     if (detections.address != 0) {
       calloc.free(detections);
@@ -432,6 +446,11 @@ void main() {
     expect(detections.first.classId, 1);
     expect(detections.first.keypoints, isNotNull);
     expect(detections.first.keypoints!.length, 2);
+    expect(detections.first.polygon, isNull);
+    expect(detections.last.polygon!.length, 3);
+    expect(detections.last.polygon![2].y, closeTo(0.75, 1e-6));
+    expect(detections.first.angle, 0);
+    expect(detections.last.angle, closeTo(0.5, 1e-6));
   });
 
   test('detect skips work when no model is loaded', () {
@@ -476,6 +495,478 @@ void main() {
     expect(fake.freeResultCalls, 0);
   });
 
+  test('detect uses reusable buffer and grows it on overflow', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    const required = 100;
+    var intoCalls = 0;
+    var copyCalls = 0;
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      detectInto: (_, __, ___, ____, _____, ______, _______, ________, out) {
+        intoCalls += 1;
+        out.ref
+          ..count = 0
+          ..requiredCapacity = required
+          ..requiredArena = 0;
+        return 7;
+      },
+      copyLastResult: (_, out) {
+        copyCalls += 1;
+        expect(out.ref.capacity, greaterThanOrEqualTo(required));
+        for (var i = 0; i < required; i++) {
+          out.ref.detections[i]
+            ..classId = i
+            ..confidence = 0.5
+            ..numKeypoints = 0
+            ..keypoints = Pointer<Float>.fromAddress(0);
+        }
+        out.ref.count = required;
+        return 0;
+      },
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    engine.loadModel('/tmp/model.onnx');
+    addTearDown(engine.dispose);
+
+    final detections = engine.detect(Uint8List(16), 2, 2);
+    expect(intoCalls, 1);
+    expect(copyCalls, 1);
+    expect(fake.detectCalls, 0);
+    expect(detections.length, required);
+    expect(detections.last.classId, required - 1);
+  });
+
+  test('batch stream drain stops on an empty queue and throws on errors', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    // 依次返回：一条结果、队列为空；之后每次都无法写入结果。
+    final codes = [0, 8];
+    var nextCalls = 0;
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      streamCreate: (_, __, ___, ____, _____, ______) =>
+          Pointer<Void>.fromAddress(1),
+      streamPush: (_, __, ___, ____, _____) => 0,
+      streamFlush: (_) => 0,
+      streamBatchSize: (_) => 4,
+      streamNext: (_, tag, out) {
+        nextCalls += 1;
+        final code = codes.isEmpty ? 7 : codes.removeAt(0);
+        if (code == 0) {
+          tag.value = 5;
+          out.ref.detections[0]
+            ..classId = 3
+            ..confidence = 0.5
+            ..numKeypoints = 0
+            ..keypoints = Pointer<Float>.fromAddress(0);
+          out.ref.count = 1;
+        } else if (code == 7) {
+          out.ref
+            ..requiredCapacity = 1
+            ..requiredArena = 0;
+        }
+        return code;
+      },
+      streamDestroy: (_) {},
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    engine.loadModel('/tmp/model.onnx');
+    addTearDown(engine.dispose);
+
+    final stream = engine.openBatchStream()!;
+    addTearDown(stream.close);
+    final drained = stream.drain();
+    expect(drained.single.$1, 5);
+    expect(drained.single.$2.single.classId, 3);
+
+    // 扩容重试后仍失败：不能当作队列为空而丢弃结果。
+    nextCalls = 0;
+    expect(stream.drain, throwsStateError);
+    expect(nextCalls, 2);
+  });
+
+  test('detect reads pooled image buffers without copying', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    var acquireCalls = 0;
+    var releaseCalls = 0;
+    var trimCalls = 0;
+    final seen = <int>[];
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: (handle, image, w, h, conf, nms, type, kpts) {
+        seen.add(image.address);
+        return base.detect(handle, image, w, h, conf, nms, type, kpts);
+      },
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      acquireImageBuffer: (size) {
+        acquireCalls += 1;
+        return calloc<Uint8>(size);
+      },
+      releaseImageBuffer: (buffer) {
+        releaseCalls += 1;
+        calloc.free(buffer);
+      },
+      trimImageBuffers: () {
+        trimCalls += 1;
+        return 0;
+      },
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    engine.loadModel('/tmp/model.onnx');
+    addTearDown(engine.dispose);
+
+    final buffer = engine.acquireImageBuffer(16)!;
+    expect(acquireCalls, 1);
+    buffer.bytes.fillRange(0, 16, 255);
+
+    // 池缓冲区视图直接传入原生层。
+    engine.detect(buffer.bytes, 2, 2);
+    expect(seen.single, buffer.pointer.address);
+    expect(acquireCalls, 1);
+
+    // 普通数据经池缓冲区暂存并在调用后归还。
+    engine.detect(Uint8List(16), 2, 2);
+    expect(acquireCalls, 2);
+    expect(releaseCalls, 1);
+
+    engine.detectBatch([buffer.bytes, Uint8List(16)], [(2, 2), (2, 2)]);
+    expect(acquireCalls, 3);
+    expect(releaseCalls, 2);
+    expect(trimCalls, 1);
+
+    engine.releaseImageBuffer(buffer);
+    expect(releaseCalls, 3);
+  });
+
+  test('getStats decodes native stats and resetStats forwards', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    var resetCalls = 0;
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      getStats: (handle, out) {
+        out.ref
+          ..calls = 3
+          ..images = 5
+          ..candidates = 120
+          ..detections = 9
+          ..bytesAllocated = 4096
+          ..dedupSkipped = 2
+          ..cascadeImages = 5
+          ..cascadeEscalated = 1;
+        out.ref.lastMs[OnnxStage.run.index] = 12.5;
+        out.ref.p95Ms[OnnxStage.total.index] = 20.0;
+        return 0;
+      },
+      resetStats: (handle) => resetCalls += 1,
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    expect(engine.getStats(), isNull);
+
+    engine.loadModel('/tmp/model.onnx');
+    addTearDown(engine.dispose);
+
+    final stats = engine.getStats()!;
+    expect(stats.calls, 3);
+    expect(stats.images, 5);
+    expect(stats.candidates, 120);
+    expect(stats.detections, 9);
+    expect(stats.bytesAllocated, 4096);
+    expect(stats.dedupSkipped, 2);
+    expect(stats.cascadeImages, 5);
+    expect(stats.cascadeEscalated, 1);
+    expect(stats.stages[OnnxStage.run]!.lastMs, 12.5);
+    expect(stats.stages[OnnxStage.total]!.p95Ms, 20.0);
+    expect(stats.stages.length, OnnxStage.values.length);
+
+    engine.resetStats();
+    expect(resetCalls, 1);
+
+    // 旧版原生库缺少统计符号时返回 null。
+    final legacy = _buildTestEngine(fake);
+    legacy.loadModel('/tmp/model.onnx');
+    addTearDown(legacy.dispose);
+    expect(legacy.getStats(), isNull);
+  });
+
+  test('startProfiling passes the trace path and stopProfiling forwards', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final paths = <String>[];
+    var stopCalls = 0;
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      startProfiling: (handle, tracePath) {
+        paths.add(tracePath.toDartString());
+        return paths.length == 1 ? 0 : 3;
+      },
+      stopProfiling: (handle) {
+        stopCalls += 1;
+        return 0;
+      },
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    expect(engine.startProfiling('/tmp/trace.json'), isFalse);
+
+    engine.loadModel('/tmp/model.onnx');
+    addTearDown(engine.dispose);
+
+    expect(engine.startProfiling('/tmp/trace.json'), isTrue);
+    expect(paths, ['/tmp/trace.json']);
+    expect(engine.startProfiling('/tmp/again.json'), isFalse);
+    expect(engine.stopProfiling(), isTrue);
+    expect(stopCalls, 1);
+
+    // 旧版原生库缺少分析符号时返回 false。
+    final legacy = _buildTestEngine(fake);
+    legacy.loadModel('/tmp/model.onnx');
+    addTearDown(legacy.dispose);
+    expect(legacy.startProfiling('/tmp/trace.json'), isFalse);
+    expect(legacy.stopProfiling(), isFalse);
+  });
+
+  test('initialize forwards threading options', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final received = <String>[];
+    var plainInits = 0;
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: () {
+        plainInits += 1;
+        return true;
+      },
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      initWithOptions: (options) {
+        final ref = options.ref;
+        final affinity = ref.intraOpAffinity.address == 0
+            ? null
+            : ref.intraOpAffinity.toDartString();
+        received.add('${ref.useGlobalThreadPools} ${ref.allowSpinning} '
+            '${ref.intraOpThreads} ${ref.interOpThreads} $affinity');
+        return ref.useGlobalThreadPools;
+      },
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    addTearDown(engine.dispose);
+
+    expect(
+      engine.initialize(
+        options: const OnnxInitOptions(
+          useGlobalThreadPools: true,
+          allowSpinning: false,
+          intraOpThreads: 4,
+          intraOpAffinity: '1;2;3',
+        ),
+      ),
+      isTrue,
+    );
+    expect(received, ['true false 4 0 1;2;3']);
+    expect(engine.isInitialized, isTrue);
+
+    // 不带选项时沿用已初始化的环境。
+    expect(engine.initialize(), isTrue);
+    expect(plainInits, 0);
+
+    // 模式不一致由原生层拒绝。
+    expect(engine.initialize(options: const OnnxInitOptions()), isFalse);
+    expect(received.last, 'false true 0 0 null');
+  });
+
+  test('loadModel forwards load options and memory calls', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final loaded = <String>[];
+    var trimCalls = 0;
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      loadModelWithOptions: (path, options) {
+        final ref = options.ref;
+        loaded.add('${ref.useGpu} ${ref.enableCpuArena} '
+            '${ref.enableMemPattern} ${ref.arenaExtendStrategy} '
+            '${ref.arenaInitialChunkBytes}');
+        return base.loadModel(path, ref.useGpu);
+      },
+      getMemoryUsage: (handle, out) {
+        out.ref
+          ..arenaReservedBytes = 64 << 20
+          ..arenaInUseBytes = 1 << 20
+          ..pluginReservedBytes = 4096
+          ..processRssBytes = -1
+          ..arenaTrimmedBytes = trimCalls << 20;
+        return 0;
+      },
+      trimMemory: (handle) {
+        trimCalls += 1;
+        return 0;
+      },
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    expect(engine.getMemoryUsage(), isNull);
+    expect(engine.trimMemory(), isFalse);
+
+    // 不带选项时走原有加载路径。
+    expect(engine.loadModel('/tmp/model.onnx'), isTrue);
+    expect(loaded, isEmpty);
+    addTearDown(engine.dispose);
+
+    expect(
+      engine.loadModel(
+        '/tmp/model.onnx',
+        useGpu: true,
+        options: const OnnxLoadOptions(
+          enableMemPattern: false,
+          arenaExtendStrategy: OnnxArenaExtendStrategy.sameAsRequested,
+          arenaInitialChunkBytes: 1 << 20,
+        ),
+      ),
+      isTrue,
+    );
+    expect(loaded, ['true true false 1 1048576']);
+
+    final usage = engine.getMemoryUsage()!;
+    expect(usage.arenaReservedBytes, 64 << 20);
+    expect(usage.arenaInUseBytes, 1 << 20);
+    expect(usage.pluginReservedBytes, 4096);
+    expect(usage.processRssBytes, isNull);
+
+    expect(usage.arenaTrimmedBytes, 0);
+
+    expect(engine.trimMemory(), isTrue);
+    expect(trimCalls, 1);
+    expect(engine.getMemoryUsage()!.arenaTrimmedBytes, 1 << 20);
+
+    // 旧版原生库缺少符号时忽略选项。
+    final legacy = _buildTestEngine(fake);
+    expect(
+      legacy.loadModel(
+        '/tmp/model.onnx',
+        options: const OnnxLoadOptions(enableCpuArena: false),
+      ),
+      isTrue,
+    );
+    addTearDown(legacy.dispose);
+    expect(legacy.getMemoryUsage(), isNull);
+    expect(legacy.trimMemory(), isFalse);
+  });
+
   test('detectBatch validates sizes and returns batch results', () {
     final fake = _FakeNativeApi();
     addTearDown(fake.dispose);
@@ -582,4 +1073,585 @@ void main() {
     expect(engine.getAvailableProviders(),
         'CPUExecutionProvider,CUDAExecutionProvider');
   });
+
+  test('OnnxDaemonClient forwards requests and reads batch results', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final calls = <String>[];
+    final base = _buildBindings(fake);
+    OnnxBindings withClient({required bool connects}) => OnnxBindings(
+          init: base.init,
+          cleanup: base.cleanup,
+          loadModel: base.loadModel,
+          unloadModel: base.unloadModel,
+          getInputSize: base.getInputSize,
+          detect: base.detect,
+          detectBatch: base.detectBatch,
+          freeResult: base.freeResult,
+          freeBatchResult: base.freeBatchResult,
+          getVersion: base.getVersion,
+          isGpuAvailable: base.isGpuAvailable,
+          getGpuInfo: base.getGpuInfo,
+          getAvailableProviders: base.getAvailableProviders,
+          getLastError: base.getLastError,
+          getLastErrorCode: base.getLastErrorCode,
+          clientConnect: (socketPath) {
+            final path =
+                socketPath.address == 0 ? null : socketPath.toDartString();
+            calls.add('connect $path');
+            return Pointer<Void>.fromAddress(connects ? 0x2 : 0);
+          },
+          clientLoadModel: (client, modelPath, useGpu) {
+            calls.add('load ${modelPath.toDartString()} $useGpu');
+            return 0;
+          },
+          clientDetectBatch: (client, images, numImages, widths, heights,
+              conf, nms, modelType, numKeypoints) {
+            calls.add('detect $numImages ${widths[0]}x${heights[0]} '
+                '$modelType $numKeypoints');
+            return fake.detectBatch(client, images, numImages, widths,
+                heights, conf, nms, modelType, numKeypoints);
+          },
+          clientDisconnect: (client) => calls.add('disconnect'),
+        );
+
+    // 旧版原生库或守护进程未运行时无法连接。
+    expect(OnnxDaemonClient.connect(bindings: base), isNull);
+    expect(
+      OnnxDaemonClient.connect(bindings: withClient(connects: false)),
+      isNull,
+    );
+    expect(calls, ['connect null']);
+    calls.clear();
+
+    final client = OnnxDaemonClient.connect(
+      socketPath: '/tmp/test.sock',
+      bindings: withClient(connects: true),
+    )!;
+    expect(client.isConnected, isTrue);
+
+    // 未加载模型时不发送请求。
+    expect(client.detect(Uint8List(16), 2, 2), isEmpty);
+    expect(client.loadModel('/tmp/model.onnx', useGpu: true), isTrue);
+    expect(client.hasModel, isTrue);
+
+    final batch = client.detectBatch(
+      [Uint8List(16), Uint8List(16)],
+      [(2, 2), (2, 2)],
+      modelType: ModelType.yoloPose,
+    );
+    expect(batch.length, 2);
+    expect(batch.first.single.keypoints!.length, 1);
+    expect(batch.last.single.classId, 1);
+    expect(fake.freeBatchResultCalls, 1);
+
+    client.close();
+    client.close();
+    expect(client.isConnected, isFalse);
+    expect(calls, [
+      'connect /tmp/test.sock',
+      'load /tmp/model.onnx true',
+      'detect 2 2x2 1 17',
+      'disconnect',
+    ]);
+  });
+
+  test('raw cache hashes keys, forwards keyed batches and cached lookups', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final calls = <String>[];
+    final base = _buildBindings(fake);
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      hashBytes: (data, size) => size == 0 ? 0 : data[0] * 1000 + size,
+      enableRawCache: (handle, dir) {
+        calls.add('enable ${dir.address == 0 ? null : dir.toDartString()}');
+        return 0;
+      },
+      detectCached: (handle, key, conf, nms, modelType, numKeypoints) {
+        calls.add('cached $key');
+        // 奇数键视为未命中。
+        return key.isOdd
+            ? Pointer<NativeDetectionResult>.fromAddress(0)
+            : fake.detect(handle, nullptr, 0, 0, conf, nms, modelType,
+                numKeypoints);
+      },
+      detectBatchKeyed: (handle, images, keys, numImages, widths, heights,
+          conf, nms, modelType, numKeypoints) {
+        calls.add('keyed ${keys[0]},${keys[1]}');
+        return fake.detectBatch(handle, images, numImages, widths, heights,
+            conf, nms, modelType, numKeypoints);
+      },
+    );
+
+    // 旧版原生库：不支持缓存，带键批量退化为普通批量。
+    final legacy = OnnxInference.forTesting(base);
+    expect(legacy.loadModel('/tmp/model.onnx'), isTrue);
+    expect(legacy.supportsRawCache, isFalse);
+    expect(legacy.hashBytes(Uint8List(4)), isNull);
+    expect(legacy.enableRawCache('/tmp/cache'), isFalse);
+    expect(legacy.detectCached(2), isNull);
+    expect(legacy.detectBatchKeyed([1], [Uint8List(16)], [(2, 2)]).length, 1);
+    expect(fake.detectBatchCalls, 1);
+
+    final engine = OnnxInference.forTesting(bindings);
+    // 未加载模型时不启用。
+    expect(engine.enableRawCache('/tmp/cache'), isFalse);
+    expect(engine.loadModel('/tmp/model.onnx'), isTrue);
+    expect(engine.hashBytes(Uint8List.fromList([7, 1, 2])), 7003);
+    expect(engine.enableRawCache('/tmp/cache'), isTrue);
+
+    expect(engine.detectCached(3), isNull);
+    final hit = engine.detectCached(4)!;
+    expect(hit.length, 2);
+    expect(hit.first.keypoints!.length, 2);
+    expect(fake.freeResultCalls, 1);
+
+    final batch = engine.detectBatchKeyed(
+      [10, 12],
+      [Uint8List(16), Uint8List(16)],
+      [(2, 2), (2, 2)],
+    );
+    expect(batch.length, 2);
+    expect(fake.detectBatchCalls, 2);
+    expect(
+      () => engine.detectBatchKeyed([1], [Uint8List(16), Uint8List(16)],
+          [(2, 2), (2, 2)]),
+      throwsArgumentError,
+    );
+
+    expect(engine.enableRawCache(null), isTrue);
+    expect(calls, [
+      'enable /tmp/cache',
+      'cached 3',
+      'cached 4',
+      'keyed 10,12',
+      'enable null',
+    ]);
+  });
+
+  test('detectSweep forwards threshold grids and frees the result', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final base = _buildBindings(fake);
+    List<double>? sweptConf;
+    List<double>? sweptNms;
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      detectSweep: (handle, image, width, height, conf, numConf, nms, numNms,
+          modelType, numKeypoints) {
+        sweptConf = conf.asTypedList(numConf).toList();
+        sweptNms = nms.asTypedList(numNms).toList();
+        return fake.detectBatch(handle, nullptr, numConf * numNms, nullptr,
+            nullptr, 0, 0, modelType, numKeypoints);
+      },
+    );
+
+    // 旧版原生库不支持扫描。
+    final legacy = OnnxInference.forTesting(base);
+    expect(legacy.loadModel('/tmp/model.onnx'), isTrue);
+    expect(legacy.supportsSweep, isFalse);
+    expect(
+      legacy.detectSweep(Uint8List(16), 2, 2,
+          confThresholds: [0.25], nmsThresholds: [0.45]),
+      isNull,
+    );
+
+    final engine = OnnxInference.forTesting(bindings);
+    expect(engine.supportsSweep, isTrue);
+    // 未加载模型时不扫描。
+    expect(
+      engine.detectSweep(Uint8List(16), 2, 2,
+          confThresholds: [0.25], nmsThresholds: [0.45]),
+      isNull,
+    );
+    expect(engine.loadModel('/tmp/model.onnx'), isTrue);
+    final sweep = engine.detectSweep(
+      Uint8List(16),
+      2,
+      2,
+      confThresholds: [0.25, 0.5, 0.75],
+      nmsThresholds: [0.5, 0.75],
+    )!;
+    expect(sweptConf, [0.25, 0.5, 0.75]);
+    expect(sweptNms, [0.5, 0.75]);
+    expect(sweep.results.length, 6);
+    expect(sweep.at(2, 1), same(sweep.results[5]));
+    expect(sweep.at(1, 1).single.classId, 3);
+    expect(fake.freeBatchResultCalls, 1);
+  });
+
+  test('hashFiles marshals paths and maps unreadable files to null', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final base = _buildBindings(fake);
+    final seen = <String>[];
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      hashFiles: (paths, count, hashes, ok) {
+        var succeeded = 0;
+        for (var i = 0; i < count; i++) {
+          final path = paths[i].toDartString();
+          seen.add(path);
+          final readable = !path.endsWith('missing.jpg');
+          hashes[i] = readable ? path.length : 0;
+          ok[i] = readable ? 1 : 0;
+          if (readable) succeeded++;
+        }
+        return succeeded;
+      },
+    );
+
+    // 旧版原生库不支持文件哈希。
+    expect(OnnxInference.forTesting(base).hashFiles(['/a.jpg']), isNull);
+
+    // 无需加载模型。
+    final engine = OnnxInference.forTesting(bindings);
+    expect(engine.hashFiles(const []), isEmpty);
+    expect(
+      engine.hashFiles(['/img/a.jpg', '/img/missing.jpg', '/img/bb.jpg']),
+      [10, null, 11],
+    );
+    expect(seen, ['/img/a.jpg', '/img/missing.jpg', '/img/bb.jpg']);
+  });
+
+  test('setDedupDistance forwards the distance and maps null to off', () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final base = _buildBindings(fake);
+    final distances = <int>[];
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      setDedup: (handle, maxDistance) {
+        distances.add(maxDistance);
+        return maxDistance > 64 ? 2 : 0;
+      },
+    );
+
+    // 旧版原生库不支持近重复跳过。
+    final legacy = OnnxInference.forTesting(base);
+    expect(legacy.loadModel('/tmp/model.onnx'), isTrue);
+    addTearDown(legacy.dispose);
+    expect(legacy.setDedupDistance(4), isFalse);
+
+    final engine = OnnxInference.forTesting(bindings);
+    // 未加载模型时不设置。
+    expect(engine.setDedupDistance(4), isFalse);
+    expect(engine.loadModel('/tmp/model.onnx'), isTrue);
+    addTearDown(engine.dispose);
+    expect(engine.setDedupDistance(4), isTrue);
+    expect(engine.setDedupDistance(null), isTrue);
+    expect(engine.setDedupDistance(65), isFalse);
+    expect(distances, [4, -1, 65]);
+  });
+
+  test('detectBatchCascade passes both handles and options to the native API',
+      () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final base = _buildBindings(fake);
+    final calls = <(int, int, double, int, bool, int)>[];
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      // 重模型返回不同的句柄以区分两个模型。
+      loadModel: (path, useGpu) => Pointer<Void>.fromAddress(
+        path.toDartString().contains('heavy') ? 0x2 : 0x1,
+      ),
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      detectBatchCascade: (fast, heavy, images, numImages, widths, heights,
+          conf, nms, modelType, numKeypoints, options) {
+        calls.add((
+          fast.address,
+          heavy.address,
+          options.ref.uncertainLow,
+          options.ref.minUncertain,
+          options.ref.escalateEmpty,
+          options.ref.heavyBatchSize,
+        ));
+        return fake.detectBatch(fast, images, numImages, widths, heights, conf,
+            nms, modelType, numKeypoints);
+      },
+    );
+
+    final images = [Uint8List(4), Uint8List(4)];
+    const sizes = [(1, 1), (1, 1)];
+
+    // 旧版原生库不支持级联：无法加载重模型，回退到普通批量推理。
+    final legacy = OnnxInference.forTesting(base);
+    addTearDown(legacy.dispose);
+    expect(legacy.supportsCascade, isFalse);
+    expect(legacy.loadModel('/tmp/fast.onnx'), isTrue);
+    expect(legacy.loadCascadeModel('/tmp/heavy.onnx'), isFalse);
+    expect(legacy.detectBatchCascade(images, sizes).length, 2);
+    expect(fake.detectBatchCalls, 1);
+
+    final engine = OnnxInference.forTesting(bindings);
+    expect(engine.supportsCascade, isTrue);
+    expect(engine.loadModel('/tmp/fast.onnx'), isTrue);
+    // 未加载重模型时回退到普通批量推理。
+    expect(engine.detectBatchCascade(images, sizes).length, 2);
+    expect(calls, isEmpty);
+    expect(fake.detectBatchCalls, 2);
+
+    expect(engine.loadCascadeModel('/tmp/heavy.onnx'), isTrue);
+    final results = engine.detectBatchCascade(
+      images,
+      sizes,
+      options: const OnnxCascadeOptions(
+        uncertainLow: 0.2,
+        minUncertain: 2,
+        escalateEmpty: false,
+        heavyBatchSize: 8,
+      ),
+    );
+    expect(results.length, 2);
+    expect(results[1].single.classId, 1);
+    expect(calls.length, 1);
+    expect(calls.single.$1, 0x1);
+    expect(calls.single.$2, 0x2);
+    expect(calls.single.$3, closeTo(0.2, 1e-6));
+    expect(calls.single.$4, 2);
+    expect(calls.single.$5, isFalse);
+    expect(calls.single.$6, 8);
+
+    // 卸载重模型后回退，重模型句柄单独释放。
+    final unloads = fake.unloadCalls;
+    engine.unloadCascadeModel();
+    expect(fake.unloadCalls, unloads + 1);
+    expect(fake.lastHandle!.address, 0x2);
+    engine.detectBatchCascade(images, sizes);
+    expect(calls.length, 1);
+    engine.unloadCascadeModel();
+    expect(fake.unloadCalls, unloads + 1);
+  });
+
+  test('setRuntimeSearchPaths joins paths and runtimePath maps empty to null',
+      () {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final base = _buildBindings(fake);
+    final searched = <String>[];
+    var loaded = ''.toNativeUtf8();
+    addTearDown(() => calloc.free(loaded));
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      setRuntimeSearchPaths: (paths) {
+        searched.add(paths.toDartString());
+        return loaded.toDartString().isEmpty;
+      },
+      getRuntimePath: () => loaded,
+    );
+
+    // 旧版原生库不支持设置搜索路径。
+    final legacy = OnnxInference.forTesting(base);
+    addTearDown(legacy.dispose);
+    expect(legacy.setRuntimeSearchPaths(['/opt/ort']), isFalse);
+    expect(legacy.runtimePath, isNull);
+
+    final engine = OnnxInference.forTesting(bindings);
+    addTearDown(engine.dispose);
+    expect(engine.runtimePath, isNull);
+    expect(engine.setRuntimeSearchPaths(['/opt/ort-gpu', '/opt/ort']), isTrue);
+    expect(engine.setRuntimeSearchPaths(const []), isTrue);
+    final separator = Platform.isWindows ? ';' : ':';
+    expect(searched, ['/opt/ort-gpu$separator/opt/ort', '']);
+
+    // 运行时库加载后不再接受搜索路径。
+    calloc.free(loaded);
+    loaded = '/opt/ort-gpu/libonnxruntime.so'.toNativeUtf8();
+    expect(engine.runtimePath, '/opt/ort-gpu/libonnxruntime.so');
+    expect(engine.setRuntimeSearchPaths(['/opt/ort']), isFalse);
+  });
+
+  test('loadModelAsync swaps handles once the background load finishes',
+      () async {
+    final fake = _FakeNativeApi();
+    addTearDown(fake.dispose);
+
+    final base = _buildBindings(fake);
+    // 加载句柄地址 -> 剩余未完成的轮询次数（-1 表示永不完成）。
+    final pending = <int, int>{};
+    final paths = <int, String>{};
+    final cancelled = <String>[];
+    var nextLoad = 0x100;
+    final bindings = OnnxBindings(
+      init: base.init,
+      cleanup: base.cleanup,
+      loadModel: base.loadModel,
+      unloadModel: base.unloadModel,
+      getInputSize: base.getInputSize,
+      detect: base.detect,
+      detectBatch: base.detectBatch,
+      freeResult: base.freeResult,
+      freeBatchResult: base.freeBatchResult,
+      getVersion: base.getVersion,
+      isGpuAvailable: base.isGpuAvailable,
+      getGpuInfo: base.getGpuInfo,
+      getAvailableProviders: base.getAvailableProviders,
+      getLastError: base.getLastError,
+      getLastErrorCode: base.getLastErrorCode,
+      loadModelAsync: (path, options) {
+        final name = path.toDartString();
+        if (name.isEmpty) return nullptr;
+        final load = nextLoad++;
+        paths[load] = name;
+        pending[load] = name.contains('slow') ? -1 : 2;
+        expect(options.ref.useGpu, name.contains('gpu'));
+        return Pointer<Void>.fromAddress(load);
+      },
+      loadModelDone: (load) {
+        final left = pending[load.address]!;
+        if (left <= 0) return left == 0 ? 1 : 0;
+        pending[load.address] = left - 1;
+        return 0;
+      },
+      loadModelFinish: (load) {
+        final name = paths.remove(load.address)!;
+        return Pointer<Void>.fromAddress(name.contains('bad') ? 0 : 0x2);
+      },
+      loadModelCancel: (load) => cancelled.add(paths.remove(load.address)!),
+    );
+
+    // 旧版原生库不支持后台加载：退回同步加载。
+    final legacy = OnnxInference.forTesting(base);
+    addTearDown(legacy.dispose);
+    expect(await legacy.loadModelAsync('/tmp/model.onnx'), isTrue);
+    expect(fake.lastModelPath, '/tmp/model.onnx');
+
+    final engine = OnnxInference.forTesting(bindings);
+    addTearDown(engine.dispose);
+    expect(engine.loadModel('/tmp/old.onnx'), isTrue);
+    final unloads = fake.unloadCalls;
+
+    // 加载期间旧模型仍可推理，完成后替换并卸载旧句柄。
+    final swap = engine.loadModelAsync(
+      '/tmp/gpu.onnx',
+      useGpu: true,
+      pollInterval: Duration.zero,
+    );
+    expect(engine.isLoadingAsync, isTrue);
+    expect(engine.hasModel, isTrue);
+    expect(engine.detectBatch([Uint8List(4)], const [(1, 1)]).length, 1);
+    expect(fake.unloadCalls, unloads);
+    expect(await swap, isTrue);
+    expect(engine.isLoadingAsync, isFalse);
+    expect(fake.unloadCalls, unloads + 1);
+    expect(fake.lastHandle!.address, 0x1);
+
+    // 加载失败时保留当前模型。
+    expect(
+      await engine.loadModelAsync('/tmp/bad.onnx', pollInterval: Duration.zero),
+      isFalse,
+    );
+    expect(engine.hasModel, isTrue);
+    expect(fake.unloadCalls, unloads + 1);
+
+    // 新的加载放弃未完成的加载。
+    final slow =
+        engine.loadModelAsync('/tmp/slow.onnx', pollInterval: Duration.zero);
+    final replacement =
+        engine.loadModelAsync('/tmp/next.onnx', pollInterval: Duration.zero);
+    expect(cancelled, ['/tmp/slow.onnx']);
+    expect(await slow, isFalse);
+    expect(await replacement, isTrue);
+    expect(fake.unloadCalls, unloads + 2);
+    expect(fake.lastHandle!.address, 0x2);
+
+    // 卸载同样放弃未完成的加载。
+    final abandoned =
+        engine.loadModelAsync('/tmp/slow.onnx', pollInterval: Duration.zero);
+    engine.unloadModel();
+    expect(cancelled, ['/tmp/slow.onnx', '/tmp/slow.onnx']);
+    expect(await abandoned, isFalse);
+    expect(engine.hasModel, isFalse);
+  });
 }
@@ -0,0 +1,580 @@
+/**
+ * 无界面自动标注工具测试
+ *
+ * 期望的标签文本与应用 FileService.writeLabels 的输出逐字节一致。
+ */
+#include "label_load_cli_utils.h"
+#include "label_load_video.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifndef _WIN32
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+namespace fs = std::filesystem;
+using namespace label_load_cli;
+
+static fs::path make_temp_dir() {
+  // 每次运行使用独立目录，避免残留文件影响结果。
+  auto stamp = std::chrono::steady_clock::now().time_since_epoch().count();
+  fs::path dir = fs::temp_directory_path() /
+                 ("label_load_cli_test_" + std::to_string(stamp));
+  fs::create_directories(dir);
+  return dir;
+}
+
+static YoloLabel make_box(int class_id, double x, double y, double w,
+                          double h) {
+  YoloLabel label;
+  label.class_id = class_id;
+  label.x = x;
+  label.y = y;
+  label.width = w;
+  label.height = h;
+  return label;
+}
+
+static void test_parse_json() {
+  JsonValue root;
+  std::string error;
+  assert(parse_json(
+      "{\"a\": [1, -2.5e1, true, null], \"s\": \"x\\n\\u00e9\\ud83d\\ude00\"}",
+      &root, &error));
+  const JsonValue *a = root.get("a");
+  assert(a && a->type == JsonValue::kArray && a->items.size() == 4);
+  assert(a->items[1].number == -25.0);
+  assert(a->items[2].boolean);
+  assert(a->items[3].type == JsonValue::kNull);
+  assert(root.get("s")->string == "x\n\xc3\xa9\xf0\x9f\x98\x80");
+  assert(root.get("missing") == nullptr);
+
+  assert(!parse_json("{\"a\": }", &root, &error));
+  assert(!error.empty());
+  assert(!parse_json("[1, 2] x", &root, &error));
+}
+
+static void test_load_project() {
+  fs::path dir = make_temp_dir();
+  std::string path = (dir / "projects.json").string();
+  assert(write_file_atomic(
+      path,
+      "[{\"id\": \"p1\", \"name\": \"first\", \"imagePath\": \"/img\","
+      " \"labelPath\": \"/lbl\", \"labelDefinitions\": ["
+      "{\"name\": \"a\", \"color\": 0, \"type\": 2},"
+      "{\"classId\": 7, \"name\": \"b\", \"color\": 0, \"type\": 9}],"
+      " \"aiConfig\": {\"modelType\": 1, \"modelPath\": \"/m.onnx\","
+      " \"confidenceThreshold\": 0.5, \"nmsThreshold\": 0.6,"
+      " \"labelSaveMode\": 1, \"numKeypoints\": 17, \"classIdOffset\": 3}},"
+      "{\"id\": \"p2\", \"name\": \"second\"}]"));
+
+  ProjectSettings settings;
+  std::string error;
+  assert(load_project(path, "first", &settings, &error));
+  assert(settings.image_dir == "/img" && settings.label_dir == "/lbl");
+  assert(settings.model_path == "/m.onnx");
+  assert(settings.model_type == MODEL_TYPE_YOLO_POSE);
+  assert(settings.conf_threshold == 0.5 && settings.nms_threshold == 0.6);
+  assert(settings.save_mode == kSaveOverwrite);
+  assert(settings.num_keypoints == 17 && settings.class_id_offset == 3);
+  // 旧格式按下标回退 classId，越界类型回退为纯边界框。
+  assert(label_type_for_class(settings, 0, -1) == kLabelPolygon);
+  assert(label_type_for_class(settings, 7, -1) == kLabelBox);
+  assert(label_type_for_class(settings, 1, -1) == -1);
+
+  // 缺失字段使用 AiConfig 默认值。
+  assert(load_project(path, "p2", &settings, &error));
+  assert(settings.name == "second" && settings.model_path.empty());
+  assert(settings.conf_threshold == 0.25 && settings.nms_threshold == 0.45);
+  assert(settings.save_mode == kSaveAppend);
+
+  assert(!load_project(path, "absent", &settings, &error));
+  assert(!load_project((dir / "none.json").string(), "p1", &settings, &error));
+  fs::remove_all(dir);
+}
+
+static void test_label_from_detection() {
+  // 姿态模型：可见性按得分分档。
+  float keypoints[9] = {0.1f, 0.2f, 0.9f, 0.3f, 0.4f, 0.3f, 0.5f, 0.6f, 0.1f};
+  Detection pose{};
+  pose.class_id = 2;
+  pose.x = 0.5f;
+  pose.y = 0.5f;
+  pose.width = 0.25f;
+  pose.height = 0.5f;
+  pose.keypoints = keypoints;
+  pose.num_keypoints = 3;
+  YoloLabel label = label_from_detection(pose);
+  assert(label.class_id == 2 && label.points.size() == 3);
+  assert(label.points[0].visibility == 2);
+  assert(label.points[1].visibility == 1);
+  assert(label.points[2].visibility == 0);
+  assert(format_yolo_line(label, false) ==
+         "2 0.500000 0.500000 0.250000 0.500000 0.100000 0.200000 2 "
+         "0.300000 0.400000 1 0.500000 0.600000 0");
+
+  // 旋转框：以角点重算包围盒。
+  float corners[8] = {0.2f, 0.1f, 0.6f, 0.3f, 0.5f, 0.5f, 0.1f, 0.3f};
+  Detection obb{};
+  obb.width = 0.9f;
+  obb.height = 0.9f;
+  obb.polygon = corners;
+  obb.num_polygon_points = 4;
+  label = label_from_detection(obb);
+  assert(label.points.size() == 4 && label.points[0].visibility == 2);
+  assert(std::fabs(label.x - 0.35) < 1e-6 && std::fabs(label.y - 0.3) < 1e-6);
+  assert(std::fabs(label.width - 0.5) < 1e-6);
+  assert(std::fabs(label.height - 0.4) < 1e-6);
+  assert(label.polygon);
+
+  // 新类别的旋转框按 YOLO-OBB 四角点行写出，而不是四个关键点。
+  ProjectSettings settings;
+  std::string content = merge_label_file(nullptr, {label}, &settings);
+  assert(label_type_for_class(settings, 0, -1) == kLabelPolygon);
+  assert(content == "0 0.200000 0.100000 0.600000 0.300000 0.500000 0.500000 "
+                    "0.100000 0.300000");
+}
+
+static void test_parse_and_format_lines() {
+  YoloLabel label;
+  assert(parse_yolo_line("0 0.5 0.5 0.2 0.2", kLabelBox, &label));
+  assert(format_yolo_line(label, false) ==
+         "0 0.500000 0.500000 0.200000 0.200000");
+
+  // 纯边界框不解析关键点，尾部字段原样保留。
+  assert(parse_yolo_line("1 .5 .5 .1 .1 0.2 0.3 2", kLabelBox, &label));
+  assert(label.points.empty() && label.extra.size() == 3);
+  assert(format_yolo_line(label, false) ==
+         "1 0.500000 0.500000 0.100000 0.100000 0.2 0.3 2");
+
+  // 关键点按三元组解析，可见性四舍五入并截断到 0-2，不足一组的尾部保留。
+  assert(parse_yolo_line("1 0.5 0.5 0.1 0.1 0.2 0.3 2.6 0.4 0.5 -1 9",
+                         kLabelBoxWithPoint, &label));
+  assert(label.points.size() == 2);
+  assert(label.points[0].visibility == 2 && label.points[1].visibility == 0);
+  assert(format_yolo_line(label, false) ==
+         "1 0.500000 0.500000 0.100000 0.100000 0.200000 0.300000 2 "
+         "0.400000 0.500000 0 9");
+
+  // 多边形：包围盒由顶点计算。
+  assert(parse_yolo_line("3 0.1 0.1 0.5 0.1 0.5 0.3", kLabelPolygon, &label));
+  assert(std::fabs(label.x - 0.3) < 1e-9 && std::fabs(label.height - 0.2) < 1e-9);
+  assert(format_yolo_line(label, true) ==
+         "3 0.100000 0.100000 0.500000 0.100000 0.500000 0.300000");
+  assert(format_yolo_line(label, false) ==
+         "3 0.300000 0.200000 0.400000 0.200000 0.100000 0.100000 2 "
+         "0.500000 0.100000 2 0.500000 0.300000 2");
+
+  assert(!parse_yolo_line("x 0.5 0.5 0.1 0.1", kLabelBox, &label));
+  assert(!parse_yolo_line("0 0.5 0.5 0.1", kLabelBox, &label));
+  assert(!parse_yolo_line("0 0.5 abc 0.1 0.1", kLabelBox, &label));
+  assert(!parse_yolo_line("0 0.1 0.1 0.5 0.1", kLabelPolygon, &label));
+}
+
+static void test_merge_append() {
+  ProjectSettings settings;
+  settings.save_mode = kSaveAppend;
+  settings.class_id_offset = 10;
+  settings.label_types = {{0, kLabelBox}, {11, kLabelBox}, {12, kLabelPolygon}};
+
+  std::string existing = "0 0.5 0.5 0.2 0.2\r\n"
+                         "broken line\n"
+                         "\n"
+                         "12 0.1 0.1 0.5 0.1 0.5 0.3\n";
+  YoloLabel box = make_box(1, 0.25, 0.25, 0.1, 0.1);
+  box.points.push_back({0.2, 0.2, 2});
+  YoloLabel polygon = make_box(2, 0, 0, 0, 0);
+  polygon.points = {{0.1, 0.2, 2}, {0.3, 0.2, 2}, {0.3, 0.4, 2}};
+  std::string content =
+      merge_label_file(&existing, {box, polygon}, &settings);
+
+  // 偏移后 11 为纯边界框，关键点被清理；已有标签在前，损坏行在末尾。
+  assert(content == "0 0.500000 0.500000 0.200000 0.200000\n"
+                    "12 0.100000 0.100000 0.500000 0.100000 0.500000 "
+                    "0.300000\n"
+                    "11 0.250000 0.250000 0.100000 0.100000\n"
+                    "12 0.100000 0.200000 0.300000 0.200000 0.300000 "
+                    "0.400000\n"
+                    "broken line");
+
+  // 文件不存在且无检测时写出空文件。
+  assert(merge_label_file(nullptr, {}, &settings).empty());
+}
+
+static void test_merge_overwrite() {
+  ProjectSettings settings;
+  settings.save_mode = kSaveOverwrite;
+  settings.class_id_offset = 10; // 覆盖模式不生效
+  settings.label_types = {{0, kLabelBox}};
+
+  std::string existing = "0 0.5 0.5 0.2 0.2\nbad\n";
+  std::string content =
+      merge_label_file(&existing, {make_box(0, 0.1, 0.2, 0.3, 0.4)}, &settings);
+  assert(content == "0 0.100000 0.200000 0.300000 0.400000\nbad");
+  assert(merge_label_file(&existing, {}, &settings) == "bad");
+}
+
+static void test_fill_missing_label_types() {
+  ProjectSettings settings;
+  settings.label_types = {{0, kLabelBox}};
+  YoloLabel with_points = make_box(5, 0.5, 0.5, 0.1, 0.1);
+  with_points.points.push_back({0.5, 0.5, 2});
+  std::vector<int> added = fill_missing_label_types(
+      {make_box(3, 0.5, 0.5, 0.1, 0.1), with_points, make_box(0, 0, 0, 0, 0),
+       make_box(5, 0.5, 0.5, 0.1, 0.1)},
+      &settings);
+  assert((added == std::vector<int>{3, 5}));
+  assert(label_type_for_class(settings, 3, -1) == kLabelBox);
+  assert(label_type_for_class(settings, 5, -1) == kLabelBoxWithPoint);
+  assert(fill_missing_label_types({make_box(3, 0, 0, 0, 0)}, &settings).empty());
+}
+
+// 新项目中的分割结果：未定义的类别记为多边形，按 YOLO-seg 多边形行写出。
+static void test_merge_new_polygon_class() {
+  float contour[10] = {0.1f, 0.1f, 0.5f, 0.1f, 0.6f, 0.3f,
+                       0.5f, 0.5f, 0.1f, 0.5f};
+  Detection seg{};
+  seg.class_id = 4;
+  seg.polygon = contour;
+  seg.num_polygon_points = 5;
+  YoloLabel mask = label_from_detection(seg);
+  assert(mask.polygon);
+
+  ProjectSettings settings;
+  settings.save_mode = kSaveOverwrite;
+  std::string content = merge_label_file(nullptr, {mask}, &settings);
+  assert(label_type_for_class(settings, 4, -1) == kLabelPolygon);
+  assert(content == "4 0.100000 0.100000 0.500000 0.100000 0.600000 0.300000 "
+                    "0.500000 0.500000 0.100000 0.500000");
+
+  // 已有定义优先：关键点类别仍按边界框 + 关键点保存。
+  ProjectSettings pose;
+  pose.label_types = {{4, kLabelBoxWithPoint}};
+  content = merge_label_file(nullptr, {mask}, &pose);
+  assert(content.rfind("4 0.350000 0.300000 0.500000 0.400000 0.100000 "
+                       "0.100000 2",
+                       0) == 0);
+}
+
+static void test_images_and_journal() {
+  fs::path dir = make_temp_dir();
+  // 2x1 的 PPM 与 1x1 的 PGM；.webp 受应用支持但无法解码，.txt 忽略。
+  std::string ppm = "P6\n# comment\n2 1\n255\n";
+  ppm += std::string("\x01\x02\x03\x04\x05\x06", 6);
+  std::string pgm = "P5 1 1 255\n";
+  pgm += '\x80';
+  assert(write_file_atomic((dir / "b.ppm").string(), ppm));
+  assert(write_file_atomic((dir / "a.PGM").string(), pgm));
+  assert(write_file_atomic((dir / "c.webp").string(), "RIFF"));
+  assert(write_file_atomic((dir / "notes.txt").string(), "x"));
+
+  int skipped = -1;
+  std::vector<std::string> images = list_images(dir.string(), &skipped);
+  bool has_webp_decoder = false;
+  for (const auto &ext : decodable_extensions()) {
+    has_webp_decoder = has_webp_decoder || ext == ".webp";
+  }
+  assert(skipped == (has_webp_decoder ? 0 : 1));
+  assert(images.size() == 2);
+  assert(fs::path(images[0]).filename() == "a.PGM");
+  assert(fs::path(images[1]).filename() == "b.ppm");
+
+  RgbaImage image;
+  std::string error;
+  assert(decode_image(images[1], &image, &error));
+  assert(image.width == 2 && image.height == 1);
+  const uint8_t expected[8] = {1, 2, 3, 255, 4, 5, 6, 255};
+  assert(image.rgba == std::vector<uint8_t>(expected, expected + 8));
+  assert(decode_image(images[0], &image, &error));
+  assert(image.rgba == std::vector<uint8_t>({0x80, 0x80, 0x80, 255}));
+  assert(!decode_image((dir / "c.webp").string(), &image, &error));
+  assert(!error.empty());
+
+  // 原子写入覆盖已有文件，且不留临时文件。
+  std::string label_path = (dir / "labels" / "b.txt").string();
+  assert(write_file_atomic(label_path, "old"));
+  assert(write_file_atomic(label_path, "new"));
+  std::string content;
+  assert(read_file(label_path, &content) && content == "new");
+  int entries = 0;
+  for (const auto &entry : fs::directory_iterator(dir / "labels")) {
+    (void)entry;
+    entries++;
+  }
+  assert(entries == 1);
+
+  std::string journal = (dir / "done").string();
+  assert(write_file_atomic(journal, "a.PGM\r\n\nb.ppm\n"));
+  std::set<std::string> done = read_journal(journal);
+  assert(done.size() == 2 && done.count("a.PGM") && done.count("b.ppm"));
+  assert(read_journal((dir / "missing").string()).empty());
+  fs::remove_all(dir);
+}
+
+static std::vector<std::string> chunk_names(const std::vector<std::string> &images,
+                                            const ShardPlan &plan, int chunk) {
+  std::vector<std::string> names;
+  size_t begin = (size_t)chunk * plan.chunk_size;
+  size_t end = std::min(images.size(), begin + plan.chunk_size);
+  for (size_t i = begin; i < end; i++) {
+    names.push_back(fs::path(images[i]).filename().string());
+  }
+  return names;
+}
+
+static void test_shard_plan() {
+  int index = -1, count = -1;
+  assert(parse_shard_spec("1/4", &index, &count) && index == 1 && count == 4);
+  assert(!parse_shard_spec("4/4", &index, &count));
+  assert(!parse_shard_spec("0/0", &index, &count));
+  assert(!parse_shard_spec("1", &index, &count));
+  assert(!default_worker_id().empty());
+
+  std::vector<std::string> images = {"/data/a.jpg", "/data/b.jpg",
+                                     "/data/c.jpg"};
+  ShardPlan plan = make_shard_plan(images, 2);
+  assert(plan.chunk_count() == 2);
+  // 只取决于文件名，不同机器的挂载点可以不同。
+  assert(make_shard_plan({"/mnt/a.jpg", "/mnt/b.jpg", "/mnt/c.jpg"}, 2)
+             .list_hash == plan.list_hash);
+  assert(make_shard_plan({"/data/a.jpg", "/data/b.jpg"}, 2).list_hash !=
+         plan.list_hash);
+
+  fs::path dir = make_temp_dir();
+  std::string shards = shard_dir(dir.string());
+  std::string error;
+  assert(open_shard_plan(shards, plan, &error));
+  assert(open_shard_plan(shards, plan, &error));
+  ShardPlan other = make_shard_plan(images, 3);
+  assert(!open_shard_plan(shards, other, &error));
+  assert(!error.empty());
+  ShardPlan loaded;
+  assert(read_shard_plan(shards, &loaded));
+  assert(loaded.chunk_size == 2 && loaded.image_count == 3 &&
+         loaded.list_hash == plan.list_hash);
+  fs::remove_all(dir);
+}
+
+static void test_shard_claims() {
+  fs::path dir = make_temp_dir();
+  std::string shards = shard_dir(dir.string());
+  std::vector<std::string> images;
+  for (int i = 0; i < 5; i++) {
+    images.push_back("img_" + std::to_string(i) + ".jpg");
+  }
+  ShardPlan plan = make_shard_plan(images, 2);
+  std::string error;
+  assert(open_shard_plan(shards, plan, &error));
+
+  // 静态分片只认领自己的分块。
+  ShardWorker even(shards, "even", 3, 0, 2, 10.0);
+  ShardWorker odd(shards, "odd", 3, 1, 2, 10.0);
+  assert(odd.claim_next(0) == 1);
+  assert(odd.claim_next(0) == -1);
+  assert(odd.exhausted());
+  int first = even.claim_next(0);
+  int second = even.claim_next(0);
+  assert(first != second && (first == 0 || first == 2) &&
+         (second == 0 || second == 2));
+
+  // 分块 1 写出一张后持有者失联：未满超时不能接管，超时后接管并跳过已写出的图片。
+  std::vector<int> todo = odd.start_chunk(1, chunk_names(images, plan, 1));
+  assert(todo.size() == 2);
+  odd.finish_image(1, "img_2.jpg", true);
+  ShardWorker thief(shards, "thief", 3, 0, 0, 10.0);
+  assert(thief.claim_next(100) == -1);
+  assert(thief.claim_next(105) == -1);
+  assert(!thief.exhausted());
+  // 心跳刷新修改时间，观察者对分块 0、2 重新计时。
+  assert(even.heartbeat().empty());
+  assert(thief.claim_next(110) == 1);
+  assert(odd.holds(1));
+  assert(odd.heartbeat() == std::vector<int>({1}));
+  assert(!odd.holds(1));
+  todo = thief.start_chunk(1, chunk_names(images, plan, 1));
+  assert(todo == std::vector<int>({1}));
+  thief.finish_image(1, "img_3.jpg", true);
+  assert(!thief.holds(1));
+  assert(thief.chunks_done() == 1 && thief.images_written() == 1);
+
+  // 同一标识重启后直接接管自己的租约。
+  ShardWorker restarted(shards, "even", 3, 0, 2, 10.0);
+  assert(restarted.claim_next(0) == 0);
+  assert(restarted.start_chunk(0, chunk_names(images, plan, 0)).size() == 2);
+  restarted.finish_image(0, "img_0.jpg", true);
+  restarted.finish_image(0, "img_1.jpg", false);
+
+  ShardCoverage coverage = verify_shard_coverage(shards, images, plan);
+  assert(coverage.chunks_total == 3 && coverage.chunks_done == 2);
+  assert(coverage.written ==
+         std::vector<std::string>({"img_0.jpg", "img_2.jpg", "img_3.jpg"}));
+  assert(coverage.missing ==
+         std::vector<std::string>({"img_1.jpg", "img_4.jpg"}));
+
+  std::vector<ShardProgress> progress = read_shard_progress(shards);
+  assert(progress.size() == 2);
+  assert(progress[0].worker == "even" && progress[0].chunks_done == 0);
+  assert(progress[1].worker == "odd" && progress[1].images_written == 1);
+  fs::remove_all(dir);
+}
+
+static void test_shard_processes() {
+#ifndef _WIN32
+  // 多个进程并发认领同一任务：分块互不重叠且全部完成。
+  fs::path dir = make_temp_dir();
+  std::string shards = shard_dir(dir.string());
+  std::vector<std::string> images;
+  for (int i = 0; i < 200; i++) {
+    images.push_back("img_" + std::to_string(1000 + i) + ".jpg");
+  }
+  ShardPlan plan = make_shard_plan(images, 3);
+  const int kWorkers = 4;
+  std::vector<pid_t> children;
+  for (int w = 0; w < kWorkers; w++) {
+    pid_t pid = fork();
+    assert(pid >= 0);
+    if (pid == 0) {
+      std::string error;
+      if (!open_shard_plan(shards, plan, &error)) {
+        _exit(1);
+      }
+      std::string worker = "worker" + std::to_string(w);
+      ShardWorker shard(shards, worker, plan.chunk_count(), 0, 0, 60.0);
+      FILE *claims = fopen((dir / worker).string().c_str(), "w");
+      // 与命令行一致：暂无可认领的分块时等待其他 worker 完成。
+      while (!shard.exhausted()) {
+        int chunk = shard.claim_next(0);
+        if (chunk < 0) {
+          usleep(1000);
+          continue;
+        }
+        fprintf(claims, "%d\n", chunk);
+        std::vector<std::string> names = chunk_names(images, plan, chunk);
+        for (int i : shard.start_chunk(chunk, names)) {
+          shard.finish_image(chunk, names[i], true);
+        }
+      }
+      fclose(claims);
+      _exit(0);
+    }
+    children.push_back(pid);
+  }
+  for (pid_t pid : children) {
+    int status = 0;
+    assert(waitpid(pid, &status, 0) == pid);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+  }
+
+  std::set<int> claimed;
+  size_t total = 0;
+  for (int w = 0; w < kWorkers; w++) {
+    std::string content;
+    assert(read_file((dir / ("worker" + std::to_string(w))).string(),
+                     &content));
+    std::istringstream lines(content);
+    int chunk;
+    while (lines >> chunk) {
+      claimed.insert(chunk);
+      total++;
+    }
+  }
+  assert((int)claimed.size() == plan.chunk_count());
+  assert(total == claimed.size());
+  ShardCoverage coverage = verify_shard_coverage(shards, images, plan);
+  assert(coverage.chunks_done == plan.chunk_count());
+  assert(coverage.missing.empty() && coverage.written.size() == 200);
+  fs::remove_all(dir);
+#endif
+}
+
+static void test_video_helpers() {
+  // 按帧间隔抽帧。
+  FrameSampler stride(3, 0);
+  std::vector<int> kept;
+  for (int i = 0; i < 10; i++) {
+    if (stride.accept(i / 30.0)) {
+      kept.push_back(i);
+    }
+  }
+  assert(kept == std::vector<int>({0, 3, 6, 9}));
+  stride.reset();
+  assert(stride.accept(5.0));
+
+  // 按时间抽帧：30fps 视频每秒 2 帧，时间戳跳跃后重新计时。
+  FrameSampler fps(1, 2.0);
+  kept.clear();
+  for (int i = 0; i < 60; i++) {
+    if (fps.accept(i / 30.0)) {
+      kept.push_back(i);
+    }
+  }
+  assert(kept == std::vector<int>({0, 15, 30, 45}));
+  assert(fps.accept(10.0));
+  assert(!fps.accept(10.2));
+  assert(fps.accept(10.5));
+
+  assert(frame_file_name("/videos/cam 1.mp4", 42, "jpg") == "cam 1_000042.jpg");
+  assert(frame_file_name("a.mkv", 1234567, "bmp") == "a_1234567.bmp");
+  assert(frame_formats().back() == "bmp");
+
+  // BMP：自下而上的 BGR 行，补齐到 4 字节，可被解码器读回。
+  RgbaImage image;
+  image.width = 2;
+  image.height = 2;
+  image.rgba = {1, 2, 3, 255, 4, 5, 6, 255, 7, 8, 9, 255, 10, 11, 12, 255};
+  std::string bmp;
+  assert(encode_frame(image, "bmp", &bmp));
+  assert(bmp.size() == 54 + 8 * 2);
+  assert(bmp.compare(0, 2, "BM") == 0);
+  assert((uint8_t)bmp[54] == 9 && (uint8_t)bmp[55] == 8 &&
+         (uint8_t)bmp[56] == 7);
+  assert((uint8_t)bmp[62] == 3 && (uint8_t)bmp[63] == 2 &&
+         (uint8_t)bmp[64] == 1);
+  assert(!encode_frame(image, "webp", &bmp));
+  image.rgba.resize(4);
+  assert(!encode_frame(image, "bmp", &bmp));
+
+  fs::path dir = make_temp_dir();
+  assert(write_file_atomic((dir / "b.MP4").string(), ""));
+  assert(write_file_atomic((dir / "a.webm").string(), ""));
+  assert(write_file_atomic((dir / "c.jpg").string(), ""));
+  std::vector<std::string> videos = list_videos(dir.string());
+  assert(videos.size() == 2);
+  assert(fs::path(videos[0]).filename() == "a.webm");
+  assert(list_videos((dir / "b.MP4").string()).size() == 1);
+
+  // 测试构建不链接 FFmpeg：打开失败并给出原因。
+  std::string error;
+  assert(!VideoReader::available());
+  assert(VideoReader::open((dir / "b.MP4").string(), &error) == nullptr);
+  assert(!error.empty());
+  fs::remove_all(dir);
+}
+
+int main() {
+  test_parse_json();
+  test_load_project();
+  test_label_from_detection();
+  test_parse_and_format_lines();
+  test_merge_append();
+  test_merge_overwrite();
+  test_fill_missing_label_types();
+  test_merge_new_polygon_class();
+  test_images_and_journal();
+  test_video_helpers();
+  test_shard_plan();
+  test_shard_claims();
+  test_shard_processes();
+  std::cout << "label_load_cli_utils_test passed\n";
+  return 0;
+}
@@ -0,0 +1,336 @@
+/**
+ * 本地推理守护进程测试。
+ *
+ * 以替身后端（固定开销 + 每张图片少量开销，模拟批量推理的摊销特性）启动
+ * 服务端，经公开的 onnx_client_* 接口由多个客户端并发请求，验证结果路由、
+ * 跨客户端合批与错误路径，并输出聚合吞吐。
+ */
+#include "onnx_daemon_server.h"
+#include "onnx_inference.h"
+#include "onnx_inference_utils.h"
+
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+using namespace onnx_daemon;
+
+static std::string test_socket_path(const char *tag) {
+  return "/tmp/onnx_daemon_test_" + std::to_string((long)getpid()) + "_" +
+         tag + ".sock";
+}
+
+// 替身后端：class_id 取图片首字节，confidence 取宽度 / 1000。
+static DaemonBackend stand_in_backend() {
+  DaemonBackend backend;
+  backend.load_model = [](const std::string &path, bool use_gpu,
+                          int32_t *model_id, std::string *error) {
+    (void)use_gpu;
+    if (path.find("missing") != std::string::npos) {
+      *error = "模型文件不存在: " + path;
+      return (int)ONNX_ERROR_RUNTIME_FAILURE;
+    }
+    *model_id = 7;
+    return (int)ONNX_OK;
+  };
+  backend.detect_batch = [](const DetectParams &params, int num_images,
+                            const uint8_t **images, const int *widths,
+                            const int *heights,
+                            std::vector<std::string> *results,
+                            std::string *error) {
+    (void)heights;
+    (void)error;
+    std::this_thread::sleep_for(std::chrono::microseconds(1000 +
+                                                          50 * num_images));
+    results->assign((size_t)num_images, std::string());
+    float keypoints[3] = {0.25f, 0.5f, 1.0f};
+    for (int i = 0; i < num_images; i++) {
+      Detection det{};
+      det.class_id = images[i][0];
+      det.confidence = widths[i] / 1000.0f;
+      det.x = 0.5f;
+      det.y = 0.5f;
+      det.width = 0.1f;
+      det.height = 0.2f;
+      if (params.num_keypoints > 0) {
+        det.keypoints = keypoints;
+        det.num_keypoints = 1;
+      }
+      encode_detections(&det, 1, &(*results)[(size_t)i]);
+    }
+    return (int)ONNX_OK;
+  };
+  return backend;
+}
+
+static void test_encode_decode_roundtrip() {
+  // 编码后解码得到的检测与原值一致，且可按插件规则释放。
+  float keypoints[6] = {1, 2, 3, 4, 5, 6};
+  float polygon[8] = {0, 0, 1, 0, 1, 1, 0, 1};
+  Detection dets[2] = {};
+  dets[0].class_id = 3;
+  dets[0].confidence = 0.9f;
+  dets[0].keypoints = keypoints;
+  dets[0].num_keypoints = 2;
+  dets[1].class_id = 5;
+  dets[1].angle = 0.5f;
+  dets[1].polygon = polygon;
+  dets[1].num_polygon_points = 4;
+  std::string data;
+  encode_detections(dets, 2, &data);
+  encode_detections(nullptr, 0, &data);
+
+  size_t pos = 0;
+  DetectionResult first;
+  DetectionResult second;
+  assert(decode_detections(data, &pos, &first));
+  assert(decode_detections(data, &pos, &second));
+  assert(pos == data.size());
+  assert(first.count == 2);
+  assert(first.detections[0].class_id == 3);
+  assert(first.detections[0].num_keypoints == 2);
+  assert(first.detections[0].keypoints[5] == 6);
+  assert(first.detections[0].polygon == nullptr);
+  assert(first.detections[1].num_polygon_points == 4);
+  assert(first.detections[1].polygon[5] == 1);
+  assert(first.detections[1].angle == 0.5f);
+  assert(second.count == 0);
+  onnx_release_detections(&first);
+
+  // 截断的数据解码失败，已分配部分仍可释放。
+  std::string truncated = data.substr(0, data.size() - 12);
+  pos = 0;
+  DetectionResult broken;
+  assert(!decode_detections(truncated, &pos, &broken));
+  onnx_release_detections(&broken);
+}
+
+static void test_client_errors() {
+  // 守护进程不存在时连接失败。
+  OnnxClientHandle missing =
+      onnx_client_connect(test_socket_path("missing").c_str());
+  assert(missing == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_DAEMON_UNAVAILABLE);
+  assert(std::strlen(onnx_client_default_socket_path()) > 0);
+
+  DaemonServerOptions options;
+  options.socket_path = test_socket_path("errors");
+  DaemonServer server(options, stand_in_backend());
+  std::string error;
+  assert(server.start(&error));
+  // 同一路径不能重复监听。
+  DaemonServer duplicate(options, stand_in_backend());
+  assert(!duplicate.start(&error));
+
+  OnnxClientHandle client = onnx_client_connect(options.socket_path.c_str());
+  assert(client != nullptr);
+
+  uint8_t pixels[4 * 4 * 4] = {9};
+  const uint8_t *images[1] = {pixels};
+  int widths[1] = {4};
+  int heights[1] = {4};
+  // 未加载模型时拒绝推理。
+  assert(onnx_client_detect_batch(client, images, 1, widths, heights, 0.25f,
+                                  0.45f, 0, 0) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_INVALID_ARGUMENT);
+
+  // 后端错误码与信息透传给客户端。
+  assert(onnx_client_load_model(client, "missing.onnx", false) ==
+         ONNX_ERROR_RUNTIME_FAILURE);
+  assert(std::strstr(onnx_get_last_error(), "missing.onnx") != nullptr);
+  assert(onnx_client_load_model(client, "model.onnx", false) == ONNX_OK);
+
+  BatchDetectionResult *result = onnx_client_detect_batch(
+      client, images, 1, widths, heights, 0.25f, 0.45f, 1, 17);
+  assert(result != nullptr);
+  assert(result->num_images == 1);
+  assert(result->results[0].count == 1);
+  assert(result->results[0].detections[0].class_id == 9);
+  assert(result->results[0].detections[0].num_keypoints == 1);
+  onnx_free_batch_result(result);
+
+  // 更大的图片触发共享内存扩容。
+  std::vector<uint8_t> large(256 * 256 * 4, 0);
+  large[0] = 42;
+  images[0] = large.data();
+  widths[0] = 256;
+  heights[0] = 256;
+  result = onnx_client_detect_batch(client, images, 1, widths, heights, 0.25f,
+                                    0.45f, 0, 0);
+  assert(result != nullptr);
+  assert(result->results[0].detections[0].class_id == 42);
+  onnx_free_batch_result(result);
+
+  // 守护进程退出后请求失败而不是挂起。
+  server.stop();
+  assert(onnx_client_detect_batch(client, images, 1, widths, heights, 0.25f,
+                                  0.45f, 0, 0) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_DAEMON_UNAVAILABLE);
+  onnx_client_disconnect(client);
+}
+
+// 经原始协议附加共享内存并请求一张 4x4 图片，返回应答状态。
+static int attach_and_detect(int fd, int memory_fd, uint64_t claimed_size,
+                             int32_t model_id, std::string *reply) {
+  bool sent = send_message(fd, kAttachMemory, ONNX_OK, &claimed_size,
+                           sizeof(claimed_size), memory_fd);
+  assert(sent);
+  std::string payload(sizeof(DetectRequest) + sizeof(ImageRef), '\0');
+  DetectRequest request{model_id, 0.25f, 0.45f, 0, 0, 1};
+  ImageRef ref{4, 4, 0};
+  memcpy(&payload[0], &request, sizeof(request));
+  memcpy(&payload[sizeof(request)], &ref, sizeof(ref));
+  sent = send_message(fd, kDetect, ONNX_OK, payload.data(), payload.size());
+  assert(sent);
+  MessageHeader header;
+  bool received = recv_message(fd, &header, reply);
+  assert(received);
+  (void)sent;
+  (void)received;
+  return header.status;
+}
+
+static void test_attach_checks_memory_size() {
+  // 共享内存大小经 fstat 核对；Linux 上已封印，客户端无法再缩小。
+  SharedMemory memory;
+  assert(create_shared_memory(4096, &memory));
+  std::string error;
+  assert(check_shared_memory(memory.fd, 4096, &error));
+  assert(!check_shared_memory(memory.fd, 4097, &error));
+  assert(error.find("4097") != std::string::npos);
+  assert(!check_shared_memory(memory.fd, 0, &error));
+#ifdef __linux__
+  assert(ftruncate(memory.fd, 1024) != 0);
+  // 未封印的 memfd 随时可能被缩小，拒绝映射。
+  int unsealed = memfd_create("unsealed", MFD_CLOEXEC);
+  assert(unsealed >= 0);
+  assert(ftruncate(unsealed, 4096) == 0);
+  assert(!check_shared_memory(unsealed, 4096, &error));
+  close(unsealed);
+#endif
+  memory.data[0] = 5;
+
+  DaemonServerOptions options;
+  options.socket_path = test_socket_path("attach");
+  DaemonServer server(options, stand_in_backend());
+  assert(server.start(&error));
+  int fd = connect_socket(options.socket_path);
+  assert(fd >= 0);
+  std::string load("\0model.onnx", 11);
+  assert(send_message(fd, kLoadModel, ONNX_OK, load.data(), load.size()));
+  MessageHeader header;
+  std::string reply;
+  assert(recv_message(fd, &header, &reply));
+  assert(header.status == ONNX_OK && reply.size() == sizeof(int32_t));
+  int32_t model_id;
+  memcpy(&model_id, reply.data(), sizeof(model_id));
+
+  // 声明大小超过实际大小：拒绝附加，守护进程不映射、不崩溃。
+  assert(attach_and_detect(fd, memory.fd, 1 << 20, model_id, &reply) ==
+         ONNX_ERROR_INVALID_ARGUMENT);
+  assert(reply.find("共享内存被拒绝") != std::string::npos);
+  assert(attach_and_detect(fd, memory.fd, 4096, model_id, &reply) == ONNX_OK);
+  close(fd);
+  server.stop();
+  release_shared_memory(&memory);
+}
+
+struct ThroughputResult {
+  double images_per_second = 0;
+  DaemonStats stats;
+};
+
+// 多个客户端各自逐张请求，返回聚合吞吐。
+static ThroughputResult run_clients(int64_t max_delay_us, int num_clients,
+                                    int requests_per_client) {
+  DaemonServerOptions options;
+  options.socket_path = test_socket_path("throughput");
+  options.max_batch = num_clients;
+  options.max_delay_us = max_delay_us;
+  DaemonServer server(options, stand_in_backend());
+  std::string error;
+  bool started = server.start(&error);
+  assert(started);
+  (void)started;
+
+  std::atomic<int> failures{0};
+  auto start = std::chrono::steady_clock::now();
+  std::vector<std::thread> threads;
+  for (int c = 0; c < num_clients; c++) {
+    threads.emplace_back([&, c] {
+      OnnxClientHandle client =
+          onnx_client_connect(options.socket_path.c_str());
+      if (!client || onnx_client_load_model(client, "model.onnx", false)) {
+        failures++;
+        onnx_client_disconnect(client);
+        return;
+      }
+      std::vector<uint8_t> pixels((size_t)(32 + c) * 32 * 4,
+                                  (uint8_t)(c + 1));
+      const uint8_t *images[1] = {pixels.data()};
+      int widths[1] = {32 + c};
+      int heights[1] = {32};
+      for (int r = 0; r < requests_per_client; r++) {
+        BatchDetectionResult *result = onnx_client_detect_batch(
+            client, images, 1, widths, heights, 0.25f, 0.45f, 0, 0);
+        // 结果必须回到发起请求的客户端。
+        if (!result || result->results[0].count != 1 ||
+            result->results[0].detections[0].class_id != c + 1 ||
+            result->results[0].detections[0].confidence !=
+                (32 + c) / 1000.0f) {
+          failures++;
+        }
+        onnx_free_batch_result(result);
+      }
+      onnx_client_disconnect(client);
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  double seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  server.stop();
+  assert(failures == 0);
+
+  ThroughputResult result;
+  result.stats = server.stats();
+  result.images_per_second =
+      (double)num_clients * requests_per_client / seconds;
+  return result;
+}
+
+static void test_micro_batching_throughput() {
+  const int clients = 8;
+  const int requests = 40;
+  ThroughputResult serial = run_clients(0, clients, requests);
+  ThroughputResult batched = run_clients(2000, clients, requests);
+  assert(serial.stats.requests == clients * requests);
+  assert(batched.stats.requests == clients * requests);
+  assert(batched.stats.images == clients * requests);
+  // 等待窗口内的并发请求应被合并。
+  assert(batched.stats.batches < batched.stats.images / 2);
+  printf("daemon throughput: %d clients, no delay %.0f img/s (%lld batches), "
+         "2 ms window %.0f img/s (%lld batches)\n",
+         clients, serial.images_per_second,
+         (long long)serial.stats.batches, batched.images_per_second,
+         (long long)batched.stats.batches);
+}
+
+int main() {
+  test_encode_decode_roundtrip();
+  test_client_errors();
+  test_attach_checks_memory_size();
+  test_micro_batching_throughput();
+  std::cout << "onnx_daemon_test passed\n";
+  return 0;
+}
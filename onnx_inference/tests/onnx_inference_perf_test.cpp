@@ -0,0 +1,574 @@
+/**
+ * ONNX 推理插件性能回归门禁
+ *
+ * 测量热点路径指标并与提交的基线 JSON 比较，超出相对容差即失败：
+ *   preprocess_ns_per_pixel      1280x720 letterbox 预处理，每源像素耗时
+ *   nms_us_per_1k_candidates     簇状候选框原地 NMS，每千候选耗时
+ *   detect_allocs_per_call       onnx_detect 插件侧路径每次调用的堆分配数
+ *   detect_into_allocs_per_call  onnx_detect_into 插件侧路径每次调用的堆分配数
+ *
+ * 耗时指标按校准负载折算到基线机器，降低不同 CI 机器间的差异；
+ * 分配数由本测试替换 malloc/calloc/realloc 计数（仅 glibc），经测试专用
+ * 插件库以合成输出代替 Run 调用插件接口（需 ONNX Runtime 头文件）。
+ * 存在 ONNX Runtime 时额外以微型模型调用真实 onnx_detect。
+ *
+ * 用法: onnx_inference_perf_test --baseline 文件 [--update]
+ */
+#include "onnx_inference_utils.h"
+
+#if defined(ONNX_PERF_PLUGIN)
+#include "onnx_inference_testing.h"
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <random>
+#include <string>
+#include <vector>
+
+// ---------------------------------------------------------------------------
+// 分配计数
+// ---------------------------------------------------------------------------
+
+#if defined(__SANITIZE_ADDRESS__)
+#define ONNX_PERF_SANITIZED 1
+#elif defined(__has_feature)
+#if __has_feature(address_sanitizer) || __has_feature(memory_sanitizer)
+#define ONNX_PERF_SANITIZED 1
+#endif
+#endif
+
+#if defined(__GLIBC__) && !defined(ONNX_PERF_SANITIZED)
+#define ONNX_PERF_COUNT_ALLOCS 1
+#endif
+
+static std::atomic<bool> g_counting{false};
+static std::atomic<int64_t> g_allocations{0};
+
+#if defined(ONNX_PERF_COUNT_ALLOCS)
+// 进程内替换 malloc 族，插件库与 libstdc++（operator new）的分配一并计入。
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *ptr, size_t size);
+void __libc_free(void *ptr);
+
+void *malloc(size_t size) {
+  if (g_counting.load(std::memory_order_relaxed)) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size) {
+  if (g_counting.load(std::memory_order_relaxed)) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  return __libc_calloc(count, size);
+}
+
+void *realloc(void *ptr, size_t size) {
+  if (g_counting.load(std::memory_order_relaxed)) {
+    g_allocations.fetch_add(1, std::memory_order_relaxed);
+  }
+  return __libc_realloc(ptr, size);
+}
+
+void free(void *ptr) { __libc_free(ptr); }
+}
+#endif
+
+// 统计 body 每次调用的平均分配数（先预热，使暂存区增长到稳态）。
+static double allocations_per_call(const std::function<void()> &body,
+                                   int calls) {
+  for (int i = 0; i < 3; i++) {
+    body();
+  }
+  g_allocations.store(0);
+  g_counting.store(true);
+  for (int i = 0; i < calls; i++) {
+    body();
+  }
+  g_counting.store(false);
+  return (double)g_allocations.load() / calls;
+}
+
+// ---------------------------------------------------------------------------
+// 测量
+// ---------------------------------------------------------------------------
+
+namespace {
+
+constexpr int kInputSize = 640;
+constexpr int kNumBoxes = 8400;
+constexpr int kNumClasses = 80;
+constexpr float kConfThreshold = 0.25f;
+constexpr float kNmsThreshold = 0.45f;
+
+volatile uint64_t g_sink = 0;
+
+// 取多次运行的最小值（受调度与频率抖动影响最小）。
+double min_time_ns(const std::function<void()> &setup,
+                   const std::function<void()> &body, int runs) {
+  using Clock = std::chrono::steady_clock;
+  double best = 0;
+  for (int i = 0; i < runs + 2; i++) {
+    setup();
+    auto start = Clock::now();
+    body();
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start)
+                    .count();
+    if (i >= 2 && (best == 0 || ns < best)) {
+      best = ns;
+    }
+  }
+  return best;
+}
+
+// 校准负载：顺序读写与浮点乘加，近似预处理/NMS 的访存与计算比例。
+double calibration_ns() {
+  std::vector<float> data((size_t)1 << 20);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (float)(i & 0xFF) / 255.0f;
+  }
+  return min_time_ns([] {},
+                     [&] {
+                       float acc = 0;
+                       for (int pass = 0; pass < 4; pass++) {
+                         for (float &v : data) {
+                           v = v * 0.999f + 0.001f;
+                           acc += v;
+                         }
+                       }
+                       g_sink += (uint64_t)acc;
+                     },
+                     15);
+}
+
+std::vector<uint8_t> make_image(int width, int height, std::mt19937 *rng) {
+  std::vector<uint8_t> image((size_t)width * height * 4);
+  std::uniform_int_distribution<int> noise(0, 31);
+  for (int y = 0; y < height; y++) {
+    for (int x = 0; x < width; x++) {
+      uint8_t *px = &image[((size_t)y * width + x) * 4];
+      px[0] = (uint8_t)((x * 255 / width + noise(*rng)) & 0xFF);
+      px[1] = (uint8_t)((y * 255 / height + noise(*rng)) & 0xFF);
+      px[2] = (uint8_t)(((x + y) & 0xFF) ^ noise(*rng));
+      px[3] = 255;
+    }
+  }
+  return image;
+}
+
+// 合成 YOLOv8 检测输出 [84, 8400]：背景得分很低，每个目标激活一簇候选框。
+std::vector<float> make_yolo_output(int num_objects, std::mt19937 *rng) {
+  int num_features = 4 + kNumClasses;
+  std::vector<float> out((size_t)num_features * kNumBoxes);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  auto at = [&](int feature, int box) -> float & {
+    return out[(size_t)feature * kNumBoxes + box];
+  };
+  for (int box = 0; box < kNumBoxes; box++) {
+    at(0, box) = unit(*rng) * kInputSize;
+    at(1, box) = unit(*rng) * kInputSize;
+    at(2, box) = 8.0f + unit(*rng) * 120.0f;
+    at(3, box) = 8.0f + unit(*rng) * 120.0f;
+    for (int c = 0; c < kNumClasses; c++) {
+      at(4 + c, box) = unit(*rng) * 0.05f;
+    }
+  }
+  std::uniform_int_distribution<int> pick_box(0, kNumBoxes - 1);
+  std::uniform_int_distribution<int> pick_class(0, kNumClasses - 1);
+  for (int obj = 0; obj < num_objects; obj++) {
+    float cx = 40.0f + unit(*rng) * (kInputSize - 80);
+    float cy = 40.0f + unit(*rng) * (kInputSize - 80);
+    float w = 20.0f + unit(*rng) * 200.0f;
+    float h = 20.0f + unit(*rng) * 200.0f;
+    int cls = pick_class(*rng);
+    for (int a = 0; a < 12; a++) {
+      int box = pick_box(*rng);
+      at(0, box) = cx + (unit(*rng) - 0.5f) * w * 0.2f;
+      at(1, box) = cy + (unit(*rng) - 0.5f) * h * 0.2f;
+      at(2, box) = w * (0.9f + unit(*rng) * 0.2f);
+      at(3, box) = h * (0.9f + unit(*rng) * 0.2f);
+      at(4 + cls, box) = 0.3f + unit(*rng) * 0.65f;
+    }
+  }
+  return out;
+}
+
+double measure_preprocess_ns_per_pixel() {
+  const int w = 1280;
+  const int h = 720;
+  std::mt19937 rng(20240601u);
+  std::vector<uint8_t> image = make_image(w, h, &rng);
+  std::vector<float> buffer((size_t)3 * kInputSize * kInputSize);
+  double ns = min_time_ns([] {},
+                          [&] {
+                            float sx, sy;
+                            int pl, pt;
+                            preprocess_image_to_buffer(
+                                image.data(), w, h, kInputSize, kInputSize,
+                                buffer.data(), &sx, &sy, &pl, &pt);
+                            g_sink += (uint64_t)buffer[buffer.size() / 2];
+                          },
+                          30);
+  return ns / ((double)w * h);
+}
+
+double measure_nms_us_per_1k() {
+  std::mt19937 rng(20240602u);
+  std::vector<float> output = make_yolo_output(300, &rng);
+  DetectionScratch scratch;
+  // 低阈值保留大量背景候选，模拟重叠密集的最坏情形。
+  parse_yolov8_output(output.data(), 4 + kNumClasses, kNumBoxes,
+                      MODEL_TYPE_YOLO, 0, 0.01f, 1.0f, 1.0f, 0, 0, kInputSize,
+                      kInputSize, &scratch);
+  std::vector<Detection> input = scratch.candidates;
+  std::vector<Detection> working;
+  double ns = min_time_ns(
+      [&] { working.assign(input.begin(), input.end()); },
+      [&] {
+        g_sink += onnx_nms_inplace(working.data(), working.size(),
+                                   kNmsThreshold);
+      },
+      30);
+  return ns / 1e3 / ((double)input.size() / 1000.0);
+}
+
+#if defined(ONNX_PERF_PLUGIN)
+// 以合成输出创建测试模型，经插件接口测量 Run 之外的路径：预处理写入复用
+// 缓冲区、解析到暂存区、原地 NMS 与结果写出。body 接收模型与图片，
+// 返回调用是否成功；任一调用失败时返回 -1（按回归处理）。
+double measure_plugin_allocs(
+    const std::function<bool(ModelHandle, const uint8_t *, int, int)> &body) {
+  std::mt19937 rng(20240603u);
+  const int w = 1280;
+  const int h = 720;
+  std::vector<uint8_t> image = make_image(w, h, &rng);
+  std::vector<float> output = make_yolo_output(20, &rng);
+  ModelHandle model = onnx_testing_create_model(
+      kInputSize, kInputSize, output.data(), 4 + kNumClasses, kNumBoxes);
+  if (!model) {
+    fprintf(stderr, "创建测试模型失败: %s\n", onnx_get_last_error());
+    return -1;
+  }
+  bool ok = true;
+  double allocs = allocations_per_call(
+      [&] { ok = body(model, image.data(), w, h) && ok; }, 50);
+  if (!ok) {
+    fprintf(stderr, "插件调用失败: %s\n", onnx_get_last_error());
+  }
+  onnx_unload_model(model);
+  return ok ? allocs : -1;
+}
+
+// onnx_detect：结果拷贝到堆分配的返回结构体并释放。
+double measure_detect_allocs() {
+  return measure_plugin_allocs(
+      [](ModelHandle model, const uint8_t *image, int w, int h) {
+        DetectionResult *result =
+            onnx_detect(model, image, w, h, kConfThreshold, kNmsThreshold,
+                        MODEL_TYPE_YOLO, 0);
+        if (!result) {
+          return false;
+        }
+        g_sink += (uint64_t)result->count;
+        onnx_free_result(result);
+        return true;
+      });
+}
+
+// onnx_detect_into：结果写入调用方持有的缓冲区，稳态下不应有分配。
+double measure_detect_into_allocs() {
+  std::vector<Detection> detections(256);
+  std::vector<uint8_t> arena(4096);
+  OnnxResultBuffer out = {};
+  out.detections = detections.data();
+  out.capacity = (int)detections.size();
+  out.arena = arena.data();
+  out.arena_capacity = (int64_t)arena.size();
+  return measure_plugin_allocs(
+      [&](ModelHandle model, const uint8_t *image, int w, int h) {
+        if (onnx_detect_into(model, image, w, h, kConfThreshold,
+                             kNmsThreshold, MODEL_TYPE_YOLO, 0,
+                             &out) != ONNX_OK) {
+          return false;
+        }
+        g_sink += (uint64_t)out.count;
+        return true;
+      });
+}
+#endif
+
+#if defined(ONNX_PERF_TINY_MODEL)
+// 以仓库内微型模型调用真实 onnx_detect（含 ONNX Runtime 内部分配）。
+double measure_tiny_model_allocs() {
+  if (!onnx_init()) {
+    return -1;
+  }
+  ModelHandle model = onnx_load_model(ONNX_PERF_TINY_MODEL, false);
+  if (!model) {
+    return -1;
+  }
+  std::mt19937 rng(20240604u);
+  std::vector<uint8_t> image = make_image(1280, 720, &rng);
+  double allocs = allocations_per_call(
+      [&] {
+        DetectionResult *result =
+            onnx_detect(model, image.data(), 1280, 720, kConfThreshold,
+                        kNmsThreshold, MODEL_TYPE_YOLO, 0);
+        onnx_free_result(result);
+      },
+      20);
+  onnx_unload_model(model);
+  return allocs;
+}
+
+// 批量推理后 onnx_trim_memory 立即收缩内存池，归还量经
+// onnx_get_memory_usage 报告。返回是否通过。
+bool check_tiny_model_trim() {
+  if (!onnx_init()) {
+    return true;
+  }
+  ModelHandle model = onnx_load_model(ONNX_PERF_TINY_MODEL, false);
+  if (!model) {
+    return true;
+  }
+  std::mt19937 rng(20240605u);
+  const int batch = 8;
+  std::vector<std::vector<uint8_t>> images;
+  std::vector<const uint8_t *> pointers;
+  std::vector<int> widths(batch, 1280), heights(batch, 720);
+  for (int i = 0; i < batch; i++) {
+    images.push_back(make_image(1280, 720, &rng));
+    pointers.push_back(images.back().data());
+  }
+  onnx_free_batch_result(onnx_detect_batch(
+      model, pointers.data(), batch, widths.data(), heights.data(),
+      kConfThreshold, kNmsThreshold, MODEL_TYPE_YOLO, 0));
+
+  OnnxMemoryUsage before{}, after{};
+  bool ok = onnx_get_memory_usage(model, &before) == ONNX_OK &&
+            onnx_trim_memory(model) == ONNX_OK &&
+            onnx_get_memory_usage(model, &after) == ONNX_OK &&
+            after.plugin_reserved_bytes == 0;
+  // 运行时支持内存池统计（API 23+）时核对归还量。
+  if (ok && before.arena_reserved_bytes >= 0) {
+    ok = after.arena_trimmed_bytes >= 0 &&
+         after.arena_reserved_bytes <= before.arena_reserved_bytes &&
+         after.arena_trimmed_bytes ==
+             before.arena_reserved_bytes - after.arena_reserved_bytes;
+  }
+  fprintf(stderr, "%-36s 内存池 %lld -> %lld 字节  %s\n", "trim_memory",
+          (long long)before.arena_reserved_bytes,
+          (long long)after.arena_reserved_bytes, ok ? "OK" : "失败");
+  onnx_unload_model(model);
+  return ok;
+}
+#endif
+
+// ---------------------------------------------------------------------------
+// 基线
+// ---------------------------------------------------------------------------
+
+struct Metric {
+  const char *name;
+  bool calibrated; // 耗时指标按校准负载折算
+  double default_tolerance;
+  double value = 0;
+  bool measured = false;
+};
+
+struct BaselineEntry {
+  double value = 0;
+  double tolerance = 0;
+  bool found = false;
+};
+
+bool read_file(const std::string &path, std::string *out) {
+  FILE *file = fopen(path.c_str(), "rb");
+  if (!file) {
+    return false;
+  }
+  char chunk[4096];
+  size_t n;
+  while ((n = fread(chunk, 1, sizeof(chunk), file)) > 0) {
+    out->append(chunk, n);
+  }
+  fclose(file);
+  return true;
+}
+
+// 读取 "key": 数值（在 [begin, end) 范围内查找）。
+bool find_number(const std::string &json, const std::string &key, size_t begin,
+                 size_t end, double *out) {
+  size_t pos = json.find("\"" + key + "\"", begin);
+  if (pos == std::string::npos || pos >= end) {
+    return false;
+  }
+  pos = json.find(':', pos);
+  if (pos == std::string::npos || pos >= end) {
+    return false;
+  }
+  *out = strtod(json.c_str() + pos + 1, nullptr);
+  return true;
+}
+
+// 基线格式: {"calibration_ns": N, "metrics": {"名称": {"value": V,
+// "tolerance": T}, ...}}，由 --update 生成。
+BaselineEntry find_metric(const std::string &json, const char *name) {
+  BaselineEntry entry;
+  size_t pos = json.find("\"" + std::string(name) + "\"");
+  if (pos == std::string::npos) {
+    return entry;
+  }
+  size_t end = json.find('}', pos);
+  if (end == std::string::npos) {
+    return entry;
+  }
+  entry.found = find_number(json, "value", pos, end, &entry.value) &&
+                find_number(json, "tolerance", pos, end, &entry.tolerance);
+  return entry;
+}
+
+bool write_baseline(const std::string &path, const std::string &old_json,
+                    double calibration, const std::vector<Metric> &metrics) {
+  FILE *file = fopen(path.c_str(), "w");
+  if (!file) {
+    fprintf(stderr, "无法写入 %s\n", path.c_str());
+    return false;
+  }
+  fprintf(file, "{\n  \"schema\": 1,\n  \"calibration_ns\": %.0f,\n",
+          calibration);
+  fprintf(file, "  \"metrics\": {");
+  bool first = true;
+  for (const Metric &m : metrics) {
+    if (!m.measured) {
+      continue;
+    }
+    // 保留已有容差，只更新数值。
+    BaselineEntry old = find_metric(old_json, m.name);
+    double tolerance = old.found ? old.tolerance : m.default_tolerance;
+    fprintf(file, "%s\n    \"%s\": {\"value\": %.4g, \"tolerance\": %.2f}",
+            first ? "" : ",", m.name, m.value, tolerance);
+    first = false;
+  }
+  fprintf(file, "\n  }\n}\n");
+  fclose(file);
+  return true;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  std::string baseline_path;
+  bool update = false;
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (arg == "--baseline" && i + 1 < argc) {
+      baseline_path = argv[++i];
+    } else if (arg == "--update") {
+      update = true;
+    } else {
+      fprintf(stderr,
+              "用法: onnx_inference_perf_test --baseline 文件 [--update]\n");
+      return 2;
+    }
+  }
+  if (baseline_path.empty()) {
+    fprintf(stderr, "缺少 --baseline\n");
+    return 2;
+  }
+
+  std::string baseline;
+  if (!read_file(baseline_path, &baseline) && !update) {
+    fprintf(stderr, "无法读取基线 %s\n", baseline_path.c_str());
+    return 1;
+  }
+
+  std::vector<Metric> metrics = {
+      {"preprocess_ns_per_pixel", true, 0.35},
+      {"nms_us_per_1k_candidates", true, 0.35},
+      {"detect_allocs_per_call", false, 0.0},
+      {"detect_into_allocs_per_call", false, 0.0},
+      {"detect_tiny_model_allocs_per_call", false, 0.10},
+  };
+  metrics[0].value = measure_preprocess_ns_per_pixel();
+  metrics[0].measured = true;
+  metrics[1].value = measure_nms_us_per_1k();
+  metrics[1].measured = true;
+#if defined(ONNX_PERF_COUNT_ALLOCS) && defined(ONNX_PERF_PLUGIN)
+  metrics[2].value = measure_detect_allocs();
+  metrics[2].measured = true;
+  metrics[3].value = measure_detect_into_allocs();
+  metrics[3].measured = true;
+#if defined(ONNX_PERF_TINY_MODEL)
+  metrics[4].value = measure_tiny_model_allocs();
+  metrics[4].measured = metrics[4].value >= 0;
+#endif
+#endif
+
+  double calibration = calibration_ns();
+  if (update) {
+    if (!write_baseline(baseline_path, baseline, calibration, metrics)) {
+      return 1;
+    }
+    fprintf(stderr, "已更新基线 %s\n", baseline_path.c_str());
+    return 0;
+  }
+
+  double base_calibration = 0;
+  if (!find_number(baseline, "calibration_ns", 0, baseline.size(),
+                   &base_calibration) ||
+      base_calibration <= 0) {
+    fprintf(stderr, "基线缺少 calibration_ns\n");
+    return 1;
+  }
+  // 本机相对基线机器的速度比（>1 表示更慢）。
+  double machine_factor = calibration / base_calibration;
+  fprintf(stderr, "校准: %.0f ns (基线 %.0f ns, 系数 %.2f)\n", calibration,
+          base_calibration, machine_factor);
+
+  int failures = 0;
+#if defined(ONNX_PERF_TINY_MODEL)
+  if (!check_tiny_model_trim()) {
+    failures++;
+  }
+#endif
+  for (const Metric &m : metrics) {
+    if (!m.measured) {
+      fprintf(stderr, "%-36s 跳过（本构建不支持）\n", m.name);
+      continue;
+    }
+    BaselineEntry entry = find_metric(baseline, m.name);
+    if (!entry.found) {
+      fprintf(stderr, "%-36s %10.4g  无基线，跳过\n", m.name, m.value);
+      continue;
+    }
+    double expected = entry.value * (m.calibrated ? machine_factor : 1.0);
+    double limit = expected * (1.0 + entry.tolerance);
+    // 负值表示测量失败。
+    bool ok = m.value >= 0 && m.value <= limit + 1e-9;
+    fprintf(stderr, "%-36s %10.4g  基线 %10.4g  上限 %10.4g  %s\n", m.name,
+            m.value, expected, limit, ok ? "OK" : "回归");
+    if (!ok) {
+      failures++;
+    }
+  }
+
+  if (failures > 0) {
+    fprintf(stderr,
+            "%d 项性能指标回归；确认为预期变化后使用 --update 更新基线\n",
+            failures);
+    return 1;
+  }
+  fprintf(stderr, "onnx_inference_perf_test passed\n");
+  return 0;
+}
@@ -7,7 +7,11 @@
 
 #include <cassert>
 #include <cstring>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <string>
+#include <vector>
 
 static void test_init_error() {
   // 初始化失败时必须设置错误码与错误信息。
@@ -19,6 +23,15 @@ static void test_init_error() {
   assert(std::strlen(err) > 0);
 }
 
+static void test_runtime_search_paths() {
+  // 无运行时构建不加载任何库，设置搜索路径同样报告运行时缺失。
+  assert(!onnx_set_runtime_search_paths("/opt/onnxruntime/lib"));
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  const char *path = onnx_get_runtime_path();
+  assert(path != nullptr);
+  assert(path[0] == '\0');
+}
+
 static void test_load_model_error() {
   // 在缺少运行时环境下，加载应失败并标记错误码。
   ModelHandle handle = onnx_load_model("fake.onnx", false);
@@ -26,6 +39,15 @@ static void test_load_model_error() {
   assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
 }
 
+static void test_async_load_errors() {
+  // 后台加载同样失败，取出与放弃接口接受 NULL。
+  assert(onnx_load_model_async("fake.onnx", nullptr) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_load_model_done(nullptr) == -1);
+  assert(onnx_load_model_finish(nullptr) == nullptr);
+  onnx_load_model_cancel(nullptr);
+}
+
 static void test_get_input_size_errors() {
   // 空指针与未初始化模型应返回失败。
   int w = -1;
@@ -53,10 +75,253 @@ static void test_detect_errors() {
   assert(batch == nullptr);
   assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
 
+  OnnxResultBuffer buffer{};
+  buffer.count = 3;
+  int code = onnx_detect_into(nullptr, nullptr, 0, 0, 0.5f, 0.4f, 0, 0,
+                              &buffer);
+  assert(code == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(buffer.count == 0);
+  assert(onnx_copy_last_result(nullptr, &buffer) ==
+         ONNX_ERROR_RUNTIME_NOT_FOUND);
+
   onnx_free_result(nullptr);
   onnx_free_batch_result(nullptr);
 }
 
+static void test_stream_errors() {
+  // 流式批量接口在缺少运行时时返回空会话与错误码。
+  BatchStreamHandle stream =
+      onnx_stream_create(nullptr, 0.25f, 0.45f, 0, 0, 0);
+  assert(stream == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_stream_push(nullptr, nullptr, 0, 0, 0) ==
+         ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_stream_flush(nullptr) == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_stream_pending(nullptr) == 0);
+  assert(onnx_stream_batch_size(nullptr) == 0);
+  int64_t tag = -1;
+  assert(onnx_stream_next(nullptr, &tag, nullptr) ==
+         ONNX_ERROR_RUNTIME_NOT_FOUND);
+  onnx_stream_destroy(nullptr);
+}
+
+static void test_raw_cache_errors() {
+  // 缓存接口在缺少运行时时失败；内容哈希与运行时无关。
+  assert(onnx_enable_raw_cache(nullptr, "cache") ==
+         ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_detect_cached(nullptr, 1, 0.5f, 0.4f, 0, 0) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_detect_batch_keyed(nullptr, nullptr, nullptr, 0, nullptr,
+                                 nullptr, 0.5f, 0.4f, 0, 0) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+
+  const uint8_t data[] = {'a', 'b', 'c'};
+  assert(onnx_hash_bytes(data, 3) == 0x44BC2CF5AD770999ULL);
+  assert(onnx_hash_bytes(nullptr, 0) == 0xEF46DB3751D8E999ULL);
+}
+
+static void test_hash_files() {
+  // 文件哈希与运行时无关：与 onnx_hash_bytes 一致，缺失文件单独标记失败。
+  namespace fs = std::filesystem;
+  fs::path dir = fs::temp_directory_path() / "onnx_inference_stub_hash";
+  fs::create_directories(dir);
+  std::vector<std::string> names;
+  std::vector<std::string> contents;
+  for (int i = 0; i < 20; i++) {
+    names.push_back((dir / ("image_" + std::to_string(i) + ".jpg")).string());
+    contents.emplace_back((size_t)(i * 977), (char)('a' + i));
+    std::ofstream(names.back(), std::ios::binary) << contents.back();
+  }
+  names.push_back((dir / "missing.jpg").string());
+
+  std::vector<const char *> paths;
+  for (const auto &name : names) {
+    paths.push_back(name.c_str());
+  }
+  paths.push_back(nullptr);
+  std::vector<uint64_t> hashes(paths.size(), 1);
+  std::vector<uint8_t> ok(paths.size(), 1);
+  assert(onnx_hash_files(paths.data(), (int)paths.size(), hashes.data(),
+                         ok.data()) == 20);
+  for (size_t i = 0; i < contents.size(); i++) {
+    assert(ok[i] == 1);
+    assert(hashes[i] == onnx_hash_bytes((const uint8_t *)contents[i].data(),
+                                        (int64_t)contents[i].size()));
+  }
+  assert(ok[20] == 0 && hashes[20] == 0);
+  assert(ok[21] == 0 && hashes[21] == 0);
+
+  assert(onnx_hash_files(nullptr, 0, nullptr, nullptr) == 0);
+  assert(onnx_hash_files(nullptr, 1, hashes.data(), ok.data()) == -1);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_INVALID_ARGUMENT);
+  fs::remove_all(dir);
+}
+
+static void test_sweep_errors() {
+  // 多阈值扫描在缺少运行时时返回空结果与错误码。
+  const uint8_t pixel[4] = {0, 0, 0, 255};
+  const float conf[2] = {0.25f, 0.5f};
+  const float nms[1] = {0.45f};
+  assert(onnx_detect_sweep(nullptr, pixel, 1, 1, conf, 2, nms, 1, 0, 0) ==
+         nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+}
+
+static void test_dedup() {
+  // 感知哈希与运行时无关；开启近重复跳过需要模型。
+  std::vector<uint8_t> image((size_t)32 * 16 * 4, 0);
+  for (size_t i = 0; i < image.size(); i += 4) {
+    image[i] = (uint8_t)((i / 4) % 32 * 8);
+  }
+  uint64_t hash = onnx_image_dhash(image.data(), 32, 16);
+  assert(hash == 0);
+  for (size_t i = 0; i < image.size(); i += 4) {
+    image[i] = 255 - image[i];
+  }
+  assert(onnx_image_dhash(image.data(), 32, 16) == ~0ULL);
+  assert(onnx_image_dhash(nullptr, 32, 16) == 0);
+
+  assert(onnx_set_dedup(nullptr, 4) == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+}
+
+static void test_cascade_errors() {
+  OnnxCascadeOptions options;
+  onnx_default_cascade_options(&options);
+  assert(options.uncertain_low < options.uncertain_high);
+  assert(options.min_uncertain == 1 && options.escalate_empty);
+  assert(options.heavy_batch_size == 0);
+  const uint8_t pixel[4] = {0, 0, 0, 255};
+  const uint8_t *images[1] = {pixel};
+  int size = 1;
+  assert(onnx_detect_batch_cascade(nullptr, nullptr, images, 1, &size, &size,
+                                   0.25f, 0.45f, 0, 0, &options) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+}
+
+static void test_tracker() {
+  // 跟踪器与运行时无关，存根构建下可用。
+  OnnxTrackerOptions options;
+  onnx_tracker_default_options(&options);
+  assert(options.keyframe_interval == 5);
+  options.keyframe_interval = 0;
+  assert(onnx_tracker_create(&options) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_INVALID_ARGUMENT);
+  assert(onnx_tracker_advance(nullptr) == -1);
+
+  TrackerHandle tracker = onnx_tracker_create(nullptr);
+  assert(tracker != nullptr);
+  float keypoints[3] = {0.5f, 0.5f, 1.0f};
+  Detection det{};
+  det.confidence = 0.8f;
+  det.x = 0.5f;
+  det.y = 0.5f;
+  det.width = 0.2f;
+  det.height = 0.2f;
+  det.keypoints = keypoints;
+  det.num_keypoints = 1;
+  assert(onnx_tracker_advance(tracker) == 1);
+  assert(onnx_tracker_update(tracker, &det, -1) == ONNX_ERROR_INVALID_ARGUMENT);
+  assert(onnx_tracker_update(tracker, &det, 1) == ONNX_OK);
+  for (int frame = 0; frame < 3; frame++) {
+    DetectionResult *result = onnx_tracker_current(tracker);
+    assert(result != nullptr && result->count == 1);
+    assert(result->detections[0].num_keypoints == 1);
+    assert(result->detections[0].keypoints != keypoints);
+    onnx_free_result(result);
+    if (onnx_tracker_advance(tracker) == 1) {
+      assert(onnx_tracker_update(tracker, &det, 1) == ONNX_OK);
+    }
+  }
+
+  OnnxTrackerStats stats;
+  assert(onnx_tracker_get_stats(tracker, &stats) == ONNX_OK);
+  assert(stats.frames == 4);
+  assert(stats.detector_calls == 2); // 首帧 + 新轨迹确认
+  assert(stats.tracks_created == 1);
+  onnx_tracker_reset(tracker);
+  assert(onnx_tracker_advance(tracker) == 1);
+  onnx_tracker_destroy(tracker);
+  onnx_tracker_destroy(nullptr);
+}
+
+static void test_stats_errors() {
+  // 统计接口在缺少运行时时返回清零的快照与错误码。
+  OnnxStats stats;
+  stats.calls = 42;
+  assert(onnx_get_stats(nullptr, &stats) == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(stats.calls == 0);
+  onnx_reset_stats(nullptr);
+  assert(onnx_get_last_error_code() == ONNX_OK);
+}
+
+static void test_profiling_errors() {
+  assert(onnx_start_profiling(nullptr, "/tmp/trace.json") ==
+         ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(onnx_stop_profiling(nullptr) == ONNX_ERROR_RUNTIME_NOT_FOUND);
+}
+
+static void test_init_options() {
+  OnnxInitOptions options;
+  onnx_default_init_options(&options);
+  assert(!options.use_global_thread_pools);
+  assert(options.allow_spinning);
+  assert(options.intra_op_threads == 0);
+  assert(options.inter_op_threads == 0);
+  assert(options.intra_op_affinity == nullptr);
+  onnx_default_init_options(nullptr);
+
+  options.use_global_thread_pools = true;
+  options.intra_op_threads = 8;
+  assert(!onnx_init_with_options(&options));
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(!onnx_init_with_options(nullptr));
+}
+
+static void test_load_options_and_memory() {
+  OnnxLoadOptions options;
+  onnx_default_load_options(&options);
+  assert(!options.use_gpu);
+  assert(options.enable_cpu_arena);
+  assert(options.enable_mem_pattern);
+  assert(options.arena_extend_strategy == ONNX_ARENA_EXTEND_NEXT_POWER_OF_TWO);
+  assert(options.arena_initial_chunk_bytes == 0);
+  onnx_default_load_options(nullptr);
+
+  options.enable_cpu_arena = false;
+  assert(onnx_load_model_with_options("model.onnx", &options) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_RUNTIME_NOT_FOUND);
+
+  // 内存占用：进程 RSS 与运行时无关，存根构建下同样可读。
+  OnnxMemoryUsage usage;
+  assert(onnx_get_memory_usage(nullptr, &usage) ==
+         ONNX_ERROR_RUNTIME_NOT_FOUND);
+  assert(usage.arena_reserved_bytes == -1);
+  assert(usage.plugin_reserved_bytes == 0);
+  assert(usage.process_rss_bytes > 0);
+  assert(usage.arena_trimmed_bytes == -1);
+  assert(onnx_trim_memory(nullptr) == ONNX_ERROR_RUNTIME_NOT_FOUND);
+}
+
+static void test_image_buffer_pool() {
+  // 暂存池不依赖运行时，存根构建下同样可用。
+  assert(onnx_acquire_image_buffer(0) == nullptr);
+  assert(onnx_get_last_error_code() == ONNX_ERROR_INVALID_ARGUMENT);
+
+  uint8_t *buffer = onnx_acquire_image_buffer(640 * 480 * 4);
+  assert(buffer != nullptr);
+  assert(onnx_get_last_error_code() == ONNX_OK);
+  buffer[0] = 1;
+  onnx_release_image_buffer(buffer);
+  onnx_release_image_buffer(nullptr);
+  assert(onnx_image_pool_cached_bytes() > 0);
+
+  onnx_cleanup();
+  assert(onnx_image_pool_cached_bytes() == 0);
+  assert(onnx_trim_image_buffers() == 0);
+}
+
 static void test_gpu_and_version() {
   // GPU 与版本查询在缺少运行时时返回安全默认值。
   const char *version = onnx_get_version();
@@ -93,9 +358,23 @@ static void test_unload_model_noop() {
 
 int main() {
   test_init_error();
+  test_runtime_search_paths();
+  test_init_options();
   test_load_model_error();
+  test_async_load_errors();
   test_get_input_size_errors();
   test_detect_errors();
+  test_stream_errors();
+  test_raw_cache_errors();
+  test_hash_files();
+  test_sweep_errors();
+  test_dedup();
+  test_cascade_errors();
+  test_tracker();
+  test_stats_errors();
+  test_profiling_errors();
+  test_load_options_and_memory();
+  test_image_buffer_pool();
   test_gpu_and_version();
   test_cleanup_resets_error();
   test_unload_model_noop();
@@ -3,9 +3,17 @@
  */
 #include "onnx_inference_utils.h"
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <chrono>
 #include <iostream>
+#include <mutex>
+#include <thread>
+#include <vector>
 
 static bool nearly_equal(float a, float b, float eps = 1e-4f) {
   // 简单的浮点比较辅助。
@@ -24,6 +32,26 @@ static Detection make_det(int class_id, float conf, float x, float y, float w,
   det.height = h;
   det.keypoints = nullptr;
   det.num_keypoints = 0;
+  det.polygon = nullptr;
+  det.num_polygon_points = 0;
+  det.angle = 0;
+  return det;
+}
+
+static Detection make_rotated_det(int class_id, float conf, float cx, float cy,
+                                  float w, float h, float angle,
+                                  float corners[8]) {
+  // 构建带 4 个角点的旋转框（单位正方形图像）。
+  Detection det = make_det(class_id, conf, cx, cy, w, h);
+  float c = std::cos(angle), s = std::sin(angle);
+  const float signs[4][2] = {{1, 1}, {1, -1}, {-1, -1}, {-1, 1}};
+  for (int k = 0; k < 4; k++) {
+    corners[k * 2] = cx + signs[k][0] * w / 2 * c - signs[k][1] * h / 2 * s;
+    corners[k * 2 + 1] = cy + signs[k][0] * w / 2 * s + signs[k][1] * h / 2 * c;
+  }
+  det.polygon = corners;
+  det.num_polygon_points = 4;
+  det.angle = angle;
   return det;
 }
 
@@ -89,6 +117,632 @@ static void test_nms_diff_class() {
   assert(filtered.size() == 2);
 }
 
+static void test_nms_inplace_compacts_survivors() {
+  Detection dets[4] = {
+      make_det(0, 0.6f, 0.5f, 0.5f, 0.4f, 0.4f),
+      make_det(0, 0.9f, 0.52f, 0.5f, 0.4f, 0.4f),
+      make_det(1, 0.7f, 0.5f, 0.5f, 0.4f, 0.4f),
+      make_det(0, 0.8f, 0.1f, 0.1f, 0.1f, 0.1f),
+  };
+  size_t kept = onnx_nms_inplace(dets, 4, 0.5f);
+  assert(kept == 3);
+  assert(nearly_equal(dets[0].confidence, 0.9f));
+  assert(nearly_equal(dets[1].confidence, 0.8f));
+  assert(nearly_equal(dets[2].confidence, 0.7f));
+  assert(onnx_nms_inplace(nullptr, 0, 0.5f) == 0);
+}
+
+// 构造 [num_features, num_boxes] 布局的输出：box 0 高分、box 1 低分。
+static void test_rotated_iou() {
+  const float kPi = 3.14159265f;
+  float qa[8], qb[8], qc[8];
+  Detection a = make_rotated_det(0, 0.9f, 0.5f, 0.5f, 0.2f, 0.2f, 0, qa);
+  Detection b = make_rotated_det(0, 0.8f, 0.5f, 0.5f, 0.2f, 0.2f, kPi / 4, qb);
+  Detection c = make_rotated_det(0, 0.7f, 0.9f, 0.9f, 0.1f, 0.1f, 0.3f, qc);
+
+  assert(nearly_equal(onnx_rotated_iou(a, a), 1.0f));
+  // 正方形与其 45° 旋转的 IoU 为 sqrt(2)/2。
+  assert(nearly_equal(onnx_rotated_iou(a, b), std::sqrt(2.0f) / 2, 1e-3f));
+  assert(nearly_equal(onnx_rotated_iou(b, a), std::sqrt(2.0f) / 2, 1e-3f));
+  assert(nearly_equal(onnx_rotated_iou(a, c), 0.0f));
+
+  // 缺少角点时退回轴对齐 IoU。
+  Detection plain = make_det(0, 0.9f, 0.5f, 0.5f, 0.2f, 0.2f);
+  assert(nearly_equal(onnx_rotated_iou(plain, a), onnx_iou(plain, a)));
+}
+
+static void test_nms_rotated() {
+  const float kPi = 3.14159265f;
+  float q[4][8];
+  // 细长框交叉成 X：轴对齐包围盒几乎重合，但旋转 IoU 很小。
+  Detection dets[4] = {
+      make_rotated_det(0, 0.9f, 0.5f, 0.5f, 0.4f, 0.05f, kPi / 4, q[0]),
+      make_rotated_det(0, 0.8f, 0.5f, 0.5f, 0.4f, 0.05f, -kPi / 4, q[1]),
+      make_rotated_det(0, 0.7f, 0.51f, 0.5f, 0.4f, 0.05f, kPi / 4, q[2]),
+      make_rotated_det(1, 0.6f, 0.5f, 0.5f, 0.4f, 0.05f, kPi / 4, q[3]),
+  };
+  assert(onnx_iou(dets[0], dets[1]) > 0.9f);
+
+  size_t kept = onnx_nms_rotated_inplace(dets, 4, 0.5f);
+  assert(kept == 3);
+  assert(nearly_equal(dets[0].confidence, 0.9f));
+  assert(nearly_equal(dets[1].confidence, 0.8f));
+  assert(nearly_equal(dets[2].confidence, 0.6f));
+}
+
+static void check_nms_sweep(bool rotated) {
+  const float kPi = 3.14159265f;
+  const int n = 240;
+  // 成簇分布的候选框，置信度互不相同（避免并列时排序不确定）。
+  std::vector<Detection> dets(n);
+  std::vector<float> corners((size_t)n * 8);
+  uint32_t state = 12345;
+  auto next = [&]() {
+    state = state * 1664525u + 1013904223u;
+    return (float)(state >> 8) / (float)(1u << 24);
+  };
+  for (int i = 0; i < n; i++) {
+    int cluster = i % 9;
+    float cx = 0.2f + (cluster % 3) * 0.3f + next() * 0.06f;
+    float cy = 0.2f + (cluster / 3) * 0.3f + next() * 0.06f;
+    float conf = (float)((i * 97) % n + 1) / (float)(n + 1);
+    dets[i] = make_rotated_det(i % 3, conf, cx, cy, 0.1f + next() * 0.05f,
+                               0.05f + next() * 0.05f,
+                               rotated ? next() * kPi : 0,
+                               &corners[(size_t)i * 8]);
+    if (!rotated) {
+      dets[i].polygon = nullptr;
+      dets[i].num_polygon_points = 0;
+    }
+  }
+
+  const float nms[3] = {0.3f, 0.5f, 0.7f};
+  std::vector<Detection> swept = dets;
+  std::vector<std::vector<uint32_t>> kept;
+  size_t total = onnx_nms_sweep(swept.data(), n, nms, 3, rotated, &kept);
+  assert(kept.size() == 3);
+  assert(total >= kept[0].size() && total < (size_t)n);
+
+  for (int j = 0; j < 3; j++) {
+    for (float conf : {0.0f, 0.3f, 0.6f}) {
+      std::vector<Detection> fresh;
+      for (const Detection &det : dets) {
+        if (det.confidence >= conf)
+          fresh.push_back(det);
+      }
+      size_t expected =
+          rotated ? onnx_nms_rotated_inplace(fresh.data(), fresh.size(), nms[j])
+                  : onnx_nms_inplace(fresh.data(), fresh.size(), nms[j]);
+      size_t got = 0;
+      for (uint32_t index : kept[j]) {
+        const Detection &det = swept[index];
+        if (det.confidence < conf)
+          break;
+        assert(got < expected);
+        assert(det.confidence == fresh[got].confidence);
+        assert(det.class_id == fresh[got].class_id);
+        assert(det.x == fresh[got].x && det.y == fresh[got].y);
+        got++;
+      }
+      assert(got == expected);
+    }
+  }
+
+  // 阈值数越界时不做处理。
+  float too_many[kMaxSweepNmsThresholds + 1] = {};
+  assert(onnx_nms_sweep(swept.data(), n, too_many,
+                        kMaxSweepNmsThresholds + 1, rotated, &kept) == 0);
+  assert(kept.size() == (size_t)kMaxSweepNmsThresholds + 1);
+  assert(kept[0].empty());
+}
+
+static void test_nms_sweep() {
+  check_nms_sweep(false);
+  check_nms_sweep(true);
+}
+
+static std::vector<float> make_pose_output(int num_classes, int num_kpts,
+                                           int num_boxes) {
+  int num_features = 4 + num_classes + num_kpts * 3;
+  std::vector<float> out(num_features * num_boxes, 0.0f);
+  auto at = [&](int f, int b) -> float & { return out[f * num_boxes + b]; };
+  at(0, 0) = 320.0f;
+  at(1, 0) = 320.0f;
+  at(2, 0) = 64.0f;
+  at(3, 0) = 32.0f;
+  at(4 + num_classes - 1, 0) = 0.9f;
+  at(4, 1) = 0.1f;
+  for (int k = 0; k < num_kpts; k++) {
+    at(4 + num_classes + k * 3 + 0, 0) = 160.0f;
+    at(4 + num_classes + k * 3 + 1, 0) = 480.0f;
+    at(4 + num_classes + k * 3 + 2, 0) = 0.7f;
+  }
+  return out;
+}
+
+static void test_parse_pose_output() {
+  const int num_classes = 2;
+  const int num_kpts = 2;
+  const int num_boxes = 3;
+  std::vector<float> out = make_pose_output(num_classes, num_kpts, num_boxes);
+  DetectionScratch scratch;
+  parse_yolov8_output(out.data(), 4 + num_classes + num_kpts * 3, num_boxes,
+                      MODEL_TYPE_YOLO_POSE, num_kpts, 0.25f, 1.0f, 1.0f, 0, 0,
+                      640, 640, &scratch);
+  assert(scratch.candidates.size() == 1);
+  const Detection &det = scratch.candidates[0];
+  assert(det.class_id == num_classes - 1);
+  assert(nearly_equal(det.x, 0.5f));
+  assert(nearly_equal(det.width, 0.1f));
+  assert(det.num_keypoints == num_kpts);
+  assert(nearly_equal(det.keypoints[0], 0.25f));
+  assert(nearly_equal(det.keypoints[1], 0.75f));
+  assert(nearly_equal(det.keypoints[2], 0.7f));
+
+  // 复用暂存区时应清空旧候选框。
+  parse_yolov8_output(out.data(), 4 + num_classes + num_kpts * 3, num_boxes,
+                      MODEL_TYPE_YOLO_POSE, num_kpts, 0.95f, 1.0f, 1.0f, 0, 0,
+                      640, 640, &scratch);
+  assert(scratch.candidates.empty());
+}
+
+static void test_parse_obb_output() {
+  // 1 个候选框、2 个类别：[cx, cy, w, h, c0, c1, angle]。
+  const float kPi = 3.14159265f;
+  std::vector<float> output = {50, 50, 40, 20, 0.1f, 0.9f, kPi / 2};
+  DetectionScratch scratch;
+  parse_yolov8_output(output.data(), 7, 1, MODEL_TYPE_YOLO_OBB, 0, 0.25f, 1.0f,
+                      1.0f, 0, 0, 100, 100, &scratch);
+  assert(scratch.candidates.size() == 1);
+  const Detection &det = scratch.candidates[0];
+  assert(det.class_id == 1);
+  assert(nearly_equal(det.angle, kPi / 2));
+  assert(det.num_polygon_points == 4);
+  // 旋转 90° 后角点包围盒为 20x40。
+  float min_x = 1, max_x = 0, min_y = 1, max_y = 0;
+  for (int k = 0; k < 4; k++) {
+    min_x = std::min(min_x, det.polygon[k * 2]);
+    max_x = std::max(max_x, det.polygon[k * 2]);
+    min_y = std::min(min_y, det.polygon[k * 2 + 1]);
+    max_y = std::max(max_y, det.polygon[k * 2 + 1]);
+  }
+  assert(nearly_equal(max_x - min_x, 0.2f, 1e-3f));
+  assert(nearly_equal(max_y - min_y, 0.4f, 1e-3f));
+}
+
+static void test_parse_end2end_output() {
+  // 3 行 [x1, y1, x2, y2, score, class]，末行为得分 0 的填充行。
+  std::vector<float> output = {10, 20, 30, 60, 0.9f, 2, //
+                               40, 40, 80, 80, 0.1f, 0, //
+                               0,  0,  0,  0,  0.0f, 0};
+  DetectionScratch scratch;
+  parse_end2end_output(output.data(), 6, 3, MODEL_TYPE_YOLO, 0, 0.25f, 1.0f,
+                       1.0f, 0, 0, 100, 100, &scratch);
+  assert(scratch.candidates.size() == 1);
+  const Detection &det = scratch.candidates[0];
+  assert(det.class_id == 2);
+  assert(nearly_equal(det.x, 0.2f));
+  assert(nearly_equal(det.y, 0.4f));
+  assert(nearly_equal(det.width, 0.2f));
+  assert(nearly_equal(det.height, 0.4f));
+  assert(det.polygon == nullptr);
+
+  // 姿态行在 6 项后接关键点。
+  std::vector<float> pose = {0, 0, 50, 50, 0.8f, 0, 25, 30, 0.9f};
+  parse_end2end_output(pose.data(), 9, 1, MODEL_TYPE_YOLO_POSE, 1, 0.25f,
+                       1.0f, 1.0f, 0, 0, 100, 100, &scratch);
+  assert(scratch.candidates.size() == 1);
+  assert(scratch.candidates[0].num_keypoints == 1);
+  assert(nearly_equal(scratch.candidates[0].keypoints[1], 0.3f));
+}
+
+static void test_pack_result_reports_required_capacity() {
+  float kpts[6] = {0.1f, 0.2f, 0.9f, 0.3f, 0.4f, 0.8f};
+  Detection dets[2] = {make_det(0, 0.9f, 0.5f, 0.5f, 0.2f, 0.2f),
+                       make_det(1, 0.8f, 0.2f, 0.2f, 0.1f, 0.1f)};
+  dets[0].keypoints = kpts;
+  dets[0].num_keypoints = 2;
+
+  Detection storage[2];
+  uint8_t arena[64];
+  OnnxResultBuffer buf{};
+  buf.detections = storage;
+  buf.capacity = 1;
+  buf.arena = arena;
+  buf.arena_capacity = sizeof(arena);
+
+  int code = onnx_pack_result(dets, 2, &buf);
+  assert(code == ONNX_ERROR_BUFFER_TOO_SMALL);
+  assert(buf.count == 0);
+  assert(buf.required_capacity == 2);
+  assert(buf.required_arena == 6 * (int64_t)sizeof(float));
+
+  buf.capacity = 2;
+  code = onnx_pack_result(dets, 2, &buf);
+  assert(code == ONNX_OK);
+  assert(buf.count == 2);
+  assert(buf.arena_used == 6 * (int64_t)sizeof(float));
+  assert(storage[0].keypoints == (float *)arena);
+  assert(nearly_equal(storage[0].keypoints[4], 0.4f));
+  assert(storage[1].keypoints == nullptr);
+}
+
+static void test_copy_and_release_detections() {
+  float kpts[3] = {0.1f, 0.2f, 0.9f};
+  float polygon[6] = {0.1f, 0.1f, 0.9f, 0.1f, 0.5f, 0.9f};
+  Detection det = make_det(0, 0.9f, 0.5f, 0.5f, 0.2f, 0.2f);
+  det.keypoints = kpts;
+  det.num_keypoints = 1;
+  det.polygon = polygon;
+  det.num_polygon_points = 3;
+
+  DetectionResult result{};
+  assert(onnx_copy_detections(&det, 1, &result));
+  assert(result.count == 1);
+  assert(result.detections[0].keypoints != kpts);
+  assert(nearly_equal(result.detections[0].keypoints[2], 0.9f));
+  assert(result.detections[0].polygon != polygon);
+  assert(result.detections[0].num_polygon_points == 3);
+  assert(nearly_equal(result.detections[0].polygon[5], 0.9f));
+  onnx_release_detections(&result);
+  assert(result.detections == nullptr);
+  assert(result.count == 0);
+
+  assert(onnx_copy_detections(nullptr, 0, &result));
+  assert(result.detections == nullptr);
+}
+
+static void test_mask_logits_crop() {
+  // 两个原型通道 4x3，裁剪区域 [1,3) x [1,3)。
+  const int pw = 4, ph = 3;
+  std::vector<float> protos(2 * pw * ph);
+  for (int i = 0; i < pw * ph; i++) {
+    protos[i] = (float)i;
+    protos[pw * ph + i] = 1.0f;
+  }
+  float coeffs[2] = {2.0f, -1.0f};
+  float out[4];
+  onnx_mask_logits(coeffs, protos.data(), 2, pw, ph, 1, 1, 3, 3, out);
+  assert(nearly_equal(out[0], 2.0f * 5 - 1));
+  assert(nearly_equal(out[1], 2.0f * 6 - 1));
+  assert(nearly_equal(out[2], 2.0f * 9 - 1));
+  assert(nearly_equal(out[3], 2.0f * 10 - 1));
+}
+
+static void test_trace_contour_largest_component() {
+  // 左侧 1 像素噪点，右侧 3x2 矩形。
+  const int w = 6, h = 4;
+  uint8_t mask[w * h] = {
+      1, 0, 0, 0, 0, 0, //
+      0, 0, 1, 1, 1, 0, //
+      0, 0, 1, 1, 1, 0, //
+      0, 0, 0, 0, 0, 0, //
+  };
+  MaskScratch scratch;
+  size_t n = onnx_trace_mask_contour(mask, w, h, &scratch);
+  // 矩形外轮廓共 6 个边界像素，起点为左上角。
+  assert(n == 6);
+  assert(nearly_equal(scratch.contour[0], 2.0f));
+  assert(nearly_equal(scratch.contour[1], 1.0f));
+  for (size_t i = 0; i < n; i++) {
+    assert(scratch.contour[i * 2] >= 2.0f);
+  }
+
+  n = onnx_simplify_polygon(scratch.contour.data(), n, 0.5f,
+                            scratch.contour.data(), &scratch);
+  assert(n == 4);
+
+  uint8_t empty[4] = {0, 0, 0, 0};
+  assert(onnx_trace_mask_contour(empty, 2, 2, &scratch) == 0);
+}
+
+static void test_assemble_masks_to_polygon() {
+  // 32x32 输入，8x8 原型；通道 0 在 [2,6) x [2,6) 为正，其余为负。
+  const int pw = 8, ph = 8;
+  std::vector<float> protos((size_t)kSegMaskCoeffs * pw * ph, 0.0f);
+  for (int y = 0; y < ph; y++) {
+    for (int x = 0; x < pw; x++) {
+      bool inside = x >= 2 && x < 6 && y >= 2 && y < 6;
+      protos[y * pw + x] = inside ? 1.0f : -1.0f;
+    }
+  }
+
+  // 构造 4 + 1 + 32 维输出，唯一候选框覆盖整张图片。
+  const int num_boxes = 1;
+  const int num_features = 4 + 1 + kSegMaskCoeffs;
+  std::vector<float> out(num_features * num_boxes, 0.0f);
+  out[0] = 16.0f;
+  out[1] = 16.0f;
+  out[2] = 32.0f;
+  out[3] = 32.0f;
+  out[4] = 0.9f;
+  out[5] = 1.0f; // 系数 0
+
+  DetectionScratch scratch;
+  parse_yolov8_output(out.data(), num_features, num_boxes, MODEL_TYPE_YOLO_SEG,
+                      0, 0.25f, 1.0f, 1.0f, 0, 0, 32, 32, &scratch);
+  assert(scratch.candidates.size() == 1);
+  assert(scratch.candidates[0].class_id == 0);
+  assert(scratch.candidates[0].num_polygon_points == 0);
+
+  MaskPrototypes mp;
+  mp.data = protos.data();
+  mp.width = pw;
+  mp.height = ph;
+  mp.input_width = 32;
+  mp.input_height = 32;
+  assemble_yolov8_masks(scratch.candidates.data(), 1, mp, 1.0f, 1.0f, 0, 0,
+                        32, 32, 0.5f, &scratch);
+  const Detection &det = scratch.candidates[0];
+  assert(det.num_polygon_points == 4);
+  for (int k = 0; k < det.num_polygon_points; k++) {
+    float x = det.polygon[k * 2];
+    float y = det.polygon[k * 2 + 1];
+    // 原型像素中心 2.5 / 5.5 -> 输入 10 / 22 -> 归一化。
+    assert(nearly_equal(x, 10.0f / 32) || nearly_equal(x, 22.0f / 32));
+    assert(nearly_equal(y, 10.0f / 32) || nearly_equal(y, 22.0f / 32));
+  }
+
+  // 无原型输出时清除暂存的系数指针。
+  parse_yolov8_output(out.data(), num_features, num_boxes, MODEL_TYPE_YOLO_SEG,
+                      0, 0.25f, 1.0f, 1.0f, 0, 0, 32, 32, &scratch);
+  assemble_yolov8_masks(scratch.candidates.data(), 1, MaskPrototypes(), 1.0f,
+                        1.0f, 0, 0, 32, 32, 0.5f, &scratch);
+  assert(scratch.candidates[0].polygon == nullptr);
+  assert(scratch.candidates[0].num_polygon_points == 0);
+}
+
+static void test_histogram_percentiles() {
+  StageHistogram histogram;
+  assert(onnx_histogram_percentile(histogram, 0.5) == 0);
+  // 98 个 1ms 样本与 2 个 100ms 样本。
+  for (int i = 0; i < 98; i++) {
+    onnx_histogram_record(&histogram, 1.0);
+  }
+  onnx_histogram_record(&histogram, 100.0);
+  onnx_histogram_record(&histogram, 100.0);
+  assert(histogram.samples == 100);
+
+  // 档上界相对误差不超过 2^(1/4)。
+  double p50 = onnx_histogram_percentile(histogram, 0.50);
+  double p99 = onnx_histogram_percentile(histogram, 0.99);
+  assert(p50 >= 1.0 && p50 <= 1.0 * 1.19);
+  assert(p99 >= 100.0 && p99 <= 100.0 * 1.19);
+  assert(onnx_histogram_percentile(histogram, 0.95) == p50);
+}
+
+static void test_stats_commit_and_snapshot() {
+  ModelStats stats;
+  stats.current_ms[ONNX_STAGE_PREPROCESS] = 2.0;
+  stats.current_ms[ONNX_STAGE_RUN] = 8.0;
+  stats.images = 1;
+  onnx_stats_commit(&stats);
+
+  OnnxStats out{};
+  stats.dedup_skipped = 3;
+  stats.cascade_images = 5;
+  stats.cascade_escalated = 2;
+  onnx_stats_snapshot(stats, &out);
+  assert(out.calls == 1);
+  assert(out.dedup_skipped == 3);
+  assert(out.cascade_images == 5 && out.cascade_escalated == 2);
+  assert(out.images == 1);
+  assert(nearly_equal((float)out.last_ms[ONNX_STAGE_TOTAL], 10.0f));
+  assert(out.p50_ms[ONNX_STAGE_RUN] >= 8.0);
+  // 未执行的阶段不计入分布。
+  assert(out.p50_ms[ONNX_STAGE_MASKS] == 0);
+  assert(stats.current_ms[ONNX_STAGE_RUN] == 0);
+}
+
+static void test_stage_timer_records_trace() {
+  // 未开启分析时只计时，开启后同时记录片段。
+  ModelStats stats;
+  {
+    StageTimer timer(&stats, ONNX_STAGE_NMS);
+  }
+  std::vector<TraceSpan> trace;
+  stats.trace = &trace;
+  {
+    StageTimer timer(&stats, ONNX_STAGE_PARSE);
+  }
+  assert(trace.size() == 1);
+  assert(strcmp(trace[0].name, "parse") == 0);
+  assert(trace[0].start_ns > 0);
+  assert(trace[0].dur_ns >= 0);
+}
+
+static void test_merge_trace() {
+  std::vector<TraceSpan> spans = {{"detect_batch", 5000000, 3000000},
+                                  {"nms", 6000000, 1500}};
+  std::string ort =
+      "[\n{\"cat\":\"Session\",\"ts\":10,\"name\":\"model_run\"},\n]\n";
+  std::string merged = onnx_merge_trace(ort, spans, 1000000, 42);
+  assert(merged.front() == '[');
+  assert(merged.find("\"name\":\"model_run\"}") != std::string::npos);
+  assert(merged.find("},\n]") == std::string::npos);
+  // 片段换算为相对 ORT 起点的微秒。
+  assert(merged.find("\"dur\":3000,\"ts\":4000,\"ph\":\"X\",\"name\":"
+                     "\"detect_batch\"") != std::string::npos);
+  assert(merged.find("\"dur\":1,\"ts\":5000") != std::string::npos);
+  assert(merged.find("\"pid\":42") != std::string::npos);
+
+  // ORT 输出缺失时仍生成合法数组。
+  std::string only_ours = onnx_merge_trace("", spans, 0, 1);
+  assert(only_ours.compare(0, 3, "[\n{") == 0);
+  assert(only_ours.find("\n]\n") == only_ours.size() - 3);
+}
+
+static void test_image_pool_reuses_size_class() {
+  ImageBufferPool pool;
+  uint8_t *a = onnx_pool_acquire(&pool, 1000);
+  assert(a != nullptr);
+  assert(((uintptr_t)a % 16) == 0);
+  assert(pool.in_use_bytes == (int64_t(1) << kImagePoolMinShift));
+
+  onnx_pool_release(&pool, a);
+  assert(pool.in_use_bytes == 0);
+  assert(pool.cached_bytes == (int64_t(1) << kImagePoolMinShift));
+
+  // 同一尺寸等级的请求复用缓存缓冲区。
+  uint8_t *b = onnx_pool_acquire(&pool, 60000);
+  assert(b == a);
+  assert(pool.cached_bytes == 0);
+  onnx_pool_release(&pool, b);
+
+  assert(onnx_pool_clear(&pool) == (int64_t(1) << kImagePoolMinShift));
+  assert(pool.cached_bytes == 0);
+}
+
+static void test_image_pool_trim_to_high_water() {
+  ImageBufferPool pool;
+  const int64_t unit = int64_t(1) << kImagePoolMinShift;
+  uint8_t *a = onnx_pool_acquire(&pool, unit);
+  uint8_t *b = onnx_pool_acquire(&pool, unit);
+  onnx_pool_release(&pool, a);
+  onnx_pool_release(&pool, b);
+
+  // 高水位为两个缓冲区，收缩不释放任何缓存，但重置高水位。
+  assert(onnx_pool_trim(&pool) == 0);
+  assert(pool.high_water == 0);
+
+  // 之后只使用一个缓冲区，再次收缩时回收多余的一个。
+  uint8_t *c = onnx_pool_acquire(&pool, unit);
+  onnx_pool_release(&pool, c);
+  assert(onnx_pool_trim(&pool) == unit);
+  assert(pool.cached_bytes == unit);
+
+  onnx_pool_clear(&pool);
+}
+
+// 模拟清理时仍有后台加载：等待方在计数归零（加载线程结束）后才返回。
+static void test_inflight_wait_for_pending_load() {
+  std::mutex mutex;
+  InflightCounter counter;
+  bool finished = false;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    onnx_inflight_begin(&counter);
+  }
+  std::thread load([&] {
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::lock_guard<std::mutex> lock(mutex);
+    finished = true;
+    onnx_inflight_end(&counter);
+  });
+
+  std::unique_lock<std::mutex> lock(mutex);
+  onnx_inflight_wait(&counter, lock);
+  assert(finished && counter.count == 0);
+  // 无进行中的加载时立即返回。
+  onnx_inflight_wait(&counter, lock);
+  lock.unlock();
+  load.join();
+}
+
+static void test_process_rss_tracks_touched_memory() {
+  int64_t before = onnx_process_rss_bytes();
+  assert(before > 0);
+
+  // 写入 64 MiB 后常驻内存至少增长一半（避免受分配器缓存影响）。
+  const size_t size = (size_t)64 << 20;
+  uint8_t *block = (uint8_t *)malloc(size);
+  assert(block);
+  memset(block, 1, size);
+  int64_t after = onnx_process_rss_bytes();
+  assert(after - before >= (int64_t)(size / 2));
+  free(block);
+}
+
+static void test_dhash_and_plan_dedup() {
+  // 水平渐变：左暗右亮，所有相邻格比较都不成立；反向渐变则全部成立。
+  const int w = 90, h = 40;
+  std::vector<uint8_t> ramp((size_t)w * h * 4, 255);
+  for (int y = 0; y < h; y++) {
+    for (int x = 0; x < w; x++) {
+      uint8_t *p = &ramp[((size_t)y * w + x) * 4];
+      p[0] = p[1] = p[2] = (uint8_t)(x * 2);
+    }
+  }
+  assert(onnx_dhash_rgba(ramp.data(), w, h) == 0);
+  std::vector<uint8_t> reversed = ramp;
+  for (size_t i = 0; i < reversed.size(); i += 4) {
+    reversed[i] = reversed[i + 1] = reversed[i + 2] = 255 - reversed[i];
+  }
+  assert(onnx_dhash_rgba(reversed.data(), w, h) == ~0ULL);
+  // 轻微噪声不改变哈希；1x1 图片与空指针不崩溃。
+  std::vector<uint8_t> noisy = reversed;
+  noisy[4 * 17] ^= 1;
+  assert(onnx_dhash_rgba(noisy.data(), w, h) == ~0ULL);
+  const uint8_t pixel[4] = {10, 20, 30, 255};
+  assert(onnx_dhash_rgba(pixel, 1, 1) == 0);
+  assert(onnx_dhash_rgba(nullptr, w, h) == 0);
+
+  assert(onnx_hamming64(0, ~0ULL) == 64);
+  assert(onnx_hamming64(0xF0, 0x0F) == 8);
+
+  // 参照为最近一张实际推理的图片，尺寸不同时不复用。
+  const uint64_t hashes[5] = {0x0, 0x3, 0xFF, 0xFF, 0xFF};
+  const int widths[5] = {8, 8, 8, 8, 4};
+  const int heights[5] = {8, 8, 8, 8, 8};
+  int source[5];
+  DedupReference reference;
+  assert(onnx_plan_dedup(hashes, widths, heights, 5, 2, &reference, source) ==
+         2);
+  assert(source[0] == -1 && source[1] == 0 && source[2] == -1 &&
+         source[3] == 2 && source[4] == -1);
+  assert(reference.valid && reference.hash == 0xFF && reference.width == 4);
+
+  // 跨调用时复用上一次调用的参照；关闭时全部推理。
+  assert(onnx_plan_dedup(hashes + 4, widths + 4, heights + 4, 1, 0,
+                         &reference, source) == 1);
+  assert(source[0] == -2);
+  DedupReference fresh;
+  assert(onnx_plan_dedup(hashes, widths, heights, 5, -1, &fresh, source) == 0);
+  for (int i = 0; i < 5; i++) {
+    assert(source[i] == -1);
+  }
+}
+
+static void test_cascade_escalation_and_filter() {
+  OnnxCascadeOptions options;
+  options.uncertain_low = 0.1f;
+  options.uncertain_high = 0.5f;
+  options.min_uncertain = 2;
+  options.escalate_empty = true;
+  options.heavy_batch_size = 0;
+  assert(onnx_cascade_options_valid(options));
+
+  // 区间为 [low, high)：0.5 不算不确定，需 2 个区间内的检测才升级。
+  Detection dets[3] = {};
+  dets[0].confidence = 0.9f;
+  dets[1].confidence = 0.5f;
+  dets[2].confidence = 0.1f;
+  assert(!onnx_cascade_should_escalate(dets, 3, options));
+  dets[1].confidence = 0.3f;
+  assert(onnx_cascade_should_escalate(dets, 3, options));
+  assert(onnx_cascade_should_escalate(dets, 0, options));
+  options.escalate_empty = false;
+  assert(!onnx_cascade_should_escalate(dets, 0, options));
+
+  options.uncertain_high = 0.05f;
+  assert(!onnx_cascade_options_valid(options));
+  options.uncertain_high = 0.5f;
+  options.min_uncertain = 0;
+  assert(!onnx_cascade_options_valid(options));
+
+  // 过滤保持顺序并释放被删检测的关键点。
+  float kpts[3] = {0.5f, 0.5f, 1.0f};
+  dets[2].keypoints = kpts;
+  dets[2].num_keypoints = 1;
+  DetectionResult result;
+  assert(onnx_copy_detections(dets, 3, &result));
+  onnx_filter_result(&result, 0.25f);
+  assert(result.count == 2);
+  assert(result.detections[0].confidence == 0.9f);
+  assert(result.detections[1].confidence == 0.3f);
+  onnx_release_detections(&result);
+}
+
 int main() {
   test_iou_identical();
   test_iou_no_overlap();
@@ -98,6 +752,28 @@ int main() {
   test_nms_empty();
   test_nms_sorting();
   test_nms_diff_class();
+  test_nms_inplace_compacts_survivors();
+  test_rotated_iou();
+  test_nms_rotated();
+  test_nms_sweep();
+  test_parse_pose_output();
+  test_parse_obb_output();
+  test_parse_end2end_output();
+  test_pack_result_reports_required_capacity();
+  test_copy_and_release_detections();
+  test_mask_logits_crop();
+  test_trace_contour_largest_component();
+  test_assemble_masks_to_polygon();
+  test_histogram_percentiles();
+  test_stats_commit_and_snapshot();
+  test_stage_timer_records_trace();
+  test_merge_trace();
+  test_image_pool_reuses_size_class();
+  test_image_pool_trim_to_high_water();
+  test_inflight_wait_for_pending_load();
+  test_process_rss_tracks_touched_memory();
+  test_dhash_and_plan_dedup();
+  test_cascade_escalation_and_filter();
   std::cout << "onnx_inference_utils_test passed\n";
   return 0;
 }
@@ -0,0 +1,268 @@
+/**
+ * 原始输出缓存测试
+ */
+#include "onnx_raw_cache.h"
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// 确定性伪随机数（0-1）。
+static float next_random(uint32_t *state) {
+  *state = *state * 1664525u + 1013904223u;
+  return (float)(*state >> 8) / (float)(1u << 24);
+}
+
+// 构造 [num_features, num_boxes] 的 YOLOv8 输出：框成簇分布以触发 NMS，
+// 得分在 0-1 间均匀分布。extra 为类别之后的附加特征数（关键点或角度）。
+static std::vector<float> make_random_output(int num_classes, int extra,
+                                             int num_boxes, uint32_t seed) {
+  int num_features = 4 + num_classes + extra;
+  std::vector<float> out((size_t)num_features * num_boxes, 0.0f);
+  auto at = [&](int f, int b) -> float & {
+    return out[(size_t)f * num_boxes + b];
+  };
+  uint32_t state = seed;
+  for (int b = 0; b < num_boxes; b++) {
+    int cluster = b % 12;
+    at(0, b) = 60.0f + (cluster % 4) * 150.0f + next_random(&state) * 20.0f;
+    at(1, b) = 80.0f + (cluster / 4) * 180.0f + next_random(&state) * 20.0f;
+    at(2, b) = 80.0f + next_random(&state) * 40.0f;
+    at(3, b) = 60.0f + next_random(&state) * 40.0f;
+    for (int c = 0; c < num_classes; c++) {
+      at(4 + c, b) = next_random(&state);
+    }
+    for (int k = 0; k < extra; k++) {
+      at(4 + num_classes + k, b) = next_random(&state) * 600.0f;
+    }
+  }
+  return out;
+}
+
+static void assert_same_detections(const Detection *a, const Detection *b,
+                                   size_t count) {
+  for (size_t i = 0; i < count; i++) {
+    assert(a[i].class_id == b[i].class_id);
+    assert(a[i].confidence == b[i].confidence);
+    assert(a[i].x == b[i].x && a[i].y == b[i].y);
+    assert(a[i].width == b[i].width && a[i].height == b[i].height);
+    assert(a[i].angle == b[i].angle);
+    assert(a[i].num_keypoints == b[i].num_keypoints);
+    assert(a[i].num_polygon_points == b[i].num_polygon_points);
+    if (a[i].num_keypoints > 0) {
+      assert(memcmp(a[i].keypoints, b[i].keypoints,
+                    (size_t)a[i].num_keypoints * 3 * sizeof(float)) == 0);
+    }
+    if (a[i].num_polygon_points > 0) {
+      assert(memcmp(a[i].polygon, b[i].polygon,
+                    (size_t)a[i].num_polygon_points * 2 * sizeof(float)) ==
+             0);
+    }
+  }
+}
+
+static void test_hash_known_vectors() {
+  assert(onnx_hash64("", 0) == 0xEF46DB3751D8E999ULL);
+  assert(onnx_hash64("abc", 3) == 0x44BC2CF5AD770999ULL);
+
+  // 覆盖 32 字节分块、8/4/1 字节尾部路径，且对内容敏感。
+  std::vector<uint8_t> data(1000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = (uint8_t)(i * 31);
+  }
+  for (size_t size : {1u, 4u, 8u, 31u, 32u, 33u, 63u, 1000u}) {
+    uint64_t h = onnx_hash64(data.data(), size);
+    assert(h == onnx_hash64(data.data(), size));
+    data[size - 1] ^= 1;
+    assert(h != onnx_hash64(data.data(), size));
+    data[size - 1] ^= 1;
+  }
+  assert(onnx_hash64(data.data(), 64, 1) != onnx_hash64(data.data(), 64, 2));
+}
+
+static void test_hash_mapped_file() {
+  fs::path dir = fs::temp_directory_path() / "onnx_raw_cache_test_hash";
+  fs::create_directories(dir);
+  fs::path file = dir / "model.bin";
+
+  std::string small(5000, 'x');
+  std::ofstream(file, std::ios::binary) << small;
+  uint64_t h = 0;
+  assert(onnx_hash_mapped_file(file.string(), &h));
+  assert(h == onnx_hash64(small.data(), small.size()));
+
+  // 超过 1 MiB 的文件同样是对整个内容的一次哈希（模型与图片键一致）。
+  std::string large((1 << 20) + 100, 'y');
+  std::ofstream(file, std::ios::binary | std::ios::trunc) << large;
+  assert(onnx_hash_mapped_file(file.string(), &h));
+  assert(h == onnx_hash64(large.data(), large.size()));
+  std::ofstream(file, std::ios::binary | std::ios::trunc);
+  assert(onnx_hash_mapped_file(file.string(), &h));
+  assert(h == onnx_hash64(nullptr, 0));
+  assert(!onnx_hash_mapped_file((dir / "missing.bin").string(), &h));
+  assert(!onnx_hash_mapped_file(dir.string(), &h));
+  fs::remove_all(dir);
+}
+
+static void test_rethreshold_matches_fresh_parse(int model_type,
+                                                 int num_keypoints) {
+  const int num_classes = 3;
+  const int num_boxes = 600;
+  int extra = model_type == MODEL_TYPE_YOLO_POSE ? num_keypoints * 3 : 1;
+  std::vector<float> out =
+      make_random_output(num_classes, extra, num_boxes, 42);
+  int num_features = 4 + num_classes + extra;
+
+  // 以下限解析一次并编码，模拟写入缓存。
+  DetectionScratch parsed;
+  parse_yolov8_output(out.data(), num_features, num_boxes, model_type,
+                      num_keypoints, kRawCacheMinConfidence, 0.8f, 0.8f, 0,
+                      64, 800, 600, &parsed);
+  std::string entry;
+  onnx_raw_cache_encode(parsed.candidates.data(), parsed.candidates.size(),
+                        model_type, num_keypoints, kRawCacheMinConfidence,
+                        &entry);
+
+  DetectionScratch fresh;
+  DetectionScratch cached;
+  for (float conf : {0.05f, 0.25f, 0.5f, 0.9f, 1.1f}) {
+    for (float nms : {0.3f, 0.7f}) {
+      parse_yolov8_output(out.data(), num_features, num_boxes, model_type,
+                          num_keypoints, conf, 0.8f, 0.8f, 0, 64, 800, 600,
+                          &fresh);
+      assert(onnx_raw_cache_decode((const uint8_t *)entry.data(),
+                                   entry.size(), model_type, num_keypoints,
+                                   conf, &cached));
+      assert(cached.candidates.size() == fresh.candidates.size());
+      assert_same_detections(fresh.candidates.data(),
+                             cached.candidates.data(),
+                             fresh.candidates.size());
+
+      auto suppress = [&](DetectionScratch &scratch) {
+        return model_type == MODEL_TYPE_YOLO_OBB
+                   ? onnx_nms_rotated_inplace(scratch.candidates.data(),
+                                              scratch.candidates.size(), nms)
+                   : onnx_nms_inplace(scratch.candidates.data(),
+                                      scratch.candidates.size(), nms);
+      };
+      size_t kept_fresh = suppress(fresh);
+      size_t kept_cached = suppress(cached);
+      assert(kept_fresh == kept_cached);
+      assert_same_detections(fresh.candidates.data(),
+                             cached.candidates.data(), kept_fresh);
+    }
+  }
+}
+
+static void test_decode_rejects_mismatch() {
+  std::vector<float> out = make_random_output(2, 6, 50, 7);
+  DetectionScratch scratch;
+  parse_yolov8_output(out.data(), 4 + 2 + 6, 50, MODEL_TYPE_YOLO_POSE, 2,
+                      0.1f, 1.0f, 1.0f, 0, 0, 640, 640, &scratch);
+  assert(!scratch.candidates.empty());
+  std::string entry;
+  onnx_raw_cache_encode(scratch.candidates.data(), scratch.candidates.size(),
+                        MODEL_TYPE_YOLO_POSE, 2, 0.1f, &entry);
+  const uint8_t *data = (const uint8_t *)entry.data();
+
+  DetectionScratch decoded;
+  assert(onnx_raw_cache_decode(data, entry.size(), MODEL_TYPE_YOLO_POSE, 2,
+                               0.1f, &decoded));
+  assert(decoded.candidates.size() == scratch.candidates.size());
+  // 模型类型、关键点数不一致或阈值低于条目下限时未命中。
+  assert(!onnx_raw_cache_decode(data, entry.size(), MODEL_TYPE_YOLO, 2, 0.1f,
+                                &decoded));
+  assert(decoded.candidates.empty());
+  assert(!onnx_raw_cache_decode(data, entry.size(), MODEL_TYPE_YOLO_POSE, 17,
+                                0.1f, &decoded));
+  assert(!onnx_raw_cache_decode(data, entry.size(), MODEL_TYPE_YOLO_POSE, 2,
+                                0.05f, &decoded));
+  // 截断与损坏的条目不会越界读取。
+  for (size_t size = 0; size < entry.size(); size += 7) {
+    assert(!onnx_raw_cache_decode(data, size, MODEL_TYPE_YOLO_POSE, 2, 0.1f,
+                                  &decoded));
+  }
+  std::string corrupt = entry;
+  corrupt[0] ^= 0x5a;
+  assert(!onnx_raw_cache_decode((const uint8_t *)corrupt.data(),
+                                corrupt.size(), MODEL_TYPE_YOLO_POSE, 2, 0.1f,
+                                &decoded));
+  assert(!onnx_raw_cache_supports(MODEL_TYPE_YOLO_SEG));
+}
+
+static void test_store_and_load() {
+  fs::path dir = fs::temp_directory_path() / "onnx_raw_cache_test_store";
+  fs::remove_all(dir);
+  std::string path =
+      onnx_raw_cache_path(dir.string(), 0xabcULL, 640, 480, 0x1234ULL);
+  assert(fs::path(path).parent_path().filename() == "0000000000000abc_640x480");
+  assert(fs::path(path).filename() == "0000000000001234.raw");
+
+  float corners[8] = {0.1f, 0.1f, 0.3f, 0.1f, 0.3f, 0.2f, 0.1f, 0.2f};
+  Detection dets[2] = {};
+  dets[0].class_id = 1;
+  dets[0].confidence = 0.8f;
+  dets[0].x = 0.2f;
+  dets[0].angle = 0.5f;
+  dets[0].polygon = corners;
+  dets[0].num_polygon_points = 4;
+  dets[1].class_id = 0;
+  dets[1].confidence = 0.2f;
+  std::string entry;
+  onnx_raw_cache_encode(dets, 2, MODEL_TYPE_YOLO_OBB, 0, 0.05f, &entry);
+
+  DetectionScratch scratch;
+  assert(!onnx_raw_cache_load(path, MODEL_TYPE_YOLO_OBB, 0, 0.25f, &scratch));
+  assert(onnx_raw_cache_store(path, entry));
+  assert(onnx_raw_cache_load(path, MODEL_TYPE_YOLO_OBB, 0, 0.25f, &scratch));
+  assert(scratch.candidates.size() == 1);
+  assert_same_detections(dets, scratch.candidates.data(), 1);
+  assert(scratch.candidates[0].polygon != corners);
+
+  // 覆盖写入，且不留下临时文件。
+  onnx_raw_cache_encode(dets, 2, MODEL_TYPE_YOLO_OBB, 0, 0.5f, &entry);
+  assert(onnx_raw_cache_store(path, entry));
+  assert(!onnx_raw_cache_load(path, MODEL_TYPE_YOLO_OBB, 0, 0.25f, &scratch));
+  int files = 0;
+  for (const auto &item : fs::directory_iterator(fs::path(path).parent_path())) {
+    (void)item;
+    files++;
+  }
+  assert(files == 1);
+  fs::remove_all(dir);
+}
+
+static void test_filter_candidates_keeps_order() {
+  Detection dets[5] = {};
+  const float confs[5] = {0.3f, 0.1f, 0.6f, 0.25f, 0.2f};
+  for (int i = 0; i < 5; i++) {
+    dets[i].class_id = i;
+    dets[i].confidence = confs[i];
+  }
+  size_t kept = onnx_filter_candidates(dets, 5, 0.25f);
+  assert(kept == 3);
+  assert(dets[0].class_id == 0);
+  assert(dets[1].class_id == 2);
+  assert(dets[2].class_id == 3);
+}
+
+int main() {
+  test_hash_known_vectors();
+  test_hash_mapped_file();
+  test_rethreshold_matches_fresh_parse(MODEL_TYPE_YOLO_POSE, 4);
+  test_rethreshold_matches_fresh_parse(MODEL_TYPE_YOLO_OBB, 0);
+  test_decode_rejects_mismatch();
+  test_store_and_load();
+  test_filter_candidates_keeps_order();
+  std::cout << "onnx_raw_cache_test passed\n";
+  return 0;
+}
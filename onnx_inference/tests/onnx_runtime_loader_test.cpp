@@ -0,0 +1,119 @@
+/**
+ * ONNX Runtime 动态加载测试
+ */
+#include "onnx_runtime_loader.h"
+
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+
+static size_t index_of(const std::vector<std::string> &list,
+                       const std::string &value) {
+  return (size_t)(std::find(list.begin(), list.end(), value) - list.begin());
+}
+
+// 候选顺序：显式路径、环境变量、插件目录、构建目录，最后为裸库名。
+static void test_candidate_order() {
+  std::string sep(1, onnx_runtime_path_separator());
+  std::vector<std::string> candidates = onnx_runtime_candidates(
+      "/opt/gpu" + sep + sep + "/opt/cpu/", "/env", "/plugin", "/build");
+  std::string name = candidates.back();
+  assert(name.find_first_of("/\\") == std::string::npos);
+
+  size_t gpu = index_of(candidates, "/opt/gpu");
+  size_t cpu = index_of(candidates, "/opt/cpu/");
+  size_t env = index_of(candidates, "/env");
+  assert(gpu < cpu && cpu < env && env < candidates.size());
+  assert(index_of(candidates, "/opt/cpu/" + name) < cpu);
+  assert(index_of(candidates, "/plugin") == candidates.size());
+  assert(index_of(candidates, "/build") == candidates.size());
+  // 空项跳过，重复项只保留首次出现。
+  assert(index_of(candidates, "") == candidates.size());
+  std::vector<std::string> repeated =
+      onnx_runtime_candidates("/a" + sep + "/a", "", "/a", "");
+  for (const std::string &candidate : repeated) {
+    assert(std::count(repeated.begin(), repeated.end(), candidate) == 1);
+  }
+  // 未设置任何路径时只剩裸库名，交给系统加载器。
+  for (const std::string &candidate : onnx_runtime_candidates("", "", "", "")) {
+    assert(candidate.find_first_of("/\\") == std::string::npos);
+  }
+}
+
+// 全部候选不可用时返回失败并给出原因，输出保持不变。
+static void test_open_missing() {
+  OnnxRuntimeLibrary library;
+  std::string error;
+  std::vector<std::string> candidates = {"/nonexistent/libonnxruntime.so"};
+  assert(!onnx_runtime_open(candidates, "OrtGetApiBase", &library, &error));
+  assert(library.handle == nullptr && library.symbol == nullptr);
+  assert(error.find("/nonexistent") != std::string::npos);
+
+  error.clear();
+  assert(!onnx_runtime_open({}, "OrtGetApiBase", &library, &error));
+  assert(!error.empty());
+}
+
+#if defined(__linux__) && !defined(__ANDROID__)
+// 能打开但未导出入口的库被跳过，继续尝试下一个候选。
+static void test_open_requires_symbol() {
+  OnnxRuntimeLibrary library;
+  std::string error;
+  assert(!onnx_runtime_open({"libc.so.6"}, "OrtGetApiBase", &library, &error));
+  assert(error.find("OrtGetApiBase") != std::string::npos);
+
+  std::vector<std::string> candidates = {"/nonexistent/libc.so.6",
+                                         "libc.so.6"};
+  assert(onnx_runtime_open(candidates, "malloc", &library, &error));
+  assert(library.handle != nullptr && library.symbol != nullptr);
+  assert(library.path == "libc.so.6");
+}
+
+// 入口校验失败（如 API 版本不兼容）的库被关闭且不写入输出，
+// 继续尝试下一个候选；全部被拒绝时报告拒绝原因。
+static void test_open_rejects_incompatible() {
+  OnnxRuntimeLibrary library;
+  std::string error;
+  auto reject = [](void *, std::string *reason) {
+    *reason = "不支持 API 版本";
+    return false;
+  };
+  std::vector<std::string> candidates = {"libc.so.6",
+                                         "/nonexistent/libc.so.6"};
+  assert(!onnx_runtime_open(candidates, "malloc", &library, &error, reject));
+  assert(library.handle == nullptr && library.symbol == nullptr);
+  assert(library.path.empty());
+  assert(error.find("libc.so.6: 不支持 API 版本") != std::string::npos);
+
+  int calls = 0;
+  auto reject_first = [&calls](void *, std::string *reason) {
+    *reason = "不支持 API 版本";
+    return calls++ > 0;
+  };
+  candidates = {"libc.so.6", "libm.so.6"};
+  assert(onnx_runtime_open(candidates, "malloc", &library, &error,
+                           reject_first));
+  assert(calls == 2 && library.path == "libm.so.6");
+}
+#endif
+
+// 测试可执行文件自身所在目录可以取到。
+static void test_module_dir() {
+  std::string dir = onnx_runtime_module_dir();
+  assert(!dir.empty());
+  assert(dir.back() != '/' && dir.back() != '\\');
+}
+
+int main() {
+  test_candidate_order();
+  test_open_missing();
+#if defined(__linux__) && !defined(__ANDROID__)
+  test_open_requires_symbol();
+  test_open_rejects_incompatible();
+#endif
+  test_module_dir();
+  std::cout << "onnx_runtime_loader_test passed\n";
+  return 0;
+}
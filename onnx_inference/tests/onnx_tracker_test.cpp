@@ -0,0 +1,182 @@
+/**
+ * 多目标跟踪测试
+ */
+#include "onnx_tracker.h"
+
+#include <cassert>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+static OnnxTrackerOptions make_options(int keyframe_interval) {
+  OnnxTrackerOptions options;
+  options.keyframe_interval = keyframe_interval;
+  options.min_confidence = 0.5f;
+  options.match_iou = 0.3f;
+  options.max_lost = 2;
+  return options;
+}
+
+static Detection make_box(int class_id, float x, float y, float w, float h) {
+  Detection det{};
+  det.class_id = class_id;
+  det.confidence = 0.9f;
+  det.x = x;
+  det.y = y;
+  det.width = w;
+  det.height = h;
+  return det;
+}
+
+// 静止目标：新轨迹下一帧确认一次，之后只在关键帧运行检测器，外推帧输出
+// 原位置。
+static void test_stationary_keyframes() {
+  OnnxTracker tracker(make_options(5));
+  Detection box = make_box(0, 0.5f, 0.5f, 0.2f, 0.3f);
+  for (int frame = 0; frame < 20; frame++) {
+    bool need = tracker.advance();
+    assert(need == (frame <= 1 || frame % 5 == 0));
+    if (need) {
+      tracker.update(&box, 1);
+    }
+    const auto &out = tracker.current();
+    assert(out.size() == 1);
+    assert(std::fabs(out[0].x - 0.5f) < 1e-5f);
+    assert(std::fabs(out[0].height - 0.3f) < 1e-5f);
+    assert(out[0].confidence <= box.confidence);
+  }
+  OnnxTrackerStats stats = tracker.stats();
+  assert(stats.frames == 20);
+  assert(stats.detector_calls == 5);
+  assert(stats.forced_calls == 2);
+  assert(stats.tracks_created == 1);
+  assert(stats.active_tracks == 1);
+}
+
+// 匀速目标：学到速度后外推误差小于沿用上一关键帧的结果。
+static void test_constant_velocity_propagation() {
+  OnnxTracker tracker(make_options(4));
+  float held_error = 0, tracked_error = 0;
+  float last_x = 0;
+  for (int frame = 0; frame < 40; frame++) {
+    float x = 0.2f + 0.005f * frame;
+    Detection box = make_box(0, x, 0.5f, 0.2f, 0.2f);
+    if (tracker.advance()) {
+      tracker.update(&box, 1);
+      last_x = x;
+    }
+    const auto &out = tracker.current();
+    assert(out.size() == 1);
+    if (frame >= 12) {
+      held_error += std::fabs(last_x - x);
+      tracked_error += std::fabs(out[0].x - x);
+    }
+  }
+  assert(held_error > 0);
+  assert(tracked_error < held_error * 0.5f);
+  assert(tracker.stats().detector_calls <= 40 / 4 + 1);
+}
+
+// 快速运动：外推置信度下降时提前运行检测器。
+static void test_fast_motion_forces_detection() {
+  OnnxTracker tracker(make_options(10));
+  for (int frame = 0; frame < 30; frame++) {
+    Detection box = make_box(0, 0.1f + 0.02f * frame, 0.5f, 0.05f, 0.05f);
+    if (tracker.advance()) {
+      tracker.update(&box, 1);
+    }
+    const auto &out = tracker.current();
+    assert(out.size() == 1);
+    assert(std::fabs(out[0].x - box.x) < 0.01f);
+  }
+  OnnxTrackerStats stats = tracker.stats();
+  assert(stats.forced_calls > 0);
+  assert(stats.detector_calls > 30 / 10 + 1);
+  assert(stats.tracks_created == 1);
+}
+
+// 关联：同类别按 IoU 匹配，未匹配轨迹不输出，超过 max_lost 后删除。
+static void test_association_lifecycle() {
+  OnnxTracker tracker(make_options(1));
+  Detection a = make_box(0, 0.3f, 0.3f, 0.2f, 0.2f);
+  Detection b = make_box(1, 0.3f, 0.3f, 0.2f, 0.2f); // 与 a 重叠但类别不同
+  Detection c = make_box(0, 0.7f, 0.7f, 0.2f, 0.2f);
+
+  std::vector<Detection> frame = {a, b};
+  assert(tracker.advance());
+  tracker.update(frame.data(), (int)frame.size());
+  assert(tracker.stats().tracks_created == 2);
+
+  frame = {b, a, c};
+  assert(tracker.advance());
+  tracker.update(frame.data(), (int)frame.size());
+  assert(tracker.stats().tracks_created == 3);
+  assert(tracker.current().size() == 3);
+
+  // c 连续缺失：保留 max_lost 个关键帧但不输出，之后重新出现视为新轨迹。
+  frame = {a, b};
+  for (int i = 0; i < 3; i++) {
+    assert(tracker.advance());
+    tracker.update(frame.data(), (int)frame.size());
+    assert(tracker.current().size() == 2);
+    assert(tracker.stats().active_tracks == 2);
+  }
+  frame = {a, b, c};
+  assert(tracker.advance());
+  tracker.update(frame.data(), (int)frame.size());
+  assert(tracker.stats().tracks_created == 4);
+
+  // 缺失未超过 max_lost 时重新出现沿用原轨迹。
+  frame = {a, b};
+  assert(tracker.advance());
+  tracker.update(frame.data(), (int)frame.size());
+  frame = {a, b, c};
+  assert(tracker.advance());
+  tracker.update(frame.data(), (int)frame.size());
+  assert(tracker.stats().tracks_created == 4);
+  assert(tracker.stats().active_tracks == 3);
+}
+
+// 外推帧的关键点随框平移；reset 后必须重新检测。
+static void test_keypoints_follow_box_and_reset() {
+  OnnxTracker tracker(make_options(3));
+  float keypoints[6] = {0.45f, 0.5f, 0.9f, 0.55f, 0.5f, 0.1f};
+  for (int frame = 0; frame < 6; frame++) {
+    Detection box = make_box(0, 0.5f + 0.01f * frame, 0.5f, 0.2f, 0.2f);
+    for (int k = 0; k < 2; k++) {
+      keypoints[k * 3] = box.x + (k == 0 ? -0.05f : 0.05f);
+    }
+    box.keypoints = keypoints;
+    box.num_keypoints = 2;
+    if (tracker.advance()) {
+      tracker.update(&box, 1);
+    }
+    const auto &out = tracker.current();
+    assert(out.size() == 1);
+    assert(out[0].num_keypoints == 2);
+    assert(out[0].keypoints != keypoints);
+    assert(std::fabs(out[0].keypoints[0] - (out[0].x - 0.05f)) < 1e-4f);
+    assert(std::fabs(out[0].keypoints[3] - (out[0].x + 0.05f)) < 1e-4f);
+    assert(out[0].keypoints[5] == 0.1f);
+  }
+
+  int64_t calls = tracker.stats().detector_calls;
+  assert(calls < 6);
+  tracker.reset();
+  assert(tracker.current().empty());
+  assert(tracker.advance());
+  OnnxTrackerStats stats = tracker.stats();
+  assert(stats.frames == 7);
+  assert(stats.detector_calls == calls + 1);
+  assert(stats.active_tracks == 0);
+}
+
+int main() {
+  test_stationary_keyframes();
+  test_constant_velocity_propagation();
+  test_fast_motion_forces_detection();
+  test_association_lifecycle();
+  test_keypoints_follow_box_and_reset();
+  std::cout << "onnx_tracker_test passed\n";
+  return 0;
+}
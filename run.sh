@@ -22,6 +22,14 @@
 #     --int         仅集成测试
 #     --native      仅原生 C++ 测试
 #     --coverage    生成覆盖率报告
+#   bench         运行原生热点路径基准 (JSON 输出)
+#     --out FILE    写入 JSON 文件 (默认输出到终端)
+#     --filter X    仅运行名称包含 X 的用例
+#     --e2e ...     端到端吞吐基准 onnx_bench (其余参数透传)
+#
+# 无界面工具:
+#   label ...     批量自动标注 label_load_cli (参数透传，无需 Flutter)
+#   daemon ...    本地推理守护进程 label_load_daemon (参数透传)
 #
 # 代码质量:
 #   analyze       静态分析
@@ -131,6 +139,14 @@ show_help() {
     echo "    --int         仅集成测试"
     echo "    --native      仅原生 C++ 测试"
     echo "    --coverage    生成覆盖率报告"
+    echo "  bench         运行原生热点路径基准 (JSON 输出)"
+    echo "    --out FILE    写入 JSON 文件 (默认输出到终端)"
+    echo "    --filter X    仅运行名称包含 X 的用例"
+    echo "    --e2e ...     端到端吞吐基准 onnx_bench (其余参数透传)"
+    echo ""
+    echo -e "${YELLOW}无界面工具:${NC}"
+    echo "  label ...     批量自动标注 label_load_cli (参数透传，无需 Flutter)"
+    echo "  daemon ...    本地推理守护进程 label_load_daemon (参数透传)"
     echo ""
     echo -e "${YELLOW}代码质量:${NC}"
     echo "  analyze       静态分析"
@@ -325,7 +341,9 @@ do_test_native() {
     cmake -S "$SCRIPT_DIR/onnx_inference/src" -B "$build_dir" -DONNX_INFERENCE_BUILD_TESTS=ON
     
     log_step "编译测试"
-    cmake --build "$build_dir" --target onnx_inference_utils_test onnx_inference_stub_test
+    cmake --build "$build_dir" --target onnx_inference_utils_test onnx_raw_cache_test onnx_inference_stub_test \
+        onnx_inference_perf_test label_load_cli_utils_test onnx_daemon_test onnx_tracker_test \
+        onnx_runtime_loader_test
     
     log_step "运行测试"
     ctest --test-dir "$build_dir" --output-on-failure
@@ -333,6 +351,52 @@ do_test_native() {
     log_success "原生测试完成"
 }
 
+do_bench() {
+    log_info "运行原生基准测试..."
+
+    if ! command -v cmake &> /dev/null; then
+        log_error "未找到 cmake，无法运行基准测试"
+        echo "安装: sudo apt install cmake"
+        exit 1
+    fi
+
+    local build_dir="$SCRIPT_DIR/onnx_inference/build-bench"
+    local bench_target="onnx_inference_bench"
+    local bench_args=()
+
+    if [[ "${1:-}" == "--e2e" ]]; then
+        shift
+        bench_target="onnx_bench"
+        bench_args=("$@")
+        set --
+    fi
+
+    while [[ $# -gt 0 ]]; do
+        case "$1" in
+            --out|--filter|--min-time-ms)
+                bench_args+=("$1" "${2:-}")
+                shift
+                ;;
+            *)
+                log_warn "未知基准选项: $1"
+                ;;
+        esac
+        shift
+    done
+
+    log_step "配置 CMake (Release)"
+    cmake -S "$SCRIPT_DIR/onnx_inference/src" -B "$build_dir" \
+        -DCMAKE_BUILD_TYPE=Release -DONNX_INFERENCE_BUILD_BENCHMARKS=ON
+
+    log_step "编译基准"
+    cmake --build "$build_dir" --target "$bench_target"
+
+    log_step "运行基准"
+    "$build_dir/$bench_target" ${bench_args[@]+"${bench_args[@]}"}
+
+    log_success "基准测试完成"
+}
+
 do_test_coverage() {
     check_flutter
     log_info "运行测试并生成覆盖率报告..."
@@ -437,6 +501,40 @@ do_format() {
 # ==============================================================================
 # 主入口
 # ==============================================================================
+do_label() {
+    if ! command -v cmake &> /dev/null; then
+        log_error "未找到 cmake，无法构建 label_load_cli"
+        echo "安装: sudo apt install cmake"
+        exit 1
+    fi
+
+    local build_dir="$SCRIPT_DIR/onnx_inference/build-cli"
+
+    log_step "构建 label_load_cli (Release)"
+    cmake -S "$SCRIPT_DIR/onnx_inference/src" -B "$build_dir" \
+        -DCMAKE_BUILD_TYPE=Release -DONNX_INFERENCE_BUILD_CLI=ON > /dev/null
+    cmake --build "$build_dir" --target label_load_cli > /dev/null
+
+    "$build_dir/label_load_cli" "$@"
+}
+
+do_daemon() {
+    if ! command -v cmake &> /dev/null; then
+        log_error "未找到 cmake，无法构建 label_load_daemon"
+        echo "安装: sudo apt install cmake"
+        exit 1
+    fi
+
+    local build_dir="$SCRIPT_DIR/onnx_inference/build-cli"
+
+    log_step "构建 label_load_daemon (Release)"
+    cmake -S "$SCRIPT_DIR/onnx_inference/src" -B "$build_dir" \
+        -DCMAKE_BUILD_TYPE=Release -DONNX_INFERENCE_BUILD_DAEMON=ON > /dev/null
+    cmake --build "$build_dir" --target label_load_daemon > /dev/null
+
+    exec "$build_dir/label_load_daemon" "$@"
+}
+
 
 main() {
     local cmd="${1:-help}"
@@ -454,6 +552,11 @@ main() {
         
         # 测试命令
         test)     do_test "$@" ;;
+        bench)    do_bench "$@" ;;
+
+        # 无界面工具
+        label)    do_label "$@" ;;
+        daemon)   do_daemon "$@" ;;
         
         # 代码质量
         analyze)  do_analyze ;;
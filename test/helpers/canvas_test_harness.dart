@@ -21,6 +21,7 @@ import 'package:label_load/services/gpu/gpu_detector.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
 import 'package:label_load/services/image/image_repository.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/services/input/input_action_gate.dart';
 import 'package:label_load/services/input/keyboard_state_reader.dart';
 import 'package:label_load/services/input/keybindings_store.dart';
@@ -213,6 +214,10 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   bool loadModel(String path, {bool useGpu = false}) => true;
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async =>
+      loadModel(path, useGpu: useGpu);
+
   @override
   void unloadModel() {}
 
@@ -241,6 +246,41 @@ class FakeInferenceEngine implements InferenceEngine {
     return List.generate(rgbaBytesList.length, (_) => const []);
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) => null;
+
+  @override
+  bool setDedupDistance(int? maxDistance) => false;
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {}
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
   @override
   bool isGpuAvailable() => false;
 
@@ -259,6 +299,12 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => 'CPUExecutionProvider';
 
+  @override
+  InferenceStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
   @override
   String get lastError => '';
 
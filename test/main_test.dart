@@ -10,6 +10,7 @@ import 'package:label_load/services/app/app_services.dart';
 import 'package:label_load/services/gpu/gpu_detector.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/services/input/keybindings_store.dart';
 import 'package:label_load/services/input/keyboard_state_reader.dart';
 import 'package:label_load/services/projects/project_list_repository.dart';
@@ -33,6 +34,10 @@ class FakeInferenceEngine implements InferenceEngine {
     return true;
   }
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async =>
+      loadModel(path, useGpu: useGpu);
+
   @override
   void unloadModel() {
     _hasModel = false;
@@ -63,6 +68,41 @@ class FakeInferenceEngine implements InferenceEngine {
     return const [];
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) => null;
+
+  @override
+  bool setDedupDistance(int? maxDistance) => false;
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {}
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
   @override
   bool isGpuAvailable() => false;
 
@@ -79,6 +119,12 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => 'CPUExecutionProvider';
 
+  @override
+  InferenceStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
   @override
   String get lastError => '';
 
@@ -57,6 +57,7 @@ void main() {
           'numKeypoints': 17,
           'keypointConfThreshold': 0.6,
           'classIdOffset': 3,
+          'skipNearDuplicates': true,
         };
 
         final config = AiConfig.fromJson(json);
@@ -70,6 +71,7 @@ void main() {
         expect(config.numKeypoints, 17);
         expect(config.keypointConfThreshold, 0.6);
         expect(config.classIdOffset, 3);
+        expect(config.skipNearDuplicates, true);
       });
 
       test('缺少字段时应使用默认值', () {
@@ -86,6 +88,7 @@ void main() {
         expect(config.numKeypoints, 0);
         expect(config.keypointConfThreshold, 0.5);
         expect(config.classIdOffset, 0);
+        expect(config.skipNearDuplicates, false);
       });
 
       test('null字段应使用默认值', () {
@@ -161,6 +164,7 @@ void main() {
           numKeypoints: 21,
           keypointConfThreshold: 0.6,
           classIdOffset: 5,
+          skipNearDuplicates: true,
         );
 
         final json = original.toJson();
@@ -175,6 +179,7 @@ void main() {
         expect(restored.numKeypoints, original.numKeypoints);
         expect(restored.keypointConfThreshold, original.keypointConfThreshold);
         expect(restored.classIdOffset, original.classIdOffset);
+        expect(restored.skipNearDuplicates, original.skipNearDuplicates);
       });
     });
 
@@ -271,10 +276,12 @@ void main() {
     test('枚举值应正确定义', () {
       expect(ModelType.yolo.index, 0);
       expect(ModelType.yoloPose.index, 1);
+      expect(ModelType.yoloSeg.index, 2);
+      expect(ModelType.yoloObb.index, 3);
     });
 
-    test('枚举数量应为2', () {
-      expect(ModelType.values.length, 2);
+    test('枚举数量应为4', () {
+      expect(ModelType.values.length, 4);
     });
   });
 
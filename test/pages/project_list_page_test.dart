@@ -22,6 +22,7 @@ import 'package:label_load/services/app/app_services.dart';
 import 'package:label_load/services/projects/project_cover_finder.dart';
 import 'package:label_load/services/image/image_preview_provider.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/services/inference/batch_inference_service.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
 
@@ -123,6 +124,10 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   bool loadModel(String path, {bool useGpu = false}) => true;
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async =>
+      loadModel(path, useGpu: useGpu);
+
   @override
   void unloadModel() {}
 
@@ -143,6 +148,41 @@ class FakeInferenceEngine implements InferenceEngine {
           required int numKeypoints}) =>
       const [];
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) => null;
+
+  @override
+  bool setDedupDistance(int? maxDistance) => false;
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {}
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
   @override
   bool isGpuAvailable() => false;
 
@@ -159,6 +199,12 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => 'CPU';
 
+  @override
+  InferenceStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
   @override
   String get lastError => '';
 
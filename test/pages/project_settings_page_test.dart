@@ -21,6 +21,7 @@ import 'package:label_load/services/files/file_picker_service.dart';
 import 'package:label_load/services/gadgets/gadget_repository.dart';
 import 'package:label_load/services/gadgets/gadget_service.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/services/image/image_repository.dart';
 import 'package:label_load/services/labels/label_definition_io.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
@@ -37,6 +38,10 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   bool loadModel(String path, {bool useGpu = false}) => true;
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async =>
+      loadModel(path, useGpu: useGpu);
+
   @override
   void unloadModel() {}
 
@@ -65,6 +70,41 @@ class FakeInferenceEngine implements InferenceEngine {
     return List.generate(rgbaBytesList.length, (_) => const []);
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) => null;
+
+  @override
+  bool setDedupDistance(int? maxDistance) => false;
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {}
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
   @override
   bool isGpuAvailable() => false;
 
@@ -81,6 +121,12 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => 'CPU';
 
+  @override
+  InferenceStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
   @override
   String get lastError => '';
 
@@ -272,6 +318,7 @@ class FakeBatchInferenceService extends BatchInferenceService {
     void Function(List<LabelDefinition> updatedDefinitions)?
         onDefinitionsUpdated,
     void Function(String fileName)? onInferredImage,
+    bool incremental = true,
   }) async {
     runCalls += 1;
     if (throwOnRun) {
@@ -105,6 +105,27 @@ void main() {
       );
     });
 
+    test('fillMissingDefinitions infers polygon for contour points', () {
+      final labels = [
+        Label(
+          id: 2,
+          points: [
+            LabelPoint(x: 0.1, y: 0.1),
+            LabelPoint(x: 0.5, y: 0.1),
+            LabelPoint(x: 0.5, y: 0.3),
+          ],
+          pointsArePolygon: true,
+        ),
+      ];
+
+      processor.sanitizeLabels(labels, const []);
+      final updated = processor.fillMissingDefinitions(labels, const []);
+
+      expect(labels.single.points.length, 3);
+      expect(updated.single.classId, 2);
+      expect(updated.single.type, LabelType.polygon);
+    });
+
     test('fillMissingDefinitions returns same list when no missing ids', () {
       final labels = [Label(id: 0)];
       final definitions = [
@@ -10,10 +10,33 @@ import 'package:label_load/models/label_definition.dart';
 import 'package:label_load/services/inference/batch_inference_service.dart';
 import 'package:label_load/services/image/image_repository.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_label_mapper.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/services/inference/inference_service.dart';
 import 'package:label_load/services/labels/label_file_repository.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
 
+class _ContourPoint {
+  _ContourPoint(this.x, this.y);
+
+  final double x;
+  final double y;
+}
+
+/// 分割/旋转框检测结果：点来自 polygon 字段。
+class _ContourDetection {
+  _ContourDetection(this.classId, this.polygon);
+
+  final int classId;
+  final double x = 0.5;
+  final double y = 0.5;
+  final double width = 0.9;
+  final double height = 0.9;
+  final List<_ContourPoint> polygon;
+
+  List<_ContourPoint>? get keypoints => null;
+}
+
 class FakeBatchRunner implements BatchInferenceRunner {
   FakeBatchRunner({
     required this.responses,
@@ -127,6 +150,10 @@ class _StubEngine implements InferenceEngine {
   @override
   bool loadModel(String path, {bool useGpu = false}) => true;
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async =>
+      loadModel(path, useGpu: useGpu);
+
   @override
   void unloadModel() {}
 
@@ -153,6 +180,41 @@ class _StubEngine implements InferenceEngine {
   }) =>
       const [];
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) => null;
+
+  @override
+  bool setDedupDistance(int? maxDistance) => false;
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {}
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
   @override
   bool isGpuAvailable() => false;
 
@@ -169,6 +231,12 @@ class _StubEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => '';
 
+  @override
+  InferenceStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
   @override
   String get lastError => '';
 
@@ -338,6 +406,96 @@ void main() {
       expect(parts.length, 5);
     });
 
+    test('writes seg masks of new classes as polygon lines', () async {
+      final rootDir = await Directory.systemTemp.createTemp('batch_infer_');
+      addTearDown(() => rootDir.delete(recursive: true));
+
+      final imageDir = Directory(path.join(rootDir.path, 'images'));
+      final labelDir = Directory(path.join(rootDir.path, 'labels'));
+      await imageDir.create();
+      await labelDir.create();
+
+      final imagePath = path.join(imageDir.path, 'seg.jpg');
+      await File(imagePath).writeAsString('x');
+
+      final mask = _ContourDetection(4, [
+        _ContourPoint(0.1, 0.1),
+        _ContourPoint(0.5, 0.1),
+        _ContourPoint(0.5, 0.3),
+      ]);
+      final runner = FakeBatchRunner(
+        responses: {
+          imagePath: InferenceLabelMapper.fromDetections([mask], const []),
+        },
+      );
+
+      final service = BatchInferenceService(runner: runner);
+      final summary = await service.run(
+        imageDir: imageDir.path,
+        labelDir: labelDir.path,
+        config: AiConfig(
+          modelPath: 'model.onnx',
+          labelSaveMode: LabelSaveMode.overwrite,
+        ),
+        definitions: const [],
+        useGpu: false,
+      );
+
+      final content =
+          await File(path.join(labelDir.path, 'seg.txt')).readAsString();
+
+      // 新项目中没有类别定义：按 YOLO-seg 多边形行写出，而不是关键点。
+      expect(summary.definitions.single.type, LabelType.polygon);
+      expect(content.trim(),
+          '4 0.100000 0.100000 0.500000 0.100000 0.500000 0.300000');
+    });
+
+    test('writes rotated boxes of new classes as corner polygons', () async {
+      final rootDir = await Directory.systemTemp.createTemp('batch_infer_');
+      addTearDown(() => rootDir.delete(recursive: true));
+
+      final imageDir = Directory(path.join(rootDir.path, 'images'));
+      final labelDir = Directory(path.join(rootDir.path, 'labels'));
+      await imageDir.create();
+      await labelDir.create();
+
+      final imagePath = path.join(imageDir.path, 'obb.jpg');
+      await File(imagePath).writeAsString('x');
+
+      final rotated = _ContourDetection(1, [
+        _ContourPoint(0.5, 0.35),
+        _ContourPoint(0.65, 0.5),
+        _ContourPoint(0.5, 0.65),
+        _ContourPoint(0.35, 0.5),
+      ]);
+      final runner = FakeBatchRunner(
+        responses: {
+          imagePath: InferenceLabelMapper.fromDetections([rotated], const []),
+        },
+      );
+
+      final service = BatchInferenceService(runner: runner);
+      final summary = await service.run(
+        imageDir: imageDir.path,
+        labelDir: labelDir.path,
+        config: AiConfig(
+          modelPath: 'model.onnx',
+          labelSaveMode: LabelSaveMode.overwrite,
+        ),
+        definitions: const [],
+        useGpu: false,
+      );
+
+      final content =
+          await File(path.join(labelDir.path, 'obb.txt')).readAsString();
+
+      expect(summary.definitions.single.type, LabelType.polygon);
+      expect(
+          content.trim(),
+          '1 0.500000 0.350000 0.650000 0.500000 '
+          '0.500000 0.650000 0.350000 0.500000');
+    });
+
     test('returns early when no images', () async {
       final runner = FakeBatchRunner(responses: {});
       final service = BatchInferenceService(
@@ -513,5 +671,71 @@ void main() {
       expect(progress.any((p) => p.$1 == 1 && p.$2 == 2), isTrue);
       expect(progress.last, (2, 2));
     });
+
+    test('skips unchanged images and resumes interrupted runs', () async {
+      final rootDir = await Directory.systemTemp.createTemp('batch_infer_');
+      addTearDown(() => rootDir.delete(recursive: true));
+      final imageDir = Directory(path.join(rootDir.path, 'images'));
+      final labelDir = path.join(rootDir.path, 'labels');
+      await imageDir.create();
+      final images = [
+        for (var i = 0; i < 6; i++) path.join(imageDir.path, 'img$i.jpg'),
+      ];
+      for (final image in images) {
+        await File(image).writeAsString('pixels of $image');
+      }
+
+      final runner = FakeBatchRunner(responses: {});
+      final service = BatchInferenceService(
+        runner: runner,
+        fileHasher: (paths) => [
+          for (final p in paths) File(p).readAsStringSync().hashCode,
+        ],
+      );
+      final config = AiConfig(modelPath: 'model.onnx');
+      Future<BatchInferenceSummary> run({bool Function()? shouldContinue}) {
+        return service.run(
+          imageDir: imageDir.path,
+          labelDir: labelDir,
+          config: config,
+          definitions: const [],
+          useGpu: false,
+          shouldContinue: shouldContinue,
+        );
+      }
+
+      // 第一批（4 张）完成后中断，重新运行只处理剩余图片。
+      var batches = 0;
+      var summary = await run(shouldContinue: () => batches++ < 1);
+      expect(summary.processedImages, 4);
+      summary = await run();
+      expect(summary.processedImages, 2);
+      expect(summary.skippedImages, 4);
+      expect(summary.inferredImages.length, 6);
+
+      // 全部未变化：不加载模型。
+      runner.initialized = false;
+      summary = await run();
+      expect(summary.processedImages, 0);
+      expect(summary.skippedImages, 6);
+      expect(runner.initialized, isFalse);
+
+      // 内容变化、仅修改时间变化、标签文件被删除。
+      await File(images[1]).writeAsString('edited');
+      await File(images[2])
+          .setLastModified(DateTime.now().add(const Duration(hours: 1)));
+      await File(path.join(labelDir, 'img3.txt')).delete();
+      final callsBefore = runner.batchCalls;
+      summary = await run();
+      expect(summary.processedImages, 2);
+      expect(summary.skippedImages, 4);
+      expect(runner.batchCalls, callsBefore + 1);
+
+      // 配置变化后全部重新推理。
+      config.confidenceThreshold = 0.5;
+      summary = await run();
+      expect(summary.processedImages, 6);
+    });
   });
 }
+
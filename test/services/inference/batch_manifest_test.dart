@@ -0,0 +1,109 @@
+import 'dart:io';
+
+import 'package:flutter_test/flutter_test.dart';
+import 'package:label_load/models/ai_config.dart';
+import 'package:label_load/services/inference/batch_manifest.dart';
+import 'package:label_load/services/inference/batch_manifest_store.dart';
+import 'package:path/path.dart' as path;
+
+void main() {
+  test('BatchManifest ignores corrupt lines and compacts stale entries',
+      () async {
+    final dir = await Directory.systemTemp.createTemp('batch_manifest_');
+    addTearDown(() => dir.delete(recursive: true));
+    final image = path.join(dir.path, 'a.jpg');
+    await File(image).writeAsString('abc');
+    await File(path.join(dir.path, 'a.txt')).writeAsString('');
+
+    final hashed = <String>[];
+    List<int?> hasher(List<String> paths) {
+      hashed.addAll(paths);
+      return [for (final _ in paths) 7];
+    }
+
+    final manifest = await BatchManifest.open(dir.path, hasher: hasher);
+    expect(manifest.length, 0);
+    expect(await manifest.pending([image], 1), [image]);
+    await manifest.record([image], 1);
+    await manifest.record([image], 1);
+    expect(hashed, [image, image]);
+
+    // 损坏的行被跳过，后出现的条目覆盖先前的。
+    final file = File(manifest.filePath);
+    await file.writeAsString('garbage\nb.jpg\tx\t1\t2\t3\n',
+        mode: FileMode.append);
+    final reopened = await BatchManifest.open(dir.path, hasher: hasher);
+    expect(reopened.length, 1);
+    expect(await reopened.pending([image], 1), isEmpty);
+    expect(await reopened.pending([image], 2), [image]);
+
+    await reopened.compact();
+    final lines = (await file.readAsLines())
+        .where((line) => !line.startsWith('#'))
+        .toList();
+    expect(lines.length, 1);
+    expect(lines.single.split('\t').first, 'a.jpg');
+  });
+
+  test('BatchManifest goes through the injected store', () async {
+    final store = _MemoryStore();
+    store.stamps['/images/a.jpg'] = const FileStamp(size: 3, modifiedMs: 10);
+    store.stamps['/model.onnx'] = const FileStamp(size: 100, modifiedMs: 1);
+    store.names['/labels'] = {'a.txt'};
+    List<int?> hasher(List<String> paths) => [for (final _ in paths) 7];
+
+    final config = AiConfig(modelPath: '/model.onnx');
+    final fingerprint =
+        await BatchManifest.fingerprintOf(config, store: store);
+    final manifest =
+        await BatchManifest.open('/labels', hasher: hasher, store: store);
+    expect(await manifest.pending(['/images/a.jpg'], fingerprint),
+        ['/images/a.jpg']);
+    await manifest.record(['/images/a.jpg'], fingerprint);
+    expect(store.files[manifest.filePath],
+        contains('a.jpg\t3\t10\t7\t$fingerprint'));
+
+    final reopened =
+        await BatchManifest.open('/labels', hasher: hasher, store: store);
+    expect(await reopened.pending(['/images/a.jpg'], fingerprint), isEmpty);
+
+    // 模型文件变化使指纹失效。
+    store.stamps['/model.onnx'] = const FileStamp(size: 100, modifiedMs: 2);
+    expect(await BatchManifest.fingerprintOf(config, store: store),
+        isNot(fingerprint));
+  });
+}
+
+class _MemoryStore implements BatchManifestStore {
+  final stamps = <String, FileStamp>{};
+  final names = <String, Set<String>>{};
+  final files = <String, String>{};
+
+  @override
+  Future<FileStamp?> stat(String filePath) async {
+    final content = files[filePath];
+    if (content != null) {
+      return FileStamp(size: content.length, modifiedMs: 0);
+    }
+    return stamps[filePath];
+  }
+
+  @override
+  Future<Set<String>> listFileNames(String directoryPath) async =>
+      names[directoryPath] ?? {};
+
+  @override
+  Future<String?> readString(String filePath) async => files[filePath];
+
+  @override
+  Future<bool> appendString(String filePath, String content) async {
+    files[filePath] = (files[filePath] ?? '') + content;
+    return true;
+  }
+
+  @override
+  Future<bool> replaceString(String filePath, String content) async {
+    files[filePath] = content;
+    return true;
+  }
+}
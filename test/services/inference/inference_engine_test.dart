@@ -4,6 +4,7 @@ import 'package:flutter_test/flutter_test.dart';
 import 'package:label_load/models/ai_config.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:onnx_inference/onnx_inference.dart' as onnx;
 
 class FakeOnnxBackend implements OnnxBackend {
@@ -14,6 +15,8 @@ class FakeOnnxBackend implements OnnxBackend {
   String providers = 'CPU';
   String error = '';
   int errorCode = 0;
+  onnx.OnnxStats? stats;
+  int resetStatsCalls = 0;
   onnx.GpuInfo gpuInfo = onnx.GpuInfo(
     cudaAvailable: false,
     tensorrtAvailable: false,
@@ -25,6 +28,7 @@ class FakeOnnxBackend implements OnnxBackend {
 
   String? lastLoadPath;
   bool? lastLoadUseGpu;
+  int asyncLoadCalls = 0;
   onnx.ModelType? lastModelType;
   onnx.ModelType? lastBatchModelType;
   int unloadCalls = 0;
@@ -32,6 +36,14 @@ class FakeOnnxBackend implements OnnxBackend {
 
   Iterable<dynamic> detectResult = const [];
   List<List<dynamic>> detectBatchResult = const [];
+  bool rawCacheEnabled = false;
+  String? rawCacheDirectory;
+  bool dedupEnabled = false;
+  final List<int?> dedupDistances = [];
+  onnx.ModelType? lastCachedModelType;
+  List<int>? lastImageKeys;
+  List<List<dynamic>>? sweepResult;
+  onnx.ModelType? lastSweepModelType;
 
   @override
   bool get hasModel => hasModelValue;
@@ -46,6 +58,12 @@ class FakeOnnxBackend implements OnnxBackend {
     return loadModelValue;
   }
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async {
+    asyncLoadCalls++;
+    return loadModel(path, useGpu: useGpu);
+  }
+
   @override
   void unloadModel() => unloadCalls++;
 
@@ -76,6 +94,78 @@ class FakeOnnxBackend implements OnnxBackend {
     return detectBatchResult;
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return null;
+  }
+
+  @override
+  bool enableRawCache(String? directory) {
+    rawCacheDirectory = directory;
+    return rawCacheEnabled;
+  }
+
+  @override
+  bool setDedupDistance(int? maxDistance) {
+    dedupDistances.add(maxDistance);
+    return dedupEnabled;
+  }
+
+  @override
+  Uint8List? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) {}
+
+  @override
+  int? hashBytes(Uint8List data) => data.length;
+
+  @override
+  Iterable<dynamic>? detectCached(
+    int imageKey, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    lastCachedModelType = modelType;
+    return imageKey == 0 ? null : detectResult;
+  }
+
+  @override
+  List<List<dynamic>> detectBatchKeyed(
+    List<int> imageKeys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    lastImageKeys = imageKeys;
+    lastBatchModelType = modelType;
+    return detectBatchResult;
+  }
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required onnx.ModelType modelType,
+    required int numKeypoints,
+  }) {
+    lastSweepModelType = modelType;
+    return sweepResult;
+  }
+
   @override
   bool isGpuAvailable() => gpuAvailable;
 
@@ -85,6 +175,12 @@ class FakeOnnxBackend implements OnnxBackend {
   @override
   String getAvailableProviders() => providers;
 
+  @override
+  onnx.OnnxStats? getStats() => stats;
+
+  @override
+  void resetStats() => resetStatsCalls++;
+
   @override
   String get lastError => error;
 
@@ -115,25 +211,56 @@ class FakeOnnxInference implements onnx.OnnxInference {
 
   int unloadCalls = 0;
   int disposeCalls = 0;
+  int asyncLoadCalls = 0;
+  List<onnx.OnnxInitOptions?> initOptions = [];
   String? lastPath;
   bool? lastUseGpu;
 
   List<onnx.Detection> detectResult = const [];
   List<List<onnx.Detection>> detectBatchResult = const [];
+  bool sweepSupported = false;
+  List<double>? lastSweepConf;
+
+  @override
+  bool initialize({onnx.OnnxInitOptions? options}) {
+    initOptions.add(options);
+    return initialized;
+  }
+
+  @override
+  bool setRuntimeSearchPaths(List<String> paths) => false;
 
   @override
-  bool initialize() => initialized;
+  String? get runtimePath => null;
 
   @override
   void dispose() => disposeCalls++;
 
   @override
-  bool loadModel(String modelPath, {bool useGpu = false}) {
+  bool loadModel(
+    String modelPath, {
+    bool useGpu = false,
+    onnx.OnnxLoadOptions? options,
+  }) {
     lastPath = modelPath;
     lastUseGpu = useGpu;
     return loadResult;
   }
 
+  @override
+  bool get isLoadingAsync => false;
+
+  @override
+  Future<bool> loadModelAsync(
+    String modelPath, {
+    bool useGpu = false,
+    onnx.OnnxLoadOptions options = const onnx.OnnxLoadOptions(),
+    Duration pollInterval = const Duration(milliseconds: 10),
+  }) async {
+    asyncLoadCalls++;
+    return loadModel(modelPath, useGpu: useGpu, options: options);
+  }
+
   @override
   void unloadModel() => unloadCalls++;
 
@@ -180,6 +307,17 @@ class FakeOnnxInference implements onnx.OnnxInference {
   @override
   bool get isInitialized => initialized;
 
+  @override
+  onnx.OnnxBatchStream? openBatchStream({
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+    int memoryBudgetBytes = 0,
+  }) {
+    return null;
+  }
+
   @override
   bool isGpuAvailable() => gpuAvailable;
 
@@ -188,6 +326,180 @@ class FakeOnnxInference implements onnx.OnnxInference {
 
   @override
   String getAvailableProviders() => providers;
+
+  @override
+  onnx.OnnxImageBuffer? acquireImageBuffer(int size) => null;
+
+  @override
+  void releaseImageBuffer(onnx.OnnxImageBuffer buffer) {}
+
+  @override
+  int trimImageBuffers() => 0;
+
+  @override
+  onnx.OnnxStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
+  @override
+  bool startProfiling(String tracePath) => false;
+
+  @override
+  bool stopProfiling() => false;
+
+  @override
+  onnx.OnnxMemoryUsage? getMemoryUsage() => null;
+
+  @override
+  bool trimMemory() => false;
+
+  @override
+  bool get supportsRawCache => false;
+
+  @override
+  int? hashBytes(Uint8List data) => null;
+
+  @override
+  List<int?>? hashFiles(List<String> paths) => null;
+
+  @override
+  bool enableRawCache(String? directory) => false;
+
+  @override
+  bool setDedupDistance(int? maxDistance) => false;
+
+  @override
+  bool get supportsCascade => false;
+
+  @override
+  bool loadCascadeModel(String modelPath, {bool useGpu = false}) => false;
+
+  @override
+  void unloadCascadeModel() {}
+
+  @override
+  List<List<onnx.Detection>> detectBatchCascade(
+    List<Uint8List> imageList,
+    List<(int, int)> sizes, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+    onnx.OnnxCascadeOptions options = const onnx.OnnxCascadeOptions(),
+  }) {
+    return detectBatchResult;
+  }
+
+  @override
+  List<onnx.Detection>? detectCached(
+    int imageKey, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    return null;
+  }
+
+  @override
+  List<List<onnx.Detection>> detectBatchKeyed(
+    List<int> imageKeys,
+    List<Uint8List> imageList,
+    List<(int, int)> sizes, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    return detectBatchResult;
+  }
+
+  @override
+  bool get supportsSweep => sweepSupported;
+
+  @override
+  onnx.OnnxSweepResult? detectSweep(
+    Uint8List imageData,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    lastSweepConf = confThresholds;
+    return onnx.OnnxSweepResult(
+      confThresholds: confThresholds,
+      nmsThresholds: nmsThresholds,
+      results: [
+        for (var i = 0; i < confThresholds.length * nmsThresholds.length; i++)
+          detectResult,
+      ],
+    );
+  }
+}
+
+class FakeDaemonClient implements onnx.OnnxDaemonClient {
+  bool connected = true;
+  bool hasModelValue = false;
+  bool loadResult = true;
+  int errorCode = 0;
+  String? lastPath;
+  int detectBatchCalls = 0;
+  int closeCalls = 0;
+  List<List<onnx.Detection>> detectBatchResult = const [];
+
+  @override
+  bool get isConnected => connected;
+
+  @override
+  bool get hasModel => hasModelValue;
+
+  @override
+  bool loadModel(String modelPath, {bool useGpu = false}) {
+    lastPath = modelPath;
+    hasModelValue = loadResult;
+    return loadResult;
+  }
+
+  @override
+  List<List<onnx.Detection>> detectBatch(
+    List<Uint8List> imageList,
+    List<(int, int)> sizes, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    detectBatchCalls++;
+    return detectBatchResult;
+  }
+
+  @override
+  List<onnx.Detection> detect(
+    Uint8List imageData,
+    int width,
+    int height, {
+    double confThreshold = 0.25,
+    double nmsThreshold = 0.45,
+    onnx.ModelType modelType = onnx.ModelType.yolo,
+    int numKeypoints = 17,
+  }) {
+    return detectBatch([imageData], [(width, height)]).first;
+  }
+
+  @override
+  String get lastError => errorCode == 0 ? '' : 'daemon error';
+
+  @override
+  int get lastErrorCode => errorCode;
+
+  @override
+  void close() {
+    closeCalls++;
+    connected = false;
+  }
 }
 
 void main() {
@@ -230,6 +542,7 @@ void main() {
     backend.unloadModel();
     backend.dispose();
 
+    expect(engine.initOptions.single!.useGlobalThreadPools, isTrue);
     expect(engine.lastPath, '/model.onnx');
     expect(engine.lastUseGpu, isTrue);
     expect(engine.unloadCalls, 1);
@@ -242,6 +555,51 @@ void main() {
     expect(backend.lastErrorCode, 5);
   });
 
+  test('loadModelAsync forwards through the engine and backends', () async {
+    final engine = FakeOnnxInference();
+    final local = OnnxInferenceBackend(engine);
+    expect(await local.loadModelAsync('/model.onnx', useGpu: true), isTrue);
+    expect(engine.asyncLoadCalls, 1);
+    expect(engine.lastPath, '/model.onnx');
+    expect(engine.lastUseGpu, isTrue);
+
+    final backend = FakeOnnxBackend()..loadModelValue = false;
+    final wrapper = OnnxInferenceEngine(backend: backend);
+    expect(await wrapper.loadModelAsync('/other.onnx'), isFalse);
+    expect(backend.asyncLoadCalls, 1);
+    expect(backend.lastLoadPath, '/other.onnx');
+
+    // 守护进程在自身进程内加载；不可用时由本地后端后台加载。
+    final client = FakeDaemonClient();
+    final fallback = FakeOnnxBackend();
+    final daemon = OnnxDaemonBackend(
+      connect: () => client,
+      fallback: fallback,
+    );
+    expect(await daemon.loadModelAsync('/daemon.onnx'), isTrue);
+    expect(client.lastPath, '/daemon.onnx');
+    expect(fallback.asyncLoadCalls, 0);
+
+    final offline = OnnxDaemonBackend(
+      connect: () => null,
+      fallback: fallback,
+    );
+    expect(await offline.loadModelAsync('/local.onnx', useGpu: true), isTrue);
+    expect(fallback.asyncLoadCalls, 1);
+    expect(fallback.lastLoadPath, '/local.onnx');
+    expect(fallback.lastLoadUseGpu, isTrue);
+  });
+
+  test('OnnxInferenceBackend retries default init when shared pools fail', () {
+    final engine = FakeOnnxInference()..initialized = false;
+    final backend = OnnxInferenceBackend(engine);
+
+    expect(backend.initialize(), isFalse);
+    expect(engine.initOptions.length, 2);
+    expect(engine.initOptions.first!.useGlobalThreadPools, isTrue);
+    expect(engine.initOptions.last, isNull);
+  });
+
   test('OnnxInferenceEngine supports engine injection', () {
     final fake = FakeOnnxInference()..gpuAvailable = true;
     final engine = OnnxInferenceEngine(engine: fake);
@@ -284,6 +642,92 @@ void main() {
     expect(backend.disposeCalls, 1);
   });
 
+  test('OnnxInferenceEngine opens raw cache through the backend', () {
+    final backend = FakeOnnxBackend()..detectResult = const ['hit'];
+    final engine = OnnxInferenceEngine(backend: backend);
+
+    expect(engine.openRawCache('/cache'), isNull);
+    expect(backend.rawCacheDirectory, '/cache');
+
+    backend.rawCacheEnabled = true;
+    final cache = engine.openRawCache('/cache')!;
+    expect(cache.keyOf(Uint8List(3)), 3);
+    expect(
+      cache.lookup(
+        3,
+        confThreshold: 0.5,
+        nmsThreshold: 0.45,
+        modelType: ModelType.yoloObb,
+        numKeypoints: 0,
+      ),
+      ['hit'],
+    );
+    expect(backend.lastCachedModelType, onnx.ModelType.yoloObb);
+    expect(
+      cache.lookup(
+        0,
+        confThreshold: 0.5,
+        nmsThreshold: 0.45,
+        modelType: ModelType.yolo,
+        numKeypoints: 0,
+      ),
+      isNull,
+    );
+
+    cache.detectBatch(
+      [7, 9],
+      [Uint8List(4), Uint8List(4)],
+      [(1, 1), (1, 1)],
+      confThreshold: 0.25,
+      nmsThreshold: 0.45,
+      modelType: ModelType.yoloPose,
+      numKeypoints: 17,
+    );
+    expect(backend.lastImageKeys, [7, 9]);
+    expect(backend.lastBatchModelType, onnx.ModelType.yoloPose);
+  });
+
+  test('detectSweep forwards threshold grids when supported', () {
+    final fake = FakeOnnxInference();
+    final backend = OnnxInferenceBackend(fake);
+    List<List<dynamic>>? sweep() => backend.detectSweep(
+          Uint8List(4),
+          1,
+          1,
+          confThresholds: const [0.25, 0.5],
+          nmsThresholds: const [0.45],
+          modelType: onnx.ModelType.yolo,
+          numKeypoints: 0,
+        );
+
+    expect(sweep(), isNull);
+    expect(fake.lastSweepConf, isNull);
+    fake.sweepSupported = true;
+    expect(sweep()!.length, 2);
+    expect(fake.lastSweepConf, [0.25, 0.5]);
+
+    final fakeBackend = FakeOnnxBackend()
+      ..sweepResult = [
+        ['a'],
+        ['b'],
+      ];
+    final engine = OnnxInferenceEngine(backend: fakeBackend);
+    final results = engine.detectSweep(
+      Uint8List(4),
+      1,
+      1,
+      confThresholds: const [0.25],
+      nmsThresholds: const [0.3, 0.6],
+      modelType: ModelType.yoloSeg,
+      numKeypoints: 0,
+    );
+    expect(results, [
+      ['a'],
+      ['b'],
+    ]);
+    expect(fakeBackend.lastSweepModelType, onnx.ModelType.yoloSeg);
+  });
+
   test('OnnxInferenceEngine exposes error and provider info', () {
     final backend = FakeOnnxBackend()
       ..error = 'boom'
@@ -316,4 +760,198 @@ void main() {
     expect(info.deviceName, 'GPU');
     expect(info.cudaDeviceCount, 2);
   });
+
+  test('OnnxInferenceEngine converts native stats', () {
+    final backend = FakeOnnxBackend();
+    final engine = OnnxInferenceEngine(backend: backend);
+    expect(engine.getStats(), isNull);
+
+    backend.stats = const onnx.OnnxStats(
+      stages: {
+        onnx.OnnxStage.run: onnx.OnnxStageTiming(
+          lastMs: 4,
+          p50Ms: 5,
+          p95Ms: 8,
+          p99Ms: 9,
+        ),
+      },
+      calls: 2,
+      images: 3,
+      candidates: 40,
+      detections: 6,
+      bytesAllocated: 1024,
+      dedupSkipped: 7,
+    );
+
+    final stats = engine.getStats()!;
+    expect(stats.stages[InferenceStage.run]!.p95Ms, 8);
+    expect(stats.stages.containsKey(InferenceStage.parse), isFalse);
+    expect(stats.calls, 2);
+    expect(stats.images, 3);
+    expect(stats.candidates, 40);
+    expect(stats.detections, 6);
+    expect(stats.bytesAllocated, 1024);
+    expect(stats.dedupSkipped, 7);
+
+    // 近重复跳过直接转发给后端。
+    expect(engine.setDedupDistance(4), isFalse);
+    backend.dedupEnabled = true;
+    expect(engine.setDedupDistance(null), isTrue);
+    expect(backend.dedupDistances, [4, null]);
+
+    engine.resetStats();
+    expect(backend.resetStatsCalls, 1);
+  });
+
+  test('OnnxDaemonBackend routes inference through the daemon', () {
+    final client = FakeDaemonClient()
+      ..detectBatchResult = [
+        [
+          onnx.Detection(
+            classId: 3,
+            confidence: 0.9,
+            x: 0.5,
+            y: 0.5,
+            width: 0.1,
+            height: 0.1,
+          ),
+        ],
+      ];
+    final fallback = FakeOnnxBackend()..gpuAvailable = true;
+    var connects = 0;
+    final backend = OnnxDaemonBackend(
+      connect: () {
+        connects++;
+        return client;
+      },
+      fallback: fallback,
+    );
+
+    expect(backend.initialize(), isTrue);
+    expect(backend.loadModel('/model.onnx'), isTrue);
+    expect(backend.hasModel, isTrue);
+    expect(backend.usesDaemon, isTrue);
+    expect(client.lastPath, '/model.onnx');
+    expect(fallback.lastLoadPath, isNull);
+
+    final result = backend.detect(
+      Uint8List(4),
+      1,
+      1,
+      confThreshold: 0.25,
+      nmsThreshold: 0.45,
+      modelType: onnx.ModelType.yolo,
+      numKeypoints: 0,
+    );
+    expect((result.single as onnx.Detection).classId, 3);
+    expect(client.detectBatchCalls, 1);
+    expect(fallback.lastBatchModelType, isNull);
+
+    // 守护进程自行合批，不提供流式会话与本地统计；GPU 查询走本地。
+    expect(
+      backend.openBatchStream(
+        confThreshold: 0.25,
+        nmsThreshold: 0.45,
+        modelType: onnx.ModelType.yolo,
+        numKeypoints: 0,
+      ),
+      isNull,
+    );
+    expect(backend.getStats(), isNull);
+    expect(backend.isGpuAvailable(), isTrue);
+    // 原始输出缓存仅用于本地推理。
+    fallback.rawCacheEnabled = true;
+    expect(backend.enableRawCache('/cache'), isFalse);
+    expect(fallback.rawCacheDirectory, isNull);
+    fallback.dedupEnabled = true;
+    expect(backend.setDedupDistance(4), isFalse);
+    expect(fallback.dedupDistances, isEmpty);
+    // 协议只支持单组阈值，扫描交由调用方逐组推理。
+    fallback.sweepResult = const [];
+    expect(
+      backend.detectSweep(
+        Uint8List(4),
+        1,
+        1,
+        confThresholds: const [0.25],
+        nmsThresholds: const [0.45],
+        modelType: onnx.ModelType.yolo,
+        numKeypoints: 0,
+      ),
+      isNull,
+    );
+    expect(fallback.lastSweepModelType, isNull);
+
+    backend.dispose();
+    expect(client.closeCalls, 1);
+    expect(fallback.disposeCalls, 1);
+    expect(connects, 1);
+  });
+
+  test('OnnxDaemonBackend falls back to local inference', () {
+    // 守护进程未运行：全部请求转交本地后端，且不再重连。
+    final fallback = FakeOnnxBackend()..hasModelValue = true;
+    var connects = 0;
+    final offline = OnnxDaemonBackend(
+      connect: () {
+        connects++;
+        return null;
+      },
+      fallback: fallback,
+    );
+    expect(offline.initialize(), isTrue);
+    expect(offline.loadModel('/local.onnx', useGpu: true), isTrue);
+    expect(fallback.lastLoadPath, '/local.onnx');
+    expect(fallback.lastLoadUseGpu, isTrue);
+    expect(offline.hasModel, isTrue);
+    expect(offline.usesDaemon, isFalse);
+    offline.detectBatch(
+      [Uint8List(4)],
+      [(1, 1)],
+      confThreshold: 0.25,
+      nmsThreshold: 0.45,
+      modelType: onnx.ModelType.yoloObb,
+      numKeypoints: 0,
+    );
+    expect(fallback.lastBatchModelType, onnx.ModelType.yoloObb);
+    expect(connects, 1);
+
+    // 推理中途连接断开：在本地加载同一模型后重试。
+    final client = FakeDaemonClient();
+    final local = FakeOnnxBackend()
+      ..detectBatchResult = [
+        ['local'],
+      ];
+    final backend = OnnxDaemonBackend(
+      connect: () => client,
+      fallback: local,
+    );
+    expect(backend.loadModel('/model.onnx'), isTrue);
+    client.errorCode = onnx.OnnxDaemonClient.errorDaemonUnavailable;
+    final results = backend.detectBatch(
+      [Uint8List(4)],
+      [(1, 1)],
+      confThreshold: 0.25,
+      nmsThreshold: 0.45,
+      modelType: onnx.ModelType.yolo,
+      numKeypoints: 0,
+    );
+    expect(results.single.single, 'local');
+    expect(client.closeCalls, 1);
+    expect(local.lastLoadPath, '/model.onnx');
+    expect(backend.usesDaemon, isFalse);
+    expect(backend.lastErrorCode, 0);
+
+    // 守护进程返回的普通错误不触发回退。
+    final failing = FakeDaemonClient()
+      ..loadResult = false
+      ..errorCode = 6;
+    final strict = OnnxDaemonBackend(
+      connect: () => failing,
+      fallback: FakeOnnxBackend(),
+    );
+    expect(strict.loadModel('/missing.onnx'), isFalse);
+    expect(strict.lastErrorCode, 6);
+    expect(strict.usesDaemon, isTrue);
+  });
 }
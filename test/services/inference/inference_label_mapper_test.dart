@@ -11,6 +11,13 @@ class FakeKeypoint {
   final double visibility;
 }
 
+class FakePolygonPoint {
+  FakePolygonPoint(this.x, this.y);
+
+  final double x;
+  final double y;
+}
+
 class FakeDetection {
   FakeDetection({
     required this.classId,
@@ -19,6 +26,7 @@ class FakeDetection {
     required this.width,
     required this.height,
     this.keypoints,
+    this.polygon,
   });
 
   final int classId;
@@ -27,6 +35,7 @@ class FakeDetection {
   final double width;
   final double height;
   final List<FakeKeypoint>? keypoints;
+  final List<FakePolygonPoint>? polygon;
 }
 
 void main() {
@@ -57,6 +66,58 @@ void main() {
       expect(labels.first.x, closeTo(0.2, 1e-6));
     });
 
+    test('maps segmentation polygons to label points', () {
+      final detections = [
+        FakeDetection(
+          classId: 0,
+          x: 0.5,
+          y: 0.5,
+          width: 0.4,
+          height: 0.4,
+          polygon: [
+            FakePolygonPoint(0.3, 0.3),
+            FakePolygonPoint(0.7, 0.3),
+            FakePolygonPoint(0.5, 0.7),
+          ],
+        ),
+      ];
+
+      final labels = InferenceLabelMapper.fromDetections(detections, const []);
+
+      expect(labels.single.points.length, 3);
+      expect(labels.single.points[1].x, closeTo(0.7, 1e-6));
+      expect(labels.single.points[2].y, closeTo(0.7, 1e-6));
+      expect(labels.single.points.first.visibility, 2);
+      expect(labels.single.pointsArePolygon, isTrue);
+    });
+
+    test('derives bbox from rotated box corners', () {
+      // 旋转 45° 的正方形：宽高为边长，边界框应包围 4 个角点。
+      final detections = [
+        FakeDetection(
+          classId: 0,
+          x: 0.5,
+          y: 0.5,
+          width: 0.2,
+          height: 0.2,
+          polygon: [
+            FakePolygonPoint(0.5, 0.35),
+            FakePolygonPoint(0.65, 0.5),
+            FakePolygonPoint(0.5, 0.65),
+            FakePolygonPoint(0.35, 0.5),
+          ],
+        ),
+      ];
+
+      final labels = InferenceLabelMapper.fromDetections(detections, const []);
+
+      expect(labels.single.points.length, 4);
+      expect(labels.single.x, closeTo(0.5, 1e-6));
+      expect(labels.single.width, closeTo(0.3, 1e-6));
+      expect(labels.single.height, closeTo(0.3, 1e-6));
+      expect(labels.single.pointsArePolygon, isTrue);
+    });
+
     test('falls back to class_id when definition is missing', () {
       final detections = [
         FakeDetection(
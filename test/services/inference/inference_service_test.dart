@@ -9,6 +9,7 @@ import 'package:label_load/services/app/app_error.dart';
 import 'package:label_load/services/gpu/gpu_info.dart';
 import 'package:label_load/services/image/image_repository.dart';
 import 'package:label_load/services/inference/inference_engine.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/services/inference/inference_service.dart';
 
 class FakeDetection {
@@ -19,6 +20,7 @@ class FakeDetection {
     required this.width,
     required this.height,
     this.keypoints = const [],
+    this.polygon = const [],
   });
 
   final int classId;
@@ -27,6 +29,7 @@ class FakeDetection {
   final double width;
   final double height;
   final List<FakeKeypoint> keypoints;
+  final List<FakeKeypoint> polygon;
 }
 
 class FakeKeypoint {
@@ -36,6 +39,94 @@ class FakeKeypoint {
   final double visibility;
 }
 
+class FakeBatchStream implements InferenceBatchStream {
+  FakeBatchStream(this.resultFor);
+
+  final Iterable<dynamic> Function(int tag) resultFor;
+  final List<int> pushedTags = [];
+  final List<Uint8List> pushedBytes = [];
+  final List<int> _ready = [];
+  int flushCalls = 0;
+  int closeCalls = 0;
+
+  /// 非空时 flush 失败并由引擎报告该错误码。
+  FakeInferenceEngine? failFlushOn;
+
+  @override
+  bool push(Uint8List rgbaBytes, int width, int height, int tag) {
+    pushedTags.add(tag);
+    pushedBytes.add(Uint8List.fromList(rgbaBytes));
+    _ready.add(tag);
+    return true;
+  }
+
+  @override
+  bool flush() {
+    flushCalls++;
+    final engine = failFlushOn;
+    if (engine == null) return true;
+    engine
+      ..errorCode = 1
+      ..error = 'stream: 微批次推理失败';
+    return false;
+  }
+
+  @override
+  List<(int, Iterable<dynamic>)> drain() {
+    final drained = [for (final tag in _ready) (tag, resultFor(tag))];
+    _ready.clear();
+    return drained;
+  }
+
+  @override
+  void close() => closeCalls++;
+}
+
+class FakeRawCache implements InferenceRawCache {
+  /// 按键缓存的检测结果。
+  final Map<int, Iterable<dynamic>> entries = {};
+  final List<List<int>> batchKeys = [];
+
+  @override
+  int keyOf(Uint8List fileBytes) => fileBytes.length;
+
+  @override
+  Iterable<dynamic>? lookup(
+    int key, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return entries[key];
+  }
+
+  @override
+  List<List<dynamic>> detectBatch(
+    List<int> keys,
+    List<Uint8List> rgbaBytesList,
+    List<(int, int)> sizes, {
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    batchKeys.add(keys);
+    return [
+      for (final key in keys)
+        [
+          FakeDetection(
+            classId: key,
+            x: 0.5,
+            y: 0.5,
+            width: 0.2,
+            height: 0.2,
+          ),
+        ],
+    ];
+  }
+}
+
 class FakeInferenceEngine implements InferenceEngine {
   bool hasModelValue = true;
   bool initializeValue = true;
@@ -52,6 +143,20 @@ class FakeInferenceEngine implements InferenceEngine {
 
   Iterable<dynamic> detectResult = const [];
   List<List<dynamic>> detectBatchResult = const [];
+  InferenceBatchStream? batchStream;
+  InferenceRawCache? rawCache;
+  final List<String> rawCacheDirectories = [];
+  bool dedupSupported = false;
+  final List<int?> dedupDistances = [];
+  List<List<dynamic>>? sweepResult;
+  List<double>? lastSweepConf;
+  List<double>? lastSweepNms;
+  List<Uint8List> lastBatchBytes = const [];
+
+  /// 为 true 时模拟原生图像缓冲区。
+  bool imageBuffersSupported = false;
+  final List<Uint8List> acquiredBuffers = [];
+  final List<Uint8List> releasedBuffers = [];
 
   @override
   bool get hasModel => hasModelValue;
@@ -68,6 +173,10 @@ class FakeInferenceEngine implements InferenceEngine {
     return loadModelValue;
   }
 
+  @override
+  Future<bool> loadModelAsync(String path, {bool useGpu = false}) async =>
+      loadModel(path, useGpu: useGpu);
+
   @override
   void unloadModel() => unloadCalls++;
 
@@ -93,9 +202,60 @@ class FakeInferenceEngine implements InferenceEngine {
     required ModelType modelType,
     required int numKeypoints,
   }) {
+    lastBatchBytes = [
+      for (final bytes in rgbaBytesList) Uint8List.fromList(bytes),
+    ];
     return detectBatchResult;
   }
 
+  @override
+  InferenceBatchStream? openBatchStream({
+    required double confThreshold,
+    required double nmsThreshold,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    return batchStream;
+  }
+
+  @override
+  InferenceRawCache? openRawCache(String directory) {
+    rawCacheDirectories.add(directory);
+    return rawCache;
+  }
+
+  @override
+  bool setDedupDistance(int? maxDistance) {
+    dedupDistances.add(maxDistance);
+    return dedupSupported;
+  }
+
+  @override
+  Uint8List? acquireImageBuffer(int size) {
+    if (!imageBuffersSupported) return null;
+    final buffer = Uint8List(size);
+    acquiredBuffers.add(buffer);
+    return buffer;
+  }
+
+  @override
+  void releaseImageBuffer(Uint8List buffer) => releasedBuffers.add(buffer);
+
+  @override
+  List<List<dynamic>>? detectSweep(
+    Uint8List rgbaBytes,
+    int width,
+    int height, {
+    required List<double> confThresholds,
+    required List<double> nmsThresholds,
+    required ModelType modelType,
+    required int numKeypoints,
+  }) {
+    lastSweepConf = confThresholds;
+    lastSweepNms = nmsThresholds;
+    return sweepResult;
+  }
+
   @override
   bool isGpuAvailable() => gpuAvailable;
 
@@ -112,6 +272,12 @@ class FakeInferenceEngine implements InferenceEngine {
   @override
   String getAvailableProviders() => providers;
 
+  @override
+  InferenceStats? getStats() => null;
+
+  @override
+  void resetStats() {}
+
   @override
   String get lastError => error;
 
@@ -246,10 +412,39 @@ void main() {
     await service.loadModel('/model.onnx');
     service.unloadModel();
 
-    expect(engine.unloadCalls, 2);
+    expect(engine.unloadCalls, 1);
     expect(service.loadedModelPath, isNull);
   });
 
+  test('InferenceService swaps models without unloading first', () async {
+    final engine = FakeInferenceEngine()
+      ..hasModelValue = true
+      ..dedupSupported = true;
+    final service = InferenceService(engine: engine);
+
+    expect(await service.loadModel('/a.onnx'), isTrue);
+    await service.runBatchInference(
+        [], AiConfig(skipNearDuplicates: true), []);
+
+    // 新模型加载失败：保留原模型。
+    engine.loadModelValue = false;
+    expect(await service.loadModel('/b.onnx'), isFalse);
+    expect(service.loadedModelPath, '/a.onnx');
+
+    // 加载成功后替换，近重复跳过对新模型重新下发。
+    engine.loadModelValue = true;
+    expect(await service.loadModel('/b.onnx'), isTrue);
+    expect(service.loadedModelPath, '/b.onnx');
+    expect(engine.loadCalls, 3);
+    expect(engine.unloadCalls, 0);
+    await service.runBatchInference(
+        [], AiConfig(skipNearDuplicates: true), []);
+    expect(engine.dedupDistances, [
+      InferenceService.nearDuplicateDistance,
+      InferenceService.nearDuplicateDistance,
+    ]);
+  });
+
   test('runInference throws when model not loaded', () async {
     final engine = FakeInferenceEngine()..hasModelValue = false;
     final service = InferenceService(engine: engine);
@@ -326,6 +521,55 @@ void main() {
     );
   });
 
+  test('runThresholdSweep counts detections per threshold pair', () async {
+    final engine = FakeInferenceEngine()..hasModelValue = true;
+    final repo = FakeImageRepository()..files['/ok.png'] = _pngBytes();
+    final service = InferenceService(engine: engine, imageRepository: repo);
+
+    // 后端不支持扫描时返回 null。
+    expect(
+      await service.runThresholdSweep(
+        '/ok.png',
+        AiConfig(),
+        confThresholds: const [0.25],
+        nmsThresholds: const [0.45],
+      ),
+      isNull,
+    );
+
+    engine.sweepResult = [
+      ['a', 'b', 'c'],
+      ['a', 'b'],
+      ['a'],
+      [],
+    ];
+    final sweep = await service.runThresholdSweep(
+      '/ok.png',
+      AiConfig(),
+      confThresholds: const [0.25, 0.5],
+      nmsThresholds: const [0.3, 0.6],
+    );
+
+    expect(engine.lastSweepConf, [0.25, 0.5]);
+    expect(engine.lastSweepNms, [0.3, 0.6]);
+    expect(sweep!.counts, [3, 2, 1, 0]);
+    expect(sweep.countAt(0, 1), 2);
+    expect(sweep.countNear(0.45, 0.35), 1);
+    expect(sweep.countNear(0.9, 0.9), 0);
+
+    engine.hasModelValue = false;
+    expect(
+      () => service.runThresholdSweep(
+        '/ok.png',
+        AiConfig(),
+        confThresholds: const [0.25],
+        nmsThresholds: const [0.45],
+      ),
+      throwsA(isA<AppError>()
+          .having((e) => e.code, 'code', AppErrorCode.aiModelNotLoaded)),
+    );
+  });
+
   test('runBatchInference returns empty lists for invalid images', () async {
     final engine = FakeInferenceEngine()..hasModelValue = true;
     final repo = FakeImageRepository();
@@ -382,6 +626,171 @@ void main() {
     expect(results[1], isEmpty);
   });
 
+  test('runBatchInference streams images when supported', () async {
+    final stream = FakeBatchStream(
+      (tag) => [
+        FakeDetection(
+          classId: tag,
+          x: 0.5,
+          y: 0.5,
+          width: 0.2,
+          height: 0.2,
+        ),
+      ],
+    );
+    final engine = FakeInferenceEngine()
+      ..hasModelValue = true
+      ..batchStream = stream;
+    final repo = FakeImageRepository()
+      ..files['/a.png'] = _pngBytes()
+      ..files['/c.png'] = _pngBytes();
+    final service = InferenceService(engine: engine, imageRepository: repo);
+    final defs = [
+      LabelDefinition(classId: 0, name: 'dog', color: const Color(0xFF000000)),
+      LabelDefinition(classId: 2, name: 'cat', color: const Color(0xFF000000)),
+    ];
+
+    final results = await service.runBatchInference(
+      ['/a.png', '/missing.png', '/c.png'],
+      AiConfig(),
+      defs,
+    );
+
+    expect(stream.pushedTags, [0, 2]);
+    expect(stream.flushCalls, 1);
+    expect(stream.closeCalls, 1);
+    expect(results[0].single.name, 'dog');
+    expect(results[1], isEmpty);
+    expect(results[2].single.name, 'cat');
+  });
+
+  test('runBatchInference writes decoded pixels into engine image buffers',
+      () async {
+    final stream = FakeBatchStream((tag) => const []);
+    final engine = FakeInferenceEngine()
+      ..hasModelValue = true
+      ..imageBuffersSupported = true
+      ..batchStream = stream;
+    final repo = FakeImageRepository()..files['/a.png'] = _pngBytes();
+    final service = InferenceService(engine: engine, imageRepository: repo);
+
+    await service.runBatchInference(['/a.png'], AiConfig(), const []);
+    expect(stream.pushedBytes.single, [255, 0, 0, 255]);
+    expect(engine.acquiredBuffers.length, 1);
+    expect(engine.releasedBuffers, engine.acquiredBuffers);
+
+    // 整批推理：缓冲区在推理返回后归还。
+    engine.batchStream = null;
+    engine.detectBatchResult = [const []];
+    await service.runBatchInference(['/a.png'], AiConfig(), const []);
+    expect(engine.lastBatchBytes.single, [255, 0, 0, 255]);
+    expect(engine.acquiredBuffers.length, 2);
+    expect(engine.releasedBuffers, engine.acquiredBuffers);
+  });
+
+  test('runBatchInference throws when the staged micro-batch fails', () async {
+    final stream = FakeBatchStream((tag) => const []);
+    final engine = FakeInferenceEngine()
+      ..hasModelValue = true
+      ..batchStream = stream;
+    stream.failFlushOn = engine;
+    final repo = FakeImageRepository()..files['/a.png'] = _pngBytes();
+    final service = InferenceService(engine: engine, imageRepository: repo);
+
+    await expectLater(
+      service.runBatchInference(['/a.png'], AiConfig(), const []),
+      throwsA(isA<AppError>()),
+    );
+    expect(stream.closeCalls, 1);
+  });
+
+  test('runBatchInference batches whole images when skipping near duplicates',
+      () async {
+    final stream = FakeBatchStream((tag) => const []);
+    final engine = FakeInferenceEngine()
+      ..hasModelValue = true
+      ..batchStream = stream
+      ..dedupSupported = true
+      ..detectBatchResult = [
+        [
+          FakeDetection(classId: 0, x: 0.5, y: 0.5, width: 0.2, height: 0.2),
+        ],
+      ];
+    final repo = FakeImageRepository()..files['/a.png'] = _pngBytes();
+    final service = InferenceService(engine: engine, imageRepository: repo);
+    final defs = [
+      LabelDefinition(classId: 0, name: 'dog', color: const Color(0xFF000000)),
+    ];
+    final config = AiConfig(skipNearDuplicates: true);
+
+    // 设置只在变化时下发，保留跨批次的参照图片。
+    for (var i = 0; i < 2; i++) {
+      final results = await service.runBatchInference(['/a.png'], config, defs);
+      expect(results.single.single.name, 'dog');
+    }
+    expect(engine.dedupDistances, [InferenceService.nearDuplicateDistance]);
+    expect(stream.pushedTags, isEmpty);
+
+    // 关闭后恢复流式会话。
+    await service.runBatchInference(
+        ['/a.png'], config.copyWith(skipNearDuplicates: false), defs);
+    expect(engine.dedupDistances,
+        [InferenceService.nearDuplicateDistance, null]);
+    expect(stream.pushedTags, [0]);
+  });
+
+  test('runBatchInference reuses raw cache hits and keys misses', () async {
+    final cache = FakeRawCache();
+    final engine = FakeInferenceEngine()
+      ..hasModelValue = true
+      ..rawCache = cache
+      ..batchStream = FakeBatchStream((tag) => const []);
+    final png = _pngBytes();
+    final large = Uint8List.fromList([...png, 0, 0]);
+    cache.entries[large.length] = [
+      FakeDetection(classId: 0, x: 0.5, y: 0.5, width: 0.2, height: 0.2),
+    ];
+    final repo = FakeImageRepository()
+      ..files['/hit.png'] = large
+      ..files['/miss.png'] = png;
+    final service = InferenceService(engine: engine, imageRepository: repo);
+    final defs = [
+      LabelDefinition(classId: 0, name: 'dog', color: const Color(0xFF000000)),
+    ];
+
+    expect(await service.loadModel('/model.onnx'), isTrue);
+    expect(service.hasRawCache, isFalse);
+    service.setRawCacheDirectory('/cache');
+    expect(engine.rawCacheDirectories, ['/cache']);
+    expect(service.hasRawCache, isTrue);
+
+    final results = await service.runBatchInference(
+      ['/hit.png', '/missing.png', '/miss.png'],
+      AiConfig(),
+      defs,
+    );
+
+    expect(results[0].single.name, 'dog');
+    expect(results[1], isEmpty);
+    expect(results[2].single.id, png.length);
+    expect(cache.batchKeys, [
+      [png.length],
+    ]);
+    expect((engine.batchStream! as FakeBatchStream).pushedTags, isEmpty);
+
+    // 分割模型不经缓存；卸载后缓存失效，重新加载时自动打开。
+    await service.runBatchInference(
+      ['/hit.png'],
+      AiConfig(modelType: ModelType.yoloSeg),
+      defs,
+    );
+    expect(cache.batchKeys.length, 1);
+    service.unloadModel();
+    expect(service.hasRawCache, isFalse);
+    expect(await service.loadModel('/model.onnx'), isTrue);
+    expect(engine.rawCacheDirectories, ['/cache', '/cache']);
+  });
+
   test('InferenceService exposes GPU info and providers', () {
     final engine = FakeInferenceEngine()
       ..gpuAvailable = true
@@ -400,7 +809,7 @@ void main() {
     await service.loadModel('/model.onnx');
     service.dispose();
 
-    expect(engine.unloadCalls, 2);
+    expect(engine.unloadCalls, 1);
     expect(engine.disposeCalls, 1);
   });
 }
@@ -2,10 +2,25 @@ import 'package:flutter/material.dart';
 import 'package:flutter_test/flutter_test.dart';
 import 'package:label_load/models/ai_config.dart';
 import 'package:label_load/services/app/app_services.dart';
+import 'package:label_load/services/inference/inference_stats.dart';
 import 'package:label_load/widgets/dialogs/ai_settings_widget.dart';
 
 import 'test_helpers.dart';
 
+class _StatsInferenceEngine extends FakeInferenceEngine {
+  InferenceStats? stats;
+  int resetCalls = 0;
+
+  @override
+  InferenceStats? getStats() => stats;
+
+  @override
+  void resetStats() {
+    resetCalls++;
+    stats = null;
+  }
+}
+
 Widget buildAiSettingsApp({
   required AiConfig initial,
   required ValueChanged<AiConfig> onChanged,
@@ -85,6 +100,11 @@ void main() {
     await tester.tap(find.text(l10n.labelSaveModeOverwrite));
     await tester.pump();
     expect(config.labelSaveMode, LabelSaveMode.overwrite);
+
+    await tester
+        .tap(find.widgetWithText(SwitchListTile, l10n.skipNearDuplicates));
+    await tester.pump();
+    expect(config.skipNearDuplicates, isTrue);
   });
 
   testWidgets('AiSettingsWidget updates classIdOffset and modelPath',
@@ -148,4 +168,65 @@ void main() {
     expect(keypointsText, '5');
     expect(classIdText, '9');
   });
+
+  testWidgets('AiSettingsWidget shows and resets inference stats',
+      (tester) async {
+    await setLargeSurface(tester);
+    final l10n = await loadL10n();
+    final engine = _StatsInferenceEngine()
+      ..stats = const InferenceStats(
+        stages: {
+          InferenceStage.run: InferenceStageTiming(
+            lastMs: 12.5,
+            p50Ms: 11,
+            p95Ms: 14,
+            p99Ms: 15,
+          ),
+        },
+        calls: 3,
+        images: 3,
+        candidates: 120,
+        detections: 9,
+        bytesAllocated: 4096,
+        dedupSkipped: 2,
+      );
+
+    await tester.pumpWidget(buildAiSettingsApp(
+      initial: AiConfig(),
+      onChanged: (_) {},
+      services: buildAppServices(inferenceEngine: engine),
+    ));
+
+    await tester.tap(find.text(l10n.inferenceStats));
+    await tester.pumpAndSettle();
+    expect(find.text(l10n.inferenceStatsCounters(3, 3, 120, 9)),
+        findsOneWidget);
+    expect(find.text(l10n.inferenceStatsDedupSkipped(2)), findsOneWidget);
+    expect(find.text('run'), findsOneWidget);
+    expect(find.text('12.50'), findsOneWidget);
+
+    await tester.tap(find.text(l10n.inferenceStatsReset));
+    await tester.pump();
+    expect(engine.resetCalls, 1);
+    expect(find.text(l10n.inferenceStatsEmpty), findsOneWidget);
+  });
+
+  testWidgets('AiSettingsWidget reports unavailable threshold preview',
+      (tester) async {
+    await setLargeSurface(tester);
+    final l10n = await loadL10n();
+    final filePicker = FakeFilePickerService(filePath: '/tmp/sample.png');
+
+    await tester.pumpWidget(buildAiSettingsApp(
+      initial: AiConfig(),
+      onChanged: (_) {},
+      services: buildAppServices(filePickerService: filePicker),
+    ));
+    expect(find.text(l10n.thresholdPreviewDesc), findsOneWidget);
+
+    // 未配置模型且引擎未加载模型：不推理，直接提示不可用。
+    await tester.tap(find.text(l10n.thresholdPreviewPick));
+    await tester.pumpAndSettle();
+    expect(find.text(l10n.thresholdPreviewFailed), findsOneWidget);
+  });
 }